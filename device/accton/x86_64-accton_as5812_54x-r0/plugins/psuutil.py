@@ -12,6 +12,7 @@ import os.path
 
 try:
     from sonic_psu.psu_base import PsuBase
+    from sonic_py_common.psu_status import PsuStatusSnapshot
 except ImportError as e:
     raise ImportError (str(e) + "- required module not found")
 
@@ -28,34 +29,26 @@ class PsuUtil(PsuBase):
             1: "57-0038",
             2: "58-003b",
         }
+        self.psu_snapshot = None
 
     def get_num_psus(self):
         return len(self.psu_mapping)
 
+    def _snapshot(self):
+        if self.psu_snapshot is None:
+            self.psu_snapshot = PsuStatusSnapshot(dict(
+                (index, (self.psu_path + dev + self.psu_presence, self.psu_path + dev + self.psu_oper_status))
+                for index, dev in self.psu_mapping.items()))
+        return self.psu_snapshot
+
     def get_psu_status(self, index):
         if index is None:
             return False
 
-        status = 0
-        node = self.psu_path + self.psu_mapping[index]+self.psu_oper_status
-        try:
-            with open(node, 'r') as power_status:
-                status = int(power_status.read())
-        except IOError:
-            return False
-
-        return status == 1
+        return self._snapshot().get_status(index)
 
     def get_psu_presence(self, index):
         if index is None:
             return False
 
-        status = 0
-        node = self.psu_path + self.psu_mapping[index] + self.psu_presence
-        try:
-            with open(node, 'r') as presence_status:
-                status = int(presence_status.read())
-        except IOError:
-            return False
-
-        return status == 1
+        return self._snapshot().get_presence(index)
@@ -10,11 +10,12 @@ try:
     import sys
     from sonic_eeprom import eeprom_base
     from sonic_eeprom import eeprom_tlvinfo
+    from sonic_py_common.eeprom_cache import EepromCache, EepromCacheMixin
     import subprocess
 except ImportError, e:
     raise ImportError (str(e) + "- required module not found")
 
-class board(eeprom_tlvinfo.TlvInfoDecoder):
+class board(EepromCacheMixin, eeprom_tlvinfo.TlvInfoDecoder):
     _TLV_INFO_MAX_LEN = 256
     def __init__(self, name, path, cpld_root, ro):
         self.eeprom_path = "/sys/bus/i2c/devices/1-0056/eeprom"
@@ -22,3 +23,4 @@ class board(eeprom_tlvinfo.TlvInfoDecoder):
         if not os.path.exists(self.eeprom_path):
             self.eeprom_path = "/sys/bus/i2c/devices/0-0056/eeprom"
         super(board, self).__init__(self.eeprom_path, 0, '', True)
+        self.eeprom_cache = EepromCache(self.eeprom_path, 0, self._TLV_INFO_MAX_LEN)
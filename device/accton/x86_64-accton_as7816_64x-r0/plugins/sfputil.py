@@ -5,6 +5,7 @@ try:
     import string
     from ctypes import create_string_buffer
     from sonic_sfp.sfputilbase import SfpUtilBase 
+    from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
 except ImportError, e:
     raise ImportError (str(e) + "- required module not found")
 
@@ -232,7 +233,22 @@ class SfpUtil(SfpUtilBase):
 
 
     data = {'valid':0, 'last':0, 'present':0}
+
+    # Binary presence bitmap of the CPLD driver, 1 is present, port 1 in bit 0
+    PRESENT_BITMAP_PATH = "/sys/bus/i2c/devices/19-0060/module_present_bitmap"
+    _presence_watcher = None
+
     def get_transceiver_change_event(self, timeout=2000):
+        if self._presence_watcher is None:
+            self._presence_watcher = PresenceWatcher([
+                PresenceBitmap(self.PRESENT_BITMAP_PATH, range(1, self.port_end + 1))])
+        if self._presence_watcher.available():
+            try:
+                return True, self._presence_watcher.wait(timeout)
+            except IOError as e:
+                print "Error: unable to read file: %s" % str(e)
+                return False, {}
+
         now = time.time()
         port_dict = {}
         port = 0
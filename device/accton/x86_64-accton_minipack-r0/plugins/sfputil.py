@@ -60,8 +60,8 @@ class SfpUtil(SfpUtilBase):
             self.port_to_eeprom_mapping[x] = self.LOCAL_OOM_PATH %x
 
         SfpUtilBase.__init__(self)
-        pim=PimUtil()
-        pim.init_pim_fpga()
+        self.pim=PimUtil()
+        self.pim.init_pim_fpga()
     
     def __del__(self):
         self.value=0                
@@ -71,33 +71,29 @@ class SfpUtil(SfpUtilBase):
         if port_num < self.port_start or port_num > self.port_end:
             return False
 
-        pim=PimUtil()
-        status=pim.get_qsfp_presence(port_num)
+        status=self.pim.get_qsfp_presence(port_num)
         return status
     
     def get_low_power_mode(self, port_num): 
         if port_num < self.port_start or port_num > self.port_end:
             return False
 
-        pim=PimUtil()
-        return pim.get_low_power_mode(port_num)
+        return self.pim.get_low_power_mode(port_num)
         
     def set_low_power_mode(self, port_num, lpmode):
         if port_num < self.port_start or port_num > self.port_end:
             return False
-        pim=PimUtil()
-        pim.set_low_power_mode(port_num, lpmode)         
+        self.pim.set_low_power_mode(port_num, lpmode)         
         return True 
 
     def reset(self, port_num):
         if port_num < self.port_start or port_num > self.port_end:
             return False
-        pim=PimUtil()
-        pim.reset(port_num)
+        self.pim.reset(port_num)
         return True        
   
     def get_transceiver_change_event(self, timeout=0):
-        pim=PimUtil()
+        pim=self.pim
         start_time = time.time()
         port_dict = {}
         forever = False
@@ -133,14 +129,12 @@ class SfpUtil(SfpUtilBase):
             if change_status:               
                 return True, port_dict
             if forever:
-                time.sleep(1)
+                pim.wait_qsfp_interrupt()
             else:
                 timeout = end_time - time.time()
-                if timeout >= 1:
-                    time.sleep(1) # We poll at 1 second granularity
+                if timeout > 0:
+                    pim.wait_qsfp_interrupt(timeout)
                 else:
-                    if timeout > 0:
-                        time.sleep(timeout)
                     return True, {}
         print "get_evt_change_event: Should not reach here."
         return False, {}
@@ -6,6 +6,7 @@
 try:
     import time
     from sonic_sfp.sfputilbase import SfpUtilBase
+    from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
 except ImportError as e:
     raise ImportError("%s - required module not found" % str(e))
 
@@ -19,6 +20,10 @@ class SfpUtil(SfpUtilBase):
 
     _port_to_eeprom_mapping = {}
 
+    # ModPrsL snapshot of the CPLD driver, notifies poll() on change
+    MODPRS_CHANGED_PATH = "/sys/devices/platform/dx010_cpld/qsfp_modprs_changed"
+    _presence_watcher = None
+
     @property
     def port_start(self):
         return self.PORT_START
@@ -201,4 +206,13 @@ class SfpUtil(SfpUtilBase):
         return True
 
     def get_transceiver_change_event(self, timeout=0):
-        raise NotImplementedError
+        if self._presence_watcher is None:
+            # ModPrsL is active low
+            self._presence_watcher = PresenceWatcher([
+                PresenceBitmap(self.MODPRS_CHANGED_PATH, range(self.port_start, self.port_end + 1),
+                               text=True, active_low=True)])
+        try:
+            return True, self._presence_watcher.wait(timeout)
+        except IOError as e:
+            print "Error: unable to read file: %s" % str(e)
+            return False, {}
@@ -9,6 +9,7 @@ try:
     import os
     import re
     import time
+    import select
     import syslog
     import logging
     import collections
@@ -68,6 +69,8 @@ class SfpUtil(SfpUtilBase):
         self.data = {'valid':0, 'last':0}
         self.f_sfp_present = "/sys/class/sfp/sfp{}/sfp_presence"
         self.f_sfp_enable = "/sys/class/sfp/sfp{}/sfp_enable"
+        self.f_sfp_all_present = "/sys/class/sfp/sfp_all/sfp_presence"
+        self.sfp_all_present = None
 
         if os.path.isdir(CONTAINER_PLATFORM_PATH):
             platform_path = CONTAINER_PLATFORM_PATH
@@ -103,11 +106,13 @@ class SfpUtil(SfpUtilBase):
 
         self.eeprom_mapping = {}
         self.presence = {}
+        self.port_to_sfp = {}  # port index -> sfp index, ports without an sfp are left out
         for port_cfg in self._port_cfgs:
             sfp_idx = self.mac_to_sfp[int(port_cfg.lanes.split(',')[0])]
             if sfp_idx > 0:
                 self.eeprom_mapping[int(port_cfg.index)] = "/sys/class/sfp/sfp{}/sfp_eeprom".format(sfp_idx)
                 self.logical.append(port_cfg.name)
+                self.port_to_sfp[int(port_cfg.index)] = sfp_idx
             else:
                 self.eeprom_mapping[int(port_cfg.index)] = None
             self.presence[int(port_cfg.index)] = False
@@ -130,13 +135,12 @@ class SfpUtil(SfpUtilBase):
     def qsfp_ports(self):
         start = 256
         end = 0
-        for port_cfg in self._port_cfgs:
-            sfp_idx = self.mac_to_sfp[int(port_cfg.lanes.split(',')[0])]
+        for port, sfp_idx in self.port_to_sfp.items():
             if sfp_idx == 25 or sfp_idx == 26:
-                if int(port_cfg.index) <= start:
-                    start = int(port_cfg.index)
-                elif int(port_cfg.index) >= end:
-                    end = int(port_cfg.index)
+                if port <= start:
+                    start = port
+                elif port >= end:
+                    end = port
         return range(start, end + 1)
 
     @property
@@ -147,15 +151,13 @@ class SfpUtil(SfpUtilBase):
         return True
 
     def get_presence(self, port_num):
-        for port_cfg in self._port_cfgs:
-            if int(port_cfg.index) == port_num:
-                sfp_idx = self.mac_to_sfp[int(port_cfg.lanes.split(',')[0])]
-                if sfp_idx >= 0:
-                    try:
-                        with open(self.f_sfp_present.format(sfp_idx), 'r') as sfp_file:
-                            return 1 == int(sfp_file.read())
-                    except IOError as e:
-                        DBG_PRINT(str(e))
+        sfp_idx = self.port_to_sfp.get(port_num)
+        if sfp_idx is not None:
+            try:
+                with open(self.f_sfp_present.format(sfp_idx), 'r') as sfp_file:
+                    return 1 == int(sfp_file.read())
+            except IOError as e:
+                DBG_PRINT(str(e))
         return False
 
     def get_low_power_mode(self, port_num):
@@ -173,7 +175,28 @@ class SfpUtil(SfpUtilBase):
             self.logical_to_asic[port_cfg.name] = 0
             self.physical_to_logical[int(port_cfg.index)] = [port_cfg.name]
 
-    def get_transceiver_change_event(self, timeout=2000):
+    def _read_all_presence(self):
+        """
+        Returns the presence bitmap of all the ports, bit (n-1) for sfpn,
+        the file is kept open to poll() it
+        """
+        if self.sfp_all_present is None:
+            self.sfp_all_present = open(self.f_sfp_all_present, 'r')
+            self.poller = select.poll()
+            self.poller.register(self.sfp_all_present, select.POLLPRI | select.POLLERR)
+        self.sfp_all_present.seek(0)
+        return int(self.sfp_all_present.read(), 16)
+
+    def _get_presence_changes(self, bitmap):
+        port_dict = {}
+        for port, sfp_idx in self.port_to_sfp.items():
+            presence = (bitmap >> (sfp_idx - 1)) & 1 == 1
+            if presence != self.presence[port]:
+                self.presence[port] = presence
+                port_dict[port] = SFP_STATUS_INSERTED if presence else SFP_STATUS_REMOVED
+        return port_dict
+
+    def _get_transceiver_change_event_polling(self, timeout):
         now = time.time()
         port_dict = {}
 
@@ -201,4 +224,21 @@ class SfpUtil(SfpUtilBase):
             time.sleep(0.5)
             return True, {}
 
-        return False, port_dict
+    def get_transceiver_change_event(self, timeout=0):
+        """
+        Waits on the presence bitmap of all the ports, the driver notifies it
+        on any change. timeout is in ms, 0 to wait until a change.
+        """
+        try:
+            port_dict = self._get_presence_changes(self._read_all_presence())
+            if not port_dict:
+                self.poller.poll(timeout if timeout > 0 else None)
+                port_dict = self._get_presence_changes(self._read_all_presence())
+        except (IOError, ValueError):
+            # sfp_all is not provided by the driver, poll the ports
+            if self.sfp_all_present is not None:
+                self.sfp_all_present.close()
+                self.sfp_all_present = None
+            return self._get_transceiver_change_event_polling(timeout)
+
+        return True, port_dict
@@ -30,6 +30,8 @@ class LedControl(LedControlBase):
     SONIC_PORT_NAME_PREFIX = "Ethernet"
     LED_MODE_UP = [11, 1]
     LED_MODE_DOWN = [7, 2]
+    # Link changes within this many seconds are applied together, the last state of a port wins
+    LED_UPDATE_DELAY = 0.1
 
     def _initSystemLed(self):
         try:
@@ -64,6 +66,9 @@ class LedControl(LedControlBase):
                 with open(self.f_led.format("port{}".format(idx)), 'w') as led_file:
                     led_file.write(str(defmode))
                     DBG_PRINT("init port{} led to mode={}".format(idx, defmode))
+                self.led_modes[idx] = defmode
+            # the default modes have been sent above
+            return
 
         for idx in range(1, 55):
             (port, ctlid, defmode) = self.led_mapping[idx]
@@ -72,6 +77,7 @@ class LedControl(LedControlBase):
                 data = struct.pack('=HHHBBH', 0, 7, 4, ctlid, defmode, port)
                 self.udpClient.sendto(data, ('localhost', 8101))
                 DBG_PRINT("init port{} led to mode={}".format(idx, defmode))
+            self.led_modes[idx] = defmode
 
     def _initDefaultConfig(self):
         DBG_PRINT("start init led")
@@ -115,22 +121,38 @@ class LedControl(LedControlBase):
     def _port_led_mode_update(self, port_idx, ledMode):
         with open(self.f_led.format("port{}".format(port_idx)), 'w') as led_file:
             led_file.write(str(ledMode))
+        self.led_modes[port_idx] = ledMode
         (port, ctlid) = (self.led_mapping[port_idx][0], self.led_mapping[port_idx][1])
         data = struct.pack('=HHHBBH', 0, 7, 4, ctlid, ledMode, port)
         self.udpClient.sendto(data, ('localhost', 8101))
 
+    def _port_led_mode_flush(self):
+        with self.led_lock:
+            pending = self.led_pending
+            self.led_pending = {}
+            self.led_timer = None
+
+        for port_idx in sorted(pending):
+            ledMode = pending[port_idx]
+            saveMode = self.led_modes[port_idx]
+            if ledMode == saveMode:
+                continue
+            self._port_led_mode_update(port_idx, ledMode)
+            DBG_PRINT("update port{} led mode from {} to {}".format(port_idx, saveMode, ledMode))
+
     # Concrete implementation of port_link_state_change() method
     def port_link_state_change(self, portname, state):
         port_idx = self._port_name_to_index(portname)
-        ledMode = self._port_state_to_mode(port_idx, state)
-        with open(self.f_led.format("port{}".format(port_idx)), 'r') as led_file:
-            saveMode = int(led_file.read())
-
-        if ledMode == saveMode:
+        if port_idx < 1 or port_idx >= len(self.led_modes):
             return
+        ledMode = self._port_state_to_mode(port_idx, state)
 
-        self._port_led_mode_update(port_idx, ledMode)
-        DBG_PRINT("update {} led mode from {} to {}".format(portname, saveMode, ledMode))
+        with self.led_lock:
+            self.led_pending[port_idx] = ledMode
+            if self.led_timer is None:
+                self.led_timer = threading.Timer(self.LED_UPDATE_DELAY, self._port_led_mode_flush)
+                self.led_timer.daemon = True
+                self.led_timer.start()
 
     # Constructor
     def __init__(self):
@@ -147,6 +169,13 @@ class LedControl(LedControlBase):
 
         self.f_led = "/sys/class/leds/{}/brightness"
 
+        # Current mode of each port led, the brightness files are only written
+        self.led_modes = [0] * len(self.led_mapping)
+        # Modes waiting for _port_led_mode_flush(), port index -> mode
+        self.led_pending = {}
+        self.led_lock = threading.Lock()
+        self.led_timer = None
+
         self.udpClient = socket(AF_INET, SOCK_DGRAM)
 
         self._initDefaultConfig()
@@ -3,6 +3,7 @@
 try:
     import time
     from sonic_sfp.sfputilbase import SfpUtilBase
+    from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
 except ImportError, e:
     raise ImportError (str(e) + "- required module not found")
 
@@ -16,7 +17,7 @@ class SfpUtil(SfpUtilBase):
     _ports_in_block = 56
 
     _port_to_eeprom_mapping = {}
-    _global_port_pres_dict = {}
+    _presence_watcher = None
     
     _port_to_i2c_mapping = {
         1 : 8,
@@ -116,18 +117,12 @@ class SfpUtil(SfpUtilBase):
 
         return False
 
-    def init_global_port_presence(self):
-        for port_num in range(self.port_start, (self.port_end + 1)):
-            self._global_port_pres_dict[port_num] = '0'
-
- 
     def __init__(self):
         eeprom_path = '/sys/bus/i2c/devices/{0}-0050/sfp_eeprom'
         for x in range(self._port_start, self._port_end + 1):
             port_eeprom_path = eeprom_path.format(self._port_to_i2c_mapping[x])
             self._port_to_eeprom_mapping[x] = port_eeprom_path
 			
-        self.init_global_port_presence()
         SfpUtilBase.__init__(self)
 
     def reset(self, port_num):
@@ -215,25 +210,18 @@ class SfpUtil(SfpUtilBase):
 
         return False
                 
-    def get_transceiver_change_event(self):
-        port_dict = {}
-        while True:
-            for port_num in range(self.port_start, (self.port_end + 1)):
-                presence = self.get_presence(port_num)
-
-                if(presence and self._global_port_pres_dict[port_num] == '0'):
-                    self._global_port_pres_dict[port_num] = '1'
-                    port_dict[port_num] = '1'
-                elif(not presence and
-                     self._global_port_pres_dict[port_num] == '1'):
-                    self._global_port_pres_dict[port_num] = '0'
-                    port_dict[port_num] = '0'
-
-                if(len(port_dict) > 0):
-                    return True, port_dict
-
-            time.sleep(0.5)
-
+    def get_transceiver_change_event(self, timeout=0):
+        if self._presence_watcher is None:
+            # The sfp driver notifies sfp_is_present of each port on a change
+            path = "/sys/bus/i2c/devices/{0}-0050/sfp_is_present"
+            self._presence_watcher = PresenceWatcher([
+                PresenceBitmap(path.format(self._port_to_i2c_mapping[port_num]), [port_num], text=True)
+                for port_num in range(self.port_start, self.port_end + 1)])
+        try:
+            return True, self._presence_watcher.wait(timeout)
+        except IOError as e:
+            print "Error: unable to read file: %s" % str(e)
+            return False, {}
 
     @property
     def port_start(self):
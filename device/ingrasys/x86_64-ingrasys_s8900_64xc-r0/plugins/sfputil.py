@@ -7,6 +7,7 @@ try:
     import time
     import subprocess
     from sonic_sfp.sfputilbase import SfpUtilBase
+    from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
 except ImportError as e:
     raise ImportError("%s - required module not found" % str(e))
 
@@ -25,6 +26,7 @@ class SfpUtil(SfpUtilBase):
     PORTS_IN_BLOCK = 64
 
     _port_to_eeprom_mapping = {}
+    _presence_watcher = None
     port_to_i2c_mapping = {
            0: [2,1],
            1: [2,2],
@@ -255,10 +257,16 @@ class SfpUtil(SfpUtilBase):
 
         return True
 
-    def get_transceiver_change_event(self):
-        """
-        TODO: This function need to be implemented
-        when decide to support monitoring SFP(Xcvrd)
-        on this platform.
-        """
-        raise NotImplementedError
+    def get_transceiver_change_event(self, timeout=0):
+        # The cpld driver notifies qsfp_modprs on a present change of any port
+        if self._presence_watcher is None:
+            self._presence_watcher = PresenceWatcher([
+                PresenceBitmap("/sys/devices/platform/ingrasys-s8900-64xc-cpld.0/qsfp_modprs",
+                               range(self.port_start, self.port_end + 1),
+                               text=True, active_low=True)])
+
+        try:
+            return True, self._presence_watcher.wait(timeout)
+        except IOError as e:
+            print "Error: unable to read file: %s" % str(e)
+            return False, {}
@@ -3,6 +3,7 @@
 try:
     import time
     from sonic_sfp.sfputilbase import SfpUtilBase 
+    from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
 except ImportError, e:
     raise ImportError (str(e) + "- required module not found")
 
@@ -52,6 +53,14 @@ class SfpUtil(SfpUtilBase):
 
     _qsfp_ports = range(0, ports_in_block + 1)
 
+    # port_events of the two QSFP-DD CPLDs, the first word is the presence
+    # of their 16 ports, 1 is present
+    PORT_EVENTS_PATHS = [
+        ("/sys/bus/i2c/devices/16-0038/port_events", range(0, 16)),
+        ("/sys/bus/i2c/devices/17-0038/port_events", range(16, 32)),
+    ]
+    _presence_watcher = None
+
     def __init__(self):
         eeprom_path = '/sys/bus/i2c/devices/{0}-0050/eeprom'
         for x in range(0, self._port_end + 1):
@@ -165,12 +174,14 @@ class SfpUtil(SfpUtilBase):
     def port_to_eeprom_mapping(self):
          return self._port_to_eeprom_mapping
 
-    def get_transceiver_change_event(self):
-        """
-        TODO: This function need to be implemented
-        when decide to support monitoring SFP(Xcvrd)
-        on this platform.
-        """
-        raise NotImplementedError
+    def get_transceiver_change_event(self, timeout=0):
+        if self._presence_watcher is None:
+            self._presence_watcher = PresenceWatcher(
+                [PresenceBitmap(path, ports, size=2) for path, ports in self.PORT_EVENTS_PATHS])
+        try:
+            return True, self._presence_watcher.wait(timeout)
+        except IOError as e:
+            print "Error: unable to read file: %s" % str(e)
+            return False, {}
 
 
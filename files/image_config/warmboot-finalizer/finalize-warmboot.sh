@@ -42,23 +42,11 @@ function wait_for_database_service()
 }
 
 
-function get_component_state()
-{
-    sonic-db-cli STATE_DB hget "WARM_RESTART_TABLE|$1" state
-}
-
-
 function check_list()
 {
-    RET_LIST=''
-    for comp in $@; do
-        state=`get_component_state ${comp}`
-	if [[ x"${state}" != x"${EXP_STATE}" ]]; then
-            RET_LIST="${RET_LIST} ${comp}"
-	fi
-    done
-
-    echo ${RET_LIST}
+    # Returns once all the components are reconciled, or with the ones
+    # which are not after 5 minutes
+    /usr/local/bin/wait-reconciled -t 300 -s ${EXP_STATE} $@ || echo $@
 }
 
 
@@ -86,16 +74,8 @@ if [[ x"${WARM_BOOT}" != x"true" ]]; then
     exit 0
 fi
 
-list=${COMP_LIST}
-
 # Wait up to 5 minutes
-for i in `seq 60`; do
-    list=`check_list ${list}`
-    if [[ -z "${list}" ]]; then
-	break
-    fi
-    sleep 5
-done
+list=`check_list ${COMP_LIST}`
 
 stop_control_plane_assistant
 
@@ -1,17 +1,18 @@
 #!/usr/bin/env bash
 
-# Wait until redis starts
-until [[ $(sonic-db-cli PING | grep -c PONG) -gt 0 ]]; do
-  sleep 1;
-done
-
-# If there is a config_db.json dump file, load it.
+# If there is a config_db.json dump file, load it. sonic-cfggen --bulk
+# waits for redis to start by itself.
 if [ -r /etc/sonic/config_db.json ]; then
     if [ -r /etc/sonic/init_cfg.json ]; then
-        sonic-cfggen -j /etc/sonic/init_cfg.json -j /etc/sonic/config_db.json --write-to-db
+        sonic-cfggen -j /etc/sonic/init_cfg.json -j /etc/sonic/config_db.json --write-to-db --bulk
     else
-        sonic-cfggen -j /etc/sonic/config_db.json --write-to-db
+        sonic-cfggen -j /etc/sonic/config_db.json --write-to-db --bulk
     fi
+else
+    # Wait until redis starts
+    until [[ $(sonic-db-cli PING | grep -c PONG) -gt 0 ]]; do
+      sleep 1;
+    done
 fi
 
 sonic-db-cli CONFIG_DB SET "CONFIG_DB_INITIALIZED" "1"
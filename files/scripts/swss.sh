@@ -64,16 +64,34 @@ function wait_for_database_service()
 # This function cleans up the tables with specific prefixes from the database
 # $1 the index of the database
 # $2 the string of a list of table prefixes
+# The keyspace is walked with SCAN, one batch per EVAL, and the matching
+# keys are freed with UNLINK, so that redis is never blocked for long
 function clean_up_tables()
 {
-    $SONIC_DB_CLI $1 EVAL "
-    local tables = {$2}
-    for i = 1, table.getn(tables) do
-        local matches = redis.call('KEYS', tables[i])
-        for j,name in ipairs(matches) do
-            redis.call('DEL', name)
+    local cursor=0
+    while true; do
+        cursor=$($SONIC_DB_CLI $1 EVAL "
+        redis.replicate_commands()
+        local tables = {$2}
+        for i = 1, #tables do
+            if string.sub(tables[i], -1) == '*' then
+                tables[i] = string.sub(tables[i], 1, -2)
+            end
         end
-    end" 0
+        local result = redis.call('SCAN', ARGV[1], 'COUNT', 10000)
+        for j,name in ipairs(result[2]) do
+            for i = 1, #tables do
+                if string.sub(name, 1, #tables[i]) == tables[i] then
+                    redis.call('UNLINK', name)
+                    break
+                end
+            end
+        end
+        return result[1]" 0 $cursor)
+        if [[ ! "$cursor" =~ ^[0-9]+$ || "$cursor" == "0" ]]; then
+            break
+        fi
+    done
 }
 
 start_peer_and_dependent_services() {
@@ -151,34 +169,8 @@ start() {
 wait() {
     start_peer_and_dependent_services
 
-    # Allow some time for peer container to start
-    # NOTE: This assumes Docker containers share the same names as their
-    # corresponding services
-    for SECS in {1..60}; do
-        if [[ ! -z $DEV ]]; then
-            RUNNING=$(docker inspect -f '{{.State.Running}}' ${PEER}$DEV)
-        else
-            RUNNING=$(docker inspect -f '{{.State.Running}}' ${PEER})
-        fi
-        ALL_DEPS_RUNNING=true
-        for dep in ${MULTI_INST_DEPENDENT}; do
-            if [[ ! -z $DEV ]]; then
-                DEP_RUNNING=$(docker inspect -f '{{.State.Running}}' ${dep}$DEV)
-            else
-                DEP_RUNNING=$(docker inspect -f '{{.State.Running}}' ${dep})
-            fi
-            if [[ x"$DEP_RUNNING" != x"true" ]]; then
-                ALL_DEPS_RUNNING=false
-                break
-            fi
-        done
-
-        if [[ x"$RUNNING" == x"true" && x"$ALL_DEPS_RUNNING" == x"true" ]]; then
-            break
-        else
-            sleep 1
-        fi
-    done
+    # docker-wait-any waits for the peer and dependent containers to start
+    # before it watches them, no need to poll them here
 
     # NOTE: This assumes Docker containers share the same names as their
     # corresponding services
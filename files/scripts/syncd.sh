@@ -160,18 +160,14 @@ stop() {
         /usr/bin/docker exec -i syncd$DEV /usr/bin/syncd_request_shutdown --${TYPE}
 
         # wait until syncd quits gracefully or force syncd to exit after 
-        # waiting for 20 seconds
-        start_in_secs=${SECONDS}
-        end_in_secs=${SECONDS}
+        # waiting for 20 seconds. The host pid of syncd is looked up once,
+        # tail then waits on that pid without running any docker command
         timer_threshold=20
-        while docker top syncd$DEV | grep -q /usr/bin/syncd \
-                && [[ $((end_in_secs - start_in_secs)) -le $timer_threshold ]]; do
-            sleep 0.1
-            end_in_secs=${SECONDS}
-        done
-
-        if [[ $((end_in_secs - start_in_secs)) -gt $timer_threshold ]]; then
-            debug "syncd process in container syncd$DEV did not exit gracefully" 
+        SYNCD_PID=$(docker top syncd$DEV -o pid,args | awk '$2 == "/usr/bin/syncd" { print $1; exit }')
+        if [[ -n "$SYNCD_PID" ]]; then
+            if ! /usr/bin/timeout $timer_threshold /usr/bin/tail --pid=$SYNCD_PID -s 0.1 -f /dev/null; then
+                debug "syncd process in container syncd$DEV did not exit gracefully" 
+            fi
         fi
 
         /usr/bin/docker exec -i syncd$DEV /bin/sync
@@ -39,6 +39,9 @@ typedef uint64_t phys_addr_t;
 
 #define BF_IOC_MAGIC 'b'
 #define BF_TBUS_MSIX_INDICES_MAX   3
+/* BF_DMA_ALLOC regions are sized and aligned in multiples of this */
+#define BF_DMA_HUGE_PAGE_SIZE      (2 * 1024 * 1024)
+#define BF_DMA_REGIONS_MAX         64 /* per open file */
 
 typedef struct bf_dma_bus_map_s
 {
@@ -64,9 +67,65 @@ typedef struct bf_intr_mode_s {
   enum bf_intr_mode intr_mode;
 } bf_intr_mode_t;
 
+/* bind an eventfd to an interrupt vector, fd < 0 unbinds the vector */
+typedef struct bf_intr_eventfd_s {
+  int vector;
+  int fd;
+} bf_intr_eventfd_t;
+
+/* data returned by read() on the device file */
+enum bf_intr_read_mode {
+  BF_INTR_READ_MODE_COUNT = 0, /* s32 event count per vector (default) */
+  BF_INTR_READ_MODE_BITMAP,    /* u32 bitmap of vectors with new events */
+};
+
+typedef struct bf_intr_read_mode_s {
+  enum bf_intr_read_mode read_mode;
+} bf_intr_read_mode_t;
+
+/* Interrupt event ring of a device, mapped with mmap() at mmap_offset.
+ * The ISR appends the vector of each interrupt at head; user space
+ * consumes the entries from tail and then advances tail. head and tail
+ * are free running, entry i is entries[i % BF_INTR_RING_ENTRIES]. The
+ * ring is empty when head == tail; when it is full, further interrupts
+ * only count in dropped and user space resyncs with read(). poll()
+ * reports POLLIN while the ring is not empty, so user space needs a
+ * system call only to wait on an empty ring.
+ */
+#define BF_INTR_RING_ENTRIES       1024 /* power of 2 */
+
+typedef struct bf_intr_ring_s {
+  volatile uint32_t head;    /* written by the kernel */
+  uint32_t rsvd0[15];
+  volatile uint32_t tail;    /* written by user space */
+  uint32_t rsvd1[15];
+  volatile uint32_t dropped; /* written by the kernel */
+  uint32_t rsvd2[15];
+  uint32_t entries[BF_INTR_RING_ENTRIES];
+} bf_intr_ring_t;
+
+typedef struct bf_intr_ring_cfg_s {
+  int enable;                     /* in: 1 attaches the ring, 0 detaches it */
+  size_t size;                    /* out: bytes to mmap() */
+  unsigned long long mmap_offset; /* out: mmap() offset */
+} bf_intr_ring_cfg_t;
+
+/* physically contiguous DMA region on the NUMA node of the device */
+typedef struct bf_dma_alloc_s {
+  size_t size;                    /* in: bytes, out: rounded up size */
+  void *dma_addr;                 /* out: bus address of the region */
+  unsigned long long mmap_offset; /* out: mmap() offset, in: for free */
+  int node;                       /* out: NUMA node of the device, -1 if any */
+} bf_dma_alloc_t;
+
 #define BF_IOCMAPDMAADDR    _IOWR(BF_IOC_MAGIC, 0, bf_dma_bus_map_t)
 #define BF_IOCUNMAPDMAADDR  _IOW(BF_IOC_MAGIC, 1, bf_dma_bus_map_t)
 #define BF_TBUS_MSIX_INDEX  _IOW(BF_IOC_MAGIC, 2, bf_tbus_msix_indices_t)
 #define BF_GET_INTR_MODE    _IOR(BF_IOC_MAGIC, 3, bf_intr_mode_t)
+#define BF_INTR_EVENTFD     _IOW(BF_IOC_MAGIC, 4, bf_intr_eventfd_t)
+#define BF_INTR_READ_MODE   _IOW(BF_IOC_MAGIC, 5, bf_intr_read_mode_t)
+#define BF_DMA_ALLOC        _IOWR(BF_IOC_MAGIC, 6, bf_dma_alloc_t)
+#define BF_DMA_FREE         _IOW(BF_IOC_MAGIC, 7, bf_dma_alloc_t)
+#define BF_INTR_RING        _IOWR(BF_IOC_MAGIC, 8, bf_intr_ring_cfg_t)
 
 #endif /* _BF_IOCTL_H_ */
@@ -38,6 +38,8 @@
 #include <linux/wait.h>
 #include <linux/poll.h>
 #include <linux/dma-mapping.h>
+#include <linux/eventfd.h>
+#include <linux/vmalloc.h>
 #include "bf_ioctl.h"
 #include "bf_kdrv.h"
 
@@ -86,6 +88,7 @@ static int kpkt_mode = 0;
 static int kpkt_hd_room = 32;
 static int kpkt_rx_count = 256;
 static int kpkt_dr_int_en = 1;
+static int kpkt_irq_affinity = 0;
 
 static enum bf_intr_mode bf_intr_mode_default = BF_INTR_MODE_MSI;
 static spinlock_t bf_nonisr_lock;
@@ -250,6 +253,32 @@ static int bf_irq_is_tbus_msix(struct bf_pci_dev *bfdev, int irq) {
 }
 #endif
 
+/* spread the TBUS MSIX vectors handled by the kernel pkt path over the cpus
+ * local to the device, or clear the hints before the vectors are released
+ */
+static void bf_kpkt_set_irq_affinity(struct bf_pci_dev *bfdev, int set) {
+#ifdef BF_INCLUDE_KPKT
+  struct bf_dev_info *info = &bfdev->info;
+  const struct cpumask *mask = NULL;
+  int i, ind;
+
+  if (!kpkt_mode || !kpkt_irq_affinity || bfdev->mode != BF_INTR_MODE_MSIX ||
+      !info->tbus_msix_map_enable) {
+    return;
+  }
+  for (i = 0; i < BF_TBUS_MSIX_INDICES_MAX; i++) {
+    ind = info->tbus_msix_ind[i];
+    if (ind >= info->num_irq) {
+      continue;
+    }
+    if (set) {
+      mask = cpumask_of(cpumask_local_spread(i, dev_to_node(&bfdev->pdev->dev)));
+    }
+    irq_set_affinity_hint(info->msix_entries[ind].vector, mask);
+  }
+#endif
+}
+
 /**
  * interrupt handler which will check if the interrupt is from the right
  * device. If so, disable it here and will be enabled later.
@@ -350,6 +379,20 @@ static int bf_setup_bars(struct pci_dev *dev, struct bf_dev_info *info) {
   return (iom != 0) ? ret : -ENOENT;
 }
 
+/* append a vector to the interrupt event ring; the ISRs are serialized by
+ * eventfd_lock, user space is the only consumer
+ */
+static void bf_intr_ring_push(bf_intr_ring_t *ring, int vector) {
+  u32 head = ring->head;
+
+  if (head - smp_load_acquire(&ring->tail) >= BF_INTR_RING_ENTRIES) {
+    WRITE_ONCE(ring->dropped, ring->dropped + 1);
+    return;
+  }
+  ring->entries[head & (BF_INTR_RING_ENTRIES - 1)] = vector;
+  smp_store_release(&ring->head, head + 1);
+}
+
 static irqreturn_t bf_interrupt(int irq, void *bfdev_id) {
   struct bf_pci_dev *bfdev = ((struct bf_int_vector *)bfdev_id)->bf_dev;
   int vect_off = ((struct bf_int_vector *)bfdev_id)->int_vec_offset;
@@ -358,10 +401,244 @@ static irqreturn_t bf_interrupt(int irq, void *bfdev_id) {
 
   if (ret == IRQ_HANDLED) {
     atomic_inc(&(bfdev->info.event[vect_off]));
+    /* signal the waiter of this vector only, if it has bound an eventfd */
+    spin_lock(&bfdev->info.eventfd_lock);
+    if (bfdev->info.intr_ring) {
+      bf_intr_ring_push(bfdev->info.intr_ring, vect_off);
+    }
+    if (bfdev->info.eventfd[vect_off]) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+      eventfd_signal(bfdev->info.eventfd[vect_off]);
+#else
+      eventfd_signal(bfdev->info.eventfd[vect_off], 1);
+#endif
+    }
+    spin_unlock(&bfdev->info.eventfd_lock);
+    wake_up_interruptible(&bfdev->info.wait);
+  }
+  return ret;
+}
+
+/* bind (fd >= 0) or unbind (fd < 0) the eventfd of an interrupt vector */
+static int bf_set_intr_eventfd(struct bf_listener *listener,
+                               int vector,
+                               int fd) {
+  struct bf_pci_dev *bfdev = listener->bfdev;
+  struct eventfd_ctx *ctx = NULL, *old_ctx;
+  unsigned long flags;
+
+  if (vector < 0 || vector >= BF_MSIX_ENTRY_CNT) {
+    return EINVAL;
+  }
+  if (fd >= 0) {
+    ctx = eventfd_ctx_fdget(fd);
+    if (IS_ERR(ctx)) {
+      return EINVAL;
+    }
+  }
+
+  spin_lock_irqsave(&bfdev->info.eventfd_lock, flags);
+  old_ctx = bfdev->info.eventfd[vector];
+  bfdev->info.eventfd[vector] = ctx;
+  bfdev->info.eventfd_owner[vector] = ctx ? listener : NULL;
+  spin_unlock_irqrestore(&bfdev->info.eventfd_lock, flags);
+
+  if (old_ctx) {
+    eventfd_ctx_put(old_ctx);
+  }
+  return 0;
+}
+
+/* unbind the eventfd(s) bound by the listener, or all if listener is NULL */
+static void bf_clear_intr_eventfd(struct bf_pci_dev *bfdev,
+                                  struct bf_listener *listener) {
+  struct eventfd_ctx *ctx[BF_MSIX_ENTRY_CNT];
+  unsigned long flags;
+  int i;
+
+  spin_lock_irqsave(&bfdev->info.eventfd_lock, flags);
+  for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
+    ctx[i] = NULL;
+    if (!listener || bfdev->info.eventfd_owner[i] == listener) {
+      ctx[i] = bfdev->info.eventfd[i];
+      bfdev->info.eventfd[i] = NULL;
+      bfdev->info.eventfd_owner[i] = NULL;
+    }
+  }
+  spin_unlock_irqrestore(&bfdev->info.eventfd_lock, flags);
+
+  for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
+    if (ctx[i]) {
+      eventfd_ctx_put(ctx[i]);
+    }
+  }
+}
+
+#define BF_INTR_RING_SIZE PAGE_ALIGN(sizeof(bf_intr_ring_t))
+
+/* attach (enable) or detach the interrupt event ring of the listener; the
+ * ring of a device has a single owner
+ */
+static int bf_set_intr_ring(struct bf_listener *listener,
+                            bf_intr_ring_cfg_t *ring_cfg) {
+  struct bf_pci_dev *bfdev = listener->bfdev;
+  bf_intr_ring_t *ring = NULL;
+  unsigned long flags;
+  int ret = 0;
+
+  mutex_lock(&listener->dma_lock);
+  if (ring_cfg->enable) {
+    if (!listener->intr_ring) {
+      listener->intr_ring = vmalloc_user(BF_INTR_RING_SIZE);
+    }
+    ring = listener->intr_ring;
+    if (!ring) {
+      mutex_unlock(&listener->dma_lock);
+      return ENOMEM;
+    }
+  }
+
+  spin_lock_irqsave(&bfdev->info.eventfd_lock, flags);
+  if (bfdev->info.intr_ring_owner && bfdev->info.intr_ring_owner != listener) {
+    ret = ring ? EBUSY : 0;
+  } else {
+    bfdev->info.intr_ring = ring;
+    bfdev->info.intr_ring_owner = ring ? listener : NULL;
+  }
+  spin_unlock_irqrestore(&bfdev->info.eventfd_lock, flags);
+  mutex_unlock(&listener->dma_lock);
+
+  ring_cfg->size = BF_INTR_RING_SIZE;
+  ring_cfg->mmap_offset = (unsigned long long)BF_INTR_RING_MMAP_INDEX
+                          << PAGE_SHIFT;
+  return ret;
+}
+
+/* detach the interrupt event ring if the listener owns it, or whoever owns
+ * it if listener is NULL; the ISR does not touch the ring once this returns
+ */
+static void bf_clear_intr_ring(struct bf_pci_dev *bfdev,
+                               struct bf_listener *listener) {
+  unsigned long flags;
+
+  spin_lock_irqsave(&bfdev->info.eventfd_lock, flags);
+  if (!listener || bfdev->info.intr_ring_owner == listener) {
+    bfdev->info.intr_ring = NULL;
+    bfdev->info.intr_ring_owner = NULL;
+  }
+  spin_unlock_irqrestore(&bfdev->info.eventfd_lock, flags);
+}
+
+/* allocate a DMA region local to the device; it is huge page sized and
+ * aligned, so that the device and, through an IOMMU or mmap(), the host
+ * use fewer translations for the DR rings and the learn/stat buffers
+ */
+static int bf_dma_alloc(struct bf_listener *listener,
+                        bf_dma_alloc_t *dma_alloc) {
+  struct device *dev = &listener->bfdev->pdev->dev;
+  struct bf_dma_region *region, *cur;
+  unsigned long index = BF_DMA_MMAP_INDEX_BASE;
+  int cnt = 0;
+  size_t size;
+
+  if (dma_alloc->size == 0) {
+    return EINVAL;
+  }
+  size = ALIGN(dma_alloc->size, BF_DMA_HUGE_PAGE_SIZE);
+  region = kzalloc_node(sizeof(*region), GFP_KERNEL, dev_to_node(dev));
+  if (!region) {
+    return ENOMEM;
+  }
+  /* the coherent allocator allocates on dev_to_node() and returns
+   * physically contiguous memory aligned to its size order
+   */
+  region->cpu_addr = dma_alloc_coherent(
+      dev, size, &region->dma_addr, GFP_KERNEL | __GFP_NOWARN);
+  if (!region->cpu_addr) {
+    kfree(region);
+    return ENOMEM;
+  }
+  region->dev = get_device(dev);
+  region->size = size;
+  atomic_set(&region->map_count, 0);
+
+  mutex_lock(&listener->dma_lock);
+  /* the list is kept sorted by index, take the first unused one */
+  list_for_each_entry(cur, &listener->dma_regions, list) {
+    if (cur->index != index) {
+      break;
+    }
+    index++;
+    cnt++;
+  }
+  if (cnt >= BF_DMA_REGIONS_MAX) {
+    mutex_unlock(&listener->dma_lock);
+    dma_free_coherent(dev, size, region->cpu_addr, region->dma_addr);
+    put_device(dev);
+    kfree(region);
+    return ENOSPC;
+  }
+  region->index = index;
+  list_add_tail(&region->list, &cur->list);
+  mutex_unlock(&listener->dma_lock);
+
+  dma_alloc->size = size;
+  dma_alloc->dma_addr = (void *)(uintptr_t)region->dma_addr;
+  dma_alloc->mmap_offset = (unsigned long long)index << PAGE_SHIFT;
+  dma_alloc->node = dev_to_node(dev);
+  return 0;
+}
+
+static void bf_dma_region_free(struct bf_dma_region *region) {
+  list_del(&region->list);
+  dma_free_coherent(
+      region->dev, region->size, region->cpu_addr, region->dma_addr);
+  put_device(region->dev);
+  kfree(region);
+}
+
+static struct bf_dma_region *bf_dma_find(struct bf_listener *listener,
+                                         unsigned long index) {
+  struct bf_dma_region *region;
+
+  list_for_each_entry(region, &listener->dma_regions, list) {
+    if (region->index == index) {
+      return region;
+    }
   }
+  return NULL;
+}
+
+/* free a region which is no longer mapped by user space */
+static int bf_dma_free(struct bf_listener *listener,
+                       unsigned long long mmap_offset) {
+  struct bf_dma_region *region;
+  int ret = 0;
+
+  mutex_lock(&listener->dma_lock);
+  region = bf_dma_find(listener, (unsigned long)(mmap_offset >> PAGE_SHIFT));
+  if (!region) {
+    ret = EINVAL;
+  } else if (atomic_read(&region->map_count)) {
+    ret = EBUSY;
+  } else {
+    bf_dma_region_free(region);
+  }
+  mutex_unlock(&listener->dma_lock);
   return ret;
 }
 
+/* called on release, when the mappings holding the file are gone too */
+static void bf_dma_free_all(struct bf_listener *listener) {
+  struct bf_dma_region *region, *tmp;
+
+  mutex_lock(&listener->dma_lock);
+  list_for_each_entry_safe(region, tmp, &listener->dma_regions, list) {
+    bf_dma_region_free(region);
+  }
+  mutex_unlock(&listener->dma_lock);
+}
+
 static unsigned int bf_poll(struct file *filep, poll_table *wait) {
   struct bf_listener *listener = (struct bf_listener *)filep->private_data;
   struct bf_pci_dev *bfdev = listener->bfdev;
@@ -376,6 +653,15 @@ static unsigned int bf_poll(struct file *filep, poll_table *wait) {
 
   poll_wait(filep, &bfdev->info.wait, wait);
 
+  /* the owner of the interrupt event ring waits for the ring only */
+  if (READ_ONCE(bfdev->info.intr_ring_owner) == listener) {
+    bf_intr_ring_t *ring = listener->intr_ring;
+    if (READ_ONCE(ring->head) != READ_ONCE(ring->tail)) {
+      return POLLIN | POLLRDNORM;
+    }
+    return 0;
+  }
+
   for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
     if (listener->event_count[i] != atomic_read(&bfdev->info.event[i])) {
       return POLLIN | POLLRDNORM;
@@ -437,6 +723,65 @@ static int bf_mmap_physical(struct vm_area_struct *vma) {
                          vma->vm_page_prot);
 }
 
+static void bf_dma_vm_open(struct vm_area_struct *vma) {
+  struct bf_dma_region *region = vma->vm_private_data;
+
+  atomic_inc(&region->map_count);
+}
+
+static void bf_dma_vm_close(struct vm_area_struct *vma) {
+  struct bf_dma_region *region = vma->vm_private_data;
+
+  atomic_dec(&region->map_count);
+}
+
+static const struct vm_operations_struct bf_dma_vm_ops = {
+    .open = bf_dma_vm_open,
+    .close = bf_dma_vm_close,
+};
+
+static int bf_mmap_dma(struct bf_listener *listener,
+                       struct vm_area_struct *vma) {
+  struct bf_dma_region *region;
+  int ret;
+
+  mutex_lock(&listener->dma_lock);
+  region = bf_dma_find(listener, vma->vm_pgoff);
+  if (!region || vma->vm_end - vma->vm_start > region->size) {
+    mutex_unlock(&listener->dma_lock);
+    return -EINVAL;
+  }
+  /* vm_pgoff is the map index, dma_mmap_coherent() takes it as an offset */
+  vma->vm_pgoff = 0;
+  ret = dma_mmap_coherent(region->dev,
+                          vma,
+                          region->cpu_addr,
+                          region->dma_addr,
+                          vma->vm_end - vma->vm_start);
+  if (ret == 0) {
+    vma->vm_private_data = region;
+    vma->vm_ops = &bf_dma_vm_ops;
+    atomic_inc(&region->map_count);
+  }
+  mutex_unlock(&listener->dma_lock);
+  return ret;
+}
+
+static int bf_mmap_intr_ring(struct bf_listener *listener,
+                             struct vm_area_struct *vma) {
+  int ret;
+
+  mutex_lock(&listener->dma_lock);
+  if (!listener->intr_ring ||
+      vma->vm_end - vma->vm_start > BF_INTR_RING_SIZE) {
+    mutex_unlock(&listener->dma_lock);
+    return -EINVAL;
+  }
+  ret = remap_vmalloc_range(vma, listener->intr_ring, 0);
+  mutex_unlock(&listener->dma_lock);
+  return ret;
+}
+
 static int bf_mmap(struct file *filep, struct vm_area_struct *vma) {
   struct bf_listener *listener = filep->private_data;
   struct bf_pci_dev *bfdev = listener->bfdev;
@@ -452,6 +797,12 @@ static int bf_mmap(struct file *filep, struct vm_area_struct *vma) {
 
   vma->vm_private_data = bfdev;
 
+  if (vma->vm_pgoff >= BF_DMA_MMAP_INDEX_BASE) {
+    return bf_mmap_dma(listener, vma);
+  }
+  if (vma->vm_pgoff == BF_INTR_RING_MMAP_INDEX) {
+    return bf_mmap_intr_ring(listener, vma);
+  }
   bar = bf_find_mem_index(vma);
   if (bar < 0) {
     return -EINVAL;
@@ -494,7 +845,11 @@ static int bf_open(struct inode *inode, struct file *filep) {
   if (listener) {
     listener->bfdev = bfdev;
     listener->minor = bfdev->info.minor;
+    listener->read_mode = BF_INTR_READ_MODE_COUNT;
+    listener->intr_ring = NULL;
     listener->next = NULL;
+    INIT_LIST_HEAD(&listener->dma_regions);
+    mutex_init(&listener->dma_lock);
     bf_add_listener(bfdev, listener);
     for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
       listener->event_count[i] = atomic_read(&bfdev->info.event[i]);
@@ -511,22 +866,32 @@ static int bf_release(struct inode *inode, struct file *filep) {
 
   bf_fasync(-1, filep, 0); /* empty any process id in the notification list */
   if (listener->bfdev) {
+    bf_clear_intr_eventfd(listener->bfdev, listener);
+    bf_clear_intr_ring(listener->bfdev, listener);
     bf_remove_listener(listener->bfdev, listener);
   }
+  bf_dma_free_all(listener);
+  vfree(listener->intr_ring);
   kfree(listener);
   return 0;
 }
 
-/* user space support: make read() system call after poll() of select() */
+/* user space support: make read() system call after poll() of select()
+ * In BF_INTR_READ_MODE_COUNT mode, the s32 event count of each vector with
+ * new events (0 otherwise) is returned.
+ * In BF_INTR_READ_MODE_BITMAP mode, a u32 bitmap of the vectors with new
+ * events is returned.
+ */
 static ssize_t bf_read(struct file *filep,
                        char __user *buf,
                        size_t count,
                        loff_t *ppos) {
   struct bf_listener *listener = filep->private_data;
   struct bf_pci_dev *bfdev = listener->bfdev;
+  DECLARE_WAITQUEUE(wait, current);
   int retval, event_count[BF_MSIX_ENTRY_CNT];
-  int i, mismatch_found = 0;                  /* OR of per vector mismatch */
-  unsigned char cnt_match[BF_MSIX_ENTRY_CNT]; /* per vector mismatch */
+  int i, num_vec;
+  u32 event_bmp;  /* per vector mismatch */
 
   if (!bfdev) {
     return -ENODEV;
@@ -539,42 +904,49 @@ static ssize_t bf_read(struct file *filep,
   /* ensure that there is enough space on user buffer for the given interrupt
    * mode */
   if (bfdev->mode == BF_INTR_MODE_MSIX) {
-    if (count < sizeof(s32) * BF_MSIX_ENTRY_CNT) {
-      return -EINVAL;
-    }
-    count = sizeof(s32) * BF_MSIX_ENTRY_CNT;
+    num_vec = BF_MSIX_ENTRY_CNT;
   } else if (bfdev->mode == BF_INTR_MODE_MSI) {
-    if (count < sizeof(s32) * BF_MSI_ENTRY_CNT) {
+    num_vec = BF_MSI_ENTRY_CNT;
+  } else {
+    num_vec = 1;
+  }
+  if (listener->read_mode == BF_INTR_READ_MODE_BITMAP) {
+    if (count < sizeof(u32)) {
       return -EINVAL;
     }
-    count = sizeof(s32) * BF_MSI_ENTRY_CNT;
+    count = sizeof(u32);
   } else {
-    if (count < sizeof(s32)) {
+    if (count < sizeof(s32) * num_vec) {
       return -EINVAL;
     }
-    count = sizeof(s32);
+    count = sizeof(s32) * num_vec;
   }
 
+  add_wait_queue(&bfdev->info.wait, &wait);
   do {
     set_current_state(TASK_INTERRUPTIBLE);
 
-    for (i = 0; i < (count / sizeof(s32)); i++) {
+    event_bmp = 0;
+    for (i = 0; i < num_vec; i++) {
       event_count[i] = atomic_read(&(bfdev->info.event[i]));
       if (event_count[i] != listener->event_count[i]) {
-        mismatch_found |= 1;
-        cnt_match[i] = 1;
+        event_bmp |= (1U << i);
       } else {
         event_count[i] = 0;
-        cnt_match[i] = 0;
       }
     }
-    if (mismatch_found) {
+    if (event_bmp) {
       __set_current_state(TASK_RUNNING);
-      if (copy_to_user(buf, &event_count, count)) {
+      if (listener->read_mode == BF_INTR_READ_MODE_BITMAP) {
+        retval = copy_to_user(buf, &event_bmp, count);
+      } else {
+        retval = copy_to_user(buf, &event_count, count);
+      }
+      if (retval) {
         retval = -EFAULT;
       } else { /* adjust the listener->event_count; */
-        for (i = 0; i < (count / sizeof(s32)); i++) {
-          if (cnt_match[i]) {
+        for (i = 0; i < num_vec; i++) {
+          if (event_bmp & (1U << i)) {
             listener->event_count[i] = event_count[i];
           }
         }
@@ -596,6 +968,7 @@ static ssize_t bf_read(struct file *filep,
   } while (1);
 
   __set_current_state(TASK_RUNNING);
+  remove_wait_queue(&bfdev->info.wait, &wait);
 
   return retval;
 }
@@ -703,10 +1076,12 @@ static long bf_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
           return EINVAL;
         }
       }
+      bf_kpkt_set_irq_affinity(bfdev, 0);
       for (i = 0; i < msix_ind.cnt; i++) {
         bfdev->info.tbus_msix_ind[i] = msix_ind.indices[i];
       }
       bfdev->info.tbus_msix_map_enable = 1;
+      bf_kpkt_set_irq_affinity(bfdev, 1);
     }
     break;
   case BF_GET_INTR_MODE:
@@ -718,6 +1093,68 @@ static long bf_ioctl(struct file *filep, unsigned int cmd, unsigned long arg)
       }
     }
     break;
+  case BF_INTR_EVENTFD:
+    {
+      bf_intr_eventfd_t i_eventfd;
+      if (copy_from_user(&i_eventfd, addr, sizeof(bf_intr_eventfd_t))) {
+        return EFAULT;
+      }
+      return bf_set_intr_eventfd(listener, i_eventfd.vector, i_eventfd.fd);
+    }
+  case BF_INTR_READ_MODE:
+    {
+      bf_intr_read_mode_t i_read_mode;
+      if (copy_from_user(&i_read_mode, addr, sizeof(bf_intr_read_mode_t))) {
+        return EFAULT;
+      }
+      if (i_read_mode.read_mode != BF_INTR_READ_MODE_COUNT &&
+          i_read_mode.read_mode != BF_INTR_READ_MODE_BITMAP) {
+        return EINVAL;
+      }
+      listener->read_mode = i_read_mode.read_mode;
+    }
+    break;
+  case BF_DMA_ALLOC:
+    {
+      bf_dma_alloc_t dma_alloc;
+      int ret;
+      if (copy_from_user(&dma_alloc, addr, sizeof(bf_dma_alloc_t))) {
+        return EFAULT;
+      }
+      ret = bf_dma_alloc(listener, &dma_alloc);
+      if (ret) {
+        return ret;
+      }
+      if (copy_to_user(addr, &dma_alloc, sizeof(bf_dma_alloc_t))) {
+        bf_dma_free(listener, dma_alloc.mmap_offset);
+        return EFAULT;
+      }
+    }
+    break;
+  case BF_DMA_FREE:
+    {
+      bf_dma_alloc_t dma_alloc;
+      if (copy_from_user(&dma_alloc, addr, sizeof(bf_dma_alloc_t))) {
+        return EFAULT;
+      }
+      return bf_dma_free(listener, dma_alloc.mmap_offset);
+    }
+  case BF_INTR_RING:
+    {
+      bf_intr_ring_cfg_t ring_cfg;
+      int ret;
+      if (copy_from_user(&ring_cfg, addr, sizeof(bf_intr_ring_cfg_t))) {
+        return EFAULT;
+      }
+      ret = bf_set_intr_ring(listener, &ring_cfg);
+      if (ret) {
+        return ret;
+      }
+      if (copy_to_user(addr, &ring_cfg, sizeof(bf_intr_ring_cfg_t))) {
+        return EFAULT;
+      }
+    }
+    break;
   default:
     return EINVAL;
   }
@@ -815,6 +1252,7 @@ int bf_register_device(struct device *parent, struct bf_pci_dev *bfdev) {
   }
 
   init_waitqueue_head(&info->wait);
+  spin_lock_init(&info->eventfd_lock);
 
   for (i = 0; i < BF_MSIX_ENTRY_CNT; i++) {
     atomic_set(&info->event[i], 0);
@@ -917,6 +1355,7 @@ void bf_unregister_device(struct bf_pci_dev *bfdev) {
   int i;
 
   if (info->irq) {
+    bf_kpkt_set_irq_affinity(bfdev, 0);
     if (bfdev->mode == BF_INTR_MODE_LEGACY) {
       free_irq(info->irq, (void *)&(bfdev->bf_int_vec[0]));
     } else if (bfdev->mode == BF_INTR_MODE_MSIX) {
@@ -929,6 +1368,8 @@ void bf_unregister_device(struct bf_pci_dev *bfdev) {
       }
     }
   }
+  bf_clear_intr_eventfd(bfdev, NULL);
+  bf_clear_intr_ring(bfdev, NULL);
   device_destroy(bf_class, MKDEV(bf_major, info->minor));
   bf_remove_cdev(bfdev);
   bf_return_minor_no(info->minor);
@@ -1459,6 +1900,14 @@ MODULE_PARM_DESC(kpkt_dr_int_en,
                  " 0 Do not use interrupt\n"
                  "\n");
 
+/* irq_affinity is applicable only if MSIX interrupt mode is selected */
+module_param(kpkt_irq_affinity, int, S_IRUGO);
+MODULE_PARM_DESC(kpkt_irq_affinity,
+                 "bf pkt TBUS MSIX vector affinity (default=0):\n"
+                 " 1 spread the vectors over the cpus local to the device\n"
+                 " 0 leave the vector affinity to the system\n"
+                 "\n");
+
 module_param(intr_mode, charp, S_IRUGO);
 MODULE_PARM_DESC(intr_mode,
                  "bf interrupt mode (default=msix):\n"
@@ -79,11 +79,31 @@ struct bf_dev_mem {
   void __iomem *internal_addr;
 };
 
+/* mmap() map index of the first BF_DMA_ALLOC region, above the BAR indices */
+#define BF_DMA_MMAP_INDEX_BASE 0x1000
+/* mmap() map index of the interrupt event ring of a listener */
+#define BF_INTR_RING_MMAP_INDEX 0x800
+
+/* DMA region allocated by BF_DMA_ALLOC, owned by the listener */
+struct bf_dma_region {
+  struct list_head list;
+  struct device *dev; /* referenced while the region exists */
+  void *cpu_addr;
+  dma_addr_t dma_addr;
+  size_t size;
+  unsigned long index; /* mmap() map index */
+  atomic_t map_count;  /* user mappings of the region */
+};
+
 struct bf_listener {
   struct bf_pci_dev *bfdev;
   s32 event_count[BF_MSIX_ENTRY_CNT];
+  enum bf_intr_read_mode read_mode;
   int minor;
   struct bf_listener *next;
+  struct list_head dma_regions;
+  struct mutex dma_lock; /* protects dma_regions and intr_ring */
+  bf_intr_ring_t *intr_ring; /* vmalloc_user(), freed on release */
 };
 
 /* device information */
@@ -93,6 +113,13 @@ struct bf_dev_info {
   int minor;
   atomic_t event[BF_MSIX_ENTRY_CNT];
   wait_queue_head_t wait;
+  /* per vector eventfd signaled from the ISR, protected by eventfd_lock */
+  struct eventfd_ctx *eventfd[BF_MSIX_ENTRY_CNT];
+  struct bf_listener *eventfd_owner[BF_MSIX_ENTRY_CNT];
+  spinlock_t eventfd_lock;
+  /* interrupt event ring filled by the ISR, protected by eventfd_lock */
+  bf_intr_ring_t *intr_ring;
+  struct bf_listener *intr_ring_owner;
   const char *version;
   struct bf_dev_mem mem[BF_MAX_BAR_MAPS];
   struct msix_entry *msix_entries;
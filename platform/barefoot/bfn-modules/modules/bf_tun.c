@@ -72,6 +72,8 @@
 #include <linux/seq_file.h>
 #include <linux/uio.h>
 #include <linux/skb_array.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
 
 #include <asm/uaccess.h>
 
@@ -120,6 +122,18 @@ do {								\
 		      IFF_MULTI_QUEUE)
 #define GOODCOPY_LEN 128
 
+/* bf_tun private ioctls to move up to N (0 = off) frames per read()/write()
+ * on a queue. Each frame in the buffer is preceded by a struct tun_batch_hdr
+ * and immediately followed by the next one.
+ */
+#define TUNSETBATCH	_IOW('T', 240, int)
+#define TUNGETBATCH	_IOR('T', 241, int)
+#define TUN_BATCH_MAX	64
+
+struct tun_batch_hdr {
+	__u32 len;	/* length of the frame, including tun_pi/vnet header */
+};
+
 #define FLT_EXACT_COUNT 8
 struct tap_filter {
 	unsigned int    count;    /* Number of addrs. Zero means disabled */
@@ -171,6 +185,7 @@ struct tun_file {
 	struct list_head next;
 	struct tun_struct *detached;
 	struct skb_array tx_array;
+	unsigned int batch;
 };
 
 struct tun_flow_entry {
@@ -221,6 +236,7 @@ struct tun_struct {
 	void *security;
 	u32 flow_count;
 	struct tun_pcpu_stats __percpu *pcpu_stats;
+	struct bpf_prog __rcu *xdp_prog;
 };
 
 #ifdef CONFIG_TUN_VNET_CROSS_LE
@@ -418,10 +434,14 @@ static void tun_flow_update(struct tun_struct *tun, u32 rxhash,
 	e = tun_flow_find(head, rxhash);
 	if (likely(e)) {
 		/* TODO: keep queueing to old queue until it's empty? */
-		e->queue_index = queue_index;
-		e->updated = jiffies;
+		/* only write when changed, the entry is read by every cpu
+		 * selecting a queue for the flow */
+		if (unlikely(READ_ONCE(e->queue_index) != queue_index))
+			WRITE_ONCE(e->queue_index, queue_index);
+		if (e->updated != jiffies)
+			e->updated = jiffies;
 		sock_rps_record_flow_hash(e->rps_rxhash);
-	} else {
+	} else if (READ_ONCE(tun->flow_count) < MAX_TAP_FLOWS) {
 		spin_lock_bh(&tun->lock);
 		if (!tun_flow_find(head, rxhash) &&
 		    tun->flow_count < MAX_TAP_FLOWS)
@@ -470,7 +490,7 @@ static u16 tun_select_queue(struct net_device *dev, struct sk_buff *skb,
 		e = tun_flow_find(&tun->flows[tun_hashfn(txq)], txq);
 		if (e) {
 			tun_flow_save_rps_rxhash(e, txq);
-			txq = e->queue_index;
+			txq = READ_ONCE(e->queue_index);
 		} else
 			/* use multiply and shift instead of expensive divide */
 			txq = ((u64)txq * numqueues) >> 32;
@@ -824,7 +844,15 @@ static const struct ethtool_ops tun_ethtool_ops;
 /* Net device detach from fd. */
 static void tun_net_uninit(struct net_device *dev)
 {
+	struct tun_struct *tun = netdev_priv(dev);
+	struct bpf_prog *xdp_prog = rtnl_dereference(tun->xdp_prog);
+
 	tun_detach_all(dev);
+
+	if (xdp_prog) {
+		RCU_INIT_POINTER(tun->xdp_prog, NULL);
+		bpf_prog_put(xdp_prog);
+	}
 }
 
 /* Net device open. */
@@ -1040,6 +1068,34 @@ tun_change_carrier(struct net_device *dev, bool new_carrier) {
   return 0;
 }
 
+static int tun_xdp_set(struct net_device *dev, struct bpf_prog *prog)
+{
+	struct tun_struct *tun = netdev_priv(dev);
+	struct bpf_prog *old_prog;
+
+	old_prog = rtnl_dereference(tun->xdp_prog);
+	rcu_assign_pointer(tun->xdp_prog, prog);
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	return 0;
+}
+
+static int tun_xdp(struct net_device *dev, struct netdev_xdp *xdp)
+{
+	struct tun_struct *tun = netdev_priv(dev);
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		return tun_xdp_set(dev, xdp->prog);
+	case XDP_QUERY_PROG:
+		xdp->prog_attached = !!rtnl_dereference(tun->xdp_prog);
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
 static const struct net_device_ops tun_netdev_ops = {
 	.ndo_uninit		= tun_net_uninit,
 	.ndo_open		= tun_net_open,
@@ -1054,6 +1110,7 @@ static const struct net_device_ops tun_netdev_ops = {
 	.ndo_set_rx_headroom	= tun_set_headroom,
 	.ndo_get_stats64	= tun_net_get_stats64,
 	.ndo_change_carrier	= tun_change_carrier,
+	.ndo_xdp		= tun_xdp,
 };
 
 static const struct net_device_ops tap_netdev_ops = {
@@ -1074,6 +1131,7 @@ static const struct net_device_ops tap_netdev_ops = {
 	.ndo_set_rx_headroom	= tun_set_headroom,
 	.ndo_get_stats64	= tun_net_get_stats64,
 	.ndo_change_carrier	= tun_change_carrier,
+	.ndo_xdp		= tun_xdp,
 };
 
 static void tun_flow_init(struct tun_struct *tun)
@@ -1189,6 +1247,55 @@ static struct sk_buff *tun_alloc_skb(struct tun_file *tfile,
 	return skb;
 }
 
+/* Run the XDP program on a packet written by user space before it enters
+ * the stack. XDP_TX sends the packet back to the queue it was written on.
+ * Returns true if the skb was consumed.
+ */
+static bool tun_run_xdp(struct tun_struct *tun, struct tun_file *tfile,
+			struct sk_buff *skb)
+{
+	struct bpf_prog *xdp_prog;
+	struct xdp_buff xdp;
+	u32 act;
+
+	rcu_read_lock();
+	xdp_prog = rcu_dereference(tun->xdp_prog);
+	if (!xdp_prog || skb_is_gso(skb))
+		goto pass;
+	if (skb_linearize(skb))
+		goto drop;
+
+	xdp.data = skb->data;
+	xdp.data_end = skb->data + skb->len;
+	act = bpf_prog_run_xdp(xdp_prog, &xdp);
+	switch (act) {
+	case XDP_PASS:
+		goto pass;
+	case XDP_TX:
+		skb_set_queue_mapping(skb, tfile->queue_index);
+		local_bh_disable();
+		tun_net_xmit(skb, tun->dev);
+		local_bh_enable();
+		rcu_read_unlock();
+		return true;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+	case XDP_DROP:
+		goto drop;
+	}
+
+drop:
+	rcu_read_unlock();
+	this_cpu_inc(tun->pcpu_stats->rx_dropped);
+	kfree_skb(skb);
+	return true;
+pass:
+	rcu_read_unlock();
+	return false;
+}
+
 /* Get packet from user space buffer */
 static ssize_t tun_get_user(struct tun_struct *tun, struct tun_file *tfile,
 			    void *msg_control, struct iov_iter *from,
@@ -1298,6 +1405,16 @@ static ssize_t tun_get_user(struct tun_struct *tun, struct tun_file *tfile,
 		return -EINVAL;
 	}
 
+	/* zerocopy pages stay owned by the writer until the skb is freed */
+	if (!zerocopy && rcu_access_pointer(tun->xdp_prog) &&
+	    tun_run_xdp(tun, tfile, skb)) {
+		if (msg_control) {
+			struct ubuf_info *uarg = msg_control;
+			uarg->callback(uarg, false);
+		}
+		return total_len;
+	}
+
 	switch (tun->flags & TUN_TYPE_MASK) {
 	case IFF_TUN:
 		if (tun->flags & IFF_NO_PI) {
@@ -1353,17 +1470,57 @@ static ssize_t tun_get_user(struct tun_struct *tun, struct tun_file *tfile,
 	return total_len;
 }
 
+/* Get up to batch packets from the user space buffer, returns the number
+ * of bytes consumed
+ */
+static ssize_t tun_get_user_batch(struct tun_struct *tun, struct tun_file *tfile,
+				  unsigned int batch, struct iov_iter *from,
+				  int noblock)
+{
+	struct tun_batch_hdr hdr;
+	struct iov_iter frame;
+	ssize_t ret, total = 0;
+	unsigned int n;
+
+	for (n = 0; n < batch && iov_iter_count(from); n++) {
+		if (copy_from_iter(&hdr, sizeof(hdr), from) != sizeof(hdr) ||
+		    hdr.len > iov_iter_count(from)) {
+			ret = -EINVAL;
+			goto err;
+		}
+
+		frame = *from;
+		iov_iter_truncate(&frame, hdr.len);
+		ret = tun_get_user(tun, tfile, NULL, &frame, noblock);
+		if (ret < 0)
+			goto err;
+
+		iov_iter_advance(from, hdr.len);
+		total += sizeof(hdr) + hdr.len;
+	}
+	return total;
+
+err:
+	return total ? total : ret;
+}
+
 static ssize_t tun_chr_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
 	struct file *file = iocb->ki_filp;
 	struct tun_struct *tun = tun_get(file);
 	struct tun_file *tfile = file->private_data;
+	unsigned int batch = READ_ONCE(tfile->batch);
 	ssize_t result;
 
 	if (!tun)
 		return -EBADFD;
 
-	result = tun_get_user(tun, tfile, NULL, from, file->f_flags & O_NONBLOCK);
+	if (batch)
+		result = tun_get_user_batch(tun, tfile, batch, from,
+					    file->f_flags & O_NONBLOCK);
+	else
+		result = tun_get_user(tun, tfile, NULL, from,
+				      file->f_flags & O_NONBLOCK);
 
 	tun_put(tun);
 	return result;
@@ -1537,16 +1694,84 @@ static ssize_t tun_do_read(struct tun_struct *tun, struct tun_file *tfile,
 	return ret;
 }
 
+/* Put up to batch packets to the user space buffer. Only the first packet
+ * waits and may be truncated, the following ones are taken only if they are
+ * queued and fit in the rest of the buffer.
+ */
+static ssize_t tun_do_read_batch(struct tun_struct *tun, struct tun_file *tfile,
+				 unsigned int batch, struct iov_iter *to,
+				 int noblock)
+{
+	size_t frame_hlen = 0;
+	struct tun_batch_hdr hdr;
+	struct iov_iter hdr_iter;
+	struct sk_buff *skb;
+	ssize_t ret, total = 0;
+	size_t avail;
+	unsigned int n;
+	int err, len;
+
+	if (iov_iter_count(to) <= sizeof(hdr))
+		return -EINVAL;
+
+	if (!(tun->flags & IFF_NO_PI))
+		frame_hlen += sizeof(struct tun_pi);
+	if (tun->flags & IFF_VNET_HDR)
+		frame_hlen += READ_ONCE(tun->vnet_hdr_sz);
+
+	for (n = 0; n < batch && iov_iter_count(to) > sizeof(hdr); n++) {
+		if (n) {
+			len = skb_array_peek_len(&tfile->tx_array);
+			if (!len ||
+			    sizeof(hdr) + frame_hlen + len > iov_iter_count(to))
+				break;
+		}
+
+		skb = tun_ring_recv(tfile, noblock || n, &err);
+		if (!skb) {
+			if (!n)
+				return err;
+			break;
+		}
+
+		/* the header is filled in once the frame length is known */
+		hdr_iter = *to;
+		iov_iter_advance(to, sizeof(hdr));
+		avail = iov_iter_count(to);
+
+		ret = tun_put_user(tun, tfile, skb, to);
+		if (unlikely(ret < 0)) {
+			kfree_skb(skb);
+			if (!n)
+				return ret;
+			break;
+		}
+		consume_skb(skb);
+
+		hdr.len = min_t(size_t, ret, avail);
+		if (copy_to_iter(&hdr, sizeof(hdr), &hdr_iter) != sizeof(hdr))
+			return total ? total : -EFAULT;
+		total += sizeof(hdr) + hdr.len;
+	}
+
+	return total;
+}
+
 static ssize_t tun_chr_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
 	struct file *file = iocb->ki_filp;
 	struct tun_file *tfile = file->private_data;
 	struct tun_struct *tun = __tun_get(tfile);
 	ssize_t len = iov_iter_count(to), ret;
+	unsigned int batch = READ_ONCE(tfile->batch);
 
 	if (!tun)
 		return -EBADFD;
-	ret = tun_do_read(tun, tfile, to, file->f_flags & O_NONBLOCK);
+	if (batch)
+		ret = tun_do_read_batch(tun, tfile, batch, to,
+					file->f_flags & O_NONBLOCK);
+	else
+		ret = tun_do_read(tun, tfile, to, file->f_flags & O_NONBLOCK);
 	ret = min_t(ssize_t, ret, len);
 	if (ret > 0)
 		iocb->ki_pos = ret;
@@ -2030,6 +2255,7 @@ static long __tun_chr_ioctl(struct file *file, unsigned int cmd,
 	int sndbuf;
 	int vnet_hdr_sz;
 	unsigned int ifindex;
+	int batch;
 	int le;
 	int ret;
 
@@ -2234,6 +2460,25 @@ static long __tun_chr_ioctl(struct file *file, unsigned int cmd,
 		tun->vnet_hdr_sz = vnet_hdr_sz;
 		break;
 
+	case TUNGETBATCH:
+		batch = tfile->batch;
+		if (put_user(batch, (int __user *)argp))
+			ret = -EFAULT;
+		break;
+
+	case TUNSETBATCH:
+		if (get_user(batch, (int __user *)argp)) {
+			ret = -EFAULT;
+			break;
+		}
+		if (batch < 0 || batch > TUN_BATCH_MAX) {
+			ret = -EINVAL;
+			break;
+		}
+
+		WRITE_ONCE(tfile->batch, batch);
+		break;
+
 	case TUNGETVNETLE:
 		le = !!(tun->flags & TUN_VNET_LE);
 		if (put_user(le, (int __user *)argp))
@@ -2369,6 +2614,7 @@ static int tun_chr_open(struct inode *inode, struct file * file)
 	RCU_INIT_POINTER(tfile->tun, NULL);
 	tfile->flags = 0;
 	tfile->ifindex = 0;
+	tfile->batch = 0;
 
 	init_waitqueue_head(&tfile->wq.wait);
 	RCU_INIT_POINTER(tfile->socket.wq, &tfile->wq);
@@ -0,0 +1,238 @@
+/*******************************************************************************
+ Barefoot Networks FPGA Linux driver
+ Copyright(c) 2018 - 2019 Barefoot Networks, Inc.
+
+ This program is free software; you can redistribute it and/or modify it
+ under the terms and conditions of the GNU General Public License,
+ version 2, as published by the Free Software Foundation.
+
+ This program is distributed in the hope it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+ The full GNU General Public License is included in this distribution in
+ the file called "COPYING".
+
+ Contact Information:
+ info@barefootnetworks.com
+ Barefoot Networks, 4750 Patrick Henry Drive, Santa Clara CA 95054
+
+*******************************************************************************/
+#include <linux/types.h>
+#include <linux/device.h>
+#include <linux/slab.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/eventfd.h>
+#include <linux/uaccess.h>
+#include <linux/version.h>
+#include "bf_fpga_ioctl.h"
+#include "bf_fpga_priv.h"
+#include "i2c/bf_fpga_i2c.h"
+
+/* asynchronous one-time i2c operations
+ *
+ * Each bus has its own queue of pending operations and its own work item, so
+ * that operations submitted for different buses run on their controllers in
+ * parallel; a scan of all the buses takes as long as the slowest one.
+ * Completed operations are kept on a completion queue until reaped, and the
+ * optional eventfd is signaled once per completion.
+ */
+
+struct bf_fpga_i2c_async_entry {
+  struct list_head list;
+  bf_fpga_i2c_async_op_t op;
+};
+
+static struct bf_fpga_i2c_async_ctx {
+  struct workqueue_struct *wq;
+  struct work_struct work[BF_I2C_FPGA_NUM_CTRL];
+  struct list_head pending[BF_I2C_FPGA_NUM_CTRL];
+  struct list_head done;
+  int outstanding; /* submitted and not yet reaped */
+  spinlock_t lock; /* protects the lists, outstanding and evfd */
+  struct mutex reap_lock;
+  struct eventfd_ctx *evfd;
+} bf_async;
+
+static void bf_fpga_i2c_async_work(struct work_struct *work) {
+  int bus_id = work - bf_async.work;
+  struct bf_fpga_i2c_async_entry *entry;
+
+  while (1) {
+    spin_lock(&bf_async.lock);
+    if (list_empty(&bf_async.pending[bus_id])) {
+      spin_unlock(&bf_async.lock);
+      break;
+    }
+    entry = list_first_entry(
+        &bf_async.pending[bus_id], struct bf_fpga_i2c_async_entry, list);
+    list_del(&entry->list);
+    spin_unlock(&bf_async.lock);
+
+    entry->op.ret = fpga_i2c_oneshot(&entry->op.i2c_op);
+
+    spin_lock(&bf_async.lock);
+    list_add_tail(&entry->list, &bf_async.done);
+    if (bf_async.evfd) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+      eventfd_signal(bf_async.evfd);
+#else
+      eventfd_signal(bf_async.evfd, 1);
+#endif
+    }
+    spin_unlock(&bf_async.lock);
+  }
+}
+
+int bf_fpga_i2c_async_init(void) {
+  int i;
+
+  /* up to one worker per bus, so that the buses do not wait for each other */
+  bf_async.wq =
+      alloc_workqueue("bf_fpga_i2c", WQ_UNBOUND, BF_I2C_FPGA_NUM_CTRL);
+  if (!bf_async.wq) {
+    return -ENOMEM;
+  }
+  for (i = 0; i < BF_I2C_FPGA_NUM_CTRL; i++) {
+    INIT_WORK(&bf_async.work[i], bf_fpga_i2c_async_work);
+    INIT_LIST_HEAD(&bf_async.pending[i]);
+  }
+  INIT_LIST_HEAD(&bf_async.done);
+  bf_async.outstanding = 0;
+  spin_lock_init(&bf_async.lock);
+  mutex_init(&bf_async.reap_lock);
+  bf_async.evfd = NULL;
+  return 0;
+}
+
+void bf_fpga_i2c_async_deinit(void) {
+  struct bf_fpga_i2c_async_entry *entry, *tmp;
+
+  if (!bf_async.wq) {
+    return;
+  }
+  /* let the queued operations complete before the i2c resources go away */
+  destroy_workqueue(bf_async.wq);
+  bf_async.wq = NULL;
+  list_for_each_entry_safe(entry, tmp, &bf_async.done, list) {
+    list_del(&entry->list);
+    kfree(entry);
+  }
+  bf_async.outstanding = 0;
+  if (bf_async.evfd) {
+    eventfd_ctx_put(bf_async.evfd);
+    bf_async.evfd = NULL;
+  }
+}
+
+/* queue the user supplied operations; stops at the first one which can not be
+ * queued and returns an error only if none was queued
+ */
+int bf_fpga_i2c_async_submit(bf_fpga_i2c_async_t *async) {
+  bf_fpga_i2c_async_op_t __user *uops =
+      (bf_fpga_i2c_async_op_t __user *)(uintptr_t)async->ops;
+  struct bf_fpga_i2c_async_entry *entry;
+  bf_fpga_i2c_t *i2c_op;
+  int i, ret = 0;
+
+  async->num_done = 0;
+  if (!bf_async.wq || async->num_ops < 0) {
+    return -EINVAL;
+  }
+  for (i = 0; i < async->num_ops; i++) {
+    entry = kmalloc(sizeof(*entry), GFP_KERNEL);
+    if (!entry) {
+      ret = -ENOMEM;
+      break;
+    }
+    if (copy_from_user(&entry->op, &uops[i], sizeof(entry->op))) {
+      kfree(entry);
+      ret = -EFAULT;
+      break;
+    }
+    i2c_op = &entry->op.i2c_op;
+    if (i2c_op->inst_hndl.bus_id >= BF_I2C_FPGA_NUM_CTRL ||
+        i2c_op->num_i2c == 0 || i2c_op->num_i2c > BF_FPGA_I2C_MAX_NUM_INST ||
+        i2c_op->one_time == 0) {
+      kfree(entry);
+      ret = -EINVAL;
+      break;
+    }
+    spin_lock(&bf_async.lock);
+    if (bf_async.outstanding >= BF_FPGA_I2C_ASYNC_MAX_OPS) {
+      spin_unlock(&bf_async.lock);
+      kfree(entry);
+      ret = -EBUSY;
+      break;
+    }
+    bf_async.outstanding++;
+    list_add_tail(&entry->list, &bf_async.pending[i2c_op->inst_hndl.bus_id]);
+    spin_unlock(&bf_async.lock);
+    queue_work(bf_async.wq, &bf_async.work[i2c_op->inst_hndl.bus_id]);
+    async->num_done++;
+  }
+  return (async->num_done ? 0 : ret);
+}
+
+/* copy up to num_ops completed operations to the user, in completion order */
+int bf_fpga_i2c_async_reap(bf_fpga_i2c_async_t *async) {
+  bf_fpga_i2c_async_op_t __user *uops =
+      (bf_fpga_i2c_async_op_t __user *)(uintptr_t)async->ops;
+  struct bf_fpga_i2c_async_entry *entry;
+  int ret = 0;
+
+  async->num_done = 0;
+  if (!bf_async.wq || async->num_ops < 0) {
+    return -EINVAL;
+  }
+  /* an entry leaves the completion queue only once it is copied out */
+  mutex_lock(&bf_async.reap_lock);
+  while (async->num_done < async->num_ops) {
+    spin_lock(&bf_async.lock);
+    entry = list_first_entry_or_null(
+        &bf_async.done, struct bf_fpga_i2c_async_entry, list);
+    spin_unlock(&bf_async.lock);
+    if (!entry) {
+      break;
+    }
+    if (copy_to_user(&uops[async->num_done], &entry->op, sizeof(entry->op))) {
+      ret = -EFAULT;
+      break;
+    }
+    spin_lock(&bf_async.lock);
+    list_del(&entry->list);
+    bf_async.outstanding--;
+    spin_unlock(&bf_async.lock);
+    kfree(entry);
+    async->num_done++;
+  }
+  mutex_unlock(&bf_async.reap_lock);
+  return (async->num_done ? 0 : ret);
+}
+
+int bf_fpga_i2c_async_set_eventfd(int fd) {
+  struct eventfd_ctx *evfd = NULL, *old;
+
+  if (fd >= 0) {
+    evfd = eventfd_ctx_fdget(fd);
+    if (IS_ERR(evfd)) {
+      return PTR_ERR(evfd);
+    }
+  }
+  spin_lock(&bf_async.lock);
+  old = bf_async.evfd;
+  bf_async.evfd = evfd;
+  spin_unlock(&bf_async.lock);
+  if (old) {
+    eventfd_ctx_put(old);
+  }
+  return 0;
+}
@@ -0,0 +1,246 @@
+/*******************************************************************************
+ Barefoot Networks FPGA Linux driver
+ Copyright(c) 2018 - 2019 Barefoot Networks, Inc.
+
+ This program is free software; you can redistribute it and/or modify it
+ under the terms and conditions of the GNU General Public License,
+ version 2, as published by the Free Software Foundation.
+
+ This program is distributed in the hope it will be useful, but WITHOUT
+ ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ more details.
+
+ You should have received a copy of the GNU General Public License along with
+ this program; if not, write to the Free Software Foundation, Inc.,
+ 51 Franklin St - Fifth Floor, Boston, MA 02110-1301 USA.
+
+ The full GNU General Public License is included in this distribution in
+ the file called "COPYING".
+
+ Contact Information:
+ info@barefootnetworks.com
+ Barefoot Networks, 4750 Patrick Henry Drive, Santa Clara CA 95054
+
+*******************************************************************************/
+#include <linux/types.h>
+#include <linux/device.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
+#include <linux/version.h>
+#include "bf_fpga_ioctl.h"
+#include "bf_fpga_priv.h"
+#include "i2c/bf_fpga_i2c.h"
+
+/* periodic i2c monitor
+ *
+ * Each monitor entry is a periodic ADDR_READ instruction, so the fpga keeps
+ * reading the register range (e.g. the DOM values of a transceiver) without
+ * the host. The refresh work copies the latest read data of all the entries
+ * into a table at the configured interval; user space mmap()s the table and
+ * reads it without any system call.
+ */
+
+static struct bf_fpga_i2c_mon_ctx {
+  bf_fpga_i2c_mon_table_t *table; /* vmalloc_user()ed, mapped to users */
+  int inst_id[BF_FPGA_I2C_MON_MAX_ENTRY]; /* periodic instruction per entry */
+  struct mutex lock;     /* protects the entries */
+  struct mutex ctl_lock; /* serializes the interval changes */
+  struct delayed_work work;
+} bf_mon;
+
+/* reader side: retry while seq is odd or has changed across the read */
+static void bf_fpga_i2c_mon_begin_update(bf_fpga_i2c_mon_data_t *data) {
+  WRITE_ONCE(data->seq, data->seq + 1);
+  smp_wmb();
+}
+
+static void bf_fpga_i2c_mon_end_update(bf_fpga_i2c_mon_data_t *data) {
+  smp_wmb();
+  WRITE_ONCE(data->seq, data->seq + 1);
+}
+
+static void bf_fpga_i2c_mon_work(struct work_struct *work) {
+  uint8_t buf[BF_FPGA_I2C_MON_MAX_DATA];
+  bf_fpga_i2c_mon_data_t *data;
+  unsigned int interval_ms;
+  uint8_t status;
+  int i;
+
+  mutex_lock(&bf_mon.lock);
+  for (i = 0; i < BF_FPGA_I2C_MON_MAX_ENTRY; i++) {
+    data = &bf_mon.table->entry[i];
+    if (!data->in_use) {
+      continue;
+    }
+    /* a failed read leaves the entry with its old timestamp */
+    if (fpga_i2c_inst_status(data->bus_id, bf_mon.inst_id[i], &status) ||
+        fpga_i2c_data_read(
+            data->bus_id, bf_mon.inst_id[i], 0, data->rd_cnt, buf)) {
+      continue;
+    }
+    bf_fpga_i2c_mon_begin_update(data);
+    data->status = status;
+    memcpy(data->data, buf, data->rd_cnt);
+    data->timestamp_ns = ktime_get_ns();
+    bf_fpga_i2c_mon_end_update(data);
+  }
+  mutex_unlock(&bf_mon.lock);
+
+  interval_ms = READ_ONCE(bf_mon.table->interval_ms);
+  if (interval_ms) {
+    schedule_delayed_work(&bf_mon.work, msecs_to_jiffies(interval_ms));
+  }
+}
+
+int bf_fpga_i2c_mon_init(void) {
+  BUILD_BUG_ON(BF_FPGA_I2C_MON_MMAP_PGOFF < BF_MAX_BAR_MAPS);
+
+  bf_mon.table = vmalloc_user(sizeof(bf_fpga_i2c_mon_table_t));
+  if (!bf_mon.table) {
+    return -ENOMEM;
+  }
+  bf_mon.table->num_entry = BF_FPGA_I2C_MON_MAX_ENTRY;
+  mutex_init(&bf_mon.lock);
+  mutex_init(&bf_mon.ctl_lock);
+  INIT_DELAYED_WORK(&bf_mon.work, bf_fpga_i2c_mon_work);
+  return 0;
+}
+
+void bf_fpga_i2c_mon_deinit(void) {
+  bf_fpga_i2c_mon_t mon;
+  int i;
+
+  if (!bf_mon.table) {
+    return;
+  }
+  bf_fpga_i2c_mon_set_interval(0);
+  for (i = 0; i < BF_FPGA_I2C_MON_MAX_ENTRY; i++) {
+    mon.entry = i;
+    bf_fpga_i2c_mon_del(&mon);
+  }
+  /* the pages stay with the existing user mappings until they go away */
+  vfree(bf_mon.table);
+  bf_mon.table = NULL;
+}
+
+int bf_fpga_i2c_mon_add(bf_fpga_i2c_mon_t *mon) {
+  bf_fpga_i2c_mon_data_t *data;
+  bf_fpga_i2c_t i2c_op;
+  int ret;
+
+  if (!bf_mon.table || mon->entry < 0 ||
+      mon->entry >= BF_FPGA_I2C_MON_MAX_ENTRY ||
+      mon->bus_id >= BF_I2C_FPGA_NUM_CTRL || mon->rd_cnt == 0 ||
+      mon->rd_cnt > BF_FPGA_I2C_MON_MAX_DATA) {
+    return -EINVAL;
+  }
+  memset(&i2c_op, 0, sizeof(i2c_op));
+  i2c_op.num_i2c = 1;
+  i2c_op.one_time = 0;
+  i2c_op.inst_hndl.bus_id = mon->bus_id;
+  i2c_op.i2c_inst[0].en = true;
+  i2c_op.i2c_inst[0].i2c_addr = mon->i2c_addr;
+  i2c_op.i2c_inst[0].i2c_type = BF_FPGA_I2C_ADDR_READ;
+  i2c_op.i2c_inst[0].wr_cnt = 1;
+  i2c_op.i2c_inst[0].wr_buf[0] = mon->offset;
+  i2c_op.i2c_inst[0].rd_cnt = mon->rd_cnt;
+
+  mutex_lock(&bf_mon.lock);
+  data = &bf_mon.table->entry[mon->entry];
+  if (data->in_use) {
+    mutex_unlock(&bf_mon.lock);
+    return -EBUSY;
+  }
+  ret = fpga_i2c_pr_add(&i2c_op);
+  if (ret == 0) {
+    /* periodic instructions run only while the controller is started */
+    ret = fpga_i2c_start(mon->bus_id);
+    if (ret) {
+      fpga_i2c_del(&i2c_op);
+    }
+  }
+  if (ret) {
+    mutex_unlock(&bf_mon.lock);
+    return ret;
+  }
+  bf_mon.inst_id[mon->entry] = i2c_op.inst_hndl.inst_id;
+  bf_fpga_i2c_mon_begin_update(data);
+  data->bus_id = mon->bus_id;
+  data->i2c_addr = mon->i2c_addr;
+  data->offset = mon->offset;
+  data->rd_cnt = mon->rd_cnt;
+  data->status = 0;
+  data->timestamp_ns = 0;
+  memset(data->data, 0, sizeof(data->data));
+  data->in_use = 1;
+  bf_fpga_i2c_mon_end_update(data);
+  mutex_unlock(&bf_mon.lock);
+  return 0;
+}
+
+int bf_fpga_i2c_mon_del(bf_fpga_i2c_mon_t *mon) {
+  bf_fpga_i2c_mon_data_t *data;
+  bf_fpga_i2c_t i2c_op;
+  int ret;
+
+  if (!bf_mon.table || mon->entry < 0 ||
+      mon->entry >= BF_FPGA_I2C_MON_MAX_ENTRY) {
+    return -EINVAL;
+  }
+  mutex_lock(&bf_mon.lock);
+  data = &bf_mon.table->entry[mon->entry];
+  if (!data->in_use) {
+    mutex_unlock(&bf_mon.lock);
+    return -ENOENT;
+  }
+  memset(&i2c_op, 0, sizeof(i2c_op));
+  i2c_op.num_i2c = 1;
+  i2c_op.inst_hndl.bus_id = data->bus_id;
+  i2c_op.inst_hndl.inst_id = bf_mon.inst_id[mon->entry];
+  ret = fpga_i2c_del(&i2c_op);
+  if (ret == 0) {
+    bf_fpga_i2c_mon_begin_update(data);
+    data->in_use = 0;
+    bf_fpga_i2c_mon_end_update(data);
+  }
+  mutex_unlock(&bf_mon.lock);
+  return ret;
+}
+
+int bf_fpga_i2c_mon_set_interval(int interval_ms) {
+  if (!bf_mon.table || interval_ms < 0) {
+    return -EINVAL;
+  }
+  mutex_lock(&bf_mon.ctl_lock);
+  WRITE_ONCE(bf_mon.table->interval_ms, interval_ms);
+  cancel_delayed_work_sync(&bf_mon.work);
+  if (interval_ms) {
+    schedule_delayed_work(&bf_mon.work, 0);
+  }
+  mutex_unlock(&bf_mon.ctl_lock);
+  return 0;
+}
+
+/* map the table read-only, it is updated by the refresh work only */
+int bf_fpga_i2c_mon_mmap(struct vm_area_struct *vma) {
+  if (!bf_mon.table) {
+    return -ENODEV;
+  }
+  if (vma->vm_flags & VM_WRITE) {
+    return -EPERM;
+  }
+  if (vma->vm_end - vma->vm_start >
+      PAGE_ALIGN(sizeof(bf_fpga_i2c_mon_table_t))) {
+    return -EINVAL;
+  }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+  vm_flags_clear(vma, VM_MAYWRITE);
+#else
+  vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+  return remap_vmalloc_range(vma, bf_mon.table, 0);
+}
@@ -84,6 +84,7 @@ int bf_fpga_ioctl(struct bf_pci_dev *bfdev,
         case BF_FPGA_I2C_INST_STOP_ON_ERR:
           break;
         case BF_FPGA_I2C_INST_INT_EN:
+          ret = fpga_i2c_int_en(i2c_ctl.inst_hndl.bus_id, true);
           break;
         default:
           break;
@@ -189,6 +190,63 @@ int bf_fpga_ioctl(struct bf_pci_dev *bfdev,
       }
       break;
     }
+    case BF_FPGA_IOCTL_I2C_ASYNC_SUBMIT:
+    case BF_FPGA_IOCTL_I2C_ASYNC_REAP: {
+      bf_fpga_i2c_async_t async;
+
+      if (copy_from_user(&async, addr, sizeof(bf_fpga_i2c_async_t))) {
+        return -EFAULT;
+      }
+      if (cmd == BF_FPGA_IOCTL_I2C_ASYNC_SUBMIT) {
+        ret = bf_fpga_i2c_async_submit(&async);
+      } else {
+        ret = bf_fpga_i2c_async_reap(&async);
+      }
+      /* report the partial progress even on error */
+      if (copy_to_user(&((bf_fpga_i2c_async_t *)addr)->num_done,
+                       &async.num_done,
+                       sizeof(async.num_done))) {
+        return -EFAULT;
+      }
+      break;
+    }
+    case BF_FPGA_IOCTL_I2C_ASYNC_EVENTFD: {
+      int fd;
+
+      if (copy_from_user(&fd, addr, sizeof(int))) {
+        return -EFAULT;
+      }
+      ret = bf_fpga_i2c_async_set_eventfd(fd);
+      break;
+    }
+    case BF_FPGA_IOCTL_I2C_MON_ADD:
+    case BF_FPGA_IOCTL_I2C_MON_DEL: {
+      bf_fpga_i2c_mon_t mon;
+
+      if (copy_from_user(&mon, addr, sizeof(bf_fpga_i2c_mon_t))) {
+        return -EFAULT;
+      }
+      if (cmd == BF_FPGA_IOCTL_I2C_MON_ADD) {
+        ret = bf_fpga_i2c_mon_add(&mon);
+      } else {
+        ret = bf_fpga_i2c_mon_del(&mon);
+      }
+      if (ret != 0) {
+        printk(KERN_ERR "fpga i2c ioctl monitor error %d on entry %d\n",
+               ret,
+               mon.entry);
+      }
+      break;
+    }
+    case BF_FPGA_IOCTL_I2C_MON_INTERVAL: {
+      int interval_ms;
+
+      if (copy_from_user(&interval_ms, addr, sizeof(int))) {
+        return -EFAULT;
+      }
+      ret = bf_fpga_i2c_mon_set_interval(interval_ms);
+      break;
+    }
     default:
       return -EINVAL;
   }
@@ -67,6 +67,13 @@
   (FPGA_I2C_ONESHOT_NUM_INST + FPGA_I2C_PERIODIC_NUM_INST)
 /* maximum i2c instructions that can be handled in one system call */
 #define BF_FPGA_I2C_MAX_NUM_INST 3
+/* maximum asynchronous operations submitted and not yet reaped */
+#define BF_FPGA_I2C_ASYNC_MAX_OPS 256
+/* periodic i2c monitor: number of entries and read bytes per entry */
+#define BF_FPGA_I2C_MON_MAX_ENTRY 64
+#define BF_FPGA_I2C_MON_MAX_DATA 64
+/* mmap() page offset of the read-only monitor table, after the BAR maps */
+#define BF_FPGA_I2C_MON_MMAP_PGOFF 6
 
 typedef struct bf_fpga_i2c_set_clk_s {
   /* 0:100k, 1:400k, 2:1M, or: 125e6/<desired freq>/3 */
@@ -119,6 +126,49 @@ typedef struct bf_fpga_i2c_ctl_s {
   bool is_busy;
 } bf_fpga_i2c_ctl_t;
 
+/* one asynchronous one-time i2c operation and, once reaped, its result */
+typedef struct bf_fpga_i2c_async_op_s {
+  unsigned long long cookie; /* opaque user tag returned with the result */
+  int ret;                   /* result of the operation, 0 on success */
+  bf_fpga_i2c_t i2c_op;      /* one-time i2c operation(s) on one bus */
+} bf_fpga_i2c_async_op_t;
+
+/* operations on different buses run in parallel, on the same bus in order */
+typedef struct bf_fpga_i2c_async_s {
+  unsigned long long ops; /* user address of bf_fpga_i2c_async_op_t array */
+  int num_ops;            /* number of entries in the array */
+  int num_done;           /* out: number of entries submitted or reaped */
+} bf_fpga_i2c_async_t;
+
+/* a register range read by the fpga with a periodic instruction */
+typedef struct bf_fpga_i2c_mon_s {
+  int entry;              /* index in the monitor table */
+  unsigned char bus_id;   /* controller index */
+  unsigned char i2c_addr; /* i2c device address in 7 bit format */
+  unsigned char offset;   /* register offset in the device */
+  unsigned char rd_cnt;   /* bytes to read, up to BF_FPGA_I2C_MON_MAX_DATA */
+} bf_fpga_i2c_mon_t;
+
+/* one monitor table entry; a reader retries while seq is odd or changes */
+typedef struct bf_fpga_i2c_mon_data_s {
+  unsigned int seq;
+  unsigned char in_use;
+  unsigned char status; /* h/w status of the last periodic execution */
+  unsigned char bus_id;
+  unsigned char i2c_addr;
+  unsigned char offset;
+  unsigned char rd_cnt;
+  unsigned char pad[2];
+  unsigned long long timestamp_ns; /* CLOCK_MONOTONIC time of the update */
+  unsigned char data[BF_FPGA_I2C_MON_MAX_DATA];
+} bf_fpga_i2c_mon_data_t;
+
+typedef struct bf_fpga_i2c_mon_table_s {
+  unsigned int interval_ms; /* refresh interval, 0 when stopped */
+  unsigned int num_entry;
+  bf_fpga_i2c_mon_data_t entry[BF_FPGA_I2C_MON_MAX_ENTRY];
+} bf_fpga_i2c_mon_table_t;
+
 #define BF_FPGA_IOCTL_I2C_CTL _IOWR(BF_FPGA_IOC_MAGIC, 0, bf_fpga_i2c_ctl_t)
 #define BF_FPGA_IOCTL_I2C_ONETIME _IOWR(BF_FPGA_IOC_MAGIC, 1, bf_fpga_i2c_t)
 #define BF_FPGA_IOCTL_I2C_ADD_PR _IOWR(BF_FPGA_IOC_MAGIC, 2, bf_fpga_i2c_t)
@@ -127,5 +177,15 @@ typedef struct bf_fpga_i2c_ctl_s {
   _IOWR(BF_FPGA_IOC_MAGIC, 4, bf_fpga_i2c_rd_data_t)
 #define BF_FPGA_IOCTL_I2C_SET_CLK \
   _IOW(BF_FPGA_IOC_MAGIC, 5, bf_fpga_i2c_set_clk_t)
+#define BF_FPGA_IOCTL_I2C_ASYNC_SUBMIT \
+  _IOWR(BF_FPGA_IOC_MAGIC, 6, bf_fpga_i2c_async_t)
+#define BF_FPGA_IOCTL_I2C_ASYNC_REAP \
+  _IOWR(BF_FPGA_IOC_MAGIC, 7, bf_fpga_i2c_async_t)
+/* eventfd signaled on each async completion, -1 to detach */
+#define BF_FPGA_IOCTL_I2C_ASYNC_EVENTFD _IOW(BF_FPGA_IOC_MAGIC, 8, int)
+#define BF_FPGA_IOCTL_I2C_MON_ADD _IOW(BF_FPGA_IOC_MAGIC, 9, bf_fpga_i2c_mon_t)
+#define BF_FPGA_IOCTL_I2C_MON_DEL _IOW(BF_FPGA_IOC_MAGIC, 10, bf_fpga_i2c_mon_t)
+/* table refresh interval in milliseconds, 0 stops the refresh */
+#define BF_FPGA_IOCTL_I2C_MON_INTERVAL _IOW(BF_FPGA_IOC_MAGIC, 11, int)
 
 #endif /* _BF_FPGA_IOCTL_H_ */
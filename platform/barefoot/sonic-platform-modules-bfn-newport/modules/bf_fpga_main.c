@@ -322,6 +322,8 @@ static irqreturn_t bf_interrupt(int irq, void *bfdev_id) {
 
   if (ret == IRQ_HANDLED) {
     atomic_inc(&(bfdev->info.event[vect_off]));
+    /* wake up the i2c operations waiting for completion */
+    fpga_i2c_intr();
   }
   return ret;
 }
@@ -416,6 +418,9 @@ static int bf_mmap(struct file *filep, struct vm_area_struct *vma) {
 
   vma->vm_private_data = bfdev;
 
+  if (vma->vm_pgoff == BF_FPGA_I2C_MON_MMAP_PGOFF) {
+    return bf_fpga_i2c_mon_mmap(vma);
+  }
   bar = bf_find_mem_index(vma);
   if (bar < 0) {
     return -EINVAL;
@@ -1075,9 +1080,17 @@ static int bf_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id) {
     printk(KERN_ERR "bf_fpga i2c initialization failed\n");
     goto fail_register_device;
   }
+  if (bf_fpga_i2c_async_init()) {
+    printk(KERN_ERR "bf_fpga i2c async initialization failed\n");
+    goto fail_i2c_init;
+  }
+  if (bf_fpga_i2c_mon_init()) {
+    printk(KERN_ERR "bf_fpga i2c monitor initialization failed\n");
+    goto fail_i2c_async_init;
+  }
   if (bf_fpga_sysfs_add(bfdev)) {
     printk(KERN_ERR "bf_fpga stsfs initialization failed\n");
-    goto fail_i2c_init;
+    goto fail_i2c_mon_init;
   }
   build_ver =
       *((u32 *)(bfdev->info.mem[0].internal_addr) + (BF_FPGA_VER_REG / 4));
@@ -1089,8 +1102,15 @@ static int bf_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id) {
          (u16)(build_ver));
   return 0;
 
+fail_i2c_mon_init:
+  bf_fpga_i2c_mon_deinit();
+fail_i2c_async_init:
+  bf_fpga_i2c_async_deinit();
 fail_i2c_init:
+  /* free the irqs before the i2c resources used by the ISR */
+  bf_unregister_device(bfdev);
   fpga_i2c_deinit();
+  goto fail_release_irq;
 fail_register_device:
   bf_unregister_device(bfdev);
 fail_release_irq:
@@ -1122,8 +1142,12 @@ static void bf_pci_remove(struct pci_dev *pdev) {
 
   bf_fpga_disable_int_dma(bfdev);
   bf_fpga_sysfs_del(bfdev);
-  fpga_i2c_deinit();
+  /* stop the i2c users before the i2c resources go away */
+  bf_fpga_i2c_mon_deinit();
+  bf_fpga_i2c_async_deinit();
+  /* free the irqs before the i2c resources used by the ISR */
   bf_unregister_device(bfdev);
+  fpga_i2c_deinit();
   if (bfdev->mode == BF_INTR_MODE_MSIX) {
     pci_disable_msix(pdev);
     kfree(bfdev->info.msix_entries);
@@ -101,10 +101,14 @@ struct bf_int_vector {
 /* sysfs related structs */
 #define BF_FPGA_SYSFS_CNT 64
 #define BF_FPGA_SYSFS_NAME_SIZE 32
+/* offset addressable size of the <name>_eeprom binary file (8 bit offset) */
+#define BF_FPGA_SYSFS_BIN_SIZE 256
 
 struct bf_fpga_sysfs_buff {
   struct device_attribute dev_attr;
   char name[BF_FPGA_SYSFS_NAME_SIZE];
+  struct bin_attribute bin_attr; /* random access reads at an offset */
+  char bin_name[BF_FPGA_SYSFS_NAME_SIZE + 8];
   int bus_id;
   unsigned char i2c_addr;
   size_t i2c_rd_size;         /* bytes to read from the device */
@@ -135,6 +139,17 @@ struct bf_pci_dev {
 int bf_fpga_ioctl(struct bf_pci_dev *bfdev,
                   unsigned int cmd,
                   unsigned long arg);
+int bf_fpga_i2c_async_init(void);
+void bf_fpga_i2c_async_deinit(void);
+int bf_fpga_i2c_async_submit(struct bf_fpga_i2c_async_s *async);
+int bf_fpga_i2c_async_reap(struct bf_fpga_i2c_async_s *async);
+int bf_fpga_i2c_async_set_eventfd(int fd);
+int bf_fpga_i2c_mon_init(void);
+void bf_fpga_i2c_mon_deinit(void);
+int bf_fpga_i2c_mon_add(struct bf_fpga_i2c_mon_s *mon);
+int bf_fpga_i2c_mon_del(struct bf_fpga_i2c_mon_s *mon);
+int bf_fpga_i2c_mon_set_interval(int interval_ms);
+int bf_fpga_i2c_mon_mmap(struct vm_area_struct *vma);
 int bf_fpga_sysfs_add(struct bf_pci_dev *fpgadev);
 void bf_fpga_sysfs_del(struct bf_pci_dev *fpgadev);
 
@@ -32,12 +32,79 @@
 #include "bf_fpga_ioctl.h"
 #include "i2c/bf_fpga_i2c.h"
 
-/* reads 1 byte from the i2c device */
+/* bytes read by one i2c instruction, the size of its FPGA data area */
+#define BF_FPGA_SYSFS_RD_CHUNK BF_FPGA_MAX_I2C_RD_DATA
+
+/* reads count bytes from the i2c device into buf. As many instructions
+ * as a oneshot can carry are chained into each FPGA transaction, every
+ * instruction reading up to BF_FPGA_SYSFS_RD_CHUNK bytes. If addr_read is
+ * set, each instruction first writes its 1 byte register offset, starting
+ * at off, so the data does not depend on the device's current pointer.
+ */
+static ssize_t bf_fpga_sysfs_i2c_read(struct bf_fpga_sysfs_buff *sysfs_buf,
+                                      bool addr_read,
+                                      loff_t off,
+                                      char *buf,
+                                      size_t count) {
+  bf_fpga_i2c_t i2c_op;
+  size_t size, cur_size;
+  int i;
+
+  i2c_op.one_time = 1;
+  i2c_op.inst_hndl.bus_id = sysfs_buf->bus_id;
+  size = 0;
+  while (size < count) {
+    /* fill up the instructions of this transaction */
+    cur_size = 0;
+    for (i = 0; i < BF_FPGA_I2C_MAX_NUM_INST && size + cur_size < count;
+         i++) {
+      bf_fpga_i2c_inst_t *inst = &i2c_op.i2c_inst[i];
+      size_t cur_cnt = count - size - cur_size;
+
+      if (cur_cnt > BF_FPGA_SYSFS_RD_CHUNK) {
+        cur_cnt = BF_FPGA_SYSFS_RD_CHUNK;
+      }
+      inst->preemt = false;
+      inst->en = true;
+      inst->i2c_addr = sysfs_buf->i2c_addr;
+      inst->delay = 0;
+      inst->rd_cnt = (unsigned char)cur_cnt;
+      if (addr_read) {
+        inst->i2c_type = BF_FPGA_I2C_ADDR_READ;
+        inst->wr_cnt = 1;
+        inst->wr_buf[0] = (unsigned char)(off + size + cur_size);
+      } else {
+        inst->i2c_type = BF_FPGA_I2C_READ;
+        inst->wr_cnt = 0;
+      }
+      cur_size += cur_cnt;
+    }
+    i2c_op.num_i2c = i;
+    if (fpga_i2c_oneshot(&i2c_op)) {
+      for (i = 0; i < i2c_op.num_i2c; i++) {
+        printk(KERN_ERR
+               "fpga-i2c read one-shot error bus %d addr 0x%hhx inst %d "
+               "status 0x%hhx\n",
+               i2c_op.inst_hndl.bus_id,
+               i2c_op.i2c_inst[i].i2c_addr,
+               i,
+               i2c_op.i2c_inst[i].status);
+      }
+      return -EIO;
+    }
+    for (i = 0; i < i2c_op.num_i2c; i++) {
+      memcpy(buf + size, i2c_op.i2c_inst[i].rd_buf, i2c_op.i2c_inst[i].rd_cnt);
+      size += i2c_op.i2c_inst[i].rd_cnt;
+    }
+  }
+  return size;
+}
+
+/* reads i2c_rd_size bytes from the device's current pointer */
 static ssize_t bf_fpga_sysfs_i2c_get(struct device *dev,
                                      struct device_attribute *attr,
                                      char *buf) {
-  bf_fpga_i2c_t i2c_op;
-  ssize_t size, cur_size;
+  size_t cur_size;
   struct bf_fpga_sysfs_buff *sysfs_buf =
       container_of(attr, struct bf_fpga_sysfs_buff, dev_attr);
 
@@ -45,43 +112,31 @@ static ssize_t bf_fpga_sysfs_i2c_get(struct device *dev,
     printk(KERN_ERR "fpga-i2c bad attr pointer in sysfs_read\n");
     return -ENXIO; /* something not quite right here; but, don't panic */
   }
-  i2c_op.num_i2c = 1;
-  i2c_op.one_time = 1;
-  i2c_op.inst_hndl.bus_id = sysfs_buf->bus_id;
-  i2c_op.i2c_inst[0].preemt = false;
-  i2c_op.i2c_inst[0].en = true;
-  i2c_op.i2c_inst[0].i2c_addr = sysfs_buf->i2c_addr;
-  i2c_op.i2c_inst[0].i2c_type = BF_FPGA_I2C_READ;
-  i2c_op.i2c_inst[0].delay = 0;
-  i2c_op.i2c_inst[0].wr_cnt = 0;
   cur_size = sysfs_buf->i2c_rd_size;
   /* limit to PAGE_SIZE per the sysfs contract */
   if (cur_size >= PAGE_SIZE) {
     cur_size = PAGE_SIZE;
   }
-  size = 0;
-  while (cur_size > 0) {
-    unsigned char cur_cnt;
-    if (cur_size > 64) {
-      cur_cnt = 64;
-    } else {
-      cur_cnt = (unsigned char)cur_size;
-    }
-    i2c_op.i2c_inst[0].rd_cnt = cur_cnt;
-    if (fpga_i2c_oneshot(&i2c_op)) {
-      printk(KERN_ERR
-             "fpga-i2c read one-shot error bus %d addr 0x%hhx status 0x%hhx\n",
-             i2c_op.inst_hndl.bus_id,
-             i2c_op.i2c_inst[0].i2c_addr,
-             i2c_op.i2c_inst[0].status);
-      return -EIO;
-    }
-    memcpy(buf, i2c_op.i2c_inst[0].rd_buf, cur_cnt);
-    buf += cur_cnt;
-    size += cur_cnt;
-    cur_size -= cur_cnt;
+  return bf_fpga_sysfs_i2c_read(sysfs_buf, false, 0, buf, cur_size);
+}
+
+/* reads count bytes from register offset off of the i2c device */
+static ssize_t bf_fpga_sysfs_i2c_bin_read(struct file *filp,
+                                          struct kobject *kobj,
+                                          struct bin_attribute *attr,
+                                          char *buf,
+                                          loff_t off,
+                                          size_t count) {
+  struct bf_fpga_sysfs_buff *sysfs_buf =
+      container_of(attr, struct bf_fpga_sysfs_buff, bin_attr);
+
+  (void)filp;
+  (void)kobj;
+  /* sysfs clamps off + count to the attribute size */
+  if (count == 0) {
+    return 0;
   }
-  return size;
+  return bf_fpga_sysfs_i2c_read(sysfs_buf, true, off, buf, count);
 }
 
 /* write the number of bytes supplied to the i2c device, 1st byte has to be
@@ -220,6 +275,23 @@ static ssize_t bf_fpga_sysfs_fixed_set(struct device *dev,
       snprintf(new_buf->name, BF_FPGA_SYSFS_NAME_SIZE, "%s", fname);
       new_buf->dev_attr.attr.name = new_buf->name;
       ret = device_create_file(&(fpgadev->pdev->dev), &new_buf->dev_attr);
+      if (ret) {
+        break;
+      }
+      /* binary file for random access reads, "<name>_eeprom" */
+      sysfs_bin_attr_init(&new_buf->bin_attr);
+      snprintf(new_buf->bin_name,
+               sizeof(new_buf->bin_name),
+               "%s_eeprom",
+               new_buf->name);
+      new_buf->bin_attr.attr.name = new_buf->bin_name;
+      new_buf->bin_attr.attr.mode = S_IRUGO;
+      new_buf->bin_attr.size = BF_FPGA_SYSFS_BIN_SIZE;
+      new_buf->bin_attr.read = bf_fpga_sysfs_i2c_bin_read;
+      ret = device_create_bin_file(&(fpgadev->pdev->dev), &new_buf->bin_attr);
+      if (ret) {
+        device_remove_file(&fpgadev->pdev->dev, &new_buf->dev_attr);
+      }
       break;
 
     case BF_SYSFS_RM_DEVICE: /* remove device request */
@@ -246,6 +318,7 @@ static ssize_t bf_fpga_sysfs_fixed_set(struct device *dev,
       new_buf->bus_id = -1;
       fpgadev->fpga_sysfs_buff[i].in_use = false;
       spin_unlock(&fpgadev->sysfs_slock);
+      device_remove_bin_file(&fpgadev->pdev->dev, &new_buf->bin_attr);
       device_remove_file(&fpgadev->pdev->dev, &new_buf->dev_attr);
       new_buf->name[0] = 0; /* nullify the name */
       ret = 0;
@@ -328,6 +401,8 @@ void bf_fpga_sysfs_del(struct bf_pci_dev *fpgadev) {
   device_remove_file(&fpgadev->pdev->dev, &fpgadev->fpga_sysfs_st_i2c.dev_attr);
   for (i = 0; i < BF_FPGA_SYSFS_CNT; i++) {
     if (fpgadev->fpga_sysfs_buff[i].in_use) {
+      device_remove_bin_file(&fpgadev->pdev->dev,
+                             &fpgadev->fpga_sysfs_buff[i].bin_attr);
       device_remove_file(&fpgadev->pdev->dev,
                          &fpgadev->fpga_sysfs_buff[i].dev_attr);
     }
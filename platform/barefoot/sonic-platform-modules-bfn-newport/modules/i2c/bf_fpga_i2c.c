@@ -236,6 +236,49 @@ static uint32_t fpga_i2c_get_status(int bus_id, int inst_id) {
   return (bf_fpga_i2c_reg_read32(i2c_ctrl, addr) & I2C_STATUS_MASK);
 }
 
+/* wait for the completion of an instruction, <cnt> is the worst case number
+ * of 50 microsec polling intervals. The fpga interrupt wakes up the waiter
+ * early. Without interrupt, the first wait covers the expected duration of
+ * the <bytes> long i2c cycle and the completion is polled thereafter.
+ */
+static uint32_t fpga_i2c_wait_complete(fpga_i2c_controller_t *i2c_ctrl,
+                                       int bus_id,
+                                       int inst_id,
+                                       int bytes,
+                                       int cnt) {
+  uint64_t now, deadline;
+  unsigned long wait_us;
+  uint32_t val;
+  int seq;
+
+  if (cnt <= 0) {
+    return 0;
+  }
+  deadline = bf_fpga_time_us() + (uint64_t)cnt * 50;
+  /* 1 byte ~= 10 bits takes 25 microsec on i2c cycle at 400khz */
+  wait_us = i2c_ctrl->int_en ? (unsigned long)cnt * 50 : bytes * 25;
+  if (wait_us < 50) {
+    wait_us = 50;
+  }
+  while (1) {
+    /* read the event sequence before the status not to miss an interrupt */
+    seq = bf_fpga_event_seq(&i2c_ctrl->i2c_event);
+    val = fpga_i2c_get_status(bus_id, inst_id);
+    now = bf_fpga_time_us();
+    if ((val & I2C_STATUS_COMPLETED) || now >= deadline) {
+      break;
+    }
+    if (wait_us > (deadline - now)) {
+      wait_us = deadline - now;
+    }
+    bf_fpga_event_wait(&i2c_ctrl->i2c_event, seq, wait_us);
+    if (!i2c_ctrl->int_en) {
+      wait_us = 50;
+    }
+  }
+  return val;
+}
+
 /** FPGA I2C data read (assumes locked by caller and no need to stop i2c)
  *
  * read the data following a read type i2c operation
@@ -340,6 +383,28 @@ int fpga_i2c_data_read(
   return ret;
 }
 
+/** FPGA I2C instruction status
+ *
+ * read the completion status of the last execution of an instruction
+ *
+ *  @param bus_id
+ *    i2c controller id
+ *  @param inst_id
+ *    instruction id within  this controller space
+ *  @param status
+ *    h/w status of the instruction <out>
+ *  @return
+ *    0 on success and <0 on error
+ */
+int fpga_i2c_inst_status(int bus_id, int inst_id, uint8_t *status) {
+  if (!status || !fpga_i2c_ctrl_get(bus_id) || inst_id < 0 ||
+      inst_id >= FPGA_I2C_NUM_INST) {
+    return BF_FPGA_EINVAL;
+  }
+  *status = (uint8_t)fpga_i2c_get_status(bus_id, inst_id);
+  return BF_FPGA_OK;
+}
+
 /** FPGA I2C onetime i2c operation
  *
  *  @param i2c_op
@@ -388,23 +453,19 @@ int fpga_i2c_oneshot(bf_fpga_i2c_t *i2c_op) {
 
   /* wait until complete and read the data if necessary */
   for (i = 0; i < i2c_op->num_i2c; i++) {
-    int cnt;
-    val = 0;
+    int cnt, bytes;
     /* cnt is roughly the number of bytes of this i2c cycle
      * overhead of 100 bytes for for worst case timeout, one
      * should not hit that in normal working case
      */
-    cnt = i2c_op->i2c_inst[i].wr_cnt + i2c_op->i2c_inst[i].rd_cnt;
+    bytes = i2c_op->i2c_inst[i].wr_cnt + i2c_op->i2c_inst[i].rd_cnt;
+    cnt = bytes;
     /* bump up the cnt for an i2c transaction containing  some data
      * for computing worst case timeout */
     if (cnt > 0) {
       cnt = cnt + 100;
     }
-    while (!(val & I2C_STATUS_COMPLETED) && (cnt-- > 0)) {
-      /* 1 byte ~= 10 bits takes 25 microsec on i2c cycle at 400khz */
-      bf_fpga_us_delay(50);
-      val = fpga_i2c_get_status(bus_id, i);
-    }
+    val = fpga_i2c_wait_complete(i2c_ctrl, bus_id, i, bytes, cnt);
     i2c_op->i2c_inst[i].status = val; /* store the h/w status */
     if (val & I2C_STATUS_ERR_MASK) {
       ret = BF_FPGA_EIO;
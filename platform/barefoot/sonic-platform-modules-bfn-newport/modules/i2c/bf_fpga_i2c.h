@@ -37,6 +37,8 @@ int fpga_i2c_reset(int bus_id);
 int fpga_i2c_is_busy(int bus_id, bool *is_busy);
 int fpga_i2c_inst_en(int bus_id, int inst_id, bool en);
 int fpga_i2c_set_clk(int bus_id, int clock_div);
+int fpga_i2c_int_en(int bus_id, bool en);
+void fpga_i2c_intr(void);
 int fpga_i2c_controller_init(int bus_id);
 int fpga_i2c_controller_cleanup(int bus_id);
 int fpga_i2c_init(uint8_t *base_addr);
@@ -46,6 +48,7 @@ int fpga_i2c_pr_add(bf_fpga_i2c_t *i2c_op);
 int fpga_i2c_del(bf_fpga_i2c_t *i2c_op);
 int fpga_i2c_data_read(
     int bus_id, int inst_id, uint8_t offset, uint8_t len, uint8_t *buf);
+int fpga_i2c_inst_status(int bus_id, int inst_id, uint8_t *status);
 bool fpga_i2c_is_inited(void);
 
 #ifdef __cplusplus
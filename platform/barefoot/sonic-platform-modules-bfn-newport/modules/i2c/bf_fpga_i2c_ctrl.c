@@ -314,6 +314,48 @@ int fpga_i2c_inst_en(int bus_id, int inst_id, bool en) {
   return BF_FPGA_OK;
 }
 
+/** FPGA I2C  interrupt driven completion enable/disable
+ *
+ *  with interrupt enabled, one time i2c operations sleep until the fpga
+ *  interrupt instead of polling for completion every 50 microsec
+ *  @param bus_id
+ *    i2c controller id
+ *  @param en
+ *    true for enable, false for disable
+ *  @return
+ *    0 on success and <0 on error
+ */
+int fpga_i2c_int_en(int bus_id, bool en) {
+  fpga_i2c_controller_t *i2c_ctrl;
+
+  if (bus_id >= BF_I2C_FPGA_NUM_CTRL || !fpga_i2c_is_inited()) {
+    return BF_FPGA_EINVAL;
+  }
+  i2c_ctrl = fpga_i2c_ctrl_get(bus_id);
+  if (bf_fpga_i2c_lock(i2c_ctrl)) {
+    return BF_FPGA_EAGAIN;
+  }
+  i2c_ctrl->int_en = en;
+  bf_fpga_i2c_unlock(i2c_ctrl);
+  return BF_FPGA_OK;
+}
+
+/** FPGA I2C interrupt handler
+ *
+ *  wake up the waiters of all the controllers, the fpga has a single
+ *  interrupt and each waiter checks the status of its own instruction
+ */
+void fpga_i2c_intr(void) {
+  int i;
+
+  if (!fpga_i2c_is_inited()) {
+    return;
+  }
+  for (i = 0; i < BF_I2C_FPGA_NUM_CTRL; i++) {
+    bf_fpga_event_signal(&fpga_i2c_ctrl[i].i2c_event);
+  }
+}
+
 /** FPGA I2C controller initialization
  *
  *  @param bus_id
@@ -334,6 +376,7 @@ int fpga_i2c_controller_init(int bus_id) {
   }
   bf_fpga_fast_lock_init(&i2c_ctrl->spinlock, 0);
   bf_fpga_cr_init(&i2c_ctrl->fpga_ctrl_lock);
+  bf_fpga_event_init(&i2c_ctrl->i2c_event);
   bf_fpga_cr_enter(&i2c_ctrl->fpga_ctrl_lock);
   for (i = 0; i < FPGA_I2C_NUM_INST; i++) {
     fpga_i2c_ctrl[bus_id].i2c_inst[i].inst = (uint32_t)i;
@@ -361,6 +404,7 @@ int fpga_i2c_controller_cleanup(int bus_id) {
   }
   bf_fpga_cr_destroy(&fpga_i2c_ctrl[bus_id].fpga_ctrl_lock);
   bf_fpga_fast_lock_destroy(&fpga_i2c_ctrl[bus_id].spinlock);
+  bf_fpga_event_destroy(&fpga_i2c_ctrl[bus_id].i2c_event);
   return BF_FPGA_OK;
 }
 
@@ -28,6 +28,7 @@
 #include <linux/vmalloc.h>
 #include <linux/mutex.h>
 #include <linux/bitops.h>
+#include <linux/wait.h>
 #include "bf_fpga_i2c_priv_porting.h"
 #include <bf_fpga_ioctl.h>
 #include "bf_fpga_i2c.h"
@@ -148,3 +149,71 @@ void bf_fpga_fast_unlock(bf_fpga_fast_lock_t *sl) {
     spin_unlock(*sl);
   }
 }
+
+/* event is a wait queue with a sequence number bumped by every signal */
+typedef struct {
+  wait_queue_head_t wq;
+  atomic_t seq;
+} fpga_event_t;
+
+int bf_fpga_event_init(bf_fpga_event_t *ev) {
+  fpga_event_t *event;
+
+  if (!ev) {
+    return -1;
+  }
+  event = vzalloc(sizeof(fpga_event_t));
+
+  if (event) {
+    init_waitqueue_head(&event->wq);
+    atomic_set(&event->seq, 0);
+    *ev = (bf_fpga_event_t *)event;
+    return 0;
+  } else {
+    *ev = NULL;
+    return -1;
+  }
+}
+
+void bf_fpga_event_destroy(bf_fpga_event_t *ev) {
+  if (ev && *ev) {
+    vfree(*ev);
+    *ev = NULL;
+  }
+}
+
+int bf_fpga_event_seq(bf_fpga_event_t *ev) {
+  if (ev && *ev) {
+    return atomic_read(&((fpga_event_t *)*ev)->seq);
+  } else {
+    return 0;
+  }
+}
+
+/* sleep until the event is signaled after <seq> was read or <usecs> */
+void bf_fpga_event_wait(bf_fpga_event_t *ev, int seq, unsigned long usecs) {
+  fpga_event_t *event;
+
+  if (ev && *ev) {
+    event = (fpga_event_t *)*ev;
+    wait_event_hrtimeout(event->wq,
+                         atomic_read(&event->seq) != seq,
+                         ns_to_ktime((u64)usecs * NSEC_PER_USEC));
+  } else {
+    bf_fpga_us_delay(usecs);
+  }
+}
+
+/* may be called from interrupt context */
+void bf_fpga_event_signal(bf_fpga_event_t *ev) {
+  fpga_event_t *event;
+
+  if (ev && *ev) {
+    event = (fpga_event_t *)*ev;
+    atomic_inc(&event->seq);
+    smp_mb__after_atomic();
+    if (waitqueue_active(&event->wq)) {
+      wake_up(&event->wq);
+    }
+  }
+}
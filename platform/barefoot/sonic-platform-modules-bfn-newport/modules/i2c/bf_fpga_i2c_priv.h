@@ -66,6 +66,7 @@ typedef struct i2c_inst_s {
 typedef struct fpga_i2c_controller_s {
   bf_fpga_mutex_t fpga_ctrl_lock;
   bf_fpga_fast_lock_t spinlock;
+  bf_fpga_event_t i2c_event; /* signaled by the fpga interrupt */
   uint8_t *fpga_base_addr; /* virtual address of start of fpga memory */
   uint8_t *i2c_base_addr;  /* virtual address of i2c controller memory */
   uint32_t start;          /* offset of start of i2c instruction memory */
@@ -34,6 +34,7 @@ extern "C" {
 #include <linux/errno.h>
 #include <linux/pci.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 
 /* This file contains OS and system specific porting functions declarations.
  */
@@ -69,6 +70,11 @@ static inline void bf_fpga_us_delay(unsigned long usecs) {
   usleep_range(usecs, usecs + 10);
 }
 
+/* monotonic time in microseconds */
+static inline uint64_t bf_fpga_time_us(void) {
+  return ktime_to_us(ktime_get());
+}
+
 /* general purpose mutual exclusion lock */
 typedef void *bf_fpga_mutex_t;
 
@@ -86,6 +92,18 @@ void bf_fpga_fast_lock_destroy(bf_fpga_fast_lock_t *sl);
 int bf_fpga_fast_lock(bf_fpga_fast_lock_t *sl);
 void bf_fpga_fast_unlock(bf_fpga_fast_lock_t *sl);
 
+/* event to sleep on until it is signaled (from interrupt) or a timeout */
+typedef void *bf_fpga_event_t;
+
+/* APIs to init/signal/wait for an event. The waiter reads the current
+ * sequence, checks its condition and then waits for the sequence to change
+ */
+int bf_fpga_event_init(bf_fpga_event_t *ev);
+void bf_fpga_event_destroy(bf_fpga_event_t *ev);
+int bf_fpga_event_seq(bf_fpga_event_t *ev);
+void bf_fpga_event_wait(bf_fpga_event_t *ev, int seq, unsigned long usecs);
+void bf_fpga_event_signal(bf_fpga_event_t *ev);
+
 #ifdef __cplusplus
 }
 #endif /* C++ */
@@ -51,14 +51,21 @@
 #define KCOM_M_NETIF_DESTROY    12 /* Destroy network interface */
 #define KCOM_M_NETIF_LIST       13 /* Get list of network interface IDs */
 #define KCOM_M_NETIF_GET        14 /* Get network interface info */
+#define KCOM_M_NETIF_CREATE_BULK 15 /* Create multiple network interfaces */
+#define KCOM_M_NETIF_GET_BULK   16 /* Get multiple network interface infos */
 #define KCOM_M_FILTER_CREATE    21 /* Create Rx filter */
 #define KCOM_M_FILTER_DESTROY   22 /* Destroy Rx filter */
 #define KCOM_M_FILTER_LIST      23 /* Get list of Rx filter IDs */
 #define KCOM_M_FILTER_GET       24 /* Get Rx filter info */
+#define KCOM_M_FILTER_CREATE_BULK 25 /* Create multiple Rx filters */
+#define KCOM_M_FILTER_DESTROY_BULK 26 /* Destroy multiple Rx filters */
+#define KCOM_M_FILTER_GET_BULK  27 /* Get multiple Rx filter infos */
 #define KCOM_M_DMA_INFO         31 /* Tx/Rx DMA info */
+#define KCOM_M_DMA_RING         32 /* Set up shared Rx completion ring */
 #define KCOM_M_DBGPKT_SET       41 /* Enbale debug packet function */
 #define KCOM_M_DBGPKT_GET       42 /* Get debug packet function info */
 #define KCOM_M_WB_CLEANUP       51 /* Clean up for warmbooting */
+#define KCOM_M_WB_REATTACH      52 /* Keep netifs/filters across SDK restart */
 
 #define KCOM_VERSION            10 /* Protocol version */
 
@@ -294,6 +301,49 @@ typedef struct kcom_dma_info_s {
     } cookie;
   } kcom_dma_info_t;
 
+/*
+ * Shared Rx completion ring
+ *
+ * When enabled with KCOM_M_DMA_RING, the kernel module publishes one
+ * entry for each completed Rx API DCB in a ring which the application
+ * maps with mmap() on the KNET device at page offset <unit>. The ring
+ * header is followed by a power of two number of entries, the number
+ * is given in the size field.
+ *
+ * The kernel module writes the entries and then prod, the application
+ * reads entries up to prod and then writes cons. Both are free running
+ * counters, the entry index is the counter modulo size. A zero len
+ * means that the packet was not passed to the API and the DCB can be
+ * recycled.
+ *
+ * The application is notified only when the ring goes from empty to
+ * non-empty. Before waiting, the application must write cons, issue a
+ * full memory barrier and check prod again. The notification is a
+ * write to the eventfd passed in KCOM_M_DMA_RING or, if none, a
+ * KCOM_DMA_INFO_F_RX_DONE DMA event.
+ *
+ * If the ring is full the DCB is not published, overflows is
+ * incremented and a KCOM_DMA_INFO_F_RX_DONE DMA event is raised so that
+ * the application scans its DCB chains for done DCBs.
+ */
+#define KCOM_DMA_RING_HDR_SIZE  128
+
+typedef struct kcom_dma_ring_hdr_s {
+    uint32 prod;
+    uint32 size;
+    uint32 overflows;
+    uint8 reserved1[52];
+    uint32 cons;
+    uint8 reserved2[60];
+} kcom_dma_ring_hdr_t;
+
+typedef struct kcom_dma_ring_entry_s {
+    uint64 dcb_start;
+    uint16 dcb_idx;
+    uint16 chan;
+    uint32 len;
+} kcom_dma_ring_entry_t;
+
 /* Default channel configuration */
 #define KCOM_DMA_TX_CHAN        0
 #define KCOM_DMA_RX_CHAN        1
@@ -428,6 +478,31 @@ typedef struct kcom_msg_wb_cleanup_s {
     uint32 flags;
 } kcom_msg_wb_cleanup_t;
 
+/*
+ * Keep the netifs and filters of a unit across an SDK restart.
+ *
+ * With KCOM_WB_REATTACH_F_RETAIN, sent by the SDK before it exits, the
+ * DMA is stopped but the netifs (with their link state and addresses)
+ * and the filters are kept. Packets sent on the netifs are dropped
+ * until the netifs are reclaimed. The reply holds the generation of
+ * the retained objects, which the SDK saves in its warmboot state.
+ *
+ * The restarted SDK sends KCOM_WB_REATTACH_F_RECLAIM with the saved
+ * generation after KCOM_M_HW_INIT. If the generation matches, the
+ * netifs and filters are kept with their IDs and can be read back with
+ * the list and get messages. Otherwise all netifs and filters of the
+ * unit are destroyed and KCOM_E_NOT_FOUND is returned, such that the
+ * SDK creates them again. A cold started SDK uses generation 0.
+ */
+#define KCOM_WB_REATTACH_F_RETAIN       (1U << 0)
+#define KCOM_WB_REATTACH_F_RECLAIM      (1U << 1)
+
+typedef struct kcom_msg_wb_reattach_s {
+    kcom_msg_hdr_t hdr;
+    uint32 flags;
+    uint32 generation;
+} kcom_msg_wb_reattach_t;
+
 /*
  * Create new system network interface. The network interface will
  * be associated with the specified switch unit number.
@@ -511,6 +586,19 @@ typedef struct kcom_msg_dma_info_s {
     kcom_dma_info_t dma_info;
 } kcom_msg_dma_info_t;
 
+/*
+ * Enable or disable the shared Rx completion ring. Set eventfd to -1
+ * to be notified through the DMA event queue. The number of ring
+ * entries is set by the kernel module.
+ */
+#define KCOM_DMA_RING_F_ENABLE  (1U << 0)
+
+typedef struct kcom_msg_dma_ring_s {
+    kcom_msg_hdr_t hdr;
+    uint32 flags;
+    int32 eventfd;
+} kcom_msg_dma_ring_t;
+
 /*
  * All messages (e.g. for generic receive)
  */
@@ -532,11 +620,98 @@ typedef union kcom_msg_s {
     kcom_msg_filter_list_t filter_list;
     kcom_msg_filter_get_t filter_get;
     kcom_msg_dma_info_t dma_info;
+    kcom_msg_dma_ring_t dma_ring;
     kcom_msg_dbg_pkt_set_t dbg_pkt_set;
     kcom_msg_dbg_pkt_get_t dbg_pkt_get;
     kcom_msg_wb_cleanup_t wb_cleanup;
+    kcom_msg_wb_reattach_t wb_reattach;
 } kcom_msg_t;
 
+/*
+ * Bulk messages
+ *
+ * Bulk messages carry arrays of objects and do not fit in kcom_msg_t,
+ * so the message buffer must be sized for kcom_msg_bulk_t. Kernel
+ * modules without bulk support reply with opcode 0.
+ *
+ * Bulk create and destroy requests are applied either entirely or not
+ * at all. On failure hdr.status is set and hdr.id holds the index of
+ * the entry which could not be applied.
+ *
+ * Bulk get requests return up to cnt (0 means the maximum) objects with
+ * IDs starting from hdr.id in ascending order. The more flag is set if
+ * objects with higher IDs exist, in which case the next request should
+ * start from the last returned ID plus one.
+ */
+#ifndef KCOM_NETIF_BULK_MAX
+#define KCOM_NETIF_BULK_MAX     64
+#endif
+
+#ifndef KCOM_FILTER_BULK_MAX
+#define KCOM_FILTER_BULK_MAX    16
+#endif
+
+/*
+ * Create multiple system network interfaces. Assigned IDs, names
+ * and MAC addresses are returned in place.
+ */
+typedef struct kcom_msg_netif_create_bulk_s {
+    kcom_msg_hdr_t hdr;
+    uint32 cnt;
+    kcom_netif_t netif[KCOM_NETIF_BULK_MAX];
+} kcom_msg_netif_create_bulk_t;
+
+/*
+ * Get detailed information of multiple network interfaces.
+ */
+typedef struct kcom_msg_netif_get_bulk_s {
+    kcom_msg_hdr_t hdr;
+    uint32 cnt;
+    uint32 more;
+    kcom_netif_t netif[KCOM_NETIF_BULK_MAX];
+} kcom_msg_netif_get_bulk_t;
+
+/*
+ * Create multiple packet filters. Assigned IDs are returned in place.
+ */
+typedef struct kcom_msg_filter_create_bulk_s {
+    kcom_msg_hdr_t hdr;
+    uint32 cnt;
+    kcom_filter_t filter[KCOM_FILTER_BULK_MAX];
+} kcom_msg_filter_create_bulk_t;
+
+/*
+ * Destroy multiple packet filters.
+ */
+typedef struct kcom_msg_filter_destroy_bulk_s {
+    kcom_msg_hdr_t hdr;
+    uint32 cnt;
+    uint16 id[KCOM_FILTER_MAX];
+} kcom_msg_filter_destroy_bulk_t;
+
+/*
+ * Get detailed information of multiple packet filters.
+ */
+typedef struct kcom_msg_filter_get_bulk_s {
+    kcom_msg_hdr_t hdr;
+    uint32 cnt;
+    uint32 more;
+    kcom_filter_t filter[KCOM_FILTER_BULK_MAX];
+} kcom_msg_filter_get_bulk_t;
+
+/*
+ * All messages including bulk messages
+ */
+typedef union kcom_msg_bulk_s {
+    kcom_msg_hdr_t hdr;
+    kcom_msg_t msg;
+    kcom_msg_netif_create_bulk_t netif_create_bulk;
+    kcom_msg_netif_get_bulk_t netif_get_bulk;
+    kcom_msg_filter_create_bulk_t filter_create_bulk;
+    kcom_msg_filter_destroy_bulk_t filter_destroy_bulk;
+    kcom_msg_filter_get_bulk_t filter_get_bulk;
+} kcom_msg_bulk_t;
+
 /*
  * KCOM communication channel vectors
  *
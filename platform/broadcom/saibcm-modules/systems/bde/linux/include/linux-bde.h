@@ -222,6 +222,18 @@ extern int lkbde_dev_instid_set(int d, uint32 instid);
 extern int lkbde_irq_mask_set(int d, uint32 addr, uint32 mask, uint32 fmask);
 extern int lkbde_irq_mask_get(int d, uint32 *mask, uint32 *fmask);
 
+/*
+ * MSI-X vector map. Vector 0 runs the handlers installed through
+ * interrupt_connect. Other vectors can get a dedicated handler, e.g.
+ * for packet DMA, and each vector can be steered to its own CPU via
+ * /proc/irq/<irq>/smp_affinity.
+ */
+#define LKBDE_MSIX_VEC_MAX 16
+extern int lkbde_irq_vector_get(int d, int *irqs, int max);
+extern int lkbde_irq_vector_connect(int d, int vec,
+                                    void (*isr)(void *), void *isr_data);
+extern int lkbde_irq_vector_disconnect(int d, int vec);
+
 #ifdef BCM_SAND_SUPPORT
 extern int lkbde_cpu_write(int d, uint32 addr, uint32 *buf);
 extern int lkbde_cpu_read(int d, uint32 addr, uint32 *buf);
@@ -32,5 +32,10 @@ extern void  mpool_free(mpool_handle_t pool, void* ptr);
 extern int mpool_destroy(mpool_handle_t pool);
 
 extern int mpool_usage(mpool_handle_t pool);
+extern int mpool_usage_max(mpool_handle_t pool);
+extern int mpool_class_usage(mpool_handle_t pool, int cls, int *size,
+                             int *inuse, int *cached);
+extern int mpool_largest_free(mpool_handle_t pool);
+extern int mpool_free_blocks(mpool_handle_t pool);
 
 #endif /* __MPOOL_H__ */
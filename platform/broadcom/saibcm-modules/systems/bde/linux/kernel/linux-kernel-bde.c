@@ -86,7 +86,17 @@ LKM_MOD_PARAM(nodevices, "i", int, 0);
 MODULE_PARM_DESC(nodevices,
 "Ignore all recognized devices (default no)");
 
+/* Number of MSI-X vectors to enable */
 int msixcnt = 1;
+LKM_MOD_PARAM(msixcnt, "i", int, 0);
+MODULE_PARM_DESC(msixcnt,
+"Number of MSI-X vectors to enable when usemsi=2 (default 1)");
+
+/* Spread MSI-X vectors across CPUs */
+int msix_affinity = 0;
+LKM_MOD_PARAM(msix_affinity, "i", int, 0);
+MODULE_PARM_DESC(msix_affinity,
+"Set a per-CPU affinity hint for each MSI-X vector (default 0)");
 
 /*
  * This usually is defined at /usr/include/linux/pci_ids.h
@@ -256,6 +266,15 @@ struct bde_spi_device_id {
     uint32  spifreq;
 };
 
+/* MSI-X vector */
+typedef struct bde_irq_vec_s {
+    struct bde_ctrl_s *ctrl;
+    /* Dedicated handler, if NULL the device handlers are called */
+    void (*isr)(void *);
+    void *isr_data;
+    uint32 count;
+} bde_irq_vec_t;
+
 /* Control Data */
 typedef struct bde_ctrl_s {
     struct list_head list;
@@ -271,6 +290,7 @@ typedef struct bde_ctrl_s {
     struct msix_entry *entries;
 #endif
     int msix_cnt;
+    bde_irq_vec_t vec[LKBDE_MSIX_VEC_MAX];
     union {
         /* Linux PCI device pointer */
         struct pci_dev* _pci_dev;
@@ -438,6 +458,9 @@ static void *cpu_address = NULL;
     (void *)(_devices[d].bde_dev.base_address1 + (addr - _devices[d].phys_address1))
 
 static uint32_t _read(int d, uint32_t addr);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+static void _msix_free_irqs(bde_ctrl_t *ctrl, int cnt);
+#endif
 
 #ifdef BCM_ICS
 #else
@@ -2030,8 +2053,16 @@ _msi_connect(bde_ctrl_t *ctrl)
             goto er_intx;
         }
         /* Only one vector is mapped by default */
-        /* May be more in future, can be controlled using module param */
         ctrl->msix_cnt = msixcnt;
+        if (ctrl->msix_cnt > ret) {
+            ctrl->msix_cnt = ret;
+        }
+        if (ctrl->msix_cnt > LKBDE_MSIX_VEC_MAX) {
+            ctrl->msix_cnt = LKBDE_MSIX_VEC_MAX;
+        }
+        if (ctrl->msix_cnt < 1) {
+            ctrl->msix_cnt = 1;
+        }
         if (unlikely(debug > 1))
             gprintk("MSIX Table size = %d\n", ctrl->msix_cnt);
         for (i = 0; i < ctrl->msix_cnt; i++)
@@ -2093,6 +2124,7 @@ _msi_disconnect(bde_ctrl_t *ctrl)
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
     if (ctrl->use_msi == PCI_USE_INT_MSIX) {
         if (ctrl->msix_cnt) {
+            memset(ctrl->vec, 0, sizeof(ctrl->vec));
             pci_disable_msix(ctrl->pci_device);
             kfree(ctrl->entries);
             ctrl->entries = NULL;
@@ -2706,9 +2738,7 @@ _pci_remove(struct pci_dev* dev)
     if (ctrl->isr || ctrl->isr2) {
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
         if (ctrl->use_msi >= PCI_USE_INT_MSIX) {
-            int i;
-            for (i = 0; i < ctrl->msix_cnt; i++)
-                free_irq(ctrl->entries[i].vector, ctrl);
+            _msix_free_irqs(ctrl, ctrl->msix_cnt);
         }
         else
 #endif
@@ -3118,6 +3148,16 @@ _pprint(void)
                     (unsigned long)pci_resource_start(ctrl->pci_device, 2),
                     ctrl->pci_device->irq,
                     ctrl->use_msi ? " (MSI)" : "");
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+            if (ctrl->use_msi == PCI_USE_INT_MSIX) {
+                int v;
+                for (v = 0; v < ctrl->msix_cnt; v++) {
+                    pprintf("\t\tMSI-X vector %d: irq %d count %u%s\n",
+                            v, ctrl->entries[v].vector, ctrl->vec[v].count,
+                            ctrl->vec[v].isr ? " (dedicated)" : "");
+                }
+            }
+#endif
         } else if (ctrl->dev_type & BDE_SPI_DEV_TYPE) {
             pprintf("SPI Device %d:%x:%x:0x%x:0x%x:%d\n",
                     ctrl->spi_device->cid,
@@ -3387,6 +3427,81 @@ _isr(_ISR_PARAMS(irq, dev_id, iregs))
     return IRQ_HANDLED;
 }
 
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+/*
+ * MSI-X handler. Runs the dedicated handler of the vector if one is
+ * connected, otherwise the device handlers like _isr.
+ */
+static _ISR_RET
+_isr_vec(_ISR_PARAMS(irq, dev_id, iregs))
+{
+    bde_irq_vec_t *vec = (bde_irq_vec_t *) dev_id;
+    bde_ctrl_t *ctrl = vec->ctrl;
+    void (*isr)(void *);
+
+    vec->count++;
+    isr = vec->isr;
+    if (isr) {
+        smp_rmb();
+        isr(vec->isr_data);
+        return IRQ_HANDLED;
+    }
+    if (ctrl->isr) {
+        ctrl->isr(ctrl->isr_data);
+    }
+    if (ctrl->isr2) {
+        ctrl->isr2(ctrl->isr2_data);
+    }
+    return IRQ_HANDLED;
+}
+
+static void
+_msix_free_irqs(bde_ctrl_t *ctrl, int cnt)
+{
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        if (unlikely(debug > 1)) {
+            gprintk("%s(%d):irq = %d\n",
+                    __func__, __LINE__, ctrl->entries[i].vector);
+        }
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0))
+        irq_set_affinity_hint(ctrl->entries[i].vector, NULL);
+#endif
+        free_irq(ctrl->entries[i].vector, &ctrl->vec[i]);
+    }
+}
+
+static int
+_msix_request_irqs(bde_ctrl_t *ctrl)
+{
+    int i, ret = 0;
+
+    for (i = 0; i < ctrl->msix_cnt; i++) {
+        if (unlikely(debug >= 1)) {
+            gprintk("%s(%d):device# = %d, irq = %d\n",
+                    __func__, __LINE__, (int)(ctrl - _devices),
+                    ctrl->entries[i].vector);
+        }
+        ctrl->vec[i].ctrl = ctrl;
+        ret = request_irq(ctrl->entries[i].vector, (irq_handler_t)_isr_vec, 0,
+                          LINUX_KERNEL_BDE_NAME, &ctrl->vec[i]);
+        if (ret < 0) {
+            _msix_free_irqs(ctrl, i);
+            return ret;
+        }
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,1,0))
+        if (msix_affinity) {
+            irq_set_affinity_hint(ctrl->entries[i].vector,
+                get_cpu_mask(cpumask_local_spread(i,
+                             dev_to_node(&ctrl->pci_device->dev))));
+        }
+#endif
+    }
+    return 0;
+}
+#endif
+
 static int
 _interrupt_connect(int d,
                    void (*isr)(void *),
@@ -3454,21 +3569,8 @@ _interrupt_connect(int d,
 #endif
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
         if (ctrl->use_msi == PCI_USE_INT_MSIX) {
-            int i;
-            for (i = 0; i < ctrl->msix_cnt; i++) {
-                 if (unlikely(debug >= 1)) {
-                     gprintk("%s(%d):device# = %d, irq = %d\n",
-                         __func__, __LINE__, d, ctrl->entries[i].vector);
-                 }
-                 ret = request_irq(ctrl->entries[i].vector, (irq_handler_t)_isr, 0,
-                                   LINUX_KERNEL_BDE_NAME, ctrl);
-                 if (ret < 0)
-                     break;
-            }
+            ret = _msix_request_irqs(ctrl);
             if (ret < 0) {
-                while (i >= 0)
-                    free_irq(ctrl->entries[i--].vector, ctrl);
-
                 goto err_disable_msi;
             }
         }
@@ -3585,14 +3687,7 @@ _interrupt_disconnect(int d)
     if (isr_active) {
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
         if (ctrl->use_msi >= PCI_USE_INT_MSIX) {
-            int i;
-            for (i = 0; i < ctrl->msix_cnt; i++) {
-                if (unlikely(debug > 1)) {
-                     gprintk("%s(%d):device# = %d, irq = %d\n",
-                         __func__, __LINE__, d, ctrl->entries[i].vector);
-                }
-                free_irq(ctrl->entries[i].vector, ctrl);
-            }
+            _msix_free_irqs(ctrl, ctrl->msix_cnt);
         }
         else
 #endif
@@ -4336,6 +4431,138 @@ lkbde_get_num_devices(int type)
     return _num_devices(type);
 }
 
+/*
+ * Function: lkbde_irq_vector_get
+ *
+ * Purpose:
+ *    Get the Linux IRQ numbers used by a device.
+ * Parameters:
+ *    d - device number
+ *    irqs - (OUT) IRQ number of each vector
+ *    max - size of irqs
+ * Returns:
+ *    Number of vectors, -1 on error
+ * Notes:
+ *    Vector 0 is the IRQ used by interrupt_connect. Vectors are only
+ *    allocated once the primary or secondary handler is connected.
+ */
+int
+lkbde_irq_vector_get(int d, int *irqs, int max)
+{
+    bde_ctrl_t *ctrl;
+    int cnt = 0;
+
+    d &= ~(LKBDE_ISR2_DEV | LKBDE_IPROC_REG);
+
+    if (!VALID_DEVICE(d) || irqs == NULL) {
+        return -1;
+    }
+
+    ctrl = _devices + d;
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+    if (ctrl->use_msi == PCI_USE_INT_MSIX && ctrl->msix_cnt) {
+        int i;
+        for (i = 0; i < ctrl->msix_cnt && i < max; i++) {
+            irqs[i] = ctrl->entries[i].vector;
+        }
+        return i;
+    }
+#endif
+    if (max > 0 && ctrl->iLine != -1) {
+        irqs[cnt++] = ctrl->iLine;
+    }
+    return cnt;
+}
+
+/*
+ * Function: lkbde_irq_vector_connect
+ *
+ * Purpose:
+ *    Connect a dedicated handler to an MSI-X vector.
+ * Parameters:
+ *    d - device number
+ *    vec - vector index, 1 to number of vectors - 1
+ *    isr - interrupt handler
+ *    isr_data - handler argument
+ * Returns:
+ *    0 on success, -1 on error
+ * Notes:
+ *    The device handlers stay on vector 0 and on all vectors that
+ *    have no dedicated handler, so the interrupt sources must be
+ *    routed to the vector in hardware before it is connected.
+ */
+int
+lkbde_irq_vector_connect(int d, int vec,
+                         void (*isr)(void *), void *isr_data)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+    bde_ctrl_t *ctrl;
+
+    d &= ~(LKBDE_ISR2_DEV | LKBDE_IPROC_REG);
+
+    if (!VALID_DEVICE(d) || isr == NULL) {
+        return -1;
+    }
+
+    ctrl = _devices + d;
+
+    if (ctrl->use_msi != PCI_USE_INT_MSIX ||
+        vec < 1 || vec >= ctrl->msix_cnt || ctrl->vec[vec].isr) {
+        return -1;
+    }
+    ctrl->vec[vec].isr_data = isr_data;
+    smp_wmb();
+    ctrl->vec[vec].isr = isr;
+
+    if (debug >= 1) {
+        gprintk("device %d: vector %d (irq %d) connected\n",
+                d, vec, ctrl->entries[vec].vector);
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/*
+ * Function: lkbde_irq_vector_disconnect
+ *
+ * Purpose:
+ *    Disconnect the dedicated handler of an MSI-X vector.
+ * Parameters:
+ *    d - device number
+ *    vec - vector index
+ * Returns:
+ *    0 on success, -1 on error
+ */
+int
+lkbde_irq_vector_disconnect(int d, int vec)
+{
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,84))
+    bde_ctrl_t *ctrl;
+
+    d &= ~(LKBDE_ISR2_DEV | LKBDE_IPROC_REG);
+
+    if (!VALID_DEVICE(d)) {
+        return -1;
+    }
+
+    ctrl = _devices + d;
+
+    if (ctrl->use_msi != PCI_USE_INT_MSIX ||
+        vec < 1 || vec >= ctrl->msix_cnt) {
+        return -1;
+    }
+    ctrl->vec[vec].isr = NULL;
+    synchronize_irq(ctrl->entries[vec].vector);
+    ctrl->vec[vec].isr_data = NULL;
+    return 0;
+#else
+    return -1;
+#endif
+}
+
 /*
  * Export functions
  */
@@ -4348,6 +4575,9 @@ LKM_EXPORT_SYM(lkbde_get_hw_dev);
 LKM_EXPORT_SYM(lkbde_get_dma_dev);
 LKM_EXPORT_SYM(lkbde_irq_mask_set);
 LKM_EXPORT_SYM(lkbde_irq_mask_get);
+LKM_EXPORT_SYM(lkbde_irq_vector_get);
+LKM_EXPORT_SYM(lkbde_irq_vector_connect);
+LKM_EXPORT_SYM(lkbde_irq_vector_disconnect);
 LKM_EXPORT_SYM(lkbde_get_dev_phys_hi);
 LKM_EXPORT_SYM(lkbde_dev_state_set);
 LKM_EXPORT_SYM(lkbde_dev_state_get);
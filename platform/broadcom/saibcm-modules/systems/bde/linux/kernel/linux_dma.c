@@ -59,6 +59,18 @@
  * The module parameter dmasize=0M enables this allocation mode, however if
  * DMA memory is requested from a user mode application, a private memory
  * pool will be created and used irrespectively.
+ *
+ * 4. Using private pool in a CMA region
+ * -------------------------------------
+ * In this mode the private pool is allocated in one piece from the
+ * Contiguous Memory Allocator. The CMA region is reserved at boot time,
+ * e.g. using the cma=256M kernel parameter, so the pool can be created
+ * at its full size regardless of how fragmented the kernel memory has
+ * become, and the pool is a single physically contiguous block which
+ * user space maps in one piece.
+ *
+ * The module parameter dmaalloc=2 enables this allocation mode. It
+ * requires a kernel built with CONFIG_DMA_CMA.
  */
 
 #include <gmodule.h>
@@ -74,6 +86,11 @@
 /* allocation types/methods for the DMA memory pool */
 #define ALLOC_TYPE_CHUNK 0 /* use small allocations and join them */
 #define ALLOC_TYPE_API 1 /* use one allocation */
+#define ALLOC_TYPE_CMA 2 /* use one allocation from the CMA region */
+#if defined(CONFIG_DMA_CMA)
+#define BDE_DMA_CMA
+#include <linux/dma-mapping.h>
+#endif
 #if _SIMPLE_MEMORY_ALLOCATION_
 #include <linux/dma-mapping.h>
 #if defined(IPROC_CMICD) && defined(CONFIG_CMA) && defined(CONFIG_CMA_SIZE_MBYTES)
@@ -165,7 +182,7 @@ MODULE_PARM_DESC(dmasize,
 /* Select DMA memory pool allocation method */
 static int dmaalloc = ALLOC_METHOD_DEFAULT;
 LKM_MOD_PARAM(dmaalloc, "i", int, 0);
-MODULE_PARM_DESC(dmaalloc, "Select DMA memory allocation method");
+MODULE_PARM_DESC(dmaalloc, "Select DMA memory allocation method (0 chunks, 1 single allocation, 2 CMA)");
 
 /* Use high memory for DMA */
 static char *himem;
@@ -179,6 +196,18 @@ LKM_MOD_PARAM(himemaddr, "s", charp, 0);
 MODULE_PARM_DESC(himemaddr,
 "Physical address to use for high memory DMA");
 
+/* DMA allocation trace ring */
+static int dma_trace = 0;
+LKM_MOD_PARAM(dma_trace, "i", int, 0);
+MODULE_PARM_DESC(dma_trace,
+"Number of DMA allocations and frees to keep in a trace ring (default 0)");
+
+/* DMA memory pool usage warning */
+static int dma_warn_pct = 90;
+LKM_MOD_PARAM(dma_warn_pct, "i", int, 0);
+MODULE_PARM_DESC(dma_warn_pct,
+"Warn when kernel allocations take the DMA pool usage above this percentage, 0 disables (default 90)");
+
 /* DMA memory allocation */
 
 #define ONE_KB 1024
@@ -223,6 +252,59 @@ static unsigned long _himemaddr = 0;
 static int _use_dma_mapping = 0;
 static LIST_HEAD(_dma_seg);
 
+/*
+ * Kernel allocations from the DMA pool are accounted per owner, i.e.
+ * per name passed to salloc. Outstanding allocations are kept in a
+ * hash table so a free can be charged back to its owner and long
+ * lived allocations can be reported.
+ */
+#define DMA_TRACK_HASH_SIZE 256
+#define DMA_TRACK_HASH(_p) \
+        ((((unsigned long)(_p)) >> 7) & (DMA_TRACK_HASH_SIZE - 1))
+#define DMA_OWNER_MAX       32
+#define DMA_OWNER_NAME_LEN  24
+#define DMA_LAT_BUCKETS     8   /* <1us, <2us, <4us ... >=64us */
+#define DMA_TRACE_MAX       4096
+
+typedef struct dma_track_s {
+    struct dma_track_s *next;
+    void *ptr;
+    int size;
+    int owner;
+    unsigned long jiffies;
+} dma_track_t;
+
+typedef struct dma_owner_s {
+    char name[DMA_OWNER_NAME_LEN];
+    int count;                  /* Outstanding allocations */
+    int bytes;                  /* Outstanding bytes */
+    int bytes_max;              /* High-water mark of bytes */
+} dma_owner_t;
+
+typedef struct dma_trace_s {
+    unsigned long jiffies;
+    void *ptr;
+    int size;                   /* < 0 for a free */
+    short owner;
+} dma_trace_t;
+
+static struct {
+    spinlock_t lock;
+    dma_track_t *hash[DMA_TRACK_HASH_SIZE];
+    dma_owner_t owner[DMA_OWNER_MAX];
+    int owner_cnt;
+    uint32 allocs;
+    uint32 frees;
+    uint32 fails;
+    uint32 untracked;           /* Allocations without a tracking entry */
+    uint32 warns;               /* Crossings of the usage warning threshold */
+    int warned;                 /* Usage is above the warning threshold */
+    uint32 lat[DMA_LAT_BUCKETS];
+    dma_trace_t *trace;
+    int trace_size;
+    uint32 trace_idx;
+} _dma_track;
+
 #define DMA_DEV_INDEX      0    /* Device index to allocate memory pool */
 #define DMA_DEV(n)         lkbde_get_dma_dev(n)
 #define BDE_NUM_DEVICES(t) lkbde_get_num_devices(t)
@@ -571,6 +653,15 @@ _pgcleanup(void)
         break;
 #endif /* _SIMPLE_MEMORY_ALLOCATION_ */
 
+#ifdef BDE_DMA_CMA
+      case ALLOC_TYPE_CMA:
+        if (_dma_vbase) {
+            if (dma_debug >= 1) gprintk("freeing CMA v=%p p=0x%lx size=0x%lx\n", _dma_vbase,(unsigned long) _dma_pbase, (unsigned long)_dma_mem_size);
+            dma_free_coherent(DMA_DEV(DMA_DEV_INDEX), _dma_mem_size, _dma_vbase, _dma_pbase);
+        }
+        break;
+#endif /* BDE_DMA_CMA */
+
       case ALLOC_TYPE_CHUNK: {
         struct list_head *pos, *tmp;
         int i, ndevices;
@@ -664,6 +755,38 @@ _alloc_mpool(size_t size)
           }
 #endif /* _SIMPLE_MEMORY_ALLOCATION_ */
 
+#ifdef BDE_DMA_CMA
+          case ALLOC_TYPE_CMA: {
+            dma_addr_t dma_handle;
+
+            if (!DMA_DEV(DMA_DEV_INDEX)) {
+                gprintk("CMA memory pool requires a DMA device\n");
+                return;
+            }
+            /* Blocking allocations are served from the CMA region */
+            _dma_vbase = dma_alloc_coherent(DMA_DEV(DMA_DEV_INDEX), size,
+                                            &dma_handle,
+                                            GFP_KERNEL | __GFP_NOWARN);
+            if (!_dma_vbase) {
+                gprintk("Failed to allocate CMA memory pool of size 0x%lx, "
+                        "check the cma= kernel parameter\n", (unsigned long)size);
+                return;
+            }
+            if (!virt_addr_valid(_dma_vbase)) {
+                /* Remapped memory cannot be mapped to user space by PFN */
+                gprintk("CMA memory pool at %p is not in the linear mapping\n",
+                        _dma_vbase);
+                dma_free_coherent(DMA_DEV(DMA_DEV_INDEX), size,
+                                  _dma_vbase, dma_handle);
+                _dma_vbase = NULL;
+                return;
+            }
+            _cpu_pbase = virt_to_phys(_dma_vbase);
+            pbase = dma_handle;
+            break;
+          }
+#endif /* BDE_DMA_CMA */
+
           case ALLOC_TYPE_CHUNK:
             _dma_vbase = _pgalloc(size);
             if (!_dma_vbase) {
@@ -694,6 +817,8 @@ _alloc_mpool(size_t size)
 
         if (((pbase + (size - 1)) >> 16) > DMA_BIT_MASK(16)) {
             gprintk("DMA memory allocated at 0x%lx size 0x%lx is beyond the 4GB limit and not supported.\n", pbase, (unsigned long)size);
+            /* Single allocations are freed by their bus address */
+            _dma_pbase = pbase;
             _pgcleanup();
             _dma_vbase = NULL;
             _dma_pbase = 0;
@@ -725,6 +850,21 @@ _alloc_mpool(size_t size)
 int
 _dma_cleanup(void)
 {
+    dma_track_t *trk;
+    int i;
+
+    for (i = 0; i < DMA_TRACK_HASH_SIZE; i++) {
+        while ((trk = _dma_track.hash[i]) != NULL) {
+            _dma_track.hash[i] = trk->next;
+            kfree(trk);
+        }
+    }
+    if (_dma_track.trace) {
+        kfree(_dma_track.trace);
+        _dma_track.trace = NULL;
+        _dma_track.trace_size = 0;
+    }
+
     if (_dma_vbase) {
         mpool_destroy(_dma_pool);
         if (_use_himem) {
@@ -805,6 +945,19 @@ void _dma_init(int dev_index)
             _dma_pool = mpool_create(_dma_vbase, _dma_mem_size);
         }
     }
+
+    spin_lock_init(&_dma_track.lock);
+    if (dma_trace > 0) {
+        if (dma_trace > DMA_TRACE_MAX) {
+            dma_trace = DMA_TRACE_MAX;
+        }
+        _dma_track.trace = kcalloc(dma_trace, sizeof(dma_trace_t), GFP_KERNEL);
+        if (_dma_track.trace) {
+            _dma_track.trace_size = dma_trace;
+        } else {
+            gprintk("no memory for DMA trace ring\n");
+        }
+    }
 }
 
 /*
@@ -893,6 +1046,201 @@ _p2l(int d, sal_paddr_t paddr)
     return bus_to_virt(paddr);
 }
 
+/* Find or add an owner, called with the tracking lock held */
+static int
+_dma_owner_get(const char *name)
+{
+    int i;
+
+    if (name == NULL) {
+        name = "unknown";
+    }
+    for (i = 0; i < _dma_track.owner_cnt; i++) {
+        if (strncmp(_dma_track.owner[i].name, name,
+                    DMA_OWNER_NAME_LEN - 1) == 0) {
+            return i;
+        }
+    }
+    if (i == DMA_OWNER_MAX) {
+        /* Table full, charge the last entry */
+        return DMA_OWNER_MAX - 1;
+    }
+    strlcpy(_dma_track.owner[i].name,
+            (i == DMA_OWNER_MAX - 1) ? "other" : name, DMA_OWNER_NAME_LEN);
+    _dma_track.owner_cnt++;
+    return i;
+}
+
+/* Record an allocation or free in the trace ring */
+static void
+_dma_trace_add(void *ptr, int size, int owner)
+{
+    dma_trace_t *t;
+
+    if (_dma_track.trace_size == 0) {
+        return;
+    }
+    t = &_dma_track.trace[_dma_track.trace_idx++ % _dma_track.trace_size];
+    t->jiffies = jiffies;
+    t->ptr = ptr;
+    t->size = size;
+    t->owner = owner;
+}
+
+/*
+ * Warn when the pool usage rises above dma_warn_pct, and again only
+ * after it dropped below it by a tenth of the threshold. Called with
+ * the tracking lock held.
+ */
+static void
+_dma_usage_check(int size)
+{
+    int usage, pct;
+
+    if (dma_warn_pct <= 0 || !_dma_mem_size || !_dma_pool) {
+        return;
+    }
+    usage = mpool_usage(_dma_pool);
+    pct = usage / (_dma_mem_size / 100);
+    if (!_dma_track.warned && pct >= dma_warn_pct) {
+        _dma_track.warned = 1;
+        _dma_track.warns++;
+        gprintk("DMA pool usage %d%% (%d of %u bytes) after a %d byte "
+                "allocation, high-water mark %d bytes, largest free block %d bytes\n",
+                pct, usage, _dma_mem_size, size, mpool_usage_max(_dma_pool),
+                mpool_largest_free(_dma_pool));
+    } else if (_dma_track.warned &&
+               pct < dma_warn_pct - (dma_warn_pct + 9) / 10) {
+        _dma_track.warned = 0;
+    }
+}
+
+/*
+ * Function: _dma_track_alloc
+ *
+ * Purpose:
+ *    Allocate DMA memory and account it to an owner.
+ * Parameters:
+ *    size - number of bytes
+ *    name - owner tag
+ * Returns:
+ *    Pointer to memory or NULL
+ */
+static void *
+_dma_track_alloc(int size, const char *name)
+{
+    dma_track_t *trk;
+    unsigned long flags;
+    ktime_t start;
+    s64 lat;
+    void *ptr;
+    int b, idx;
+
+    start = ktime_get();
+    if (_dma_mem_size) {
+        ptr = mpool_alloc(_dma_pool, size);
+    } else if ((ptr = kmalloc(size, mem_flags)) == NULL) {
+        ptr = _pgalloc(size);
+    }
+    lat = ktime_to_us(ktime_sub(ktime_get(), start));
+    b = 0;
+    while (b < DMA_LAT_BUCKETS - 1 && lat >= (1 << b)) {
+        b++;
+    }
+
+    trk = ptr ? kmalloc(sizeof(*trk), GFP_ATOMIC) : NULL;
+
+    spin_lock_irqsave(&_dma_track.lock, flags);
+    _dma_track.lat[b]++;
+    if (ptr == NULL) {
+        _dma_track.fails++;
+        spin_unlock_irqrestore(&_dma_track.lock, flags);
+        if (dma_debug >= 1 || (dma_warn_pct > 0 && printk_ratelimit())) {
+            gprintk("DMA allocation of %d bytes for %s failed, largest free block %d bytes\n",
+                    size, name ? name : "unknown",
+                    (_dma_mem_size && _dma_pool) ? mpool_largest_free(_dma_pool) : 0);
+        }
+        return NULL;
+    }
+    _dma_track.allocs++;
+    _dma_usage_check(size);
+    if (trk) {
+        dma_owner_t *own;
+
+        trk->ptr = ptr;
+        trk->size = size;
+        trk->owner = _dma_owner_get(name);
+        trk->jiffies = jiffies;
+        idx = DMA_TRACK_HASH(ptr);
+        trk->next = _dma_track.hash[idx];
+        _dma_track.hash[idx] = trk;
+
+        own = &_dma_track.owner[trk->owner];
+        own->count++;
+        own->bytes += size;
+        if (own->bytes > own->bytes_max) {
+            own->bytes_max = own->bytes;
+        }
+        _dma_trace_add(ptr, size, trk->owner);
+    } else {
+        _dma_track.untracked++;
+        _dma_trace_add(ptr, size, -1);
+    }
+    spin_unlock_irqrestore(&_dma_track.lock, flags);
+
+    return ptr;
+}
+
+/*
+ * Function: _dma_track_free
+ *
+ * Purpose:
+ *    Free DMA memory allocated by _dma_track_alloc.
+ * Parameters:
+ *    ptr - memory to free
+ * Returns:
+ *    Nothing
+ */
+static void
+_dma_track_free(void *ptr)
+{
+    dma_track_t **pp, *trk;
+    unsigned long flags;
+    int owner = -1;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    spin_lock_irqsave(&_dma_track.lock, flags);
+    pp = &_dma_track.hash[DMA_TRACK_HASH(ptr)];
+    for (trk = *pp; trk; pp = &trk->next, trk = trk->next) {
+        if (trk->ptr == ptr) {
+            *pp = trk->next;
+            owner = trk->owner;
+            _dma_track.owner[owner].count--;
+            _dma_track.owner[owner].bytes -= trk->size;
+            break;
+        }
+    }
+    _dma_track.frees++;
+    _dma_trace_add(ptr, trk ? -trk->size : 0, owner);
+    spin_unlock_irqrestore(&_dma_track.lock, flags);
+
+    kfree(trk);
+
+    if (_dma_mem_size) {
+        mpool_free(_dma_pool, ptr);
+        spin_lock_irqsave(&_dma_track.lock, flags);
+        _dma_usage_check(0);
+        spin_unlock_irqrestore(&_dma_track.lock, flags);
+        return;
+    }
+    if (_pgfree(ptr) < 0) {
+        kfree(ptr);
+    }
+}
+
 /*
  * Some of the driver malloc's are too large for
  * kmalloc(), so 'sal_alloc' and 'sal_free' in the
@@ -908,37 +1256,24 @@ _p2l(int d, sal_paddr_t paddr)
 
 void* kmalloc_giant(int sz)
 {
-    return mpool_alloc(_dma_pool, sz);
+    return _dma_track_alloc(sz, "giant");
 }
 
 void kfree_giant(void* ptr)
 {
-    return mpool_free(_dma_pool, ptr);
+    _dma_track_free(ptr);
 }
 
 uint32_t *
 _salloc(int d, int size, const char *name)
 {
-    void *ptr;
-
-    if (_dma_mem_size) {
-        return mpool_alloc(_dma_pool, size);
-    }
-    if ((ptr = kmalloc(size, mem_flags)) == NULL) {
-        ptr = _pgalloc(size);
-    }
-    return ptr;
+    return _dma_track_alloc(size, name);
 }
 
 void
 _sfree(int d, void *ptr)
 {
-    if (_dma_mem_size) {
-        return mpool_free(_dma_pool, ptr);
-    }
-    if (_pgfree(ptr) < 0) {
-        kfree(ptr);
-    }
+    _dma_track_free(ptr);
 }
 
 int
@@ -989,15 +1324,111 @@ lkbde_get_dma_info(phys_addr_t* cpu_pbase, phys_addr_t* dma_pbase, ssize_t* size
     return 0;
 }
 
+/* Print the kernel allocation accounting */
+static void
+_dma_track_pprint(void)
+{
+    unsigned long oldest[DMA_OWNER_MAX];
+    unsigned long flags;
+    dma_track_t *trk;
+    dma_trace_t *t;
+    uint32 idx;
+    int i, n;
+
+    spin_lock_irqsave(&_dma_track.lock, flags);
+
+    pprintf("DMA kernel allocations: %u allocs, %u frees, %u failed, "
+            "%u untracked\n", _dma_track.allocs, _dma_track.frees,
+            _dma_track.fails, _dma_track.untracked);
+    if (dma_warn_pct > 0) {
+        pprintf("  Usage warning at %d%%: crossed %u times%s\n",
+                dma_warn_pct, _dma_track.warns,
+                _dma_track.warned ? ", above now" : "");
+    }
+
+    pprintf("  Alloc latency (us):");
+    for (i = 0; i < DMA_LAT_BUCKETS - 1; i++) {
+        pprintf(" <%d:%u", 1 << i, _dma_track.lat[i]);
+    }
+    pprintf(" >=%d:%u\n", 1 << (DMA_LAT_BUCKETS - 2), _dma_track.lat[i]);
+
+    /* Age of the oldest outstanding allocation of each owner */
+    memset(oldest, 0, sizeof(oldest));
+    for (i = 0; i < DMA_TRACK_HASH_SIZE; i++) {
+        for (trk = _dma_track.hash[i]; trk; trk = trk->next) {
+            if (oldest[trk->owner] == 0 ||
+                time_before(trk->jiffies, oldest[trk->owner])) {
+                oldest[trk->owner] = trk->jiffies;
+            }
+        }
+    }
+    for (i = 0; i < _dma_track.owner_cnt; i++) {
+        dma_owner_t *own = &_dma_track.owner[i];
+
+        pprintf("  %-24s %6d allocs %10d bytes %10d max",
+                own->name, own->count, own->bytes, own->bytes_max);
+        if (own->count && oldest[i]) {
+            pprintf(", oldest %lus", (jiffies - oldest[i]) / HZ);
+        }
+        pprintf("\n");
+    }
+
+    if (_dma_track.trace_size) {
+        n = _dma_track.trace_idx < _dma_track.trace_size ?
+            _dma_track.trace_idx : _dma_track.trace_size;
+        pprintf("DMA trace (last %d):\n", n);
+        for (idx = _dma_track.trace_idx - n; idx != _dma_track.trace_idx; idx++) {
+            t = &_dma_track.trace[idx % _dma_track.trace_size];
+            pprintf("  %10lu %s %p %8d %s\n", t->jiffies,
+                    (t->size < 0) ? "free " : "alloc", t->ptr,
+                    (t->size < 0) ? -t->size : t->size,
+                    (t->owner >= 0) ? _dma_track.owner[t->owner].name : "-");
+        }
+    }
+
+    spin_unlock_irqrestore(&_dma_track.lock, flags);
+}
+
 void
 _dma_pprint(void)
 {
+    int cls, size, inuse, cached;
+    int free, largest, blocks, pct;
+
     pprintf("DMA Memory (%s): %d bytes, %d used, %d free%s\n",
             (_use_himem) ? "high" : "kernel",
             (_dma_vbase) ? _dma_mem_size : 0,
             (_dma_vbase) ? mpool_usage(_dma_pool) : 0,
             (_dma_vbase) ? _dma_mem_size - mpool_usage(_dma_pool) : 0,
             USE_LINUX_BDE_MMAP ? ", local mmap" : "");
+
+    if (!_dma_vbase || !_dma_pool) {
+        _dma_track_pprint();
+        return;
+    }
+
+    free = _dma_mem_size - mpool_usage(_dma_pool);
+    for (cls = 0; mpool_class_usage(_dma_pool, cls, &size,
+                                    &inuse, &cached) == 0; cls++) {
+        if (inuse || cached) {
+            pprintf("  %8d byte blocks: %d used, %d cached\n",
+                    size, inuse, cached);
+        }
+        free -= size * cached;
+    }
+
+    /* Share of the uncached free memory outside the largest free block */
+    largest = mpool_largest_free(_dma_pool);
+    pct = (free >= 100) ? largest / (free / 100) : 100;
+    if (pct > 100) {
+        pct = 100;
+    }
+    blocks = mpool_free_blocks(_dma_pool);
+    pprintf("DMA Memory largest free block %d bytes in %d free blocks, "
+            "fragmentation %d%%\n", largest, blocks, 100 - pct);
+    pprintf("DMA Memory high-water mark %d bytes\n", mpool_usage_max(_dma_pool));
+
+    _dma_track_pprint();
 }
 
 /*
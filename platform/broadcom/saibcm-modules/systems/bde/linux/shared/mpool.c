@@ -73,16 +73,41 @@ static sal_sem_t _mpool_lock;
 #define MPOOL_BUF_SIZE               1024
 #define MPOOL_BUF_ALLOC_COUNT_MAX      16
 
+/*
+ * Small blocks are rounded up to a power of two size class. Freed
+ * blocks of a size class stay in the address list and are kept on a
+ * per-class free list for reuse, so allocating and freeing them does
+ * not walk the address list. Blocks are found by address through a
+ * hash table on free.
+ */
+#define MPOOL_CLASS_NUM                10
+#define MPOOL_CLASS_SIZE(_c)           (BCM_CACHE_LINE_BYTES << (_c))
+#define MPOOL_HASH_SIZE              4096
+#define MPOOL_HASH(_a) \
+        ((((unsigned long)(_a)) / BCM_CACHE_LINE_BYTES) & (MPOOL_HASH_SIZE - 1))
+
 typedef struct mpool_mem_s {
     unsigned char *address;
     int size;
+    int cls;                    /* Size class or -1 */
     struct mpool_mem_s *prev;
     struct mpool_mem_s *next;
+    struct mpool_mem_s *hnext;  /* Hash chain or class free list */
 } mpool_mem_t;
 
+typedef struct mpool_class_s {
+    mpool_mem_t *free;          /* Freed blocks ready for reuse */
+    int inuse;                  /* Allocated blocks */
+    int cached;                 /* Blocks on the free list */
+} mpool_class_t;
+
 static int _buf_alloc_count;
 static mpool_mem_t *mpool_buf[MPOOL_BUF_ALLOC_COUNT_MAX];
 static mpool_mem_t *free_list;
+static mpool_mem_t *_mpool_hash[MPOOL_HASH_SIZE];
+static mpool_class_t _mpool_class[MPOOL_CLASS_NUM];
+static int _mpool_used;
+static int _mpool_used_max;
 
 #define ALLOC_INIT_MPOOL_BUF(ptr) \
         ptr = MALLOC((sizeof(mpool_mem_t) * MPOOL_BUF_SIZE)); \
@@ -116,6 +141,70 @@ mpool_init(void)
 static int _dma_mem_used = 0;
 #endif
 
+static void
+_mpool_hash_add(mpool_mem_t *ptr)
+{
+    int idx = MPOOL_HASH(ptr->address);
+
+    ptr->hnext = _mpool_hash[idx];
+    _mpool_hash[idx] = ptr;
+}
+
+static mpool_mem_t *
+_mpool_hash_del(unsigned char *address)
+{
+    mpool_mem_t **pp = &_mpool_hash[MPOOL_HASH(address)];
+    mpool_mem_t *ptr;
+
+    for (ptr = *pp; ptr; pp = &ptr->hnext, ptr = ptr->hnext) {
+        if (ptr->address == address) {
+            *pp = ptr->hnext;
+            ptr->hnext = NULL;
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+/* Remove a block from the address list */
+static void
+_mpool_unlink(mpool_mem_t *ptr)
+{
+    ptr->prev->next = ptr->next;
+    ptr->next->prev = ptr->prev;
+    ptr->next = free_list;
+    free_list = ptr;
+}
+
+/* Return all cached size class blocks to the address list */
+static void
+_mpool_class_flush(void)
+{
+    mpool_mem_t *ptr;
+    int cls;
+
+    for (cls = 0; cls < MPOOL_CLASS_NUM; cls++) {
+        while ((ptr = _mpool_class[cls].free) != NULL) {
+            _mpool_class[cls].free = ptr->hnext;
+            _mpool_unlink(ptr);
+        }
+        _mpool_class[cls].cached = 0;
+    }
+}
+
+/* First-fit search of the address list */
+static mpool_mem_t *
+_mpool_fit(mpool_mem_t *ptr, int size)
+{
+    while (ptr && ptr->next) {
+        if (ptr->next->address - (ptr->address + ptr->size) >= size) {
+            return ptr;
+        }
+        ptr = ptr->next;
+    }
+    return NULL;
+}
+
 /*
  * Function: mpool_alloc
  *
@@ -132,6 +221,7 @@ mpool_alloc(mpool_handle_t pool, int size)
 {
     mpool_mem_t *ptr = pool, *newptr = NULL;
     int mod;
+    int cls;
 
     MPOOL_LOCK();
 
@@ -143,14 +233,30 @@ mpool_alloc(mpool_handle_t pool, int size)
     if (mod != 0 ) {
         size += (BCM_CACHE_LINE_BYTES - mod);
     }
-    while (ptr && ptr->next) {
-        if (ptr->next->address - (ptr->address + ptr->size) >= size) {
+
+    for (cls = 0; cls < MPOOL_CLASS_NUM; cls++) {
+        if (MPOOL_CLASS_SIZE(cls) >= size) {
+            size = MPOOL_CLASS_SIZE(cls);
             break;
         }
-        ptr = ptr->next;
+    }
+    if (cls == MPOOL_CLASS_NUM) {
+        cls = -1;
+    } else if ((newptr = _mpool_class[cls].free) != NULL) {
+        /* Reuse a freed block of the same size class */
+        _mpool_class[cls].free = newptr->hnext;
+        _mpool_class[cls].cached--;
+        goto done;
+    }
+
+    ptr = _mpool_fit(pool, size);
+    if (!ptr) {
+        /* Give the cached blocks back and try again */
+        _mpool_class_flush();
+        ptr = _mpool_fit(pool, size);
     }
   
-    if (!(ptr && ptr->next)) {
+    if (!ptr) {
         MPOOL_UNLOCK();
         return NULL;
     }
@@ -176,10 +282,21 @@ mpool_alloc(mpool_handle_t pool, int size)
   
     newptr->address = ptr->address + ptr->size;
     newptr->size = size;
+    newptr->cls = cls;
     newptr->next = ptr->next;
     newptr->prev = ptr;
     ptr->next->prev = newptr;
     ptr->next = newptr;
+
+done:
+    _mpool_hash_add(newptr);
+    if (cls >= 0) {
+        _mpool_class[cls].inuse++;
+    }
+    _mpool_used += size;
+    if (_mpool_used > _mpool_used_max) {
+        _mpool_used_max = _mpool_used;
+    }
 #ifdef TRACK_DMA_USAGE
     _dma_mem_used += size;
 #endif
@@ -213,20 +330,21 @@ mpool_free(mpool_handle_t pool, void *addr)
         return;
     }
 
-    ptr = head->prev->prev;
-
-    while (ptr && (ptr != head)) {
-        if (ptr->address == address) {
+    ptr = _mpool_hash_del(address);
+    if (ptr) {
 #ifdef TRACK_DMA_USAGE
-            _dma_mem_used -= ptr->size;
+        _dma_mem_used -= ptr->size;
 #endif
-            ptr->prev->next = ptr->next;
-            ptr->next->prev = ptr->prev;
-            ptr->next = free_list;
-            free_list = ptr;
-            break;
+        _mpool_used -= ptr->size;
+        if (ptr->cls >= 0) {
+            /* Keep it in place for the next allocation of this size */
+            _mpool_class[ptr->cls].inuse--;
+            _mpool_class[ptr->cls].cached++;
+            ptr->hnext = _mpool_class[ptr->cls].free;
+            _mpool_class[ptr->cls].free = ptr;
+        } else {
+            _mpool_unlink(ptr);
         }
-        ptr = ptr->prev;
     }
 
     MPOOL_UNLOCK();
@@ -261,6 +379,17 @@ mpool_create(void *base_ptr, int size)
 
     _buf_alloc_count = 0;
 
+    for (i = 0; i < MPOOL_HASH_SIZE; i++) {
+        _mpool_hash[i] = NULL;
+    }
+    for (i = 0; i < MPOOL_CLASS_NUM; i++) {
+        _mpool_class[i].free = NULL;
+        _mpool_class[i].inuse = 0;
+        _mpool_class[i].cached = 0;
+    }
+    _mpool_used = 0;
+    _mpool_used_max = 0;
+
     ALLOC_INIT_MPOOL_BUF(mpool_buf[_buf_alloc_count]);
 
     if (mpool_buf[_buf_alloc_count] == NULL) {
@@ -282,6 +411,7 @@ mpool_create(void *base_ptr, int size)
     free_list = free_list->next;
 
     head->size = tail->size = 0;
+    head->cls = tail->cls = -1;
     head->address = base_ptr;
     tail->address = head->address + size;
     head->prev = tail;
@@ -336,20 +466,138 @@ mpool_destroy(mpool_handle_t pool)
  *    pool - mpool handle (from mpool_create)
  * Returns:
  *    Number of bytes currently allocated using mpool_alloc.
+ * Notes
+ *    Freed blocks cached by size class are not counted.
  */
 int
 mpool_usage(mpool_handle_t pool)
 {
-    int usage = 0;
+    int usage;
+
+    MPOOL_LOCK();
+
+    usage = pool ? _mpool_used : 0;
+
+    MPOOL_UNLOCK();
+
+    return usage;
+}
+
+/*
+ * Function: mpool_usage_max
+ *
+ * Purpose:
+ *    Report the high-water mark of allocated mpool memory.
+ * Parameters:
+ *    pool - mpool handle (from mpool_create)
+ * Returns:
+ *    Largest number of bytes allocated at any time since mpool_create.
+ */
+int
+mpool_usage_max(mpool_handle_t pool)
+{
+    int usage;
+
+    MPOOL_LOCK();
+
+    usage = pool ? _mpool_used_max : 0;
+
+    MPOOL_UNLOCK();
+
+    return usage;
+}
+
+/*
+ * Function: mpool_class_usage
+ *
+ * Purpose:
+ *    Report usage of a size class.
+ * Parameters:
+ *    pool - mpool handle (from mpool_create)
+ *    cls - size class index
+ *    size - (OUT) block size of the size class
+ *    inuse - (OUT) number of allocated blocks
+ *    cached - (OUT) number of freed blocks kept for reuse
+ * Returns:
+ *    0 on success, -1 if there is no such size class.
+ */
+int
+mpool_class_usage(mpool_handle_t pool, int cls, int *size,
+                  int *inuse, int *cached)
+{
+    if (!pool || cls < 0 || cls >= MPOOL_CLASS_NUM) {
+        return -1;
+    }
+
+    MPOOL_LOCK();
+
+    *size = MPOOL_CLASS_SIZE(cls);
+    *inuse = _mpool_class[cls].inuse;
+    *cached = _mpool_class[cls].cached;
+
+    MPOOL_UNLOCK();
+
+    return 0;
+}
+
+/*
+ * Function: mpool_largest_free
+ *
+ * Purpose:
+ *    Report the largest contiguous free block.
+ * Parameters:
+ *    pool - mpool handle (from mpool_create)
+ * Returns:
+ *    Size in bytes of the largest block mpool_alloc can return
+ *    without flushing the size class caches.
+ */
+int
+mpool_largest_free(mpool_handle_t pool)
+{
+    int largest = 0, gap;
     mpool_mem_t *ptr;
 
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next) {
-        usage += ptr->size;
+    for (ptr = pool; ptr && ptr->next; ptr = ptr->next) {
+        gap = ptr->next->address - (ptr->address + ptr->size);
+        if (gap > largest) {
+            largest = gap;
+        }
     }
 
     MPOOL_UNLOCK();
 
-    return usage;
+    return largest;
+}
+
+/*
+ * Function: mpool_free_blocks
+ *
+ * Purpose:
+ *    Report the number of contiguous free blocks.
+ * Parameters:
+ *    pool - mpool handle (from mpool_create)
+ * Returns:
+ *    Number of gaps between allocated blocks, not counting the
+ *    freed blocks cached by size class. A pool that is not
+ *    fragmented has at most one.
+ */
+int
+mpool_free_blocks(mpool_handle_t pool)
+{
+    int blocks = 0;
+    mpool_mem_t *ptr;
+
+    MPOOL_LOCK();
+
+    for (ptr = pool; ptr && ptr->next; ptr = ptr->next) {
+        if (ptr->next->address > ptr->address + ptr->size) {
+            blocks++;
+        }
+    }
+
+    MPOOL_UNLOCK();
+
+    return blocks;
 }
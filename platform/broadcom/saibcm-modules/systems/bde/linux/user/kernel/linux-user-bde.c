@@ -33,6 +33,7 @@
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4,12,0)
 #include <linux/uaccess.h>
 #endif
+#include <linux/eventfd.h>
 
 
 MODULE_AUTHOR("Broadcom Corporation");
@@ -175,6 +176,12 @@ typedef struct {
     unsigned int    dma_size;
     wait_queue_head_t intr_wq;
     atomic_t intr;
+    spinlock_t intr_lock;       /* Protects the interrupt event data */
+    int intr_events;            /* Collect interrupt status in the ISR */
+    uint32 intr_cnt;            /* Interrupts since the last wait */
+    u64 intr_ts;                /* Time of the last interrupt (ns) */
+    uint32 intr_stat[LUBDE_INTR_STAT_WORDS]; /* Status since the last wait */
+    struct eventfd_ctx *intr_efd; /* Signaled on every interrupt */
 } bde_inst_resource_t;
 
 static bde_inst_resource_t _bde_inst_resource[LINUX_BDE_MAX_DEVICES];
@@ -212,6 +219,60 @@ static _dma_pool_t _dma_pool;
             writel((val), (addr))
 
 #endif
+/*
+ * Function: _intr_stat_add
+ *
+ * Purpose:
+ *    Record interrupt status bits for LUBDE_WAIT_FOR_INTERRUPT_EVENTS.
+ * Parameters:
+ *    res - instance resource
+ *    ind - status word index
+ *    stat - status bits
+ * Returns:
+ *    Nothing
+ */
+static void
+_intr_stat_add(bde_inst_resource_t *res, int ind, uint32 stat)
+{
+    if (ind < LUBDE_INTR_STAT_WORDS) {
+        spin_lock(&res->intr_lock);
+        res->intr_stat[ind] |= stat;
+        spin_unlock(&res->intr_lock);
+    }
+}
+
+/*
+ * Function: _intr_notify
+ *
+ * Purpose:
+ *    Account for an interrupt and wake up the interrupt thread.
+ * Parameters:
+ *    res - instance resource
+ * Returns:
+ *    Nothing
+ */
+static void
+_intr_notify(bde_inst_resource_t *res)
+{
+    struct eventfd_ctx *efd;
+
+    spin_lock(&res->intr_lock);
+    res->intr_cnt++;
+    res->intr_ts = ktime_to_ns(ktime_get());
+    efd = res->intr_efd;
+    if (efd) {
+        eventfd_signal(efd, 1);
+    }
+    spin_unlock(&res->intr_lock);
+
+    atomic_set(&res->intr, 1);
+#ifdef BDE_LINUX_NON_INTERRUPTIBLE
+    wake_up(&res->intr_wq);
+#else
+    wake_up_interruptible(&res->intr_wq);
+#endif
+}
+
 /*
  * Function: _interrupt
  *
@@ -253,13 +314,7 @@ _cmic_interrupt(bde_ctrl_t *ctrl)
 
     lkbde_irq_mask_set(d, CMIC_IRQ_MASK, 0, 0);
 
-    atomic_set(&res->intr, 1);
-
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 static void 
@@ -344,6 +399,17 @@ _cmicx_interrupt(bde_ctrl_t *ctrl)
         if (fmask && ind == INTC_PDMA_INTR_REG_IND) {
             continue;
         }
+        if (res->intr_events) {
+            if (ctrl->dev_type & BDE_AXI_DEV_TYPE) {
+                if (ind >= INTC_LOW_PRIORITY_INTR_REG_IND) {
+                    IHOST_READ_INTR(d, ihost_intr_status_base + ind, stat);
+                    _intr_stat_add(res, ind, stat);
+                }
+            } else {
+                READ_INTC_INTR(d, intc_intr_status_base + 4 * ind, stat);
+                _intr_stat_add(res, ind, stat);
+            }
+        }
         if (ctrl->dev_type & BDE_AXI_DEV_TYPE) {
             if (ind < INTC_LOW_PRIORITY_INTR_REG_IND) {
                 continue;
@@ -361,12 +427,7 @@ _cmicx_interrupt(bde_ctrl_t *ctrl)
     }
 
     /* Notify */
-    atomic_set(&res->intr, 1);
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 static void
@@ -427,6 +488,14 @@ _cmicm_interrupt(bde_ctrl_t *ctrl)
         return;
     }
 
+    if (res->intr_events) {
+        _intr_stat_add(res, 0, user_bde->read(d, CMIC_CMCx_IRQ_STAT0_OFFSET(cmc)));
+        _intr_stat_add(res, 1, user_bde->read(d, CMIC_CMCx_IRQ_STAT1_OFFSET(cmc)));
+        _intr_stat_add(res, 2, user_bde->read(d, CMIC_CMCx_IRQ_STAT2_OFFSET(cmc)));
+        _intr_stat_add(res, 3, user_bde->read(d, CMIC_CMCx_IRQ_STAT3_OFFSET(cmc)));
+        _intr_stat_add(res, 4, user_bde->read(d, CMIC_CMCx_IRQ_STAT4_OFFSET(cmc)));
+    }
+
     if (ctrl->dev_type & BDE_AXI_DEV_TYPE) {
         lkbde_irq_mask_set(d, CMIC_CMCx_UC0_IRQ_MASK0_OFFSET(cmc), 0, 0);
         user_bde->write(d, CMIC_CMCx_UC0_IRQ_MASK1_OFFSET(cmc), 0);
@@ -445,12 +514,7 @@ _cmicm_interrupt(bde_ctrl_t *ctrl)
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK0_OFFSET(1), 0);
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK0_OFFSET(2), 0);
     }
-    atomic_set(&res->intr, 1);
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 /* some device has cmc0 only */
@@ -546,12 +610,7 @@ _cmicd_cmc0_interrupt(bde_ctrl_t *ctrl)
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK5_OFFSET(cmc), 0);
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK6_OFFSET(cmc), 0);
     }
-    atomic_set(&res->intr, 1);
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 static void
@@ -650,12 +709,7 @@ _cmicd_interrupt(bde_ctrl_t *ctrl)
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK0_OFFSET(1), 0);
         user_bde->write(d, CMIC_CMCx_PCIE_IRQ_MASK0_OFFSET(2), 0);
     }
-    atomic_set(&res->intr, 1);
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 static void 
@@ -670,12 +724,7 @@ _bcm88750_interrupt(bde_ctrl_t *ctrl)
 
     lkbde_irq_mask_set(d, CMIC_IRQ_MASK_1, 0, 0); 
     lkbde_irq_mask_set(d, CMIC_IRQ_MASK_2, 0, 0);
-    atomic_set(&res->intr, 1);
-#ifdef BDE_LINUX_NON_INTERRUPTIBLE
-    wake_up(&res->intr_wq);
-#else
-    wake_up_interruptible(&res->intr_wq);
-#endif
+    _intr_notify(res);
 }
 
 /* The actual interrupt handler of ethernet devices */
@@ -926,6 +975,9 @@ _init(void)
 
     /* Use _bde_inst_resource[0] as the default resource */
     memset(_bde_inst_resource, 0, sizeof(_bde_inst_resource));
+    for (i = 0; i < LINUX_BDE_MAX_DEVICES; i++) {
+        spin_lock_init(&_bde_inst_resource[i].intr_lock);
+    }
     res = &_bde_inst_resource[0];
     res->dma_offset = 0;
     res->dma_size = _dma_pool.total_size;
@@ -970,6 +1022,13 @@ _cleanup(void)
         user_bde = NULL;
     }
 
+    for (i = 0; i < LINUX_BDE_MAX_DEVICES; i++) {
+        if (_bde_inst_resource[i].intr_efd) {
+            eventfd_ctx_put(_bde_inst_resource[i].intr_efd);
+            _bde_inst_resource[i].intr_efd = NULL;
+        }
+    }
+
     if (ihost_intr_enable_base) {
         iounmap(ihost_intr_enable_base);
         ihost_intr_enable_base = NULL;
@@ -1181,6 +1240,87 @@ _instance_attach(unsigned int inst_id, unsigned int dma_size)
     return LUBDE_SUCCESS;
 }
 
+/* Register operations copied from user space at a time */
+#define LUBDE_REG_BATCH_CHUNK 32
+
+/*
+ * Function: _reg_batch
+ *
+ * Purpose:
+ *    Execute a vector of register accesses for LUBDE_REG_BATCH.
+ * Parameters:
+ *    d - device number
+ *    uops - user space array of operations
+ *    cnt - number of operations
+ *    done - (OUT) number of completed operations
+ * Returns:
+ *    0 on success, -EFAULT on copy error, -1 on access error
+ */
+static int
+_reg_batch(int d, lubde_reg_op_t __user *uops, unsigned int cnt,
+           unsigned int *done)
+{
+    lubde_reg_op_t ops[LUBDE_REG_BATCH_CHUNK];
+    uint32_t *mapaddr;
+    unsigned int num, i;
+    int axi, rv = 0;
+
+    *done = 0;
+    axi = (_devices[d].dev_type & BDE_AXI_DEV_TYPE) ? 1 : 0;
+
+    while (*done < cnt && rv == 0) {
+        num = cnt - *done;
+        if (num > LUBDE_REG_BATCH_CHUNK) {
+            num = LUBDE_REG_BATCH_CHUNK;
+        }
+        if (copy_from_user(ops, uops + *done, num * sizeof(ops[0]))) {
+            return -EFAULT;
+        }
+        for (i = 0; i < num && rv == 0; i++) {
+            switch (ops[i].op) {
+            case LUBDE_REG_OP_READ:
+                ops[i].value = user_bde->read(d, ops[i].addr);
+                break;
+            case LUBDE_REG_OP_WRITE:
+                rv = user_bde->write(d, ops[i].addr, ops[i].value);
+                break;
+            case LUBDE_REG_OP_IPROC_READ:
+                if (axi) {
+                    mapaddr = IOREMAP(ops[i].addr, sizeof(uint32_t));
+                    if (mapaddr == NULL) {
+                        rv = -1;
+                        break;
+                    }
+                    ops[i].value = readl(mapaddr);
+                    iounmap(mapaddr);
+                } else {
+                    ops[i].value = user_bde->iproc_read(d, ops[i].addr);
+                    if (ops[i].value == -1) {
+                        rv = -1;
+                    }
+                }
+                break;
+            case LUBDE_REG_OP_IPROC_WRITE:
+                rv = user_bde->iproc_write(d, ops[i].addr, ops[i].value);
+                break;
+            default:
+                rv = -1;
+                break;
+            }
+        }
+        if (rv != 0) {
+            /* Do not count the failed entry */
+            i--;
+        }
+        if (copy_to_user(uops + *done, ops, i * sizeof(ops[0]))) {
+            return -EFAULT;
+        }
+        *done += i;
+    }
+
+    return rv == 0 ? 0 : -1;
+}
+
 /*
  * Function: _ioctl
  *
@@ -1202,6 +1342,9 @@ _ioctl(unsigned int cmd, unsigned long arg)
     int inst_id;
     bde_inst_resource_t *res;
     uint32_t *mapaddr;
+    struct eventfd_ctx *efd, *old_efd;
+    unsigned long flags;
+    int ret;
 
     if (copy_from_user(&io, (void *)arg, sizeof(io))) {
         return -EFAULT;
@@ -1347,6 +1490,66 @@ _ioctl(unsigned int cmd, unsigned long arg)
             atomic_set(&_ether_interrupt_has_taken_place, 0);
         }
         break;
+    case LUBDE_WAIT_FOR_INTERRUPT_EVENTS:
+        if (!VALID_DEVICE(io.dev) ||
+            !(_devices[io.dev].dev_type & BDE_SWITCH_DEV_TYPE)) {
+            return -EINVAL;
+        }
+        res = &_bde_inst_resource[_devices[io.dev].inst];
+        res->intr_events = 1;
+#ifdef BDE_LINUX_NON_INTERRUPTIBLE
+        wait_event_timeout(res->intr_wq,
+                           atomic_read(&res->intr) != 0, 100);
+#else
+        wait_event_interruptible(res->intr_wq,
+                                 atomic_read(&res->intr) != 0);
+#endif
+        atomic_set(&res->intr, 0);
+        /* Hand over everything collected since the last wait */
+        spin_lock_irqsave(&res->intr_lock, flags);
+        io.d0 = res->intr_cnt;
+        io.d1 = LUBDE_INTR_STAT_WORDS;
+        io.d2 = (unsigned int)res->intr_ts;
+        io.d3 = (unsigned int)(res->intr_ts >> 32);
+        memcpy(io.dx.intr_stat, res->intr_stat, sizeof(io.dx.intr_stat));
+        memset(res->intr_stat, 0, sizeof(res->intr_stat));
+        res->intr_cnt = 0;
+        spin_unlock_irqrestore(&res->intr_lock, flags);
+        break;
+    case LUBDE_GET_IRQ_VECTORS:
+        if (!VALID_DEVICE(io.dev)) {
+            return -EINVAL;
+        }
+        io.d0 = 0;
+        ret = lkbde_irq_vector_get(io.dev, io.dx.irqs, LUBDE_IRQ_VEC_MAX);
+        if (ret < 0) {
+            io.rc = LUBDE_FAIL;
+        } else {
+            io.d0 = ret;
+        }
+        break;
+    case LUBDE_INTR_EVENTFD:
+        if (!VALID_DEVICE(io.dev) ||
+            !(_devices[io.dev].dev_type & BDE_SWITCH_DEV_TYPE)) {
+            return -EINVAL;
+        }
+        res = &_bde_inst_resource[_devices[io.dev].inst];
+        efd = NULL;
+        if ((int)io.d0 >= 0) {
+            efd = eventfd_ctx_fdget((int)io.d0);
+            if (IS_ERR(efd)) {
+                io.rc = LUBDE_FAIL;
+                break;
+            }
+        }
+        spin_lock_irqsave(&res->intr_lock, flags);
+        old_efd = res->intr_efd;
+        res->intr_efd = efd;
+        spin_unlock_irqrestore(&res->intr_lock, flags);
+        if (old_efd) {
+            eventfd_ctx_put(old_efd);
+        }
+        break;
     case LUBDE_USLEEP:
     case LUBDE_UDELAY:
     case LUBDE_SEM_OP:
@@ -1432,6 +1635,20 @@ _ioctl(unsigned int cmd, unsigned long arg)
             io.rc = LUBDE_FAIL;
         }
         break;
+    case LUBDE_REG_BATCH:
+        if (!VALID_DEVICE(io.dev) || io.d0 > LUBDE_REG_BATCH_MAX) {
+            return -EINVAL;
+        }
+        ret = _reg_batch(io.dev,
+                         (lubde_reg_op_t __user *)(unsigned long)io.p0,
+                         io.d0, &io.d1);
+        if (ret == -EFAULT) {
+            return ret;
+        }
+        if (ret < 0) {
+            io.rc = LUBDE_FAIL;
+        }
+        break;
     case LUBDE_ATTACH_INSTANCE:
         io.rc = _instance_attach(io.d0, io.d1);
         break;
@@ -35,6 +35,12 @@ typedef uint64_t bde_kernel_addr_t;
 typedef uint32_t bde_kernel_addr_t;
 #endif
 
+/* Interrupt status words returned by LUBDE_WAIT_FOR_INTERRUPT_EVENTS */
+#define LUBDE_INTR_STAT_WORDS 8
+
+/* Interrupt vectors returned by LUBDE_GET_IRQ_VECTORS */
+#define LUBDE_IRQ_VEC_MAX 16
+
 /* Ioctl control structure */
 typedef struct  {
     unsigned int dev;   /* Device ID */
@@ -46,6 +52,8 @@ typedef struct  {
     bde_kernel_addr_t p0;
     union {
         unsigned int dw[2];
+        unsigned int intr_stat[LUBDE_INTR_STAT_WORDS];
+        int irqs[LUBDE_IRQ_VEC_MAX];
         unsigned char buf[64];
     } dx;
 } lubde_ioctl_t;
@@ -82,12 +90,32 @@ typedef struct  {
 #define LUBDE_ATTACH_INSTANCE     _IO(LUBDE_MAGIC, 29)
 #define LUBDE_GET_DEVICE_STATE    _IO(LUBDE_MAGIC, 30)
 #define LUBDE_REPROBE             _IO(LUBDE_MAGIC, 31)
+#define LUBDE_WAIT_FOR_INTERRUPT_EVENTS _IO(LUBDE_MAGIC, 32)
+#define LUBDE_INTR_EVENTFD        _IO(LUBDE_MAGIC, 33)
+#define LUBDE_GET_IRQ_VECTORS     _IO(LUBDE_MAGIC, 34)
+#define LUBDE_REG_BATCH           _IO(LUBDE_MAGIC, 35)
 
 #define LUBDE_SEM_OP_CREATE       1
 #define LUBDE_SEM_OP_DESTROY      2
 #define LUBDE_SEM_OP_TAKE         3
 #define LUBDE_SEM_OP_GIVE         4
 
+/* Register access operations for LUBDE_REG_BATCH */
+#define LUBDE_REG_OP_READ         0
+#define LUBDE_REG_OP_WRITE        1
+#define LUBDE_REG_OP_IPROC_READ   2
+#define LUBDE_REG_OP_IPROC_WRITE  3
+
+/* Maximum number of operations in one LUBDE_REG_BATCH call */
+#define LUBDE_REG_BATCH_MAX       4096
+
+/* Register access for LUBDE_REG_BATCH */
+typedef struct {
+    unsigned int op;    /* LUBDE_REG_OP_xxx */
+    unsigned int addr;  /* Register address */
+    unsigned int value; /* Value to write or value read */
+} lubde_reg_op_t;
+
 #define LUBDE_SUCCESS 0
 #define LUBDE_FAIL ((unsigned int)-1)
 
@@ -96,8 +124,21 @@ typedef struct  {
  * Version history
  * 1: add LUBDE_GET_DEVICE_STATE to support PCI hot plug 
  * 2: add LUBDE_REPROBE to support reprobe available devices
+ * 3: add LUBDE_WAIT_FOR_INTERRUPT_EVENTS and LUBDE_INTR_EVENTFD
+ *    LUBDE_WAIT_FOR_INTERRUPT_EVENTS returns the number of interrupts
+ *    since the last wait in d0, the number of status words in d1, the
+ *    time of the last interrupt in ns in d2 (low) and d3 (high), and
+ *    the interrupt status bits seen by the ISR in dx.intr_stat.
+ *    LUBDE_INTR_EVENTFD makes every interrupt signal the eventfd in d0,
+ *    or stops signaling if d0 is -1.
+ * 4: add LUBDE_GET_IRQ_VECTORS. Returns the number of interrupt vectors
+ *    in d0 and their Linux IRQ numbers in dx.irqs.
+ * 5: add LUBDE_REG_BATCH. Executes the d0 lubde_reg_op_t entries at the
+ *    user address p0 in order and writes back the values read. Returns
+ *    the number of completed entries in d1 and stops at the first
+ *    failing entry.
  */
-#define KBDE_VERSION    2
+#define KBDE_VERSION    5
 
 
 /* This is the signal that will be used
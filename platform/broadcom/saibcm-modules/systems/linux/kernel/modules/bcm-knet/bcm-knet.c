@@ -75,6 +75,29 @@
 #include <linux/random.h>
 #include <linux/seq_file.h>
 #include <linux/if_vlan.h>
+#include <linux/jhash.h>
+#include <linux/rculist.h>
+#include <linux/mutex.h>
+#include <linux/delay.h>
+#include <linux/math64.h>
+#include <linux/vmalloc.h>
+#include <linux/eventfd.h>
+#include <linux/percpu.h>
+#include <linux/timex.h>
+#include <asm/unaligned.h>
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0))
+#include <net/busy_poll.h>
+#endif
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,19,0))
+#define BKN_XDP_SUPPORT
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <net/xdp.h>
+#endif
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,10,0))
+#define BKN_GENL_SUPPORT
+#include <net/genetlink.h>
+#endif
 
 
 MODULE_AUTHOR("Broadcom Corporation");
@@ -171,6 +194,93 @@ LKM_MOD_PARAM(basedev_suspend, "i", int, 0);
 MODULE_PARM_DESC(basedev_suspend,
 "Pause traffic till base device is up (enabled by default in NAPI mode)");
 
+/*
+ * Receive into order-0 pages and scatter frames larger than a page over
+ * multiple DCBs, such that jumbo frames need no high-order allocations.
+ * Not supported on DNX/DPP devices.
+ */
+static int rx_sg_pages = 0;
+LKM_MOD_PARAM(rx_sg_pages, "i", int, 0);
+MODULE_PARM_DESC(rx_sg_pages,
+"Use page sized Rx buffers with scatter DMA for large frames (default 0)");
+
+static int rx_copybreak = 256;
+LKM_MOD_PARAM(rx_copybreak, "i", int, 0);
+MODULE_PARM_DESC(rx_copybreak,
+"Copy Rx packets up to this size and recycle the DMA buffer (default 256)");
+
+static int tx_dcbs = 64;
+LKM_MOD_PARAM(tx_dcbs, "i", int, 0);
+MODULE_PARM_DESC(tx_dcbs,
+"Number of DCBs in the Tx DMA ring (default 64)");
+
+static int rx_dcbs = 64;
+LKM_MOD_PARAM(rx_dcbs, "i", int, 0);
+MODULE_PARM_DESC(rx_dcbs,
+"Number of DCBs in each Rx DMA ring (default 64)");
+
+static int api_rx_ring = 1024;
+LKM_MOD_PARAM(api_rx_ring, "i", int, 0);
+MODULE_PARM_DESC(api_rx_ring,
+"Entries in the shared Rx API completion ring, power of two, 0 to disable (default 1024)");
+
+static int use_tx_sg = 1;
+LKM_MOD_PARAM(use_tx_sg, "i", int, 0);
+MODULE_PARM_DESC(use_tx_sg,
+"Transmit fragmented packets using scatter-gather DCBs (default 1)");
+
+static int use_rx_mq = 1;
+LKM_MOD_PARAM(use_rx_mq, "i", int, 0);
+MODULE_PARM_DESC(use_rx_mq,
+"Expose one Rx queue per Rx DMA channel on network interfaces (default 1)");
+
+static int tx_ts_retry_us = 20;
+LKM_MOD_PARAM(tx_ts_retry_us, "i", int, 0);
+MODULE_PARM_DESC(tx_ts_retry_us,
+"Interval between Tx timestamp retrievals not ready at Tx completion in usecs (default 20)");
+
+static int tx_ts_retries = 50;
+LKM_MOD_PARAM(tx_ts_retries, "i", int, 0);
+MODULE_PARM_DESC(tx_ts_retries,
+"Tx timestamp retrievals before the timestamp is counted as missed (default 50)");
+
+/* MSI-X vector for packet DMA interrupts */
+static int msix_vec = 0;
+LKM_MOD_PARAM(msix_vec, "i", int, 0);
+MODULE_PARM_DESC(msix_vec,
+"Dedicated MSI-X vector for packet DMA interrupts, 0 shares vector 0 (default 0)");
+
+/* Rx filter lookup cost sampling */
+static int rx_filter_sample = 64;
+LKM_MOD_PARAM(rx_filter_sample, "i", int, 0);
+MODULE_PARM_DESC(rx_filter_sample,
+"Measure the CPU cycles of one in this many Rx filter lookups, 0 disables (default 64)");
+
+/* Generic netlink netif statistics events */
+static int genl_stats_interval = 0;
+LKM_MOD_PARAM(genl_stats_interval, "i", int, 0);
+MODULE_PARM_DESC(genl_stats_interval,
+"Interval of netif statistics events on the generic netlink events group in msecs, 0 disables (default 0)");
+
+/*
+ * Network interfaces get one Rx queue per Rx DMA channel, such that
+ * RPS/RFS can steer the traffic of each channel to its own CPU set
+ * through /sys/class/net/<dev>/queues/rx-<chan>/rps_cpus.
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,38))
+#define bkn_alloc_etherdev(_sz) \
+    (use_rx_mq ? alloc_etherdev_mqs(_sz, 1, NUM_RX_CHAN) : alloc_etherdev(_sz))
+#else
+#define bkn_alloc_etherdev(_sz) alloc_etherdev(_sz)
+#endif
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,30))
+#define bkn_skb_record_rx_queue(_skb, _chan) \
+    do { if (use_rx_mq) skb_record_rx_queue(_skb, _chan); } while (0)
+#else
+#define bkn_skb_record_rx_queue(_skb, _chan)
+#endif
+
 /* Debug levels */
 #define DBG_LVL_VERB    0x1
 #define DBG_LVL_DCB     0x2
@@ -241,6 +351,17 @@ LKM_MOD_PARAM(napi_weight, "i", int, 0);
 MODULE_PARM_DESC(napi_weight,
 "Weight of NAPI interfaces (default 64)");
 
+static int use_gro = 0;
+LKM_MOD_PARAM(use_gro, "i", int, 0);
+MODULE_PARM_DESC(use_gro,
+"Use GRO for NAPI receive, per netif GRO is set via ethtool (default 0)");
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,29)
+#define bkn_napi_gro_receive(_napi, _skb) netif_receive_skb(_skb)
+#else
+#define bkn_napi_gro_receive(_napi, _skb) napi_gro_receive(_napi, _skb)
+#endif
+
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2,6,24)
 #define bkn_napi_enable(_dev, _napi) netif_poll_enable(_dev)
 #define bkn_napi_disable(_dev, _napi) netif_poll_disable(_dev)
@@ -261,6 +382,9 @@ MODULE_PARM_DESC(napi_weight,
 
 static int use_napi = 0;
 static int napi_weight = 0;
+static int use_gro = 0;
+
+#define bkn_napi_gro_receive(_napi, _skb) netif_receive_skb(_skb)
 
 #define bkn_napi_enable(_dev, _napi)
 #define bkn_napi_disable(_dev, _napi)
@@ -469,6 +593,10 @@ static inline void bkn_skb_tx_timestamp(struct sk_buff *skb)
 #define DMA_TODEV                       DMA_TO_DEVICE
 #define DMA_MAP_SINGLE(d,p,s,r)         dma_map_single(d,p,s,r)
 #define DMA_UNMAP_SINGLE(d,a,s,r)       dma_unmap_single(d,a,s,r)
+#define DMA_MAP_PAGE(d,p,o,s,r)         dma_map_page(d,p,o,s,r)
+#define DMA_UNMAP_PAGE(d,a,s,r)         dma_unmap_page(d,a,s,r)
+#define DMA_SYNC_FOR_CPU(d,a,s,r)       dma_sync_single_for_cpu(d,a,s,r)
+#define DMA_SYNC_FOR_DEV(d,a,s,r)       dma_sync_single_for_device(d,a,s,r)
 #define DMA_ALLOC_COHERENT(d,s,h)       dma_alloc_coherent(d,s,h,GFP_ATOMIC|GFP_DMA32)
 #define DMA_FREE_COHERENT(d,s,a,h)      dma_free_coherent(d,s,a,h)
 #define DMA_MAPPING_ERROR(d,a)          bkn_dma_mapping_error(d,a)
@@ -478,6 +606,10 @@ static inline void bkn_skb_tx_timestamp(struct sk_buff *skb)
 #define DMA_TODEV                       PCI_DMA_TODEVICE
 #define DMA_MAP_SINGLE(d,p,s,r)         pci_map_single(d,p,s,r)
 #define DMA_UNMAP_SINGLE(d,a,s,r)       pci_unmap_single(d,a,s,r)
+#define DMA_MAP_PAGE(d,p,o,s,r)         pci_map_page(d,p,o,s,r)
+#define DMA_UNMAP_PAGE(d,a,s,r)         pci_unmap_page(d,a,s,r)
+#define DMA_SYNC_FOR_CPU(d,a,s,r)       pci_dma_sync_single_for_cpu(d,a,s,r)
+#define DMA_SYNC_FOR_DEV(d,a,s,r)       pci_dma_sync_single_for_device(d,a,s,r)
 #define DMA_ALLOC_COHERENT(d,s,h)       pci_alloc_consistent(d,s,h)
 #define DMA_FREE_COHERENT(d,s,a,h)      pci_free_consistent(d,s,a,h)
 #define DMA_MAPPING_ERROR(d,a)          bkn_pci_dma_mapping_error(d,a)
@@ -510,6 +642,8 @@ typedef struct bkn_desc_info_s {
     struct sk_buff *skb;
     uint64_t skb_dma;
     uint32_t dma_size;
+    int dma_page;               /* skb_dma maps an skb page fragment */
+    struct page *page;          /* Rx page buffer (scatter Rx) */
 } bkn_desc_info_t;
 
 /* DCB chain info */
@@ -521,8 +655,11 @@ typedef struct bkn_dcb_chain_s {
     uint64_t dcb_dma;
 } bkn_dcb_chain_t;
 
-#define MAX_TX_DCBS 64
-#define MAX_RX_DCBS 64
+/* DMA ring sizes are set through the tx_dcbs/rx_dcbs module parameters */
+#define MIN_DCBS    16
+#define MAX_DCBS    4096
+#define MAX_TX_DCBS tx_dcbs
+#define MAX_RX_DCBS rx_dcbs
 
 #define NUM_DMA_CHAN 8
 #define NUM_RX_CHAN 7
@@ -532,13 +669,87 @@ typedef struct bkn_dcb_chain_s {
 #define FCS_SZ 4
 #define TAG_SZ 4
 
+/*
+ * Scatter-gather Tx sends the linear part and each page fragment of an
+ * skb from consecutive DCBs, terminated by a DCB pointing at a zeroed
+ * FCS pad area behind the DCB rings. Only used in Continuous DMA mode.
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,2,0))
+#define BKN_TX_SG
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,4,0))
+#define bkn_skb_frag_off(_frag) skb_frag_off(_frag)
+#else
+#define bkn_skb_frag_off(_frag) ((_frag)->page_offset)
+#endif
+#endif
+
+/* Packet headers which must be in the linear part of a fragmented skb */
+#define BKN_TX_SG_PULL_SZ (RCPU_HDR_SIZE + RCPU_TX_META_SIZE + 16 + TAG_SZ)
+
+/*
+ * Rx rate control runs off a high-resolution timer where available, so
+ * token refill is not quantized to jiffies (4 ms at HZ=250).
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,28))
+#define BKN_RX_HRTIMER
+#include <linux/hrtimer.h>
+#endif
+#define BKN_RXTICKS_MAX 10000   /* Max Rx rate control updates per second */
+
+/*
+ * Tx skbs waiting for a hardware timestamp. The timestamp is retrieved
+ * from the Tx completion context, and timestamps which are not ready
+ * yet are retried from a high-resolution timer.
+ */
+#define BKN_TX_TS_RING_SIZE     64      /* Must be a power of two */
+#define BKN_TX_TS_PORT_MAX      512     /* Ports with Tx timestamp stats */
+
+typedef struct bkn_tx_ts_stats_s {
+    uint32_t ok;                /* Taken at Tx completion */
+    uint32_t late;              /* Taken by a later retry */
+    uint32_t missed;            /* Never taken or ring full */
+} bkn_tx_ts_stats_t;
+
+/* Netif ID lookup table, replaced as a whole when it needs to grow */
+typedef struct bkn_ndev_table_s {
+    int ndev_max;               /* Size of indexed array */
+    struct net_device *ndevs[0];
+} bkn_ndev_table_t;
+
+/*
+ * Rx packet dispatch looks up filters and netifs under RCU only. The
+ * netif list, the filter list and the filter groups are updated under
+ * cfg_lock, and removed entries are freed after a grace period, such
+ * that netif and filter configuration never holds the main lock.
+ */
+
+/*
+ * Rx filter lookup statistics, kept per CPU. The walk depth is the
+ * number of filters compared by a lookup, bucket n of the histogram
+ * counts depths of [2^(n-1), 2^n), the last one all above.
+ */
+#define BKN_RXF_DEPTH_BUCKETS   8
+
+typedef struct bkn_rxf_stats_s {
+    u64 lookups;                /* Rx filter lookups */
+    u64 no_match;               /* Lookups matching no filter */
+    u64 depth[BKN_RXF_DEPTH_BUCKETS]; /* Walk depth histogram */
+    u64 samples;                /* Lookups with measured cycles */
+    u64 cycles;                 /* Sum of measured cycles */
+    u64 max_cycles;             /* Longest measured lookup */
+    int sample_left;            /* Lookups until the next measurement */
+} bkn_rxf_stats_t;
+
 /* Device control info */
 typedef struct bkn_switch_info_s {
     struct list_head list;
     struct list_head ndev_list; /* Associated virtual Ethernet interfaces */
-    struct net_device **ndevs;  /* Indexed array of ndev_list */
-    int ndev_max;               /* Size of indexed array */
+    bkn_ndev_table_t *ndev_table; /* Indexed array of ndev_list */
     struct list_head rxpf_list; /* Associated Rx packet filters */
+    struct list_head rxpf_groups; /* Rx filters grouped by match shape */
+    uint64_t rxpf_gen;          /* Creation counter for filter sort keys */
+    bkn_rxf_stats_t __percpu *rxf_stats; /* Rx filter lookup statistics */
+    spinlock_t cfg_lock;        /* Netif and filter configuration lock */
     volatile void *base_addr;   /* Base address for PCI register access */
     struct DMA_DEV *dma_dev;    /* Required for DMA memory control */
     struct pci_dev *pdev;       /* Required for DMA memory control */
@@ -547,7 +758,12 @@ typedef struct bkn_switch_info_s {
     struct timer_list timer;    /* Retry/resource timer */
     int timer_queued;           /* Flag indicating queued timer function */
     uint32_t timer_runs;        /* Timer function runs (debug only) */
+#ifdef BKN_RX_HRTIMER
+    struct hrtimer rxtick;      /* Rx rate control timer */
+    ktime_t rxtick_period;      /* Time between updates */
+#else
     struct timer_list rxtick;   /* Rx rate control timer */
+#endif
     uint32_t rxticks_per_sec;   /* Rx rate control update frequency */
     uint32_t rxtick_jiffies;    /* Time between updates (in jiffies) */
     uint32_t rxticks;           /* Rx rate control debug counter */
@@ -564,6 +780,7 @@ typedef struct bkn_switch_info_s {
     uint32_t pph_lif_ext_size[8];   /* Size of PPH Lif extension header */
     uint8_t  udh_enable;            /* Indicates UDH existence */
     uint32_t udh_length_type[4];    /* Size of UDH header per type */
+    const struct bkn_dnx_pph_layout_s *dnx_pph; /* PPH base field layout */
     int rx_chans;               /* Number of Rx channels */
     uint32_t dma_hi;            /* DMA higher address */
     uint32_t cmic_type;         /* CMIC type (CMICe or CMICm) */
@@ -571,6 +788,13 @@ typedef struct bkn_switch_info_s {
     uint32_t napi_poll_mode;    /* NAPI is in polling mode */
     uint32_t napi_not_done;     /* NAPI poll did not process all packets */
     uint32_t napi_poll_again;   /* Used if DCB chain is restarted */
+#ifdef BKN_RX_HRTIMER
+    struct hrtimer coal_timer;  /* Interrupt hold-off timer (NAPI only) */
+#endif
+    uint32_t rx_coal_usecs;     /* Interrupt hold-off after NAPI poll */
+    uint32_t coal_holdoff;      /* Interrupts held off, timer pending */
+    uint32_t coal_polls;        /* Polls triggered by hold-off timer */
+    uint64_t perf_rx_ts;        /* Rx interrupt time for perf harness */
     uint32_t tx_yield;          /* Tx schedule for Continuous DMA and Non-NAPI mode */
     void *dcb_mem;              /* Logical pointer to DCB memory */
     uint64_t dcb_dma;           /* Physical bus address for DCB memory */
@@ -583,17 +807,36 @@ typedef struct bkn_switch_info_s {
     uint32_t inst_id;           /* Instance id of this device */
     int evt_idx;                /* Event queue index for this device*/
     int basedev_suspended;      /* Base device suspended */
+    int rx_sg;                  /* Scatter Rx into page buffers */
+    int wb_retained;            /* Netifs/filters retained for SDK restart */
+    uint32_t wb_generation;     /* Generation of retained netifs/filters */
+    int msix_vec;               /* Connected MSI-X vector, 0 if none */
     int tx_hwts;                /* HW timestamp for Tx */
     int rx_hwts;                /* HW timestamp for Rx */
-    struct sk_buff_head tx_ptp_queue;   /* Tx PTP skb queue */
-    struct work_struct tx_ptp_work;     /* Tx PTP work */
     struct {
-        bkn_desc_info_t desc[MAX_TX_DCBS+1];
+        struct sk_buff *skb[BKN_TX_TS_RING_SIZE]; /* Pending Tx PTP skbs */
+        unsigned int head;      /* Next pending entry */
+        unsigned int tail;      /* Next free entry */
+        int retries;            /* Retries of the head entry */
+#ifdef BKN_RX_HRTIMER
+        struct hrtimer timer;   /* Retry timer */
+        int timer_armed;        /* Retry timer is running */
+#endif
+        bkn_tx_ts_stats_t total;
+        bkn_tx_ts_stats_t port[BKN_TX_TS_PORT_MAX];
+    } tx_ts;
+    struct {
+        bkn_desc_info_t *desc;  /* MAX_TX_DCBS+1 descriptors */
         int free;               /* Number of free Tx DCBs */
         int cur;                /* Index of current Tx DCB */
         int dirty;              /* Index of next Tx DCB to complete */
         int api_active;         /* BCM Tx API is in progress */
         int suspends;           /* Calls to netif_stop_queue (debug only) */
+        int doorbell_pending;   /* DCBs added without moving halt location */
+        uint32_t doorbells;     /* Halt location updates (debug only) */
+        uint64_t fcs_dma;       /* FCS pad area for scatter-gather Tx */
+        uint32_t sg_pkts;       /* Scatter-gather Tx packets (debug only) */
+        uint32_t sg_linearize;  /* Fragmented skbs linearized (debug only) */
         struct list_head api_dcb_list; /* Tx DCB chains from BCM Tx API */
         bkn_dcb_chain_t *api_dcb_chain; /* Current Tx DCB chain */
         bkn_dcb_chain_t *api_dcb_chain_end; /* Tx DCB chain end */
@@ -609,7 +852,7 @@ typedef struct bkn_switch_info_s {
         uint32_t pkts_d_over_limit; /* Tx drop - length is out of range */
     } tx;
     struct {
-        bkn_desc_info_t desc[MAX_RX_DCBS+1];
+        bkn_desc_info_t *desc;  /* MAX_RX_DCBS+1 descriptors */
         int free;               /* Number of free Rx DCBs */
         int cur;                /* Index of current Rx DCB */
         int dirty;              /* Index of next Rx DCB to complete */
@@ -625,6 +868,7 @@ typedef struct bkn_switch_info_s {
         uint32_t tokens;        /* Tokens for Rx rate control */
         uint32_t rate;          /* Current packet rate */
         unsigned long tok_jif;  /* Jiffies at last token update */
+        uint64_t tok_ns;        /* Time at last token update (hrtimer) */
         unsigned long rate_jif; /* Jiffies at last rate update */
         struct list_head api_dcb_list; /* Rx DCB chains from BCM Rx API */
         bkn_dcb_chain_t *api_dcb_chain; /* Current Rx DCB chain */
@@ -642,7 +886,26 @@ typedef struct bkn_switch_info_s {
         uint32_t pkts_d_callback;   /* Rx drop - consumed by call-back */
         uint32_t pkts_d_no_link;    /* Rx drop - software link down */
         uint32_t pkts_d_no_api_buf; /* Rx drop - no API buffers */
+        uint32_t bufs_reuse;        /* Rx refill with recycled DMA buffer */
+        uint32_t bufs_alloc;        /* Rx refill with new DMA buffer */
+        uint32_t rate_pauses;       /* Rx DMA paused by rate control */
+        uint32_t pkts_d_xdp;        /* Rx drop - XDP program */
+        uint32_t pkts_d_sg;         /* Rx drop - incomplete scatter frame */
+        uint32_t pkts_d_policed;    /* Rx drop - filter policer */
+        struct sk_buff *sg_skb;     /* Scatter frame being received */
+        uint32_t sg_stat;           /* Accumulated DCB status of sg_skb */
     } rx[NUM_RX_CHAN];
+    struct {
+        kcom_dma_ring_hdr_t *hdr; /* Shared ring, kept until device removal */
+        kcom_dma_ring_entry_t *entry; /* Ring entries after the header */
+        int map_size;           /* Size of the shared ring in bytes */
+        int active;             /* Rx API completions go to the ring */
+        struct eventfd_ctx *evfd; /* Notification eventfd, NULL if none */
+        uint32_t prod;          /* Next entry to write */
+        uint32_t pub;           /* Producer index seen by the application */
+        int overflow;           /* DCBs not published since the last kick */
+        uint32_t kicks;         /* Notifications sent (debug only) */
+    } api_ring;
 } bkn_switch_info_t;
 
 /* PTCH_2 */
@@ -823,6 +1086,189 @@ typedef struct bkn_dune_system_header_info_s {
     uint32_t fhei_type;                       /* FHEI: Type */
 } bkn_dune_system_header_info_t;
 
+/*
+ * System header field extraction. Field positions are given as the
+ * bit offset of the field MSB from the start of the header. Each
+ * field is precomputed into the byte offset of a 64-bit big-endian
+ * window, a shift and a mask, so that it takes a single load instead
+ * of a bit-by-bit copy.
+ */
+typedef struct bkn_hdr_fld_s {
+    uint16_t offs;              /* Byte offset of 64-bit window */
+    uint8_t shift;              /* Position of field LSB in window */
+    uint32_t mask;              /* Field mask after shift */
+} bkn_hdr_fld_t;
+
+#define BKN_HDR_FLD(_msb, _nbits) \
+    { (_msb) / 8, 64 - ((_msb) % 8) - (_nbits), \
+      (uint32_t)((1ULL << (_nbits)) - 1) }
+
+/* DNX FTMH base header */
+enum {
+    BKN_DNX_FTMH_F_SPA,
+    BKN_DNX_FTMH_F_TSH_EN,
+    BKN_DNX_FTMH_F_PPH_EN,
+    BKN_DNX_FTMH_F_TM_DST_EXT,
+    BKN_DNX_FTMH_F_APP_SPECIFIC_EXT,
+    BKN_DNX_FTMH_F_FLOW_ID_EXT,
+    BKN_DNX_FTMH_F_BIER_BFR_EXT,
+    BKN_DNX_FTMH_F_COUNT
+};
+
+static const bkn_hdr_fld_t bkn_dnx_ftmh_flds[BKN_DNX_FTMH_F_COUNT] = {
+    [BKN_DNX_FTMH_F_SPA] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_SRC_SYS_PORT_AGGREGATE_MSB,
+                    BKN_DNX_FTMH_SRC_SYS_PORT_AGGREGATE_NOF_BITS),
+    [BKN_DNX_FTMH_F_TSH_EN] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_PPH_TYPE_IS_TSH_EN_MSB,
+                    BKN_DNX_FTMH_PPH_TYPE_IS_TSH_EN_NOF_BITS),
+    [BKN_DNX_FTMH_F_PPH_EN] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_PPH_TYPE_IS_PPH_EN_MSB,
+                    BKN_DNX_FTMH_PPH_TYPE_IS_PPH_EN_NOF_BITS),
+    [BKN_DNX_FTMH_F_TM_DST_EXT] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_TM_DST_EXT_PRESENT_MSB,
+                    BKN_DNX_FTMH_TM_DST_EXT_PRESENT_NOF_BITS),
+    [BKN_DNX_FTMH_F_APP_SPECIFIC_EXT] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_APP_SPECIFIC_EXT_SIZE_MSB,
+                    BKN_DNX_FTMH_APP_SPECIFIC_EXT_SIZE_NOF_BITS),
+    [BKN_DNX_FTMH_F_FLOW_ID_EXT] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_FLOW_ID_EXT_SIZE_MSB,
+                    BKN_DNX_FTMH_FLOW_ID_EXT_SIZE_NOF_BITS),
+    [BKN_DNX_FTMH_F_BIER_BFR_EXT] =
+        BKN_HDR_FLD(BKN_DNX_FTMH_BIER_BFR_EXT_SIZE_MSB,
+                    BKN_DNX_FTMH_BIER_BFR_EXT_SIZE_NOF_BITS),
+};
+
+/* DNX PPH base header, layout depends on the PPH base size */
+enum {
+    BKN_DNX_PPH_F_FORWARD_DOMAIN,
+    BKN_DNX_PPH_F_LEARN_EXT_PRESENT,
+    BKN_DNX_PPH_F_FHEI_SIZE,
+    BKN_DNX_PPH_F_LIF_EXT_TYPE,
+    BKN_DNX_PPH_F_COUNT
+};
+
+typedef struct bkn_dnx_pph_layout_s {
+    uint32_t base_size;
+    bkn_hdr_fld_t fld[BKN_DNX_PPH_F_COUNT];
+} bkn_dnx_pph_layout_t;
+
+#define BKN_DNX_PPH_LAYOUT(_t) { \
+    BKN_DNX_PPH_BASE_TYPE_##_t, { \
+    [BKN_DNX_PPH_F_FORWARD_DOMAIN] = \
+        BKN_HDR_FLD(BKN_DNX_PPH_##_t##_FORWARD_DOMAIN_MSB, \
+                    BKN_DNX_PPH_##_t##_FORWARD_DOMAIN_NOF_BITS), \
+    [BKN_DNX_PPH_F_LEARN_EXT_PRESENT] = \
+        BKN_HDR_FLD(BKN_DNX_PPH_##_t##_LEARN_EXT_PRESENT_MSB, \
+                    BKN_DNX_PPH_##_t##_LEARN_EXT_PRESENT_NOF_BITS), \
+    [BKN_DNX_PPH_F_FHEI_SIZE] = \
+        BKN_HDR_FLD(BKN_DNX_PPH_##_t##_FHEI_SIZE_MSB, \
+                    BKN_DNX_PPH_##_t##_FHEI_SIZE_NOF_BITS), \
+    [BKN_DNX_PPH_F_LIF_EXT_TYPE] = \
+        BKN_HDR_FLD(BKN_DNX_PPH_##_t##_LIF_EXT_TYPE_MSB, \
+                    BKN_DNX_PPH_##_t##_LIF_EXT_TYPE_NOF_BITS) } }
+
+static const bkn_dnx_pph_layout_t bkn_dnx_pph9_layout = BKN_DNX_PPH_LAYOUT(9);
+static const bkn_dnx_pph_layout_t bkn_dnx_pph10_layout = BKN_DNX_PPH_LAYOUT(10);
+static const bkn_dnx_pph_layout_t bkn_dnx_pph12_layout = BKN_DNX_PPH_LAYOUT(12);
+
+/* DNX 5-byte FHEI */
+enum {
+    BKN_DNX_FHEI_F_TYPE,
+    BKN_DNX_FHEI_F_QUALIFIER,
+    BKN_DNX_FHEI_F_CODE,
+    BKN_DNX_FHEI_F_COUNT
+};
+
+static const bkn_hdr_fld_t bkn_dnx_fhei_flds[BKN_DNX_FHEI_F_COUNT] = {
+    [BKN_DNX_FHEI_F_TYPE] =
+        BKN_HDR_FLD(BKN_DNX_PPH_FHEI_TRAP_5B_TYPE_MSB,
+                    BKN_DNX_PPH_FHEI_TRAP_5B_TYPE_NOF_BITS),
+    [BKN_DNX_FHEI_F_QUALIFIER] =
+        BKN_HDR_FLD(BKN_DNX_PPH_FHEI_TRAP_5B_QUALIFIER_MSB,
+                    BKN_DNX_PPH_FHEI_TRAP_5B_QUALIFIER_NOF_BITS),
+    [BKN_DNX_FHEI_F_CODE] =
+        BKN_HDR_FLD(BKN_DNX_PPH_FHEI_TRAP_5B_CODE_MSB,
+                    BKN_DNX_PPH_FHEI_TRAP_5B_CODE_NOF_BITS),
+};
+
+/* DNX UDH base header */
+#define BKN_DNX_UDH_F_COUNT     4
+
+static const bkn_hdr_fld_t bkn_dnx_udh_flds[BKN_DNX_UDH_F_COUNT] = {
+    BKN_HDR_FLD(BKN_DNX_UDH_DATA_TYPE_0_MSB, BKN_DNX_UDH_DATA_TYPE_0_NOF_BITS),
+    BKN_HDR_FLD(BKN_DNX_UDH_DATA_TYPE_1_MSB, BKN_DNX_UDH_DATA_TYPE_1_NOF_BITS),
+    BKN_HDR_FLD(BKN_DNX_UDH_DATA_TYPE_2_MSB, BKN_DNX_UDH_DATA_TYPE_2_NOF_BITS),
+    BKN_HDR_FLD(BKN_DNX_UDH_DATA_TYPE_3_MSB, BKN_DNX_UDH_DATA_TYPE_3_NOF_BITS),
+};
+
+/* DPP FTMH */
+enum {
+    BKN_DPP_FTMH_F_PKT_SIZE,
+    BKN_DPP_FTMH_F_TC,
+    BKN_DPP_FTMH_F_SRC_SYS_PORT,
+    BKN_DPP_FTMH_F_ACTION_TYPE,
+    BKN_DPP_FTMH_F_PPH_TYPE,
+    BKN_DPP_FTMH_F_DSP_EXIST,
+    BKN_DPP_FTMH_F_COUNT
+};
+
+static const bkn_hdr_fld_t bkn_dpp_ftmh_flds[BKN_DPP_FTMH_F_COUNT] = {
+    [BKN_DPP_FTMH_F_PKT_SIZE] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_PKT_SIZE_MSB, BKN_DPP_FTMH_PKT_SIZE_NOF_BITS),
+    [BKN_DPP_FTMH_F_TC] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_TC_MSB, BKN_DPP_FTMH_TC_NOF_BITS),
+    [BKN_DPP_FTMH_F_SRC_SYS_PORT] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_SRC_SYS_PORT_MSB, BKN_DPP_FTMH_SRC_SYS_PORT_NOF_BITS),
+    [BKN_DPP_FTMH_F_ACTION_TYPE] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_ACTION_TYPE_MSB, BKN_DPP_FTMH_ACTION_TYPE_NOF_BITS),
+    [BKN_DPP_FTMH_F_PPH_TYPE] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_PPH_TYPE_MSB, BKN_DPP_FTMH_PPH_TYPE_NOF_BITS),
+    [BKN_DPP_FTMH_F_DSP_EXIST] =
+        BKN_HDR_FLD(BKN_DPP_FTMH_EXT_DSP_EXIST_MSB, BKN_DPP_FTMH_EXT_DSP_EXIST_NOF_BITS),
+};
+
+/* DPP PPH */
+enum {
+    BKN_DPP_PPH_F_EEI_EXT,
+    BKN_DPP_PPH_F_LEARN_EXT,
+    BKN_DPP_PPH_F_FHEI_SIZE,
+    BKN_DPP_PPH_F_FORWARD_CODE,
+    BKN_DPP_PPH_F_VSI,
+    BKN_DPP_PPH_F_COUNT
+};
+
+static const bkn_hdr_fld_t bkn_dpp_pph_flds[BKN_DPP_PPH_F_COUNT] = {
+    [BKN_DPP_PPH_F_EEI_EXT] =
+        BKN_HDR_FLD(BKN_DPP_PPH_EEI_EXTENSION_PRESENT_MSB,
+                    BKN_DPP_PPH_EEI_EXTENSION_PRESENT_NOF_BITS),
+    [BKN_DPP_PPH_F_LEARN_EXT] =
+        BKN_HDR_FLD(BKN_DPP_PPH_LEARN_EXENSION_PRESENT_MSB,
+                    BKN_DPP_PPH_LEARN_EXENSION_PRESENT_NOF_BITS),
+    [BKN_DPP_PPH_F_FHEI_SIZE] =
+        BKN_HDR_FLD(BKN_DPP_PPH_FHEI_SIZE_MSB, BKN_DPP_PPH_FHEI_SIZE_NOF_BITS),
+    [BKN_DPP_PPH_F_FORWARD_CODE] =
+        BKN_HDR_FLD(BKN_DPP_PPH_FORWARD_CODE_MSB, BKN_DPP_PPH_FORWARD_CODE_NOF_BITS),
+    [BKN_DPP_PPH_F_VSI] =
+        BKN_HDR_FLD(BKN_DPP_PPH_VSI_MSB, BKN_DPP_PPH_VSI_NOF_BITS),
+};
+
+/* DPP 3-byte trap/snoop FHEI */
+enum {
+    BKN_DPP_FHEI_F_TRAP_QUALIFIER,
+    BKN_DPP_FHEI_F_TRAP_CODE,
+    BKN_DPP_FHEI_F_COUNT
+};
+
+static const bkn_hdr_fld_t bkn_dpp_fhei_flds[BKN_DPP_FHEI_F_COUNT] = {
+    [BKN_DPP_FHEI_F_TRAP_QUALIFIER] =
+        BKN_HDR_FLD(BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_QUALIFIER_MSB,
+                    BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_QUALIFIER_NOF_BITS),
+    [BKN_DPP_FHEI_F_TRAP_CODE] =
+        BKN_HDR_FLD(BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_MSB,
+                    BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_NOF_BITS),
+};
+
 #define PREV_IDX(_cur, _max) (((_cur) == 0) ? (_max) - 1 : (_cur) - 1)
 
 #if defined(CMIC_SOFT_BYTE_SWAP)
@@ -885,12 +1331,61 @@ typedef struct bkn_priv_s {
     uint32_t cb_user_data;
     uint8_t system_headers[27];
     uint32_t system_headers_size;
+#ifdef BKN_XDP_SUPPORT
+    struct bpf_prog *xdp_prog;  /* Protected by sinfo->lock */
+    struct xdp_rxq_info xdp_rxq;
+#endif
 } bkn_priv_t;
 
+/*
+ * Rx filter engine
+ *
+ * Filters which share the same match shape (OOB/packet offsets, sizes
+ * and mask) are collected in a filter group. Within a group the
+ * filters are hashed on their (masked) match data, so each received
+ * packet only needs one key extraction and one bucket lookup per
+ * group rather than a compare against every installed filter.
+ *
+ * Each filter carries a sort key (seq) made of its priority and its
+ * creation order, which matches its position in the priority ordered
+ * rxpf_list. Bucket chains are kept sorted on seq, such that the
+ * lowest seq match across all groups is the one the linear list walk
+ * would have returned. The key is set before the filter is published
+ * to the Rx path and never changes, so lockless readers always compare
+ * consistent keys.
+ */
+#define BKN_FLTR_HASH_BITS      6
+#define BKN_FLTR_HASH_SIZE      (1 << BKN_FLTR_HASH_BITS)
+
+typedef struct bkn_fgroup_s {
+    struct list_head list;
+    uint16 oob_data_offset;
+    uint16 oob_data_size;
+    uint16 pkt_data_offset;
+    uint16 pkt_data_size;
+    int wsize;
+    uint32 mask[KCOM_FILTER_WORDS_MAX];
+    int filters;
+    struct list_head bucket[BKN_FLTR_HASH_SIZE];
+} bkn_fgroup_t;
+
+/* Token bucket of a filter policer on one CPU */
+typedef struct bkn_fpol_s {
+    uint64_t tok_ns;           /* Time of last token update */
+    uint32_t tokens;           /* Packets that may pass */
+    unsigned long drops;       /* Packets dropped by the policer */
+} bkn_fpol_t;
+
 typedef struct bkn_filter_s {
     struct list_head list;
     int dev_no;
-    unsigned long hits;
+    unsigned long __percpu *hits; /* Matched packets, per CPU */
+    uint32_t pol_rate;         /* Policer rate in packets/s, 0 if none */
+    uint32_t pol_burst;        /* Policer burst in packets */
+    bkn_fpol_t __percpu *pol;  /* Policer state, per CPU */
+    struct list_head hlist;    /* Hash bucket chain in filter group */
+    bkn_fgroup_t *fgroup;
+    uint64_t seq;              /* Sort key, priority then creation */
     kcom_filter_t kf;
 } bkn_filter_t;
 
@@ -921,10 +1416,45 @@ static int bkn_knet_dev_reinit(int d);
 /* IOCTL debug counters */
 static int ioctl_cmd;
 static int ioctl_evt;
+static int genl_cmd;
+
+#ifdef BKN_GENL_SUPPORT
+static void bkn_genl_link_notify(bkn_priv_t *priv);
+#endif
 
 /* Switch devices */
 LIST_HEAD(_sinfo_list);
 
+/*
+ * Loopback performance harness (see /proc/bcm/knet/perf)
+ */
+#define BKN_PERF_LAT_BUCKETS    1024    /* 1 usec per bucket */
+#define BKN_PERF_LEN_MIN        60
+#define BKN_PERF_LEN_MAX        9216
+#define BKN_PERF_COUNT_DEF      100000
+#define BKN_PERF_DRAIN_MSEC     20      /* Wait for looped back packets */
+#define BKN_PERF_BUSY_MSEC      1000    /* Give up if Tx stays suspended */
+
+typedef struct bkn_perf_s {
+    bkn_switch_info_t *sinfo;   /* Device sampled for Rx latency */
+    int unit;
+    int netif;
+    int len;
+    int count;
+    uint32_t tx_ok;
+    uint32_t tx_fail;
+    uint64_t elapsed_ns;
+    uint32_t interrupts;
+    uint32_t rx_pkts[NUM_RX_CHAN];
+    uint32_t lat_samples;
+    uint64_t lat_max_ns;
+    uint32_t lat_hist[BKN_PERF_LAT_BUCKETS];
+} bkn_perf_t;
+
+static bkn_perf_t bkn_perf;
+static int bkn_perf_active;
+static DEFINE_MUTEX(bkn_perf_lock);
+
 /* Reallocation chunk size for netif array */
 #define NDEVS_CHUNK     64
 
@@ -1082,6 +1612,23 @@ bkn_sleep(int clicks)
 }
 #endif
 
+/*
+ * Datapath tracepoints. Must be included after all other headers,
+ * since CREATE_TRACE_POINTS applies to every trace header included
+ * from here on.
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,32))
+#define CREATE_TRACE_POINTS
+#include <bcm-knet-trace.h>
+#else
+#define trace_bkn_rx_dcb_done(_unit, _chan, _idx, _stat)
+#define trace_bkn_rx_filter_match(_unit, _chan, _id, _type, _dest)
+#define trace_bkn_rx_deliver(_unit, _skb)
+#define trace_bkn_tx_enqueue(_unit, _dev, _skb, _idx, _ndcbs)
+#define trace_bkn_tx_done(_unit, _skb, _idx)
+#define trace_bkn_rx_rate_pause(_unit, _chan, _tokens)
+#endif
+
 static bkn_thread_ctrl_t bkn_cmd_ctrl;
 static bkn_thread_ctrl_t bkn_evt_ctrl;
 
@@ -1094,6 +1641,23 @@ static bkn_thread_ctrl_t bkn_evt_ctrl;
  */
 #define SOC_DCB_KNET_DONE       0x8000
 #define SOC_DCB_KNET_COUNT_MASK 0x7fff
+
+/* Rx DCB status bits */
+#define SOC_DCB_RX_END          (1 << 16)
+#define SOC_DCB_RX_START        (1 << 17)
+#define SOC_DCB_RX_ERR_MASK     (3 << 18)
+
+/* Rx DCB scatter-gather control bit */
+#define SOC_DCB_SG              (1 << 17)
+
+/*
+ * Page buffer layout for scatter Rx. The headroom leaves space for
+ * RCPU encapsulation and the first page of a frame becomes the skb
+ * head, so the shared info is reserved at the end of every page.
+ */
+#define BKN_RX_SG_HEADROOM      (NET_SKB_PAD + RCPU_RX_ENCAP_SIZE)
+#define BKN_RX_SG_BUF_SIZE      ((PAGE_SIZE - BKN_RX_SG_HEADROOM - \
+                                  SKB_DATA_ALIGN(sizeof(struct skb_shared_info))) & ~63)
 #define SOC_DCB_META_OFFSET     2
 
 /* Default channel configuration */
@@ -1881,7 +2445,9 @@ bkn_alloc_dcbs(bkn_switch_info_t *sinfo)
     dcb_size = sinfo->dcb_wsize * sizeof(uint32_t);
     tx_ring_size = dcb_size * (MAX_TX_DCBS + 1);
     rx_ring_size = dcb_size * (MAX_RX_DCBS + 1);
-    sinfo->dcb_mem_size = tx_ring_size + rx_ring_size * sinfo->rx_chans;
+    /* One extra DCB worth of memory is used as Tx FCS pad area */
+    sinfo->dcb_mem_size = tx_ring_size + rx_ring_size * sinfo->rx_chans +
+                          dcb_size;
 
     sinfo->dcb_mem = DMA_ALLOC_COHERENT(sinfo->dma_dev,
                                         sinfo->dcb_mem_size,
@@ -1892,6 +2458,7 @@ bkn_alloc_dcbs(bkn_switch_info_t *sinfo)
         return -ENOMEM;
     }
     sinfo->dcb_dma = (uint64_t)dcb_dma;
+    sinfo->tx.fcs_dma = sinfo->dcb_dma + sinfo->dcb_mem_size - dcb_size;
 
     return 0;
 }
@@ -1906,6 +2473,26 @@ bkn_free_dcbs(bkn_switch_info_t *sinfo)
     }
 }
 
+/* Release the packet buffer DMA mapping of a Tx DCB */
+static void
+bkn_tx_desc_unmap(bkn_switch_info_t *sinfo, bkn_desc_info_t *desc)
+{
+    if (desc->skb_dma == 0) {
+        return;
+    }
+    if (desc->dma_page) {
+        DMA_UNMAP_PAGE(sinfo->dma_dev,
+                       desc->skb_dma, desc->dma_size,
+                       DMA_TODEV);
+        desc->dma_page = 0;
+    } else {
+        DMA_UNMAP_SINGLE(sinfo->dma_dev,
+                         desc->skb_dma, desc->dma_size,
+                         DMA_TODEV);
+    }
+    desc->skb_dma = 0;
+}
+
 static void
 bkn_clean_tx_dcbs(bkn_switch_info_t *sinfo)
 {
@@ -1915,13 +2502,10 @@ bkn_clean_tx_dcbs(bkn_switch_info_t *sinfo)
                 sinfo->tx.cur, sinfo->tx.dirty));
     while (sinfo->tx.free < MAX_TX_DCBS) {
         desc = &sinfo->tx.desc[sinfo->tx.dirty];
+        bkn_tx_desc_unmap(sinfo, desc);
         if (desc->skb != NULL) {
             DBG_SKB(("Cleaning Tx SKB from DCB %d.\n",
                      sinfo->tx.dirty));
-            DMA_UNMAP_SINGLE(sinfo->dma_dev,
-                             desc->skb_dma, desc->dma_size,
-                             DMA_TODEV);
-            desc->skb_dma = 0;
             dev_kfree_skb_any(desc->skb);
             desc->skb = NULL;
         }
@@ -1954,11 +2538,23 @@ bkn_clean_rx_dcbs(bkn_switch_info_t *sinfo, int chan)
             dev_kfree_skb_any(desc->skb);
             desc->skb = NULL;
         }
+        if (desc->page != NULL) {
+            DMA_UNMAP_SINGLE(sinfo->dma_dev,
+                             desc->skb_dma, desc->dma_size,
+                             DMA_FROMDEV);
+            desc->skb_dma = 0;
+            put_page(desc->page);
+            desc->page = NULL;
+        }
         if (++sinfo->rx[chan].dirty >= MAX_RX_DCBS) {
             sinfo->rx[chan].dirty = 0;
         }
         sinfo->rx[chan].free--;
     }
+    if (sinfo->rx[chan].sg_skb != NULL) {
+        dev_kfree_skb_any(sinfo->rx[chan].sg_skb);
+        sinfo->rx[chan].sg_skb = NULL;
+    }
     sinfo->rx[chan].running = 0;
     sinfo->rx[chan].api_active = 0;
     DBG_DCB_RX(("Cleaned Rx%d DCBs (%d %d).\n",
@@ -2200,6 +2796,88 @@ bkn_api_rx_chain_done(bkn_switch_info_t *sinfo, int chan)
     bkn_api_rx_restart(sinfo, chan);
 }
 
+/*
+ * Publish a completed Rx API DCB in the shared completion ring.
+ * The entries become visible to the application in bkn_api_ring_kick.
+ */
+static void
+bkn_api_ring_put(bkn_switch_info_t *sinfo, int chan,
+                 bkn_dcb_chain_t *dcb_chain, uint32_t *dcb)
+{
+    kcom_dma_ring_entry_t *entry;
+    uint32_t size;
+
+    if (!sinfo->api_ring.active) {
+        return;
+    }
+    size = sinfo->api_ring.hdr->size;
+    if (sinfo->api_ring.prod - READ_ONCE(sinfo->api_ring.hdr->cons) >= size) {
+        sinfo->api_ring.hdr->overflows++;
+        sinfo->api_ring.overflow = 1;
+        return;
+    }
+    entry = &sinfo->api_ring.entry[sinfo->api_ring.prod & (size - 1)];
+    entry->dcb_start = dcb_chain->dcb_dma;
+    entry->dcb_idx = dcb_chain->dcb_cur;
+    entry->chan = chan + 1;
+    entry->len = dcb[sinfo->dcb_wsize-1] & SOC_DCB_KNET_COUNT_MASK;
+    sinfo->api_ring.prod++;
+}
+
+/*
+ * Update the producer index of the shared completion ring and notify
+ * the application if the ring was empty. Returns 0 if the ring is not
+ * in use, in which case the caller raises the Rx DMA event.
+ */
+static int
+bkn_api_ring_kick(bkn_switch_info_t *sinfo)
+{
+    bkn_evt_resource_t *evt;
+    uint32_t pub;
+    int dma_event = 0;
+
+    if (!sinfo->api_ring.active) {
+        return 0;
+    }
+
+    if (sinfo->api_ring.prod != sinfo->api_ring.pub) {
+        pub = sinfo->api_ring.pub;
+        /* Entries must be visible before the producer index */
+        smp_wmb();
+        WRITE_ONCE(sinfo->api_ring.hdr->prod, sinfo->api_ring.prod);
+        sinfo->api_ring.pub = sinfo->api_ring.prod;
+        /* Pairs with the barrier after the consumer index update */
+        smp_mb();
+        if (READ_ONCE(sinfo->api_ring.hdr->cons) == pub) {
+            sinfo->api_ring.kicks++;
+            if (sinfo->api_ring.evfd) {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6,8,0))
+                eventfd_signal(sinfo->api_ring.evfd);
+#else
+                eventfd_signal(sinfo->api_ring.evfd, 1);
+#endif
+            } else {
+                dma_event = 1;
+            }
+        }
+    }
+
+    if (sinfo->api_ring.overflow) {
+        /* Application must scan the DCB chains */
+        sinfo->api_ring.overflow = 0;
+        dma_event = 1;
+    }
+
+    if (dma_event) {
+        sinfo->dma_events |= KCOM_DMA_INFO_F_RX_DONE;
+        evt = &_bkn_evt[sinfo->evt_idx];
+        evt->evt_wq_put++;
+        wake_up_interruptible(&evt->evt_wq);
+    }
+
+    return 1;
+}
+
 static int
 bkn_api_rx_copy_from_skb(bkn_switch_info_t *sinfo,
                          int chan, bkn_desc_info_t *desc)
@@ -2246,7 +2924,11 @@ bkn_api_rx_copy_from_skb(bkn_switch_info_t *sinfo,
     }
 
     /* Copy packet data */
-    memcpy(pkt, desc->skb->data, pktlen);
+    if (skb_is_nonlinear(desc->skb)) {
+        skb_copy_bits(desc->skb, 0, pkt, pktlen);
+    } else {
+        memcpy(pkt, desc->skb->data, pktlen);
+    }
 
     /* Copy packet metadata and mark as done */
     if (sinfo->cmic_type != 'x') {
@@ -2256,6 +2938,7 @@ bkn_api_rx_copy_from_skb(bkn_switch_info_t *sinfo,
     }
     dcb[sinfo->dcb_wsize-1] = dcb_stat | SOC_DCB_KNET_DONE;
     MEMORY_BARRIER;
+    bkn_api_ring_put(sinfo, chan, dcb_chain, dcb);
 
     dcb_chain->dcb_cur++;
 
@@ -2279,6 +2962,10 @@ bkn_api_rx_copy_from_skb(bkn_switch_info_t *sinfo,
         }
     }
 
+    if (bkn_api_ring_kick(sinfo)) {
+        return 0;
+    }
+
     sinfo->dma_events |= KCOM_DMA_INFO_F_RX_DONE;
 
     evt = &_bkn_evt[sinfo->evt_idx];
@@ -2296,8 +2983,12 @@ bkn_rx_refill(bkn_switch_info_t *sinfo, int chan)
     uint32_t *dcb;
     uint32_t resv_size = sinfo->cmic_type == 'x' ? RCPU_HDR_SIZE : RCPU_RX_ENCAP_SIZE;
     uint32_t meta_size = sinfo->cmic_type == 'x' ? RCPU_RX_META_SIZE : 0;
+    uint32_t buf_size;
+    void *buf;
     int prev;
 
+    buf_size = sinfo->rx_sg ? BKN_RX_SG_BUF_SIZE : rx_buffer_size + meta_size;
+
     if (sinfo->rx[chan].use_rx_skb == 0) {
         /* Rx buffers are provided by BCM Rx API */
         return;
@@ -2306,24 +2997,45 @@ bkn_rx_refill(bkn_switch_info_t *sinfo, int chan)
     if (!CDMA_CH(sinfo, XGS_DMA_RX_CHAN + chan) &&
         sinfo->rx[chan].tokens < MAX_RX_DCBS) {
         /* Pause DMA for now */
+        sinfo->rx[chan].rate_pauses++;
+        trace_bkn_rx_rate_pause(sinfo->dev_no, chan, sinfo->rx[chan].tokens);
         return;
     }
 
     while (sinfo->rx[chan].free < MAX_RX_DCBS) {
         desc = &sinfo->rx[chan].desc[sinfo->rx[chan].cur];
-        if (desc->skb == NULL) {
-            skb = dev_alloc_skb(rx_buffer_size + RCPU_RX_ENCAP_SIZE);
-            if (skb == NULL) {
-                break;
+        if (sinfo->rx_sg) {
+            if (desc->page == NULL) {
+                desc->page = alloc_page(GFP_ATOMIC | __GFP_NOWARN);
+                if (desc->page == NULL) {
+                    break;
+                }
             }
-            skb_reserve(skb, resv_size);
-            desc->skb = skb;
+            buf = page_address(desc->page) + BKN_RX_SG_HEADROOM;
         } else {
-            DBG_DCB_RX(("Refill Rx%d SKB in DCB %d recycled.\n",
-                        chan, sinfo->rx[chan].cur));
+            if (desc->skb == NULL) {
+                skb = dev_alloc_skb(rx_buffer_size + RCPU_RX_ENCAP_SIZE);
+                if (skb == NULL) {
+                    break;
+                }
+                skb_reserve(skb, resv_size);
+                desc->skb = skb;
+            } else {
+                DBG_DCB_RX(("Refill Rx%d SKB in DCB %d recycled.\n",
+                            chan, sinfo->rx[chan].cur));
+            }
+            buf = desc->skb->data;
         }
-        skb = desc->skb;
-        desc->dma_size = rx_buffer_size + meta_size;
+        if (desc->skb_dma) {
+            /* Recycled buffer is still mapped, hand it back to the device */
+            DMA_SYNC_FOR_DEV(sinfo->dma_dev,
+                             desc->skb_dma, desc->dma_size,
+                             DMA_FROMDEV);
+            sinfo->rx[chan].bufs_reuse++;
+            goto refill_dcb;
+        }
+        sinfo->rx[chan].bufs_alloc++;
+        desc->dma_size = buf_size;
 #ifdef KNET_NO_AXI_DMA_INVAL
         /*
          * FIXME: Need to retain this code until iProc customers have been
@@ -2339,13 +3051,20 @@ bkn_rx_refill(bkn_switch_info_t *sinfo, int chan)
         }
 #endif
         desc->skb_dma = DMA_MAP_SINGLE(sinfo->dma_dev,
-                                       skb->data, desc->dma_size,
+                                       buf, desc->dma_size,
                                        DMA_FROMDEV);
         if (DMA_MAPPING_ERROR(sinfo->dma_dev, desc->skb_dma)) {
-            dev_kfree_skb_any(skb);
-            desc->skb = NULL;
+            if (desc->page != NULL) {
+                put_page(desc->page);
+                desc->page = NULL;
+            } else {
+                dev_kfree_skb_any(desc->skb);
+                desc->skb = NULL;
+            }
+            desc->skb_dma = 0;
             break;
         }
+refill_dcb:
         DBG_DCB_RX(("Refill Rx%d DCB %d (0x%08x).\n",
                     chan, sinfo->rx[chan].cur, (uint32_t)desc->skb_dma));
         dcb = desc->dcb_mem;
@@ -2368,15 +3087,26 @@ bkn_rx_refill(bkn_switch_info_t *sinfo, int chan)
         }
         if (sinfo->cmic_type == 'x') {
             dcb[1] = DMA_TO_BUS_HI(desc->skb_dma >> 32);
-            dcb[2] |= rx_buffer_size + meta_size;
+            dcb[2] |= buf_size;
+            if (sinfo->rx_sg) {
+                dcb[2] |= SOC_DCB_SG;
+            }
         } else {
-            dcb[1] |= rx_buffer_size;
+            dcb[1] |= buf_size;
+            if (sinfo->rx_sg) {
+                dcb[1] |= SOC_DCB_SG;
+            }
         }
 
-        if (CDMA_CH(sinfo, XGS_DMA_RX_CHAN + chan) &&
-            sinfo->rx[chan].tokens > MAX_RX_DCBS) {
-            /* DMA run to the new halt location */
-            bkn_cdma_goto(sinfo, XGS_DMA_RX_CHAN + chan, desc->dcb_dma);
+        if (CDMA_CH(sinfo, XGS_DMA_RX_CHAN + chan)) {
+            if (sinfo->rx[chan].tokens > MAX_RX_DCBS) {
+                /* DMA run to the new halt location */
+                bkn_cdma_goto(sinfo, XGS_DMA_RX_CHAN + chan, desc->dcb_dma);
+            } else {
+                /* Halt location is held back */
+                trace_bkn_rx_rate_pause(sinfo->dev_no, chan,
+                                        sinfo->rx[chan].tokens);
+            }
         }
 
         if (++sinfo->rx[chan].cur >= MAX_RX_DCBS) {
@@ -2560,123 +3290,500 @@ device_is_sand(bkn_switch_info_t *sinfo)
     return is_sand;
 }
 
-static bkn_filter_t *
-bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
-                 void *meta, int chan, bkn_filter_t *cbf)
+static int
+bkn_filter_chan_match(bkn_switch_info_t *sinfo, kcom_filter_t *kf, int chan)
 {
-    struct list_head *list;
-    bkn_filter_t *filter;
-    kcom_filter_t scratch, *kf;
-    uint8_t *oob = (uint8_t *)meta;
-    int size, wsize;
-    int idx, match;
-
-    list_for_each(list, &sinfo->rxpf_list) {
-        filter = (bkn_filter_t *)list;
-        kf = &filter->kf;
-        memcpy(&scratch.data.b[0],
-               &oob[kf->oob_data_offset], kf->oob_data_size);
-        memcpy(&scratch.data.b[kf->oob_data_size],
-               &pkt[kf->pkt_data_offset], kf->pkt_data_size);
-        size = kf->oob_data_size + kf->pkt_data_size;
-        wsize = BYTES2WORDS(size);
-        DBG_VERB(("Filter: size = %d (%d), data = 0x%08x, mask = 0x%08x\n",
-                  size, wsize, kf->data.w[0], kf->mask.w[0]));
-
-        if (device_is_dnx(sinfo)) {
-            DBG_DUNE(("Filter: size = %d (wsize %d)\n", size, wsize));
-            for (idx = 0; idx < wsize; idx++)
-            {
-                DBG_DUNE(("OOB[%d]: 0x%08x [0x%08x]\n", idx, kf->data.w[idx], kf->mask.w[idx]));
-            }
-            DBG_DUNE(("Meta Data [+ Selected Raw packet data]\n"));
-            for (idx = 0; idx < wsize; idx++)
-            {
-                DBG_DUNE(("Scratch[%d]: 0x%08x\n", idx, scratch.data.w[idx]));
-            }
-        }
-
-        match = 1;
-        if (match) {
-            if (device_is_sand(sinfo))
-            {
-                /** priority 0 means no priority check */
-                if (kf->priority && (kf->priority < (num_rx_prio * sinfo->rx_chans))) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
-            else {
-                if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
-                    if (kf->priority < (num_rx_prio * chan) ||
-                        kf->priority >= (num_rx_prio * (chan + 1))) {
-                        match = 0;
-                    }
-                }
-            }
-        }
-        if (match) {
-            for (idx = 0; idx < wsize; idx++) {
-                scratch.data.w[idx] &= kf->mask.w[idx];
-                if (scratch.data.w[idx] != kf->data.w[idx]) {
-                    match = 0;
-                    break;
-                }
-            }
+    if (device_is_sand(sinfo)) {
+        /** priority 0 means no priority check */
+        if (kf->priority == 0) {
+            return 1;
         }
-        if (match) {
-            if (kf->dest_type == KCOM_DEST_T_CB) {
-                /* Check for custom filters */
-                if (knet_filter_cb != NULL && cbf != NULL) {
-                    memset(cbf, 0, sizeof(*cbf));
-                    memcpy(&cbf->kf, kf, sizeof(cbf->kf));
-                    if (knet_filter_cb(pkt, pktlen, sinfo->dev_no,
-                                       meta, chan, &cbf->kf)) {
-                        filter->hits++;
-                        return cbf;
-                    }
-                } else {
-                    DBG_FLTR(("Match, but not filter callback\n"));
-                }
-            } else {
-                filter->hits++;
-                return filter;
-            }
+    }
+    if (kf->priority < (num_rx_prio * sinfo->rx_chans)) {
+        if (kf->priority < (num_rx_prio * chan) ||
+            kf->priority >= (num_rx_prio * (chan + 1))) {
+            return 0;
         }
     }
+    return 1;
+}
 
-    return NULL;
+static int
+bkn_fgroup_hash(uint32 *key, int wsize)
+{
+    return jhash2(key, wsize, 0) & (BKN_FLTR_HASH_SIZE - 1);
 }
 
-static bkn_priv_t *
-bkn_netif_lookup(bkn_switch_info_t *sinfo, int id)
+/* Extract the masked match key for a filter group from a packet */
+static void
+bkn_fgroup_key(bkn_fgroup_t *fg, uint8_t *oob, uint8_t *pkt, uint32 *key)
 {
-    struct list_head *list;
-    bkn_priv_t *priv;
-    int found;
+    uint8_t *kb = (uint8_t *)key;
+    int idx;
 
-    /* Fast path */
-    if (id < sinfo->ndev_max) {
-        if (sinfo->ndevs[id] != NULL) {
-            DBG_NDEV(("Look up netif ID %d successful\n", id));
-            return netdev_priv(sinfo->ndevs[id]);
-        }
+    if (fg->wsize == 0) {
+        return;
+    }
+    key[fg->wsize - 1] = 0;
+    memcpy(&kb[0], &oob[fg->oob_data_offset], fg->oob_data_size);
+    memcpy(&kb[fg->oob_data_size],
+           &pkt[fg->pkt_data_offset], fg->pkt_data_size);
+    for (idx = 0; idx < fg->wsize; idx++) {
+        key[idx] &= fg->mask[idx];
     }
+}
 
-    /* Slow path - should normally not get here */
-    found = 0;
-    priv = NULL;
-    list_for_each(list, &sinfo->ndev_list) {
-        priv = (bkn_priv_t *)list;
-        if (priv->id == id) {
+static int
+bkn_fgroup_shape_match(bkn_fgroup_t *fg, kcom_filter_t *kf)
+{
+    if (fg->oob_data_offset != kf->oob_data_offset ||
+        fg->oob_data_size != kf->oob_data_size ||
+        fg->pkt_data_offset != kf->pkt_data_offset ||
+        fg->pkt_data_size != kf->pkt_data_size) {
+        return 0;
+    }
+    return memcmp(fg->mask, kf->mask.w, fg->wsize * sizeof(uint32)) == 0;
+}
+
+/*
+ * Add filter to the filter engine. The filter must already be in
+ * rxpf_list with its sort key set. list_add_tail_rcu() publishes the
+ * filter after its key is written. Called with sinfo->cfg_lock held.
+ */
+static int
+bkn_fgroup_add(bkn_switch_info_t *sinfo, bkn_filter_t *filter)
+{
+    struct list_head *list;
+    bkn_fgroup_t *fg;
+    bkn_filter_t *lfilter;
+    kcom_filter_t *kf = &filter->kf;
+    uint32 key[KCOM_FILTER_WORDS_MAX];
+    int idx, wsize, found;
+
+    wsize = BYTES2WORDS(kf->oob_data_size + kf->pkt_data_size);
+    if (wsize > KCOM_FILTER_WORDS_MAX) {
+        return -1;
+    }
+
+    found = 0;
+    list_for_each(list, &sinfo->rxpf_groups) {
+        fg = (bkn_fgroup_t *)list;
+        if (fg->wsize == wsize && bkn_fgroup_shape_match(fg, kf)) {
+            found = 1;
+            break;
+        }
+    }
+    if (!found) {
+        fg = kmalloc(sizeof(*fg), GFP_ATOMIC);
+        if (fg == NULL) {
+            return -1;
+        }
+        memset(fg, 0, sizeof(*fg));
+        fg->oob_data_offset = kf->oob_data_offset;
+        fg->oob_data_size = kf->oob_data_size;
+        fg->pkt_data_offset = kf->pkt_data_offset;
+        fg->pkt_data_size = kf->pkt_data_size;
+        fg->wsize = wsize;
+        memcpy(fg->mask, kf->mask.w, wsize * sizeof(uint32));
+        for (idx = 0; idx < BKN_FLTR_HASH_SIZE; idx++) {
+            INIT_LIST_HEAD(&fg->bucket[idx]);
+        }
+        list_add_tail_rcu(&fg->list, &sinfo->rxpf_groups);
+        DBG_FLTR(("New filter group: oob %d/%d pkt %d/%d\n",
+                  fg->oob_data_offset, fg->oob_data_size,
+                  fg->pkt_data_offset, fg->pkt_data_size));
+    }
+
+    for (idx = 0; idx < wsize; idx++) {
+        key[idx] = kf->data.w[idx] & fg->mask[idx];
+    }
+    idx = bkn_fgroup_hash(key, wsize);
+
+    /* Keep bucket sorted on priority order */
+    filter->fgroup = fg;
+    found = 0;
+    list_for_each(list, &fg->bucket[idx]) {
+        lfilter = list_entry(list, bkn_filter_t, hlist);
+        if (filter->seq < lfilter->seq) {
+            list_add_tail_rcu(&filter->hlist, &lfilter->hlist);
             found = 1;
             break;
         }
     }
-    if (found && priv != NULL) {
-        return priv;
+    if (!found) {
+        list_add_tail_rcu(&filter->hlist, &fg->bucket[idx]);
+    }
+    fg->filters++;
+
+    return 0;
+}
+
+/*
+ * Remove filter from the filter engine. If this empties the filter
+ * group, the group is unlinked and returned, and must be freed by the
+ * caller after an RCU grace period. Called with sinfo->cfg_lock held.
+ */
+static bkn_fgroup_t *
+bkn_fgroup_del(bkn_switch_info_t *sinfo, bkn_filter_t *filter)
+{
+    bkn_fgroup_t *fg = filter->fgroup;
+
+    if (fg == NULL) {
+        return NULL;
+    }
+    list_del_rcu(&filter->hlist);
+    if (--fg->filters == 0) {
+        list_del_rcu(&fg->list);
+        return fg;
+    }
+    return NULL;
+}
+
+static unsigned long
+bkn_filter_hits(bkn_filter_t *filter)
+{
+    unsigned long hits = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        hits += *per_cpu_ptr(filter->hits, cpu);
+    }
+    return hits;
+}
+
+static void
+bkn_filter_hits_clear(bkn_filter_t *filter)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        *per_cpu_ptr(filter->hits, cpu) = 0;
+        per_cpu_ptr(filter->pol, cpu)->drops = 0;
+    }
+}
+
+static unsigned long
+bkn_filter_drops(bkn_filter_t *filter)
+{
+    unsigned long drops = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        drops += per_cpu_ptr(filter->pol, cpu)->drops;
+    }
+    return drops;
+}
+
+/*
+ * Set the policer of a filter. A rate of zero removes the policer.
+ * The buckets start full. Called with sinfo->cfg_lock held.
+ */
+static void
+bkn_filter_police_config(bkn_filter_t *filter, uint32_t rate, uint32_t burst)
+{
+    bkn_fpol_t *pol;
+    int cpu;
+
+    filter->pol_rate = 0;
+    smp_wmb();
+    for_each_possible_cpu(cpu) {
+        pol = per_cpu_ptr(filter->pol, cpu);
+        pol->tok_ns = 0;
+        pol->tokens = 0;
+    }
+    filter->pol_burst = burst ? burst : rate;
+    smp_wmb();
+    filter->pol_rate = rate;
+}
+
+/*
+ * Called from the Rx path, which does not migrate between CPUs, for
+ * the filter selected by bkn_match_rx_pkt. Returns 1 if the packet
+ * exceeds the policer of the filter and must be dropped.
+ *
+ * Each CPU has its own bucket, so the rate applies per Rx CPU and a
+ * storm on one filter does not use the rx_rate budget of its channel
+ * before the other filters see their packets.
+ */
+static int
+bkn_filter_police(bkn_filter_t *filter)
+{
+    uint32_t rate = filter->pol_rate;
+    uint64_t cur_ns, delta, tokens;
+    bkn_fpol_t *pol;
+
+    if (rate == 0) {
+        return 0;
+    }
+    smp_rmb();
+    pol = this_cpu_ptr(filter->pol);
+
+    cur_ns = ktime_to_ns(ktime_get());
+    delta = cur_ns - pol->tok_ns;
+    if (delta > NSEC_PER_SEC) {
+        delta = NSEC_PER_SEC;
+    }
+    tokens = div_u64(delta * rate, NSEC_PER_SEC);
+    if (pol->tokens + tokens >= filter->pol_burst) {
+        pol->tokens = filter->pol_burst;
+        pol->tok_ns = cur_ns;
+    } else if (tokens) {
+        pol->tokens += tokens;
+        /* Carry the unused fraction of a token over to the next packet */
+        pol->tok_ns += div_u64(tokens * NSEC_PER_SEC, rate);
+    }
+
+    if (pol->tokens == 0) {
+        pol->drops++;
+        return 1;
+    }
+    pol->tokens--;
+    return 0;
+}
+
+/* Called under rcu_read_lock */
+static bkn_filter_t *
+bkn_match_rx_pkt_walk(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
+                      void *meta, int chan, bkn_filter_t *cbf, int *depth)
+{
+    bkn_fgroup_t *fg;
+    bkn_filter_t *filter, *best;
+    kcom_filter_t *kf;
+    uint32 key[KCOM_FILTER_WORDS_MAX];
+    uint8_t *oob = (uint8_t *)meta;
+    uint64_t last_seq;
+    int idx;
+
+    /*
+     * Pick the highest priority match across all filter groups. If
+     * a callback filter declines the packet, look for the next match
+     * in priority order. Sort keys start at 1.
+     */
+    last_seq = 0;
+    while (1) {
+        best = NULL;
+        list_for_each_entry_rcu(fg, &sinfo->rxpf_groups, list) {
+            bkn_fgroup_key(fg, oob, pkt, key);
+            DBG_VERB(("Filter group: size = %d (%d), key = 0x%08x, mask = 0x%08x\n",
+                      fg->oob_data_size + fg->pkt_data_size, fg->wsize,
+                      key[0], fg->mask[0]));
+            if (device_is_dnx(sinfo)) {
+                DBG_DUNE(("Meta Data [+ Selected Raw packet data]\n"));
+                for (idx = 0; idx < fg->wsize; idx++)
+                {
+                    DBG_DUNE(("Key[%d]: 0x%08x [0x%08x]\n", idx, key[idx], fg->mask[idx]));
+                }
+            }
+            idx = bkn_fgroup_hash(key, fg->wsize);
+            list_for_each_entry_rcu(filter, &fg->bucket[idx], hlist) {
+                if (best && filter->seq >= best->seq) {
+                    break;
+                }
+                if (filter->seq <= last_seq) {
+                    continue;
+                }
+                if (!bkn_filter_chan_match(sinfo, &filter->kf, chan)) {
+                    continue;
+                }
+                (*depth)++;
+                if (memcmp(key, filter->kf.data.w,
+                           fg->wsize * sizeof(uint32)) == 0) {
+                    best = filter;
+                    break;
+                }
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+
+        kf = &best->kf;
+        if (kf->dest_type == KCOM_DEST_T_CB) {
+            /* Check for custom filters */
+            if (knet_filter_cb != NULL && cbf != NULL) {
+                memset(cbf, 0, sizeof(*cbf));
+                memcpy(&cbf->kf, kf, sizeof(cbf->kf));
+                /* Police with the policer of the matched filter */
+                cbf->pol_rate = best->pol_rate;
+                cbf->pol_burst = best->pol_burst;
+                cbf->pol = best->pol;
+                if (knet_filter_cb(pkt, pktlen, sinfo->dev_no,
+                                   meta, chan, &cbf->kf)) {
+                    this_cpu_inc(*best->hits);
+                    trace_bkn_rx_filter_match(sinfo->dev_no, chan, kf->id,
+                                              cbf->kf.dest_type,
+                                              cbf->kf.dest_id);
+                    return cbf;
+                }
+            } else {
+                DBG_FLTR(("Match, but not filter callback\n"));
+            }
+        } else {
+            this_cpu_inc(*best->hits);
+            trace_bkn_rx_filter_match(sinfo->dev_no, chan, kf->id,
+                                      kf->dest_type, kf->dest_id);
+            return best;
+        }
+        last_seq = best->seq;
+    }
+
+    return NULL;
+}
+
+/*
+ * Called under rcu_read_lock from the Rx path, which does not migrate
+ * between CPUs. Counts the lookup in the statistics of the CPU, and
+ * measures its cycles once every rx_filter_sample lookups.
+ */
+static bkn_filter_t *
+bkn_match_rx_pkt(bkn_switch_info_t *sinfo, uint8_t *pkt, int pktlen,
+                 void *meta, int chan, bkn_filter_t *cbf)
+{
+    bkn_rxf_stats_t *st = this_cpu_ptr(sinfo->rxf_stats);
+    bkn_filter_t *filter;
+    cycles_t start = 0, cycles;
+    int depth = 0, sample = 0;
+
+    if (rx_filter_sample > 0 && --st->sample_left <= 0) {
+        st->sample_left = rx_filter_sample;
+        sample = 1;
+        start = get_cycles();
+    }
+
+    filter = bkn_match_rx_pkt_walk(sinfo, pkt, pktlen, meta, chan, cbf, &depth);
+
+    if (sample) {
+        cycles = get_cycles() - start;
+        st->samples++;
+        st->cycles += cycles;
+        if (cycles > st->max_cycles) {
+            st->max_cycles = cycles;
+        }
+    }
+    st->lookups++;
+    if (filter == NULL) {
+        st->no_match++;
+    }
+    st->depth[min(fls(depth), BKN_RXF_DEPTH_BUCKETS - 1)]++;
+
+    return filter;
+}
+
+#ifdef BKN_XDP_SUPPORT
+/*
+ * Run the XDP program of a netif on a received packet while it is still
+ * in the Rx DMA buffer, i.e. before any skb is handed to the stack.
+ * Packets can be passed or dropped. The buffer has no headroom, and
+ * head/tail adjustments are not applied to passed packets.
+ * Called with sinfo->lock held.
+ */
+static u32
+bkn_do_xdp(bkn_priv_t *priv, uint8_t *data, int len)
+{
+    struct xdp_buff xdp;
+    u32 act;
+
+    xdp.data_hard_start = data;
+    xdp.data = data;
+    xdp.data_end = data + len;
+    xdp_set_data_meta_invalid(&xdp);
+    xdp.rxq = &priv->xdp_rxq;
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,8,0))
+    xdp.frame_sz = len;
+#endif
+
+    act = bpf_prog_run_xdp(priv->xdp_prog, &xdp);
+    switch (act) {
+    case XDP_PASS:
+    case XDP_DROP:
+        break;
+    case XDP_ABORTED:
+        act = XDP_DROP;
+        break;
+    default:
+        /* XDP_TX and XDP_REDIRECT are not supported */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,17,0))
+        bpf_warn_invalid_xdp_action(priv->dev, priv->xdp_prog, act);
+#else
+        bpf_warn_invalid_xdp_action(act);
+#endif
+        act = XDP_DROP;
+        break;
+    }
+    return act;
+}
+#endif
+
+/*
+ * Record the time from the Rx interrupt (or the start of the poll if
+ * there was none) until the packet is passed to the network stack.
+ */
+static void
+bkn_perf_rx_sample(bkn_switch_info_t *sinfo)
+{
+    uint64_t lat;
+    int idx;
+
+    if (sinfo != bkn_perf.sinfo || sinfo->perf_rx_ts == 0) {
+        return;
+    }
+    lat = ktime_to_ns(ktime_get()) - sinfo->perf_rx_ts;
+    if (lat > bkn_perf.lat_max_ns) {
+        bkn_perf.lat_max_ns = lat;
+    }
+    idx = (lat >= BKN_PERF_LAT_BUCKETS * NSEC_PER_USEC) ?
+          (BKN_PERF_LAT_BUCKETS - 1) : ((uint32_t)lat / NSEC_PER_USEC);
+    bkn_perf.lat_hist[idx]++;
+    bkn_perf.lat_samples++;
+}
+
+/* Pass Rx packet up the network stack. Called without sinfo->lock held. */
+static void
+bkn_netif_rx(bkn_switch_info_t *sinfo, struct sk_buff *skb)
+{
+    trace_bkn_rx_deliver(sinfo->dev_no, skb);
+    if (bkn_perf_active) {
+        bkn_perf_rx_sample(sinfo);
+    }
+    if (use_napi) {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0))
+        /* Allow sockets to busy poll the NAPI context (SO_BUSY_POLL) */
+        skb_mark_napi_id(skb, &sinfo->napi);
+#endif
+        if (use_gro) {
+            /* GRO is skipped by the stack unless enabled on the netif */
+            bkn_napi_gro_receive(&sinfo->napi, skb);
+        } else {
+            netif_receive_skb(skb);
+        }
+    } else {
+        netif_rx(skb);
+    }
+}
+
+/* Called under rcu_read_lock */
+static bkn_priv_t *
+bkn_netif_lookup(bkn_switch_info_t *sinfo, int id)
+{
+    bkn_ndev_table_t *table;
+    struct net_device *dev;
+    bkn_priv_t *priv;
+
+    /* Fast path */
+    table = rcu_dereference(sinfo->ndev_table);
+    if (table != NULL && id < table->ndev_max) {
+        dev = rcu_dereference(table->ndevs[id]);
+        if (dev != NULL) {
+            DBG_NDEV(("Look up netif ID %d successful\n", id));
+            return netdev_priv(dev);
+        }
+    }
+
+    /* Slow path - should normally not get here */
+    list_for_each_entry_rcu(priv, &sinfo->ndev_list, list) {
+        if (priv->id == id) {
+            return priv;
+        }
     }
     return NULL;
 }
@@ -2826,100 +3933,76 @@ bkn_bitstream_set_field(uint32_t *input_buffer, uint32_t start_bit, uint32_t  no
     return;
 }
 
-static void
-bkn_bitstream_get_field(uint8_t  *input_buffer, uint32_t start_bit, uint32_t  nof_bits, uint32_t *output_value)
+/*
+ * Load the 64-bit big-endian window of a system header field. Bytes
+ * beyond the end of the buffer read as zero.
+ */
+static inline uint64_t
+bkn_hdr_window(const uint8_t *buf, int len, int offs)
 {
-    uint32_t idx;
-    uint32_t buf_sizes=0;
-    uint32_t tmp_output_value[2]={0};
-    uint32_t first_byte_ndx;
-    uint32_t last_byte_ndx;
-    uint32_t place;
-    uint32_t field_bit_i;
-    uint8_t *tmp_output_value_u8_ptr = (uint8_t*)&tmp_output_value;
-    uint32_t bit_indicator;
+    uint64_t w = 0;
+    int idx;
 
-    if (nof_bits > 32)
-    {
-         return;
+    if (likely(offs + 8 <= len)) {
+        return get_unaligned_be64(buf + offs);
+    }
+    for (idx = offs; idx < offs + 8; idx++) {
+        w = (w << 8) | ((idx < len) ? buf[idx] : 0);
     }
+    return w;
+}
 
-    first_byte_ndx = start_bit / 8;
-    last_byte_ndx = ((start_bit + nof_bits - 1) / 8);
-    *output_value=0;
+/* Extract all fields of a system header in one pass */
+static void
+bkn_hdr_flds_get(const uint8_t *buf, int len, const bkn_hdr_fld_t *flds,
+                 int cnt, uint32_t *vals)
+{
+    int idx;
 
-    /* get 32 bit value, MSB */
-    for (idx = first_byte_ndx; idx <= last_byte_ndx; ++idx)
-    {
-        tmp_output_value_u8_ptr[last_byte_ndx - idx] = input_buffer[idx];
-        buf_sizes += 8;
-    }
-    tmp_output_value[0] = BKN_DNX_BYTE_SWAP(tmp_output_value[0]);
-    if (last_byte_ndx > 4)
-    {
-       tmp_output_value[1] = BKN_DNX_BYTE_SWAP(tmp_output_value[1]);
+    for (idx = 0; idx < cnt; idx++) {
+        vals[idx] = (uint32_t)(bkn_hdr_window(buf, len, flds[idx].offs) >>
+                               flds[idx].shift) & flds[idx].mask;
     }
+}
 
-    place = buf_sizes - (start_bit % 8 + nof_bits);
-    for (field_bit_i = 0; field_bit_i< nof_bits; ++place, ++field_bit_i)
-    {
-        uint32_t result;
-        result = tmp_output_value[place>>5] & BKN_DNX_BIT(place & 0x0000001F);
-        if (result)
-        {
-           bit_indicator = 1;
-        } else {
-           bit_indicator = 0;
-        }
-        *output_value |=  bit_indicator << field_bit_i;
+/*
+ * Select the PPH base layout of a DNX device. Called when the system
+ * header parameters of the device are (re)configured.
+ */
+static void
+bkn_dnx_hdr_layout_init(bkn_switch_info_t *sinfo)
+{
+    switch (sinfo->pph_base_size) {
+    case BKN_DNX_PPH_BASE_TYPE_9:
+        sinfo->dnx_pph = &bkn_dnx_pph9_layout;
+        break;
+    case BKN_DNX_PPH_BASE_TYPE_10:
+        sinfo->dnx_pph = &bkn_dnx_pph10_layout;
+        break;
+    case BKN_DNX_PPH_BASE_TYPE_12:
+        sinfo->dnx_pph = &bkn_dnx_pph12_layout;
+        break;
+    default:
+        sinfo->dnx_pph = NULL;
+        break;
     }
-    return;
 }
 
 static void
-bkn_dpp_packet_parse_ftmh(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_dune_system_header_info_t *packet_info)
+bkn_dpp_packet_parse_ftmh(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], int hdr_len, bkn_dune_system_header_info_t *packet_info)
 {
     uint32_t header_ptr = 0;
-    uint32_t dsp_ext_exist=0;
-    uint32_t fld_val;
+    uint32_t ftmh[BKN_DPP_FTMH_F_COUNT];
 
     header_ptr = packet_info->ntwrk_header_ptr;
 
-    /* Packet-size */
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_FTMH_PKT_SIZE_MSB,
-            BKN_DPP_FTMH_PKT_SIZE_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh.packet_size = fld_val;
-    /* Traffic-class */
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_FTMH_TC_MSB,
-            BKN_DPP_FTMH_TC_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh.prio = fld_val;
-    /* Source-system-port-aggregate */
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_FTMH_SRC_SYS_PORT_MSB,
-            BKN_DPP_FTMH_SRC_SYS_PORT_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh.src_sys_port = fld_val;
-    /* TM-action-type */
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_FTMH_ACTION_TYPE_MSB,
-            BKN_DPP_FTMH_ACTION_TYPE_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh.action_type = fld_val;
-    /* PPH-type */
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_FTMH_PPH_TYPE_MSB,
-            BKN_DPP_FTMH_PPH_TYPE_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh.pph_type = fld_val;
+    bkn_hdr_flds_get(&hdr_buff[header_ptr], hdr_len - header_ptr,
+                     bkn_dpp_ftmh_flds, BKN_DPP_FTMH_F_COUNT, ftmh);
+    packet_info->ftmh.packet_size = ftmh[BKN_DPP_FTMH_F_PKT_SIZE];
+    packet_info->ftmh.prio = ftmh[BKN_DPP_FTMH_F_TC];
+    packet_info->ftmh.src_sys_port = ftmh[BKN_DPP_FTMH_F_SRC_SYS_PORT];
+    packet_info->ftmh.action_type = ftmh[BKN_DPP_FTMH_F_ACTION_TYPE];
+    packet_info->ftmh.pph_type = ftmh[BKN_DPP_FTMH_F_PPH_TYPE];
 
     packet_info->ntwrk_header_ptr += BKN_DPP_FTMH_SIZE_BYTE;
     DBG_DUNE(("FTMH(%d) Packet-size %d Action-type %d PPH-type %d Source-system-port 0x%x Traffic-class %d\n",
@@ -2933,13 +4016,7 @@ bkn_dpp_packet_parse_ftmh(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_dune
         DBG_DUNE(("FTMH(%d) FTMH LB-Key Extension is present\n", packet_info->ntwrk_header_ptr));
     }
     /* DSP ext*/
-    fld_val = 0;
-    bkn_bitstream_get_field(
-        &hdr_buff[header_ptr],
-        BKN_DPP_FTMH_EXT_DSP_EXIST_MSB,
-        BKN_DPP_FTMH_EXT_DSP_EXIST_NOF_BITS,
-        &dsp_ext_exist);
-    if (dsp_ext_exist)
+    if (ftmh[BKN_DPP_FTMH_F_DSP_EXIST])
     {
         packet_info->ntwrk_header_ptr += BKN_DPP_FTMH_DEST_EXT_SIZE_BYTE;
         DBG_DUNE(("FTMH(%d) DSP-extension-present 1\n", packet_info->ntwrk_header_ptr));
@@ -2955,72 +4032,39 @@ bkn_dpp_packet_parse_ftmh(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_dune
 }
 
 static void
-bkn_dpp_packet_parse_internal(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_dune_system_header_info_t *packet_info)
+bkn_dpp_packet_parse_internal(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], int hdr_len, bkn_dune_system_header_info_t *packet_info)
 {
     uint32_t header_ptr = 0;
-    uint32_t fld_val;
-    uint32_t eei_extension_present = 0;
-    uint32_t learn_extension_present = 0;
-    uint32_t fhei_size = 0;
-    uint32_t forward_code;
+    uint32_t pph[BKN_DPP_PPH_F_COUNT];
+    uint32_t fhei[BKN_DPP_FHEI_F_COUNT];
+    uint32_t fhei_size;
     uint8_t  is_trapped = 0;
 
     header_ptr = packet_info->ntwrk_header_ptr;
 
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_PPH_EEI_EXTENSION_PRESENT_MSB,
-            BKN_DPP_PPH_EEI_EXTENSION_PRESENT_NOF_BITS,
-            &eei_extension_present);
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_PPH_LEARN_EXENSION_PRESENT_MSB,
-            BKN_DPP_PPH_LEARN_EXENSION_PRESENT_NOF_BITS,
-            &learn_extension_present);
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_PPH_FHEI_SIZE_MSB,
-            BKN_DPP_PPH_FHEI_SIZE_NOF_BITS,
-            &fhei_size);
-    bkn_bitstream_get_field(
-            &hdr_buff[header_ptr],
-            BKN_DPP_PPH_FORWARD_CODE_MSB,
-            BKN_DPP_PPH_FORWARD_CODE_NOF_BITS,
-            &forward_code);
+    bkn_hdr_flds_get(&hdr_buff[header_ptr], hdr_len - header_ptr,
+                     bkn_dpp_pph_flds, BKN_DPP_PPH_F_COUNT, pph);
+    fhei_size = pph[BKN_DPP_PPH_F_FHEI_SIZE];
     /* 7: CPU-Trap  */
-    is_trapped = (uint8_t)(forward_code == 7);
-
-    bkn_bitstream_get_field(
-             &hdr_buff[header_ptr],
-             BKN_DPP_PPH_VSI_MSB,
-             BKN_DPP_PPH_VSI_NOF_BITS,
-             &fld_val);
-    packet_info->internal.vsi = fld_val;
+    is_trapped = (uint8_t)(pph[BKN_DPP_PPH_F_FORWARD_CODE] == 7);
+    packet_info->internal.vsi = pph[BKN_DPP_PPH_F_VSI];
 
     /* size of PPH base is 7 */
     packet_info->ntwrk_header_ptr += BKN_DPP_PPH_SIZE_BYTE;
     header_ptr = packet_info->ntwrk_header_ptr;
 
     DBG_DUNE(("PPH(%d) Forward-Code %d EEI-Extension %d Learn-Extension %d VSI %d FHEI-size %d\n", packet_info->ntwrk_header_ptr,
-        forward_code, eei_extension_present, learn_extension_present, packet_info->internal.vsi, fhei_size));
+        pph[BKN_DPP_PPH_F_FORWARD_CODE], pph[BKN_DPP_PPH_F_EEI_EXT], pph[BKN_DPP_PPH_F_LEARN_EXT],
+        packet_info->internal.vsi, fhei_size));
 
     /* PPH extension */
     if (is_trapped && (fhei_size == 1))
     {
-        /* CPU trap code qualifier */
-        bkn_bitstream_get_field(
-                &hdr_buff[header_ptr],
-                BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_QUALIFIER_MSB,
-                BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_QUALIFIER_NOF_BITS,
-                &fld_val);
-        packet_info->internal.trap_qualifier = fld_val;
-       /* CPU trap code */
-        bkn_bitstream_get_field(
-          &hdr_buff[header_ptr],
-          BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_MSB,
-          BKN_DPP_PPH_FHEI_TRAP_SNOOP_3B_CPU_TRAP_CODE_NOF_BITS,
-          &fld_val);
-        packet_info->internal.trap_id = fld_val;
+        /* CPU trap code qualifier and CPU trap code */
+        bkn_hdr_flds_get(&hdr_buff[header_ptr], hdr_len - header_ptr,
+                         bkn_dpp_fhei_flds, BKN_DPP_FHEI_F_COUNT, fhei);
+        packet_info->internal.trap_qualifier = fhei[BKN_DPP_FHEI_F_TRAP_QUALIFIER];
+        packet_info->internal.trap_id = fhei[BKN_DPP_FHEI_F_TRAP_CODE];
     }
     switch(fhei_size) {
         case 1:
@@ -3035,10 +4079,10 @@ bkn_dpp_packet_parse_internal(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_
         default:
             break;
     }
-    if (eei_extension_present) {
+    if (pph[BKN_DPP_PPH_F_EEI_EXT]) {
         packet_info->ntwrk_header_ptr += BKN_DPP_PPH_EXPLICIT_EDITING_INFOMATION_EXTENSION_SIZE_BYTE;
     }
-    if (learn_extension_present) {
+    if (pph[BKN_DPP_PPH_F_LEARN_EXT]) {
         packet_info->ntwrk_header_ptr += BKN_DPP_PPH_LEARN_EXTENSION_SIZE_BYTE;
     }
 
@@ -3049,18 +4093,17 @@ bkn_dpp_packet_parse_internal(bkn_switch_info_t *sinfo, uint8_t hdr_buff[], bkn_
 static int
 bkn_dpp_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buff, uint32_t buff_len, bkn_dune_system_header_info_t *packet_info)
 {
-    uint8_t  hdr_buff[BKN_DPP_HDR_MAX_SIZE];
     uint32_t hdr_size;
     uint8_t  has_internal = 0;
 
     if ((buff == NULL) || (packet_info == NULL)) {
         return -1;
     }
+    /* Headers are parsed in place, nothing beyond the maximum size is used */
     hdr_size = buff_len < BKN_DPP_HDR_MAX_SIZE ? buff_len: BKN_DPP_HDR_MAX_SIZE;
-    memcpy(hdr_buff, buff, hdr_size);
 
     /* FTMH */
-    bkn_dpp_packet_parse_ftmh(sinfo, hdr_buff, packet_info);
+    bkn_dpp_packet_parse_ftmh(sinfo, buff, hdr_size, packet_info);
     if (packet_info->ftmh.packet_size != (buff_len + 2)) {
         DBG_DUNE(("FTMH packet size verfication failed, %d-%d\n", packet_info->ftmh.packet_size, buff_len));
         memset(packet_info, 0, sizeof(bkn_dune_system_header_info_t));
@@ -3085,7 +4128,7 @@ bkn_dpp_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buff, uint32_t buff
     }
 
     if (has_internal) {
-      bkn_dpp_packet_parse_internal(sinfo, &hdr_buff[0], packet_info);
+      bkn_dpp_packet_parse_internal(sinfo, buff, hdr_size, packet_info);
     }
 
     /* FIXME: */
@@ -3097,75 +4140,29 @@ bkn_dpp_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buff, uint32_t buff
 static int
 bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_len, bkn_dune_system_header_info_t *packet_info)
 {
-    uint32_t fld_val;
+    const bkn_dnx_pph_layout_t *pph_layout;
+    uint32_t ftmh[BKN_DNX_FTMH_F_COUNT];
+    uint32_t pph[BKN_DNX_PPH_F_COUNT];
+    uint32_t fhei[BKN_DNX_FHEI_F_COUNT];
+    uint32_t udh[BKN_DNX_UDH_F_COUNT];
     uint32_t hdr_size = 0;
     uint32_t pkt_offset_ingress_untrapped =0;
-    uint8_t  tm_dst_ext_present = 0;
-    uint8_t  app_specific_ext_size = 0;
-    uint8_t  flow_id_ext_size = 0;
-    uint8_t  bier_bfr_ext_size = 0;
-    uint8_t  is_pph_en = 0;
-    uint8_t  is_tsh_en = 0;
+    int len = (int)buf_len;
 
     if ((buf == NULL) || (packet_info == NULL)) {
         return -1;
     }
 
-    /* FTMH: Source-System-Port-Aggregate */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_SRC_SYS_PORT_AGGREGATE_MSB,
-            BKN_DNX_FTMH_SRC_SYS_PORT_AGGREGATE_NOF_BITS,
-            &fld_val);
-    packet_info->ftmh_spa = fld_val;
-    /* FTMH: PPH-Type TSH */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_PPH_TYPE_IS_TSH_EN_MSB,
-            BKN_DNX_FTMH_PPH_TYPE_IS_TSH_EN_NOF_BITS,
-            &fld_val);
-    is_tsh_en = fld_val;
-    /* FTMH: PPH-Type PPH base */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_PPH_TYPE_IS_PPH_EN_MSB,
-            BKN_DNX_FTMH_PPH_TYPE_IS_PPH_EN_NOF_BITS,
-            &fld_val);
-    is_pph_en = fld_val;
-    /* FTMH: TM-Destination-Extension-Present */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_TM_DST_EXT_PRESENT_MSB,
-            BKN_DNX_FTMH_TM_DST_EXT_PRESENT_NOF_BITS,
-            &fld_val);
-    tm_dst_ext_present = fld_val;
-    /* FTMH: Application-Specific-Extension-Size */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_APP_SPECIFIC_EXT_SIZE_MSB,
-            BKN_DNX_FTMH_APP_SPECIFIC_EXT_SIZE_NOF_BITS,
-            &fld_val);
-    app_specific_ext_size = fld_val;
-    /* FTMH: Flow-ID-Extension-Size */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_FLOW_ID_EXT_SIZE_MSB,
-            BKN_DNX_FTMH_FLOW_ID_EXT_SIZE_NOF_BITS,
-            &fld_val);
-    flow_id_ext_size = fld_val;
-    /* FTMH: BIER-BFR-Extension-Size */
-    bkn_bitstream_get_field(
-            &buf[hdr_size],
-            BKN_DNX_FTMH_BIER_BFR_EXT_SIZE_MSB,
-            BKN_DNX_FTMH_BIER_BFR_EXT_SIZE_NOF_BITS,
-            &fld_val);
-    bier_bfr_ext_size = fld_val;
+    /* FTMH base header */
+    bkn_hdr_flds_get(buf, len, bkn_dnx_ftmh_flds, BKN_DNX_FTMH_F_COUNT, ftmh);
+    packet_info->ftmh_spa = ftmh[BKN_DNX_FTMH_F_SPA];
 
     hdr_size = BKN_DNX_FTMH_BASE_SIZE;
     pkt_offset_ingress_untrapped = BKN_DNX_FTMH_BASE_SIZE;
 
     DBG_DUNE(("FTMH(%d) source-system-port 0x%x is_tsh_en %d is_pph_en %d\n",
-              hdr_size, packet_info->ftmh_spa, is_tsh_en, is_pph_en));
+              hdr_size, packet_info->ftmh_spa,
+              ftmh[BKN_DNX_FTMH_F_TSH_EN], ftmh[BKN_DNX_FTMH_F_PPH_EN]));
 
     /* FTMH LB-Key Extension */
     if (sinfo->ftmh_lb_key_ext_size > 0)
@@ -3180,25 +4177,25 @@ bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_l
         DBG_DUNE(("FTMH Stacking Extension(%d) is present\n", sinfo->ftmh_stacking_ext_size));
     }
     /* FTMH BIER BFR Extension */
-    if (bier_bfr_ext_size > 0)
+    if (ftmh[BKN_DNX_FTMH_F_BIER_BFR_EXT])
     {
         hdr_size += BKN_DNX_FTMH_BIER_BFR_EXT_SIZE;
         DBG_DUNE(("FTMH BIER BFR Extension(2) is present\n"));
     }
     /* FTMH TM Destination Extension */
-    if (tm_dst_ext_present > 0)
+    if (ftmh[BKN_DNX_FTMH_F_TM_DST_EXT])
     {
         hdr_size += BKN_DNX_FTMH_TM_DST_EXT_SIZE;
         DBG_DUNE(("FTMH TM Destination Extension(3) is present\n"));
     }
     /* FTMH Application Specific Extension */
-    if (app_specific_ext_size > 0)
+    if (ftmh[BKN_DNX_FTMH_F_APP_SPECIFIC_EXT])
     {
         hdr_size += BKN_DNX_FTMH_APP_SPECIFIC_EXT_SIZE;
         DBG_DUNE(("FTMH Application Specific Extension(6) is present\n"));
     }
     /* FTMH Flow-ID Extension */
-    if (flow_id_ext_size > 0)
+    if (ftmh[BKN_DNX_FTMH_F_FLOW_ID_EXT])
     {
         hdr_size += BKN_DNX_FTMH_FLOW_ID_EXT_SIZE;
         DBG_DUNE(("FTMH Flow-ID Extension(3) is present\n"));
@@ -3207,128 +4204,33 @@ bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_l
     /* Given the packet is trapped to CPU */
 
     /* Time-Stamp Header */
-    if (is_tsh_en == TRUE)
+    if (ftmh[BKN_DNX_FTMH_F_TSH_EN])
     {
         hdr_size += BKN_DNX_TSH_SIZE;
         DBG_DUNE(("Time-Stamp Header(4) is present\n"));
     }
 
     /* Packet Processing Header */
-    if (is_pph_en)
+    pph_layout = sinfo->dnx_pph;
+    if (ftmh[BKN_DNX_FTMH_F_PPH_EN])
     {
-        uint8_t  learn_ext_present;
-        uint8_t  fhei_size;
-        uint8_t  lif_ext_type;
+        uint32_t learn_ext_present = 0;
+        uint32_t fhei_size = 0;
+        uint32_t lif_ext_type = 0;
 
-        switch (sinfo->pph_base_size)
+        if (pph_layout != NULL)
         {
-            case BKN_DNX_PPH_BASE_TYPE_9:
-                /* FTMH: Forward-Domain */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_9_FORWARD_DOMAIN_MSB,
-                        BKN_DNX_PPH_9_FORWARD_DOMAIN_NOF_BITS,
-                        &fld_val);
-                packet_info->pph_forward_domain = fld_val;
-                /* FTMH: Learn-Extension-Present */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_9_LEARN_EXT_PRESENT_MSB,
-                        BKN_DNX_PPH_9_LEARN_EXT_PRESENT_NOF_BITS,
-                        &fld_val);
-                learn_ext_present = fld_val;
-                /* FTMH: FHEI-Size */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_9_FHEI_SIZE_MSB,
-                        BKN_DNX_PPH_9_FHEI_SIZE_NOF_BITS,
-                        &fld_val);
-                fhei_size = fld_val;
-                /* FTMH: LIF-Extension-Type */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_9_LIF_EXT_TYPE_MSB,
-                        BKN_DNX_PPH_9_LIF_EXT_TYPE_NOF_BITS,
-                        &fld_val);
-                lif_ext_type = fld_val;
-
-                hdr_size += BKN_DNX_PPH_BASE_TYPE_9;
-                DBG_DUNE(("PPH(10) FWD_DOMAIN %d, LEARN_EXT %d, FHEI_SIZE %d, LIF_EXT %d \n",
-                            packet_info->pph_forward_domain, learn_ext_present, fhei_size, lif_ext_type));
-                break;
-            case BKN_DNX_PPH_BASE_TYPE_10:
-                /* FTMH: Forward-Domain */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_10_FORWARD_DOMAIN_MSB,
-                        BKN_DNX_PPH_10_FORWARD_DOMAIN_NOF_BITS,
-                        &fld_val);
-                packet_info->pph_forward_domain = fld_val;
-                /* FTMH: Learn-Extension-Present */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_10_LEARN_EXT_PRESENT_MSB,
-                        BKN_DNX_PPH_10_LEARN_EXT_PRESENT_NOF_BITS,
-                        &fld_val);
-                learn_ext_present = fld_val;
-                /* FTMH: FHEI-Size */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_10_FHEI_SIZE_MSB,
-                        BKN_DNX_PPH_10_FHEI_SIZE_NOF_BITS,
-                        &fld_val);
-                fhei_size = fld_val;
-                /* FTMH: LIF-Extension-Type */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_10_LIF_EXT_TYPE_MSB,
-                        BKN_DNX_PPH_10_LIF_EXT_TYPE_NOF_BITS,
-                        &fld_val);
-                lif_ext_type = fld_val;
-
-                hdr_size += BKN_DNX_PPH_BASE_TYPE_10;
-                DBG_DUNE(("PPH(10) FWD_DOMAIN %d, LEARN_EXT %d, FHEI_SIZE %d, LIF_EXT %d \n",
-                            packet_info->pph_forward_domain, learn_ext_present, fhei_size, lif_ext_type));
-                break;
-            case BKN_DNX_PPH_BASE_TYPE_12:
-                /* FTMH: Forward-Domain */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_12_FORWARD_DOMAIN_MSB,
-                        BKN_DNX_PPH_12_FORWARD_DOMAIN_NOF_BITS,
-                        &fld_val);
-                packet_info->pph_forward_domain = fld_val;
-                /* FTMH: Learn-Extension-Present */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_12_LEARN_EXT_PRESENT_MSB,
-                        BKN_DNX_PPH_12_LEARN_EXT_PRESENT_NOF_BITS,
-                        &fld_val);
-                learn_ext_present = fld_val;
-                /* FTMH: FHEI-Size */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_12_FHEI_SIZE_MSB,
-                        BKN_DNX_PPH_12_FHEI_SIZE_NOF_BITS,
-                        &fld_val);
-                fhei_size = fld_val;
-                /* FTMH: LIF-Extension-Type */
-                bkn_bitstream_get_field(
-                        &buf[hdr_size],
-                        BKN_DNX_PPH_12_LIF_EXT_TYPE_MSB,
-                        BKN_DNX_PPH_12_LIF_EXT_TYPE_NOF_BITS,
-                        &fld_val);
-                lif_ext_type = fld_val;
-
-                hdr_size += BKN_DNX_PPH_BASE_TYPE_12;
-                DBG_DUNE(("PPH(12) FWD_DOMAIN %d, LEARN_EXT %d, FHEI_SIZE %d, LIF_EXT %d \n",
-                            packet_info->pph_forward_domain, learn_ext_present, fhei_size, lif_ext_type));
-                break;
-            default:
-                fhei_size = 0;
-                lif_ext_type = 0;
-                learn_ext_present = 0;
-                break;
+            bkn_hdr_flds_get(&buf[hdr_size], len - hdr_size, pph_layout->fld,
+                             BKN_DNX_PPH_F_COUNT, pph);
+            packet_info->pph_forward_domain = pph[BKN_DNX_PPH_F_FORWARD_DOMAIN];
+            learn_ext_present = pph[BKN_DNX_PPH_F_LEARN_EXT_PRESENT];
+            fhei_size = pph[BKN_DNX_PPH_F_FHEI_SIZE];
+            lif_ext_type = pph[BKN_DNX_PPH_F_LIF_EXT_TYPE];
+
+            hdr_size += pph_layout->base_size;
+            DBG_DUNE(("PPH(%d) FWD_DOMAIN %d, LEARN_EXT %d, FHEI_SIZE %d, LIF_EXT %d \n",
+                        pph_layout->base_size, packet_info->pph_forward_domain,
+                        learn_ext_present, fhei_size, lif_ext_type));
         }
         if (fhei_size)
         {
@@ -3339,30 +4241,14 @@ bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_l
                     DBG_DUNE(("FHEI(3) is present\n"));
                     break;
                 case BKN_DNX_PPH_FHEI_TYPE_SZ1:
-                    /* FHEI: Code */
-                    bkn_bitstream_get_field(
-                            &buf[hdr_size],
-                            BKN_DNX_PPH_FHEI_TRAP_5B_TYPE_MSB,
-                            BKN_DNX_PPH_FHEI_TRAP_5B_TYPE_NOF_BITS,
-                            &fld_val);
-                    packet_info->fhei_type = fld_val;
+                    bkn_hdr_flds_get(&buf[hdr_size], len - hdr_size,
+                                     bkn_dnx_fhei_flds, BKN_DNX_FHEI_F_COUNT, fhei);
+                    packet_info->fhei_type = fhei[BKN_DNX_FHEI_F_TYPE];
                     /* FHEI-Size == 5B, FHEI-Type == Trap/Sniff */
                     if (packet_info->fhei_type == 0x5)
                     {
-                        /* FHEI: Qualifier */
-                        bkn_bitstream_get_field(
-                                &buf[hdr_size],
-                                BKN_DNX_PPH_FHEI_TRAP_5B_QUALIFIER_MSB,
-                                BKN_DNX_PPH_FHEI_TRAP_5B_QUALIFIER_NOF_BITS,
-                                &fld_val);
-                        packet_info->fhei_qualifier = fld_val;
-                        /* FHEI: Code */
-                        bkn_bitstream_get_field(
-                                &buf[hdr_size],
-                                BKN_DNX_PPH_FHEI_TRAP_5B_CODE_MSB,
-                                BKN_DNX_PPH_FHEI_TRAP_5B_CODE_NOF_BITS,
-                                &fld_val);
-                        packet_info->fhei_code = fld_val;
+                        packet_info->fhei_qualifier = fhei[BKN_DNX_FHEI_F_QUALIFIER];
+                        packet_info->fhei_code = fhei[BKN_DNX_FHEI_F_CODE];
                     }
                     hdr_size += BKN_DNX_PPH_FHEI_SZ1_SIZE;
                     DBG_DUNE(("FHEI(5) is present code 0x%x qualifier 0x%x\n", packet_info->fhei_code, packet_info->fhei_qualifier));
@@ -3392,46 +4278,16 @@ bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_l
     /* UDH Header */
     if (sinfo->udh_enable)
     {
-        uint8 data_type_0;
-        uint8 data_type_1;
-        uint8 data_type_2;
-        uint8 data_type_3;
-
         DBG_DUNE(("UDH base(1) is present\n"));
 
-        /* UDH: UDH-Data-Type[0] */
-        bkn_bitstream_get_field(
-                &buf[hdr_size],
-                BKN_DNX_UDH_DATA_TYPE_0_MSB,
-                BKN_DNX_UDH_DATA_TYPE_0_NOF_BITS,
-                &fld_val);
-        data_type_0 = fld_val;
-        hdr_size += sinfo->udh_length_type[data_type_0];
-        /* UDH: UDH-Data-Type[1] */
-        bkn_bitstream_get_field(
-                &buf[hdr_size],
-                BKN_DNX_UDH_DATA_TYPE_1_MSB,
-                BKN_DNX_UDH_DATA_TYPE_1_NOF_BITS,
-                &fld_val);
-        data_type_1 = fld_val;
-        hdr_size += sinfo->udh_length_type[data_type_1];
-        /* UDH: UDH-Data-Type[2] */
-        bkn_bitstream_get_field(
-                &buf[hdr_size],
-                BKN_DNX_UDH_DATA_TYPE_2_MSB,
-                BKN_DNX_UDH_DATA_TYPE_2_NOF_BITS,
-                &fld_val);
-        data_type_2 = fld_val;
-        hdr_size += sinfo->udh_length_type[data_type_2];
-        /* UDH: UDH-Data-Type[3] */
-        bkn_bitstream_get_field(
-                &buf[hdr_size],
-                BKN_DNX_UDH_DATA_TYPE_3_MSB,
-                BKN_DNX_UDH_DATA_TYPE_3_NOF_BITS,
-                &fld_val);
-        data_type_3 = fld_val;
-        hdr_size += sinfo->udh_length_type[data_type_3];
+        /* UDH base carries the data types of all UDH data fields */
+        bkn_hdr_flds_get(&buf[hdr_size], len - hdr_size,
+                         bkn_dnx_udh_flds, BKN_DNX_UDH_F_COUNT, udh);
         hdr_size += BKN_DNX_UDH_BASE_SIZE;
+        hdr_size += sinfo->udh_length_type[udh[0]];
+        hdr_size += sinfo->udh_length_type[udh[1]];
+        hdr_size += sinfo->udh_length_type[udh[2]];
+        hdr_size += sinfo->udh_length_type[udh[3]];
     }
 
     /*
@@ -3460,12 +4316,9 @@ bkn_dnx_packet_header_parse(bkn_switch_info_t *sinfo, uint8 *buf, uint32_t buf_l
         DBG_DUNE(("Time-Stamp Header(4) is present\n"));
 
         /** Packet Processing Header */
-        bkn_bitstream_get_field(
-                &buf[hdr_size],
-                BKN_DNX_PPH_12_FORWARD_DOMAIN_MSB,
-                BKN_DNX_PPH_12_FORWARD_DOMAIN_NOF_BITS,
-                &fld_val);
-        packet_info->pph_forward_domain = fld_val;
+        bkn_hdr_flds_get(&buf[hdr_size], len - hdr_size,
+                         &bkn_dnx_pph12_layout.fld[BKN_DNX_PPH_F_FORWARD_DOMAIN],
+                         1, &packet_info->pph_forward_domain);
         hdr_size += BKN_DNX_PPH_BASE_TYPE_12;
         DBG_DUNE(("PPH(12) is present\n"));
 
@@ -3540,6 +4393,8 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             sinfo->rx[chan].chain_complete = 1;
         }
         sinfo->rx[chan].pkts++;
+        trace_bkn_rx_dcb_done(sinfo->dev_no, chan, dcb_chain->dcb_cur,
+                              dcb[sinfo->dcb_wsize-1]);
         if (sinfo->cmic_type == 'x') {
             pkt_dma = BUS_TO_DMA_HI(dcb[1]);
             pkt_dma = pkt_dma << 32 | dcb[0];
@@ -3637,7 +4492,10 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             }
         }
         drop_api = 1;
-        if (filter) {
+        if (filter && bkn_filter_police(filter)) {
+            DBG_FLTR(("Filter ID %d over policer rate\n", filter->kf.id));
+            sinfo->rx[chan].pkts_d_policed++;
+        } else if (filter) {
             DBG_FLTR(("Match filter ID %d\n", filter->kf.id));
             switch (filter->kf.dest_type) {
             case KCOM_DEST_T_API:
@@ -3743,14 +4601,11 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         bkn_eth_type_update(skb, ethertype);
                     }
                     DBG_DUNE(("skb protocol 0x%04x\n",skb->protocol));
+                    bkn_skb_record_rx_queue(skb, chan);
 
                     /* Unlock while calling up network stack */
                     spin_unlock(&sinfo->lock);
-                    if (use_napi) {
-                        netif_receive_skb(skb);
-                    } else {
-                        netif_rx(skb);
-                    }
+                    bkn_netif_rx(sinfo, skb);
                     spin_lock(&sinfo->lock);
 
                     if (filter->kf.mirror_type == KCOM_DEST_T_API ||
@@ -3781,6 +4636,7 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             dcb[sinfo->dcb_wsize-1] &= ~SOC_DCB_KNET_COUNT_MASK;
         }
         dcb[sinfo->dcb_wsize-1] |= SOC_DCB_KNET_DONE;
+        bkn_api_ring_put(sinfo, chan, dcb_chain, dcb);
         dcb_chain->dcb_cur++;
         dcbs_done++;
     }
@@ -3788,6 +4644,72 @@ bkn_do_api_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     return dcbs_done;
 }
 
+/*
+ * Scatter Rx: add the page of a done DCB to the frame being received on
+ * the channel. The frame is returned at its last DCB, with the status
+ * of the whole frame in that DCB, otherwise NULL is returned. The page
+ * is always consumed.
+ */
+static struct sk_buff *
+bkn_rx_sg_collect(bkn_switch_info_t *sinfo, int chan, bkn_desc_info_t *desc)
+{
+    struct sk_buff *skb = sinfo->rx[chan].sg_skb;
+    struct page *page = desc->page;
+    uint32_t *dcb = desc->dcb_mem;
+    uint32_t stat = dcb[sinfo->dcb_wsize-1];
+    int len = stat & SOC_DCB_KNET_COUNT_MASK;
+
+    DMA_UNMAP_SINGLE(sinfo->dma_dev,
+                     desc->skb_dma, desc->dma_size,
+                     DMA_FROMDEV);
+    desc->skb_dma = 0;
+    desc->page = NULL;
+
+    if (stat & SOC_DCB_RX_START) {
+        if (skb != NULL) {
+            /* End of previous frame was lost */
+            sinfo->rx[chan].pkts_d_sg++;
+            dev_kfree_skb_any(skb);
+        }
+        skb = build_skb(page_address(page), PAGE_SIZE);
+        if (skb == NULL) {
+            sinfo->rx[chan].pkts_d_no_skb++;
+            sinfo->rx[chan].sg_skb = NULL;
+            put_page(page);
+            return NULL;
+        }
+        skb_reserve(skb, BKN_RX_SG_HEADROOM);
+        skb_put(skb, len);
+        sinfo->rx[chan].sg_skb = skb;
+        sinfo->rx[chan].sg_stat = stat;
+    } else if (skb == NULL) {
+        /* Rest of a dropped frame */
+        put_page(page);
+        return NULL;
+    } else if (skb_shinfo(skb)->nr_frags >= MAX_SKB_FRAGS) {
+        sinfo->rx[chan].pkts_d_sg++;
+        dev_kfree_skb_any(skb);
+        sinfo->rx[chan].sg_skb = NULL;
+        put_page(page);
+        return NULL;
+    } else {
+        skb_add_rx_frag(skb, skb_shinfo(skb)->nr_frags, page,
+                        BKN_RX_SG_HEADROOM, len, PAGE_SIZE);
+        sinfo->rx[chan].sg_stat |= stat & SOC_DCB_RX_ERR_MASK;
+    }
+
+    if ((stat & SOC_DCB_RX_END) == 0) {
+        return NULL;
+    }
+
+    sinfo->rx[chan].sg_skb = NULL;
+    dcb[sinfo->dcb_wsize-1] = (stat & ~(SOC_DCB_KNET_COUNT_MASK | SOC_DCB_RX_START)) |
+                              (sinfo->rx[chan].sg_stat &
+                               (SOC_DCB_RX_START | SOC_DCB_RX_ERR_MASK)) |
+                              (skb->len & SOC_DCB_KNET_COUNT_MASK);
+    return skb;
+}
+
 static int
 bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 {
@@ -3801,6 +4723,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
     int ethertype;
     int pktlen;
     int idx;
+    int copied;
     int dcbs_done = 0;
     bkn_dune_system_header_info_t packet_info = {0};
     uint32_t dnx_meta_data[3] = {0};
@@ -3827,7 +4750,16 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                 sinfo->napi_poll_again = 1;
             }
         }
+        if (sinfo->rx_sg) {
+            /* Frame is processed at its last DCB */
+            desc->skb = bkn_rx_sg_collect(sinfo, chan, desc);
+            if (desc->skb == NULL) {
+                goto rx_dcb_done;
+            }
+        }
         sinfo->rx[chan].pkts++;
+        trace_bkn_rx_dcb_done(sinfo->dev_no, chan, sinfo->rx[chan].dirty,
+                              dcb[sinfo->dcb_wsize-1]);
         skb = desc->skb;
         if (sinfo->cmic_type == 'x') {
             if (device_is_dnx(sinfo)){
@@ -3847,11 +4779,18 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
         pktlen = dcb[sinfo->dcb_wsize-1] & 0xffff;
         priv = netdev_priv(sinfo->dev);
         DBG_DCB_RX(("Rx%d SKB DMA done (%d).\n", chan, sinfo->rx[chan].dirty));
-        DMA_UNMAP_SINGLE(sinfo->dma_dev,
-                         desc->skb_dma, desc->dma_size,
-                         DMA_FROMDEV);
-        desc->skb_dma = 0;
-        bkn_dump_pkt(skb->data, pktlen, XGS_DMA_RX_CHAN);
+        /*
+         * Keep the buffer mapped, so it can be recycled without a new
+         * DMA mapping unless it is passed up the network stack.
+         */
+        if (!sinfo->rx_sg) {
+            DMA_SYNC_FOR_CPU(sinfo->dma_dev,
+                             desc->skb_dma, desc->dma_size,
+                             DMA_FROMDEV);
+        }
+        bkn_dump_pkt(skb->data, sinfo->rx_sg ? skb_headlen(skb) : pktlen,
+                     XGS_DMA_RX_CHAN);
+        copied = 0;
 
         if (device_is_dpp(sinfo)) {
             uint16_t tpid = 0;
@@ -3929,7 +4868,11 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             }
         }
         DBG_PKT(("Rx packet (%d bytes).\n", pktlen));
-        if (filter) {
+        if (filter && bkn_filter_police(filter)) {
+            DBG_FLTR(("Filter ID %d over policer rate\n", filter->kf.id));
+            sinfo->rx[chan].pkts_d_policed++;
+            priv->stats.rx_dropped++;
+        } else if (filter) {
             DBG_FLTR(("Match filter ID %d\n", filter->kf.id));
             switch (filter->kf.dest_type) {
             case KCOM_DEST_T_API:
@@ -3955,14 +4898,62 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         bkn_api_rx_copy_from_skb(sinfo, chan, desc);
                     }
 
-                    if (device_is_dpp(sinfo)) {
-                        if (filter->kf.mirror_type == KCOM_DEST_T_API) {
-                            sinfo->rx[chan].pkts_m_api++;
-                            bkn_api_rx_copy_from_skb(sinfo, chan, desc);
+#ifdef BKN_XDP_SUPPORT
+                    /* XDP needs the frame in a single buffer */
+                    if (priv->xdp_prog && !skb_is_nonlinear(skb)) {
+                        int xdp_off = 0;
+                        int xdp_len;
+                        if (device_is_dpp(sinfo)) {
+                            xdp_off = packet_info.ntwrk_header_ptr;
+                        } else if (device_is_dnx(sinfo)) {
+                            xdp_off = packet_info.system_header_size;
+                        } else if (sinfo->cmic_type == 'x') {
+                            xdp_off = sinfo->pkt_hdr_size;
                         }
-                        /* Strip Dune headers */
-                        skb->data += packet_info.ntwrk_header_ptr;
-                        pktlen -= packet_info.ntwrk_header_ptr;
+                        xdp_len = pktlen - xdp_off;
+                        if (!device_is_sand(sinfo)) {
+                            xdp_len -= 4; /* CRC */
+                        }
+                        if (bkn_do_xdp(priv, skb->data + xdp_off,
+                                       xdp_len) != XDP_PASS) {
+                            /* Rx buffer is recycled */
+                            sinfo->rx[chan].pkts_d_xdp++;
+                            priv->stats.rx_dropped++;
+                            break;
+                        }
+                    }
+#endif
+
+                    if (pktlen <= rx_copybreak && !sinfo->rx_sg) {
+                        /* Copy small packets and keep the Rx DMA buffer */
+                        struct sk_buff *cskb;
+                        cskb = dev_alloc_skb(pktlen + RCPU_RX_ENCAP_SIZE);
+                        if (cskb != NULL) {
+                            skb_reserve(cskb, sinfo->cmic_type == 'x' ?
+                                        RCPU_HDR_SIZE : RCPU_RX_ENCAP_SIZE);
+                            memcpy(cskb->data, skb->data, pktlen);
+                            skb = cskb;
+                            if (sinfo->cmic_type == 'x' && !device_is_dnx(sinfo)) {
+                                meta = (uint32_t *)skb->data;
+                            }
+                            copied = 1;
+                        }
+                    }
+                    if (!copied && !sinfo->rx_sg) {
+                        DMA_UNMAP_SINGLE(sinfo->dma_dev,
+                                         desc->skb_dma, desc->dma_size,
+                                         DMA_FROMDEV);
+                        desc->skb_dma = 0;
+                    }
+
+                    if (device_is_dpp(sinfo)) {
+                        if (filter->kf.mirror_type == KCOM_DEST_T_API) {
+                            sinfo->rx[chan].pkts_m_api++;
+                            bkn_api_rx_copy_from_skb(sinfo, chan, desc);
+                        }
+                        /* Strip Dune headers */
+                        skb->data += packet_info.ntwrk_header_ptr;
+                        pktlen -= packet_info.ntwrk_header_ptr;
                         bkn_dump_pkt(skb->data, 32, XGS_DMA_RX_CHAN);
                         /* CRC has been stripped on Dune*/
                         skb_put(skb, pktlen);
@@ -3977,6 +4968,8 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         bkn_dump_pkt(skb->data, 32, XGS_DMA_RX_CHAN);
                         /* CRC has been stripped on Dune*/
                         skb_put(skb, pktlen);
+                    } else if (sinfo->rx_sg) {
+                        pskb_trim(skb, pktlen - 4); /* Strip CRC */
                     } else {
                         skb_put(skb, pktlen - 4); /* Strip CRC */
                     }
@@ -4032,7 +5025,9 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                             /* Consumed by call-back */
                             sinfo->rx[chan].pkts_d_callback++;
                             priv->stats.rx_dropped++;
-                            desc->skb = NULL;
+                            if (!copied) {
+                                desc->skb = NULL;
+                            }
                             break;
                         }
                     }
@@ -4055,6 +5050,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                         bkn_eth_type_update(skb, ethertype);
                     }
                     DBG_DUNE(("skb protocol 0x%04x\n",skb->protocol));
+                    bkn_skb_record_rx_queue(skb, chan);
 
                     if (filter->kf.mirror_type == KCOM_DEST_T_NETIF) {
                         bkn_priv_t *mpriv;
@@ -4074,11 +5070,7 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
                                 }
                                 /* Unlock while calling up network stack */
                                 spin_unlock(&sinfo->lock);
-                                if (use_napi) {
-                                    netif_receive_skb(mskb);
-                                } else {
-                                    netif_rx(mskb);
-                                }
+                                bkn_netif_rx(sinfo, mskb);
                                 spin_lock(&sinfo->lock);
                             }
                         }
@@ -4086,15 +5078,13 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 
                     /* Unlock while calling up network stack */
                     spin_unlock(&sinfo->lock);
-                    if (use_napi) {
-                        netif_receive_skb(skb);
-                    } else {
-                        netif_rx(skb);
-                    }
+                    bkn_netif_rx(sinfo, skb);
                     spin_lock(&sinfo->lock);
 
                     /* Ensure that we reallocate SKB for this DCB */
-                    desc->skb = NULL;
+                    if (!copied) {
+                        desc->skb = NULL;
+                    }
                 } else {
                     DBG_FLTR(("Unknown netif %d\n",
                               filter->kf.dest_id));
@@ -4113,6 +5103,12 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
             sinfo->rx[chan].pkts_d_no_match++;
             priv->stats.rx_dropped++;
         }
+        if (sinfo->rx_sg && desc->skb != NULL) {
+            /* Frame was not passed up, page buffers are not recycled */
+            dev_kfree_skb_any(desc->skb);
+            desc->skb = NULL;
+        }
+rx_dcb_done:
         dcb[sinfo->dcb_wsize-1] &= ~(1 << 31);
         if (++sinfo->rx[chan].dirty >= MAX_RX_DCBS) {
             sinfo->rx[chan].dirty = 0;
@@ -4131,13 +5127,31 @@ bkn_do_skb_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 static int
 bkn_do_rx(bkn_switch_info_t *sinfo, int chan, int budget)
 {
+    int dcbs_done;
+    int perf_polled = 0;
+
+    if (bkn_perf_active && sinfo->perf_rx_ts == 0) {
+        /* Polled without an interrupt */
+        sinfo->perf_rx_ts = ktime_to_ns(ktime_get());
+        perf_polled = 1;
+    }
+
+    /* Filters and netifs are only referenced within this section */
+    rcu_read_lock();
     if (sinfo->rx[chan].use_rx_skb == 0) {
         /* Rx buffers are provided by BCM Rx API */
-        return bkn_do_api_rx(sinfo, chan, budget);
+        dcbs_done = bkn_do_api_rx(sinfo, chan, budget);
     } else {
         /* Rx buffers are provided by Linux kernel */
-        return bkn_do_skb_rx(sinfo, chan, budget);
+        dcbs_done = bkn_do_skb_rx(sinfo, chan, budget);
+    }
+    rcu_read_unlock();
+
+    if (perf_polled) {
+        sinfo->perf_rx_ts = 0;
     }
+
+    return dcbs_done;
 }
 
 static void
@@ -4148,6 +5162,9 @@ bkn_rx_desc_done(bkn_switch_info_t *sinfo, int chan)
     DBG_IRQ(("Rx%d desc done\n", chan));
 
     if (sinfo->rx[chan].use_rx_skb == 0) {
+        if (bkn_api_ring_kick(sinfo)) {
+            return;
+        }
         sinfo->dma_events |= KCOM_DMA_INFO_F_RX_DONE;
         evt->evt_wq_put++;
         wake_up_interruptible(&evt->evt_wq);
@@ -4207,23 +5224,22 @@ bkn_rx_chain_done(bkn_switch_info_t *sinfo, int chan)
 static void
 bkn_suspend_tx(bkn_switch_info_t *sinfo)
 {
-    struct list_head *list;
     bkn_priv_t *priv = netdev_priv(sinfo->dev);
 
     /* Stop main device */
     netif_stop_queue(priv->dev);
     sinfo->tx.suspends++;
     /* Stop associated virtual devices */
-    list_for_each(list, &sinfo->ndev_list) {
-        priv = (bkn_priv_t *)list;
+    rcu_read_lock();
+    list_for_each_entry_rcu(priv, &sinfo->ndev_list, list) {
         netif_stop_queue(priv->dev);
     }
+    rcu_read_unlock();
 }
 
 static void
 bkn_resume_tx(bkn_switch_info_t *sinfo)
 {
-    struct list_head *list;
     bkn_priv_t *priv = netdev_priv(sinfo->dev);
 
     /* Check main device */
@@ -4231,12 +5247,13 @@ bkn_resume_tx(bkn_switch_info_t *sinfo)
         netif_wake_queue(priv->dev);
     }
     /* Check associated virtual devices */
-    list_for_each(list, &sinfo->ndev_list) {
-        priv = (bkn_priv_t *)list;
+    rcu_read_lock();
+    list_for_each_entry_rcu(priv, &sinfo->ndev_list, list) {
         if (netif_queue_stopped(priv->dev) && sinfo->tx.free > 1) {
             netif_wake_queue(priv->dev);
         }
     }
+    rcu_read_unlock();
 }
 
 static int
@@ -4263,19 +5280,128 @@ bkn_hw_tstamp_tx_set(bkn_switch_info_t *sinfo, struct sk_buff *skb)
     return 0;
 }
 
-static void
-bkn_hw_tstamp_tx_work(struct work_struct *work)
+#define BKN_TX_TS_STAT_INC(_sinfo, _skb, _cnt)                  \
+    do {                                                        \
+        int _port = KNET_SKB_CB(_skb)->port;                    \
+        (_sinfo)->tx_ts.total._cnt++;                           \
+        if (_port >= 0 && _port < BKN_TX_TS_PORT_MAX) {         \
+            (_sinfo)->tx_ts.port[_port]._cnt++;                 \
+        }                                                       \
+    } while (0)
+
+/*
+ * Retrieve pending Tx timestamps in completion order.
+ * Called with sinfo->lock held.
+ *
+ * Returns the number of skbs still waiting for a timestamp.
+ */
+static int
+bkn_hw_tstamp_tx_poll(bkn_switch_info_t *sinfo, int retry)
 {
-    bkn_switch_info_t *sinfo = container_of(work, bkn_switch_info_t, tx_ptp_work);
     struct sk_buff *skb;
 
-    while (skb_queue_len(&sinfo->tx_ptp_queue)) {
-        skb = skb_dequeue(&sinfo->tx_ptp_queue);
-        if (bkn_hw_tstamp_tx_set(sinfo, skb) < 0) {
-            gprintk("Timestamp has not been taken for the current skb.\n");
+    while (sinfo->tx_ts.head != sinfo->tx_ts.tail) {
+        skb = sinfo->tx_ts.skb[sinfo->tx_ts.head & (BKN_TX_TS_RING_SIZE - 1)];
+        if (bkn_hw_tstamp_tx_set(sinfo, skb) == 0) {
+            if (retry || sinfo->tx_ts.retries) {
+                BKN_TX_TS_STAT_INC(sinfo, skb, late);
+            } else {
+                BKN_TX_TS_STAT_INC(sinfo, skb, ok);
+            }
+        } else if (knet_hw_tstamp_tx_time_get_cb &&
+                   retry && sinfo->tx_ts.retries < tx_ts_retries) {
+            /* Not ready yet, try again later */
+            sinfo->tx_ts.retries++;
+            break;
+        } else if (knet_hw_tstamp_tx_time_get_cb && !retry) {
+            /* Leave it for the retry timer */
+            break;
+        } else {
+            DBG_WARN(("Timestamp has not been taken for the current skb.\n"));
+            BKN_TX_TS_STAT_INC(sinfo, skb, missed);
         }
         dev_kfree_skb_any(skb);
+        sinfo->tx_ts.head++;
+        sinfo->tx_ts.retries = 0;
+    }
+
+    return sinfo->tx_ts.tail - sinfo->tx_ts.head;
+}
+
+/*
+ * Called with sinfo->lock held.
+ */
+static void
+bkn_hw_tstamp_tx_retry_start(bkn_switch_info_t *sinfo)
+{
+#ifdef BKN_RX_HRTIMER
+    if (!sinfo->tx_ts.timer_armed) {
+        sinfo->tx_ts.timer_armed = 1;
+        hrtimer_start(&sinfo->tx_ts.timer,
+                      ktime_set(0, tx_ts_retry_us * NSEC_PER_USEC),
+                      HRTIMER_MODE_REL);
+    }
+#else
+    /* No retry timer, so give up on timestamps which are not ready */
+    do {
+        sinfo->tx_ts.retries = tx_ts_retries;
+    } while (bkn_hw_tstamp_tx_poll(sinfo, 1));
+#endif
+}
+
+#ifdef BKN_RX_HRTIMER
+static enum hrtimer_restart
+bkn_hw_tstamp_tx_timer(struct hrtimer *t)
+{
+    bkn_switch_info_t *sinfo = container_of(t, bkn_switch_info_t, tx_ts.timer);
+    unsigned long flags;
+    int pending;
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    pending = bkn_hw_tstamp_tx_poll(sinfo, 1);
+    if (!pending) {
+        sinfo->tx_ts.timer_armed = 0;
+    }
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    if (pending) {
+        hrtimer_forward_now(t, ktime_set(0, tx_ts_retry_us * NSEC_PER_USEC));
+        return HRTIMER_RESTART;
+    }
+    return HRTIMER_NORESTART;
+}
+#endif
+
+/*
+ * Queue a Tx skb for timestamp retrieval once its DCB is done.
+ * Called with sinfo->lock held.
+ */
+static void
+bkn_hw_tstamp_tx_queue(bkn_switch_info_t *sinfo, struct sk_buff *skb)
+{
+    if (sinfo->tx_ts.tail - sinfo->tx_ts.head >= BKN_TX_TS_RING_SIZE) {
+        DBG_WARN(("Tx timestamp ring full.\n"));
+        BKN_TX_TS_STAT_INC(sinfo, skb, missed);
+        dev_kfree_skb_any(skb);
+        return;
+    }
+    sinfo->tx_ts.skb[sinfo->tx_ts.tail & (BKN_TX_TS_RING_SIZE - 1)] = skb;
+    sinfo->tx_ts.tail++;
+}
+
+/*
+ * Drop all skbs waiting for a Tx timestamp.
+ * Called with sinfo->lock held.
+ */
+static void
+bkn_hw_tstamp_tx_purge(bkn_switch_info_t *sinfo)
+{
+    while (sinfo->tx_ts.head != sinfo->tx_ts.tail) {
+        dev_kfree_skb_any(sinfo->tx_ts.skb[sinfo->tx_ts.head &
+                                           (BKN_TX_TS_RING_SIZE - 1)]);
+        sinfo->tx_ts.head++;
     }
+    sinfo->tx_ts.retries = 0;
 }
 
 static int
@@ -4299,19 +5425,17 @@ bkn_do_tx(bkn_switch_info_t *sinfo)
         if ((desc->dcb_mem[sinfo->dcb_wsize-1] & (1 << 31)) == 0) {
             break;
         }
+        /* Fragments of a scatter-gather packet have no skb attached */
+        bkn_tx_desc_unmap(sinfo, desc);
         if (desc->skb) {
             DBG_DCB_TX(("Tx SKB DMA done (%d).\n", sinfo->tx.dirty));
-            DMA_UNMAP_SINGLE(sinfo->dma_dev,
-                             desc->skb_dma, desc->dma_size,
-                             DMA_TODEV);
+            trace_bkn_tx_done(sinfo->dev_no, desc->skb, sinfo->tx.dirty);
             if (bkn_skb_tx_flags(desc->skb) & SKBTX_IN_PROGRESS) {
-                skb_queue_tail(&sinfo->tx_ptp_queue, desc->skb);
-                schedule_work(&sinfo->tx_ptp_work);
+                bkn_hw_tstamp_tx_queue(sinfo, desc->skb);
             } else {
                 dev_kfree_skb_any(desc->skb);
             }
             desc->skb = NULL;
-            desc->skb_dma = 0;
         }
         desc->dcb_mem[sinfo->dcb_wsize-1] &= ~(1 << 31);
         if (++sinfo->tx.dirty >= MAX_TX_DCBS) {
@@ -4323,6 +5447,12 @@ bkn_do_tx(bkn_switch_info_t *sinfo)
         dcbs_done++;
     }
 
+    if (sinfo->tx_ts.head != sinfo->tx_ts.tail) {
+        if (bkn_hw_tstamp_tx_poll(sinfo, 0)) {
+            bkn_hw_tstamp_tx_retry_start(sinfo);
+        }
+    }
+
     return dcbs_done;
 }
 
@@ -4583,17 +5713,50 @@ bkn_schedule_napi_poll(bkn_switch_info_t *sinfo)
 }
 
 static void
-bkn_napi_poll_complete(bkn_switch_info_t *sinfo)
+bkn_napi_poll_complete(bkn_switch_info_t *sinfo, int work_done)
 {
     /* Unlock while calling up network stack */
     spin_unlock(&sinfo->lock);
     bkn_napi_complete(sinfo->dev, &sinfo->napi);
     spin_lock(&sinfo->lock);
+    sinfo->perf_rx_ts = 0;
+#ifdef BKN_RX_HRTIMER
+    /*
+     * Interrupt moderation: keep interrupts masked and poll again
+     * from the hold-off timer for as long as packets keep arriving.
+     */
+    if (sinfo->rx_coal_usecs && (work_done || !sinfo->coal_holdoff)) {
+        sinfo->coal_holdoff = 1;
+        hrtimer_start(&sinfo->coal_timer,
+                      ktime_set(0, sinfo->rx_coal_usecs * NSEC_PER_USEC),
+                      HRTIMER_MODE_REL);
+        return;
+    }
+    sinfo->coal_holdoff = 0;
+#endif
     /* Re-enable interrupts */
     sinfo->napi_poll_mode = 0;
     dev_irq_mask_set(sinfo, sinfo->irq_mask);
 }
 
+#ifdef BKN_RX_HRTIMER
+static enum hrtimer_restart
+bkn_coal_timer(struct hrtimer *t)
+{
+    bkn_switch_info_t *sinfo = container_of(t, bkn_switch_info_t, coal_timer);
+    unsigned long flags;
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    if (sinfo->coal_holdoff) {
+        sinfo->coal_polls++;
+        bkn_schedule_napi_poll(sinfo);
+    }
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    return HRTIMER_NORESTART;
+}
+#endif
+
 static int
 xgs_do_dma(bkn_switch_info_t *sinfo, int budget)
 {
@@ -4916,6 +6079,10 @@ bkn_isr(void *isr_data)
         return;
     }
 
+    if (bkn_perf_active) {
+        sinfo->perf_rx_ts = ktime_to_ns(ktime_get());
+    }
+
     if (DEV_IS_CMICX(sinfo)) {
         xgsx_isr(sinfo);
     } else if (DEV_IS_CMICM(sinfo)) {
@@ -4924,6 +6091,11 @@ bkn_isr(void *isr_data)
         xgs_isr(sinfo);
     }
 
+    if (bkn_perf_active && !use_napi) {
+        /* Packets were processed from the interrupt handler */
+        sinfo->perf_rx_ts = 0;
+    }
+
     spin_unlock(&sinfo->lock);
 }
 
@@ -5136,7 +6308,7 @@ bkn_poll(struct net_device *dev, int *budget)
         poll_again = 1;
         sinfo->napi_not_done++;
     } else {
-        bkn_napi_poll_complete(sinfo);
+        bkn_napi_poll_complete(sinfo, rx_dcbs_done);
     }
 
     spin_unlock_irqrestore(&sinfo->lock, flags);
@@ -5164,7 +6336,7 @@ bkn_poll(struct napi_struct *napi, int budget)
         rx_dcbs_done = budget;
         sinfo->napi_not_done++;
     } else {
-        bkn_napi_poll_complete(sinfo);
+        bkn_napi_poll_complete(sinfo, rx_dcbs_done);
     }
 
     spin_unlock_irqrestore(&sinfo->lock, flags);
@@ -5187,6 +6359,17 @@ bkn_stop(struct net_device *dev)
         /* NAPI used only on base device */
         if (use_napi) {
             bkn_napi_disable(dev, &sinfo->napi);
+#ifdef BKN_RX_HRTIMER
+            /* Drop pending interrupt hold-off */
+            hrtimer_cancel(&sinfo->coal_timer);
+            spin_lock_irqsave(&sinfo->lock, flags);
+            if (sinfo->coal_holdoff) {
+                sinfo->coal_holdoff = 0;
+                sinfo->napi_poll_mode = 0;
+                dev_irq_mask_set(sinfo, sinfo->irq_mask);
+            }
+            spin_unlock_irqrestore(&sinfo->lock, flags);
+#endif
         }
         /* Suspend all devices if base device is stopped */
         if (basedev_suspend) {
@@ -5256,15 +6439,157 @@ bkn_hw_tstamp_tx_config(bkn_switch_info_t *sinfo, struct sk_buff *skb, uint32_t
     return 0;
 }
 
+/*
+ * In Continuous DMA mode the Tx DMA is kicked by moving the halt
+ * location. When the stack signals that more packets are following
+ * (xmit_more), this is deferred until the last packet of the batch.
+ */
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0))
+#define bkn_xmit_more(_skb)     netdev_xmit_more()
+#elif (LINUX_VERSION_CODE >= KERNEL_VERSION(3,18,0))
+#define bkn_xmit_more(_skb)     ((_skb)->xmit_more)
+#else
+#define bkn_xmit_more(_skb)     0
+#endif
+
+/* Called with sinfo->lock held */
+static void
+bkn_tx_doorbell(bkn_switch_info_t *sinfo)
+{
+    if (sinfo->tx.doorbell_pending) {
+        sinfo->tx.doorbell_pending = 0;
+        if (!sinfo->tx.api_active) {
+            /* DMA run to the new halt location */
+            bkn_cdma_goto(sinfo, XGS_DMA_TX_CHAN,
+                          sinfo->tx.desc[sinfo->tx.cur].dcb_dma);
+            sinfo->tx.doorbells++;
+        }
+    }
+}
+
+/* Set packet buffer address and byte count of a Tx DCB */
+static inline void
+bkn_tx_dcb_buf_set(bkn_switch_info_t *sinfo, uint32_t *dcb,
+                   uint64_t buf_dma, int len)
+{
+    dcb[0] = buf_dma;
+    if (sinfo->cmic_type == 'x') {
+        dcb[1] = DMA_TO_BUS_HI(buf_dma >> 32);
+        dcb[2] &= ~SOC_DCB_KNET_COUNT_MASK;
+        dcb[2] |= len;
+    } else {
+        dcb[1] &= ~SOC_DCB_KNET_COUNT_MASK;
+        dcb[1] |= len;
+    }
+}
+
+/*
+ * Prepare a fragmented skb for Tx. If the fragments fit in the Tx ring
+ * without wrapping, only the packet headers are pulled into a private
+ * linear part, such that tags and system headers can be inserted in
+ * place. Otherwise the skb is linearized.
+ *
+ * Called with sinfo->lock held.
+ */
+static int
+bkn_tx_sg_prep(bkn_switch_info_t *sinfo, struct sk_buff *skb, int hdrlen)
+{
+#ifdef BKN_TX_SG
+    int ndcbs = skb_shinfo(skb)->nr_frags + 2;
+
+    /* Tx call-backs expect a linear packet */
+    if (use_tx_sg && CDMA_CH(sinfo, XGS_DMA_TX_CHAN) && knet_tx_cb == NULL &&
+        sinfo->tx.free > ndcbs && (sinfo->tx.cur + ndcbs) <= MAX_TX_DCBS) {
+        /* Headroom for system headers, VLAN tag and DPP PTCH/ITMH */
+        if (pskb_may_pull(skb, min_t(int, skb->len, BKN_TX_SG_PULL_SZ)) &&
+            skb_cow_head(skb, hdrlen + TAG_SZ + 8) == 0) {
+            return 0;
+        }
+    }
+    sinfo->tx.sg_linearize++;
+#endif
+    return skb_linearize(skb);
+}
+
+/*
+ * Map the linear part and the page fragments of an skb to consecutive
+ * Tx DCBs starting at the current DCB, which already holds the packet
+ * meta data. The skb is attached to the final FCS pad DCB.
+ *
+ * Returns the number of DCBs used or -1 if DMA mapping failed.
+ */
 static int
-bkn_tx(struct sk_buff *skb, struct net_device *dev)
+bkn_tx_sg_map(bkn_switch_info_t *sinfo, struct sk_buff *skb,
+              unsigned char *pktdata)
+{
+#ifdef BKN_TX_SG
+    bkn_desc_info_t *desc = &sinfo->tx.desc[sinfo->tx.cur];
+    bkn_desc_info_t *fdesc;
+    uint32_t *dcb = desc->dcb_mem;
+    uint32_t *fdcb;
+    skb_frag_t *frag;
+    int nr_frags = skb_shinfo(skb)->nr_frags;
+    int woff = (sinfo->cmic_type == 'x') ? 2 : 1;
+    int cnt, idx;
+
+    desc->dma_size = skb_headlen(skb) - (pktdata - skb->data);
+    desc->skb_dma = DMA_MAP_SINGLE(sinfo->dma_dev,
+                                   pktdata, desc->dma_size,
+                                   DMA_TODEV);
+    if (DMA_MAPPING_ERROR(sinfo->dma_dev, desc->skb_dma)) {
+        desc->skb_dma = 0;
+        return -1;
+    }
+    bkn_tx_dcb_buf_set(sinfo, dcb, desc->skb_dma, desc->dma_size);
+    /* Packet continues in next DCB */
+    dcb[woff] |= 1 << 17;
+
+    cnt = 1;
+    for (idx = 0; idx <= nr_frags; idx++, cnt++) {
+        fdesc = &sinfo->tx.desc[sinfo->tx.cur + cnt];
+        fdcb = fdesc->dcb_mem;
+        /* Each DCB carries the same meta data */
+        memcpy(fdcb, dcb, (sinfo->dcb_wsize - 1) * sizeof(uint32_t));
+        fdcb[sinfo->dcb_wsize-1] = 0;
+        fdcb[woff] |= 1 << 24 | 1 << 16;
+        if (idx == nr_frags) {
+            fdcb[woff] &= ~(1 << 17);
+            bkn_tx_dcb_buf_set(sinfo, fdcb, sinfo->tx.fcs_dma, FCS_SZ);
+            fdesc->skb = skb;
+            break;
+        }
+        frag = &skb_shinfo(skb)->frags[idx];
+        fdesc->dma_size = skb_frag_size(frag);
+        fdesc->skb_dma = DMA_MAP_PAGE(sinfo->dma_dev, skb_frag_page(frag),
+                                      bkn_skb_frag_off(frag),
+                                      fdesc->dma_size, DMA_TODEV);
+        if (DMA_MAPPING_ERROR(sinfo->dma_dev, fdesc->skb_dma)) {
+            fdesc->skb_dma = 0;
+            while (cnt-- > 0) {
+                bkn_tx_desc_unmap(sinfo, &sinfo->tx.desc[sinfo->tx.cur + cnt]);
+            }
+            return -1;
+        }
+        fdesc->dma_page = 1;
+        bkn_tx_dcb_buf_set(sinfo, fdcb, fdesc->skb_dma, fdesc->dma_size);
+    }
+    sinfo->tx.sg_pkts++;
+
+    return cnt + 1;
+#else
+    return -1;
+#endif
+}
+
+static int
+bkn_tx_skb(struct sk_buff *skb, struct net_device *dev, int xmit_more)
 {
     bkn_priv_t *priv = netdev_priv(dev);
     bkn_switch_info_t *sinfo = priv->sinfo;
     struct sk_buff *new_skb = NULL;
     unsigned char *pktdata;
     int pktlen, hdrlen, taglen, rcpulen, metalen;
-    int sop, idx;
+    int sop, idx, ndcbs;
     uint16_t tpid;
     uint32_t *metadata;
     unsigned long flags;
@@ -5286,6 +6611,13 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         return 0;
     }
 
+    if (sinfo->wb_retained) {
+        /* DMA is stopped until the restarted SDK reclaims the netifs */
+        priv->stats.tx_dropped++;
+        dev_kfree_skb_any(skb);
+        return 0;
+    }
+
     spin_lock_irqsave(&sinfo->lock, flags);
 
     if (sinfo->tx.free > 1) {
@@ -5298,6 +6630,19 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         rcpulen = 0;
         sop = 0;
 
+        if (skb_is_nonlinear(skb)) {
+            if (bkn_tx_sg_prep(sinfo, skb, hdrlen) != 0) {
+                DBG_WARN(("Tx drop: No SKB memory\n"));
+                priv->stats.tx_dropped++;
+                sinfo->tx.pkts_d_no_skb++;
+                dev_kfree_skb_any(skb);
+                spin_unlock_irqrestore(&sinfo->lock, flags);
+                return 0;
+            }
+            /* Linear part may have been reallocated */
+            pktdata = skb->data;
+        }
+
         if (priv->flags & KCOM_NETIF_F_RCPU_ENCAP) {
             rcpulen = RCPU_HDR_SIZE;
             if (skb->len < (rcpulen + 14)) {
@@ -5716,34 +7061,40 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         }
 
         /* Prepare for DMA */
-        desc->skb = skb;
         /* Add FCS bytes */
         pktlen = pktlen + FCS_SZ;
-        desc->dma_size = pktlen;
-        desc->skb_dma = DMA_MAP_SINGLE(sinfo->dma_dev,
-                                       pktdata, desc->dma_size,
-                                       DMA_TODEV);
-        if (DMA_MAPPING_ERROR(sinfo->dma_dev, desc->skb_dma)) {
-            priv->stats.tx_dropped++;
-            dev_kfree_skb_any(skb);
-            spin_unlock_irqrestore(&sinfo->lock, flags);
-            return 0;
-        }
-        dcb[0] = desc->skb_dma;
-        if (sinfo->cmic_type == 'x') {
-            dcb[1] = DMA_TO_BUS_HI(desc->skb_dma >> 32);
-            dcb[2] &= ~SOC_DCB_KNET_COUNT_MASK;
-            dcb[2] |= pktlen;
+        if (skb_is_nonlinear(skb)) {
+            ndcbs = bkn_tx_sg_map(sinfo, skb, pktdata);
+            if (ndcbs < 0) {
+                priv->stats.tx_dropped++;
+                dev_kfree_skb_any(skb);
+                spin_unlock_irqrestore(&sinfo->lock, flags);
+                return 0;
+            }
         } else {
-            dcb[1] &= ~SOC_DCB_KNET_COUNT_MASK;
-            dcb[1] |= pktlen;
+            ndcbs = 1;
+            desc->skb = skb;
+            desc->dma_size = pktlen;
+            desc->skb_dma = DMA_MAP_SINGLE(sinfo->dma_dev,
+                                           pktdata, desc->dma_size,
+                                           DMA_TODEV);
+            if (DMA_MAPPING_ERROR(sinfo->dma_dev, desc->skb_dma)) {
+                desc->skb = NULL;
+                desc->skb_dma = 0;
+                priv->stats.tx_dropped++;
+                dev_kfree_skb_any(skb);
+                spin_unlock_irqrestore(&sinfo->lock, flags);
+                return 0;
+            }
+            bkn_tx_dcb_buf_set(sinfo, dcb, desc->skb_dma, pktlen);
         }
 
         bkn_dump_dcb("Tx RCPU", dcb, sinfo->dcb_wsize, XGS_DMA_TX_CHAN);
-        DBG_DCB_TX(("Add Tx DCB @ 0x%08x (%d) [%d free] (%d bytes).\n",
+        DBG_DCB_TX(("Add Tx DCB @ 0x%08x (%d) [%d free] (%d bytes, %d DCBs).\n",
                     (uint32_t)desc->dcb_dma, sinfo->tx.cur,
-                    sinfo->tx.free, pktlen));
-        bkn_dump_pkt(pktdata, pktlen, XGS_DMA_TX_CHAN);
+                    sinfo->tx.free, pktlen, ndcbs));
+        bkn_dump_pkt(pktdata, (ndcbs > 1) ? desc->dma_size : pktlen,
+                     XGS_DMA_TX_CHAN);
 
         if (CDMA_CH(sinfo, XGS_DMA_TX_CHAN)) {
             if (sinfo->cmic_type == 'x') {
@@ -5754,15 +7105,18 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         } else {
             bkn_tx_dma_start(sinfo);
         }
-        if (++sinfo->tx.cur >= MAX_TX_DCBS) {
+        trace_bkn_tx_enqueue(sinfo->dev_no, dev, skb, sinfo->tx.cur, ndcbs);
+        sinfo->tx.cur += ndcbs;
+        if (sinfo->tx.cur >= MAX_TX_DCBS) {
             sinfo->tx.cur = 0;
         }
-        sinfo->tx.free--;
+        sinfo->tx.free -= ndcbs;
 
         if (CDMA_CH(sinfo, XGS_DMA_TX_CHAN) && !sinfo->tx.api_active) {
-            /* DMA run to the new halt location */
-            bkn_cdma_goto(sinfo, XGS_DMA_TX_CHAN,
-                          sinfo->tx.desc[sinfo->tx.cur].dcb_dma);
+            sinfo->tx.doorbell_pending = 1;
+            if (!xmit_more || sinfo->tx.free <= 1) {
+                bkn_tx_doorbell(sinfo);
+            }
         }
 
         priv->stats.tx_packets++;
@@ -5773,6 +7127,7 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
         DBG_VERB(("Tx busy: No DMA resources\n"));
         sinfo->tx.pkts_d_dma_resrc++;
 #endif              /* SDK-224448 */
+        bkn_tx_doorbell(sinfo);
         bkn_suspend_tx(sinfo);
 #ifdef SAI_FIXUP    /* SDK-224448 */
         spin_unlock_irqrestore(&sinfo->lock, flags);
@@ -5787,6 +7142,27 @@ bkn_tx(struct sk_buff *skb, struct net_device *dev)
     return 0;
 }
 
+static int
+bkn_tx(struct sk_buff *skb, struct net_device *dev)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    bkn_switch_info_t *sinfo = priv->sinfo;
+    unsigned long flags;
+    int xmit_more = bkn_xmit_more(skb);
+    int rv;
+
+    rv = bkn_tx_skb(skb, dev, xmit_more);
+
+    /* Make sure a batch is not left behind if its last packet was dropped */
+    if (!xmit_more && sinfo->tx.doorbell_pending) {
+        spin_lock_irqsave(&sinfo->lock, flags);
+        bkn_tx_doorbell(sinfo);
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+    }
+
+    return rv;
+}
+
 static void
 bkn_timer_func(bkn_switch_info_t *sinfo)
 {
@@ -5839,10 +7215,32 @@ bkn_timer(struct timer_list *t)
 static void
 bkn_rx_add_tokens(bkn_switch_info_t *sinfo, int chan)
 {
+#ifdef BKN_RX_HRTIMER
+    uint64_t cur_ns, delta, tokens;
+    uint32_t rate_max = sinfo->rx[chan].rate_max;
+#else
     unsigned long cur_jif, ticks;
     uint32_t tokens_per_tick;
+#endif
     bkn_desc_info_t *desc;
 
+#ifdef BKN_RX_HRTIMER
+    cur_ns = ktime_to_ns(ktime_get());
+    delta = cur_ns - sinfo->rx[chan].tok_ns;
+    if (delta > NSEC_PER_SEC) {
+        /* Bucket is full after one second at any rate */
+        delta = NSEC_PER_SEC;
+    }
+    tokens = rate_max ? div_u64(delta * rate_max, NSEC_PER_SEC) : 0;
+    if (sinfo->rx[chan].tokens + tokens >= sinfo->rx[chan].burst_max) {
+        sinfo->rx[chan].tokens = sinfo->rx[chan].burst_max;
+        sinfo->rx[chan].tok_ns = cur_ns;
+    } else if (tokens) {
+        sinfo->rx[chan].tokens += tokens;
+        /* Carry the unused fraction of a token over to the next update */
+        sinfo->rx[chan].tok_ns += div_u64(tokens * NSEC_PER_SEC, rate_max);
+    }
+#else
     tokens_per_tick = sinfo->rx[chan].rate_max / HZ;
     cur_jif = jiffies;
     ticks = cur_jif - sinfo->rx[chan].tok_jif;
@@ -5851,6 +7249,7 @@ bkn_rx_add_tokens(bkn_switch_info_t *sinfo, int chan)
     if (sinfo->rx[chan].tokens > sinfo->rx[chan].burst_max) {
         sinfo->rx[chan].tokens = sinfo->rx[chan].burst_max;
     }
+#endif
 
     /* Restart channel if Rx is suppressed */
     if (CDMA_CH(sinfo, XGS_DMA_RX_CHAN + chan)) {
@@ -5878,7 +7277,9 @@ bkn_rxtick_func(bkn_switch_info_t *sinfo)
 
     spin_lock_irqsave(&sinfo->lock, flags);
 
+#ifndef BKN_RX_HRTIMER
     sinfo->rxtick.expires = jiffies + sinfo->rxtick_jiffies;
+#endif
 
     /* For debug purposes we maintain a rough actual packet rate */
     if (++sinfo->rxticks >= sinfo->rxticks_per_sec) {
@@ -5902,10 +7303,22 @@ bkn_rxtick_func(bkn_switch_info_t *sinfo)
 
     spin_unlock_irqrestore(&sinfo->lock, flags);
 
+#ifndef BKN_RX_HRTIMER
     add_timer(&sinfo->rxtick);
+#endif
 }
 
-#if (LINUX_VERSION_CODE < KERNEL_VERSION(4,15,0))
+#if defined(BKN_RX_HRTIMER)
+static enum hrtimer_restart
+bkn_rxtick(struct hrtimer *t)
+{
+    bkn_switch_info_t *sinfo = container_of(t, bkn_switch_info_t, rxtick);
+
+    bkn_rxtick_func(sinfo);
+    hrtimer_forward_now(t, sinfo->rxtick_period);
+    return HRTIMER_RESTART;
+}
+#elif (LINUX_VERSION_CODE < KERNEL_VERSION(4,15,0))
 static void
 bkn_rxtick(unsigned long context)
 {
@@ -5944,12 +7357,20 @@ bkn_rx_rate_config(bkn_switch_info_t *sinfo)
         }
     }
 
+#ifdef BKN_RX_HRTIMER
+    if (rxticks_per_sec > BKN_RXTICKS_MAX) {
+        rxticks_per_sec = BKN_RXTICKS_MAX;
+    }
+    jiffies_per_rxtick = HZ / rxticks_per_sec;
+    sinfo->rxtick_period = ktime_set(0, NSEC_PER_SEC / rxticks_per_sec);
+#else
     /* Convert update frequency to system ticks */
     jiffies_per_rxtick = HZ / rxticks_per_sec;
     if (jiffies_per_rxtick == 0) {
         jiffies_per_rxtick = 1;
     }
     rxticks_per_sec = HZ / jiffies_per_rxtick;
+#endif
 
     for (chan = 0; chan < NUM_RX_CHAN; chan++) {
         /* Ensure that burst size satifies overall rate */
@@ -5974,34 +7395,87 @@ bkn_rx_rate_config(bkn_switch_info_t *sinfo)
 }
 
 static void
-bkn_destroy_sinfo(bkn_switch_info_t *sinfo)
-{
-    list_del(&sinfo->list);
-    bkn_free_dcbs(sinfo);
-    kfree(sinfo);
-}
-
-static bkn_switch_info_t *
-bkn_create_sinfo(int dev_no)
+bkn_free_desc_info(bkn_switch_info_t *sinfo)
 {
-    bkn_switch_info_t *sinfo;
+    int chan;
+
+    kfree(sinfo->tx.desc);
+    sinfo->tx.desc = NULL;
+    for (chan = 0; chan < NUM_RX_CHAN; chan++) {
+        kfree(sinfo->rx[chan].desc);
+        sinfo->rx[chan].desc = NULL;
+    }
+}
+
+static int
+bkn_alloc_desc_info(bkn_switch_info_t *sinfo)
+{
+    int chan;
+    size_t size;
+
+    size = (MAX_TX_DCBS + 1) * sizeof(bkn_desc_info_t);
+    if ((sinfo->tx.desc = kmalloc(size, GFP_KERNEL)) == NULL) {
+        return -1;
+    }
+    memset(sinfo->tx.desc, 0, size);
+
+    size = (MAX_RX_DCBS + 1) * sizeof(bkn_desc_info_t);
+    for (chan = 0; chan < NUM_RX_CHAN; chan++) {
+        if ((sinfo->rx[chan].desc = kmalloc(size, GFP_KERNEL)) == NULL) {
+            bkn_free_desc_info(sinfo);
+            return -1;
+        }
+        memset(sinfo->rx[chan].desc, 0, size);
+    }
+    return 0;
+}
+
+static void
+bkn_destroy_sinfo(bkn_switch_info_t *sinfo)
+{
+    list_del(&sinfo->list);
+    bkn_free_dcbs(sinfo);
+    bkn_free_desc_info(sinfo);
+    if (sinfo->api_ring.evfd) {
+        eventfd_ctx_put(sinfo->api_ring.evfd);
+    }
+    vfree(sinfo->api_ring.hdr);
+    free_percpu(sinfo->rxf_stats);
+    kfree(sinfo);
+}
+
+static bkn_switch_info_t *
+bkn_create_sinfo(int dev_no)
+{
+    bkn_switch_info_t *sinfo;
     int chan;
 
     if ((sinfo = kmalloc(sizeof(*sinfo), GFP_KERNEL)) == NULL) {
         return NULL;
     }
     memset(sinfo, 0, sizeof(*sinfo));
+    sinfo->rxf_stats = alloc_percpu(bkn_rxf_stats_t);
+    if (sinfo->rxf_stats == NULL) {
+        kfree(sinfo);
+        return NULL;
+    }
+    if (bkn_alloc_desc_info(sinfo) < 0) {
+        free_percpu(sinfo->rxf_stats);
+        kfree(sinfo);
+        return NULL;
+    }
     INIT_LIST_HEAD(&sinfo->ndev_list);
     INIT_LIST_HEAD(&sinfo->rxpf_list);
+    INIT_LIST_HEAD(&sinfo->rxpf_groups);
     sinfo->base_addr = lkbde_get_dev_virt(dev_no);
     sinfo->dma_dev = lkbde_get_dma_dev(dev_no);
     sinfo->pdev = lkbde_get_hw_dev(dev_no);
     sinfo->dev_no = dev_no;
     sinfo->evt_idx = -1;
+    get_random_bytes(&sinfo->wb_generation, sizeof(sinfo->wb_generation));
 
     spin_lock_init(&sinfo->lock);
-    skb_queue_head_init(&sinfo->tx_ptp_queue);
-    INIT_WORK(&sinfo->tx_ptp_work, bkn_hw_tstamp_tx_work);
+    spin_lock_init(&sinfo->cfg_lock);
 
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(4,15,0))
     init_timer(&sinfo->timer);
@@ -6028,14 +7502,18 @@ bkn_create_sinfo(int dev_no)
         sinfo->rx[0].use_rx_skb = 0;
     }
 
-#if (LINUX_VERSION_CODE < KERNEL_VERSION(4,15,0))
+#if defined(BKN_RX_HRTIMER)
+    hrtimer_init(&sinfo->rxtick, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sinfo->rxtick.function = bkn_rxtick;
+#elif (LINUX_VERSION_CODE < KERNEL_VERSION(4,15,0))
     init_timer(&sinfo->rxtick);
     sinfo->rxtick.data = (unsigned long)sinfo;
     sinfo->rxtick.function = bkn_rxtick;
+    sinfo->rxtick.expires = jiffies + 1;
 #else
     timer_setup(&sinfo->rxtick, bkn_rxtick, 0);
-#endif
     sinfo->rxtick.expires = jiffies + 1;
+#endif
 
     for (chan = 0; chan < NUM_RX_CHAN; chan++) {
         sinfo->rx[chan].rate_max = rx_rate[chan];
@@ -6043,13 +7521,80 @@ bkn_create_sinfo(int dev_no)
     }
     bkn_rx_rate_config(sinfo);
 
+#ifdef BKN_RX_HRTIMER
+    hrtimer_init(&sinfo->coal_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sinfo->coal_timer.function = bkn_coal_timer;
+    hrtimer_init(&sinfo->tx_ts.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    sinfo->tx_ts.timer.function = bkn_hw_tstamp_tx_timer;
+    hrtimer_start(&sinfo->rxtick, sinfo->rxtick_period, HRTIMER_MODE_REL);
+#else
     add_timer(&sinfo->rxtick);
+#endif
 
     list_add_tail(&sinfo->list, &_sinfo_list);
 
     return sinfo;
 }
 
+#ifdef BKN_XDP_SUPPORT
+static int
+bkn_xdp_setup(struct net_device *dev, struct bpf_prog *prog)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    bkn_switch_info_t *sinfo = priv->sinfo;
+    struct bpf_prog *old_prog;
+    unsigned long flags;
+
+    if (priv->id <= 0) {
+        /* Filters never deliver to the base device */
+        return -EOPNOTSUPP;
+    }
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    old_prog = priv->xdp_prog;
+    priv->xdp_prog = prog;
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    if (old_prog) {
+        bpf_prog_put(old_prog);
+    }
+    return 0;
+}
+
+static int
+bkn_bpf(struct net_device *dev, struct netdev_bpf *bpf)
+{
+    switch (bpf->command) {
+    case XDP_SETUP_PROG:
+        return bkn_xdp_setup(dev, bpf->prog);
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(5,7,0))
+    case XDP_QUERY_PROG:
+        {
+            bkn_priv_t *priv = netdev_priv(dev);
+            bpf->prog_id = priv->xdp_prog ? priv->xdp_prog->aux->id : 0;
+        }
+        return 0;
+#endif
+    default:
+        return -EINVAL;
+    }
+}
+
+static void
+bkn_uninit(struct net_device *dev)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+
+    if (priv->xdp_prog) {
+        bpf_prog_put(priv->xdp_prog);
+        priv->xdp_prog = NULL;
+    }
+    if (xdp_rxq_info_is_reg(&priv->xdp_rxq)) {
+        xdp_rxq_info_unreg(&priv->xdp_rxq);
+    }
+}
+#endif
+
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,29))
 static const struct net_device_ops bkn_netdev_ops = {
     .ndo_open            = bkn_open,
@@ -6065,6 +7610,10 @@ static const struct net_device_ops bkn_netdev_ops = {
 #ifdef CONFIG_NET_POLL_CONTROLLER
     .ndo_poll_controller = bkn_poll_controller,
 #endif
+#ifdef BKN_XDP_SUPPORT
+    .ndo_bpf             = bkn_bpf,
+    .ndo_uninit          = bkn_uninit,
+#endif
 };
 #endif
 
@@ -6116,8 +7665,191 @@ bkn_get_ts_info(struct net_device *dev, struct ethtool_ts_info *info)
 }
 #endif
 
+/*
+ * Statistics for ethtool -S
+ *
+ * Each netif reports its own counters, the Rx filter hits of filters
+ * pointing to it, and the counters of each Rx DMA channel of the device.
+ */
+typedef struct bkn_ethtool_stat_s {
+    char name[ETH_GSTRING_LEN];
+    int offset;
+} bkn_ethtool_stat_t;
+
+#define BKN_NETIF_STAT(_n) \
+    { #_n, offsetof(struct net_device_stats, _n) }
+
+static const bkn_ethtool_stat_t bkn_netif_stats[] = {
+    BKN_NETIF_STAT(rx_packets),
+    BKN_NETIF_STAT(rx_bytes),
+    BKN_NETIF_STAT(rx_errors),
+    BKN_NETIF_STAT(rx_dropped),
+    BKN_NETIF_STAT(tx_packets),
+    BKN_NETIF_STAT(tx_bytes),
+    BKN_NETIF_STAT(tx_dropped),
+};
+
+#define BKN_RX_STAT(_s, _n) \
+    { _s, offsetof(bkn_switch_info_t, rx[0]._n) - \
+          offsetof(bkn_switch_info_t, rx[0]) }
+
+static const bkn_ethtool_stat_t bkn_rx_chan_stats[] = {
+    BKN_RX_STAT("packets", pkts),
+    BKN_RX_STAT("filter_to_api", pkts_f_api),
+    BKN_RX_STAT("filter_to_netif", pkts_f_netif),
+    BKN_RX_STAT("mirror_to_api", pkts_m_api),
+    BKN_RX_STAT("mirror_to_netif", pkts_m_netif),
+    BKN_RX_STAT("drop_no_skb", pkts_d_no_skb),
+    BKN_RX_STAT("drop_no_match", pkts_d_no_match),
+    BKN_RX_STAT("drop_unkn_netif", pkts_d_unkn_netif),
+    BKN_RX_STAT("drop_unkn_dest", pkts_d_unkn_dest),
+    BKN_RX_STAT("drop_callback", pkts_d_callback),
+    BKN_RX_STAT("drop_no_link", pkts_d_no_link),
+    BKN_RX_STAT("drop_no_api_buf", pkts_d_no_api_buf),
+    BKN_RX_STAT("rate_pauses", rate_pauses),
+    BKN_RX_STAT("drop_xdp", pkts_d_xdp),
+    BKN_RX_STAT("drop_policed", pkts_d_policed),
+};
+
+#define BKN_NETIF_STATS_NUM     (sizeof(bkn_netif_stats) / sizeof(bkn_netif_stats[0]))
+#define BKN_RX_CHAN_STATS_NUM   (sizeof(bkn_rx_chan_stats) / sizeof(bkn_rx_chan_stats[0]))
+
+static int
+bkn_get_sset_count(struct net_device *dev, int sset)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+
+    switch (sset) {
+    case ETH_SS_STATS:
+        return BKN_NETIF_STATS_NUM + 1 +
+            priv->sinfo->rx_chans * BKN_RX_CHAN_STATS_NUM;
+    default:
+        return -EOPNOTSUPP;
+    }
+}
+
+static void
+bkn_get_strings(struct net_device *dev, u32 sset, u8 *data)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    int idx, chan;
+
+    if (sset != ETH_SS_STATS) {
+        return;
+    }
+    for (idx = 0; idx < BKN_NETIF_STATS_NUM; idx++) {
+        strlcpy(data, bkn_netif_stats[idx].name, ETH_GSTRING_LEN);
+        data += ETH_GSTRING_LEN;
+    }
+    strlcpy(data, "filter_hits", ETH_GSTRING_LEN);
+    data += ETH_GSTRING_LEN;
+    for (chan = 0; chan < priv->sinfo->rx_chans; chan++) {
+        for (idx = 0; idx < BKN_RX_CHAN_STATS_NUM; idx++) {
+            snprintf(data, ETH_GSTRING_LEN, "rx%d_%s",
+                     chan, bkn_rx_chan_stats[idx].name);
+            data += ETH_GSTRING_LEN;
+        }
+    }
+}
+
+static void
+bkn_get_ethtool_stats(struct net_device *dev,
+                      struct ethtool_stats *stats, u64 *data)
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    bkn_switch_info_t *sinfo = priv->sinfo;
+    struct list_head *list;
+    bkn_filter_t *filter;
+    unsigned long flags;
+    u64 hits;
+    int idx, chan;
+
+    hits = 0;
+    spin_lock(&sinfo->cfg_lock);
+    list_for_each(list, &sinfo->rxpf_list) {
+        filter = (bkn_filter_t *)list;
+        if (filter->kf.dest_type == KCOM_DEST_T_NETIF &&
+            filter->kf.dest_id == priv->id) {
+            hits += bkn_filter_hits(filter);
+        }
+    }
+    spin_unlock(&sinfo->cfg_lock);
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+
+    for (idx = 0; idx < BKN_NETIF_STATS_NUM; idx++) {
+        *data++ = *(unsigned long *)((char *)&priv->stats +
+                                     bkn_netif_stats[idx].offset);
+    }
+    *data++ = hits;
+    for (chan = 0; chan < sinfo->rx_chans; chan++) {
+        for (idx = 0; idx < BKN_RX_CHAN_STATS_NUM; idx++) {
+            *data++ = *(uint32_t *)((char *)&sinfo->rx[chan] +
+                                    bkn_rx_chan_stats[idx].offset);
+        }
+    }
+
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+}
+
+#ifdef BKN_RX_HRTIMER
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,15,0))
+static int
+bkn_get_coalesce(struct net_device *dev, struct ethtool_coalesce *ec,
+                 struct kernel_ethtool_coalesce *kec,
+                 struct netlink_ext_ack *extack)
+#else
+static int
+bkn_get_coalesce(struct net_device *dev, struct ethtool_coalesce *ec)
+#endif
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+
+    memset(ec, 0, sizeof(*ec));
+    ec->rx_coalesce_usecs = priv->sinfo->rx_coal_usecs;
+    return 0;
+}
+
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,15,0))
+static int
+bkn_set_coalesce(struct net_device *dev, struct ethtool_coalesce *ec,
+                 struct kernel_ethtool_coalesce *kec,
+                 struct netlink_ext_ack *extack)
+#else
+static int
+bkn_set_coalesce(struct net_device *dev, struct ethtool_coalesce *ec)
+#endif
+{
+    bkn_priv_t *priv = netdev_priv(dev);
+    bkn_switch_info_t *sinfo = priv->sinfo;
+    unsigned long flags;
+
+    /* Interrupt hold-off is done from the NAPI poll */
+    if (!use_napi && ec->rx_coalesce_usecs) {
+        return -EOPNOTSUPP;
+    }
+    if (ec->rx_coalesce_usecs > 10000) {
+        return -EINVAL;
+    }
+    spin_lock_irqsave(&sinfo->lock, flags);
+    sinfo->rx_coal_usecs = ec->rx_coalesce_usecs;
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+    return 0;
+}
+#endif /* BKN_RX_HRTIMER */
+
 static const struct ethtool_ops bkn_ethtool_ops = {
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,7,0)) && defined(BKN_RX_HRTIMER)
+    .supported_coalesce_params = ETHTOOL_COALESCE_RX_USECS,
+#endif
     .get_drvinfo        = bkn_get_drvinfo,
+#ifdef BKN_RX_HRTIMER
+    .get_coalesce       = bkn_get_coalesce,
+    .set_coalesce       = bkn_set_coalesce,
+#endif
+    .get_sset_count     = bkn_get_sset_count,
+    .get_strings        = bkn_get_strings,
+    .get_ethtool_stats  = bkn_get_ethtool_stats,
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(3,5,0))
     .get_ts_info        = bkn_get_ts_info,
 #endif
@@ -6129,7 +7861,7 @@ bkn_init_ndev(u8 *mac, char *name)
     struct net_device *dev;
 
     /* Create Ethernet device */
-    dev = alloc_etherdev(sizeof(bkn_priv_t));
+    dev = bkn_alloc_etherdev(sizeof(bkn_priv_t));
 
     if (dev == NULL) {
         DBG_WARN(("Error allocating Ethernet device.\n"));
@@ -6168,6 +7900,17 @@ bkn_init_ndev(u8 *mac, char *name)
 #endif
 #endif
     dev->ethtool_ops = &bkn_ethtool_ops;
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,29))
+    if (use_gro) {
+        dev->features |= NETIF_F_GRO;
+    }
+#endif
+#ifdef BKN_TX_SG
+    if (use_tx_sg) {
+        dev->features |= NETIF_F_SG;
+        dev->hw_features |= NETIF_F_SG;
+    }
+#endif
     if (name && *name) {
         strncpy(dev->name, name, IFNAMSIZ-1);
     }
@@ -6184,6 +7927,16 @@ bkn_init_ndev(u8 *mac, char *name)
     }
     DBG_VERB(("Created Ethernet device %s.\n", dev->name));
 
+#ifdef BKN_XDP_SUPPORT
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,11,0))
+    if (xdp_rxq_info_reg(&((bkn_priv_t *)netdev_priv(dev))->xdp_rxq, dev, 0, 0) < 0) {
+#else
+    if (xdp_rxq_info_reg(&((bkn_priv_t *)netdev_priv(dev))->xdp_rxq, dev, 0) < 0) {
+#endif
+        DBG_WARN(("Error registering XDP Rx queue info for %s.\n", dev->name));
+    }
+#endif
+
     return dev;
 }
 
@@ -6197,12 +7950,11 @@ bkn_proc_link_show(struct seq_file *m, void *v)
     struct net_device *dev;
     bkn_priv_t *priv;
     bkn_switch_info_t *sinfo;
-    unsigned long flags;
 
     seq_printf(m, "Software link status:\n");
     list_for_each(slist, &_sinfo_list) {
         sinfo = (bkn_switch_info_t *)slist;
-        spin_lock_irqsave(&sinfo->lock, flags);
+        spin_lock(&sinfo->cfg_lock);
         list_for_each(dlist, &sinfo->ndev_list) {
             priv = (bkn_priv_t *)dlist;
             dev = priv->dev;
@@ -6211,7 +7963,7 @@ bkn_proc_link_show(struct seq_file *m, void *v)
                            netif_carrier_ok(dev) ? "up" : "down");
             }
         }
-        spin_unlock_irqrestore(&sinfo->lock, flags);
+        spin_unlock(&sinfo->cfg_lock);
     }
     return 0;
 }
@@ -6242,7 +7994,6 @@ bkn_proc_link_write(struct file *file, const char *buf,
     struct net_device *dev;
     bkn_priv_t *priv;
     bkn_switch_info_t *sinfo;
-    unsigned long flags;
     char link_str[40];
     char *ptr;
     char *newline;
@@ -6271,7 +8022,7 @@ bkn_proc_link_write(struct file *file, const char *buf,
     dev = NULL;
     list_for_each(slist, &_sinfo_list) {
         sinfo = (bkn_switch_info_t *)slist;
-        spin_lock_irqsave(&sinfo->lock, flags);
+        spin_lock(&sinfo->cfg_lock);
         list_for_each(dlist, &sinfo->ndev_list) {
             priv = (bkn_priv_t *)dlist;
             if (priv->dev) {
@@ -6289,10 +8040,13 @@ bkn_proc_link_write(struct file *file, const char *buf,
             } else {
                 gprintk("Warning: unknown link state setting: '%s'\n", ptr);
             }
-            spin_unlock_irqrestore(&sinfo->lock, flags);
+#ifdef BKN_GENL_SUPPORT
+            bkn_genl_link_notify(priv);
+#endif
+            spin_unlock(&sinfo->cfg_lock);
             return count;
         }
-        spin_unlock_irqrestore(&sinfo->lock, flags);
+        spin_unlock(&sinfo->cfg_lock);
     }
 
     gprintk("Warning: unknown network interface: '%s'\n", link_str);
@@ -6316,8 +8070,9 @@ static int
 bkn_proc_rate_show(struct seq_file *m, void *v)
 {
     int unit = 0;
-    struct list_head *list;
+    struct list_head *list, *flist;
     bkn_switch_info_t *sinfo;
+    bkn_filter_t *filter;
     int chan;
 
     list_for_each(list, &_sinfo_list) {
@@ -6335,6 +8090,18 @@ bkn_proc_rate_show(struct seq_file *m, void *v)
                             chan, sinfo->rx[chan].tokens);
         }
 
+        spin_lock(&sinfo->cfg_lock);
+        list_for_each(flist, &sinfo->rxpf_list) {
+            filter = (bkn_filter_t *)flist;
+            if (filter->pol_rate == 0) {
+                continue;
+            }
+            seq_printf(m, "  Filter %d rate %8u burst %8u policed %lu\n",
+                       filter->kf.id, filter->pol_rate, filter->pol_burst,
+                       bkn_filter_drops(filter));
+        }
+        spin_unlock(&sinfo->cfg_lock);
+
         unit++;
     }
     return 0;
@@ -6355,19 +8122,29 @@ bkn_proc_rate_open(struct inode * inode, struct file * file)
  *   Where <rate0> is packets/sec for the first Rx DMA channel,
  *   <rate1> is packets/sec for the second Rx DMA channel, etc.
  *
+ *   [<unit>:]filter_rate=<id>,<rate>[,<burst>]
+ *
+ *   Where <id> is a filter ID, <rate> is packets/sec on each Rx CPU
+ *   for the packets matching the filter and <burst> is packets, which
+ *   defaults to <rate>. A <rate> of 0 removes the policer of the filter.
+ *
  *   Examples:
  *   rx_rate=5000
  *   0:rx_rate=10000,10000
  *   1:rx_rate=10000,5000
+ *   filter_rate=12,1000,200
  */
 static ssize_t
 bkn_proc_rate_write(struct file *file, const char *buf,
                     size_t count, loff_t *loff)
 {
     bkn_switch_info_t *sinfo;
+    struct list_head *flist;
+    bkn_filter_t *filter;
     char rate_str[80];
     char *ptr;
-    int unit, chan;
+    int unit, chan, id;
+    uint32_t rate, burst;
 
     if (count > sizeof(rate_str)) {
         count = sizeof(rate_str) - 1;
@@ -6400,6 +8177,27 @@ bkn_proc_rate_write(struct file *file, const char *buf,
             sinfo->rx[chan].burst_max = simple_strtol(ptr, NULL, 10);
         } while ((ptr = strchr(ptr, ',')) != NULL && ++chan < sinfo->rx_chans);
         bkn_rx_rate_config(sinfo);
+    } else if ((ptr = strstr(rate_str, "filter_rate=")) != NULL) {
+        ptr += 12;
+        id = simple_strtol(ptr, &ptr, 10);
+        if (*ptr != ',') {
+            gprintk("Warning: filter_rate requires a rate\n");
+            return count;
+        }
+        rate = simple_strtoul(ptr + 1, &ptr, 10);
+        burst = (*ptr == ',') ? simple_strtoul(ptr + 1, NULL, 10) : 0;
+        spin_lock(&sinfo->cfg_lock);
+        list_for_each(flist, &sinfo->rxpf_list) {
+            filter = (bkn_filter_t *)flist;
+            if (filter->kf.id == id) {
+                bkn_filter_police_config(filter, rate, burst);
+                break;
+            }
+        }
+        spin_unlock(&sinfo->cfg_lock);
+        if (flist == &sinfo->rxpf_list) {
+            gprintk("Warning: unknown filter ID: %d\n", id);
+        }
     } else {
         gprintk("Warning: unknown configuration setting\n");
     }
@@ -6524,6 +8322,13 @@ bkn_seq_dma_show(struct seq_file *s, void *v)
     if (iter->rx_dma == 0) {
         if (iter->idx == -2) {
             seq_printf(s, "Pending events: 0x%x\n", sinfo->dma_events);
+            if (sinfo->api_ring.active) {
+                seq_printf(s, "Rx API ring: prod %u cons %u overflows %u kicks %u\n",
+                           sinfo->api_ring.prod,
+                           READ_ONCE(sinfo->api_ring.hdr->cons),
+                           sinfo->api_ring.hdr->overflows,
+                           sinfo->api_ring.kicks);
+            }
         } else if (iter->idx == -1) {
             spin_lock_irqsave(&sinfo->lock, flags);
             curr = &sinfo->tx.api_dcb_list;
@@ -6752,6 +8557,7 @@ bkn_proc_debug_show(struct seq_file *m, void *v)
     seq_printf(m, "Active IOCTLs:\n");
     seq_printf(m, "  Command:        %d\n", ioctl_cmd);
     seq_printf(m, "  Event:          %d\n", ioctl_evt);
+    seq_printf(m, "  Netlink:        %d\n", genl_cmd);
 
     list_for_each(list, &_sinfo_list) {
         sinfo = (bkn_switch_info_t *)list;
@@ -6773,6 +8579,8 @@ bkn_proc_debug_show(struct seq_file *m, void *v)
         seq_printf(m, "  napi_poll_mode: %d\n", sinfo->napi_poll_mode);
         seq_printf(m, "  inst_id:        0x%x\n", sinfo->inst_id);
         seq_printf(m, "  evt_queue:      %d\n", sinfo->evt_idx);
+        seq_printf(m, "  wb_retained:    %d (gen 0x%x)\n",
+                   sinfo->wb_retained, sinfo->wb_generation);
 
         unit++;
     }
@@ -6827,13 +8635,17 @@ bkn_proc_stats_show(struct seq_file *m, void *v)
         }
         seq_printf(m, "  Timer runs  %10u\n", sinfo->timer_runs);
         seq_printf(m, "  NAPI reruns %10u\n", sinfo->napi_not_done);
+        seq_printf(m, "  NAPI coal   %10u\n", sinfo->coal_polls);
 
+        spin_lock(&sinfo->cfg_lock);
         list_for_each(flist, &sinfo->rxpf_list) {
             filter = (bkn_filter_t *)flist;
 
             seq_printf(m, "  Filter %d stats:\n", filter->kf.id);
-            seq_printf(m, "    Hits      %10lu\n", filter->hits);
+            seq_printf(m, "    Hits      %10lu\n", bkn_filter_hits(filter));
+            seq_printf(m, "    Policed   %10lu\n", bkn_filter_drops(filter));
         }
+        spin_unlock(&sinfo->cfg_lock);
 
         unit++;
     }
@@ -6905,10 +8717,13 @@ bkn_proc_stats_write(struct file *file, const char *buf,
         sinfo->interrupts = 0;
         sinfo->timer_runs = 0;
         sinfo->napi_not_done = 0;
+        sinfo->coal_polls = 0;
+        spin_lock(&sinfo->cfg_lock);
         list_for_each(flist, &sinfo->rxpf_list) {
             filter = (bkn_filter_t *)flist;
-            filter->hits = 0;
+            bkn_filter_hits_clear(filter);
         }
+        spin_unlock(&sinfo->cfg_lock);
     }
 
     return count;
@@ -6924,72 +8739,304 @@ struct file_operations bkn_proc_stats_file_ops = {
 };
 
 /*
- * Device Debug Statistics Proc Entry
+ * Rx Filter Engine Proc Entry
  */
 static int
-bkn_proc_dstats_show(struct seq_file *m, void *v)
+bkn_proc_filter_show(struct seq_file *m, void *v)
 {
     int unit = 0;
-    struct list_head *list;
+    struct list_head *list, *glist, *flist;
     bkn_switch_info_t *sinfo;
-    int chan;
+    bkn_fgroup_t *fg;
+    int idx, used, depth, max_depth;
 
     list_for_each(list, &_sinfo_list) {
         sinfo = (bkn_switch_info_t *)list;
 
-        seq_printf(m, "Device debug stats (unit %d):\n", unit);
-        seq_printf(m, "  Tx drop no skb      %10u\n",
-                        sinfo->tx.pkts_d_no_skb);
-        seq_printf(m, "  Tx drop rcpu encap  %10u\n",
-                        sinfo->tx.pkts_d_rcpu_encap);
-        seq_printf(m, "  Tx drop rcpu sig    %10u\n",
-                        sinfo->tx.pkts_d_rcpu_sig);
-        seq_printf(m, "  Tx drop rcpu meta   %10u\n",
-                        sinfo->tx.pkts_d_rcpu_meta);
-        seq_printf(m, "  Tx drop pad failed  %10u\n",
-                        sinfo->tx.pkts_d_pad_fail);
-        seq_printf(m, "  Tx drop no resource %10u\n",
-                        sinfo->tx.pkts_d_dma_resrc);
-        seq_printf(m, "  Tx drop callback    %10u\n",
-                        sinfo->tx.pkts_d_callback);
-        seq_printf(m, "  Tx drop no link     %10u\n",
-                        sinfo->tx.pkts_d_no_link);
-        seq_printf(m, "  Tx drop oversized   %10u\n",
-                        sinfo->tx.pkts_d_over_limit);
-        seq_printf(m, "  Tx suspends         %10u\n",
-                        sinfo->tx.suspends);
-        for (chan = 0; chan < sinfo->rx_chans; chan++) {
-            seq_printf(m, "  Rx%d filter to api   %10u\n",
-                            chan, sinfo->rx[chan].pkts_f_api);
-            seq_printf(m, "  Rx%d filter to netif %10u\n",
-                            chan, sinfo->rx[chan].pkts_f_netif);
-            seq_printf(m, "  Rx%d mirror to api   %10u\n",
-                            chan, sinfo->rx[chan].pkts_m_api);
-            seq_printf(m, "  Rx%d mirror to netif %10u\n",
-                            chan, sinfo->rx[chan].pkts_m_netif);
-            seq_printf(m, "  Rx%d drop no skb     %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_no_skb);
-            seq_printf(m, "  Rx%d drop no match   %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_no_match);
-            seq_printf(m, "  Rx%d drop unkn netif %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_unkn_netif);
-            seq_printf(m, "  Rx%d drop unkn dest  %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_unkn_dest);
-            seq_printf(m, "  Rx%d drop callback   %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_callback);
-            seq_printf(m, "  Rx%d drop no link    %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_no_link);
-            seq_printf(m, "  Rx%d sync error      %10u\n",
-                            chan, sinfo->rx[chan].sync_err);
-            seq_printf(m, "  Rx%d sync retry      %10u\n",
-                            chan, sinfo->rx[chan].sync_retry);
-            seq_printf(m, "  Rx%d sync maxloop    %10u\n",
-                            chan, sinfo->rx[chan].sync_maxloop);
-            seq_printf(m, "  Rx%d drop no buffer  %10u\n",
-                            chan, sinfo->rx[chan].pkts_d_no_api_buf);
-        }
-        unit++;
-    }
+        seq_printf(m, "Rx filter groups (unit %d):\n", unit);
+        spin_lock(&sinfo->cfg_lock);
+        list_for_each(glist, &sinfo->rxpf_groups) {
+            fg = (bkn_fgroup_t *)glist;
+            used = 0;
+            max_depth = 0;
+            for (idx = 0; idx < BKN_FLTR_HASH_SIZE; idx++) {
+                depth = 0;
+                list_for_each(flist, &fg->bucket[idx]) {
+                    depth++;
+                }
+                if (depth) {
+                    used++;
+                }
+                if (depth > max_depth) {
+                    max_depth = depth;
+                }
+            }
+            seq_printf(m, "  OOB %3d/%3d Pkt %3d/%3d mask 0x%08x: "
+                       "filters %3d buckets %2d/%d max depth %d\n",
+                       fg->oob_data_offset, fg->oob_data_size,
+                       fg->pkt_data_offset, fg->pkt_data_size,
+                       fg->wsize ? fg->mask[0] : 0, fg->filters,
+                       used, BKN_FLTR_HASH_SIZE, max_depth);
+        }
+        spin_unlock(&sinfo->cfg_lock);
+
+        unit++;
+    }
+    return 0;
+}
+
+static int bkn_proc_filter_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, bkn_proc_filter_show, NULL);
+}
+
+struct file_operations bkn_proc_filter_file_ops = {
+    owner:      THIS_MODULE,
+    open:       bkn_proc_filter_open,
+    read:       seq_read,
+    llseek:     seq_lseek,
+    release:    single_release,
+};
+
+/*
+ * Rx Filter Lookup Statistics Proc Entry
+ */
+static int
+bkn_proc_fstats_show(struct seq_file *m, void *v)
+{
+    int unit = 0;
+    struct list_head *list, *flist;
+    bkn_switch_info_t *sinfo;
+    bkn_rxf_stats_t *st, sum;
+    bkn_filter_t *filter;
+    unsigned long hits;
+    char label[16];
+    int cpu, idx;
+
+    list_for_each(list, &_sinfo_list) {
+        sinfo = (bkn_switch_info_t *)list;
+
+        memset(&sum, 0, sizeof(sum));
+        for_each_possible_cpu(cpu) {
+            st = per_cpu_ptr(sinfo->rxf_stats, cpu);
+            sum.lookups += st->lookups;
+            sum.no_match += st->no_match;
+            for (idx = 0; idx < BKN_RXF_DEPTH_BUCKETS; idx++) {
+                sum.depth[idx] += st->depth[idx];
+            }
+            sum.samples += st->samples;
+            sum.cycles += st->cycles;
+            if (st->max_cycles > sum.max_cycles) {
+                sum.max_cycles = st->max_cycles;
+            }
+        }
+
+        seq_printf(m, "Rx filter lookups (unit %d):\n", unit);
+        seq_printf(m, "  Lookups     %10llu\n", sum.lookups);
+        seq_printf(m, "  No match    %10llu\n", sum.no_match);
+        for (idx = 0; idx < BKN_RXF_DEPTH_BUCKETS; idx++) {
+            if (idx < 2) {
+                snprintf(label, sizeof(label), "%d", idx);
+            } else if (idx < BKN_RXF_DEPTH_BUCKETS - 1) {
+                snprintf(label, sizeof(label), "%d-%d",
+                         1 << (idx - 1), (1 << idx) - 1);
+            } else {
+                snprintf(label, sizeof(label), "%d+", 1 << (idx - 1));
+            }
+            seq_printf(m, "  Depth %-5s %10llu\n", label, sum.depth[idx]);
+        }
+        seq_printf(m, "  Samples     %10llu\n", sum.samples);
+        seq_printf(m, "  Avg cycles  %10llu\n",
+                   sum.samples ? div64_u64(sum.cycles, sum.samples) : 0);
+        seq_printf(m, "  Max cycles  %10llu\n", sum.max_cycles);
+
+        spin_lock(&sinfo->cfg_lock);
+        list_for_each(flist, &sinfo->rxpf_list) {
+            filter = (bkn_filter_t *)flist;
+
+            seq_printf(m, "  Filter %d (prio %d) hits %lu policed %lu:",
+                       filter->kf.id, filter->kf.priority,
+                       bkn_filter_hits(filter), bkn_filter_drops(filter));
+            for_each_online_cpu(cpu) {
+                hits = *per_cpu_ptr(filter->hits, cpu);
+                if (hits) {
+                    seq_printf(m, " cpu%d %lu", cpu, hits);
+                }
+            }
+            seq_printf(m, "\n");
+        }
+        spin_unlock(&sinfo->cfg_lock);
+
+        unit++;
+    }
+    return 0;
+}
+
+static int bkn_proc_fstats_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, bkn_proc_fstats_show, NULL);
+}
+
+/*
+ * Rx Filter Lookup Statistics Proc Write Entry
+ *
+ *   Syntax:
+ *   [<unit>:]clear
+ *
+ *   Clears the lookup statistics, and the filter hits and policer drops.
+ */
+static ssize_t
+bkn_proc_fstats_write(struct file *file, const char *buf,
+                      size_t count, loff_t *loff)
+{
+    bkn_switch_info_t *sinfo;
+    struct list_head *flist;
+    bkn_filter_t *filter;
+    char debug_str[40];
+    int unit;
+    int cpu;
+
+    if (count > sizeof(debug_str)) {
+        count = sizeof(debug_str) - 1;
+        debug_str[count] = '\0';
+    }
+    if (copy_from_user(debug_str, buf, count)) {
+        return -EFAULT;
+    }
+
+    unit = simple_strtol(debug_str, NULL, 10);
+    sinfo = bkn_sinfo_from_unit(unit);
+    if (sinfo == NULL) {
+        gprintk("Warning: unknown unit: %d\n", unit);
+        return count;
+    }
+
+    if (strstr(debug_str, "clear") == NULL) {
+        gprintk("Warning: unknown configuration setting\n");
+        return count;
+    }
+
+    for_each_possible_cpu(cpu) {
+        memset(per_cpu_ptr(sinfo->rxf_stats, cpu), 0, sizeof(bkn_rxf_stats_t));
+    }
+    spin_lock(&sinfo->cfg_lock);
+    list_for_each(flist, &sinfo->rxpf_list) {
+        filter = (bkn_filter_t *)flist;
+        bkn_filter_hits_clear(filter);
+    }
+    spin_unlock(&sinfo->cfg_lock);
+
+    return count;
+}
+
+struct file_operations bkn_proc_fstats_file_ops = {
+    owner:      THIS_MODULE,
+    open:       bkn_proc_fstats_open,
+    read:       seq_read,
+    llseek:     seq_lseek,
+    write:      bkn_proc_fstats_write,
+    release:    single_release,
+};
+
+/*
+ * Device Debug Statistics Proc Entry
+ */
+static int
+bkn_proc_dstats_show(struct seq_file *m, void *v)
+{
+    int unit = 0;
+    struct list_head *list;
+    bkn_switch_info_t *sinfo;
+    int chan;
+    int port;
+
+    list_for_each(list, &_sinfo_list) {
+        sinfo = (bkn_switch_info_t *)list;
+
+        seq_printf(m, "Device debug stats (unit %d):\n", unit);
+        seq_printf(m, "  Tx drop no skb      %10u\n",
+                        sinfo->tx.pkts_d_no_skb);
+        seq_printf(m, "  Tx drop rcpu encap  %10u\n",
+                        sinfo->tx.pkts_d_rcpu_encap);
+        seq_printf(m, "  Tx drop rcpu sig    %10u\n",
+                        sinfo->tx.pkts_d_rcpu_sig);
+        seq_printf(m, "  Tx drop rcpu meta   %10u\n",
+                        sinfo->tx.pkts_d_rcpu_meta);
+        seq_printf(m, "  Tx drop pad failed  %10u\n",
+                        sinfo->tx.pkts_d_pad_fail);
+        seq_printf(m, "  Tx drop no resource %10u\n",
+                        sinfo->tx.pkts_d_dma_resrc);
+        seq_printf(m, "  Tx drop callback    %10u\n",
+                        sinfo->tx.pkts_d_callback);
+        seq_printf(m, "  Tx drop no link     %10u\n",
+                        sinfo->tx.pkts_d_no_link);
+        seq_printf(m, "  Tx drop oversized   %10u\n",
+                        sinfo->tx.pkts_d_over_limit);
+        seq_printf(m, "  Tx suspends         %10u\n",
+                        sinfo->tx.suspends);
+        seq_printf(m, "  Tx doorbells        %10u\n",
+                        sinfo->tx.doorbells);
+        seq_printf(m, "  Tx scatter-gather   %10u\n",
+                        sinfo->tx.sg_pkts);
+        seq_printf(m, "  Tx linearized       %10u\n",
+                        sinfo->tx.sg_linearize);
+        seq_printf(m, "  Tx timestamp ok     %10u\n",
+                        sinfo->tx_ts.total.ok);
+        seq_printf(m, "  Tx timestamp late   %10u\n",
+                        sinfo->tx_ts.total.late);
+        seq_printf(m, "  Tx timestamp missed %10u\n",
+                        sinfo->tx_ts.total.missed);
+        for (port = 0; port < BKN_TX_TS_PORT_MAX; port++) {
+            bkn_tx_ts_stats_t *ts = &sinfo->tx_ts.port[port];
+            if (ts->ok || ts->late || ts->missed) {
+                seq_printf(m, "    port %3d ok %10u late %10u missed %10u\n",
+                           port, ts->ok, ts->late, ts->missed);
+            }
+        }
+        for (chan = 0; chan < sinfo->rx_chans; chan++) {
+            seq_printf(m, "  Rx%d filter to api   %10u\n",
+                            chan, sinfo->rx[chan].pkts_f_api);
+            seq_printf(m, "  Rx%d filter to netif %10u\n",
+                            chan, sinfo->rx[chan].pkts_f_netif);
+            seq_printf(m, "  Rx%d mirror to api   %10u\n",
+                            chan, sinfo->rx[chan].pkts_m_api);
+            seq_printf(m, "  Rx%d mirror to netif %10u\n",
+                            chan, sinfo->rx[chan].pkts_m_netif);
+            seq_printf(m, "  Rx%d drop no skb     %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_no_skb);
+            seq_printf(m, "  Rx%d drop no match   %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_no_match);
+            seq_printf(m, "  Rx%d drop unkn netif %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_unkn_netif);
+            seq_printf(m, "  Rx%d drop unkn dest  %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_unkn_dest);
+            seq_printf(m, "  Rx%d drop callback   %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_callback);
+            seq_printf(m, "  Rx%d drop no link    %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_no_link);
+            seq_printf(m, "  Rx%d sync error      %10u\n",
+                            chan, sinfo->rx[chan].sync_err);
+            seq_printf(m, "  Rx%d sync retry      %10u\n",
+                            chan, sinfo->rx[chan].sync_retry);
+            seq_printf(m, "  Rx%d sync maxloop    %10u\n",
+                            chan, sinfo->rx[chan].sync_maxloop);
+            seq_printf(m, "  Rx%d drop no buffer  %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_no_api_buf);
+            seq_printf(m, "  Rx%d buffer reuse    %10u\n",
+                            chan, sinfo->rx[chan].bufs_reuse);
+            seq_printf(m, "  Rx%d buffer alloc    %10u\n",
+                            chan, sinfo->rx[chan].bufs_alloc);
+            seq_printf(m, "  Rx%d rate pauses     %10u\n",
+                            chan, sinfo->rx[chan].rate_pauses);
+            seq_printf(m, "  Rx%d drop xdp        %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_xdp);
+            seq_printf(m, "  Rx%d drop sg frame   %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_sg);
+            seq_printf(m, "  Rx%d drop policed    %10u\n",
+                            chan, sinfo->rx[chan].pkts_d_policed);
+        }
+        unit++;
+    }
     return 0;
 }
 
@@ -7068,6 +9115,11 @@ bkn_proc_dstats_write(struct file *file, const char *buf,
         sinfo->tx.pkts_d_over_limit = 0;
         sinfo->tx.pkts_d_dma_resrc = 0;
         sinfo->tx.suspends = 0;
+        sinfo->tx.doorbells = 0;
+        sinfo->tx.sg_pkts = 0;
+        sinfo->tx.sg_linearize = 0;
+        memset(&sinfo->tx_ts.total, 0, sizeof(sinfo->tx_ts.total));
+        memset(sinfo->tx_ts.port, 0, sizeof(sinfo->tx_ts.port));
     }
     /* Rx counters */
     for (chan = 0; chan < sinfo->rx_chans; chan++) {
@@ -7081,6 +9133,12 @@ bkn_proc_dstats_write(struct file *file, const char *buf,
             sinfo->rx[chan].pkts_d_unkn_netif = 0;
             sinfo->rx[chan].pkts_d_unkn_dest = 0;
             sinfo->rx[chan].pkts_d_no_api_buf = 0;
+            sinfo->rx[chan].bufs_reuse = 0;
+            sinfo->rx[chan].bufs_alloc = 0;
+            sinfo->rx[chan].rate_pauses = 0;
+            sinfo->rx[chan].pkts_d_xdp = 0;
+            sinfo->rx[chan].pkts_d_sg = 0;
+            sinfo->rx[chan].pkts_d_policed = 0;
             sinfo->rx[chan].sync_err = 0;
             sinfo->rx[chan].sync_retry = 0;
             sinfo->rx[chan].sync_maxloop = 0;
@@ -7099,6 +9157,318 @@ struct file_operations bkn_proc_dstats_file_ops = {
     release:    single_release,
 };
 
+/*
+ * Loopback Performance Proc Entry
+ *
+ * Shows the results of the last run. Rx latency is measured from the
+ * Rx interrupt (or the start of the poll if packets were found without
+ * an interrupt) until the packet is passed to the network stack.
+ */
+static uint32_t
+bkn_perf_lat_pct(int pct)
+{
+    uint32_t target, sum;
+    int idx;
+
+    if (bkn_perf.lat_samples == 0) {
+        return 0;
+    }
+    target = (uint32_t)div_u64((uint64_t)bkn_perf.lat_samples * pct + 99, 100);
+    sum = 0;
+    for (idx = 0; idx < BKN_PERF_LAT_BUCKETS; idx++) {
+        sum += bkn_perf.lat_hist[idx];
+        if (sum >= target) {
+            break;
+        }
+    }
+    /* Upper bound of the bucket */
+    return idx + 1;
+}
+
+static int
+bkn_proc_perf_show(struct seq_file *m, void *v)
+{
+    uint64_t usecs, pps, kbps;
+    int chan;
+
+    mutex_lock(&bkn_perf_lock);
+
+    if (bkn_perf.count == 0) {
+        seq_printf(m, "No perf run\n");
+        mutex_unlock(&bkn_perf_lock);
+        return 0;
+    }
+
+    usecs = div_u64(bkn_perf.elapsed_ns, NSEC_PER_USEC);
+    if (usecs == 0) {
+        usecs = 1;
+    }
+    pps = div_u64((uint64_t)bkn_perf.tx_ok * USEC_PER_SEC, usecs);
+    /* Include preamble, IFG and FCS on the wire */
+    kbps = div_u64(pps * (bkn_perf.len + 24) * 8, 1000);
+
+    seq_printf(m, "Perf run (unit %d, netif %d, len %d, count %d):\n",
+               bkn_perf.unit, bkn_perf.netif, bkn_perf.len, bkn_perf.count);
+    seq_printf(m, "  Tx ok       %10u\n", bkn_perf.tx_ok);
+    seq_printf(m, "  Tx failed   %10u\n", bkn_perf.tx_fail);
+    seq_printf(m, "  Elapsed us  %10llu\n", (unsigned long long)usecs);
+    seq_printf(m, "  Tx pps      %10llu\n", (unsigned long long)pps);
+    seq_printf(m, "  Tx Gbps     %6llu.%03llu\n",
+               (unsigned long long)div_u64(kbps, 1000000),
+               (unsigned long long)div_u64(kbps, 1000) % 1000);
+    for (chan = 0; chan < NUM_RX_CHAN; chan++) {
+        if (bkn_perf.rx_pkts[chan] == 0) {
+            continue;
+        }
+        seq_printf(m, "  Rx%d packets %10u\n", chan, bkn_perf.rx_pkts[chan]);
+        seq_printf(m, "  Rx%d pps     %10llu\n", chan,
+                   (unsigned long long)div_u64((uint64_t)bkn_perf.rx_pkts[chan] *
+                                               USEC_PER_SEC, usecs));
+    }
+    seq_printf(m, "  Interrupts  %10u\n", bkn_perf.interrupts);
+    if (bkn_perf.tx_ok == 0) {
+        seq_printf(m, "  Intr/kpkt            -\n");
+    } else {
+        seq_printf(m, "  Intr/kpkt   %10u\n",
+                   (uint32_t)div_u64((uint64_t)bkn_perf.interrupts * 1000,
+                                     bkn_perf.tx_ok));
+    }
+    seq_printf(m, "  Rx samples  %10u\n", bkn_perf.lat_samples);
+    seq_printf(m, "  Rx p50 us   %10u\n", bkn_perf_lat_pct(50));
+    seq_printf(m, "  Rx p99 us   %10u\n", bkn_perf_lat_pct(99));
+    seq_printf(m, "  Rx max us   %10llu\n",
+               (unsigned long long)div_u64(bkn_perf.lat_max_ns, NSEC_PER_USEC));
+
+    mutex_unlock(&bkn_perf_lock);
+
+    return 0;
+}
+
+static int
+bkn_proc_perf_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, bkn_proc_perf_show, NULL);
+}
+
+static struct sk_buff *
+bkn_perf_skb_alloc(struct net_device *dev, int len)
+{
+    struct sk_buff *skb;
+    struct ethhdr *eth;
+
+    skb = dev_alloc_skb(len + 64);
+    if (skb == NULL) {
+        return NULL;
+    }
+    skb_reserve(skb, 64);
+    memset(skb_put(skb, len), 0, len);
+    eth = (struct ethhdr *)skb->data;
+    memcpy(eth->h_dest, dev->dev_addr, ETH_ALEN);
+    memcpy(eth->h_source, dev->dev_addr, ETH_ALEN);
+    /* IEEE local experimental EtherType */
+    eth->h_proto = htons(0x88b5);
+    skb->dev = dev;
+    return skb;
+}
+
+/*
+ * Send count packets of len bytes through the netif Tx path. Called
+ * with bkn_perf_lock held.
+ */
+static int
+bkn_perf_run(bkn_switch_info_t *sinfo, int unit, int id, int len, int count)
+{
+    struct net_device *dev;
+    bkn_priv_t *priv;
+    struct sk_buff *skb;
+    unsigned long busy_until;
+    unsigned long tx_packets, tx_dropped;
+    uint32_t interrupts, rx_pkts[NUM_RX_CHAN];
+    uint64_t start;
+    int sent, rv, chan;
+
+    spin_lock(&sinfo->cfg_lock);
+    dev = NULL;
+    list_for_each_entry(priv, &sinfo->ndev_list, list) {
+        if (priv->id == id) {
+            dev = priv->dev;
+            dev_hold(dev);
+            break;
+        }
+    }
+    spin_unlock(&sinfo->cfg_lock);
+    if (dev == NULL) {
+        gprintk("Warning: unknown netif: %d\n", id);
+        return -ENODEV;
+    }
+    priv = netdev_priv(dev);
+
+    memset(&bkn_perf, 0, sizeof(bkn_perf));
+    bkn_perf.unit = unit;
+    bkn_perf.netif = id;
+    bkn_perf.len = len;
+    bkn_perf.count = count;
+    bkn_perf.sinfo = sinfo;
+
+    tx_packets = priv->stats.tx_packets;
+    tx_dropped = priv->stats.tx_dropped;
+    interrupts = sinfo->interrupts;
+    for (chan = 0; chan < NUM_RX_CHAN; chan++) {
+        rx_pkts[chan] = sinfo->rx[chan].pkts;
+    }
+    bkn_perf_active = 1;
+    start = ktime_to_ns(ktime_get());
+
+    rv = 0;
+    skb = NULL;
+    busy_until = 0;
+    for (sent = 0; sent < count; ) {
+        if (skb == NULL) {
+            skb = bkn_perf_skb_alloc(dev, len);
+            if (skb == NULL) {
+                bkn_perf.tx_fail++;
+                rv = -ENOMEM;
+                break;
+            }
+        }
+        if (netif_queue_stopped(dev)) {
+            /* Wait for Tx DMA to catch up */
+            if (busy_until == 0) {
+                busy_until = jiffies + msecs_to_jiffies(BKN_PERF_BUSY_MSEC);
+            } else if (time_after(jiffies, busy_until)) {
+                rv = -EBUSY;
+                break;
+            }
+            usleep_range(20, 50);
+            continue;
+        }
+        local_bh_disable();
+        rv = bkn_tx(skb, dev);
+        local_bh_enable();
+        if (rv == BKN_NETDEV_TX_BUSY) {
+            /* Not consumed, try again once Tx resumes */
+            rv = 0;
+            continue;
+        }
+        skb = NULL;
+        busy_until = 0;
+        sent++;
+        if ((sent & 0xff) == 0) {
+            if (signal_pending(current)) {
+                rv = -EINTR;
+                break;
+            }
+            cond_resched();
+        }
+    }
+    if (skb != NULL) {
+        dev_kfree_skb_any(skb);
+    }
+
+    bkn_perf.elapsed_ns = ktime_to_ns(ktime_get()) - start;
+
+    /* Give looped back packets a chance to arrive */
+    msleep(BKN_PERF_DRAIN_MSEC);
+    bkn_perf_active = 0;
+
+    bkn_perf.tx_ok = priv->stats.tx_packets - tx_packets;
+    bkn_perf.tx_fail += priv->stats.tx_dropped - tx_dropped;
+    bkn_perf.tx_fail += count - sent;
+    bkn_perf.interrupts = sinfo->interrupts - interrupts;
+    for (chan = 0; chan < NUM_RX_CHAN; chan++) {
+        bkn_perf.rx_pkts[chan] = sinfo->rx[chan].pkts - rx_pkts[chan];
+    }
+
+    dev_put(dev);
+
+    return rv;
+}
+
+/*
+ * Loopback Performance Proc Write Entry
+ *
+ *   Syntax:
+ *   [<unit>:]netif=<id>[,len=<bytes>][,count=<packets>]
+ *
+ *   Where <id> is the ID of a netif. Packets are sent through the
+ *   regular netif Tx path, so the egress port should be in loopback
+ *   and a filter should steer the packets back to a netif. Default
+ *   is 60 byte packets and a count of 100000. The write does not
+ *   return until the run has completed.
+ *
+ *   Examples:
+ *   netif=1
+ *   0:netif=2,len=1500,count=1000000
+ */
+static ssize_t
+bkn_proc_perf_write(struct file *file, const char *buf,
+                    size_t count, loff_t *loff)
+{
+    bkn_switch_info_t *sinfo;
+    char perf_str[80];
+    char *ptr;
+    int unit, id, len, pkts, rv;
+
+    if (count > sizeof(perf_str)) {
+        count = sizeof(perf_str) - 1;
+    }
+    if (copy_from_user(perf_str, buf, count)) {
+        return -EFAULT;
+    }
+    perf_str[count] = '\0';
+
+    unit = simple_strtol(perf_str, NULL, 10);
+    sinfo = bkn_sinfo_from_unit(unit);
+    if (sinfo == NULL) {
+        gprintk("Warning: unknown unit: %d\n", unit);
+        return count;
+    }
+
+    if ((ptr = strstr(perf_str, "netif=")) == NULL) {
+        gprintk("Warning: unknown configuration setting\n");
+        return count;
+    }
+    id = simple_strtol(ptr + 6, NULL, 10);
+
+    len = BKN_PERF_LEN_MIN;
+    if ((ptr = strstr(perf_str, "len=")) != NULL) {
+        len = simple_strtol(ptr + 4, NULL, 10);
+        if (len < BKN_PERF_LEN_MIN) {
+            len = BKN_PERF_LEN_MIN;
+        } else if (len > BKN_PERF_LEN_MAX) {
+            len = BKN_PERF_LEN_MAX;
+        }
+    }
+
+    pkts = BKN_PERF_COUNT_DEF;
+    if ((ptr = strstr(perf_str, "count=")) != NULL) {
+        pkts = simple_strtol(ptr + 6, NULL, 10);
+        if (pkts <= 0) {
+            pkts = BKN_PERF_COUNT_DEF;
+        }
+    }
+
+    if (!mutex_trylock(&bkn_perf_lock)) {
+        return -EBUSY;
+    }
+    rv = bkn_perf_run(sinfo, unit, id, len, pkts);
+    mutex_unlock(&bkn_perf_lock);
+    if (rv < 0 && rv != -EINTR && rv != -EBUSY) {
+        return rv;
+    }
+
+    return count;
+}
+
+struct file_operations bkn_proc_perf_file_ops = {
+    owner:      THIS_MODULE,
+    open:       bkn_proc_perf_open,
+    read:       seq_read,
+    llseek:     seq_lseek,
+    write:      bkn_proc_perf_write,
+    release:    single_release,
+};
+
 static int
 bkn_proc_init(void)
 {
@@ -7128,6 +9498,18 @@ bkn_proc_init(void)
     if (entry == NULL) {
         return -1;
     }
+    PROC_CREATE(entry, "filter", 0, bkn_proc_root, &bkn_proc_filter_file_ops);
+    if (entry == NULL) {
+        return -1;
+    }
+    PROC_CREATE(entry, "perf", 0666, bkn_proc_root, &bkn_proc_perf_file_ops);
+    if (entry == NULL) {
+        return -1;
+    }
+    PROC_CREATE(entry, "fstats", 0666, bkn_proc_root, &bkn_proc_fstats_file_ops);
+    if (entry == NULL) {
+        return -1;
+    }
 
     return 0;
 }
@@ -7141,6 +9523,9 @@ bkn_proc_cleanup(void)
     remove_proc_entry("debug", bkn_proc_root);
     remove_proc_entry("stats", bkn_proc_root);
     remove_proc_entry("dstats", bkn_proc_root);
+    remove_proc_entry("filter", bkn_proc_root);
+    remove_proc_entry("perf", bkn_proc_root);
+    remove_proc_entry("fstats", bkn_proc_root);
     return 0;
 }
 
@@ -7297,6 +9682,78 @@ bkn_knet_dma_info(kcom_msg_dma_info_t *kmsg, int len)
     return sizeof(kcom_msg_hdr_t);
 }
 
+/*
+ * The shared ring is allocated on first use and kept until the device
+ * is removed, since the application may still have it mapped.
+ */
+static int
+bkn_knet_dma_ring(kcom_msg_dma_ring_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    struct eventfd_ctx *evfd = NULL;
+    kcom_dma_ring_hdr_t *hdr;
+    unsigned long flags;
+    int map_size;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    if (sinfo == NULL || api_rx_ring == 0) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    if ((kmsg->flags & KCOM_DMA_RING_F_ENABLE) && kmsg->eventfd >= 0) {
+        evfd = eventfd_ctx_fdget(kmsg->eventfd);
+        if (IS_ERR(evfd)) {
+            kmsg->hdr.status = KCOM_E_PARAM;
+            return sizeof(kcom_msg_hdr_t);
+        }
+    }
+
+    if ((kmsg->flags & KCOM_DMA_RING_F_ENABLE) && sinfo->api_ring.hdr == NULL) {
+        map_size = PAGE_ALIGN(KCOM_DMA_RING_HDR_SIZE +
+                              api_rx_ring * sizeof(kcom_dma_ring_entry_t));
+        hdr = vmalloc_user(map_size);
+        if (hdr == NULL) {
+            if (evfd) {
+                eventfd_ctx_put(evfd);
+            }
+            kmsg->hdr.status = KCOM_E_RESOURCE;
+            return sizeof(kcom_msg_hdr_t);
+        }
+        hdr->size = api_rx_ring;
+        spin_lock_irqsave(&sinfo->lock, flags);
+        sinfo->api_ring.entry = (kcom_dma_ring_entry_t *)
+            ((uint8_t *)hdr + KCOM_DMA_RING_HDR_SIZE);
+        sinfo->api_ring.map_size = map_size;
+        sinfo->api_ring.hdr = hdr;
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+    }
+
+    spin_lock_irqsave(&sinfo->lock, flags);
+    if (kmsg->flags & KCOM_DMA_RING_F_ENABLE) {
+        /* Restart with an empty ring */
+        sinfo->api_ring.prod = 0;
+        sinfo->api_ring.pub = 0;
+        sinfo->api_ring.overflow = 0;
+        sinfo->api_ring.hdr->prod = 0;
+        sinfo->api_ring.hdr->cons = 0;
+        sinfo->api_ring.hdr->overflows = 0;
+        sinfo->api_ring.active = 1;
+    } else {
+        sinfo->api_ring.active = 0;
+    }
+    swap(evfd, sinfo->api_ring.evfd);
+    spin_unlock_irqrestore(&sinfo->lock, flags);
+
+    if (evfd) {
+        eventfd_ctx_put(evfd);
+    }
+
+    return sizeof(kcom_msg_hdr_t);
+}
+
 static int
 bkn_create_inst(uint32 inst_id)
 {
@@ -7441,12 +9898,12 @@ bkn_knet_hw_reset(kcom_msg_hw_reset_t *kmsg, int len)
         /* Clean all if no channels specified */
         bkn_dma_abort(sinfo);
         bkn_clean_dcbs(sinfo);
-        skb_queue_purge(&sinfo->tx_ptp_queue);
+        bkn_hw_tstamp_tx_purge(sinfo);
     } else {
         if (kmsg->channels & (1 << XGS_DMA_TX_CHAN)) {
             bkn_dma_abort_tx(sinfo);
             bkn_clean_tx_dcbs(sinfo);
-            skb_queue_purge(&sinfo->tx_ptp_queue);
+            bkn_hw_tstamp_tx_purge(sinfo);
         }
         for (chan = 0; chan < sinfo->rx_chans; chan++) {
             if (kmsg->channels & (1 << (XGS_DMA_RX_CHAN + chan))) {
@@ -7494,6 +9951,14 @@ bkn_knet_hw_init(kcom_msg_hw_init_t *kmsg, int len)
         sinfo->cmic_type, sinfo->dcb_type, sinfo->dcb_wsize,
         sinfo->dma_hi, sinfo->pkt_hdr_size));
 
+    /* System header field layout */
+    if (device_is_dnx(sinfo)) {
+        bkn_dnx_hdr_layout_init(sinfo);
+    }
+
+    /* Rx buffer layout, the Rx DCBs are set up again below */
+    sinfo->rx_sg = rx_sg_pages && !device_is_sand(sinfo);
+
     /* Config Continuous DMA mode */
     sinfo->cdma_channels = kmsg->cdma_channels & ~(~0 << (sinfo->rx_chans + 1));
 
@@ -7533,6 +9998,15 @@ bkn_knet_hw_init(kcom_msg_hw_init_t *kmsg, int len)
     /* Register interrupt handler */
     kernel_bde->interrupt_connect(sinfo->dev_no | LKBDE_ISR2_DEV,
                                   bkn_isr, sinfo);
+    if (msix_vec > 0 && sinfo->msix_vec == 0) {
+        if (lkbde_irq_vector_connect(sinfo->dev_no, msix_vec,
+                                     bkn_isr, sinfo) == 0) {
+            sinfo->msix_vec = msix_vec;
+        } else {
+            gprintk("Unit %d: MSI-X vector %d not available\n",
+                    sinfo->dev_no, msix_vec);
+        }
+    }
 
     /* Init DCBs */
     bkn_init_dcbs(sinfo);
@@ -7589,72 +10063,64 @@ bkn_knet_reprobe(kcom_msg_reprobe_t *kmsg, int len)
     return sizeof(kcom_msg_reprobe_t);
 }
 
+/*
+ * Allocate and register the network device for a netif. The netif is
+ * not visible to the Rx path until it has been inserted.
+ */
 static int
-bkn_knet_netif_create(kcom_msg_netif_create_t *kmsg, int len)
+bkn_netif_alloc(bkn_switch_info_t *sinfo, kcom_netif_t *netif,
+                struct net_device **ndev)
 {
-    bkn_switch_info_t *sinfo;
     struct net_device *dev;
-    struct list_head *list;
-    bkn_priv_t *priv, *lpriv;
-    unsigned long flags;
-    int found, id;
+    bkn_priv_t *priv;
     uint8 *ma;
 
-    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
-
-    switch (kmsg->netif.type) {
+    switch (netif->type) {
     case KCOM_NETIF_T_VLAN:
     case KCOM_NETIF_T_PORT:
     case KCOM_NETIF_T_META:
         break;
     default:
-        kmsg->hdr.status = KCOM_E_PARAM;
-        return sizeof(kcom_msg_hdr_t);
+        return KCOM_E_PARAM;
     }
-    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
-    if (sinfo == NULL) {
-        kmsg->hdr.status = KCOM_E_PARAM;
-        return sizeof(kcom_msg_hdr_t);
-    }
-    ma = kmsg->netif.macaddr;
+    ma = netif->macaddr;
     if ((ma[0] | ma[1] | ma[2] | ma[3] | ma[4] | ma[5]) == 0) {
         bkn_dev_mac[5]++;
         ma = bkn_dev_mac;
     }
-    if ((dev = bkn_init_ndev(ma, kmsg->netif.name)) == NULL) {
-        kmsg->hdr.status = KCOM_E_RESOURCE;
-        return sizeof(kcom_msg_hdr_t);
+    if ((dev = bkn_init_ndev(ma, netif->name)) == NULL) {
+        return KCOM_E_RESOURCE;
     }
     priv = netdev_priv(dev);
     priv->dev = dev;
     priv->sinfo = sinfo;
-    priv->type = kmsg->netif.type;
-    priv->vlan = kmsg->netif.vlan;
+    priv->type = netif->type;
+    priv->vlan = netif->vlan;
     if (priv->type == KCOM_NETIF_T_PORT) {
-        priv->port = kmsg->netif.port;
+        priv->port = netif->port;
         if (device_is_dpp(sinfo)) {
-            memcpy(priv->itmh, kmsg->netif.itmh, 4);
+            memcpy(priv->itmh, netif->itmh, 4);
         } else if (device_is_dnx(sinfo)) {
-            memcpy(priv->system_headers, kmsg->netif.system_headers, kmsg->netif.system_headers_size);
-            priv->system_headers_size = kmsg->netif.system_headers_size;
+            memcpy(priv->system_headers, netif->system_headers, netif->system_headers_size);
+            priv->system_headers_size = netif->system_headers_size;
         }
-        priv->qnum = kmsg->netif.qnum;
+        priv->qnum = netif->qnum;
     } else {
         if (device_is_sand(sinfo)) {
             if (device_is_dpp(sinfo)) {
-                priv->port = kmsg->netif.port;
-                priv->qnum = kmsg->netif.qnum;
+                priv->port = netif->port;
+                priv->qnum = netif->qnum;
             }else if (device_is_dnx(sinfo)) {
-                memcpy(priv->system_headers, kmsg->netif.system_headers, kmsg->netif.system_headers_size);
-                priv->system_headers_size = kmsg->netif.system_headers_size;
+                memcpy(priv->system_headers, netif->system_headers, netif->system_headers_size);
+                priv->system_headers_size = netif->system_headers_size;
             }
         }
         else {
             priv->port = -1;
         }
     }
-    priv->flags = kmsg->netif.flags;
-    priv->cb_user_data = kmsg->netif.cb_user_data;
+    priv->flags = netif->flags;
+    priv->cb_user_data = netif->cb_user_data;
 
     /* Force RCPU encapsulation if rcpu_mode */
     if (rcpu_mode) {
@@ -7662,11 +10128,65 @@ bkn_knet_netif_create(kcom_msg_netif_create_t *kmsg, int len)
         DBG_RCPU(("RCPU auto-enabled\n"));
     }
 
+    *ndev = dev;
+    return KCOM_E_NONE;
+}
+
+/*
+ * Make sure the netif table can hold IDs up to max_id. A replaced
+ * table is returned through old_table and must be freed after an RCU
+ * grace period. Called with sinfo->cfg_lock held.
+ */
+static void
+bkn_ndev_table_grow(bkn_switch_info_t *sinfo, int max_id,
+                    bkn_ndev_table_t **old_table)
+{
+    bkn_ndev_table_t *table = sinfo->ndev_table;
+    bkn_ndev_table_t *new_table;
+    int ndev_max, size;
+
+    if (table != NULL && max_id < table->ndev_max) {
+        return;
+    }
+    ndev_max = (max_id / NDEVS_CHUNK + 1) * NDEVS_CHUNK;
+    size = sizeof(*table) + ndev_max * sizeof(struct net_device *);
+    new_table = kmalloc(size, GFP_ATOMIC);
+    if (new_table == NULL) {
+        /* Netifs beyond the table are found through the slow path */
+        return;
+    }
+    DBG_NDEV(("Reallocate netif table for ID %d\n", max_id));
+    memset(new_table, 0, size);
+    new_table->ndev_max = ndev_max;
+    if (table != NULL) {
+        size = table->ndev_max * sizeof(struct net_device *);
+        memcpy(new_table->ndevs, table->ndevs, size);
+    }
+    /* Old table is freed once Rx lookups are done with it */
+    rcu_assign_pointer(sinfo->ndev_table, new_table);
+    *old_table = table;
+}
+
+/*
+ * Assign the lowest free ID to a netif and make it visible to the Rx
+ * path. The netif table must already be large enough for the ID. The
+ * assigned ID, name and MAC address are returned in netif.
+ * Called with sinfo->cfg_lock held.
+ */
+static void
+bkn_netif_insert(bkn_switch_info_t *sinfo, struct net_device *dev,
+                 kcom_netif_t *netif, int unit)
+{
+    struct list_head *list;
+    bkn_priv_t *priv, *lpriv;
+    bkn_ndev_table_t *table;
+    int found, id;
+
+    priv = netdev_priv(dev);
+
     /* Prevent (incorrect) compiler warning */
     lpriv = NULL;
 
-    spin_lock_irqsave(&sinfo->lock, flags);
-
     /*
      * We insert network interfaces sorted by ID.
      * In case an interface is destroyed, we reuse the ID
@@ -7685,57 +10205,162 @@ bkn_knet_netif_create(kcom_msg_netif_create_t *kmsg, int len)
     priv->id = id;
     if (found) {
         /* Replace previously removed interface */
-        list_add_tail(&priv->list, &lpriv->list);
+        list_add_tail_rcu(&priv->list, &lpriv->list);
     } else {
         /* No holes - add to end of list */
-        list_add_tail(&priv->list, &sinfo->ndev_list);
+        list_add_tail_rcu(&priv->list, &sinfo->ndev_list);
     }
 
-    if (id < sinfo->ndev_max) {
+    table = sinfo->ndev_table;
+    if (table != NULL && id < table->ndev_max) {
         DBG_NDEV(("Add netif ID %d to table\n", id));
-        sinfo->ndevs[id] = dev;
-    } else {
-        int ndev_max = sinfo->ndev_max + NDEVS_CHUNK;
-        int size = ndev_max * sizeof(struct net_device *);
-        void *ndevs = kmalloc(size, GFP_ATOMIC);
-        if (ndevs != NULL) {
-            DBG_NDEV(("Reallocate netif table for ID %d\n", id));
-            memset(ndevs, 0, size);
-            if (sinfo->ndevs != NULL) {
-                size = sinfo->ndev_max * sizeof(struct net_device *);
-                memcpy(ndevs, sinfo->ndevs, size);
-                kfree(sinfo->ndevs);
-            }
-            sinfo->ndevs = ndevs;
-            sinfo->ndev_max = ndev_max;
-            sinfo->ndevs[id] = dev;
-        }
+        rcu_assign_pointer(table->ndevs[id], dev);
     }
 
     DBG_VERB(("Assigned ID %d to Ethernet device %s\n",
               priv->id, dev->name));
 
-    kmsg->netif.id = priv->id;
-    memcpy(kmsg->netif.macaddr, dev->dev_addr, 6);
-    memcpy(kmsg->netif.name, dev->name, KCOM_NETIF_NAME_MAX - 1);
+    netif->id = priv->id;
+    memcpy(netif->macaddr, dev->dev_addr, 6);
+    memcpy(netif->name, dev->name, KCOM_NETIF_NAME_MAX - 1);
 
     if (knet_netif_create_cb != NULL) {
-        int retv = knet_netif_create_cb(kmsg->hdr.unit, &(kmsg->netif), dev);
+        int retv = knet_netif_create_cb(unit, netif, dev);
         if (retv) { 
             gprintk("Warning: knet_netif_create_cb() returned %d for netif '%s'\n", retv, dev->name);
         }
     }
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
-
     if (device_is_dnx(sinfo)) {
         int idx = 0;
         for (idx = 0; idx < priv->system_headers_size; idx++) {
             DBG_DUNE(("System Header[%d]: 0x%02x\n", idx, priv->system_headers[idx]));
         }
     }
+}
+
+/* Number of netifs. Called with sinfo->cfg_lock held. */
+static int
+bkn_netif_count(bkn_switch_info_t *sinfo)
+{
+    struct list_head *list;
+    int cnt = 0;
+
+    list_for_each(list, &sinfo->ndev_list) {
+        cnt++;
+    }
+    return cnt;
+}
+
+static int
+bkn_knet_netif_create(kcom_msg_netif_create_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    struct net_device *dev;
+    bkn_ndev_table_t *old_table;
+    int rv;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    switch (kmsg->netif.type) {
+    case KCOM_NETIF_T_VLAN:
+    case KCOM_NETIF_T_PORT:
+    case KCOM_NETIF_T_META:
+        break;
+    default:
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    if (sinfo == NULL) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+    rv = bkn_netif_alloc(sinfo, &kmsg->netif, &dev);
+    if (rv != KCOM_E_NONE) {
+        kmsg->hdr.status = rv;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    old_table = NULL;
+
+    spin_lock(&sinfo->cfg_lock);
+    /* Lowest free ID is at most the number of netifs plus one */
+    bkn_ndev_table_grow(sinfo, bkn_netif_count(sinfo) + 1, &old_table);
+    bkn_netif_insert(sinfo, dev, &kmsg->netif, kmsg->hdr.unit);
+    spin_unlock(&sinfo->cfg_lock);
+
+    if (old_table != NULL) {
+        synchronize_rcu();
+        kfree(old_table);
+    }
+
+    return sizeof(*kmsg);
+}
+
+/*
+ * Create multiple netifs. All network devices are allocated up front,
+ * and then inserted under a single hold of the configuration lock.
+ */
+static int
+bkn_knet_netif_create_bulk(kcom_msg_netif_create_bulk_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    struct net_device **devs;
+    bkn_ndev_table_t *old_table;
+    int idx, cnt, rv;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    cnt = kmsg->cnt;
+    if (sinfo == NULL || cnt <= 0 || cnt > KCOM_NETIF_BULK_MAX ||
+        len < (int)(sizeof(*kmsg) - sizeof(kmsg->netif) +
+                    cnt * sizeof(kmsg->netif[0]))) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    devs = kmalloc(cnt * sizeof(*devs), GFP_KERNEL);
+    if (devs == NULL) {
+        kmsg->hdr.status = KCOM_E_RESOURCE;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    for (idx = 0; idx < cnt; idx++) {
+        rv = bkn_netif_alloc(sinfo, &kmsg->netif[idx], &devs[idx]);
+        if (rv != KCOM_E_NONE) {
+            kmsg->hdr.status = rv;
+            kmsg->hdr.id = idx;
+            /* Nothing has been inserted yet */
+            while (idx-- > 0) {
+                unregister_netdev(devs[idx]);
+                free_netdev(devs[idx]);
+            }
+            kfree(devs);
+            return sizeof(kcom_msg_hdr_t);
+        }
+    }
+
+    old_table = NULL;
+
+    spin_lock(&sinfo->cfg_lock);
+    bkn_ndev_table_grow(sinfo, bkn_netif_count(sinfo) + cnt, &old_table);
+    for (idx = 0; idx < cnt; idx++) {
+        bkn_netif_insert(sinfo, devs[idx], &kmsg->netif[idx],
+                         kmsg->hdr.unit);
+    }
+    spin_unlock(&sinfo->cfg_lock);
+
+    if (old_table != NULL) {
+        synchronize_rcu();
+        kfree(old_table);
+    }
+    kfree(devs);
+
+    DBG_VERB(("Created %d netifs\n", cnt));
 
-    return sizeof(*kmsg);
+    return sizeof(*kmsg) - sizeof(kmsg->netif) + (cnt * sizeof(kmsg->netif[0]));
 }
 
 static int
@@ -7745,7 +10370,6 @@ bkn_knet_netif_destroy(kcom_msg_netif_destroy_t *kmsg, int len)
     struct net_device *dev;
     bkn_priv_t *priv;
     struct list_head *list;
-    unsigned long flags;
     int found;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
@@ -7756,7 +10380,7 @@ bkn_knet_netif_destroy(kcom_msg_netif_destroy_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
     found = 0;
     list_for_each(list, &sinfo->ndev_list) {
@@ -7768,7 +10392,7 @@ bkn_knet_netif_destroy(kcom_msg_netif_destroy_t *kmsg, int len)
     }
 
     if (!found) {
-        spin_unlock_irqrestore(&sinfo->lock, flags);
+        spin_unlock(&sinfo->cfg_lock);
         kmsg->hdr.status = KCOM_E_NOT_FOUND;
         return sizeof(kcom_msg_hdr_t);
     }
@@ -7779,13 +10403,16 @@ bkn_knet_netif_destroy(kcom_msg_netif_destroy_t *kmsg, int len)
         netif.id = priv->id;
         knet_netif_destroy_cb(kmsg->hdr.unit, &netif, priv->dev);
     }
-    list_del(&priv->list);
+    list_del_rcu(&priv->list);
 
-    if (priv->id < sinfo->ndev_max) {
-        sinfo->ndevs[priv->id] = NULL;
+    if (sinfo->ndev_table != NULL && priv->id < sinfo->ndev_table->ndev_max) {
+        RCU_INIT_POINTER(sinfo->ndev_table->ndevs[priv->id], NULL);
     }
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_unlock(&sinfo->cfg_lock);
+
+    /* Wait for Rx lookups which may still reference the netif */
+    synchronize_rcu();
 
     dev = priv->dev;
     DBG_VERB(("Removing virtual Ethernet device %s (%d).\n",
@@ -7802,7 +10429,6 @@ bkn_knet_netif_list(kcom_msg_netif_list_t *kmsg, int len)
     bkn_switch_info_t *sinfo;
     bkn_priv_t *priv;
     struct list_head *list;
-    unsigned long flags;
     int idx;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
@@ -7813,7 +10439,7 @@ bkn_knet_netif_list(kcom_msg_netif_list_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
     idx = 0;
     list_for_each(list, &sinfo->ndev_list) {
@@ -7828,17 +10454,34 @@ bkn_knet_netif_list(kcom_msg_netif_list_t *kmsg, int len)
     }
     kmsg->ifcnt = idx;
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_unlock(&sinfo->cfg_lock);
 
     return sizeof(*kmsg) - sizeof(kmsg->id) + (idx * sizeof(kmsg->id[0]));
 }
 
+static void
+bkn_netif_info_get(bkn_priv_t *priv, kcom_netif_t *netif)
+{
+    memcpy(netif->macaddr, priv->dev->dev_addr, 6);
+    memcpy(netif->name, priv->dev->name, KCOM_NETIF_NAME_MAX - 1);
+    netif->vlan = priv->vlan;
+    netif->type = priv->type;
+    netif->id = priv->id;
+    netif->flags = priv->flags;
+
+    if (priv->port < 0) {
+        netif->port = 0;
+    } else {
+        netif->port = priv->port;
+    }
+    netif->qnum = priv->qnum;
+}
+
 static int
 bkn_knet_netif_get(kcom_msg_netif_get_t *kmsg, int len)
 {
     bkn_switch_info_t *sinfo;
     bkn_priv_t *priv;
-    unsigned long flags;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
 
@@ -7848,43 +10491,30 @@ bkn_knet_netif_get(kcom_msg_netif_get_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    rcu_read_lock();
 
     priv = bkn_netif_lookup(sinfo, kmsg->hdr.id);
 
     if (priv == NULL) {
-        spin_unlock_irqrestore(&sinfo->lock, flags);
+        rcu_read_unlock();
         kmsg->hdr.status = KCOM_E_NOT_FOUND;
         return sizeof(kcom_msg_hdr_t);
     }
 
-    memcpy(kmsg->netif.macaddr, priv->dev->dev_addr, 6);
-    memcpy(kmsg->netif.name, priv->dev->name, KCOM_NETIF_NAME_MAX - 1);
-    kmsg->netif.vlan = priv->vlan;
-    kmsg->netif.type = priv->type;
-    kmsg->netif.id = priv->id;
-    kmsg->netif.flags = priv->flags;
-
-    if (priv->port < 0) {
-        kmsg->netif.port = 0;
-    } else {
-        kmsg->netif.port = priv->port;
-    }
-    kmsg->netif.qnum = priv->qnum;
+    bkn_netif_info_get(priv, &kmsg->netif);
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    rcu_read_unlock();
 
     return sizeof(*kmsg);
 }
 
 static int
-bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
+bkn_knet_netif_get_bulk(kcom_msg_netif_get_bulk_t *kmsg, int len)
 {
     bkn_switch_info_t *sinfo;
+    bkn_priv_t *priv;
     struct list_head *list;
-    bkn_filter_t *filter, *lfilter;
-    unsigned long flags;
-    int found, id;
+    int idx, max;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
 
@@ -7894,15 +10524,64 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    switch (kmsg->filter.type) {
-    case KCOM_FILTER_T_RX_PKT:
-        break;
-    default:
-        kmsg->hdr.status = KCOM_E_PARAM;
-        return sizeof(kcom_msg_hdr_t);
+    max = kmsg->cnt;
+    if (max <= 0 || max > KCOM_NETIF_BULK_MAX) {
+        max = KCOM_NETIF_BULK_MAX;
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
+
+    /* Netif list is sorted by ID */
+    idx = 0;
+    kmsg->more = 0;
+    list_for_each(list, &sinfo->ndev_list) {
+        priv = (bkn_priv_t *)list;
+        if (priv->id < kmsg->hdr.id) {
+            continue;
+        }
+        if (idx >= max) {
+            kmsg->more = 1;
+            break;
+        }
+        memset(&kmsg->netif[idx], 0, sizeof(kmsg->netif[idx]));
+        bkn_netif_info_get(priv, &kmsg->netif[idx]);
+        idx++;
+    }
+    kmsg->cnt = idx;
+
+    spin_unlock(&sinfo->cfg_lock);
+
+    return sizeof(*kmsg) - sizeof(kmsg->netif) + (idx * sizeof(kmsg->netif[0]));
+}
+
+/* Called with sinfo->cfg_lock held */
+static bkn_filter_t *
+bkn_filter_find(bkn_switch_info_t *sinfo, int id)
+{
+    struct list_head *list;
+    bkn_filter_t *filter;
+
+    list_for_each(list, &sinfo->rxpf_list) {
+        filter = (bkn_filter_t *)list;
+        if (id == filter->kf.id) {
+            return filter;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Allocate a filter ID and add the filter to rxpf_list according to
+ * priority. The filter is not visible to the Rx path until it has been
+ * added to the filter engine. Called with sinfo->cfg_lock held.
+ */
+static int
+bkn_filter_link(bkn_switch_info_t *sinfo, bkn_filter_t *filter)
+{
+    struct list_head *list;
+    bkn_filter_t *lfilter;
+    unsigned long flags;
+    int found, id;
 
     /*
      * Find available ID
@@ -7910,42 +10589,29 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
     found = 1;
     id = 0;
     while (found && ++id < KCOM_FILTER_MAX) {
-        found = 0;
-        list_for_each(list, &sinfo->rxpf_list) {
-            lfilter = (bkn_filter_t *)list;
-            if (id == lfilter->kf.id) {
-                found = 1;
-                break;
-            }
-        }
+        found = (bkn_filter_find(sinfo, id) != NULL);
     }
     if (found) {
         /* Too many filters */
-        spin_unlock_irqrestore(&sinfo->lock, flags);
-        kmsg->hdr.status = KCOM_E_RESOURCE;
-        return sizeof(kcom_msg_hdr_t);
-    }
-
-    filter = kmalloc(sizeof(*filter), GFP_ATOMIC);
-    if (filter == NULL) {
-        spin_unlock_irqrestore(&sinfo->lock, flags);
-        kmsg->hdr.status = KCOM_E_PARAM;
-        return sizeof(kcom_msg_hdr_t);
+        return KCOM_E_RESOURCE;
     }
-    memset(filter, 0, sizeof(*filter));
-    memcpy(&filter->kf, &kmsg->filter, sizeof(filter->kf));
 
     if (device_is_dnx(sinfo)) {
         /* Information to parser Dune system headers */
-        sinfo->ftmh_lb_key_ext_size = kmsg->filter.ftmh_lb_key_ext_size;
-        sinfo->ftmh_stacking_ext_size = kmsg->filter.ftmh_stacking_ext_size;
-        sinfo->pph_base_size = kmsg->filter.pph_base_size;
-        memcpy(sinfo->pph_lif_ext_size, kmsg->filter.pph_lif_ext_size, sizeof(sinfo->pph_lif_ext_size));
-        sinfo->udh_enable = kmsg->filter.udh_enable;
-        memcpy(sinfo->udh_length_type, kmsg->filter.udh_length_type, sizeof(sinfo->udh_length_type));
+        spin_lock_irqsave(&sinfo->lock, flags);
+        sinfo->ftmh_lb_key_ext_size = filter->kf.ftmh_lb_key_ext_size;
+        sinfo->ftmh_stacking_ext_size = filter->kf.ftmh_stacking_ext_size;
+        sinfo->pph_base_size = filter->kf.pph_base_size;
+        memcpy(sinfo->pph_lif_ext_size, filter->kf.pph_lif_ext_size, sizeof(sinfo->pph_lif_ext_size));
+        sinfo->udh_enable = filter->kf.udh_enable;
+        memcpy(sinfo->udh_length_type, filter->kf.udh_length_type, sizeof(sinfo->udh_length_type));
+        bkn_dnx_hdr_layout_init(sinfo);
+        spin_unlock_irqrestore(&sinfo->lock, flags);
     }
 
     filter->kf.id = id;
+    /* Filters of equal priority are checked in creation order */
+    filter->seq = ((uint64_t)filter->kf.priority << 56) | ++sinfo->rxpf_gen;
 
     /* Add according to priority */
     found = 0;
@@ -7961,26 +10627,242 @@ bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
         list_add_tail(&filter->list, &sinfo->rxpf_list);
     }
 
+    return KCOM_E_NONE;
+}
+
+/*
+ * Remove a filter from rxpf_list and the filter engine. A filter group
+ * emptied by the removal is left in filter->fgroup, and both must be
+ * freed after an RCU grace period. Called with sinfo->cfg_lock held.
+ */
+static void
+bkn_filter_unlink(bkn_switch_info_t *sinfo, bkn_filter_t *filter)
+{
+    filter->fgroup = bkn_fgroup_del(sinfo, filter);
+    list_del(&filter->list);
+}
+
+static bkn_filter_t *
+bkn_filter_alloc(kcom_filter_t *kf)
+{
+    bkn_filter_t *filter;
+
+    filter = kmalloc(sizeof(*filter), GFP_KERNEL);
+    if (filter == NULL) {
+        return NULL;
+    }
+    memset(filter, 0, sizeof(*filter));
+    filter->hits = alloc_percpu(unsigned long);
+    if (filter->hits == NULL) {
+        kfree(filter);
+        return NULL;
+    }
+    filter->pol = alloc_percpu(bkn_fpol_t);
+    if (filter->pol == NULL) {
+        free_percpu(filter->hits);
+        kfree(filter);
+        return NULL;
+    }
+    memcpy(&filter->kf, kf, sizeof(filter->kf));
+    return filter;
+}
+
+/* Free an unlinked filter. Must be called after an RCU grace period. */
+static void
+bkn_filter_free(bkn_filter_t *filter)
+{
+    DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
+    if (filter->fgroup != NULL) {
+        kfree(filter->fgroup);
+    }
+    free_percpu(filter->hits);
+    free_percpu(filter->pol);
+    kfree(filter);
+}
+
+static void
+bkn_filter_dnx_dump(bkn_switch_info_t *sinfo, bkn_filter_t *filter)
+{
+    int idx, wsize;
+
+    wsize = BYTES2WORDS(filter->kf.oob_data_size + filter->kf.pkt_data_size);
+    DBG_DUNE(("Filter: oob_data_size = %d pkt_data_size=%d wsize %d\n", filter->kf.oob_data_size, filter->kf.pkt_data_size, wsize));
+    for (idx = 0; idx < wsize; idx++)
+    {
+        DBG_DUNE(("OOB[%d]: 0x%08x [0x%08x]\n", idx, filter->kf.data.w[idx], filter->kf.mask.w[idx]));
+    }
+    DBG_DUNE(("DNX system headers parameters:LB_KEY_EXT %d, STK_EXT %d, PPH_BASE %d, LIF_EXT %d %d %d, UDH_ENA %d, %d %d %d %d\n",
+              sinfo->ftmh_lb_key_ext_size, sinfo->ftmh_stacking_ext_size, sinfo->pph_base_size,
+              sinfo->pph_lif_ext_size[1],sinfo->pph_lif_ext_size[2], sinfo->pph_lif_ext_size[3],
+              sinfo->udh_enable, sinfo->udh_length_type[0], sinfo->udh_length_type[1], sinfo->udh_length_type[2], sinfo->udh_length_type[3]));
+}
+
+static int
+bkn_knet_filter_create(kcom_msg_filter_create_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    bkn_filter_t *filter;
+    int rv;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    if (sinfo == NULL) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    switch (kmsg->filter.type) {
+    case KCOM_FILTER_T_RX_PKT:
+        break;
+    default:
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    filter = bkn_filter_alloc(&kmsg->filter);
+    if (filter == NULL) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    spin_lock(&sinfo->cfg_lock);
+
+    rv = bkn_filter_link(sinfo, filter);
+    if (rv != KCOM_E_NONE) {
+        spin_unlock(&sinfo->cfg_lock);
+        bkn_filter_free(filter);
+        kmsg->hdr.status = rv;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    if (bkn_fgroup_add(sinfo, filter) < 0) {
+        /* Never reached the filter groups, so not visible to Rx */
+        list_del(&filter->list);
+        spin_unlock(&sinfo->cfg_lock);
+        bkn_filter_free(filter);
+        kmsg->hdr.status = KCOM_E_RESOURCE;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
     kmsg->filter.id = filter->kf.id;
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_unlock(&sinfo->cfg_lock);
 
     DBG_VERB(("Created filter ID %d (%s).\n",
               filter->kf.id, filter->kf.desc));
 
     if (device_is_dnx(sinfo)) {
-        int idx, wsize;
-        wsize = BYTES2WORDS(filter->kf.oob_data_size + filter->kf.pkt_data_size);
-        DBG_DUNE(("Filter: oob_data_size = %d pkt_data_size=%d wsize %d\n", filter->kf.oob_data_size, filter->kf.pkt_data_size, wsize));
-        for (idx = 0; idx < wsize; idx++)
-        {
-            DBG_DUNE(("OOB[%d]: 0x%08x [0x%08x]\n", idx, filter->kf.data.w[idx], filter->kf.mask.w[idx]));
+        bkn_filter_dnx_dump(sinfo, filter);
+    }
+
+    return len;
+}
+
+/*
+ * Create multiple filters under a single hold of the configuration
+ * lock. If any filter cannot be added, none of them remain installed.
+ */
+static int
+bkn_knet_filter_create_bulk(kcom_msg_filter_create_bulk_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    bkn_filter_t **filters;
+    int idx, cnt, linked, added, failed, rv;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    cnt = kmsg->cnt;
+    if (sinfo == NULL || cnt <= 0 || cnt > KCOM_FILTER_BULK_MAX ||
+        len < (int)(sizeof(*kmsg) - sizeof(kmsg->filter) +
+                    cnt * sizeof(kmsg->filter[0]))) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    filters = kmalloc(cnt * sizeof(*filters), GFP_KERNEL);
+    if (filters == NULL) {
+        kmsg->hdr.status = KCOM_E_RESOURCE;
+        return sizeof(kcom_msg_hdr_t);
+    }
+    memset(filters, 0, cnt * sizeof(*filters));
+
+    rv = KCOM_E_NONE;
+    for (idx = 0; idx < cnt; idx++) {
+        if (kmsg->filter[idx].type != KCOM_FILTER_T_RX_PKT) {
+            rv = KCOM_E_PARAM;
+            break;
+        }
+        filters[idx] = bkn_filter_alloc(&kmsg->filter[idx]);
+        if (filters[idx] == NULL) {
+            rv = KCOM_E_RESOURCE;
+            break;
+        }
+    }
+    if (rv != KCOM_E_NONE) {
+        kmsg->hdr.status = rv;
+        kmsg->hdr.id = idx;
+        while (idx-- > 0) {
+            bkn_filter_free(filters[idx]);
+        }
+        kfree(filters);
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    spin_lock(&sinfo->cfg_lock);
+
+    added = 0;
+    for (linked = 0; linked < cnt; linked++) {
+        rv = bkn_filter_link(sinfo, filters[linked]);
+        if (rv != KCOM_E_NONE) {
+            break;
         }
-        DBG_DUNE(("DNX system headers parameters:LB_KEY_EXT %d, STK_EXT %d, PPH_BASE %d, LIF_EXT %d %d %d, UDH_ENA %d, %d %d %d %d\n",
-                  sinfo->ftmh_lb_key_ext_size, sinfo->ftmh_stacking_ext_size, sinfo->pph_base_size,
-                  sinfo->pph_lif_ext_size[1],sinfo->pph_lif_ext_size[2], sinfo->pph_lif_ext_size[3],
-                  sinfo->udh_enable, sinfo->udh_length_type[0], sinfo->udh_length_type[1], sinfo->udh_length_type[2], sinfo->udh_length_type[3]));
     }
+    failed = linked;
+    if (rv == KCOM_E_NONE) {
+        for (added = 0; added < cnt; added++) {
+            if (bkn_fgroup_add(sinfo, filters[added]) < 0) {
+                rv = KCOM_E_RESOURCE;
+                break;
+            }
+        }
+        failed = added;
+    }
+    if (rv != KCOM_E_NONE) {
+        /* Roll back the whole batch */
+        kmsg->hdr.status = rv;
+        kmsg->hdr.id = failed;
+        for (idx = 0; idx < linked; idx++) {
+            bkn_filter_unlink(sinfo, filters[idx]);
+        }
+        spin_unlock(&sinfo->cfg_lock);
+
+        if (added > 0) {
+            /* Wait for Rx lookups which may already have seen a filter */
+            synchronize_rcu();
+        }
+        for (idx = 0; idx < cnt; idx++) {
+            bkn_filter_free(filters[idx]);
+        }
+        kfree(filters);
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    for (idx = 0; idx < cnt; idx++) {
+        kmsg->filter[idx].id = filters[idx]->kf.id;
+    }
+
+    spin_unlock(&sinfo->cfg_lock);
+
+    DBG_VERB(("Created %d filters\n", cnt));
+
+    if (device_is_dnx(sinfo)) {
+        for (idx = 0; idx < cnt; idx++) {
+            bkn_filter_dnx_dump(sinfo, filters[idx]);
+        }
+    }
+    kfree(filters);
 
     return len;
 }
@@ -7990,9 +10872,6 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
 {
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
-    struct list_head *list;
-    unsigned long flags;
-    int found;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
 
@@ -8002,29 +10881,79 @@ bkn_knet_filter_destroy(kcom_msg_filter_destroy_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
-    found = 0;
-    list_for_each(list, &sinfo->rxpf_list) {
-        filter = (bkn_filter_t *)list;
-        if (kmsg->hdr.id == filter->kf.id) {
-            found = 1;
-            break;
-        }
+    filter = bkn_filter_find(sinfo, kmsg->hdr.id);
+    if (filter == NULL) {
+        spin_unlock(&sinfo->cfg_lock);
+        kmsg->hdr.status = KCOM_E_NOT_FOUND;
+        return sizeof(kcom_msg_hdr_t);
     }
 
-    if (!found) {
-        spin_unlock_irqrestore(&sinfo->lock, flags);
-        kmsg->hdr.status = KCOM_E_NOT_FOUND;
+    bkn_filter_unlink(sinfo, filter);
+
+    spin_unlock(&sinfo->cfg_lock);
+
+    /* Wait for Rx lookups which may still reference the filter */
+    synchronize_rcu();
+
+    bkn_filter_free(filter);
+
+    return sizeof(kcom_msg_hdr_t);
+}
+
+/*
+ * Destroy multiple filters under a single hold of the configuration
+ * lock, followed by a single RCU grace period. If any ID is unknown,
+ * no filter is destroyed. Duplicate IDs are ignored.
+ */
+static int
+bkn_knet_filter_destroy_bulk(kcom_msg_filter_destroy_bulk_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    bkn_filter_t *filter, *nfilter;
+    struct list_head unlinked;
+    int idx, cnt;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    cnt = kmsg->cnt;
+    if (sinfo == NULL || cnt <= 0 || cnt > KCOM_FILTER_MAX ||
+        len < (int)(sizeof(*kmsg) - sizeof(kmsg->id) +
+                    cnt * sizeof(kmsg->id[0]))) {
+        kmsg->hdr.status = KCOM_E_PARAM;
         return sizeof(kcom_msg_hdr_t);
     }
 
-    list_del(&filter->list);
+    INIT_LIST_HEAD(&unlinked);
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
-    DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
-    kfree(filter);
+    for (idx = 0; idx < cnt; idx++) {
+        if (bkn_filter_find(sinfo, kmsg->id[idx]) == NULL) {
+            spin_unlock(&sinfo->cfg_lock);
+            kmsg->hdr.status = KCOM_E_NOT_FOUND;
+            kmsg->hdr.id = idx;
+            return sizeof(kcom_msg_hdr_t);
+        }
+    }
+    for (idx = 0; idx < cnt; idx++) {
+        filter = bkn_filter_find(sinfo, kmsg->id[idx]);
+        if (filter != NULL) {
+            bkn_filter_unlink(sinfo, filter);
+            list_add_tail(&filter->list, &unlinked);
+        }
+    }
+
+    spin_unlock(&sinfo->cfg_lock);
+
+    /* Wait for Rx lookups which may still reference the filters */
+    synchronize_rcu();
+
+    list_for_each_entry_safe(filter, nfilter, &unlinked, list) {
+        bkn_filter_free(filter);
+    }
 
     return sizeof(kcom_msg_hdr_t);
 }
@@ -8035,7 +10964,6 @@ bkn_knet_filter_list(kcom_msg_filter_list_t *kmsg, int len)
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
     struct list_head *list;
-    unsigned long flags;
     int idx;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
@@ -8046,7 +10974,7 @@ bkn_knet_filter_list(kcom_msg_filter_list_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
     idx = 0;
     list_for_each(list, &sinfo->rxpf_list) {
@@ -8061,7 +10989,7 @@ bkn_knet_filter_list(kcom_msg_filter_list_t *kmsg, int len)
     }
     kmsg->fcnt = idx;
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_unlock(&sinfo->cfg_lock);
 
     return sizeof(*kmsg) - sizeof(kmsg->id) + (idx * sizeof(kmsg->id[0]));
 }
@@ -8072,7 +11000,6 @@ bkn_knet_filter_get(kcom_msg_filter_get_t *kmsg, int len)
     bkn_switch_info_t *sinfo;
     bkn_filter_t *filter;
     struct list_head *list;
-    unsigned long flags;
     int found;
 
     kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
@@ -8083,7 +11010,7 @@ bkn_knet_filter_get(kcom_msg_filter_get_t *kmsg, int len)
         return sizeof(kcom_msg_hdr_t);
     }
 
-    spin_lock_irqsave(&sinfo->lock, flags);
+    spin_lock(&sinfo->cfg_lock);
 
     found = 0;
     list_for_each(list, &sinfo->rxpf_list) {
@@ -8095,18 +11022,65 @@ bkn_knet_filter_get(kcom_msg_filter_get_t *kmsg, int len)
     }
 
     if (!found) {
-        spin_unlock_irqrestore(&sinfo->lock, flags);
+        spin_unlock(&sinfo->cfg_lock);
         kmsg->hdr.status = KCOM_E_NOT_FOUND;
         return sizeof(kcom_msg_hdr_t);
     }
 
     memcpy(&kmsg->filter, &filter->kf, sizeof(kmsg->filter));
 
-    spin_unlock_irqrestore(&sinfo->lock, flags);
+    spin_unlock(&sinfo->cfg_lock);
 
     return sizeof(*kmsg);
 }
 
+/*
+ * Return filters in ascending ID order starting from the ID in the
+ * message header.
+ */
+static int
+bkn_knet_filter_get_bulk(kcom_msg_filter_get_bulk_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    bkn_filter_t *filter;
+    int id, idx, max;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    if (sinfo == NULL) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    max = kmsg->cnt;
+    if (max == 0 || max > KCOM_FILTER_BULK_MAX) {
+        max = KCOM_FILTER_BULK_MAX;
+    }
+
+    spin_lock(&sinfo->cfg_lock);
+
+    idx = 0;
+    kmsg->more = 0;
+    for (id = kmsg->hdr.id; id < KCOM_FILTER_MAX; id++) {
+        filter = bkn_filter_find(sinfo, id);
+        if (filter == NULL) {
+            continue;
+        }
+        if (idx >= max) {
+            kmsg->more = 1;
+            break;
+        }
+        memcpy(&kmsg->filter[idx], &filter->kf, sizeof(kmsg->filter[0]));
+        idx++;
+    }
+    kmsg->cnt = idx;
+
+    spin_unlock(&sinfo->cfg_lock);
+
+    return sizeof(*kmsg) - sizeof(kmsg->filter) + (idx * sizeof(kmsg->filter[0]));
+}
+
 static int
 bkn_knet_dbg_pkt_set(kcom_msg_dbg_pkt_set_t *kmsg, int len)
 {
@@ -8161,6 +11135,133 @@ bkn_knet_wb_cleanup(kcom_msg_wb_cleanup_t *kmsg, int len)
     return sizeof(kcom_msg_hdr_t);
 }
 
+/*
+ * Destroy all netifs and filters of a unit, if the retained ones are
+ * not reclaimed by the restarted SDK.
+ */
+static void
+bkn_wb_discard(bkn_switch_info_t *sinfo)
+{
+    struct net_device *devs[16];
+    bkn_filter_t *filter, *nfilter;
+    struct list_head unlinked;
+    bkn_priv_t *priv;
+    int idx, cnt;
+
+    INIT_LIST_HEAD(&unlinked);
+
+    spin_lock(&sinfo->cfg_lock);
+    list_for_each_entry_safe(filter, nfilter, &sinfo->rxpf_list, list) {
+        bkn_filter_unlink(sinfo, filter);
+        list_add_tail(&filter->list, &unlinked);
+    }
+    spin_unlock(&sinfo->cfg_lock);
+
+    do {
+        cnt = 0;
+        spin_lock(&sinfo->cfg_lock);
+        while (cnt < ARRAY_SIZE(devs) && !list_empty(&sinfo->ndev_list)) {
+            priv = list_entry(sinfo->ndev_list.next, bkn_priv_t, list);
+            if (knet_netif_destroy_cb != NULL) {
+                kcom_netif_t netif;
+                memset(&netif, 0, sizeof(kcom_netif_t));
+                netif.id = priv->id;
+                knet_netif_destroy_cb(sinfo->dev_no, &netif, priv->dev);
+            }
+            list_del_rcu(&priv->list);
+            if (sinfo->ndev_table != NULL &&
+                priv->id < sinfo->ndev_table->ndev_max) {
+                RCU_INIT_POINTER(sinfo->ndev_table->ndevs[priv->id], NULL);
+            }
+            devs[cnt++] = priv->dev;
+        }
+        spin_unlock(&sinfo->cfg_lock);
+
+        /* Wait for Rx lookups which may still reference the objects */
+        synchronize_rcu();
+
+        list_for_each_entry_safe(filter, nfilter, &unlinked, list) {
+            list_del(&filter->list);
+            bkn_filter_free(filter);
+        }
+        for (idx = 0; idx < cnt; idx++) {
+            DBG_VERB(("Removing virtual Ethernet device %s.\n",
+                      devs[idx]->name));
+            unregister_netdev(devs[idx]);
+            free_netdev(devs[idx]);
+        }
+    } while (cnt == ARRAY_SIZE(devs));
+}
+
+static int
+bkn_knet_wb_reattach(kcom_msg_wb_reattach_t *kmsg, int len)
+{
+    bkn_switch_info_t *sinfo;
+    unsigned long flags;
+    int match;
+
+    kmsg->hdr.type = KCOM_MSG_TYPE_RSP;
+
+    sinfo = bkn_sinfo_from_unit(kmsg->hdr.unit);
+    if (sinfo == NULL) {
+        kmsg->hdr.status = KCOM_E_PARAM;
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    if (kmsg->flags & KCOM_WB_REATTACH_F_RETAIN) {
+        spin_lock_irqsave(&sinfo->lock, flags);
+        sinfo->wb_retained = 1;
+        bkn_dma_abort(sinfo);
+        bkn_clean_dcbs(sinfo);
+        bkn_hw_tstamp_tx_purge(sinfo);
+        if (++sinfo->wb_generation == 0) {
+            sinfo->wb_generation++;
+        }
+        kmsg->generation = sinfo->wb_generation;
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+        return sizeof(kcom_msg_wb_reattach_t);
+    }
+
+    if (kmsg->flags & KCOM_WB_REATTACH_F_RECLAIM) {
+        spin_lock_irqsave(&sinfo->lock, flags);
+        match = sinfo->wb_retained &&
+                kmsg->generation == sinfo->wb_generation;
+        sinfo->wb_retained = 0;
+        spin_unlock_irqrestore(&sinfo->lock, flags);
+        if (!match) {
+            DBG_WARN(("Unit %d: discarding retained netifs and filters\n",
+                      sinfo->dev_no));
+            bkn_wb_discard(sinfo);
+            kmsg->hdr.status = KCOM_E_NOT_FOUND;
+        }
+        return sizeof(kcom_msg_hdr_t);
+    }
+
+    kmsg->hdr.status = KCOM_E_PARAM;
+    return sizeof(kcom_msg_hdr_t);
+}
+
+/* Bulk messages require a kcom_msg_bulk_t buffer */
+static int
+bkn_kcom_msg_is_bulk(kcom_msg_hdr_t *hdr)
+{
+    switch (hdr->opcode) {
+    case KCOM_M_NETIF_CREATE_BULK:
+    case KCOM_M_NETIF_GET_BULK:
+    case KCOM_M_FILTER_CREATE_BULK:
+    case KCOM_M_FILTER_DESTROY_BULK:
+    case KCOM_M_FILTER_GET_BULK:
+        return 1;
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*
+ * The message buffer must be a kcom_msg_bulk_t if the opcode is a
+ * bulk opcode.
+ */
 static int
 bkn_handle_cmd_req(kcom_msg_t *kmsg, int len)
 {
@@ -8226,6 +11327,16 @@ bkn_handle_cmd_req(kcom_msg_t *kmsg, int len)
         /* Return network interface info */
         len = bkn_knet_netif_get(&kmsg->netif_get, len);
         break;
+    case KCOM_M_NETIF_CREATE_BULK:
+        DBG_CMD(("KCOM_M_NETIF_CREATE_BULK\n"));
+        /* Create multiple network interfaces */
+        len = bkn_knet_netif_create_bulk(&((kcom_msg_bulk_t *)kmsg)->netif_create_bulk, len);
+        break;
+    case KCOM_M_NETIF_GET_BULK:
+        DBG_CMD(("KCOM_M_NETIF_GET_BULK\n"));
+        /* Return info of multiple network interfaces */
+        len = bkn_knet_netif_get_bulk(&((kcom_msg_bulk_t *)kmsg)->netif_get_bulk, len);
+        break;
     case KCOM_M_FILTER_CREATE:
         DBG_CMD(("KCOM_M_FILTER_CREATE\n"));
         /* Create packet filter */
@@ -8246,6 +11357,26 @@ bkn_handle_cmd_req(kcom_msg_t *kmsg, int len)
         /* Return packet filter info */
         len = bkn_knet_filter_get(&kmsg->filter_get, len);
         break;
+    case KCOM_M_FILTER_CREATE_BULK:
+        DBG_CMD(("KCOM_M_FILTER_CREATE_BULK\n"));
+        /* Create multiple packet filters */
+        len = bkn_knet_filter_create_bulk(&((kcom_msg_bulk_t *)kmsg)->filter_create_bulk, len);
+        break;
+    case KCOM_M_FILTER_DESTROY_BULK:
+        DBG_CMD(("KCOM_M_FILTER_DESTROY_BULK\n"));
+        /* Destroy multiple packet filters */
+        len = bkn_knet_filter_destroy_bulk(&((kcom_msg_bulk_t *)kmsg)->filter_destroy_bulk, len);
+        break;
+    case KCOM_M_FILTER_GET_BULK:
+        DBG_CMD(("KCOM_M_FILTER_GET_BULK\n"));
+        /* Return info of multiple packet filters */
+        len = bkn_knet_filter_get_bulk(&((kcom_msg_bulk_t *)kmsg)->filter_get_bulk, len);
+        break;
+    case KCOM_M_DMA_RING:
+        DBG_CMD(("KCOM_M_DMA_RING\n"));
+        /* Set up shared Rx completion ring */
+        len = bkn_knet_dma_ring(&kmsg->dma_ring, len);
+        break;
     case KCOM_M_DBGPKT_SET:
         DBG_CMD(("KCOM_M_DBGPKT_SET\n"));
         /* Set debugging packet function */
@@ -8261,6 +11392,11 @@ bkn_handle_cmd_req(kcom_msg_t *kmsg, int len)
         /* Clean up for warmbooting */
         len = bkn_knet_wb_cleanup(&kmsg->wb_cleanup, len);
         break;
+    case KCOM_M_WB_REATTACH:
+        DBG_CMD(("KCOM_M_WB_REATTACH\n"));
+        /* Retain or reclaim netifs and filters across SDK restart */
+        len = bkn_knet_wb_reattach(&kmsg->wb_reattach, len);
+        break;
     default:
         DBG_WARN(("Unsupported command (type=%d, opcode=%d)\n",
                   kmsg->hdr.type, kmsg->hdr.opcode));
@@ -8275,7 +11411,8 @@ static int
 bkn_cmd_thread(void *context)
 {
     bkn_thread_ctrl_t *tc = (bkn_thread_ctrl_t *)context;
-    kcom_msg_t kmsg;
+    /* Only one command thread, so avoid a large stack buffer */
+    static kcom_msg_bulk_t kmsg;
     unsigned int len, rlen;
 
     bkn_thread_boot(tc);
@@ -8288,7 +11425,7 @@ bkn_cmd_thread(void *context)
         if (PROXY_RECV(KCOM_CHAN_KNET, &kmsg, &len) >= 0) {
             DBG_VERB(("Received %d bytes from KCOM_CHAN_CMD\n", len));
             tc->state = 3;
-            rlen = bkn_handle_cmd_req(&kmsg, len);
+            rlen = bkn_handle_cmd_req(&kmsg.msg, len);
             tc->state = 4;
             if (rlen > 0) {
                 PROXY_SEND(KCOM_CHAN_KNET, &kmsg, rlen);
@@ -8304,6 +11441,297 @@ bkn_cmd_thread(void *context)
     return 0;
 }
 
+#ifdef BKN_GENL_SUPPORT
+/*
+ * Generic netlink control channel (see bcm-knet.h).
+ *
+ * A batch of KCOM messages is handled with one request, which saves a
+ * user/kernel round trip per netif or filter, e.g. when thousands of
+ * filters are replayed at warm boot. The messages go through
+ * bkn_handle_cmd_req like the ones of the proxy and IOCTL paths.
+ */
+#define BKN_GENL_REPLY_SIZE     max_t(size_t, NLMSG_DEFAULT_SIZE, \
+                                      nla_total_size(sizeof(kcom_msg_bulk_t)))
+
+static struct genl_family bkn_genl_family;
+static int bkn_genl_registered;
+
+static const struct nla_policy bkn_genl_policy[BKN_GENL_A_MAX + 1] = {
+    [BKN_GENL_A_MSG] = { .type = NLA_BINARY, .len = sizeof(kcom_msg_bulk_t) },
+};
+
+static struct sk_buff *
+bkn_genl_reply_new(struct genl_info *info, void **hdr)
+{
+    struct sk_buff *skb;
+
+    skb = genlmsg_new(BKN_GENL_REPLY_SIZE, GFP_KERNEL);
+    if (skb == NULL) {
+        return NULL;
+    }
+    *hdr = genlmsg_put(skb, info->snd_portid, info->snd_seq,
+                       &bkn_genl_family, NLM_F_MULTI, BKN_GENL_CMD_KCOM);
+    if (*hdr == NULL) {
+        nlmsg_free(skb);
+        return NULL;
+    }
+    return skb;
+}
+
+/*
+ * The replies are sent as a NLM_F_MULTI sequence terminated by
+ * NLMSG_DONE, with as many KCOM replies per part as fit.
+ */
+static int
+bkn_genl_kcom(struct sk_buff *skb, struct genl_info *info)
+{
+    struct nlattr *attr;
+    struct sk_buff *rskb = NULL;
+    struct nlmsghdr *nlh;
+    kcom_msg_hdr_t *hdr;
+    kcom_msg_bulk_t *bmsg;
+    void *rhdr = NULL;
+    int rem, len;
+    int rv = 0;
+
+    if (!module_initialized) {
+        return -ENODEV;
+    }
+
+    /* Check the whole batch before handling any message */
+    nla_for_each_attr(attr, genlmsg_data(info->genlhdr),
+                      genlmsg_len(info->genlhdr), rem) {
+        if (nla_type(attr) != BKN_GENL_A_MSG) {
+            continue;
+        }
+        if (nla_len(attr) < sizeof(kcom_msg_hdr_t) ||
+            nla_len(attr) > sizeof(kcom_msg_bulk_t)) {
+            return -EINVAL;
+        }
+        hdr = nla_data(attr);
+        if (hdr->type != KCOM_MSG_TYPE_CMD) {
+            return -EINVAL;
+        }
+    }
+
+    bmsg = kmalloc(sizeof(*bmsg), GFP_KERNEL);
+    if (bmsg == NULL) {
+        return -ENOMEM;
+    }
+
+    genl_cmd++;
+    nla_for_each_attr(attr, genlmsg_data(info->genlhdr),
+                      genlmsg_len(info->genlhdr), rem) {
+        if (nla_type(attr) != BKN_GENL_A_MSG) {
+            continue;
+        }
+        len = nla_len(attr);
+        memcpy(bmsg, nla_data(attr), len);
+        len = bkn_handle_cmd_req(&bmsg->msg, len);
+
+        if (rskb && nla_put(rskb, BKN_GENL_A_MSG, len, bmsg) < 0) {
+            /* Reply part is full */
+            genlmsg_end(rskb, rhdr);
+            rv = genlmsg_unicast(genl_info_net(info), rskb, info->snd_portid);
+            rskb = NULL;
+            if (rv < 0) {
+                break;
+            }
+        }
+        if (rskb == NULL) {
+            rskb = bkn_genl_reply_new(info, &rhdr);
+            if (rskb == NULL) {
+                rv = -ENOMEM;
+                break;
+            }
+            if (nla_put(rskb, BKN_GENL_A_MSG, len, bmsg) < 0) {
+                nlmsg_free(rskb);
+                rskb = NULL;
+                rv = -EMSGSIZE;
+                break;
+            }
+        }
+    }
+    genl_cmd--;
+    kfree(bmsg);
+
+    if (rskb) {
+        genlmsg_end(rskb, rhdr);
+        if (rv < 0) {
+            nlmsg_free(rskb);
+        } else {
+            rv = genlmsg_unicast(genl_info_net(info), rskb, info->snd_portid);
+        }
+    }
+    if (rv < 0) {
+        return rv;
+    }
+
+    rskb = nlmsg_new(0, GFP_KERNEL);
+    if (rskb == NULL) {
+        return -ENOMEM;
+    }
+    nlh = nlmsg_put(rskb, info->snd_portid, info->snd_seq,
+                    NLMSG_DONE, 0, NLM_F_MULTI);
+    if (nlh == NULL) {
+        nlmsg_free(rskb);
+        return -EMSGSIZE;
+    }
+    nlmsg_end(rskb, nlh);
+    return genlmsg_unicast(genl_info_net(info), rskb, info->snd_portid);
+}
+
+/*
+ * Send a netif event to the events group.
+ * May be called with sinfo->cfg_lock held.
+ */
+static void
+bkn_genl_netif_event(bkn_priv_t *priv, int cmd)
+{
+    struct net_device_stats *stats = &priv->stats;
+    struct sk_buff *skb;
+    void *hdr;
+
+    if (!bkn_genl_registered ||
+        !genl_has_listeners(&bkn_genl_family, &init_net, 0)) {
+        return;
+    }
+
+    skb = genlmsg_new(NLMSG_GOODSIZE, GFP_ATOMIC);
+    if (skb == NULL) {
+        return;
+    }
+    hdr = genlmsg_put(skb, 0, 0, &bkn_genl_family, 0, cmd);
+    if (hdr == NULL) {
+        goto fail;
+    }
+    if (nla_put_u32(skb, BKN_GENL_A_UNIT, priv->sinfo->dev_no) ||
+        nla_put_u32(skb, BKN_GENL_A_NETIF_ID, priv->id) ||
+        nla_put_u32(skb, BKN_GENL_A_PORT, priv->port) ||
+        nla_put_u32(skb, BKN_GENL_A_IFINDEX, priv->dev->ifindex) ||
+        nla_put_string(skb, BKN_GENL_A_IFNAME, priv->dev->name)) {
+        goto fail;
+    }
+    if (cmd == BKN_GENL_CMD_LINK_EVENT) {
+        if (nla_put_u8(skb, BKN_GENL_A_LINK, netif_carrier_ok(priv->dev))) {
+            goto fail;
+        }
+    } else {
+        if (nla_put_u64_64bit(skb, BKN_GENL_A_RX_PACKETS,
+                              stats->rx_packets, BKN_GENL_A_PAD) ||
+            nla_put_u64_64bit(skb, BKN_GENL_A_RX_BYTES,
+                              stats->rx_bytes, BKN_GENL_A_PAD) ||
+            nla_put_u64_64bit(skb, BKN_GENL_A_RX_DROPPED,
+                              stats->rx_dropped, BKN_GENL_A_PAD) ||
+            nla_put_u64_64bit(skb, BKN_GENL_A_TX_PACKETS,
+                              stats->tx_packets, BKN_GENL_A_PAD) ||
+            nla_put_u64_64bit(skb, BKN_GENL_A_TX_BYTES,
+                              stats->tx_bytes, BKN_GENL_A_PAD) ||
+            nla_put_u64_64bit(skb, BKN_GENL_A_TX_DROPPED,
+                              stats->tx_dropped, BKN_GENL_A_PAD)) {
+            goto fail;
+        }
+    }
+    genlmsg_end(skb, hdr);
+    genlmsg_multicast(&bkn_genl_family, skb, 0, 0, GFP_ATOMIC);
+    return;
+
+fail:
+    nlmsg_free(skb);
+}
+
+static void
+bkn_genl_link_notify(bkn_priv_t *priv)
+{
+    bkn_genl_netif_event(priv, BKN_GENL_CMD_LINK_EVENT);
+}
+
+static void bkn_genl_stats_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(bkn_genl_stats_dwork, bkn_genl_stats_work);
+
+static void
+bkn_genl_stats_work(struct work_struct *work)
+{
+    struct list_head *slist, *dlist;
+    bkn_switch_info_t *sinfo;
+    bkn_priv_t *priv;
+
+    if (genl_has_listeners(&bkn_genl_family, &init_net, 0)) {
+        list_for_each(slist, &_sinfo_list) {
+            sinfo = (bkn_switch_info_t *)slist;
+            spin_lock(&sinfo->cfg_lock);
+            list_for_each(dlist, &sinfo->ndev_list) {
+                priv = (bkn_priv_t *)dlist;
+                if (priv->dev) {
+                    bkn_genl_netif_event(priv, BKN_GENL_CMD_STATS_EVENT);
+                }
+            }
+            spin_unlock(&sinfo->cfg_lock);
+        }
+    }
+    schedule_delayed_work(&bkn_genl_stats_dwork,
+                          msecs_to_jiffies(genl_stats_interval));
+}
+
+static const struct genl_ops bkn_genl_ops[] = {
+    {
+        .cmd = BKN_GENL_CMD_KCOM,
+#if (LINUX_VERSION_CODE < KERNEL_VERSION(5,2,0))
+        .policy = bkn_genl_policy,
+#endif
+        .doit = bkn_genl_kcom,
+        .flags = GENL_ADMIN_PERM,
+    },
+};
+
+static const struct genl_multicast_group bkn_genl_mcgrps[] = {
+    { .name = BKN_GENL_MCGRP_EVENTS, },
+};
+
+static struct genl_family bkn_genl_family = {
+    .name = BKN_GENL_FAMILY_NAME,
+    .version = BKN_GENL_VERSION,
+    .maxattr = BKN_GENL_A_MAX,
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(5,2,0))
+    .policy = bkn_genl_policy,
+#endif
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6,1,0))
+    .resv_start_op = __BKN_GENL_CMD_MAX,
+#endif
+    .module = THIS_MODULE,
+    .ops = bkn_genl_ops,
+    .n_ops = ARRAY_SIZE(bkn_genl_ops),
+    .mcgrps = bkn_genl_mcgrps,
+    .n_mcgrps = ARRAY_SIZE(bkn_genl_mcgrps),
+};
+
+static void
+bkn_genl_init(void)
+{
+    if (genl_register_family(&bkn_genl_family) < 0) {
+        gprintk("Warning: generic netlink family %s not registered\n",
+                BKN_GENL_FAMILY_NAME);
+        return;
+    }
+    bkn_genl_registered = 1;
+    if (genl_stats_interval > 0) {
+        schedule_delayed_work(&bkn_genl_stats_dwork,
+                              msecs_to_jiffies(genl_stats_interval));
+    }
+}
+
+static void
+bkn_genl_cleanup(void)
+{
+    if (!bkn_genl_registered) {
+        return;
+    }
+    cancel_delayed_work_sync(&bkn_genl_stats_dwork);
+    bkn_genl_registered = 0;
+    genl_unregister_family(&bkn_genl_family);
+}
+#endif /* BKN_GENL_SUPPORT */
+
 static int
 bkn_get_next_dma_event(kcom_msg_dma_info_t *kmsg)
 {
@@ -8415,6 +11843,7 @@ _cleanup(void)
     struct list_head *list;
     struct net_device *dev;
     bkn_filter_t *filter;
+    bkn_fgroup_t *fg;
     bkn_priv_t *priv;
     bkn_switch_info_t *sinfo;
     unsigned long flags;
@@ -8422,6 +11851,10 @@ _cleanup(void)
     /* Inidicate that we are shutting down */
     module_initialized = 0;
 
+#ifdef BKN_GENL_SUPPORT
+    bkn_genl_cleanup();
+#endif
+
     /* Shut down event thread */
     bkn_thread_stop(&bkn_evt_ctrl);
 
@@ -8439,7 +11872,12 @@ _cleanup(void)
         sinfo = (bkn_switch_info_t *)list;
 
         del_timer_sync(&sinfo->timer);
+#ifdef BKN_RX_HRTIMER
+        hrtimer_cancel(&sinfo->rxtick);
+        hrtimer_cancel(&sinfo->coal_timer);
+#else
         del_timer_sync(&sinfo->rxtick);
+#endif
 
         spin_lock_irqsave(&sinfo->lock, flags);
         bkn_dma_abort(sinfo);
@@ -8447,6 +11885,10 @@ _cleanup(void)
         spin_unlock_irqrestore(&sinfo->lock, flags);
 
         DBG_IRQ(("Unregister ISR.\n"));
+        if (sinfo->msix_vec) {
+            lkbde_irq_vector_disconnect(sinfo->dev_no, sinfo->msix_vec);
+            sinfo->msix_vec = 0;
+        }
         kernel_bde->interrupt_disconnect(sinfo->dev_no | LKBDE_ISR2_DEV);
 
         if (use_napi) {
@@ -8457,8 +11899,11 @@ _cleanup(void)
 
         spin_lock_irqsave(&sinfo->lock, flags);
         bkn_clean_dcbs(sinfo);
-        skb_queue_purge(&sinfo->tx_ptp_queue);
+        bkn_hw_tstamp_tx_purge(sinfo);
         spin_unlock_irqrestore(&sinfo->lock, flags);
+#ifdef BKN_RX_HRTIMER
+        hrtimer_cancel(&sinfo->tx_ts.timer);
+#endif
     }
 
     /* Destroy all switch devices */
@@ -8468,9 +11913,13 @@ _cleanup(void)
         /* Destroy all associated Rx packet filters */
         while (!list_empty(&sinfo->rxpf_list)) {
             filter = list_entry(sinfo->rxpf_list.next, bkn_filter_t, list);
+            fg = bkn_fgroup_del(sinfo, filter);
             list_del(&filter->list);
             DBG_VERB(("Removing filter ID %d.\n", filter->kf.id));
             kfree(filter);
+            if (fg != NULL) {
+                kfree(fg);
+            }
         }
 
         /* Destroy all associated virtual net devices */
@@ -8482,8 +11931,8 @@ _cleanup(void)
             unregister_netdev(dev);
             free_netdev(dev);
         }
-        if (sinfo->ndevs != NULL) {
-            kfree(sinfo->ndevs);
+        if (sinfo->ndev_table != NULL) {
+            kfree(sinfo->ndev_table);
         }
 
         /* Destroy base net device */
@@ -8640,6 +12089,22 @@ _init(void)
         }
     }
 
+    /* Keep DMA ring sizes within supported range */
+    if (tx_dcbs < MIN_DCBS || tx_dcbs > MAX_DCBS) {
+        gprintk("Warning: tx_dcbs must be in range %d-%d, using 64\n",
+                MIN_DCBS, MAX_DCBS);
+        tx_dcbs = 64;
+    }
+    if (rx_dcbs < MIN_DCBS || rx_dcbs > MAX_DCBS) {
+        gprintk("Warning: rx_dcbs must be in range %d-%d, using 64\n",
+                MIN_DCBS, MAX_DCBS);
+        rx_dcbs = 64;
+    }
+    if (api_rx_ring < 0 || (api_rx_ring & (api_rx_ring - 1)) != 0) {
+        gprintk("Warning: api_rx_ring must be a power of two, using 1024\n");
+        api_rx_ring = 1024;
+    }
+
     /* NAPI implies that base device must be up before we can pass traffic */
     if (use_napi) {
         basedev_suspend = 1;
@@ -8676,6 +12141,10 @@ _init(void)
         bkn_thread_start(&bkn_evt_ctrl, "bknevt", bkn_evt_thread);
     }
 
+#ifdef BKN_GENL_SUPPORT
+    bkn_genl_init();
+#endif
+
     module_initialized = 1;
 
     return 0;
@@ -8686,6 +12155,9 @@ _ioctl(unsigned int cmd, unsigned long arg)
 {
     bkn_ioctl_t io;
     kcom_msg_t kmsg;
+    kcom_msg_bulk_t *bmsg = NULL;
+    kcom_msg_t *cmsg = &kmsg;
+    int rv = 0;
 
     if (!module_initialized) {
         return -EFAULT;
@@ -8695,7 +12167,7 @@ _ioctl(unsigned int cmd, unsigned long arg)
         return -EFAULT;
     }
 
-    if (io.len > sizeof(kmsg)) {
+    if (io.len > sizeof(kcom_msg_bulk_t)) {
         return -EINVAL;
     }
 
@@ -8704,11 +12176,23 @@ _ioctl(unsigned int cmd, unsigned long arg)
     switch(cmd) {
     case 0:
         if (io.len > 0) {
-            if (copy_from_user(&kmsg, (void *)(unsigned long)io.buf, io.len)) {
+            if (copy_from_user(&kmsg.hdr, (void *)(unsigned long)io.buf,
+                               min_t(unsigned int, io.len, sizeof(kmsg.hdr)))) {
+                return -EFAULT;
+            }
+            if (io.len > sizeof(kmsg) || bkn_kcom_msg_is_bulk(&kmsg.hdr)) {
+                bmsg = kmalloc(sizeof(*bmsg), GFP_KERNEL);
+                if (bmsg == NULL) {
+                    return -ENOMEM;
+                }
+                cmsg = &bmsg->msg;
+            }
+            if (copy_from_user(cmsg, (void *)(unsigned long)io.buf, io.len)) {
+                kfree(bmsg);
                 return -EFAULT;
             }
             ioctl_cmd++;
-            io.len = bkn_handle_cmd_req(&kmsg, io.len);
+            io.len = bkn_handle_cmd_req(cmsg, io.len);
             ioctl_cmd--;
         } else {
             memset(&kmsg, 0, sizeof(kcom_msg_dma_info_t));
@@ -8726,10 +12210,11 @@ _ioctl(unsigned int cmd, unsigned long arg)
             ioctl_evt--;
         }
         if (io.len > 0) {
-            if (copy_to_user((void *)(unsigned long)io.buf, &kmsg, io.len)) {
-                return -EFAULT;
+            if (copy_to_user((void *)(unsigned long)io.buf, cmsg, io.len)) {
+                rv = -EFAULT;
             }
         }
+        kfree(bmsg);
         break;
     default:
         gprintk("Invalid IOCTL");
@@ -8737,11 +12222,34 @@ _ioctl(unsigned int cmd, unsigned long arg)
         break;
     }
 
-    if (copy_to_user((void*)arg, &io, sizeof(io))) {
+    if (rv == 0 && copy_to_user((void*)arg, &io, sizeof(io))) {
+        rv = -EFAULT;
+    }
+
+    return rv;
+}
+
+/*
+ * Map the shared Rx completion ring of the unit given as page offset.
+ */
+static int
+_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+    bkn_switch_info_t *sinfo;
+
+    if (!module_initialized) {
         return -EFAULT;
     }
 
-    return 0;
+    sinfo = bkn_sinfo_from_unit(vma->vm_pgoff);
+    if (sinfo == NULL || sinfo->api_ring.hdr == NULL) {
+        return -ENODEV;
+    }
+    if (vma->vm_end - vma->vm_start > sinfo->api_ring.map_size) {
+        return -EINVAL;
+    }
+
+    return remap_vmalloc_range(vma, sinfo->api_ring.hdr, 0);
 }
 
 static gmodule_t _gmodule = {
@@ -8753,6 +12261,7 @@ static gmodule_t _gmodule = {
     ioctl: _ioctl,
     open: NULL,
     close: NULL,
+    mmap: _mmap,
 };
 
 gmodule_t *
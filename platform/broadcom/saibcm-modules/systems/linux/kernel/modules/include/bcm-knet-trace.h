@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017 Broadcom
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License, version 2, as
+ * published by the Free Software Foundation (the "GPL").
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 (GPLv2) for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 (GPLv2) along with this source code.
+ */
+/*
+ * Static tracepoints for the KNET datapath.
+ *
+ * The events show up under /sys/kernel/debug/tracing/events/bcm_knet
+ * and can be used from perf and eBPF. A disabled tracepoint costs a
+ * single static branch.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM bcm_knet
+
+#if !defined(__BCM_KNET_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __BCM_KNET_TRACE_H__
+
+#include <linux/tracepoint.h>
+#include <linux/netdevice.h>
+#include <linux/skbuff.h>
+
+/* Rx DCB completed by the DMA engine */
+TRACE_EVENT(bkn_rx_dcb_done,
+    TP_PROTO(int unit, int chan, int dcb_idx, uint32_t dcb_stat),
+    TP_ARGS(unit, chan, dcb_idx, dcb_stat),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(int, chan)
+        __field(int, dcb_idx)
+        __field(uint32_t, dcb_stat)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->chan = chan;
+        __entry->dcb_idx = dcb_idx;
+        __entry->dcb_stat = dcb_stat;
+    ),
+    TP_printk("unit=%d chan=%d dcb=%d stat=0x%08x",
+              __entry->unit, __entry->chan, __entry->dcb_idx,
+              __entry->dcb_stat)
+);
+
+/* Rx packet matched a filter */
+TRACE_EVENT(bkn_rx_filter_match,
+    TP_PROTO(int unit, int chan, int filter_id, int dest_type, int dest_id),
+    TP_ARGS(unit, chan, filter_id, dest_type, dest_id),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(int, chan)
+        __field(int, filter_id)
+        __field(int, dest_type)
+        __field(int, dest_id)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->chan = chan;
+        __entry->filter_id = filter_id;
+        __entry->dest_type = dest_type;
+        __entry->dest_id = dest_id;
+    ),
+    TP_printk("unit=%d chan=%d filter=%d dest_type=%d dest_id=%d",
+              __entry->unit, __entry->chan, __entry->filter_id,
+              __entry->dest_type, __entry->dest_id)
+);
+
+/* Rx skb passed to the network stack */
+TRACE_EVENT(bkn_rx_deliver,
+    TP_PROTO(int unit, struct sk_buff *skb),
+    TP_ARGS(unit, skb),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(const void *, skbaddr)
+        __field(unsigned int, len)
+        __string(name, skb->dev->name)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->skbaddr = skb;
+        __entry->len = skb->len;
+        __assign_str(name, skb->dev->name);
+    ),
+    TP_printk("unit=%d dev=%s skbaddr=%p len=%u",
+              __entry->unit, __get_str(name), __entry->skbaddr,
+              __entry->len)
+);
+
+/* Tx packet added to the DCB ring */
+TRACE_EVENT(bkn_tx_enqueue,
+    TP_PROTO(int unit, struct net_device *dev, struct sk_buff *skb,
+             int dcb_idx, int ndcbs),
+    TP_ARGS(unit, dev, skb, dcb_idx, ndcbs),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(const void *, skbaddr)
+        __field(unsigned int, len)
+        __field(int, dcb_idx)
+        __field(int, ndcbs)
+        __string(name, dev->name)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->skbaddr = skb;
+        __entry->len = skb->len;
+        __entry->dcb_idx = dcb_idx;
+        __entry->ndcbs = ndcbs;
+        __assign_str(name, dev->name);
+    ),
+    TP_printk("unit=%d dev=%s skbaddr=%p len=%u dcb=%d ndcbs=%d",
+              __entry->unit, __get_str(name), __entry->skbaddr,
+              __entry->len, __entry->dcb_idx, __entry->ndcbs)
+);
+
+/* Tx DCB carrying an skb completed by the DMA engine */
+TRACE_EVENT(bkn_tx_done,
+    TP_PROTO(int unit, struct sk_buff *skb, int dcb_idx),
+    TP_ARGS(unit, skb, dcb_idx),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(const void *, skbaddr)
+        __field(int, dcb_idx)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->skbaddr = skb;
+        __entry->dcb_idx = dcb_idx;
+    ),
+    TP_printk("unit=%d skbaddr=%p dcb=%d",
+              __entry->unit, __entry->skbaddr, __entry->dcb_idx)
+);
+
+/* Rx DMA held back by the token bucket */
+TRACE_EVENT(bkn_rx_rate_pause,
+    TP_PROTO(int unit, int chan, uint32_t tokens),
+    TP_ARGS(unit, chan, tokens),
+    TP_STRUCT__entry(
+        __field(int, unit)
+        __field(int, chan)
+        __field(uint32_t, tokens)
+    ),
+    TP_fast_assign(
+        __entry->unit = unit;
+        __entry->chan = chan;
+        __entry->tokens = tokens;
+    ),
+    TP_printk("unit=%d chan=%d tokens=%u",
+              __entry->unit, __entry->chan, __entry->tokens)
+);
+
+#endif /* __BCM_KNET_TRACE_H__ */
+
+/* Found via the module include path */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE bcm-knet-trace
+#include <trace/define_trace.h>
@@ -33,6 +33,53 @@ typedef struct  {
     uint64_t buf;
 } bkn_ioctl_t;
 
+/*
+ * Generic netlink control channel.
+ *
+ * BKN_GENL_CMD_KCOM carries one or more BKN_GENL_A_MSG attributes,
+ * each holding a KCOM command message (kcom_msg_t, or kcom_msg_bulk_t
+ * for the bulk opcodes). The messages are handled in order and the
+ * replies hold one BKN_GENL_A_MSG attribute per message with its KCOM
+ * reply, in order. They are sent as a NLM_F_MULTI sequence of
+ * BKN_GENL_CMD_KCOM messages terminated by NLMSG_DONE.
+ *
+ * The "events" multicast group gets BKN_GENL_CMD_LINK_EVENT on netif
+ * link changes and, if enabled, periodic BKN_GENL_CMD_STATS_EVENT per
+ * netif.
+ */
+#define BKN_GENL_FAMILY_NAME            "bcm_knet"
+#define BKN_GENL_VERSION                1
+#define BKN_GENL_MCGRP_EVENTS           "events"
+
+enum {
+    BKN_GENL_CMD_UNSPEC,
+    BKN_GENL_CMD_KCOM,
+    BKN_GENL_CMD_LINK_EVENT,
+    BKN_GENL_CMD_STATS_EVENT,
+    __BKN_GENL_CMD_MAX
+};
+#define BKN_GENL_CMD_MAX                (__BKN_GENL_CMD_MAX - 1)
+
+enum {
+    BKN_GENL_A_UNSPEC,
+    BKN_GENL_A_PAD,
+    BKN_GENL_A_MSG,             /* binary, KCOM message */
+    BKN_GENL_A_UNIT,            /* u32 */
+    BKN_GENL_A_NETIF_ID,        /* u32 */
+    BKN_GENL_A_PORT,            /* u32 */
+    BKN_GENL_A_IFINDEX,         /* u32 */
+    BKN_GENL_A_IFNAME,          /* string */
+    BKN_GENL_A_LINK,            /* u8, 1 if up */
+    BKN_GENL_A_RX_PACKETS,      /* u64 */
+    BKN_GENL_A_RX_BYTES,        /* u64 */
+    BKN_GENL_A_RX_DROPPED,      /* u64 */
+    BKN_GENL_A_TX_PACKETS,      /* u64 */
+    BKN_GENL_A_TX_BYTES,        /* u64 */
+    BKN_GENL_A_TX_DROPPED,      /* u64 */
+    __BKN_GENL_A_MAX
+};
+#define BKN_GENL_A_MAX                  (__BKN_GENL_A_MAX - 1)
+
 #ifdef __KERNEL__
 
 /*
@@ -5,13 +5,15 @@
 #include <uapi/linux/psample.h>
 #include <linux/module.h>
 #include <linux/list.h>
+#include <linux/rcupdate.h>
 
 struct psample_group {
-	struct list_head list;
+	struct hlist_node node;
 	struct net *net;
 	u32 group_num;
-	u32 refcount;
+	atomic_t refcount;
 	u32 seq;
+	struct rcu_head rcu;
 };
 
 extern struct psample_group *psample_group_get(struct net *net, u32 group_num);
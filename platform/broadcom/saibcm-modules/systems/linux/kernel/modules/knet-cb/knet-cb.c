@@ -59,6 +59,19 @@ LKM_MOD_PARAM(debug, "i", int, 0);
 MODULE_PARM_DESC(debug,
 "Debug level (default 0)");
 
+static int rx_vlan_hwaccel = 0;
+LKM_MOD_PARAM(rx_vlan_hwaccel, "i", int, 0);
+MODULE_PARM_DESC(rx_vlan_hwaccel,
+"Keep the stripped VLAN tag in the skb VLAN metadata (default 0)");
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3,10,0)
+#define knet_cb_vlan_hwaccel_put_tag(_skb, _proto, _tci) \
+    __vlan_hwaccel_put_tag(_skb, _tci)
+#else
+#define knet_cb_vlan_hwaccel_put_tag(_skb, _proto, _tci) \
+    __vlan_hwaccel_put_tag(_skb, htons(_proto), _tci)
+#endif
+
 /* Module Information */
 #define MODULE_MAJOR 121
 #define MODULE_NAME "linux-knet-cb"
@@ -74,6 +87,7 @@ MODULE_PARM_DESC(debug,
 /* Maintain tag strip statistics */
 struct strip_stats_s {
     unsigned long stripped;     /* Number of packets that have been stripped */
+    unsigned long hwaccel;      /* Stripped tags kept in the skb VLAN metadata */
     unsigned long checked;
     unsigned long skipped;
 };
@@ -91,17 +105,27 @@ static int  _pprint(void);
 static int  _cleanup(void);
 static int  _init(void);
 
-/* Remove VLAN tag for select TPIDs */
+/*
+ * Remove VLAN tag for select TPIDs. The MAC addresses are moved over the
+ * tag with one memmove, the payload stays in place. With rx_vlan_hwaccel
+ * the tag is kept in the skb VLAN metadata, as a NIC with VLAN stripping
+ * offload would do, so that the stack and packet sockets still see it.
+ */
 static void
 strip_vlan_tag(struct sk_buff *skb)
 {
     uint16_t    vlan_proto = (uint16_t) ((skb->data[12] << 8) | skb->data[13]);
+    uint16_t    tci;
+
     if ((vlan_proto == 0x8100) || (vlan_proto == 0x88a8) || (vlan_proto == 0x9100)) {
+        tci = (uint16_t) ((skb->data[14] << 8) | skb->data[15]);
         /* Move first 12 bytes of packet back by 4 */
-        ((u32 *) skb->data)[3] = ((u32 *) skb->data)[2];
-        ((u32 *) skb->data)[2] = ((u32 *) skb->data)[1];
-        ((u32 *) skb->data)[1] = ((u32 *) skb->data)[0];
-        skb_pull(skb, 4);       /* Remove 4 bytes from start of buffer */
+        memmove(skb->data + VLAN_HLEN, skb->data, 2 * ETH_ALEN);
+        __skb_pull(skb, VLAN_HLEN);     /* Remove 4 bytes from start of buffer */
+        if (rx_vlan_hwaccel) {
+            knet_cb_vlan_hwaccel_put_tag(skb, vlan_proto, tci);
+            strip_stats.hwaccel++;
+        }
     }
 }
 
@@ -133,7 +157,7 @@ get_tag_status(int dcb_type, void *meta)
         case 21:
         case 22:
         case 30:
-            tag_status = (dcb[12] > 10) & 0x3;
+            tag_status = (dcb[12] >> 10) & 0x3;
             break;
         case 23:
         case 29:
@@ -312,6 +336,7 @@ _pprint(void)
 {   
     pprintf("Broadcom Linux KNET Call-Back: Untagged VLAN Stripper\n");
     pprintf("    %lu stripped packets\n", strip_stats.stripped);
+    pprintf("    %lu tags kept in skb metadata\n", strip_stats.hwaccel);
     pprintf("    %lu packets checked\n", strip_stats.checked);
     pprintf("    %lu packets skipped\n", strip_stats.skipped);
 
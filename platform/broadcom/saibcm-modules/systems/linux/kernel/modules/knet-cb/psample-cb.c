@@ -42,6 +42,9 @@
 #include <linux/skbuff.h>
 #include <linux/sched.h>
 #include <linux/netdevice.h>
+#include <linux/rcupdate.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 #include <net/net_namespace.h>
 #include <net/psample.h>
 #include "psample-cb.h"
@@ -79,12 +82,38 @@ LKM_MOD_PARAM(psample_size, "i", int, 0);
 MODULE_PARM_DESC(psample_size,
 "psample pkt size (default 128 bytes)");
 
+#define PSAMPLE_QLEN_DFLT 1024
+static int psample_qlen = PSAMPLE_QLEN_DFLT;
+LKM_MOD_PARAM(psample_qlen, "i", int, 0);
+MODULE_PARM_DESC(psample_qlen,
+"psample queue depth per CPU (default 1024 pkts)");
+
+static int psample_subsample = 1;
+LKM_MOD_PARAM(psample_subsample, "i", int, 0);
+MODULE_PARM_DESC(psample_subsample,
+"Send 1 of every N samples to psample, N=1 disables sub-sampling (default 1)");
+
 /* driver proc entry root */
 static struct proc_dir_entry *psample_proc_root = NULL;
 
+/* Number of entries in the port to netif map (psample_netif_t.port is 8-bit) */
+#define PSAMPLE_NETIF_PORT_MAX 256
+
+/* Per-port overrides, 0 means use the netif/global setting */
+typedef struct psample_port_cfg_s {
+    uint32 sample_rate;
+    uint32 sample_size;
+    uint32 subsample;
+    atomic_t subsample_cnt;
+} psample_port_cfg_t;
+
 /* psample general info */
 typedef struct {
     struct list_head netif_list;
+    /* Lowest ID netif of each port, RCU protected for the Rx path */
+    psample_netif_t __rcu *port_map[PSAMPLE_NETIF_PORT_MAX];
+    psample_port_cfg_t port_cfg[PSAMPLE_NETIF_PORT_MAX];
+    atomic_t subsample_cnt;
     knet_hw_info_t hw;
     struct net *netns;
     spinlock_t lock;
@@ -105,6 +134,9 @@ typedef struct psample_stats_s {
     unsigned long pkts_d_meta_srcport;
     unsigned long pkts_d_meta_dstport;
     unsigned long pkts_d_invalid_size;
+    unsigned long pkts_d_queue_full;
+    unsigned long pkts_d_subsampled;
+    unsigned long pkts_q_max;
 } psample_stats_t;
 static psample_stats_t g_psample_stats = {0};
 
@@ -113,27 +145,65 @@ typedef struct psample_meta_s {
     int src_ifindex;
     int dst_ifindex;
     int sample_rate;
+    int subsample;
+    atomic_t *subsample_cnt;
 } psample_meta_t;
 
+/* Sampled pkt waiting for delivery to the psample module */
+typedef struct psample_pkt_s {
+    struct list_head list;
+    struct psample_group *group;
+    psample_meta_t meta;
+    int size;               /* Original pkt size */
+    int data_len;           /* Bytes copied to data */
+    uint8_t data[0];
+} psample_pkt_t;
+
+/*
+ * Per-CPU queue of sampled pkts. The filter callback only copies the
+ * sample and queues it, the netlink messages are built by a worker.
+ */
+typedef struct psample_queue_s {
+    spinlock_t lock;
+    struct list_head pkt_list;
+    int count;
+    struct work_struct work;
+} psample_queue_t;
+static psample_queue_t __percpu *g_psample_queue = NULL;
 
+
+/*
+ * Look up the netif of a port without locking.
+ * Must be called within rcu_read_lock().
+ */
 static psample_netif_t*
 psample_netif_lookup_by_port(int unit, int port)
+{
+    if (port < 0 || port >= PSAMPLE_NETIF_PORT_MAX) {
+        return (NULL);
+    }
+    return rcu_dereference(g_psample_info.port_map[port]);
+}
+
+/*
+ * Point the port map entry of a port at the lowest ID netif on that
+ * port (the first match in the ID sorted netif list).
+ * Must be called with g_psample_info.lock held.
+ */
+static void
+psample_netif_port_map_update(int port)
 {
     struct list_head *list;
-    psample_netif_t *psample_netif = NULL;
-    unsigned long flags;
+    psample_netif_t *psample_netif, *found = NULL;
 
-    /* look for port from list of available net_devices */
-    spin_lock_irqsave(&g_psample_info.lock, flags);
     list_for_each(list, &g_psample_info.netif_list) {
         psample_netif = (psample_netif_t*)list;
         if (psample_netif->port == port) {
-            spin_unlock_irqrestore(&g_psample_info.lock, flags);
-            return psample_netif;
+            found = psample_netif;
+            break;
         }
     }
-    spin_unlock_irqrestore(&g_psample_info.lock, flags);
-    return (NULL);
+    rcu_assign_pointer(g_psample_info.port_map[port], found);
 }
         
 static int
@@ -286,7 +356,10 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
     int dst_ifindex = 0;
     int sample_rate = PSAMPLE_RATE_DFLT;
     int sample_size = PSAMPLE_SIZE_DFLT;
+    int subsample = psample_subsample;
+    atomic_t *subsample_cnt = &g_psample_info.subsample_cnt;
     psample_netif_t *psample_netif = NULL;
+    psample_port_cfg_t *port_cfg;
 
 #ifdef PSAMPLE_CB_DBG
     if (debug & 0x1) {
@@ -309,6 +382,8 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         return (-1);
     }
 
+    rcu_read_lock();
+
     /* find src port netif (no need to lookup CPU port) */
     if (srcport != 0) {
         if ((psample_netif = psample_netif_lookup_by_port(unit, srcport))) {
@@ -331,6 +406,23 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
         }
     }
 
+    rcu_read_unlock();
+
+    /* per-port overrides of the src port */
+    if (srcport > 0 && srcport < PSAMPLE_NETIF_PORT_MAX) {
+        port_cfg = &g_psample_info.port_cfg[srcport];
+        if (port_cfg->sample_rate) {
+            sample_rate = port_cfg->sample_rate;
+        }
+        if (port_cfg->sample_size) {
+            sample_size = port_cfg->sample_size;
+        }
+        if (port_cfg->subsample) {
+            subsample = port_cfg->subsample;
+            subsample_cnt = &port_cfg->subsample_cnt;
+        }
+    }
+
     PSAMPLE_CB_DBG_PRINT("%s: srcport %d, dstport %d, src_ifindex %d, dst_ifindex %d, trunc_size %d, sample_rate %d\n", 
             __func__, srcport, dstport, src_ifindex, dst_ifindex, sample_size, sample_rate);
 
@@ -338,17 +430,99 @@ psample_meta_get(int unit, uint8_t *pkt, void *pkt_meta, psample_meta_t *sflow_m
     sflow_meta->dst_ifindex = dst_ifindex;
     sflow_meta->trunc_size  = sample_size;
     sflow_meta->sample_rate = sample_rate;
+    sflow_meta->subsample   = subsample;
+    sflow_meta->subsample_cnt = subsample_cnt;
 
     return (0);
 }
 
+static void
+psample_task(struct work_struct *work)
+{
+    psample_queue_t *queue = container_of(work, psample_queue_t, work);
+    psample_pkt_t *pkt, *tmp;
+    struct sk_buff skb;
+    unsigned long flags;
+    LIST_HEAD(pkt_list);
+
+    /* Take all queued samples at once */
+    spin_lock_irqsave(&queue->lock, flags);
+    list_splice_init(&queue->pkt_list, &pkt_list);
+    queue->count = 0;
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    list_for_each_entry_safe(pkt, tmp, &pkt_list, list) {
+        /* setup skb to point to pkt */
+        memset(&skb, 0, sizeof(struct sk_buff));
+        skb.len = pkt->size;
+        skb.data = pkt->data;
+
+        psample_sample_packet(pkt->group,
+                              &skb,
+                              pkt->meta.trunc_size,
+                              pkt->meta.src_ifindex,
+                              pkt->meta.dst_ifindex,
+                              pkt->meta.sample_rate);
+
+        g_psample_stats.pkts_f_psample_mod++;
+        list_del(&pkt->list);
+        kfree(pkt);
+    }
+}
+
+static int
+psample_pkt_queue(struct psample_group *group, psample_meta_t *meta,
+                  uint8_t *data, int size)
+{
+    psample_queue_t *queue;
+    psample_pkt_t *pkt;
+    unsigned long flags;
+    int data_len;
+    int rv = 0;
+
+    data_len = size;
+    if (meta->trunc_size > 0 && data_len > meta->trunc_size) {
+        data_len = meta->trunc_size;
+    }
+
+    queue = get_cpu_ptr(g_psample_queue);
+    if (queue->count >= psample_qlen) {
+        g_psample_stats.pkts_d_queue_full++;
+        rv = -1;
+        goto PSAMPLE_PKT_QUEUE_DONE;
+    }
+
+    if ((pkt = kmalloc(sizeof(psample_pkt_t) + data_len, GFP_ATOMIC)) == NULL) {
+        g_psample_stats.pkts_d_no_skb++;
+        rv = -1;
+        goto PSAMPLE_PKT_QUEUE_DONE;
+    }
+    pkt->group = group;
+    pkt->meta = *meta;
+    pkt->size = size;
+    pkt->data_len = data_len;
+    memcpy(pkt->data, data, data_len);
+
+    spin_lock_irqsave(&queue->lock, flags);
+    list_add_tail(&pkt->list, &queue->pkt_list);
+    if (++queue->count > g_psample_stats.pkts_q_max) {
+        g_psample_stats.pkts_q_max = queue->count;
+    }
+    spin_unlock_irqrestore(&queue->lock, flags);
+
+    schedule_work_on(smp_processor_id(), &queue->work);
+
+PSAMPLE_PKT_QUEUE_DONE:
+    put_cpu_ptr(g_psample_queue);
+    return rv;
+}
+
 int 
 psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
                   int chan, kcom_filter_t *kf)
 {
     struct psample_group *group;
     psample_meta_t meta;   
-    struct sk_buff skb;
     int rv = 0;
     static int info_get = 0;
 
@@ -398,20 +572,18 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
             __func__, group->group_num, meta.trunc_size, meta.src_ifindex, meta.dst_ifindex, meta.sample_rate);
 
     /* drop if configured sample rate is 0 */
-    if (meta.sample_rate > 0) {
-        /* setup skb to point to pkt */
-        memset(&skb, 0, sizeof(struct sk_buff));
-        skb.len = size;
-        skb.data = pkt;
-
-        psample_sample_packet(group, 
-                              &skb, 
-                              meta.trunc_size,
-                              meta.src_ifindex,
-                              meta.dst_ifindex,
-                              meta.sample_rate);
+    /* in-kernel sub-sampling, scale the rate to keep estimates right */
+    if (meta.sample_rate > 0 && meta.subsample > 1) {
+        if (atomic_inc_return(meta.subsample_cnt) % meta.subsample) {
+            g_psample_stats.pkts_d_subsampled++;
+            goto PSAMPLE_FILTER_CB_PKT_HANDLED;
+        }
+        meta.sample_rate *= meta.subsample;
+    }
 
-        g_psample_stats.pkts_f_psample_mod++;
+    if (meta.sample_rate > 0) {
+        /* hand the sample over to psample_task */
+        psample_pkt_queue(group, &meta, pkt, size);
     } else {
         g_psample_stats.pkts_d_sampling_disabled++;
     }    
@@ -468,7 +640,8 @@ psample_netif_create_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         /* No holes - add to end of list */
         list_add_tail(&psample_netif->list, &g_psample_info.netif_list);
     }
-    
+    psample_netif_port_map_update(psample_netif->port);
+
     spin_unlock_irqrestore(&g_psample_info.lock, flags);
 
     PSAMPLE_CB_DBG_PRINT("%s: added psample netif '%s'\n", __func__, dev->name);
@@ -478,7 +651,7 @@ psample_netif_create_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
 int
 psample_netif_destroy_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
 {
-    int found;
+    int found = 0;
     struct list_head *list;
     psample_netif_t *psample_netif;
     unsigned long flags; 
@@ -495,8 +668,10 @@ psample_netif_destroy_cb(int unit, kcom_netif_t *netif, struct net_device *dev)
         if (netif->id == psample_netif->id) {
             found = 1; 
             list_del(&psample_netif->list);
+            psample_netif_port_map_update(psample_netif->port);
             PSAMPLE_CB_DBG_PRINT("%s: removing psample netif '%s'\n", __func__, dev->name);
-            kfree(psample_netif);
+            /* Rx path may still be looking at it */
+            kfree_rcu(psample_netif, rcu);
             break;
         }
     }
@@ -710,6 +885,109 @@ struct file_operations psample_proc_size_file_ops = {
     release:    single_release,
 };
 
+/*
+ * psample per-port config Proc Read Entry
+ */
+static int
+psample_proc_port_show(struct seq_file *m, void *v)
+{
+    psample_port_cfg_t *port_cfg;
+    int port;
+
+    seq_printf(m, "  subsample default %d\n", psample_subsample);
+    seq_printf(m, "  %-6s %10s %10s %10s\n", "port", "rate", "size", "subsample");
+    for (port = 0; port < PSAMPLE_NETIF_PORT_MAX; port++) {
+        port_cfg = &g_psample_info.port_cfg[port];
+        if (port_cfg->sample_rate || port_cfg->sample_size || port_cfg->subsample) {
+            seq_printf(m, "  %-6d %10u %10u %10u\n", port,
+                       port_cfg->sample_rate, port_cfg->sample_size,
+                       port_cfg->subsample);
+        }
+    }
+    return 0;
+}
+
+static int
+psample_proc_port_open(struct inode * inode, struct file * file)
+{
+    return single_open(file, psample_proc_port_show, NULL);
+}
+
+/*
+ * psample per-port config Proc Write Entry
+ *
+ *   Syntax:
+ *   <port>:[rate=<n>][,size=<n>][,subsample=<n>]
+ *   <port>:clear
+ *   subsample=<n>
+ *
+ *   Where <port> is the physical port in the pkt metadata. A value of
+ *   0 removes the override, and subsample=<n> without a port sets the
+ *   default for ports without an override.
+ *
+ *   Examples:
+ *   1:rate=1000,size=256
+ *   33:subsample=4
+ */
+static ssize_t
+psample_proc_port_write(struct file *file, const char *buf,
+                    size_t count, loff_t *loff)
+{
+    psample_port_cfg_t *port_cfg;
+    char port_str[80], *ptr;
+    int port;
+
+    if (count > sizeof(port_str) - 1) {
+        count = sizeof(port_str) - 1;
+    }
+    if (copy_from_user(port_str, buf, count)) {
+        return -EFAULT;
+    }
+    port_str[count] = 0;
+
+    if (strchr(port_str, ':') == NULL) {
+        if ((ptr = strstr(port_str, "subsample=")) != NULL) {
+            psample_subsample = simple_strtol(ptr + 10, NULL, 10);
+        } else {
+            gprintk("Error: Port config syntax not recognized: '%s'\n", port_str);
+        }
+        return count;
+    }
+
+    port = simple_strtol(port_str, NULL, 10);
+    if (port < 0 || port >= PSAMPLE_NETIF_PORT_MAX) {
+        gprintk("Error: Invalid port %d\n", port);
+        return count;
+    }
+    port_cfg = &g_psample_info.port_cfg[port];
+
+    if (strstr(port_str, "clear") != NULL) {
+        port_cfg->sample_rate = 0;
+        port_cfg->sample_size = 0;
+        port_cfg->subsample = 0;
+        return count;
+    }
+    if ((ptr = strstr(port_str, "rate=")) != NULL) {
+        port_cfg->sample_rate = simple_strtol(ptr + 5, NULL, 10);
+    }
+    if ((ptr = strstr(port_str, "size=")) != NULL) {
+        port_cfg->sample_size = simple_strtol(ptr + 5, NULL, 10);
+    }
+    if ((ptr = strstr(port_str, "subsample=")) != NULL) {
+        port_cfg->subsample = simple_strtol(ptr + 10, NULL, 10);
+    }
+    return count;
+}
+
+struct file_operations psample_proc_port_file_ops = {
+    owner:      THIS_MODULE,
+    open:       psample_proc_port_open,
+    read:       seq_read,
+    llseek:     seq_lseek,
+    write:      psample_proc_port_write,
+    release:    single_release,
+};
+
 /*
  * psample debug Proc Read Entry
  */
@@ -795,6 +1073,10 @@ psample_proc_stats_show(struct seq_file *m, void *v)
     seq_printf(m, "  pkts with invalid src port     %10lu\n", g_psample_stats.pkts_d_meta_srcport);
     seq_printf(m, "  pkts with invalid dst port     %10lu\n", g_psample_stats.pkts_d_meta_dstport);
     seq_printf(m, "  pkts with invalid orig pkt sz  %10lu\n", g_psample_stats.pkts_d_invalid_size);
+    seq_printf(m, "  pkts drop queue full           %10lu\n", g_psample_stats.pkts_d_queue_full);
+    seq_printf(m, "  pkts drop sub-sampled          %10lu\n", g_psample_stats.pkts_d_subsampled);
+    seq_printf(m, "  pkts queue max depth           %10lu\n", g_psample_stats.pkts_q_max);
+    seq_printf(m, "  pkts queue limit per CPU       %10d\n",  psample_qlen);
     return 0;
 }
 
@@ -815,10 +1097,28 @@ struct file_operations psample_proc_stats_file_ops = {
 
 int psample_cleanup(void)
 {
+    psample_queue_t *queue;
+    psample_pkt_t *pkt, *tmp;
+    int cpu;
+
     remove_proc_entry("stats", psample_proc_root);
     remove_proc_entry("rate",  psample_proc_root);
     remove_proc_entry("size",  psample_proc_root);
+    remove_proc_entry("port",  psample_proc_root);
     remove_proc_entry("debug", psample_proc_root);
+
+    if (g_psample_queue) {
+        for_each_possible_cpu(cpu) {
+            queue = per_cpu_ptr(g_psample_queue, cpu);
+            cancel_work_sync(&queue->work);
+            list_for_each_entry_safe(pkt, tmp, &queue->pkt_list, list) {
+                list_del(&pkt->list);
+                kfree(pkt);
+            }
+        }
+        free_percpu(g_psample_queue);
+        g_psample_queue = NULL;
+    }
     return 0;
 }
 
@@ -827,6 +1127,8 @@ int psample_init(void)
     #define PROCFS_MAX_PATH 1024
     char psample_procfs_path[PROCFS_MAX_PATH];
     struct proc_dir_entry *entry;
+    psample_queue_t *queue;
+    int cpu;
 
     /* create procfs for psample */
     snprintf(psample_procfs_path, PROCFS_MAX_PATH, "bcm/knet-cb");
@@ -855,6 +1157,13 @@ int psample_init(void)
         return -1;
     }
 
+    /* create procfs for per-port rate, size and sub-sampling */
+    PROC_CREATE(entry, "port", 0666, psample_proc_root, &psample_proc_port_file_ops);
+    if (entry == NULL) {
+        gprintk("%s: Unable to create procfs entry '/procfs/%s/port'\n", __func__, psample_procfs_path);
+        return -1;
+    }
+
     /* create procfs for debug log */
     PROC_CREATE(entry, "debug", 0666, psample_proc_root, &psample_proc_debug_file_ops);
     if (entry == NULL) {
@@ -870,6 +1179,20 @@ int psample_init(void)
     INIT_LIST_HEAD(&g_psample_info.netif_list); 
     spin_lock_init(&g_psample_info.lock);
 
+    /* setup per-CPU sample queues */
+    g_psample_queue = alloc_percpu(psample_queue_t);
+    if (!g_psample_queue) {
+        gprintk("%s: failed to alloc psample queues\n", __func__);
+        return (-1);
+    }
+    for_each_possible_cpu(cpu) {
+        queue = per_cpu_ptr(g_psample_queue, cpu);
+        spin_lock_init(&queue->lock);
+        INIT_LIST_HEAD(&queue->pkt_list);
+        queue->count = 0;
+        INIT_WORK(&queue->work, psample_task);
+    }
+
     /* get net namespace */ 
     g_psample_info.netns = get_net_ns_by_pid(current->pid);
     if (!g_psample_info.netns) {
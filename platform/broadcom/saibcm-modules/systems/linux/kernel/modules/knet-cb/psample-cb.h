@@ -40,6 +40,7 @@ psample_filter_cb(uint8_t * pkt, int size, int dev_no, void *pkt_meta,
 /* psample data per interface */
 typedef struct {
     struct list_head list;
+    struct rcu_head rcu;
     struct net_device *dev;
     uint16 id;
     uint8  port;
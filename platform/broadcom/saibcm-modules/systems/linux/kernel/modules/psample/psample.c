@@ -18,10 +18,17 @@
 #include <net/genetlink.h>
 #include <net/psample.h>
 #include <linux/spinlock.h>
+#include <linux/hashtable.h>
 
 #define PSAMPLE_MAX_PACKET_SIZE 0xffff
 
-static LIST_HEAD(psample_groups_list);
+/*
+ * Groups are hashed by group number. Lookups run under RCU and take a
+ * reference with atomic_inc_not_zero(), the lock only serializes the
+ * creation and removal of groups.
+ */
+#define PSAMPLE_GROUPS_HASH_BITS 6
+static DEFINE_HASHTABLE(psample_groups_table, PSAMPLE_GROUPS_HASH_BITS);
 static DEFINE_SPINLOCK(psample_groups_lock);
 
 /* multicast groups */
@@ -53,7 +60,7 @@ static int psample_group_nl_fill(struct sk_buff *msg,
 	if (ret < 0)
 		goto error;
 
-	ret = nla_put_u32(msg, PSAMPLE_ATTR_GROUP_REFCOUNT, group->refcount);
+	ret = nla_put_u32(msg, PSAMPLE_ATTR_GROUP_REFCOUNT, atomic_read(&group->refcount));
 	if (ret < 0)
 		goto error;
 
@@ -75,10 +82,11 @@ static int psample_nl_cmd_get_group_dumpit(struct sk_buff *msg,
 	struct psample_group *group;
 	int start = cb->args[0];
 	int idx = 0;
+	int bkt;
 	int err;
 
-	spin_lock(&psample_groups_lock);
-	list_for_each_entry(group, &psample_groups_list, list) {
+	spin_lock_bh(&psample_groups_lock);
+	hash_for_each(psample_groups_table, bkt, group, node) {
 		if (!net_eq(group->net, sock_net(msg->sk)))
 			continue;
 		if (idx < start) {
@@ -93,7 +101,7 @@ static int psample_nl_cmd_get_group_dumpit(struct sk_buff *msg,
 		idx++;
 	}
 
-	spin_unlock(&psample_groups_lock);
+	spin_unlock_bh(&psample_groups_lock);
 	cb->args[0] = idx;
 	return msg->len;
 }
@@ -147,7 +155,8 @@ static struct psample_group *psample_group_create(struct net *net,
 
 	group->net = net;
 	group->group_num = group_num;
-	list_add_tail(&group->list, &psample_groups_list);
+	atomic_set(&group->refcount, 1);
+	hash_add_rcu(psample_groups_table, &group->node, group_num);
 
 	psample_group_notify(group, PSAMPLE_CMD_NEW_GROUP);
 	return group;
@@ -156,16 +165,17 @@ static struct psample_group *psample_group_create(struct net *net,
 static void psample_group_destroy(struct psample_group *group)
 {
 	psample_group_notify(group, PSAMPLE_CMD_DEL_GROUP);
-	list_del(&group->list);
-	kfree(group);
+	hash_del_rcu(&group->node);
+	kfree_rcu(group, rcu);
 }
 
+/* Call under rcu_read_lock() or with psample_groups_lock held */
 static struct psample_group *
 psample_group_lookup(struct net *net, u32 group_num)
 {
 	struct psample_group *group;
 
-	list_for_each_entry(group, &psample_groups_list, list)
+	hash_for_each_possible_rcu(psample_groups_table, group, node, group_num)
 		if ((group->group_num == group_num) && (group->net == net))
 			return group;
 	return NULL;
@@ -175,30 +185,40 @@ struct psample_group *psample_group_get(struct net *net, u32 group_num)
 {
 	struct psample_group *group;
 
-	spin_lock(&psample_groups_lock);
+	/* Fast path, the group exists and is not being removed */
+	rcu_read_lock();
+	group = psample_group_lookup(net, group_num);
+	if (group && atomic_inc_not_zero(&group->refcount)) {
+		rcu_read_unlock();
+		return group;
+	}
+	rcu_read_unlock();
+
+	spin_lock_bh(&psample_groups_lock);
 
 	group = psample_group_lookup(net, group_num);
-	if (!group) {
+	if (group)
+		atomic_inc(&group->refcount);
+	else
 		group = psample_group_create(net, group_num);
-		if (!group)
-			goto out;
-	}
-	group->refcount++;
 
-out:
-	spin_unlock(&psample_groups_lock);
+	spin_unlock_bh(&psample_groups_lock);
 	return group;
 }
 EXPORT_SYMBOL_GPL(psample_group_get);
 
 void psample_group_put(struct psample_group *group)
 {
-	spin_lock(&psample_groups_lock);
+	/* Only the last reference takes the lock */
+	if (atomic_add_unless(&group->refcount, -1, 1))
+		return;
+
+	spin_lock_bh(&psample_groups_lock);
 
-	if (--group->refcount == 0)
+	if (atomic_dec_and_test(&group->refcount))
 		psample_group_destroy(group);
 
-	spin_unlock(&psample_groups_lock);
+	spin_unlock_bh(&psample_groups_lock);
 }
 EXPORT_SYMBOL_GPL(psample_group_put);
 
@@ -874,10 +874,19 @@ static ssize_t sfp_show_tx_rx_status(struct device *dev, struct device_attribute
     return sprintf(buf, "%d\n", val);
 }
 /* Platform dependent --- */
-static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
-                                int data_len)
+/* Block transfers unless disabled or the adapter can not do them */
+static bool use_block_read = USE_I2C_BLOCK_READ;
+module_param(use_block_read, bool, 0644);
+MODULE_PARM_DESC(use_block_read, "Use SMBus block transfers when the adapter supports them");
+
+static int sfp_use_block(struct i2c_client *client, u32 func)
+{
+    return use_block_read && i2c_check_functionality(client->adapter, func);
+}
+
+static ssize_t sfp_eeprom_write_block(struct i2c_client *client, u8 command, const char *data,
+                                      int data_len)
 {
-#if USE_I2C_BLOCK_READ
     int status, retry = I2C_RW_RETRY_COUNT;
 
     if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -900,7 +909,10 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
     }
 
     return data_len;
-#else
+}
+
+static ssize_t sfp_eeprom_write_byte(struct i2c_client *client, u8 command, const char *data)
+{
     int status, retry = I2C_RW_RETRY_COUNT;
 
     while (retry) {
@@ -919,9 +931,25 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
     }
 
     return 1;
-#endif
+}
 
+static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
+                                int data_len)
+{
+    ssize_t status;
+
+    if (!sfp_use_block(client, I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+        return sfp_eeprom_write_byte(client, command, data);
+    }
 
+    status = sfp_eeprom_write_block(client, command, data, data_len);
+    if (status >= 0 || status == -ENXIO) {
+        return status;
+    }
+
+    /* The block transfer was rejected, redo this one byte by byte */
+    dev_dbg(&client->dev, "sfp block write failed, command(0x%2x), status(%d), fall back to byte write\r\n", command, (int)status);
+    return sfp_eeprom_write_byte(client, command, data);
 }
 
 #if (MULTIPAGE_SUPPORT == 0)
@@ -987,10 +1015,9 @@ static ssize_t sfp_bin_write(struct file *filp, struct kobject *kobj,
 #endif
 }
 
-static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
-                               int data_len)
+static ssize_t sfp_eeprom_read_block(struct i2c_client *client, u8 command, u8 *data,
+                                     int data_len)
 {
-#if USE_I2C_BLOCK_READ
     int status, retry = I2C_RW_RETRY_COUNT;
 
     if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -1020,7 +1047,10 @@ static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
 
 abort:
     return status;
-#else
+}
+
+static ssize_t sfp_eeprom_read_byte(struct i2c_client *client, u8 command, u8 *data)
+{
     int status, retry = I2C_RW_RETRY_COUNT;
 
     while (retry) {
@@ -1044,7 +1074,25 @@ abort:
 
 abort:
     return status;
-#endif
+}
+
+static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
+                               int data_len)
+{
+    ssize_t status;
+
+    if (!sfp_use_block(client, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        return sfp_eeprom_read_byte(client, command, data);
+    }
+
+    status = sfp_eeprom_read_block(client, command, data, data_len);
+    if (status >= 0 || status == -ENXIO) {
+        return status;
+    }
+
+    /* The block transfer was rejected, redo this one byte by byte */
+    dev_dbg(&client->dev, "sfp block read failed, command(0x%2x), status(%d), fall back to byte read\r\n", command, (int)status);
+    return sfp_eeprom_read_byte(client, command, data);
 }
 
 #if (MULTIPAGE_SUPPORT == 1)
@@ -1107,9 +1155,9 @@ static uint8_t sff_8436_translate_offset(struct sfp_port_data *port_data,
     return page;  /* note also returning client and offset */
 }
 
-static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
-                                    struct i2c_client *client,
-                                    char *buf, unsigned offset, size_t count)
+static ssize_t sff_8436_eeprom_do_read(struct sfp_port_data *port_data,
+                                       struct i2c_client *client,
+                                       char *buf, unsigned offset, size_t count)
 {
     struct i2c_msg msg[2];
     u8 msgbuf[2];
@@ -1196,6 +1244,9 @@ static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
         if (status == -ENXIO) /* no module present */
             return status;
 
+        if (status == -EOPNOTSUPP || status == -EPROTO)
+            return status; /* transfer type rejected */
+
         /* REVISIT: at HZ=100, this is sloooow */
         msleep(1);
     } while (time_before(read_time, timeout));
@@ -1203,6 +1254,52 @@ static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
     return -ETIMEDOUT;
 }
 
+/*
+ * Step down to the next transfer type the adapter offers once the current
+ * one is rejected, the port keeps using it from then on.
+ */
+static int sff_8436_read_fallback(struct sfp_port_data *port_data,
+                                  struct i2c_client *client)
+{
+    int use_smbus;
+
+    switch (port_data->use_smbus) {
+    case 0:
+        if (i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK)) {
+            use_smbus = I2C_SMBUS_I2C_BLOCK_DATA;
+            break;
+        }
+        /* fall through */
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        if (i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA)) {
+            use_smbus = I2C_SMBUS_BYTE_DATA;
+            break;
+        }
+        /* fall through */
+    default:
+        return 0;
+    }
+
+    dev_notice(&client->dev, "Transfer rejected, falling back to %s reads\n",
+               use_smbus == I2C_SMBUS_I2C_BLOCK_DATA ? "block" : "byte");
+    port_data->use_smbus = use_smbus;
+    return 1;
+}
+
+static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
+                                    struct i2c_client *client,
+                                    char *buf, unsigned offset, size_t count)
+{
+    ssize_t status;
+
+    do {
+        status = sff_8436_eeprom_do_read(port_data, client, buf, offset, count);
+    } while ((status == -EOPNOTSUPP || status == -EPROTO) &&
+             sff_8436_read_fallback(port_data, client));
+
+    return status;
+}
+
 static ssize_t sff_8436_eeprom_write(struct sfp_port_data *port_data,
                                      struct i2c_client *client,
                                      const char *buf,
@@ -1495,7 +1592,28 @@ static ssize_t sfp_port_read_write(struct sfp_port_data *port_data,
      */
     pending_len = len; /* amount remaining to transfer */
     retval = 0;  /* amount transferred */
-    for (chunk = off >> 7; chunk <= (off + len - 1) >> 7; chunk++) {
+
+    /*
+     * Lower and upper page 00h (A0h for SFP) need no page select,
+     * move them in a single transfer rather than chunk by chunk.
+     */
+    if (off < 2 * SFF_8436_PAGE_SIZE) {
+        chunk_len = min_t(size_t, pending_len, 2 * SFF_8436_PAGE_SIZE - off);
+        status = sff_8436_eeprom_update_client(port_data, buf,
+                off, chunk_len, opcode);
+        if (status != chunk_len) {
+            dev_dbg(&client->dev,
+    "sff_8436_update_client for page 0 off %lld chunk_len %ld failed %d!\n",
+                off, (long int) chunk_len, status);
+            goto err;
+        }
+        buf += status;
+        off += status;
+        pending_len -= status;
+        retval += status;
+    }
+
+    for (chunk = off >> 7; pending_len && chunk <= (off + pending_len - 1) >> 7; chunk++) {
 
         /*
          * Compute the offset and number of bytes to be read/write
@@ -1662,11 +1780,8 @@ static int sfp_sysfs_eeprom_cleanup(struct kobject *kobj, struct bin_attribute *
 #if (MULTIPAGE_SUPPORT == 0)
 static int sfp_i2c_check_functionality(struct i2c_client *client)
 {
-#if USE_I2C_BLOCK_READ
-    return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK);
-#else
+    /* Byte access is enough, block transfers are used when supported */
     return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA);
-#endif
 }
 #endif
 
@@ -31,6 +31,7 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
+#include "accton_sfp_cache.h"
 
 #define DRIVER_NAME 	"as7712_32x_sfp"
 
@@ -172,6 +173,7 @@ struct sfp_port_data {
 	struct sfp_msa_data	  *msa;
 	struct sfp_ddm_data   *ddm;
 	struct qsfp_data 	  *qsfp;
+	struct accton_sfp_cache cache;	  /* eeprom pages */
 
 	struct i2c_client 	  *client;
 };
@@ -210,33 +212,57 @@ static ssize_t show_port_number(struct device *dev, struct device_attribute *da,
 	return sprintf(buf, "%d\n", CPLD_PORT_TO_FRONT_PORT(data->port));
 }
 
-static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+/*
+ * The presence bitmap is shared by all ports and read at most once per
+ * present_cache_ms. dom_cache_ms is how long the DOM and status page of
+ * the eeprom may be served from the cache, 0 always reads the module.
+ */
+static unsigned int present_cache_ms = 100;
+module_param(present_cache_ms, uint, 0644);
+MODULE_PARM_DESC(present_cache_ms, "Max age of the shared presence bitmap in ms");
+
+static unsigned int dom_cache_ms = 1000;
+module_param(dom_cache_ms, uint, 0644);
+MODULE_PARM_DESC(dom_cache_ms, "Max age of the cached eeprom DOM/status page in ms");
+
+/* Upper page 00h (id) */
+#define QSFP_CACHE_STATIC_PAGES	BIT(1)
+
+static struct accton_sfp_present sfp_present;
+
+static int sfp_read_present_bitmap(u64 *bitmap)
 {
-	struct sfp_port_data *data = i2c_get_clientdata(client);
 	int i = 0;
 	int status = -1;
 	u8 regs[] = {0x30, 0x31, 0x32, 0x33};
 
-	DEBUG_PRINT("Starting sfp present status update");
-	mutex_lock(&data->update_lock);
-
 	/* Read present status of port 1~32 */
-    data->present = 0;
-	
+    *bitmap = 0;
+
     for (i = 0; i < ARRAY_SIZE(regs); i++) {
         status = accton_i2c_cpld_read(0x60, regs[i]);
         
         if (status < 0) {
             DEBUG_PRINT("cpld(0x60) reg(0x%x) err %d", regs[i], status);
-            goto exit;
+            return status;
         }
-        
-        DEBUG_PRINT("Present status = 0x%llx", data->present);
-        data->present |= (u64)status << (i*8);
+
+        *bitmap |= (u64)status << (i*8);
     }
 
+	return 0;
+}
+
+static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+{
+	struct sfp_port_data *data = i2c_get_clientdata(client);
+
+	DEBUG_PRINT("Starting sfp present status update");
+	accton_sfp_present_update(&sfp_present, sfp_read_present_bitmap, present_cache_ms);
+
+	mutex_lock(&data->update_lock);
+	data->present = sfp_present.bitmap;
 	DEBUG_PRINT("Present status = 0x%llx", data->present);
-exit:
 	mutex_unlock(&data->update_lock);
 	return data;
 }
@@ -577,6 +603,7 @@ static ssize_t qsfp_set_tx_disable(struct device *dev, struct device_attribute *
 	DEBUG_PRINT("index = (%d), status = (0x%x)", attr->index, data->qsfp->status[1]);
 	result = sfp_eeprom_write(client, SFF8436_TX_DISABLE_ADDR, &data->qsfp->status[1], sizeof(data->qsfp->status[1]));
 	mutex_unlock(&data->update_lock);
+	accton_sfp_cache_invalidate(&data->cache);
 	return count;
 }
 
@@ -693,10 +720,19 @@ static struct attribute *sfp_ddm_attributes[] = {
 	NULL
 };
 
-static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
+/* Block transfers unless disabled or the adapter can not do them */
+static bool use_block_read = USE_I2C_BLOCK_READ;
+module_param(use_block_read, bool, 0644);
+MODULE_PARM_DESC(use_block_read, "Use SMBus block transfers when the adapter supports them");
+
+static int sfp_use_block(struct i2c_client *client, u32 func)
+{
+	return use_block_read && i2c_check_functionality(client->adapter, func);
+}
+
+static ssize_t sfp_eeprom_write_block(struct i2c_client *client, u8 command, const char *data,
 			  int data_len)
 {
-#if USE_I2C_BLOCK_READ
 	int result, retry = I2C_RW_RETRY_COUNT;
 
 	if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -719,7 +755,10 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
 	}		
 
 	return data_len;
-#else
+}
+
+static ssize_t sfp_eeprom_write_byte(struct i2c_client *client, u8 command, const char *data)
+{
 	int result, retry = I2C_RW_RETRY_COUNT;
 
 	while (retry) {
@@ -738,9 +777,25 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
 	}
 
 	return 1;
-#endif
+}
 
-	
+static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
+			  int data_len)
+{
+	ssize_t result;
+
+	if (!sfp_use_block(client, I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+		return sfp_eeprom_write_byte(client, command, data);
+	}
+
+	result = sfp_eeprom_write_block(client, command, data, data_len);
+	if (result >= 0 || result == -ENXIO) {
+		return result;
+	}
+
+	/* The block transfer was rejected, redo this one byte by byte */
+	dev_dbg(&client->dev, "sfp block write failed, command(0x%2x), result(%d), fall back to byte write\r\n", command, (int)result);
+	return sfp_eeprom_write_byte(client, command, data);
 }
 
 
@@ -785,15 +840,17 @@ static ssize_t sfp_bin_write(struct file *filp, struct kobject *kobj,
 				char *buf, loff_t off, size_t count)
 {
 	struct sfp_port_data *data;
+	ssize_t status;
 	DEBUG_PRINT("offset = (%d), count = (%d)", off, count);
 	data = dev_get_drvdata(container_of(kobj, struct device, kobj));
-	return sfp_port_write(data, buf, off, count);
+	status = sfp_port_write(data, buf, off, count);
+	accton_sfp_cache_invalidate(&data->cache);
+	return status;
 }
 
-static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
+static ssize_t sfp_eeprom_read_block(struct i2c_client *client, u8 command, u8 *data,
 			  int data_len)
 {
-#if USE_I2C_BLOCK_READ
 	int result, retry = I2C_RW_RETRY_COUNT;
 
 	if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -822,7 +879,10 @@ static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
 	
 abort:
 	return result;
-#else
+}
+
+static ssize_t sfp_eeprom_read_byte(struct i2c_client *client, u8 command, u8 *data)
+{
 	int result, retry = I2C_RW_RETRY_COUNT;
 
 	while (retry) {
@@ -845,8 +905,26 @@ abort:
 	result = 1;
 
 abort:
-	return result;	
-#endif
+	return result;
+}
+
+static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
+			  int data_len)
+{
+	ssize_t result;
+
+	if (!sfp_use_block(client, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+		return sfp_eeprom_read_byte(client, command, data);
+	}
+
+	result = sfp_eeprom_read_block(client, command, data, data_len);
+	if (result >= 0 || result == -ENXIO) {
+		return result;
+	}
+
+	/* The block transfer was rejected, redo this one byte by byte */
+	dev_dbg(&client->dev, "sfp block read failed, command(0x%2x), result(%d), fall back to byte read\r\n", command, (int)result);
+	return sfp_eeprom_read_byte(client, command, data);
 }
 
 static ssize_t sfp_port_read(struct sfp_port_data *data,
@@ -887,14 +965,27 @@ static ssize_t sfp_port_read(struct sfp_port_data *data,
 
 }
 
+static ssize_t sfp_cache_fill(void *ctx, char *buf, loff_t off, size_t count)
+{
+	return sfp_port_read(ctx, buf, off, count);
+}
+
 static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 		struct bin_attribute *attr,
 		char *buf, loff_t off, size_t count)
 {
+	/* Control bytes are not cached, writes go straight to the module */
+	const unsigned int cache_ttl_ms[ACCTON_SFP_TTL_CLASSES] = {
+		[ACCTON_SFP_TTL_DOM] = dom_cache_ms,
+	};
 	struct sfp_port_data *data;
 	DEBUG_PRINT("offset = (%d), count = (%d)", off, count);
 	data = dev_get_drvdata(container_of(kobj, struct device, kobj));
-	return sfp_port_read(data, buf, off, count);
+
+	/* Catches a module swap before anything is served from the cache */
+	sfp_update_present(data->client);
+	return accton_sfp_cache_read(&data->cache, READ_ONCE(sfp_present.gen[data->port]),
+								 buf, off, count, cache_ttl_ms, sfp_cache_fill, data);
 }
 
 static int sfp_sysfs_eeprom_init(struct kobject *kobj, struct bin_attribute *eeprom)
@@ -929,11 +1020,8 @@ static const struct attribute_group sfp_msa_group = {
 
 static int sfp_i2c_check_functionality(struct i2c_client *client)
 {
-#if USE_I2C_BLOCK_READ
-    return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK);
-#else
+    /* Byte access is enough, block transfers are used when supported */
     return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA);
-#endif
 }
 
 static int sfp_msa_probe(struct i2c_client *client, const struct i2c_device_id *dev_id,
@@ -1099,6 +1187,7 @@ static int sfp_device_probe(struct i2c_client *client,
 	}
 	
 	data->driver_type = DRIVER_TYPE_QSFP;
+	accton_sfp_cache_init(&data->cache, QSFP_CACHE_STATIC_PAGES);
 	return qsfp_probe(client, dev_id, &data->qsfp);
 }
 
@@ -1154,6 +1243,7 @@ static struct i2c_driver sfp_driver = {
 
 static int __init sfp_init(void)
 {
+    accton_sfp_present_init(&sfp_present);
     return i2c_add_driver(&sfp_driver);
 }
 
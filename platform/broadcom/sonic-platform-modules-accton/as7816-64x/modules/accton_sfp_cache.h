@@ -0,0 +1 @@
+../../common/modules/accton_sfp_cache.h
\ No newline at end of file
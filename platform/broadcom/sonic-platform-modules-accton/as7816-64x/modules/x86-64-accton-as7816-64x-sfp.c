@@ -31,6 +31,7 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
+#include "accton_sfp_cache.h"
 
 #define DRIVER_NAME 	"as7816_64x_sfp" /* Platform dependent */
 
@@ -321,6 +322,7 @@ struct sfp_port_data {
 	u64					   present;		/* present status, bit0:port0, bit1:port1 and so on */
 
 	struct qsfp_data	  *qsfp;
+	struct accton_sfp_cache cache;		/* eeprom pages */
 
 	struct i2c_client	  *client;
 #if (MULTIPAGE_SUPPORT == 1)
@@ -342,36 +344,64 @@ static ssize_t show_port_number(struct device *dev, struct device_attribute *da,
 	return sprintf(buf, "%d\n", CPLD_PORT_TO_FRONT_PORT(data->port));
 }
 
+/*
+ * The presence bitmap is shared by all ports and read at most once per
+ * present_cache_ms. dom_cache_ms is how long the DOM and status page of
+ * the eeprom may be served from the cache, 0 always reads the module.
+ */
+static unsigned int present_cache_ms = 100;
+module_param(present_cache_ms, uint, 0644);
+MODULE_PARM_DESC(present_cache_ms, "Max age of the shared presence bitmap in ms");
+
+static unsigned int dom_cache_ms = 1000;
+module_param(dom_cache_ms, uint, 0644);
+MODULE_PARM_DESC(dom_cache_ms, "Max age of the cached eeprom DOM/status page in ms");
+
+/* Upper pages 00h-03h (id, application, user and threshold) */
+#define QSFP_CACHE_STATIC_PAGES	(BIT(1) | BIT(2) | BIT(3) | BIT(4))
+
+static struct accton_sfp_present sfp_present;
+
 /* Platform dependent +++ */
-static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+static int sfp_read_present_bitmap(u64 *bitmap)
 {
-	struct sfp_port_data *data = i2c_get_clientdata(client);
 	int i = 0;
 	int status = -1;
 	u8 regs[] = {0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77};
 
-	DEBUG_PRINT("Starting sfp present status update");
-	mutex_lock(&data->update_lock);
-
 	/* Read present status of port 1~64 */
-    data->present = 0;
-	
+    *bitmap = 0;
+
     for (i = 0; i < ARRAY_SIZE(regs); i++) {
         status = accton_i2c_cpld_read(0x60, regs[i]);
         
         if (status < 0) {
             DEBUG_PRINT("cpld(0x60) reg(0x%x) err %d", regs[i], status);
-            goto exit;
+            return status;
         }
-        
-		DEBUG_PRINT("Present status = 0x%lx", data->present);		
-        data->present |= (u64)status << (i*8);
+
+        *bitmap |= (u64)status << (i*8);
     }
 
-	DEBUG_PRINT("Present status = 0x%lx", data->present);
-exit:
+	return 0;
+}
+
+static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+{
+	struct sfp_port_data *data = i2c_get_clientdata(client);
+	int status;
+
+	DEBUG_PRINT("Starting sfp present status update");
+	status = accton_sfp_present_update(&sfp_present, sfp_read_present_bitmap, present_cache_ms);
+	if (status < 0) {
+		return ERR_PTR(status);
+	}
+
+	mutex_lock(&data->update_lock);
+	data->present = sfp_present.bitmap;
+	DEBUG_PRINT("Present status = 0x%llx", data->present);
 	mutex_unlock(&data->update_lock);
-	return (status < 0) ? ERR_PTR(status) : data;
+	return data;
 }
 
 /* Platform dependent --- */
@@ -586,13 +616,23 @@ static ssize_t qsfp_set_tx_disable(struct device *dev, struct device_attribute *
 	}
 
 	mutex_unlock(&data->update_lock);
+	accton_sfp_cache_invalidate(&data->cache);
 	return count;
 }
 
-static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
+/* Block transfers unless disabled or the adapter can not do them */
+static bool use_block_read = USE_I2C_BLOCK_READ;
+module_param(use_block_read, bool, 0644);
+MODULE_PARM_DESC(use_block_read, "Use SMBus block transfers when the adapter supports them");
+
+static int sfp_use_block(struct i2c_client *client, u32 func)
+{
+	return use_block_read && i2c_check_functionality(client->adapter, func);
+}
+
+static ssize_t sfp_eeprom_write_block(struct i2c_client *client, u8 command, const char *data,
 			  int data_len)
 {
-#if USE_I2C_BLOCK_READ
 	int status, retry = I2C_RW_RETRY_COUNT;
 
 	if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -615,7 +655,10 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
 	}
 
 	return data_len;
-#else
+}
+
+static ssize_t sfp_eeprom_write_byte(struct i2c_client *client, u8 command, const char *data)
+{
 	int status, retry = I2C_RW_RETRY_COUNT;
 
 	while (retry) {
@@ -634,9 +677,25 @@ static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const cha
 	}
 
 	return 1;
-#endif
+}
 
+static ssize_t sfp_eeprom_write(struct i2c_client *client, u8 command, const char *data,
+			  int data_len)
+{
+	ssize_t status;
+
+	if (!sfp_use_block(client, I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+		return sfp_eeprom_write_byte(client, command, data);
+	}
+
+	status = sfp_eeprom_write_block(client, command, data, data_len);
+	if (status >= 0 || status == -ENXIO) {
+		return status;
+	}
 
+	/* The block transfer was rejected, redo this one byte by byte */
+	dev_dbg(&client->dev, "sfp block write failed, command(0x%2x), status(%d), fall back to byte write\r\n", command, (int)status);
+	return sfp_eeprom_write_byte(client, command, data);
 }
 
 #if (MULTIPAGE_SUPPORT == 0)
@@ -681,6 +740,7 @@ static ssize_t sfp_bin_write(struct file *filp, struct kobject *kobj,
 				char *buf, loff_t off, size_t count)
 {
 	int present;
+	ssize_t status;
 	struct sfp_port_data *data;
 	DEBUG_PRINT("%s(%d) offset = (%d), count = (%d)", off, count);
 	data = dev_get_drvdata(container_of(kobj, struct device, kobj));
@@ -696,16 +756,17 @@ static ssize_t sfp_bin_write(struct file *filp, struct kobject *kobj,
 	}
 
 #if (MULTIPAGE_SUPPORT == 1)
-	return sfp_port_read_write(data, buf, off, count, QSFP_WRITE_OP);
+	status = sfp_port_read_write(data, buf, off, count, QSFP_WRITE_OP);
 #else
-	return sfp_port_write(data, buf, off, count);
+	status = sfp_port_write(data, buf, off, count);
 #endif
+	accton_sfp_cache_invalidate(&data->cache);
+	return status;
 }
 
-static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
+static ssize_t sfp_eeprom_read_block(struct i2c_client *client, u8 command, u8 *data,
 			  int data_len)
 {
-#if USE_I2C_BLOCK_READ
 	int status, retry = I2C_RW_RETRY_COUNT;
 
 	if (data_len > I2C_SMBUS_BLOCK_MAX) {
@@ -735,7 +796,10 @@ static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
 
 abort:
 	return status;
-#else
+}
+
+static ssize_t sfp_eeprom_read_byte(struct i2c_client *client, u8 command, u8 *data)
+{
 	int status, retry = I2C_RW_RETRY_COUNT;
 
 	while (retry) {
@@ -759,7 +823,25 @@ abort:
 
 abort:
 	return status;
-#endif
+}
+
+static ssize_t sfp_eeprom_read(struct i2c_client *client, u8 command, u8 *data,
+			  int data_len)
+{
+	ssize_t status;
+
+	if (!sfp_use_block(client, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+		return sfp_eeprom_read_byte(client, command, data);
+	}
+
+	status = sfp_eeprom_read_block(client, command, data, data_len);
+	if (status >= 0 || status == -ENXIO) {
+		return status;
+	}
+
+	/* The block transfer was rejected, redo this one byte by byte */
+	dev_dbg(&client->dev, "sfp block read failed, command(0x%2x), status(%d), fall back to byte read\r\n", command, (int)status);
+	return sfp_eeprom_read_byte(client, command, data);
 }
 
 #if (MULTIPAGE_SUPPORT == 1)
@@ -813,7 +895,7 @@ static uint8_t sff_8436_translate_offset(struct sfp_port_data *port_data,
 	return page;  /* note also returning client and offset */
 }
 
-static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
+static ssize_t sff_8436_eeprom_do_read(struct sfp_port_data *port_data,
 		    struct i2c_client *client,
 		    char *buf, unsigned offset, size_t count)
 {
@@ -902,6 +984,9 @@ static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
 		if (status == -ENXIO) /* no module present */
 			return status;
 
+		if (status == -EOPNOTSUPP || status == -EPROTO)
+			return status; /* transfer type rejected */
+
 		/* REVISIT: at HZ=100, this is sloooow */
 		msleep(1);
 	} while (time_before(read_time, timeout));
@@ -909,6 +994,52 @@ static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
 	return -ETIMEDOUT;
 }
 
+/*
+ * Step down to the next transfer type the adapter offers once the current
+ * one is rejected, the port keeps using it from then on.
+ */
+static int sff_8436_read_fallback(struct sfp_port_data *port_data,
+				  struct i2c_client *client)
+{
+	int use_smbus;
+
+	switch (port_data->use_smbus) {
+	case 0:
+		if (i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK)) {
+			use_smbus = I2C_SMBUS_I2C_BLOCK_DATA;
+			break;
+		}
+		/* fall through */
+	case I2C_SMBUS_I2C_BLOCK_DATA:
+		if (i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA)) {
+			use_smbus = I2C_SMBUS_BYTE_DATA;
+			break;
+		}
+		/* fall through */
+	default:
+		return 0;
+	}
+
+	dev_notice(&client->dev, "Transfer rejected, falling back to %s reads\n",
+		   use_smbus == I2C_SMBUS_I2C_BLOCK_DATA ? "block" : "byte");
+	port_data->use_smbus = use_smbus;
+	return 1;
+}
+
+static ssize_t sff_8436_eeprom_read(struct sfp_port_data *port_data,
+		    struct i2c_client *client,
+		    char *buf, unsigned offset, size_t count)
+{
+	ssize_t status;
+
+	do {
+		status = sff_8436_eeprom_do_read(port_data, client, buf, offset, count);
+	} while ((status == -EOPNOTSUPP || status == -EPROTO) &&
+		 sff_8436_read_fallback(port_data, client));
+
+	return status;
+}
+
 static ssize_t sff_8436_eeprom_write(struct sfp_port_data *port_data,
 		    		struct i2c_client *client,
 				const char *buf,
@@ -1188,7 +1319,28 @@ static ssize_t sfp_port_read_write(struct sfp_port_data *port_data,
 	 */
 	pending_len = len; /* amount remaining to transfer */
 	retval = 0;  /* amount transferred */
-	for (chunk = off >> 7; chunk <= (off + len - 1) >> 7; chunk++) {
+
+	/*
+	 * Lower and upper page 00h (A0h for SFP) need no page select,
+	 * move them in a single transfer rather than chunk by chunk.
+	 */
+	if (off < 2 * SFF_8436_PAGE_SIZE) {
+		chunk_len = min_t(size_t, pending_len, 2 * SFF_8436_PAGE_SIZE - off);
+		status = sff_8436_eeprom_update_client(port_data, buf,
+				off, chunk_len, opcode);
+		if (status != chunk_len) {
+			dev_dbg(&client->dev,
+	"sff_8436_update_client for page 0 off %lld chunk_len %ld failed %d!\n",
+				off, (long int) chunk_len, status);
+			goto err;
+		}
+		buf += status;
+		off += status;
+		pending_len -= status;
+		retval += status;
+	}
+
+	for (chunk = off >> 7; pending_len && chunk <= (off + pending_len - 1) >> 7; chunk++) {
 
 		/*
 		 * Compute the offset and number of bytes to be read/write
@@ -1291,10 +1443,25 @@ static ssize_t sfp_port_read(struct sfp_port_data *data,
 }
 #endif
 
+static ssize_t sfp_cache_fill(void *ctx, char *buf, loff_t off, size_t count)
+{
+	struct sfp_port_data *data = ctx;
+
+#if (MULTIPAGE_SUPPORT == 1)
+	return sfp_port_read_write(data, buf, off, count, QSFP_READ_OP);
+#else
+	return sfp_port_read(data, buf, off, count);
+#endif
+}
+
 static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 		struct bin_attribute *attr,
 		char *buf, loff_t off, size_t count)
 {
+	/* Control bytes are not cached, writes go straight to the module */
+	const unsigned int cache_ttl_ms[ACCTON_SFP_TTL_CLASSES] = {
+		[ACCTON_SFP_TTL_DOM] = dom_cache_ms,
+	};
 	int present;
 	struct sfp_port_data *data;
 	DEBUG_PRINT("offset = (%d), count = (%d)", off, count);
@@ -1310,11 +1477,8 @@ static ssize_t sfp_bin_read(struct file *filp, struct kobject *kobj,
 		return -ENODEV;
 	}
 
-#if (MULTIPAGE_SUPPORT == 1)
-	return sfp_port_read_write(data, buf, off, count, QSFP_READ_OP);
-#else
-	return sfp_port_read(data, buf, off, count);
-#endif
+	return accton_sfp_cache_read(&data->cache, READ_ONCE(sfp_present.gen[data->port]),
+								 buf, off, count, cache_ttl_ms, sfp_cache_fill, data);
 }
 
 #if (MULTIPAGE_SUPPORT == 1)
@@ -1355,11 +1519,8 @@ static int sfp_sysfs_eeprom_cleanup(struct kobject *kobj, struct bin_attribute *
 #if (MULTIPAGE_SUPPORT == 0)
 static int sfp_i2c_check_functionality(struct i2c_client *client)
 {
-#if USE_I2C_BLOCK_READ
-	return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_I2C_BLOCK);
-#else
+	/* Byte access is enough, block transfers are used when supported */
 	return i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA);
-#endif
 }
 #endif
 
@@ -1503,6 +1664,7 @@ static int sfp_device_probe(struct i2c_client *client,
 	data->port	 = dev_id->driver_data;
 	data->client = client;
 	data->driver_type = DRIVER_TYPE_QSFP;
+	accton_sfp_cache_init(&data->cache, QSFP_CACHE_STATIC_PAGES);
 
 	ret = qsfp_probe(client, dev_id, &data->qsfp);
 	if (ret < 0) {
@@ -1559,6 +1721,7 @@ static struct i2c_driver sfp_driver = {
 
 static int __init sfp_init(void)
 {
+	accton_sfp_present_init(&sfp_present);
 	return i2c_add_driver(&sfp_driver);
 }
 
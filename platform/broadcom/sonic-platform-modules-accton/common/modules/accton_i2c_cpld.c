@@ -35,6 +35,8 @@
 #include <linux/delay.h>
 #include <linux/list.h>
 #include <linux/printk.h>
+#include <linux/workqueue.h>
+#include <linux/interrupt.h>
 
 
 #define MAX_PORT_NUM				    64
@@ -56,6 +58,21 @@
 #define NAME_SIZE		24
 #define MAX_RESP_LENGTH	48
 
+#define PRESENT_BITMAP_NAME		"module_present_bitmap"
+#define PRESENT_SAFETY_POLL_MS	5000	/* with an interrupt line */
+
+/*
+ * module_present_bitmap is refreshed every present_poll_ms, or on the
+ * CPLD interrupt when the client has one, and notifies pollers on change.
+ */
+static unsigned int present_poll_ms = 500;
+module_param(present_poll_ms, uint, 0644);
+MODULE_PARM_DESC(present_poll_ms, "Presence poll interval in ms without an interrupt line, 0 to read on demand only");
+
+static bool present_block_read;
+module_param(present_block_read, bool, 0644);
+MODULE_PARM_DESC(present_block_read, "Read the presence registers in one SMBus block read, the CPLD must auto-increment");
+
 typedef ssize_t (*show_func)( struct device *dev,
                               struct device_attribute *attr,
                               char *buf);
@@ -124,6 +141,15 @@ struct cpld_data {
     u16  sfp_num;
     u8   sfp_types;
     struct model_attrs *cmn_attr;
+
+    /* module_present_bitmap */
+    bool present_bitmap;
+    int  present_reg;       /* first presence register */
+    u64  present;           /* 1: present, bit0:port1 and so on */
+    bool present_valid;
+    int  irq;
+    struct bin_attribute present_bin;
+    struct delayed_work  present_work;
 };
 
 struct cpld_client_node {
@@ -536,6 +562,157 @@ exit:
     return status;
 }
 
+/*
+ * Read all the presence registers under one lock, and notify the
+ * pollers of module_present_bitmap when the result differs.
+ */
+static int cpld_update_present(struct i2c_client *client, struct cpld_data *data)
+{
+    u8 regs[MAX_PORT_NUM/8];
+    int i, status = 0, num = (data->sfp_num + 7)/8;
+    u64 present = 0;
+    bool changed;
+
+    mutex_lock(&data->update_lock);
+    if (present_block_read &&
+        i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        status = i2c_smbus_read_i2c_block_data(client, data->present_reg, num, regs);
+    }
+
+    if (status != num) {
+        for (i = 0; i < num; i++) {
+            status = cpld_read_internal(client, data->present_reg + i);
+            if (unlikely(status < 0)) {
+                goto exit;
+            }
+            regs[i] = status;
+        }
+    }
+
+    /* The CPLD reports 0 for a present module */
+    for (i = 0; i < num; i++) {
+        present |= (u64)(u8)~regs[i] << (i*8);
+    }
+    if (data->sfp_num < MAX_PORT_NUM) {
+        present &= (1ULL << data->sfp_num) - 1;
+    }
+
+    changed = !data->present_valid || present != data->present;
+    data->present = present;
+    data->present_valid = true;
+    mutex_unlock(&data->update_lock);
+
+    if (changed) {
+        sysfs_notify(&client->dev.kobj, NULL, PRESENT_BITMAP_NAME);
+    }
+    return 0;
+
+exit:
+    mutex_unlock(&data->update_lock);
+    return status;
+}
+
+static ssize_t read_present_bitmap(struct file *filp, struct kobject *kobj,
+                                   struct bin_attribute *attr,
+                                   char *buf, loff_t off, size_t count)
+{
+    struct i2c_client *client = kobj_to_i2c_client(kobj);
+    struct cpld_data *data = i2c_get_clientdata(client);
+    __le64 value;
+    int status;
+
+    status = cpld_update_present(client, data);
+    if (status < 0) {
+        return status;
+    }
+
+    mutex_lock(&data->update_lock);
+    value = cpu_to_le64(data->present);
+    mutex_unlock(&data->update_lock);
+
+    return memory_read_from_buffer(buf, count, &off, &value, sizeof(value));
+}
+
+static void cpld_present_work(struct work_struct *work)
+{
+    struct cpld_data *data = container_of(to_delayed_work(work),
+                                          struct cpld_data, present_work);
+    unsigned int ms = (data->irq > 0) ? PRESENT_SAFETY_POLL_MS : present_poll_ms;
+
+    if (ms) {
+        cpld_update_present(to_i2c_client(data->dev), data);
+    }
+
+    /* Polling switched off, look again for the parameter later */
+    schedule_delayed_work(&data->present_work, msecs_to_jiffies(ms ? ms : 1000));
+}
+
+static irqreturn_t cpld_present_irq(int irq, void *dev_id)
+{
+    struct i2c_client *client = dev_id;
+
+    cpld_update_present(client, i2c_get_clientdata(client));
+    return IRQ_HANDLED;
+}
+
+static int cpld_present_init(struct i2c_client *client, struct cpld_data *data)
+{
+    struct attrs **cmn = data->cmn_attr->cmn;
+    int i, status;
+
+    data->present_reg = -1;
+    for (i = 0; cmn && cmn[i]; i++) {
+        if (cmn[i]->base == &common_attrs[CMN_PRESENT_ALL]) {
+            data->present_reg = cmn[i]->reg;
+        }
+    }
+
+    /* Only the models with their presence registers in a row */
+    if (data->present_reg < 0 || !data->sfp_num) {
+        return 0;
+    }
+
+    sysfs_bin_attr_init(&data->present_bin);
+    data->present_bin.attr.name = PRESENT_BITMAP_NAME;
+    data->present_bin.attr.mode = S_IRUGO;
+    data->present_bin.read = read_present_bitmap;
+    data->present_bin.size = sizeof(u64);
+
+    status = sysfs_create_bin_file(&client->dev.kobj, &data->present_bin);
+    if (status) {
+        return status;
+    }
+
+    INIT_DELAYED_WORK(&data->present_work, cpld_present_work);
+    if (client->irq > 0) {
+        status = request_threaded_irq(client->irq, NULL, cpld_present_irq,
+                                      IRQF_ONESHOT, client->name, client);
+        if (status) {
+            dev_warn(&client->dev, "irq %d unavailable (%d), polling presence\n",
+                     client->irq, status);
+        } else {
+            data->irq = client->irq;
+        }
+    }
+
+    data->present_bitmap = true;
+    schedule_delayed_work(&data->present_work, 0);
+    return 0;
+}
+
+static void cpld_present_cleanup(struct i2c_client *client, struct cpld_data *data)
+{
+    if (!data->present_bitmap) {
+        return;
+    }
+
+    if (data->irq > 0) {
+        free_irq(data->irq, client);
+    }
+    cancel_delayed_work_sync(&data->present_work);
+    sysfs_remove_bin_file(&client->dev.kobj, &data->present_bin);
+}
+
 static void accton_i2c_cpld_add_client(struct i2c_client *client)
 {
     struct cpld_client_node *node =
@@ -768,10 +945,15 @@ static int accton_i2c_cpld_probe(struct i2c_client *client,
         goto out_kfree;
     }
 
+    status = cpld_present_init(client, data);
+    if (status) {
+        goto exit_remove;
+    }
+
     data->hwmon_dev = hwmon_device_register(&client->dev);
     if (IS_ERR(data->hwmon_dev)) {
         status = PTR_ERR(data->hwmon_dev);
-        goto exit_remove;
+        goto exit_present;
     }
 
     accton_i2c_cpld_add_client(client);
@@ -779,6 +961,8 @@ static int accton_i2c_cpld_probe(struct i2c_client *client,
              dev_name(data->hwmon_dev), client->name);
 
     return 0;
+exit_present:
+    cpld_present_cleanup(client, data);
 exit_remove:
     sysfs_remove_group(&client->dev.kobj, &data->group);
 out_kfree:
@@ -792,6 +976,7 @@ static int accton_i2c_cpld_remove(struct i2c_client *client)
     struct cpld_data *data = i2c_get_clientdata(client);
 
     hwmon_device_unregister(data->hwmon_dev);
+    cpld_present_cleanup(client, data);
     sysfs_remove_group(&client->dev.kobj, &data->group);
     kfree(data->group.attrs);
     accton_i2c_cpld_remove_client(client);
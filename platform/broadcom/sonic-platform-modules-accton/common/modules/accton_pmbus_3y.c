@@ -31,6 +31,7 @@
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
 #include <linux/jiffies.h>
+#include <linux/workqueue.h>
 #include <linux/i2c/pmbus.h>
 #include "pmbus.h"
 
@@ -65,6 +66,18 @@ enum chips {
 
 #define PMBUS_NAME_SIZE		24
 
+/*
+ * The registers are refreshed by a background work every
+ * update_interval_ms, sysfs reads only return the cached values.
+ * 0 refreshes in the reader context once the values are a second old.
+ */
+static unsigned int update_interval_ms = 1000;
+module_param(update_interval_ms, uint, 0644);
+MODULE_PARM_DESC(update_interval_ms, "PSU register refresh interval in ms, 0 to refresh on read");
+
+/* The cache is reported stale after this many missed refreshes */
+#define PMBUS_STALE_INTERVALS	3
+
 struct pmbus_sensor {
     struct pmbus_sensor *next;
     char name[PMBUS_NAME_SIZE];	/* sysfs sensor name */
@@ -117,6 +130,8 @@ struct pmbus_data {
     struct mutex update_lock;
     bool valid;
     unsigned long last_updated;	/* in jiffies */
+    struct delayed_work update_work;
+    struct device_attribute stale_attr;
 
     /*
      * A single status register covers multiple attributes,
@@ -264,57 +279,97 @@ void _pmbus_clear_faults(struct i2c_client *client)
     for (i = 0; i < data->info->pages; i++)
         pmbus_clear_fault_page(client, i);
 }
-static struct pmbus_data *pmbus_update_device(struct device *dev)
+
+/* Read all status and sensor registers, update_lock must be held */
+static void pmbus_update_regs(struct i2c_client *client, struct pmbus_data *data)
 {
-    struct i2c_client *client = to_i2c_client(dev->parent);
-    struct pmbus_data *data = i2c_get_clientdata(client);
     const struct pmbus_driver_info *info = data->info;
     struct pmbus_sensor *sensor;
+    int i, j;
 
-    mutex_lock(&data->update_lock);
-    if (time_after(jiffies, data->last_updated + HZ) || !data->valid) {
-        int i, j;
+    for (i = 0; i < info->pages; i++) {
+        data->status[PB_STATUS_BASE + i]
+            = _pmbus_read_byte_data(client, i,
+                                    data->status_register);
+        for (j = 0; j < ARRAY_SIZE(pmbus_status); j++) {
+            struct _pmbus_status *s = &pmbus_status[j];
 
-        for (i = 0; i < info->pages; i++) {
-            data->status[PB_STATUS_BASE + i]
+            if (!(info->func[i] & s->func))
+                continue;
+            data->status[s->base + i]
                 = _pmbus_read_byte_data(client, i,
-                                        data->status_register);
-            for (j = 0; j < ARRAY_SIZE(pmbus_status); j++) {
-                struct _pmbus_status *s = &pmbus_status[j];
-
-                if (!(info->func[i] & s->func))
-                    continue;
-                data->status[s->base + i]
-                    = _pmbus_read_byte_data(client, i,
-                                            s->reg);
-            }
+                                        s->reg);
         }
+    }
 
-        if (info->func[0] & PMBUS_HAVE_STATUS_INPUT)
-            data->status[PB_STATUS_INPUT_BASE]
-                = _pmbus_read_byte_data(client, 0,
-                                        PMBUS_STATUS_INPUT);
-
-        if (info->func[0] & PMBUS_HAVE_STATUS_VMON)
-            data->status[PB_STATUS_VMON_BASE]
-                = _pmbus_read_byte_data(client, 0,
-                                        PMBUS_VIRT_STATUS_VMON);
-
-        for (sensor = data->sensors; sensor; sensor = sensor->next) {
-            if (!data->valid || sensor->update)
-                sensor->data
-                    = _pmbus_read_word_data(client,
-                                            sensor->page,
-                                            sensor->reg);
-        }
-        _pmbus_clear_faults(client);
-        data->last_updated = jiffies;
-        data->valid = 1;
+    if (info->func[0] & PMBUS_HAVE_STATUS_INPUT)
+        data->status[PB_STATUS_INPUT_BASE]
+            = _pmbus_read_byte_data(client, 0,
+                                    PMBUS_STATUS_INPUT);
+
+    if (info->func[0] & PMBUS_HAVE_STATUS_VMON)
+        data->status[PB_STATUS_VMON_BASE]
+            = _pmbus_read_byte_data(client, 0,
+                                    PMBUS_VIRT_STATUS_VMON);
+
+    for (sensor = data->sensors; sensor; sensor = sensor->next) {
+        if (!data->valid || sensor->update)
+            sensor->data
+                = _pmbus_read_word_data(client,
+                                        sensor->page,
+                                        sensor->reg);
+    }
+    _pmbus_clear_faults(client);
+    data->last_updated = jiffies;
+    data->valid = 1;
+}
+
+static void pmbus_update_work(struct work_struct *work)
+{
+    struct pmbus_data *data = container_of(to_delayed_work(work),
+                                           struct pmbus_data, update_work);
+    unsigned int interval = update_interval_ms;
+
+    if (interval) {
+        mutex_lock(&data->update_lock);
+        pmbus_update_regs(to_i2c_client(data->dev), data);
+        mutex_unlock(&data->update_lock);
     }
+
+    /* With on-read refresh, look again for the parameter later */
+    schedule_delayed_work(&data->update_work,
+                          msecs_to_jiffies(interval ? interval : 1000));
+}
+
+static struct pmbus_data *pmbus_update_device(struct device *dev)
+{
+    struct i2c_client *client = to_i2c_client(dev->parent);
+    struct pmbus_data *data = i2c_get_clientdata(client);
+
+    /* Served from the cache once the first refresh is done */
+    if (update_interval_ms && data->valid)
+        return data;
+
+    mutex_lock(&data->update_lock);
+    if (time_after(jiffies, data->last_updated + HZ) || !data->valid)
+        pmbus_update_regs(client, data);
     mutex_unlock(&data->update_lock);
     return data;
 }
 
+static ssize_t pmbus_show_stale(struct device *dev,
+                                struct device_attribute *da, char *buf)
+{
+    struct i2c_client *client = to_i2c_client(dev->parent);
+    struct pmbus_data *data = i2c_get_clientdata(client);
+    unsigned long age = msecs_to_jiffies(max(update_interval_ms, 1000U));
+    int stale;
+
+    stale = !data->valid ||
+            time_after(jiffies, data->last_updated + PMBUS_STALE_INTERVALS * age);
+    return snprintf(buf, PAGE_SIZE, "%d\n", stale);
+}
+
 /*
  * Convert linear sensor values to milli- or micro-units
  * depending on sensor type.
@@ -1733,6 +1788,12 @@ int _pmbus_do_probe(struct i2c_client *client, const struct i2c_device_id *id,
         goto out_kfree;
     }
 
+    pmbus_dev_attr_init(&data->stale_attr, "stale", S_IRUGO,
+                        pmbus_show_stale, NULL);
+    ret = pmbus_add_attribute(data, &data->stale_attr.attr);
+    if (ret)
+        goto out_kfree;
+
     data->groups[0] = &data->group;
     data->hwmon_dev = hwmon_device_register_with_groups(dev, client->name,
                       data, data->groups);
@@ -1741,6 +1802,9 @@ int _pmbus_do_probe(struct i2c_client *client, const struct i2c_device_id *id,
         dev_err(dev, "Failed to register hwmon device\n");
         goto out_kfree;
     }
+
+    INIT_DELAYED_WORK(&data->update_work, pmbus_update_work);
+    schedule_delayed_work(&data->update_work, 0);
     return 0;
 
 out_kfree:
@@ -1954,6 +2018,7 @@ static int pmbus_probe(struct i2c_client *client,
 int _pmbus_do_remove(struct i2c_client *client)
 {
     struct pmbus_data *data = i2c_get_clientdata(client);
+    cancel_delayed_work_sync(&data->update_work);
     hwmon_device_unregister(data->hwmon_dev);
     kfree(data->group.attrs);
     return 0;
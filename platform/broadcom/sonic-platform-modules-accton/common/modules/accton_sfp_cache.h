@@ -0,0 +1,328 @@
+/*
+ * EEPROM page cache and presence bitmap shared by the Accton SFP drivers
+ *
+ * The cache serves the eeprom binary attribute in the usual optoe layout:
+ * lower page at 0-127, upper page 00h at 128-255 and upper page n at
+ * 128 * (n + 1). accton_sfp_paged_read() turns such an offset into
+ * SFF-8636/CMIS page select and I2C reads, so a driver only provides the
+ * raw accessors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef ACCTON_SFP_CACHE_H
+#define ACCTON_SFP_CACHE_H
+
+#include <linux/jiffies.h>
+#include <linux/bitops.h>
+#include <linux/string.h>
+#include <linux/mutex.h>
+#include <linux/i2c.h>
+
+#define ACCTON_SFP_CACHE_PAGE_SIZE	128
+#define ACCTON_SFP_CACHE_PAGES		5	/* lower page + upper pages 00h..03h */
+#define ACCTON_SFP_PRESENT_MAX		64
+#define ACCTON_SFP_PAGE_SELECT_REG	0x7f	/* SFF-8636 and CMIS */
+
+/*
+ * How long a cached page stays valid. Static pages are kept until the
+ * module is replaced, the others for the ttl given per class to
+ * accton_sfp_cache_read(); a ttl of 0 disables caching of the class.
+ */
+enum accton_sfp_ttl_class {
+	ACCTON_SFP_TTL_STATIC,		/* ID, vendor data and thresholds */
+	ACCTON_SFP_TTL_DOM,			/* monitors and status flags */
+	ACCTON_SFP_TTL_CONTROL,		/* control bytes the host writes */
+	ACCTON_SFP_TTL_CLASSES
+};
+
+/*
+ * Presence of all ports, read in one go and shared by every port client.
+ * gen[port] moves each time the port's presence bit flips, the page
+ * caches compare it to drop whatever they hold for a removed module.
+ */
+struct accton_sfp_present {
+	struct mutex	lock;
+	char			valid;			/* !=0 if bitmap is valid */
+	unsigned long	last_updated;	/* In jiffies */
+	u64				bitmap;			/* raw CPLD bits, bit0:port0 and so on */
+	unsigned int	gen[ACCTON_SFP_PRESENT_MAX];
+};
+
+/*
+ * Cached 128 byte pages of one port, laid out as the eeprom file is.
+ * Each page belongs to a ttl class, see enum accton_sfp_ttl_class.
+ */
+struct accton_sfp_cache {
+	struct mutex	lock;
+	unsigned long	valid;			/* bit n: page n is cached */
+	u8				ttl_class[ACCTON_SFP_CACHE_PAGES];
+	unsigned int	gen;			/* accton_sfp_present.gen[] when filled */
+	unsigned long	updated[ACCTON_SFP_CACHE_PAGES];	/* In jiffies */
+	u8				data[ACCTON_SFP_CACHE_PAGES * ACCTON_SFP_CACHE_PAGE_SIZE];
+};
+
+typedef int (*accton_sfp_present_read_fn)(u64 *bitmap);
+typedef ssize_t (*accton_sfp_fill_fn)(void *ctx, char *buf, loff_t off, size_t count);
+
+/* Raw accessors of one port for accton_sfp_paged_read() */
+struct accton_sfp_page_ops {
+	/* Read up to count bytes at offset 0-255 of the selected page */
+	ssize_t (*read)(void *ctx, u8 *buf, unsigned int offset, size_t count);
+	/* Write the page select register */
+	int (*select_page)(void *ctx, u8 page);
+};
+
+static inline void accton_sfp_present_init(struct accton_sfp_present *p)
+{
+	memset(p, 0, sizeof(*p));
+	mutex_init(&p->lock);
+}
+
+/*
+ * Refresh the bitmap unless it is younger than max_age_ms.
+ * Returns 0 or the error of read().
+ */
+static inline int accton_sfp_present_update(struct accton_sfp_present *p,
+				accton_sfp_present_read_fn read, unsigned int max_age_ms)
+{
+	u64 bitmap, changed;
+	int i, status = 0;
+
+	mutex_lock(&p->lock);
+	if (p->valid && time_before(jiffies, p->last_updated + msecs_to_jiffies(max_age_ms))) {
+		goto exit;
+	}
+
+	status = read(&bitmap);
+	if (status < 0) {
+		goto exit;
+	}
+
+	changed = p->valid ? (p->bitmap ^ bitmap) : ~0ULL;
+	for (i = 0; changed && i < ACCTON_SFP_PRESENT_MAX; i++, changed >>= 1) {
+		if (changed & 1) {
+			p->gen[i]++;
+		}
+	}
+
+	p->bitmap = bitmap;
+	p->last_updated = jiffies;
+	p->valid = 1;
+
+exit:
+	mutex_unlock(&p->lock);
+	return status;
+}
+
+/* Pages in static_mask are ACCTON_SFP_TTL_STATIC, the others ACCTON_SFP_TTL_DOM */
+static inline void accton_sfp_cache_init(struct accton_sfp_cache *c, unsigned long static_mask)
+{
+	int page;
+
+	memset(c, 0, sizeof(*c));
+	mutex_init(&c->lock);
+	for (page = 0; page < ACCTON_SFP_CACHE_PAGES; page++) {
+		c->ttl_class[page] = (static_mask & BIT(page)) ? ACCTON_SFP_TTL_STATIC : ACCTON_SFP_TTL_DOM;
+	}
+}
+
+static inline void accton_sfp_cache_set_class(struct accton_sfp_cache *c, int page,
+				enum accton_sfp_ttl_class ttl_class)
+{
+	mutex_lock(&c->lock);
+	c->ttl_class[page] = ttl_class;
+	clear_bit(page, &c->valid);
+	mutex_unlock(&c->lock);
+}
+
+static inline void accton_sfp_cache_invalidate(struct accton_sfp_cache *c)
+{
+	mutex_lock(&c->lock);
+	c->valid = 0;
+	mutex_unlock(&c->lock);
+}
+
+static inline int accton_sfp_cache_fresh(struct accton_sfp_cache *c, int page,
+				const unsigned int *ttl_ms)
+{
+	unsigned int ms;
+
+	if (!test_bit(page, &c->valid)) {
+		return 0;
+	}
+
+	if (c->ttl_class[page] == ACCTON_SFP_TTL_STATIC) {
+		return 1;
+	}
+
+	ms = ttl_ms[c->ttl_class[page]];
+	return ms && time_before(jiffies, c->updated[page] + msecs_to_jiffies(ms));
+}
+
+/*
+ * Serve a read from the cache. The stale pages of the request are
+ * refilled by a single fill() call covering all of them. Anything past
+ * the cached pages, or a refill that fails, goes straight to fill().
+ * gen is the present generation of the port, see accton_sfp_present.
+ * ttl_ms holds the ttl of each class, indexed by enum accton_sfp_ttl_class.
+ */
+static inline ssize_t accton_sfp_cache_read(struct accton_sfp_cache *c, unsigned int gen,
+				char *buf, loff_t off, size_t count, const unsigned int *ttl_ms,
+				accton_sfp_fill_fn fill, void *ctx)
+{
+	int page, first, last, miss = -1, hi = -1;
+	ssize_t status;
+
+	if (!count || off < 0 || off + count > sizeof(c->data)) {
+		return fill(ctx, buf, off, count);
+	}
+
+	first = off / ACCTON_SFP_CACHE_PAGE_SIZE;
+	last = (off + count - 1) / ACCTON_SFP_CACHE_PAGE_SIZE;
+
+	mutex_lock(&c->lock);
+	if (c->gen != gen) {
+		c->valid = 0;
+		c->gen = gen;
+	}
+
+	for (page = first; page <= last; page++) {
+		if (!accton_sfp_cache_fresh(c, page, ttl_ms)) {
+			if (miss < 0) {
+				miss = page;
+			}
+			hi = page;
+		}
+	}
+
+	if (miss >= 0) {
+		size_t len = (hi - miss + 1) * ACCTON_SFP_CACHE_PAGE_SIZE;
+
+		status = fill(ctx, c->data + miss * ACCTON_SFP_CACHE_PAGE_SIZE,
+					  miss * ACCTON_SFP_CACHE_PAGE_SIZE, len);
+		for (page = miss; status > 0 && page <= hi; page++) {
+			if (status < (page - miss + 1) * ACCTON_SFP_CACHE_PAGE_SIZE) {
+				break;
+			}
+			set_bit(page, &c->valid);
+			c->updated[page] = jiffies;
+		}
+
+		if (page <= hi) {
+			/* Short or failed refill, leave this request to the bus */
+			mutex_unlock(&c->lock);
+			return fill(ctx, buf, off, count);
+		}
+	}
+
+	memcpy(buf, c->data + off, count);
+	mutex_unlock(&c->lock);
+	return count;
+}
+
+/*
+ * Read at an eeprom file offset, selecting the upper page as needed.
+ * A request spanning several pages selects each of them in turn, and
+ * page 0 is selected again before returning. Returns the number of
+ * bytes read, or the error of the first access.
+ */
+static inline ssize_t accton_sfp_paged_read(const struct accton_sfp_page_ops *ops, void *ctx,
+				char *buf, loff_t off, size_t count)
+{
+	ssize_t status, retval = 0;
+	unsigned int offset, page, selected = 0;
+
+	while (count) {
+		size_t len;
+
+		if (off < ACCTON_SFP_CACHE_PAGE_SIZE * 2) {
+			page = 0;
+			offset = off;
+			len = min_t(size_t, count, ACCTON_SFP_CACHE_PAGE_SIZE * 2 - off);
+		} else {
+			page = (off >> 7) - 1;
+			offset = ACCTON_SFP_CACHE_PAGE_SIZE + (off & 0x7f);
+			len = min_t(size_t, count, ACCTON_SFP_CACHE_PAGE_SIZE * 2 - offset);
+		}
+
+		if (page > 0xff) {
+			break;
+		}
+
+		if (page != selected) {
+			status = ops->select_page(ctx, page);
+			if (status < 0) {
+				if (!retval) {
+					retval = status;
+				}
+				break;
+			}
+			selected = page;
+		}
+
+		status = ops->read(ctx, buf, offset, len);
+		if (status <= 0) {
+			if (!retval) {
+				retval = status;
+			}
+			break;
+		}
+
+		buf += status;
+		off += status;
+		count -= status;
+		retval += status;
+	}
+
+	if (selected) {
+		status = ops->select_page(ctx, 0);
+		if (status < 0) {
+			return status;
+		}
+	}
+
+	return retval;
+}
+
+/*
+ * Read up to count bytes with one SMBus block read, or one byte when the
+ * adapter cannot. *use_block is cleared the first time the adapter
+ * rejects a block read, so the port keeps using byte reads.
+ */
+static inline ssize_t accton_sfp_i2c_read(struct i2c_client *client, bool *use_block,
+				u8 *buf, unsigned int offset, size_t count)
+{
+	int status;
+
+	if (*use_block) {
+		status = i2c_smbus_read_i2c_block_data(client, offset,
+					min_t(size_t, count, I2C_SMBUS_BLOCK_MAX), buf);
+		if (status != -EOPNOTSUPP && status != -EPROTO) {
+			return status;
+		}
+		*use_block = false;
+	}
+
+	status = i2c_smbus_read_byte_data(client, offset);
+	if (status < 0) {
+		return status;
+	}
+
+	buf[0] = status;
+	return 1;
+}
+
+#endif /* ACCTON_SFP_CACHE_H */
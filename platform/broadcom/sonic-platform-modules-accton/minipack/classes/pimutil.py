@@ -32,6 +32,7 @@ try:
     from tabulate import tabulate
     import fbfpgaio
     import re
+    import struct
     import time
     from select import select
     #from ctypes import fbfpgaio 
@@ -126,6 +127,19 @@ mdio_read_cmd = 0x1
 mdio_write_cmd = 0x0
 mdio_device_type = 0x1F
 
+# DOM registers of each PIM read together into the PimUtil snapshot
+snapshot_regs = ["revision", "qsfp_present", "qsfp_lp_mode", "device_power_bad_status"]
+
+# Presence and interrupt of the 16 QSFPs of a PIM unmasked
+qsfp_intr_mask = 0xffff0000
+
+# UIO device of the minipack_fpga_intr driver
+UIO_CLASS_DIR = "/sys/class/uio"
+UIO_INTR_NAME = "minipack_fpga_intr"
+
+# Longest wait for the FPGA interrupt before the status is read anyway
+QSFP_INTR_POLL = 10
+
 
 #fbfpgaio=cdll.LoadLibrary('./fbfpgaio.so')
 
@@ -144,6 +158,27 @@ def fpga_io(offset, data=None):
     fbfpgaio.hw_io(offset, data)
     return
 
+def fpga_io_bulk(offsets):
+  if hasattr(fbfpgaio, "hw_io_bulk"):
+    return fbfpgaio.hw_io_bulk(offsets)
+  return [fbfpgaio.hw_io(offset) for offset in offsets]
+
+def fpga_read_block(base, count):
+  if hasattr(fbfpgaio, "hw_read_block"):
+    return fbfpgaio.hw_read_block(base, count)
+  return [fbfpgaio.hw_io(base + 4 * idx) for idx in range(count)]
+
+def open_fpga_intr():
+  for uio in sorted(os.listdir(UIO_CLASS_DIR)) if os.path.isdir(UIO_CLASS_DIR) else []:
+    try:
+      with open(os.path.join(UIO_CLASS_DIR, uio, "name")) as f:
+        if f.read().strip() != UIO_INTR_NAME:
+          continue
+      return os.open(os.path.join("/dev", uio), os.O_RDWR)
+    except (IOError, OSError):
+      continue
+  return None
+
 def pim_io(pim, offset, data=None):
   global dom_base
   target_offset = dom_base[pim]+offset
@@ -172,9 +207,9 @@ def show_pim_present():
   print(status_str)
 
 def show_qsfp_present_status(pim_num):
-     status = fpga_io(dom_base[pim_num]+dom["qsfp_present"])
-     interrupt = fpga_io(dom_base[pim_num]+dom["qsfp_present_intr"])
-     mask = fpga_io(dom_base[pim_num]+dom["qsfp_present_intr_mask"])
+     # 0x48 to 0x58 in one read
+     regs = fpga_read_block(dom_base[pim_num]+dom["qsfp_present"], 5)
+     status, interrupt, mask = regs[0], regs[2], regs[4]
 
      print
      print("    (0x48)      (0x50)      (0x58)")
@@ -203,14 +238,49 @@ class PimUtil(object):
     PORT_START = 0
     PORT_END = 127
 
+    # Status queries within this many seconds share one FPGA read
+    SNAPSHOT_HOLD = 0.5
+
     def __init__(self):
         self.value=1        
+        self._snapshot = None
+        self._snapshot_time = 0
+        self._intr_fd = None
+
+    def _get_snapshot(self):
+        """
+        Returns the PIM status register and the snapshot_regs of the eight
+        PIMs, read in one call at most once per SNAPSHOT_HOLD seconds
+        """
+        now = time.time()
+        if self._snapshot is None or not 0 <= now - self._snapshot_time < self.SNAPSHOT_HOLD:
+            offsets = [iob["pim_status"]]
+            for pim in range(1, 9):
+                offsets += [dom_base[pim] + dom[reg] for reg in snapshot_regs]
+            values = fpga_io_bulk(offsets)
+            self._snapshot = {"pim_status": values[0]}
+            for pim in range(1, 9):
+                first = 1 + (pim - 1) * len(snapshot_regs)
+                for idx, reg in enumerate(snapshot_regs):
+                    self._snapshot[(pim, reg)] = values[first + idx]
+            self._snapshot_time = now
+        return self._snapshot
+
+    #pim is the dom_base index, from 1 to 8
+    def _get_pim_reg(self, pim, reg):
+        return self._get_snapshot()[(pim, reg)]
+
+    def invalidate_snapshot(self):
+        self._snapshot = None
 
     def __del__(self):
         self.value=0
+        if self._intr_fd is not None:
+            os.close(self._intr_fd)
         
     def init_pim_fpga(self):
         init_resources()    
+        self.init_qsfp_interrupt()
     
     def release_pim_fpga(self):
         release_resources()
@@ -232,7 +302,7 @@ class PimUtil(object):
     def get_pim_presence(self, pim_num):
         if pim_num <0 or pim_num > 7:
             return 0
-        pim_status = fpga_io(iob["pim_status"])
+        pim_status = self._get_snapshot()["pim_status"]
         status = pim_status & (0x10000 << pim_num)
         if status:
             return 1 #present
@@ -243,7 +313,7 @@ class PimUtil(object):
     def get_pim_board_id(self, pim_num):
         if pim_num <0 or pim_num > 7:
             return False
-        board_id = fpga_io(dom_base[pim_num+1]+dom["revision"])
+        board_id = self._get_pim_reg(pim_num+1, "revision")
         board_id = board_id & 0x1
         if board_id==0x0:
             return 0
@@ -256,7 +326,7 @@ class PimUtil(object):
             return 0xFF
         power_status =0
         #device_power_bad_status
-        status=fpga_io(dom_base[pim_num+1]+dom["device_power_bad_status"])
+        status=self._get_pim_reg(pim_num+1, "device_power_bad_status")
         
         for x in range(0, 5):
             if status & ( (0xf) << (4*x) ) :
@@ -350,16 +420,15 @@ class PimUtil(object):
             if change_status:
                 new_pim_status = pim_status | new_pim_status #Write one to clear interrupt bit
                 fpga_io(iob["pim_status"], new_pim_status)
+                self.invalidate_snapshot()
                 return True, pim_dict
             if forever:
-                time.sleep(1)
+                self.wait_qsfp_interrupt()
             else:
                 timeout = end_time - time.time()
-                if timeout >= 1:
-                    time.sleep(1) # We poll at 1 second granularity
+                if timeout > 0:
+                    self.wait_qsfp_interrupt(timeout)
                 else:
-                    if timeout > 0:
-                        time.sleep(timeout)
                     return True, {}
         print "get_evt_change_event: Should not reach here."
         return False, {}
@@ -404,7 +473,7 @@ class PimUtil(object):
          if status==0:
             return False
          else:
-            present = fpga_io(dom_base[pim_num]+dom["qsfp_present"])
+            present = self._get_pim_reg(pim_num, "qsfp_present")
          status, shift = self.get_onepimport_by_port(port_num)
          if status==0:
              return False
@@ -421,7 +490,7 @@ class PimUtil(object):
         if status==0:
             return False
         else:
-            lp_mode = fpga_io(dom_base[pim_num]+dom["qsfp_lp_mode"])
+            lp_mode = self._get_pim_reg(pim_num, "qsfp_lp_mode")
         
         status, shift=self.get_onepimport_by_port(port_num)
         if status==0:
@@ -447,18 +516,33 @@ class PimUtil(object):
             else:
                 new_val=val|(0x1 << shift)
         status=fpga_io(dom_base[pim_num]+dom["qsfp_lp_mode"], new_val)
+        self.invalidate_snapshot()
         return status
     
+    #pim_num start from 0 to 7
+    def init_qsfp_interrupt(self, pim_num=None):
+        pims = range(0, 8) if pim_num is None else [pim_num]
+        for pim_num in pims:
+            fpga_io(dom_base[pim_num+1]+dom["qsfp_present_intr_mask"], qsfp_intr_mask)
+            fpga_io(dom_base[pim_num+1]+dom["qsfp_intr_mask"], qsfp_intr_mask)
+
     #port_dict[idx]=1 means get interrupt(change evt), port_dict[idx]=0 means no get interrupt
     def get_qsfp_interrupt(self):
         port_dict={}
         #show_qsfp_present_status(1)
+        offsets = []
+        for pim_num in range(0, 8):
+            base = dom_base[pim_num+1]
+            offsets += [base+dom["qsfp_present_intr"], base+dom["qsfp_present_intr_mask"], base+dom["qsfp_intr_mask"]]
+        regs = fpga_io_bulk(offsets)
+        intr_status = regs[0::3]
         for pim_num in range(0, 8):
-            fpga_io(dom_base[pim_num+1]+dom["qsfp_present_intr_mask"], 0xffff0000)
-            fpga_io(dom_base[pim_num+1]+dom["qsfp_intr_mask"], 0xffff0000)
+            #The masks are programmed at init, a re-inserted PIM comes up with its defaults
+            if regs[pim_num*3+1] != qsfp_intr_mask or regs[pim_num*3+2] != qsfp_intr_mask:
+                self.init_qsfp_interrupt(pim_num)
         for pim_num in range(0, 8):            
             clear_bit=0            
-            qsfp_present_intr_status = fpga_io(dom_base[pim_num+1]+dom["qsfp_present_intr"])
+            qsfp_present_intr_status = intr_status[pim_num]
             interrupt_status = qsfp_present_intr_status & 0xffff
             #time.sleep(2)            
             if interrupt_status:
@@ -472,8 +556,37 @@ class PimUtil(object):
                 
                 #W1C to clear
                 fpga_io(dom_base[pim_num+1]+dom["qsfp_present_intr"], qsfp_present_intr_status | clear_bit) 
+                #Presence changed, read it again on the next query
+                self.invalidate_snapshot()
                 
         return port_dict
+
+    def wait_qsfp_interrupt(self, timeout=None):
+        """
+        Blocks until the FPGA interrupts, for at most timeout seconds and
+        QSFP_INTR_POLL seconds. Without the minipack_fpga_intr driver it
+        sleeps a second, the granularity the status used to be polled at.
+        Returns True when the FPGA interrupted
+        """
+        if self._intr_fd is None:
+            self._intr_fd = open_fpga_intr()
+        if self._intr_fd is None:
+            time.sleep(1 if timeout is None else min(timeout, 1))
+            return False
+
+        if timeout is None or timeout > QSFP_INTR_POLL:
+            timeout = QSFP_INTR_POLL
+        try:
+            #Unmask the interrupt, the handler masked it when it fired
+            os.write(self._intr_fd, struct.pack("I", 1))
+            readable, _, _ = select([self._intr_fd], [], [], timeout)
+            if readable:
+                os.read(self._intr_fd, 4)
+                return True
+        except (IOError, OSError):
+            os.close(self._intr_fd)
+            self._intr_fd = None
+        return False
         
     def reset(self, port_num):
         status, pim=self.get_pim_by_port(port_num)
@@ -487,6 +600,7 @@ class PimUtil(object):
         else:               
             val = val & (~(0x1 << shift))
         fpga_io(dom_base[pim]+dom["qsfp_reset"], val)
+        self.invalidate_snapshot()
         return True
 
     #color:white(0), blue(1),red(2), orange(3),green(4)
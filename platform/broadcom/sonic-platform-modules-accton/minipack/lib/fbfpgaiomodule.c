@@ -102,10 +102,106 @@ static PyObject *fbfpgaio_hw_io(PyObject *self, PyObject *args)
   }
 }
 
+/* Check that a 32-bit register at offset is inside the mapped resource */
+static int fbfpgaio_check_offset(unsigned long offset)
+{
+  if ((io_base == NULL) || (io_base == MAP_FAILED)) {
+    PyErr_SetString(PyExc_IOError, "FPGA resource is not mapped");
+    return -1;
+  }
+  if ((offset & 0x3) || (offset > FPGA_RESOURCE_LENGTH - sizeof(unsigned int))) {
+    PyErr_Format(PyExc_ValueError, "invalid FPGA register offset 0x%lx", offset);
+    return -1;
+  }
+  return 0;
+}
+
+static PyObject *fbfpgaio_hw_io_bulk(PyObject *self, PyObject *args)
+{
+  PyObject *offsets, *seq, *values;
+  Py_ssize_t i, count;
+
+  if (!PyArg_ParseTuple(args, "O", &offsets)) {
+    return NULL;
+  }
+
+  seq = PySequence_Fast(offsets, "offsets must be a sequence");
+  if (seq == NULL) {
+    return NULL;
+  }
+
+  count = PySequence_Fast_GET_SIZE(seq);
+  values = PyList_New(count);
+  if (values == NULL) {
+    Py_DECREF(seq);
+    return NULL;
+  }
+
+  for (i = 0; i < count; i++) {
+    unsigned long offset = PyInt_AsUnsignedLongMask(PySequence_Fast_GET_ITEM(seq, i));
+    PyObject *value;
+
+    if (PyErr_Occurred() || (fbfpgaio_check_offset(offset) != 0)) {
+      Py_DECREF(values);
+      Py_DECREF(seq);
+      return NULL;
+    }
+
+    IDEBUG("Bulk read operation\n");
+    value = PyLong_FromUnsignedLong(*(volatile unsigned int *) ((unsigned long) io_base + offset));
+    if (value == NULL) {
+      Py_DECREF(values);
+      Py_DECREF(seq);
+      return NULL;
+    }
+    PyList_SET_ITEM(values, i, value);
+  }
+
+  Py_DECREF(seq);
+  return values;
+}
+
+static PyObject *fbfpgaio_hw_read_block(PyObject *self, PyObject *args)
+{
+  unsigned long base;
+  unsigned int count, i;
+  PyObject *values;
+
+  if (!PyArg_ParseTuple(args, "kI", &base, &count)) {
+    return NULL;
+  }
+
+  if ((fbfpgaio_check_offset(base) != 0) ||
+      ((count > 0) && (fbfpgaio_check_offset(base + (count - 1) * sizeof(unsigned int)) != 0))) {
+    return NULL;
+  }
+
+  values = PyList_New(count);
+  if (values == NULL) {
+    return NULL;
+  }
+
+  IDEBUG("Block read operation\n");
+  for (i = 0; i < count; i++) {
+    volatile unsigned int *address = (volatile unsigned int *) ((unsigned long) io_base + base) + i;
+    PyObject *value = PyLong_FromUnsignedLong(*address);
+
+    if (value == NULL) {
+      Py_DECREF(values);
+      return NULL;
+    }
+    PyList_SET_ITEM(values, i, value);
+  }
+
+  return values;
+}
+
 static PyMethodDef FbfpgaMethods[] = {
   { "hw_init", (PyCFunction) fbfpgaio_hw_init, METH_NOARGS, "Initialize resources for accessing FPGA" },
   { "hw_release", (PyCFunction) fbfpgaio_hw_release, METH_NOARGS, "Release resources for accessing FPGA" },
   { "hw_io", fbfpgaio_hw_io, METH_VARARGS, "Access FPGA" },
+  { "hw_io_bulk", fbfpgaio_hw_io_bulk, METH_VARARGS, "Read a list of FPGA registers" },
+  { "hw_read_block", fbfpgaio_hw_read_block, METH_VARARGS, "Read consecutive FPGA registers" },
   { NULL, NULL, 0, NULL },
 };
 
@@ -120,7 +216,11 @@ initfbfpgaio(void)
 3. hw_io(offset,[data])\n\
    return value:\n\
      In reading operation: data which is read from FPGA\n\
-     In writing operation: None\n";
+     In writing operation: None\n\
+4. hw_io_bulk(offsets)\n\
+   return value: list of the data read from FPGA at each offset\n\
+5. hw_read_block(base, count)\n\
+   return value: list of the data of count registers read from FPGA from base\n";
 
   (void) Py_InitModule3("fbfpgaio", FbfpgaMethods, docstr);
 }
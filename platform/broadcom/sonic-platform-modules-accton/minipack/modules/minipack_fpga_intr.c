@@ -0,0 +1,206 @@
+/*
+ * A UIO driver for the interrupt of the minipack IOB FPGA.
+ *
+ * Copyright (C) 2019 Accton Technology Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	 See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+/*
+ * The FPGA registers are accessed from user space through the resource0
+ * sysfs node (see fbfpgaio), so this driver only owns the interrupt.
+ * It exposes it as /dev/uioN: a read or select() on the node blocks until
+ * the FPGA interrupts, e.g. when the presence of a QSFP of a PIM changes.
+ * The handler masks the interrupt, and user space writes 1 to the node to
+ * unmask it again after it cleared the latched status in the FPGA.
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/pci.h>
+#include <linux/interrupt.h>
+#include <linux/spinlock.h>
+#include <linux/slab.h>
+#include <linux/uio_driver.h>
+
+#define DRVNAME "minipack_fpga_intr"
+#define DRV_VERSION "0.1"
+
+/* Location of the FPGA, the same as FPGA_RESOURCE_NODE of fbfpgaio */
+static unsigned int bus = 0x5;
+module_param(bus, uint, S_IRUGO);
+MODULE_PARM_DESC(bus, "PCI bus number of the IOB FPGA. Default is 5.");
+
+static unsigned int slot = 0x0;
+module_param(slot, uint, S_IRUGO);
+MODULE_PARM_DESC(slot, "PCI slot number of the IOB FPGA. Default is 0.");
+
+#define FPGA_INTR_DISABLED  0
+
+struct fpga_intr_data {
+    struct pci_dev  *pdev;
+    struct uio_info info;
+    spinlock_t      lock;
+    unsigned long   flags;
+};
+
+static irqreturn_t fpga_intr_handler(int irq, struct uio_info *info)
+{
+    struct fpga_intr_data *data = info->priv;
+
+    if (!data->pdev->msi_enabled) {
+        /* The INTx line may be shared, mask it in the FPGA config space */
+        if (!pci_check_and_mask_intx(data->pdev))
+            return IRQ_NONE;
+        return IRQ_HANDLED;
+    }
+
+    spin_lock(&data->lock);
+    if (!__test_and_set_bit(FPGA_INTR_DISABLED, &data->flags))
+        disable_irq_nosync(irq);
+    spin_unlock(&data->lock);
+
+    return IRQ_HANDLED;
+}
+
+static int fpga_intr_irqcontrol(struct uio_info *info, s32 irq_on)
+{
+    struct fpga_intr_data *data = info->priv;
+    unsigned long flags;
+
+    if (!data->pdev->msi_enabled) {
+        pci_intx(data->pdev, !!irq_on);
+        return 0;
+    }
+
+    spin_lock_irqsave(&data->lock, flags);
+    if (irq_on) {
+        if (__test_and_clear_bit(FPGA_INTR_DISABLED, &data->flags))
+            enable_irq(info->irq);
+    } else {
+        if (!__test_and_set_bit(FPGA_INTR_DISABLED, &data->flags))
+            disable_irq_nosync(info->irq);
+    }
+    spin_unlock_irqrestore(&data->lock, flags);
+
+    return 0;
+}
+
+static int fpga_intr_probe(struct pci_dev *pdev, const struct pci_device_id *id)
+{
+    struct fpga_intr_data *data;
+    int status;
+
+    if (pdev->bus->number != bus || pdev->devfn != PCI_DEVFN(slot, 0))
+        return -ENODEV;
+
+    data = kzalloc(sizeof(*data), GFP_KERNEL);
+    if (!data)
+        return -ENOMEM;
+
+    status = pci_enable_device(pdev);
+    if (status) {
+        dev_err(&pdev->dev, "Failed to enable device (%d)\n", status);
+        goto exit_free;
+    }
+
+    status = pci_alloc_irq_vectors(pdev, 1, 1, PCI_IRQ_MSI | PCI_IRQ_LEGACY);
+    if (status < 0) {
+        dev_err(&pdev->dev, "No interrupt available (%d)\n", status);
+        goto exit_disable;
+    }
+
+    data->pdev = pdev;
+    spin_lock_init(&data->lock);
+    data->info.name = DRVNAME;
+    data->info.version = DRV_VERSION;
+    data->info.irq = pci_irq_vector(pdev, 0);
+    data->info.irq_flags = pdev->msi_enabled ? 0 : IRQF_SHARED;
+    data->info.handler = fpga_intr_handler;
+    data->info.irqcontrol = fpga_intr_irqcontrol;
+    data->info.priv = data;
+
+    status = uio_register_device(&pdev->dev, &data->info);
+    if (status) {
+        dev_err(&pdev->dev, "Failed to register uio device (%d)\n", status);
+        goto exit_free_vectors;
+    }
+
+    pci_set_drvdata(pdev, data);
+    dev_info(&pdev->dev, "Interrupt %ld (%s) exposed to user space\n",
+             data->info.irq, pdev->msi_enabled ? "MSI" : "INTx");
+    return 0;
+
+exit_free_vectors:
+    pci_free_irq_vectors(pdev);
+exit_disable:
+    pci_disable_device(pdev);
+exit_free:
+    kfree(data);
+    return status;
+}
+
+static void fpga_intr_remove(struct pci_dev *pdev)
+{
+    struct fpga_intr_data *data = pci_get_drvdata(pdev);
+
+    uio_unregister_device(&data->info);
+    pci_free_irq_vectors(pdev);
+    pci_disable_device(pdev);
+    kfree(data);
+}
+
+static struct pci_driver fpga_intr_driver = {
+    .name     = DRVNAME,
+    .probe    = fpga_intr_probe,
+    .remove   = fpga_intr_remove,
+};
+
+static int __init fpga_intr_init(void)
+{
+    struct pci_dev *pdev;
+    int status;
+
+    /* Match the FPGA by its location, as fbfpgaio does */
+    pdev = pci_get_domain_bus_and_slot(0, bus, PCI_DEVFN(slot, 0));
+    if (!pdev) {
+        pr_err(DRVNAME ": No device at %02x:%02x.0\n", bus, slot);
+        return -ENODEV;
+    }
+
+    status = pci_register_driver(&fpga_intr_driver);
+    if (!status) {
+        status = pci_add_dynid(&fpga_intr_driver, pdev->vendor, pdev->device,
+                               PCI_ANY_ID, PCI_ANY_ID, 0, 0, 0);
+        if (status)
+            pci_unregister_driver(&fpga_intr_driver);
+    }
+
+    pci_dev_put(pdev);
+    return status;
+}
+
+static void __exit fpga_intr_exit(void)
+{
+    pci_unregister_driver(&fpga_intr_driver);
+}
+
+module_init(fpga_intr_init);
+module_exit(fpga_intr_exit);
+
+MODULE_AUTHOR("Accton Technology Corporation");
+MODULE_DESCRIPTION("minipack IOB FPGA interrupt driver");
+MODULE_VERSION(DRV_VERSION);
+MODULE_LICENSE("GPL");
@@ -194,7 +194,8 @@ kos = [
 'modprobe i2c_dev',
 'modprobe i2c_mux_pca954x force_deselect_on_exit=1',
 'modprobe optoe',
-'modprobe minipack_psensor']
+'modprobe minipack_psensor',
+'modprobe minipack_fpga_intr']
 
 def driver_install():
     for i in range(0,len(kos)):
@@ -33,6 +33,8 @@ try:
     import logging.handlers
     import types
     import time  # this is only being used as part of the example
+    import fcntl
+    import glob
     import traceback    
     from tabulate import tabulate    
     from minipack.pimutil import PimUtil
@@ -70,6 +72,14 @@ DEBUG = False
 PIM_MIN=0
 PIM_MAX=8
 
+I2C_SLAVE_FORCE = 0x0706
+QSFP_LINK_DIR = '/usr/local/bin/minipack_qsfp'
+#Time for the muxes of an inserted PIM to answer, polled every PCA_READY_INTERVAL
+PCA_READY_TIMEOUT = 20
+PCA_READY_INTERVAL = 0.05
+#Longest wait for a PIM presence change, failed setups are retried after it
+PIM_EVENT_TIMEOUT = 2000
+
 def my_log(txt):
     if DEBUG == True:
         print "[ACCTON DBG]: "+txt
@@ -84,6 +94,22 @@ def log_os_system(cmd):
         logging.info('Failed :'+cmd)
     return  status, output
 
+def sysfs_write(path, value):
+    logging.info('Write %s to %s', value, path)
+    try:
+        with open(path, 'w') as f:
+            f.write(value)
+    except (IOError, OSError) as e:
+        logging.info('Failed : %s', str(e))
+        return 1, str(e)
+    return 0, ""
+
+def i2c_new_device(bus, name, addr):
+    return sysfs_write("/sys/bus/i2c/devices/i2c-%d/new_device" % bus, "%s 0x%x" % (name, addr))
+
+def i2c_delete_device(bus, addr):
+    return sysfs_write("/sys/bus/i2c/devices/i2c-%d/delete_device" % bus, "0x%x" % addr)
+
 def qsfp_map_bus(idx):
     port = idx + 1
     base = ((port-1)/8*8) + 10
@@ -98,14 +124,11 @@ def qsfp_map_bus(idx):
     
 def pca9548_sysfs(i2c_bus, create):
     if create==1:        
-        cmdl = "echo pca9548 0x%x > /sys/bus/i2c/devices/i2c-%d/new_device"
+        status1, output = i2c_new_device(i2c_bus, "pca9548", 0x72)
+        status2, output = i2c_new_device(i2c_bus, "pca9548", 0x71)
     else:
-        cmdl = "echo 0x%x > /sys/bus/i2c/devices/i2c-%d/delete_device"    
-    
-    cmdm = cmdl % (0x72, i2c_bus)
-    status1, output =log_os_system(cmdm)    
-    cmdm = cmdl % (0x71, i2c_bus)
-    status2, output =log_os_system(cmdm)
+        status1, output = i2c_delete_device(i2c_bus, 0x72)
+        status2, output = i2c_delete_device(i2c_bus, 0x71)
     return (status1 | status2)
 
 
@@ -120,22 +143,23 @@ def qsfp_eeprom_sys(pim_idx, i2c_bus_order, create):
     for i in range(start_bus, end_bus):
         bus = qsfp_map_bus(i)
         if create==1:
-            status, output =log_os_system(
-                "echo optoe1 0x50 > /sys/bus/i2c/devices/i2c-"+str(bus)+"/new_device")
+            status, output = i2c_new_device(bus, "optoe1", 0x50)
             if status:
                 print output
                 return 1
-            status, output =log_os_system(
-                "echo port"+str(k+1)+" > /sys/bus/i2c/devices/"+str(bus)+"-0050/port_name")
+            status, output = sysfs_write(
+                "/sys/bus/i2c/devices/%d-0050/port_name" % bus, "port%d" % (k+1))
             
-            status, output =log_os_system(
-                "ln -s -f /sys/bus/i2c/devices/"+str(bus)+"-0050/eeprom" + " /usr/local/bin/minipack_qsfp/port" + str(k) + "_eeprom")
-            if status:
-                print output
+            link = "%s/port%d_eeprom" % (QSFP_LINK_DIR, k)
+            try:
+                if os.path.lexists(link):
+                    os.remove(link)
+                os.symlink("/sys/bus/i2c/devices/%d-0050/eeprom" % bus, link)
+            except OSError as e:
+                print str(e)
                 return 1
         else:        
-            status, output =log_os_system(
-                "echo 0x50 > /sys/bus/i2c/devices/i2c-"+str(bus)+"/delete_device")
+            status, output = i2c_delete_device(bus, 0x50)
             if status:
                 print output
    
@@ -143,11 +167,20 @@ def qsfp_eeprom_sys(pim_idx, i2c_bus_order, create):
 
     return 0
 
+#Return 0 when the device at i2c_addr answers a read on the bus
 def check_pca_active( i2c_addr, bus):
-    cmd = "i2cget -y -f %d 0x%x 0x0"
-    cmd =  cmd %(bus, i2c_addr)
-    status, output = commands.getstatusoutput(cmd)
-    return status
+    try:
+        fd = os.open("/dev/i2c-%d" % bus, os.O_RDWR)
+    except OSError:
+        return 1
+    try:
+        fcntl.ioctl(fd, I2C_SLAVE_FORCE, i2c_addr)
+        os.read(fd, 1)
+        return 0
+    except (IOError, OSError):
+        return 1
+    finally:
+        os.close(fd)
 
 def set_pim_port_use_bus(pim_idx):
 
@@ -171,21 +204,21 @@ def del_pim_port_use_bus(pim_idx):
       
 
 def device_remove():    
-    cmd1 = "echo 0x%x > /sys/bus/i2c/devices/i2c-%d/delete_device"    
-    
     for bus in range(2, 10):        
         #ret=check_pca_active(0x72, bus)
         #if ret==0:
         
-        cmdm= cmd1 % (0x72, bus)        
-        status, output = commands.getstatusoutput(cmdm)
+        i2c_delete_device(bus, 0x72)
         print "Remove %d-0072 i2c device"%bus
-        cmdm= cmd1 % (0x71, bus)
-        status, output = commands.getstatusoutput(cmdm)
+        i2c_delete_device(bus, 0x71)
         print "Remove %d-0071 i2c device"%bus
 
-    cmd="rm -f /usr/local/bin/minipack_qsfp/port*"
-    status, output=log_os_system(cmd)
+    status = 0
+    for link in glob.glob(QSFP_LINK_DIR + "/port*"):
+        try:
+            os.remove(link)
+        except OSError:
+            status = 1
     return status
     
 class device_monitor(object):
@@ -235,7 +268,7 @@ class device_monitor(object):
                     
                     logging.info ("pim_idx=%d oom use i2c_bus_order=%d", pim_idx, i2c_bus_order)
                     ready=0
-                    retry_limit=100
+                    retry_limit=int(PCA_READY_TIMEOUT / PCA_READY_INTERVAL)
                     retry_count=0
                     while retry_count < retry_limit:                    
                         ret=check_pca_active(0x72, pim_idx+2)
@@ -243,7 +276,7 @@ class device_monitor(object):
                             ready=1
                             break                        
                         retry_count=retry_count+1
-                        time.sleep(0.2)
+                        time.sleep(PCA_READY_INTERVAL)
                         
                     if ready==1:
                         status=pca9548_sysfs(pim_idx+2, 1)
@@ -262,7 +295,7 @@ class device_monitor(object):
                         pim_state[pim_idx]=self.PIM_STATE_INSERT
                         logging.info("pim_state[%d] PIM_STATE_INSERT", pim_idx);
                     else:
-                        print "retry check 100 times for check pca addr"
+                        print "retry check %d times for check pca addr" % retry_limit
                         del_pim_port_use_bus(pim_idx)
             else:
                 if pim_state[pim_idx]==self.PIM_STATE_INSERT:                    
@@ -310,7 +343,8 @@ def main(argv):
     
     while True:
         monitor.manage_pim()
-        time.sleep(2)
+        #Returns on a PIM presence change, or after the timeout to retry a failed setup
+        pim_dev.get_pim_change_event(PIM_EVENT_TIMEOUT)
 
 
 if __name__ == "__main__":
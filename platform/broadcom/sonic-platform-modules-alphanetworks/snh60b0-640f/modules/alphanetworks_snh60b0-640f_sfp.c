@@ -45,8 +45,6 @@
 #include <linux/sysfs.h>
 #include <linux/slab.h>
 #include <linux/delay.h>
-#include <linux/fs.h>
-#include <asm/uaccess.h>
 
 #define DRIVER_NAME 	"snh60b0_640f_sfp"
 
@@ -62,6 +60,8 @@
 #define NUM_OF_SFP_PORT 		64
 #define EEPROM_NAME 			"sfp_eeprom"
 #define EEPROM_SIZE				256	/*  256 byte eeprom */
+#define EEPROM_PAGE_SIZE		128
+#define EEPROM_NUM_PAGES		(EEPROM_SIZE / EEPROM_PAGE_SIZE)
 #define BIT_INDEX(i) 			(1ULL << (i))
 #define USE_I2C_BLOCK_READ 		1
 #define I2C_RW_RETRY_COUNT		3
@@ -70,6 +70,9 @@
 #define SFP_CPLD_I2C_ADDR		0x5F
 #define SFP_EEPROM_A0_I2C_ADDR	0x50
 #define SFP_EEPROM_A2_I2C_ADDR	0x68
+#define PORTS_PER_CPLD			16
+/* Module select register of the CPLD, routes the EEPROM of a port to 0x50 */
+#define SFP_MODULE_SELECT_REG(port)	(0x0b + (port) / 8)
 #define SFP_PCA9506_I2C_ADDR	0x20
 
 
@@ -96,6 +99,18 @@ static ssize_t sfp_eeprom_write(struct i2c_client *, u8 , const char *,int);
 /* extern int alpha_i2c_cpld_read(unsigned short cpld_addr, u8 reg); */
 extern int alpha_i2c_cpld_write(unsigned short cpld_addr, u8 reg, u8 value);
 
+/* The present/reset status of all the ports of a CPLD is read at once and
+ * kept for status_cache_ms. The lower EEPROM page of a port is kept for
+ * eeprom_cache_ms, the upper page until the module is removed.
+ */
+static unsigned int status_cache_ms = 100;
+module_param(status_cache_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(status_cache_ms, "Lifetime of the port status snapshot in ms");
+
+static unsigned int eeprom_cache_ms = 1000;
+module_param(eeprom_cache_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(eeprom_cache_ms, "Lifetime of the cached lower EEPROM page in ms");
+
 /* Addresses scanned
  */
 static const unsigned short normal_i2c[] = { SFP_EEPROM_A0_I2C_ADDR, SFP_EEPROM_A2_I2C_ADDR, SFP_CPLD_I2C_ADDR, SFP_PCA9506_I2C_ADDR, I2C_CLIENT_END };
@@ -196,6 +211,12 @@ struct qsfp_data {
 	struct eeprom_data	eeprom;
 };
 
+struct eeprom_page {
+	char			valid;			/* !=0 if data is valid */
+	unsigned long	last_updated;	/* In jiffies */
+	u8				data[EEPROM_PAGE_SIZE];
+};
+
 struct sfp_port_data {
 	struct mutex		   update_lock;
 	enum driver_type_e     driver_type;
@@ -203,6 +224,9 @@ struct sfp_port_data {
 	oom_driver_port_type_t port_type;
 	u64					   present;   /* present status, bit0:port0, bit1:port1 and so on */
 	u64					   port_reset;   /* reset status, bit0:port0, bit1:port1 and so on */
+	char				   status_valid;	/* !=0 if present and port_reset are valid */
+	unsigned long		   status_updated;	/* In jiffies */
+	struct eeprom_page	   eeprom_cache[PORTS_PER_CPLD][EEPROM_NUM_PAGES];
 
 	struct sfp_msa_data	  *msa;
 	struct sfp_ddm_data   *ddm;
@@ -698,69 +722,94 @@ static ssize_t show_port_number(struct device *dev, struct device_attribute *da,
 	return sprintf(buf, "%d\n", CPLD_PORT_TO_FRONT_PORT(data->port + attr->index));
 }
 
-static struct sfp_port_data *sfp_pca9506_update_present(struct i2c_client *client)
+static int sfp_read_regs(struct i2c_client *client, const u8 *regs, int num, u64 *value)
 {
-	struct sfp_port_data *data = i2c_get_clientdata(client);
-	int i = 0;
-	int status = -1;
-	u8 regs[] = {0x03};
+	int i, status;
 
-	DEBUG_PRINT("Starting pca9506 sfp present status update");
-	mutex_lock(&data->update_lock);
-	
-	/* Read present status of port */
-    data->present = 0;
-	
-    for (i = 0; i < ARRAY_SIZE(regs); i++) {
-        /* status = alpha_i2c_cpld_read(0x5f, regs[i]); */
+	*value = 0;
+
+	for (i = 0; i < num; i++) {
 		status = i2c_smbus_read_byte_data(client, regs[i]);
-        
-        if (status < 0) {
-            DEBUG_PRINT("pca9506(0x20) reg(0x%x) err %d", regs[i], status);
-            goto exit;
-        }
-        
-		data->present = status;
-    }
+		if (status < 0) {
+			DEBUG_PRINT("cpld(0x%x) reg(0x%x) err %d", client->addr, regs[i], status);
+			return status;
+		}
 
-	DEBUG_PRINT("Present status = 0x%llx", data->present);
-exit:
-	mutex_unlock(&data->update_lock);
-	return data;
+		*value |= (u64)status << (i*8);
+	}
+
+	return 0;
 }
 
-static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+/* Call with data->update_lock held */
+static void sfp_eeprom_cache_invalidate(struct sfp_port_data *data, u64 ports)
+{
+	int i, page;
+
+	for (i = 0; i < PORTS_PER_CPLD; i++) {
+		if (!(ports & BIT_INDEX(i))) {
+			continue;
+		}
+
+		for (page = 0; page < EEPROM_NUM_PAGES; page++) {
+			data->eeprom_cache[i][page].valid = 0;
+		}
+	}
+}
+
+/* Refresh the present/reset snapshot of all the ports of the CPLD, call with
+ * data->update_lock held. The EEPROM cache of a port is dropped when its
+ * present status changes.
+ */
+static int sfp_update_status(struct i2c_client *client)
 {
 	struct sfp_port_data *data = i2c_get_clientdata(client);
-	int i = 0;
-	int status = -1;
-	u8 regs[] = {0x05, 0x06};
+	static const u8 present_regs[] = {0x05, 0x06};
+	static const u8 pca9506_present_regs[] = {0x03};
+	static const u8 reset_regs[] = {0x07, 0x08};
+	u64 present, port_reset;
+	int status;
 
-	if(data->port >= SFPPLUS_1_PORT_NUMBER){
-		return sfp_pca9506_update_present(client);
+	if (data->status_valid &&
+		time_before(jiffies, data->status_updated + msecs_to_jiffies(status_cache_ms))) {
+		return 0;
 	}
 
-	DEBUG_PRINT("Starting sfp present status update");
-	mutex_lock(&data->update_lock);
-	
-	/* Read present status of port 1~32 */
-    data->present = 0;
-	
-    for (i = 0; i < ARRAY_SIZE(regs); i++) {
-        /* status = alpha_i2c_cpld_read(0x5f, regs[i]); */
-		status = i2c_smbus_read_byte_data(client, regs[i]);
-        
-        if (status < 0) {
-            DEBUG_PRINT("cpld(0x5f) reg(0x%x) err %d", regs[i], status);
-            goto exit;
-        }
-        
-		data->present |= (u64)status << (i*8);
-        DEBUG_PRINT("Present status = 0x%llx", data->present);
-    }
+	DEBUG_PRINT("Starting sfp status update");
+	if (data->port >= SFPPLUS_1_PORT_NUMBER) {
+		/* SFP+ modules have no reset */
+		status = sfp_read_regs(client, pca9506_present_regs, ARRAY_SIZE(pca9506_present_regs), &present);
+		port_reset = ~0ULL;
+	}
+	else {
+		status = sfp_read_regs(client, present_regs, ARRAY_SIZE(present_regs), &present);
+		if (status == 0) {
+			status = sfp_read_regs(client, reset_regs, ARRAY_SIZE(reset_regs), &port_reset);
+		}
+	}
 
-	DEBUG_PRINT("Present status = 0x%llx", data->present);
-exit:
+	if (status < 0) {
+		data->status_valid = 0;
+		data->present = 0;
+		return status;
+	}
+
+	sfp_eeprom_cache_invalidate(data, data->status_valid ? (present ^ data->present) : ~0ULL);
+	data->present = present;
+	data->port_reset = port_reset;
+	data->status_valid = 1;
+	data->status_updated = jiffies;
+
+	DEBUG_PRINT("Present status = 0x%llx, reset status = 0x%llx", data->present, data->port_reset);
+	return 0;
+}
+
+static struct sfp_port_data *sfp_update_present(struct i2c_client *client)
+{
+	struct sfp_port_data *data = i2c_get_clientdata(client);
+
+	mutex_lock(&data->update_lock);
+	sfp_update_status(client);
 	mutex_unlock(&data->update_lock);
 	return data;
 }
@@ -883,36 +932,6 @@ static ssize_t show_port_type(struct device *dev, struct device_attribute *da,
 }
 
 
-static struct sfp_port_data *sfp_update_port_reset(struct i2c_client *client)
-{
-    struct sfp_port_data *data = i2c_get_clientdata(client);
-    int i = 0;
-    int status = -1;
-    u8 regs[] = {0x07, 0x08};
-
-    mutex_lock(&data->update_lock);
-
-    /* Read reset status of port 1~32 */
-    data->port_reset = 0;
-
-    for (i = 0; i < ARRAY_SIZE(regs); i++) {
-		status = i2c_smbus_read_byte_data(client, regs[i]);
-
-        if (status < 0) {
-            DEBUG_PRINT("cpld(0x60) reg(0x%x) err %d", regs[i], status);
-            goto exit;
-        }
-        
-        DEBUG_PRINT("reset status = 0x%x", status);
-        data->port_reset |= (u64)status << (i*8);
-    }
-
-    DEBUG_PRINT("reset status = 0x%llx", data->port_reset);
-exit:
-    mutex_unlock(&data->update_lock);
-    return data;
-}
-
 static ssize_t show_port_reset(struct device *dev, struct device_attribute *da,
                          char *buf)
 {
@@ -925,7 +944,6 @@ static ssize_t show_port_reset(struct device *dev, struct device_attribute *da,
         return sprintf(buf, "%d\n", OOM_DRIVER_PORT_TYPE_NOT_PRESENT);
     }
 
-    sfp_update_port_reset(client);
     is_reset = (data->port_reset & BIT_INDEX(attr->index))? 0 : 1;
 
     return sprintf(buf, "%d\n", is_reset);
@@ -966,6 +984,7 @@ static ssize_t sfp_set_port_reset(struct device *dev, struct device_attribute *d
 
     alpha_i2c_cpld_write(0x5f, cpld_reg, cpld_val);
     DEBUG_PRINT("write cpld reg = 0x%x value = 0x%x", cpld_reg, cpld_val);
+    data->status_valid = 0;
 
     mutex_unlock(&data->update_lock);
 
@@ -1143,120 +1162,139 @@ static ssize_t sfp_show_tx_rx_status(struct device *dev, struct device_attribute
 	return sprintf(buf, "%d\n", val);
 }
 
-static ssize_t qsfp_show_eeprom(struct device *dev, struct device_attribute *da,
-			 char *buf)
+/* Read one page of the module EEPROM with a single transfer, or with SMBus
+ * block reads when the adapter is SMBus only.
+ */
+static int sfp_eeprom_read_page(struct i2c_adapter *adap, u8 offset, u8 *buf)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
-	char devfile[96];
-    struct file *sfd;
-	int i2c_index = 0;
-	int result;
-	int offset[] = {0x0b, 0x0c};
-    int rdlen, rc;
-    mm_segment_t old_fs;
-	char buffer[256];
-	
-    if (!sfp_is_port_present(client, attr->index)) {
-        return 0;
-    }
+	int i, status = -EIO, retry;
+
+	if (i2c_check_functionality(adap, I2C_FUNC_I2C)) {
+		struct i2c_msg msgs[] = {
+			{ .addr = SFP_EEPROM_A0_I2C_ADDR, .flags = 0, .len = 1, .buf = &offset },
+			{ .addr = SFP_EEPROM_A0_I2C_ADDR, .flags = I2C_M_RD, .len = EEPROM_PAGE_SIZE, .buf = buf },
+		};
+
+		for (retry = I2C_RW_RETRY_COUNT; retry; retry--) {
+			status = i2c_transfer(adap, msgs, ARRAY_SIZE(msgs));
+			if (status == ARRAY_SIZE(msgs)) {
+				return 0;
+			}
+			msleep(I2C_RW_RETRY_INTERVAL);
+		}
 
-	if(strcmp(client->name, "sfpcpld1") == 0)
-		i2c_index = 13;
-	else if(strcmp(client->name, "sfpcpld17") == 0)
-		i2c_index = 14;
-	else if(strcmp(client->name, "sfpcpld33") == 0)
-		i2c_index = 15;
-	else if(strcmp(client->name, "sfpcpld49") == 0)
-		i2c_index = 16;
-	else if(strcmp(client->name, "sfpcpld65") == 0){
-		if(attr->index == 0)
-			i2c_index = 21;
-		else if(attr->index == 1)
-			i2c_index = 22;
+		return (status < 0) ? status : -EIO;
 	}
-	
-    snprintf(devfile, sizeof(devfile), "/sys/bus/i2c/devices/%d-0050/sfp_eeprom", i2c_index);
-		
-	/* Set module select register */
-	switch(i2c_index){
-	case 13:
-	case 14:
-	case 15:
-	case 16:
-		if((attr->index/8) == 0){
-			/* Port number is 1-8 */
-			result = i2c_smbus_write_byte_data(client, offset[0], BIT_INDEX(attr->index));
-			if (result < 0) {
-				dev_info(&client->dev, "i2c_smbus_write_byte_data fail(%d)", result);
+
+	for (i = 0; i < EEPROM_PAGE_SIZE; i += I2C_SMBUS_BLOCK_MAX) {
+		union i2c_smbus_data smbus_data;
+
+		for (retry = I2C_RW_RETRY_COUNT; retry; retry--) {
+			smbus_data.block[0] = I2C_SMBUS_BLOCK_MAX;
+			status = i2c_smbus_xfer(adap, SFP_EEPROM_A0_I2C_ADDR, 0, I2C_SMBUS_READ,
+									offset + i, I2C_SMBUS_I2C_BLOCK_DATA, &smbus_data);
+			if (status >= 0) {
+				break;
 			}
+			msleep(I2C_RW_RETRY_INTERVAL);
 		}
-		else if((attr->index/8) == 1){
-			/* Port number is 9-16 */
-			result = i2c_smbus_write_byte_data(client, offset[1], BIT_INDEX((attr->index)%8));
-			if (result < 0) {
-				dev_info(&client->dev, "i2c_smbus_write_byte_data fail(%d)", result);
-			}
+
+		if (status < 0) {
+			return status;
 		}
-		break;
-	default:
-		break;
+
+		memcpy(buf + i, &smbus_data.block[1], I2C_SMBUS_BLOCK_MAX);
 	}
 
-	/* Read SFP EEPROM */
-    sfd = filp_open(devfile, O_RDONLY, 0);
-    if (IS_ERR(sfd)) {
-        dev_info(&client->dev, "Failed to open file(%s)#%d", devfile, __LINE__);
-        return 0;
-    }
+	return 0;
+}
 
-    if(!(sfd->f_op) || !(sfd->f_op->read) ) {
-        dev_info(&client->dev, "file %s cann't readable ?\n", devfile);
-        return 0;
-    }
+/* Refresh the expired EEPROM pages of port, call with data->update_lock held */
+static int sfp_update_eeprom(struct i2c_client *client, struct i2c_adapter *adap, int port)
+{
+	struct sfp_port_data *data = i2c_get_clientdata(client);
+	struct eeprom_page *cache = data->eeprom_cache[port];
+	int page, result, status = 0;
+	int select = 0;
+
+	for (page = 0; page < EEPROM_NUM_PAGES; page++) {
+		/* Only the lower page holds live monitor values */
+		if (cache[page].valid && (page > 0 ||
+			time_before(jiffies, cache[page].last_updated + msecs_to_jiffies(eeprom_cache_ms)))) {
+			continue;
+		}
 
-    old_fs = get_fs();
-    set_fs(KERNEL_DS);
-    rdlen = sfd->f_op->read(sfd, buffer, sizeof(buffer), &sfd->f_pos);
-    if (rdlen == 0) {
-        dev_info(&client->dev, "File(%s) empty!\n", devfile);
-        rc = 0;
-        goto exit;
-    }
-	
-	rc = sizeof(buffer);
-	memcpy(buf, buffer, rc);
-			
-	/* Reset module select register */
-	switch(i2c_index){
-	case 13:
-	case 14:
-	case 15:
-	case 16:
-		if((attr->index/8) == 0){
-			/* Port number is 1-8 */
-			result = i2c_smbus_write_byte_data(client, offset[0], 0);
+		if (!select && data->port < SFPPLUS_1_PORT_NUMBER) {
+			/* Set module select register */
+			result = i2c_smbus_write_byte_data(client, SFP_MODULE_SELECT_REG(port), BIT_INDEX(port % 8));
 			if (result < 0) {
 				dev_info(&client->dev, "i2c_smbus_write_byte_data fail(%d)", result);
 			}
+			select = 1;
 		}
-		else if((attr->index/8) == 1){
-			/* Port number is 9-16 */
-			result = i2c_smbus_write_byte_data(client, offset[1], 0);
-			if (result < 0) {
-				dev_info(&client->dev, "i2c_smbus_write_byte_data fail(%d)", result);
-			}
+
+		status = sfp_eeprom_read_page(adap, page * EEPROM_PAGE_SIZE, cache[page].data);
+		if (status < 0) {
+			dev_dbg(&client->dev, "sfp%d eeprom page %d read fail(%d)", port + 1, page, status);
+			break;
 		}
-		break;
-	default:
-		break;
+
+		cache[page].valid = 1;
+		cache[page].last_updated = jiffies;
 	}
 
-exit:
-    set_fs(old_fs);
-    filp_close(sfd, 0);
+	if (select) {
+		/* Reset module select register */
+		result = i2c_smbus_write_byte_data(client, SFP_MODULE_SELECT_REG(port), 0);
+		if (result < 0) {
+			dev_info(&client->dev, "i2c_smbus_write_byte_data fail(%d)", result);
+		}
+	}
+
+	return status;
+}
+
+static ssize_t qsfp_show_eeprom(struct device *dev, struct device_attribute *da,
+			 char *buf)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	struct sfp_port_data *data = i2c_get_clientdata(client);
+	struct sensor_device_attribute *attr = to_sensor_dev_attr(da);
+	struct i2c_adapter *adap = client->adapter;
+	int page, status;
+
+	if (!sfp_is_port_present(client, attr->index)) {
+		return 0;
+	}
+
+	if (data->port >= SFPPLUS_1_PORT_NUMBER) {
+		/* The EEPROMs of the SFP+ ports sit on their own buses */
+		if (attr->index > 1) {
+			return 0;
+		}
+
+		adap = i2c_get_adapter((attr->index == 0) ? 21 : 22);
+		if (!adap) {
+			return 0;
+		}
+	}
+
+	mutex_lock(&data->update_lock);
+
+	status = sfp_update_eeprom(client, adap, attr->index);
+	if (status == 0) {
+		for (page = 0; page < EEPROM_NUM_PAGES; page++) {
+			memcpy(buf + page * EEPROM_PAGE_SIZE, data->eeprom_cache[attr->index][page].data, EEPROM_PAGE_SIZE);
+		}
+	}
+
+	mutex_unlock(&data->update_lock);
+
+	if (adap != client->adapter) {
+		i2c_put_adapter(adap);
+	}
 
-	return rc;
+	return (status == 0) ? EEPROM_SIZE : 0;
 }
 
 #if 0
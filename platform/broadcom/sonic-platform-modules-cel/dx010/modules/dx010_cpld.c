@@ -26,6 +26,8 @@
 #include <linux/err.h>
 #include <linux/platform_device.h>
 #include <linux/types.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
 #include <uapi/linux/stat.h>
 
 #define DRIVER_NAME "dx010_cpld"
@@ -65,6 +67,25 @@
 #define INT2229     0x3d6
 #define INT3032     0x3d7
 
+/* Gather the 32 port bits of a register set, port 1 at bit 0 */
+#define PORT_BITS(reg)                                          \
+        ((inb(reg##3032) & 0x07) << (24+5) |                    \
+         inb(reg##2229) << (24-3)  |                            \
+         (inb(reg##1921) & 0x07) << (16 + 2) |                  \
+         inb(reg##1118) << (16-6) |                             \
+         (inb(reg##0910) & 0x03) << 8 |                         \
+         inb(reg##0108))
+
+#define MODPRS_CHANGED_NAME     "qsfp_modprs_changed"
+
+/*
+ * The port status snapshot is refreshed every modprs_poll_ms, a change of
+ * ModPrsL notifies pollers of qsfp_modprs_changed.
+ */
+static unsigned int modprs_poll_ms = 100;
+module_param(modprs_poll_ms, uint, 0644);
+MODULE_PARM_DESC(modprs_poll_ms, "QSFP status snapshot refresh interval in ms, 0 to stop");
+
 
 #define LENGTH_PORT_CPLD        34
 #define PORT_BANK1_START        1
@@ -124,10 +145,25 @@ struct dx010_i2c_data {
         struct current_xfer curr_xfer;
 };
 
+/*
+ * Whole chassis port status, all 32 bits of each register set.
+ */
+struct dx010_port_status {
+        u32 present;
+        u32 reset;
+        u32 lpmode;
+        u32 modirq;
+};
+
 struct dx010_cpld_data {
         struct i2c_adapter *i2c_adapter[LENGTH_PORT_CPLD];
         struct mutex       cpld_lock;
         uint16_t           read_addr;
+        struct device      *dev;
+        struct dx010_port_status status;
+        bool               status_valid;
+        unsigned long      status_updated;  /* in jiffies */
+        struct delayed_work status_work;
 };
 
 struct dx010_cpld_data *cpld_data;
@@ -239,6 +275,8 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr,
         outb( (reset >> 18) & 0x07, RESET1921);
         outb( (reset >> 21) & 0xFF, RESET2229);
         outb( (reset >> 29) & 0x07, RESET3032);
+        if (cpld_data->status_valid)
+                dx010_status_update();
 
         mutex_unlock(&cpld_data->cpld_lock);
 
@@ -286,6 +324,8 @@ static ssize_t set_lpmode(struct device *dev, struct device_attribute *devattr,
         outb( (lpmod >> 18) & 0x07, LPMOD1921);
         outb( (lpmod >> 21) & 0xFF, LPMOD2229);
         outb( (lpmod >> 29) & 0x07, LPMOD3032);
+        if (cpld_data->status_valid)
+                dx010_status_update();
 
         mutex_unlock(&cpld_data->cpld_lock);
 
@@ -332,12 +372,86 @@ static ssize_t get_modirq(struct device *dev, struct device_attribute *devattr,
         return sprintf(buf,"0x%8.8lx\n", irq  & 0xffffffff);
 }
 
+/*
+ * Read all port registers in one go, cpld_lock must be held. Notify
+ * pollers of qsfp_modprs_changed when a module came or went.
+ */
+static void dx010_status_update(void)
+{
+        struct dx010_port_status st;
+        bool changed;
+
+        st.present = PORT_BITS(ABS);
+        st.reset = PORT_BITS(RESET);
+        st.lpmode = PORT_BITS(LPMOD);
+        st.modirq = PORT_BITS(INT);
+
+        changed = cpld_data->status_valid &&
+                  st.present != cpld_data->status.present;
+        cpld_data->status = st;
+        cpld_data->status_updated = jiffies;
+        cpld_data->status_valid = true;
+
+        if (changed)
+                sysfs_notify(&cpld_data->dev->kobj, NULL, MODPRS_CHANGED_NAME);
+}
+
+static void dx010_status_work(struct work_struct *work)
+{
+        unsigned int interval = modprs_poll_ms;
+
+        if (interval) {
+                mutex_lock(&cpld_data->cpld_lock);
+                dx010_status_update();
+                mutex_unlock(&cpld_data->cpld_lock);
+        }
+
+        /* Look again for the parameter later when stopped */
+        schedule_delayed_work(&cpld_data->status_work,
+                              msecs_to_jiffies(interval ? interval : 1000));
+}
+
+/* The snapshot, refreshed here when the work is stopped or not run yet */
+static void dx010_status_get(struct dx010_port_status *st)
+{
+        mutex_lock(&cpld_data->cpld_lock);
+        if (!cpld_data->status_valid || !modprs_poll_ms)
+                dx010_status_update();
+        *st = cpld_data->status;
+        mutex_unlock(&cpld_data->cpld_lock);
+}
+
+static ssize_t get_status(struct device *dev, struct device_attribute *devattr,
+                char *buf)
+{
+        struct dx010_port_status st;
+
+        dx010_status_get(&st);
+        return sprintf(buf, "present=0x%8.8x reset=0x%8.8x lpmode=0x%8.8x irq=0x%8.8x\n",
+                        st.present, st.reset, st.lpmode, st.modirq);
+}
+
+/*
+ * Same content as qsfp_modprs, from the snapshot. poll() returns
+ * POLLPRI | POLLERR once ModPrsL changes, read again to re-arm.
+ */
+static ssize_t get_modprs_changed(struct device *dev, struct device_attribute *devattr,
+                char *buf)
+{
+        struct dx010_port_status st;
+
+        dx010_status_get(&st);
+        return sprintf(buf, "0x%8.8x\n", st.present);
+}
+
 static DEVICE_ATTR_RW(getreg);
 static DEVICE_ATTR_WO(setreg);
 static DEVICE_ATTR(qsfp_reset, S_IRUGO | S_IWUSR, get_reset, set_reset);
 static DEVICE_ATTR(qsfp_lpmode, S_IRUGO | S_IWUSR, get_lpmode, set_lpmode);
 static DEVICE_ATTR(qsfp_modprs, S_IRUGO, get_modprs, NULL);
 static DEVICE_ATTR(qsfp_modirq, S_IRUGO, get_modirq, NULL);
+static DEVICE_ATTR(qsfp_status, S_IRUGO, get_status, NULL);
+static DEVICE_ATTR(qsfp_modprs_changed, S_IRUGO, get_modprs_changed, NULL);
 
 static struct attribute *dx010_lpc_attrs[] = {
         &dev_attr_getreg.attr,
@@ -346,6 +460,8 @@ static struct attribute *dx010_lpc_attrs[] = {
         &dev_attr_qsfp_lpmode.attr,
         &dev_attr_qsfp_modprs.attr,
         &dev_attr_qsfp_modirq.attr,
+        &dev_attr_qsfp_status.attr,
+        &dev_attr_qsfp_modprs_changed.attr,
         NULL,
 };
 
@@ -627,6 +743,8 @@ static int cel_dx010_lpc_drv_probe(struct platform_device *pdev)
 
         mutex_init(&cpld_data->cpld_lock);
         cpld_data->read_addr = CPLD1_VERSION_ADDR;
+        cpld_data->dev = &pdev->dev;
+        INIT_DELAYED_WORK(&cpld_data->status_work, dx010_status_work);
 
         res = platform_get_resource(pdev, IORESOURCE_IO, 0);
         if (unlikely(!res)) {
@@ -643,6 +761,8 @@ static int cel_dx010_lpc_drv_probe(struct platform_device *pdev)
                 cpld_data->i2c_adapter[portid_count-1] =
                                 cel_dx010_i2c_init(pdev, portid_count);
 
+        schedule_delayed_work(&cpld_data->status_work, 0);
+
         return 0;
 }
 
@@ -650,6 +770,7 @@ static int cel_dx010_lpc_drv_remove(struct platform_device *pdev)
 {
         int portid_count;
 
+        cancel_delayed_work_sync(&cpld_data->status_work);
         sysfs_remove_group(&pdev->dev.kobj, &dx010_lpc_attr_grp);
 
         for (portid_count=1 ; portid_count<=LENGTH_PORT_CPLD ; portid_count++)
@@ -113,6 +113,28 @@ enum {
  */
 #define FAN_RPM_FACTOR 3932160
 
+/* Fan Configuration 2: RPM error window of the fan speed control */
+#define FAN_CONF2_ERG_MASK	0x06
+#define FAN_CONF2_ERG_SHIFT	1
+
+static const u16 fan_error_range[] = { 0, 50, 100, 200 };
+
+/*
+ * All fans of a chip are refreshed in one pass once the cache is older
+ * than update_interval_ms.
+ */
+static unsigned int update_interval_ms = 1500;
+module_param(update_interval_ms, uint, 0644);
+MODULE_PARM_DESC(update_interval_ms, "Fan cache lifetime in ms");
+
+/*
+ * With a nonzero rpm_target the fans are put in RPM based fan speed
+ * control at probe, the chip then holds the speed by itself.
+ */
+static unsigned int rpm_target;
+module_param(rpm_target, uint, 0444);
+MODULE_PARM_DESC(rpm_target, "RPM target programmed at probe, 0 keeps the setup");
+
 
 struct emc2305_fan_data {
 	bool		enabled;
@@ -125,12 +147,15 @@ struct emc2305_fan_data {
 	u16		tach;
 	u16		rpm_factor;
 	u8		pwm;
+	u8		error_range;
 };
 
 struct emc2305_data {
 	struct device		*hwmon_dev;
 	struct mutex		update_lock;
 	int			fans;
+	bool			block_read;
+	unsigned long		last_updated;
 	struct emc2305_fan_data	fan[5];
 };
 
@@ -198,6 +223,51 @@ static void read_fan_setting(struct i2c_client *client, int fan)
 	data->fan[fan].pwm = setting;
 }
 
+static void read_fan_config2(struct i2c_client *client, int fan)
+{
+	struct emc2305_data *data = i2c_get_clientdata(client);
+	u8 conf2;
+
+	if (read_u8_from_i2c(client, SEL_FAN(fan, REG_FAN_CONFIGURATION_2),
+			     &conf2) < 0)
+		return;
+
+	data->fan[fan].error_range =
+		(conf2 & FAN_CONF2_ERG_MASK) >> FAN_CONF2_ERG_SHIFT;
+}
+
+/*
+ * Read the whole register bank of a fan (0x30 - 0x3f) with one block
+ * transfer. Returns 0, or a negative value to fall back to byte reads.
+ */
+static int read_fan_block(struct i2c_client *client, int fan_idx)
+{
+	struct emc2305_data *data = i2c_get_clientdata(client);
+	struct emc2305_fan_data *fan = &data->fan[fan_idx];
+	u8 regs[16];
+	int status;
+
+	status = i2c_smbus_read_i2c_block_data(client,
+					       SEL_FAN(fan_idx, REG_FAN_SETTING),
+					       sizeof(regs), regs);
+	if (status != sizeof(regs))
+		return status < 0 ? status : -EIO;
+
+#define FAN_BLOCK(reg)	regs[(reg) - REG_FAN_SETTING]
+	fan->pwm = FAN_BLOCK(REG_FAN_SETTING);
+	fan->rpm_control = (FAN_BLOCK(REG_FAN_CONFIGURATION_1) & 0x80) != 0;
+	fan->multiplier = 1 << ((FAN_BLOCK(REG_FAN_CONFIGURATION_1) & 0x60) >> 5);
+	fan->poles = ((FAN_BLOCK(REG_FAN_CONFIGURATION_1) & 0x18) >> 3) + 1;
+	fan->error_range = (FAN_BLOCK(REG_FAN_CONFIGURATION_2) &
+			    FAN_CONF2_ERG_MASK) >> FAN_CONF2_ERG_SHIFT;
+	fan->target = ((u16)FAN_BLOCK(REG_TACH_TARGET_HIGH) << 5) |
+		      (FAN_BLOCK(REG_TACH_TARGET_LOW) >> 3);
+	fan->tach = ((u16)FAN_BLOCK(REG_TACH_READ_HIGH) << 5) |
+		    (FAN_BLOCK(REG_TACH_READ_LOW) >> 3);
+#undef FAN_BLOCK
+	return 0;
+}
+
 static void read_fan_data(struct i2c_client *client, int fan_idx)
 {
 	struct emc2305_data *data = i2c_get_clientdata(client);
@@ -210,6 +280,34 @@ static void read_fan_data(struct i2c_client *client, int fan_idx)
 			  SEL_FAN(fan_idx, REG_TACH_READ_LOW));
 }
 
+/* Refresh every fan of the chip, update_lock must be held */
+static void emc2305_update_fans(struct i2c_client *client)
+{
+	struct emc2305_data *data = i2c_get_clientdata(client);
+	int fan_idx;
+
+	for (fan_idx = 0; fan_idx < data->fans; fan_idx++) {
+		struct emc2305_fan_data *fan_data = &data->fan[fan_idx];
+
+		if (!fan_data->enabled && fan_data->valid)
+			continue;
+
+		if (data->block_read && read_fan_block(client, fan_idx) < 0) {
+			dev_info(&client->dev, "block read failed, using byte reads\n");
+			data->block_read = false;
+		}
+		if (!data->block_read) {
+			read_fan_config_from_i2c(client, fan_idx);
+			read_fan_config2(client, fan_idx);
+			read_fan_data(client, fan_idx);
+			read_fan_setting(client, fan_idx);
+		}
+		fan_data->valid = true;
+		fan_data->last_updated = jiffies;
+	}
+	data->last_updated = jiffies;
+}
+
 static struct emc2305_fan_data *
 emc2305_update_fan(struct i2c_client *client, int fan_idx)
 {
@@ -218,14 +316,10 @@ emc2305_update_fan(struct i2c_client *client, int fan_idx)
 
 	mutex_lock(&data->update_lock);
 
-	if (time_after(jiffies, fan_data->last_updated + HZ + HZ / 2)
-	    || !fan_data->valid) {
-		read_fan_config_from_i2c(client, fan_idx);
-		read_fan_data(client, fan_idx);
-		read_fan_setting(client, fan_idx);
-		fan_data->valid = true;
-		fan_data->last_updated = jiffies;
-	}
+	if (time_after(jiffies, data->last_updated +
+		       msecs_to_jiffies(update_interval_ms))
+	    || !fan_data->valid)
+		emc2305_update_fans(client);
 
 	mutex_unlock(&data->update_lock);
 	return fan_data;
@@ -341,6 +435,47 @@ emc2305_set_fan_target(struct i2c_client *client, int fan_idx, long rpm_target)
 	return 0;
 }
 
+/*
+ * The fan speed control leaves the drive alone while the measured speed
+ * is within the error window of the target, the chip rounds up to 0, 50,
+ * 100 or 200 RPM.
+ */
+static int
+emc2305_set_fan_target_hyst(struct i2c_client *client, int fan_idx, long rpm)
+{
+	struct emc2305_data *data = i2c_get_clientdata(client);
+	struct emc2305_fan_data *fan = emc2305_update_fan(client, fan_idx);
+	const u8 reg_conf2 = SEL_FAN(fan_idx, REG_FAN_CONFIGURATION_2);
+	int status, range;
+
+	if (rpm < 0)
+		return -EINVAL;
+
+	for (range = 0; range < ARRAY_SIZE(fan_error_range) - 1; range++)
+		if (rpm <= fan_error_range[range])
+			break;
+
+	mutex_lock(&data->update_lock);
+
+	status = i2c_smbus_read_byte_data(client, reg_conf2);
+	if (status < 0) {
+		status = -EIO;
+		goto exit_unlock;
+	}
+	status &= ~FAN_CONF2_ERG_MASK;
+	status |= range << FAN_CONF2_ERG_SHIFT;
+	status = i2c_smbus_write_byte_data(client, reg_conf2, status);
+	if (status < 0) {
+		status = -EIO;
+		goto exit_unlock;
+	}
+	fan->error_range = range;
+
+exit_unlock:
+	mutex_unlock(&data->update_lock);
+	return status;
+}
+
 static int
 emc2305_set_pwm_enable(struct i2c_client *client, int fan_idx, long enable)
 {
@@ -501,6 +636,33 @@ static ssize_t set_fan_target(struct device *dev, struct device_attribute *da,
 	return count;
 }
 
+static ssize_t
+show_fan_target_hyst(struct device *dev, struct device_attribute *da, char *buf)
+{
+	struct emc2305_fan_data *fan = emc2305_update_device_fan(dev, da);
+	return sprintf(buf, "%d\n", fan_error_range[fan->error_range]);
+}
+
+static ssize_t set_fan_target_hyst(struct device *dev,
+				   struct device_attribute *da,
+				   const char *buf, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	int fan_idx = to_sensor_dev_attr(da)->index;
+	long rpm;
+	int status;
+
+	status = kstrtol(buf, 10, &rpm);
+	if (status < 0)
+		return -EINVAL;
+
+	status = emc2305_set_fan_target_hyst(client, fan_idx, rpm);
+	if (status < 0)
+		return status;
+
+	return count;
+}
+
 static ssize_t
 show_pwm_enable(struct device *dev, struct device_attribute *da, char *buf)
 {
@@ -578,6 +740,7 @@ static ssize_t set_pwm(struct device *dev, struct device_attribute *da,
 		EMC2305_ATTR_RO(fan, fault, _num),			\
 		EMC2305_ATTR_RW(fan, div, _num),			\
 		EMC2305_ATTR_RW(fan, target, _num),			\
+		EMC2305_ATTR_RW(fan, target_hyst, _num),		\
 		EMC2305_ATTR_RW(pwm, enable, _num),			\
 		EMC2305_ATTR_RW2(pwm, _num)			\
 	}
@@ -644,6 +807,7 @@ struct of_fan_attribute {
 struct of_fan_attribute of_fan_attributes[] = {
 	{"fan-div", emc2305_set_fan_div},
 	{"fan-target", emc2305_set_fan_target},
+	{"fan-target-hyst", emc2305_set_fan_target_hyst},
 	{"pwm-enable", emc2305_set_pwm_enable},
 	{NULL, NULL}
 };
@@ -724,6 +888,17 @@ static void emc2305_get_config(struct i2c_client *client)
 	emc2305_config_of(client);
 #endif
 
+	if (!rpm_target)
+		return;
+
+	for (i = 0; i < data->fans; ++i) {
+		if (!data->fan[i].enabled)
+			continue;
+		if (emc2305_set_fan_target(client, i, rpm_target) < 0 ||
+		    emc2305_set_pwm_enable(client, i, 3) < 0)
+			dev_warn(&client->dev, "fan%d: cannot enable rpm control\n",
+				 i + 1);
+	}
 }
 
 static int
@@ -743,6 +918,8 @@ emc2305_probe(struct i2c_client *client, const struct i2c_device_id *id)
 
 	i2c_set_clientdata(client, data);
 	mutex_init(&data->update_lock);
+	data->block_read = i2c_check_functionality(client->adapter,
+					I2C_FUNC_SMBUS_READ_I2C_BLOCK);
 
 	status = i2c_smbus_read_byte_data(client, REG_PRODUCT_ID);
 	switch (status) {
@@ -44,6 +44,9 @@
 #include <linux/dmi.h>
 #include <linux/slab.h>
 #include <linux/wait.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/list.h>
 #include <linux/err.h>
 #include <linux/kobject.h>
 #include <linux/platform_device.h>
@@ -52,6 +55,9 @@
 #include <linux/fs.h>
 #include <linux/uaccess.h>
 #include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 static int  majorNumber;
 
@@ -69,6 +75,9 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
                            unsigned short flags, char rw, u8 cmd,
                            int size, union i2c_smbus_data *data);
 
+static int i2c_raw_access(struct i2c_adapter *adapter,
+                          struct i2c_msg *msgs, int num);
+
 static int fpgafw_init(void);
 static void fpgafw_exit(void);
 
@@ -287,6 +296,58 @@ static struct mutex fpga_i2c_master_locks[I2C_MASTER_CH_TOTAL];
 /* Store lasted switch address and channel */
 static uint16_t fpga_i2c_lasted_access_port[I2C_MASTER_CH_TOTAL];
 
+/*
+ * Interrupt mode: the I2C masters raise MIF on the FPGA PCIe interrupt
+ * (MIEN is always set), the ISR latches the status of each master and
+ * wakes up the waiter instead of i2c_wait_ack() spinning on REG_SR0.
+ * Polling stays the default and the fallback when no irq is available.
+ */
+static bool i2c_irq_mode = false;
+module_param(i2c_irq_mode, bool, 0444);
+MODULE_PARM_DESC(i2c_irq_mode, "Wait for the FPGA I2C master interrupt instead of polling");
+
+static wait_queue_head_t fpga_i2c_master_wq[I2C_MASTER_CH_TOTAL];
+static atomic_t fpga_i2c_master_irq_status[I2C_MASTER_CH_TOTAL];
+
+/*
+ * Order of the waiters for a master. On release the master goes first to
+ * a waiter behind the PCA9548 channel already selected, so callers that
+ * poll ports concurrently do not flip the mux on every transfer. At most
+ * mux_batch waiters may overtake the oldest one, 0 keeps arrival order.
+ */
+static unsigned int mux_batch = 8;
+module_param(mux_batch, uint, 0644);
+MODULE_PARM_DESC(mux_batch, "Max transfers on the selected mux channel ahead of older waiters");
+
+struct fpga_i2c_sched {
+    spinlock_t lock;
+    bool busy;
+    unsigned int streak;            // waiters granted out of arrival order
+    struct list_head waiters;
+};
+
+struct fpga_i2c_waiter {
+    struct list_head list;
+    uint16_t port;                  // switch_addr << 8 | channel, 0 without mux
+    struct task_struct *task;
+    bool granted;
+};
+
+static struct fpga_i2c_sched fpga_i2c_master_sched[I2C_MASTER_CH_TOTAL];
+
+/* Per master transfer accounting, updated under fpga_i2c_master_locks[] */
+struct fpga_i2c_stats {
+    u64 xfers;
+    u64 errors;
+    u64 mux_writes;
+    u64 total_ns;
+    u64 max_ns;
+    u64 irqs;       // updated by the ISR only
+};
+
+static struct fpga_i2c_stats fpga_i2c_master_stats[I2C_MASTER_CH_TOTAL];
+static struct dentry *fpga_debugfs_dir = NULL;
+
 enum PORT_TYPE {
     NONE,
     QSFP,
@@ -346,12 +407,15 @@ struct fpga_device {
     void __iomem *data_base_addr;
     resource_size_t data_mmio_start;
     resource_size_t data_mmio_len;
+    /* I2C master interrupt, 0 when polling */
+    int irq;
 };
 
 static struct fpga_device fpga_dev = {
     .data_base_addr = 0,
     .data_mmio_start = 0,
     .data_mmio_len = 0,
+    .irq = 0,
 };
 
 struct silverstone_fpga_data {
@@ -1105,6 +1169,26 @@ static struct device * silverstone_sff_init(int portid) {
     return new_device;
 }
 
+/**
+ * Sleep until the ISR has latched the completion of the master, or
+ * REG_SR0 already shows it.
+ */
+static int i2c_wait_irq(unsigned int master_bus, void __iomem *reg_sr,
+                        unsigned long timeout, int writing)
+{
+    atomic_t *irq_status = &fpga_i2c_master_irq_status[master_bus - 1];
+    u8 mask = 1 << I2C_SR_BIT_MIF;
+
+    if (writing == 0)
+        mask |= 1 << I2C_SR_BIT_MCF;
+
+    if (!wait_event_timeout(fpga_i2c_master_wq[master_bus - 1],
+                            (atomic_read(irq_status) | ioread8(reg_sr)) & mask,
+                            msecs_to_jiffies(timeout)))
+        return -ETIMEDOUT;
+    return 0;
+}
+
 static int i2c_wait_ack(struct i2c_adapter *a, unsigned long timeout, int writing) {
     int error = 0;
     int Status;
@@ -1134,6 +1218,13 @@ static int i2c_wait_ack(struct i2c_adapter *a, unsigned long timeout, int writin
     check(pci_bar + REG_SR0);
     check(pci_bar + REG_CR0);
 
+    if (fpga_dev.irq > 0) {
+        error = i2c_wait_irq(master_bus, pci_bar + REG_SR0, timeout, writing);
+        if (error < 0)
+            info("Error Timeout");
+        goto wait_done;
+    }
+
     timeout = jiffies + msecs_to_jiffies(timeout);
     while (1) {
         Status = ioread8(pci_bar + REG_SR0);
@@ -1153,7 +1244,11 @@ static int i2c_wait_ack(struct i2c_adapter *a, unsigned long timeout, int writin
             break;
         }
     }
+
+wait_done:
     Status = ioread8(pci_bar + REG_SR0);
+    if (fpga_dev.irq > 0)
+        Status |= atomic_xchg(&fpga_i2c_master_irq_status[master_bus - 1], 0);
     iowrite8(0, pci_bar + REG_SR0);
 
     if (error < 0) {
@@ -1236,6 +1331,12 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
     case I2C_SMBUS_WORD_DATA:
     case I2C_SMBUS_BLOCK_DATA:
         break;
+    case I2C_SMBUS_I2C_BLOCK_DATA:
+        if (data->block[0] < 1 || data->block[0] > I2C_SMBUS_BLOCK_MAX) {
+            error = -EINVAL;
+            goto Done;
+        }
+        break;
     default:
         printk(KERN_INFO "Unsupported transaction %d\n", size);
         error = -EOPNOTSUPP;
@@ -1247,6 +1348,7 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
     ////[S][ADDR/R]
     //Clear status register
     iowrite8(0, pci_bar + REG_SR0);
+    atomic_set(&fpga_i2c_master_irq_status[master_bus - 1], 0);
     iowrite8(1 << I2C_CR_BIT_MIEN | 1 << I2C_CR_BIT_MTX | 1 << I2C_CR_BIT_MSTA , pci_bar + REG_CR0);
     SET_REG_BIT_H(pci_bar + REG_CR0, I2C_CR_BIT_MEN);
 
@@ -1274,6 +1376,7 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
     if (size == I2C_SMBUS_BYTE_DATA ||
             size == I2C_SMBUS_WORD_DATA ||
             size == I2C_SMBUS_BLOCK_DATA ||
+            size == I2C_SMBUS_I2C_BLOCK_DATA ||
             (size == I2C_SMBUS_BYTE && rw == I2C_SMBUS_WRITE)) {
 
         //sent command code to data register
@@ -1294,6 +1397,7 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
     case I2C_SMBUS_WORD_DATA:
         cnt = 2;  break;
     case I2C_SMBUS_BLOCK_DATA:
+    case I2C_SMBUS_I2C_BLOCK_DATA:
         // in block data mode keep number of byte in block[0]
         cnt = data->block[0];
         break;
@@ -1320,11 +1424,12 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
                 size == I2C_SMBUS_BYTE ||
                 size == I2C_SMBUS_BYTE_DATA ||
                 size == I2C_SMBUS_WORD_DATA ||
-                size == I2C_SMBUS_BLOCK_DATA
+                size == I2C_SMBUS_BLOCK_DATA ||
+                size == I2C_SMBUS_I2C_BLOCK_DATA
             )) {
         int bid = 0;
         info( "MS prepare to sent [%d bytes]", cnt);
-        if (size == I2C_SMBUS_BLOCK_DATA ) {
+        if (size == I2C_SMBUS_BLOCK_DATA || size == I2C_SMBUS_I2C_BLOCK_DATA) {
             bid = 1;    // block[0] is cnt;
             cnt += 1;   // offset from block[0]
         }
@@ -1344,7 +1449,8 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
     if ( rw == I2C_SMBUS_READ && (
                 size == I2C_SMBUS_BYTE_DATA ||
                 size == I2C_SMBUS_WORD_DATA ||
-                size == I2C_SMBUS_BLOCK_DATA
+                size == I2C_SMBUS_BLOCK_DATA ||
+                size == I2C_SMBUS_I2C_BLOCK_DATA
             )) {
         info( "MS Repeated Start");
 
@@ -1370,8 +1476,11 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
                 size == I2C_SMBUS_BYTE ||
                 size == I2C_SMBUS_BYTE_DATA ||
                 size == I2C_SMBUS_WORD_DATA ||
-                size == I2C_SMBUS_BLOCK_DATA
+                size == I2C_SMBUS_BLOCK_DATA ||
+                size == I2C_SMBUS_I2C_BLOCK_DATA
             )) {
+        // I2C block data goes to block[1..n], the length stays in block[0]
+        int first = (size == I2C_SMBUS_I2C_BLOCK_DATA) ? 1 : 0;
 
         switch (size) {
         case I2C_SMBUS_BYTE:
@@ -1382,6 +1491,8 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
         case I2C_SMBUS_BLOCK_DATA:
             //will be changed after recived first data
             cnt = 3;  break;
+        case I2C_SMBUS_I2C_BLOCK_DATA:
+            cnt = data->block[0] + 1;  break;
         default:
             cnt = 0;  break;
         }
@@ -1393,7 +1504,7 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
                  1 << I2C_CR_BIT_MIEN |
                  1 << I2C_CR_BIT_MSTA , pci_bar + REG_CR0);
 
-        for (bid = -1; bid < cnt; bid++) {
+        for (bid = first - 1; bid < cnt; bid++) {
 
             // Wait {A}
             error = i2c_wait_ack(adapter, 12, 0);
@@ -1406,7 +1517,7 @@ static int smbus_access(struct i2c_adapter *adapter, u16 addr,
                 SET_REG_BIT_H(pci_bar + REG_CR0, I2C_CR_BIT_TXAK);
             }
 
-            if (bid < 0) {
+            if (bid < first) {
                 ioread8(pci_bar + REG_DR0);
                 info( "READ Dummy Byte" );
             } else {
@@ -1442,17 +1553,210 @@ Done:
     return error;
 }
 
+/**
+ * Plain I2C transfer on the FPGA master: one START, the messages joined
+ * by repeated STARTs, and one STOP. A page of EEPROM is then a single
+ * transaction instead of a transfer per byte.
+ * Reads are supported as the last message only, which covers the
+ * [offset write][data read] pattern of the EEPROM drivers.
+ */
+static int i2c_raw_access(struct i2c_adapter *adapter,
+                          struct i2c_msg *msgs, int num)
+{
+    int error = 0;
+    int i, bid;
+    struct i2c_msg *msg;
+    struct i2c_dev_data *dev_data;
+    void __iomem *pci_bar;
+    unsigned int  portid, master_bus;
+    unsigned int REG_CR0;
+    unsigned int REG_SR0;
+    unsigned int REG_DR0;
+    unsigned int REG_ID0;
+
+    dev_data = i2c_get_adapdata(adapter);
+    portid = dev_data->portid;
+    pci_bar = fpga_dev.data_base_addr;
+    master_bus = dev_data->pca9548.master_bus;
+    REG_CR0   = I2C_MASTER_CTRL_1    + (master_bus - 1) * 0x0100;
+    REG_SR0   = I2C_MASTER_STATUS_1  + (master_bus - 1) * 0x0100;
+    REG_DR0   = I2C_MASTER_DATA_1    + (master_bus - 1) * 0x0100;
+    REG_ID0   = I2C_MASTER_PORT_ID_1 + (master_bus - 1) * 0x0100;
+
+    if (master_bus < I2C_MASTER_CH_1 || master_bus > I2C_MASTER_CH_TOTAL)
+        return -EINVAL;
+
+    for (i = 0; i < num; i++) {
+        if (msgs[i].flags & (I2C_M_TEN | I2C_M_RECV_LEN))
+            return -EOPNOTSUPP;
+        if ((msgs[i].flags & I2C_M_RD) && (i != num - 1 || msgs[i].len == 0))
+            return -EOPNOTSUPP;
+    }
+
+    iowrite8(portid, pci_bar + REG_ID0);
+
+    //Clear status register
+    iowrite8(0, pci_bar + REG_SR0);
+    atomic_set(&fpga_i2c_master_irq_status[master_bus - 1], 0);
+
+    for (i = 0; i < num; i++) {
+        msg = &msgs[i];
+
+        if (i == 0) {
+            ////[S]
+            iowrite8(1 << I2C_CR_BIT_MIEN | 1 << I2C_CR_BIT_MTX | 1 << I2C_CR_BIT_MSTA , pci_bar + REG_CR0);
+            SET_REG_BIT_H(pci_bar + REG_CR0, I2C_CR_BIT_MEN);
+        } else {
+            ////[Sr]
+            SET_REG_BIT_L(pci_bar + REG_CR0, I2C_CR_BIT_MEN);
+            iowrite8(1 << I2C_CR_BIT_MIEN |
+                     1 << I2C_CR_BIT_MTX |
+                     1 << I2C_CR_BIT_MSTA |
+                     1 << I2C_CR_BIT_RSTA , pci_bar + REG_CR0);
+            SET_REG_BIT_H(pci_bar + REG_CR0, I2C_CR_BIT_MEN);
+        }
+
+        //// [ADDR/RW]{A}
+        iowrite8(msg->addr << 1 | ((msg->flags & I2C_M_RD) ? 0x01 : 0x00), pci_bar + REG_DR0);
+        error = i2c_wait_ack(adapter, 12, 1);
+        if (error < 0)
+            goto Done;
+
+        if (!(msg->flags & I2C_M_RD)) {
+            //// [DATA]{A}
+            for (bid = 0; bid < msg->len; bid++) {
+                iowrite8(msg->buf[bid], pci_bar + REG_DR0);
+                error = i2c_wait_ack(adapter, 12, 1);
+                if (error < 0)
+                    goto Done;
+            }
+            continue;
+        }
+
+        //set to Receive mode
+        iowrite8(1 << I2C_CR_BIT_MEN |
+                 1 << I2C_CR_BIT_MIEN |
+                 1 << I2C_CR_BIT_MSTA , pci_bar + REG_CR0);
+
+        for (bid = -1; bid < msg->len; bid++) {
+            error = i2c_wait_ack(adapter, 12, 0);
+            if (error < 0)
+                goto Done;
+
+            if (bid == msg->len - 2)
+                SET_REG_BIT_H(pci_bar + REG_CR0, I2C_CR_BIT_TXAK);
+
+            if (bid < 0) {
+                ioread8(pci_bar + REG_DR0);
+            } else {
+                if (bid == msg->len - 1)
+                    SET_REG_BIT_L(pci_bar + REG_CR0, I2C_CR_BIT_MSTA);
+                msg->buf[bid] = ioread8(pci_bar + REG_DR0);
+            }
+        }
+    }
+
+    //[P]
+    SET_REG_BIT_L(pci_bar + REG_CR0, I2C_CR_BIT_MSTA);
+    i2c_wait_ack(adapter, 12, 0);
+
+Done:
+    iowrite8(1 << I2C_CR_BIT_MEN, pci_bar + REG_CR0);
+    return error < 0 ? error : num;
+}
+
+static void fpga_i2c_sched_init(unsigned int master_bus)
+{
+    struct fpga_i2c_sched *sched = &fpga_i2c_master_sched[master_bus - 1];
+
+    spin_lock_init(&sched->lock);
+    sched->busy = false;
+    sched->streak = 0;
+    INIT_LIST_HEAD(&sched->waiters);
+}
+
+/**
+ * Wait for the turn on the master, see fpga_i2c_sched_release().
+ */
+static void fpga_i2c_sched_acquire(unsigned int master_bus, uint16_t port)
+{
+    struct fpga_i2c_sched *sched = &fpga_i2c_master_sched[master_bus - 1];
+    struct fpga_i2c_waiter waiter;
+
+    spin_lock(&sched->lock);
+    if (!sched->busy) {
+        sched->busy = true;
+        spin_unlock(&sched->lock);
+        return;
+    }
+
+    waiter.port = port;
+    waiter.task = current;
+    waiter.granted = false;
+    list_add_tail(&waiter.list, &sched->waiters);
+    for (;;) {
+        set_current_state(TASK_UNINTERRUPTIBLE);
+        if (waiter.granted)
+            break;
+        spin_unlock(&sched->lock);
+        schedule();
+        spin_lock(&sched->lock);
+    }
+    __set_current_state(TASK_RUNNING);
+    spin_unlock(&sched->lock);
+}
+
+/**
+ * Hand the master to the next waiter, preferring one on the mux channel
+ * left selected by the previous transfer.
+ */
+static void fpga_i2c_sched_release(unsigned int master_bus)
+{
+    struct fpga_i2c_sched *sched = &fpga_i2c_master_sched[master_bus - 1];
+    uint16_t selected = fpga_i2c_lasted_access_port[master_bus - 1];
+    struct fpga_i2c_waiter *waiter, *next = NULL;
+
+    spin_lock(&sched->lock);
+    if (mux_batch && sched->streak < mux_batch) {
+        list_for_each_entry(waiter, &sched->waiters, list) {
+            if (waiter->port == selected) {
+                next = waiter;
+                break;
+            }
+        }
+    }
+
+    if (next && next != list_first_entry(&sched->waiters, struct fpga_i2c_waiter, list)) {
+        sched->streak++;
+    } else {
+        next = list_first_entry_or_null(&sched->waiters, struct fpga_i2c_waiter, list);
+        sched->streak = 0;
+    }
+
+    if (next) {
+        list_del(&next->list);
+        next->granted = true;
+        wake_up_process(next->task);
+    } else {
+        sched->busy = false;
+    }
+    spin_unlock(&sched->lock);
+}
+
 /**
  * Wrapper of smbus_access access with PCA9548 I2C switch management.
  * This function set PCA9548 switches to the proper slave channel.
  * Only one channel among switches chip is selected during communication time.
+ * When msgs is set, the plain I2C messages are sent instead of the SMBus
+ * command.
  *
  * Note: If the bus does not have any PCA9548 on it, the switch_addr must be
  * set to 0xFF, it will use normal smbus_access function.
  */
-static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
-                           unsigned short flags, char rw, u8 cmd,
-                           int size, union i2c_smbus_data *data)
+static int fpga_i2c_mux_access(struct i2c_adapter *adapter, u16 addr,
+                               unsigned short flags, char rw, u8 cmd,
+                               int size, union i2c_smbus_data *data,
+                               struct i2c_msg *msgs, int num)
 {
     int error = 0;
     struct i2c_dev_data *dev_data;
@@ -1463,6 +1767,9 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
     unsigned char prev_switch;
     unsigned char prev_ch;
     int retry;
+    struct fpga_i2c_stats *stats;
+    ktime_t start;
+    u64 elapsed;
 
     dev_data = i2c_get_adapdata(adapter);
     master_bus = dev_data->pca9548.master_bus;
@@ -1470,7 +1777,10 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
     channel = dev_data->pca9548.channel;
 
     // Acquire the master resource.
+    fpga_i2c_sched_acquire(master_bus, switch_addr != 0xFF ? switch_addr << 8 | channel : 0);
     mutex_lock(&fpga_i2c_master_locks[master_bus - 1]);
+    stats = &fpga_i2c_master_stats[master_bus - 1];
+    start = ktime_get();
     prev_port = fpga_i2c_lasted_access_port[master_bus - 1];
     prev_switch = (unsigned char)(prev_port >> 8) & 0xFF;
     prev_ch = (unsigned char)(prev_port & 0xFF);
@@ -1482,6 +1792,7 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
             // reset prev_port PCA9548 chip
             retry = 3;
             while(retry--){
+                stats->mux_writes++;
                 error = smbus_access(adapter, (u16)(prev_switch), flags, I2C_SMBUS_WRITE, 0x00, I2C_SMBUS_BYTE, NULL);
                 if(error >= 0){
                     break;
@@ -1489,11 +1800,14 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
                     dev_dbg(&adapter->dev,"Failed to deselect ch %d of 0x%x, CODE %d\n", prev_ch, prev_switch, error);
                 }
             }
-            if(retry == 0)
+            if(error < 0)
                 goto release_unlock;
+            // nothing is selected until the new channel is set
+            fpga_i2c_lasted_access_port[master_bus - 1] = 0;
             // set PCA9548 to current channel
             retry = 3;
             while(retry--){
+                stats->mux_writes++;
                 error = smbus_access(adapter, switch_addr, flags, I2C_SMBUS_WRITE, 1 << channel, I2C_SMBUS_BYTE, NULL);
                 if(error >= 0){
                     break;
@@ -1501,7 +1815,7 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
                     dev_dbg(&adapter->dev,"Failed to select ch %d of 0x%x, CODE %d\n", channel, switch_addr, error);
                 }
             }
-            if(retry == 0)
+            if(error < 0)
                 goto release_unlock;
             // update lasted port
             fpga_i2c_lasted_access_port[master_bus - 1] = switch_addr << 8 | channel;
@@ -1512,6 +1826,7 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
                 // set new PCA9548 at switch_addr to current
                 retry = 3;
                 while(retry--){
+                    stats->mux_writes++;
                     error = smbus_access(adapter, switch_addr, flags, I2C_SMBUS_WRITE, 1 << channel, I2C_SMBUS_BYTE, NULL);
                     if(error >= 0){
                         break;
@@ -1519,7 +1834,7 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
                         dev_dbg(&adapter->dev,"Failed to select ch %d of 0x%x, CODE %d\n", channel, switch_addr, error);
                     }
                 }
-                if(retry == 0)
+                if(error < 0)
                     goto release_unlock;
                 // update lasted port
                 fpga_i2c_lasted_access_port[master_bus - 1] = switch_addr << 8 | channel;
@@ -1527,6 +1842,14 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
         }
     }
 
+    if (msgs) {
+        error = i2c_raw_access(adapter, msgs, num);
+        if (error < 0)
+            dev_dbg(&adapter->dev, "i2c_xfer failed (%d) @ 0x%2.2X, %d msgs\n",
+                    error, msgs[0].addr, num);
+        goto release_unlock;
+    }
+
     // Do SMBus communication
     error = smbus_access(adapter, addr, flags, rw, cmd, size, data);
     if(error < 0){
@@ -1543,11 +1866,33 @@ static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
     }
 
 release_unlock:
+    elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+    stats->xfers++;
+    stats->total_ns += elapsed;
+    if (elapsed > stats->max_ns)
+        stats->max_ns = elapsed;
+    if (error < 0)
+        stats->errors++;
     mutex_unlock(&fpga_i2c_master_locks[master_bus - 1]);
+    fpga_i2c_sched_release(master_bus);
     dev_dbg(&adapter->dev,"switch ch %d of 0x%x -> ch %d of 0x%x\n", prev_ch, prev_switch, channel, switch_addr);
     return error;
 }
 
+static int fpga_i2c_access(struct i2c_adapter *adapter, u16 addr,
+                           unsigned short flags, char rw, u8 cmd,
+                           int size, union i2c_smbus_data *data)
+{
+    return fpga_i2c_mux_access(adapter, addr, flags, rw, cmd, size, data, NULL, 0);
+}
+
+static int fpga_i2c_xfer(struct i2c_adapter *adapter, struct i2c_msg *msgs, int num)
+{
+    if (num <= 0)
+        return -EINVAL;
+    return fpga_i2c_mux_access(adapter, msgs[0].addr, 0, 0, 0, 0, NULL, msgs, num);
+}
+
 
 
 /**
@@ -1555,14 +1900,17 @@ release_unlock:
  */
 static u32 fpga_i2c_func(struct i2c_adapter *a)
 {
-    return I2C_FUNC_SMBUS_QUICK  |
+    return I2C_FUNC_I2C             |
+           I2C_FUNC_SMBUS_QUICK     |
            I2C_FUNC_SMBUS_BYTE      |
            I2C_FUNC_SMBUS_BYTE_DATA |
            I2C_FUNC_SMBUS_WORD_DATA |
-           I2C_FUNC_SMBUS_BLOCK_DATA;
+           I2C_FUNC_SMBUS_BLOCK_DATA |
+           I2C_FUNC_SMBUS_I2C_BLOCK;
 }
 
 static const struct i2c_algorithm silverstone_i2c_algorithm = {
+    .master_xfer = fpga_i2c_xfer,
     .smbus_xfer = fpga_i2c_access,
     .functionality  = fpga_i2c_func,
 };
@@ -1681,6 +2029,7 @@ static int silverstone_drv_probe(struct platform_device *pdev)
     mutex_init(&fpga_data->fpga_lock);
     for (ret = I2C_MASTER_CH_1 ; ret <= I2C_MASTER_CH_TOTAL; ret++) {
         mutex_init(&fpga_i2c_master_locks[ret - 1]);
+        fpga_i2c_sched_init(ret);
     }
 
     fpga = kobject_create_and_add("FPGA", &pdev->dev.kobj);
@@ -1894,6 +2243,94 @@ static const struct pci_device_id fpga_id_table[] = {
 
 MODULE_DEVICE_TABLE(pci, fpga_id_table);
 
+/**
+ * Latch and clear the status of every master that raised MIF, then wake
+ * up its waiter in i2c_wait_irq().
+ */
+static irqreturn_t fpga_i2c_isr(int irq, void *dev_id)
+{
+    struct fpga_device *fpga = dev_id;
+    irqreturn_t ret = IRQ_NONE;
+    unsigned int master_bus;
+    void __iomem *reg_sr;
+    u8 Status;
+
+    for (master_bus = I2C_MASTER_CH_1; master_bus <= I2C_MASTER_CH_TOTAL; master_bus++) {
+        reg_sr = fpga->data_base_addr + I2C_MASTER_STATUS_1 + (master_bus - 1) * 0x0100;
+        Status = ioread8(reg_sr);
+        if (!(Status & (1 << I2C_SR_BIT_MIF)))
+            continue;
+
+        iowrite8(0, reg_sr);
+        atomic_or(Status, &fpga_i2c_master_irq_status[master_bus - 1]);
+        fpga_i2c_master_stats[master_bus - 1].irqs++;
+        wake_up(&fpga_i2c_master_wq[master_bus - 1]);
+        ret = IRQ_HANDLED;
+    }
+    return ret;
+}
+
+static void fpga_i2c_irq_init(struct pci_dev *pdev)
+{
+    int master;
+    int err;
+
+    for (master = 0; master < I2C_MASTER_CH_TOTAL; master++) {
+        init_waitqueue_head(&fpga_i2c_master_wq[master]);
+        atomic_set(&fpga_i2c_master_irq_status[master], 0);
+    }
+
+    if (!i2c_irq_mode)
+        return;
+
+    if (pdev->irq <= 0) {
+        dev_warn(&pdev->dev, "no irq assigned, I2C masters stay in polling mode\n");
+        return;
+    }
+
+    err = request_irq(pdev->irq, fpga_i2c_isr, IRQF_SHARED, FPGA_PCI_NAME, &fpga_dev);
+    if (err) {
+        dev_warn(&pdev->dev, "request_irq %d failed (%d), I2C masters stay in polling mode\n",
+                 pdev->irq, err);
+        return;
+    }
+    fpga_dev.irq = pdev->irq;
+    dev_info(&pdev->dev, "I2C masters use irq %d\n", fpga_dev.irq);
+}
+
+static int fpga_i2c_stats_show(struct seq_file *m, void *v)
+{
+    int master;
+    struct fpga_i2c_stats stats;
+
+    seq_printf(m, "mode: %s\n", fpga_dev.irq > 0 ? "irq" : "polling");
+    seq_printf(m, "%-6s %10s %8s %10s %10s %10s %10s\n",
+               "master", "xfers", "errors", "mux_writes", "avg_us", "max_us", "irqs");
+    for (master = 0; master < I2C_MASTER_CH_TOTAL; master++) {
+        mutex_lock(&fpga_i2c_master_locks[master]);
+        stats = fpga_i2c_master_stats[master];
+        mutex_unlock(&fpga_i2c_master_locks[master]);
+        seq_printf(m, "%-6d %10llu %8llu %10llu %10llu %10llu %10llu\n", master + 1,
+                   stats.xfers, stats.errors, stats.mux_writes,
+                   stats.xfers ? div64_u64(stats.total_ns, stats.xfers) / NSEC_PER_USEC : 0,
+                   div64_u64(stats.max_ns, NSEC_PER_USEC), stats.irqs);
+    }
+    return 0;
+}
+
+static int fpga_i2c_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, fpga_i2c_stats_show, inode->i_private);
+}
+
+static const struct file_operations fpga_i2c_stats_fops = {
+    .owner      = THIS_MODULE,
+    .open       = fpga_i2c_stats_open,
+    .read       = seq_read,
+    .llseek     = seq_lseek,
+    .release    = single_release,
+};
+
 static int fpga_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id)
 {
     int err;
@@ -1934,6 +2371,11 @@ static int fpga_pci_probe(struct pci_dev *pdev, const struct pci_device_id *id)
     printk(KERN_INFO "");
     fpga_version = ioread32(fpga_dev.data_base_addr);
     printk(KERN_INFO "FPGA VERSION : %8.8x\n", fpga_version);
+    fpga_i2c_irq_init(pdev);
+    fpga_debugfs_dir = debugfs_create_dir(DRIVER_NAME, NULL);
+    if (!IS_ERR_OR_NULL(fpga_debugfs_dir))
+        debugfs_create_file("i2c_stats", 0444, fpga_debugfs_dir, NULL,
+                            &fpga_i2c_stats_fops);
     fpgafw_init();
     platform_device_register(&silverstone_dev);
     platform_driver_register(&silverstone_drv);
@@ -1951,6 +2393,11 @@ static void fpga_pci_remove(struct pci_dev *pdev)
     platform_driver_unregister(&silverstone_drv);
     platform_device_unregister(&silverstone_dev);
     fpgafw_exit();
+    debugfs_remove_recursive(fpga_debugfs_dir);
+    if (fpga_dev.irq > 0) {
+        free_irq(fpga_dev.irq, &fpga_dev);
+        fpga_dev.irq = 0;
+    }
     pci_iounmap(pdev, fpga_dev.data_base_addr);
     pci_release_regions(pdev);
     pci_disable_device(pdev);
@@ -22,6 +22,7 @@
 #include <linux/gpio.h>
 #include <linux/mfd/lpc_ich.h>
 #include <linux/acpi.h>
+#include <linux/notifier.h>
 
 #define DRV_NAME "dell_ich"
 
@@ -691,6 +692,25 @@ static struct attribute_group sci_attrs_group= {
     .attrs = sci_attrs,
 };
 
+/*
+ * Drivers of the devices behind GPIO SUS6 (the QSFP presence CPLDs)
+ * are told about each SUS6 SCI, before the user space clients. The
+ * callbacks run in the SCI handler and must not sleep.
+ */
+static ATOMIC_NOTIFIER_HEAD(dell_ich_sus6_notifier);
+
+int dell_ich_register_sus6_notifier(struct notifier_block *nb)
+{
+    return atomic_notifier_chain_register(&dell_ich_sus6_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(dell_ich_register_sus6_notifier);
+
+int dell_ich_unregister_sus6_notifier(struct notifier_block *nb)
+{
+    return atomic_notifier_chain_unregister(&dell_ich_sus6_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(dell_ich_unregister_sus6_notifier);
+
 static u32 dell_ich_sci_handler(void *context)
 {
     unsigned int data;
@@ -707,6 +727,8 @@ static u32 dell_ich_sci_handler(void *context)
 	// Clear the SUS6 status
         IO_REG_WRITE(data,ACPI_GPE0a_STS,ich_data->acpi_base);
         ich_data->int_gpio_sus6_count++;
+        atomic_notifier_call_chain(&dell_ich_sus6_notifier,
+                                   ich_data->int_gpio_sus6_count, NULL);
 	// and notify the user space clients
 	sysfs_notify(&dev->kobj, NULL, "sci_int_gpio_sus6");
 	return ACPI_INTERRUPT_HANDLED;
@@ -24,6 +24,10 @@
 #include <linux/hwmon-sysfs.h>
 #include <linux/acpi.h>
 #include <linux/bitops.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+#include <linux/ktime.h>
+#include <asm/unaligned.h>
 
 #define SIO_DRVNAME             "SMF"
 #define DEBUG                   1
@@ -180,10 +184,32 @@
 #define CPU_IOM3_CTRL_FLAG 0x04DB
 #define CPU_IOM4_CTRL_FLAG 0x04DC
 
+/* Sensor register snapshot, indexed by SMF register address */
+#define SMF_SNAP_SIZE           (IO_MODULE_PRESENCE + 1)
+/* Refresh time and age trailer appended to the smf_snapshot image */
+#define SMF_SNAP_TRAILER_SIZE   12
+#define SMF_SNAP_IMAGE_SIZE     (SMF_SNAP_SIZE + SMF_SNAP_TRAILER_SIZE)
+
 unsigned long  *mmio;
 static struct kobject *dell_kobj;
 static unsigned short force_id;
 module_param(force_id, ushort, 0);
+static unsigned int snapshot_ms = 1000;
+module_param(snapshot_ms, uint, 0644);
+MODULE_PARM_DESC(snapshot_ms, "Sensor snapshot refresh in ms, 0 reads the SMF directly");
+
+/*
+ * Sensor ranges refreshed by the snapshot work: temperatures, fans,
+ * PSUs, voltages, currents and module status. The FAN/PSU EEPROM and
+ * the reset/power-on reason registers are always read directly.
+ */
+static const struct {
+        u16 start;
+        u16 end;
+} smf_snap_ranges[] = {
+        { TEMP_SENSOR_1, FAN_TRAY_AIRFLOW },
+        { MAX_NUM_PSUS, IO_MODULE_PRESENCE },
+};
 int smf_ver;
 
 
@@ -461,6 +487,12 @@ struct smf_data {
         const char * const *curr_label;
         const char * const *fan_label;
         const char * const *psu_label;
+        struct delayed_work snap_work;
+        spinlock_t snap_lock;           /* Protects snap, snap_valid and snap_time */
+        bool snap_valid;
+        ktime_t snap_time;
+        u8 snap[SMF_SNAP_SIZE];
+        u8 snap_scratch[SMF_SNAP_SIZE];
 };
 
 
@@ -469,9 +501,39 @@ struct smf_sio_data {
         enum kinds kind;
 };
 
+static bool smf_reg_in_snap(u16 reg)
+{
+        int i;
+
+        for (i = 0; i < ARRAY_SIZE(smf_snap_ranges); i++) {
+                if (reg >= smf_snap_ranges[i].start && reg <= smf_snap_ranges[i].end)
+                        return true;
+        }
+        return false;
+}
+
+/* Returns the cached register pair, or -EAGAIN to read the SMF instead */
+static int smf_read_snap(struct smf_data *data, u16 reg, int len)
+{
+        unsigned long flags;
+        int res = -EAGAIN;
+
+        if (!snapshot_ms || !smf_reg_in_snap(reg) ||
+                        (len == 2 && !smf_reg_in_snap(reg + 1)))
+                return res;
+
+        spin_lock_irqsave(&data->snap_lock, flags);
+        if (data->snap_valid)
+                res = (len == 2) ? (data->snap[reg] << 8) + data->snap[reg + 1] :
+                        data->snap[reg];
+        spin_unlock_irqrestore(&data->snap_lock, flags);
+        return res;
+}
+
 static int smf_write_reg(struct smf_data *data, u16 reg, u16 dev_data)
 {
         int res = 0;
+        unsigned long flags;
 
         mutex_lock(&data->lock);
         outb_p(reg>> 8, data->addr + SMF_ADDR_REG_OFFSET);
@@ -479,6 +541,25 @@ static int smf_write_reg(struct smf_data *data, u16 reg, u16 dev_data)
         outb_p(dev_data & 0xff, data->addr + SMF_WRITE_DATA_REG_OFFSET);
         mutex_unlock(&data->lock);
 
+        /* Read the SMF directly until the next refresh */
+        if (smf_reg_in_snap(reg)) {
+                spin_lock_irqsave(&data->snap_lock, flags);
+                data->snap_valid = false;
+                spin_unlock_irqrestore(&data->snap_lock, flags);
+        }
+
+        return res;
+}
+
+static int __smf_read_reg(struct smf_data *data, u16 reg)
+{
+        int res;
+
+        mutex_lock(&data->lock);
+        outb_p(reg>> 8, data->addr + SMF_ADDR_REG_OFFSET);
+        outb_p(reg & 0xff, data->addr + SMF_ADDR_REG_OFFSET + 1);
+        res = inb_p(data->addr + SMF_READ_DATA_REG_OFFSET);
+        mutex_unlock(&data->lock);
         return res;
 }
 
@@ -486,12 +567,10 @@ static int smf_read_reg(struct smf_data *data, u16 reg)
 { 
         int res; 
 
-        mutex_lock(&data->lock); 
-        outb_p(reg>> 8, data->addr + SMF_ADDR_REG_OFFSET); 
-        outb_p(reg & 0xff, data->addr + SMF_ADDR_REG_OFFSET + 1); 
-        res = inb_p(data->addr + SMF_READ_DATA_REG_OFFSET); 
-        mutex_unlock(&data->lock); 
-        return res; 
+        res = smf_read_snap(data, reg, 1);
+        if (res >= 0)
+                return res;
+        return __smf_read_reg(data, reg);
 } 
 
 
@@ -499,6 +578,10 @@ static int smf_read_reg16(struct smf_data *data, u16 reg)
 {
         int res;
 
+        res = smf_read_snap(data, reg, 2);
+        if (res >= 0)
+                return res;
+
         mutex_lock(&data->lock);
         outb_p(reg>> 8, data->addr + SMF_ADDR_REG_OFFSET);
         outb_p(reg & 0xff, data->addr + SMF_ADDR_REG_OFFSET + 1);
@@ -514,6 +597,79 @@ static int smf_read_reg16(struct smf_data *data, u16 reg)
         return res;
 }
 
+static void smf_snap_work(struct work_struct *work)
+{
+        struct smf_data *data = container_of(to_delayed_work(work),
+                        struct smf_data, snap_work);
+        unsigned long flags;
+        int i;
+        u16 reg;
+
+        if (!snapshot_ms) {
+                schedule_delayed_work(&data->snap_work, HZ);
+                return;
+        }
+
+        /* Fill the scratch copy first, readers keep the last snapshot */
+        for (i = 0; i < ARRAY_SIZE(smf_snap_ranges); i++) {
+                for (reg = smf_snap_ranges[i].start; reg <= smf_snap_ranges[i].end; reg++)
+                        data->snap_scratch[reg] = __smf_read_reg(data, reg);
+        }
+
+        spin_lock_irqsave(&data->snap_lock, flags);
+        memcpy(data->snap, data->snap_scratch, sizeof(data->snap));
+        data->snap_valid = true;
+        data->snap_time = ktime_get_boottime();
+        spin_unlock_irqrestore(&data->snap_lock, flags);
+
+        schedule_delayed_work(&data->snap_work, msecs_to_jiffies(snapshot_ms));
+}
+
+/*
+ * Raw image of the snapshot, the file offset is the SMF register
+ * address. Bytes outside smf_snap_ranges read as zero. The registers
+ * are followed by a trailer, both little endian: the refresh time in
+ * ms since boot (u64) and the age of the snapshot in ms when it was
+ * read (u32). A reader that gets the whole image in one read gets the
+ * registers and the trailer of the same refresh.
+ */
+static ssize_t smf_snapshot_read(struct file *filp, struct kobject *kobj,
+                struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+        struct smf_data *data = dev_get_drvdata(kobj_to_dev(kobj));
+        u8 trailer[SMF_SNAP_TRAILER_SIZE];
+        unsigned long flags;
+        s64 age;
+        size_t len = 0;
+
+        if (off >= SMF_SNAP_IMAGE_SIZE)
+                return 0;
+        if (count > SMF_SNAP_IMAGE_SIZE - off)
+                count = SMF_SNAP_IMAGE_SIZE - off;
+
+        spin_lock_irqsave(&data->snap_lock, flags);
+        if (!data->snap_valid) {
+                spin_unlock_irqrestore(&data->snap_lock, flags);
+                return -EAGAIN;
+        }
+        age = ktime_ms_delta(ktime_get_boottime(), data->snap_time);
+        put_unaligned_le64(ktime_to_ms(data->snap_time), trailer);
+        put_unaligned_le32(clamp_t(s64, age, 0, U32_MAX), trailer + 8);
+
+        if (off < SMF_SNAP_SIZE) {
+                len = min_t(size_t, count, SMF_SNAP_SIZE - off);
+                memcpy(buf, data->snap + off, len);
+                off += len;
+        }
+        if (len < count)
+                memcpy(buf + len, trailer + (off - SMF_SNAP_SIZE), count - len);
+        spin_unlock_irqrestore(&data->snap_lock, flags);
+
+        return count;
+}
+
+static BIN_ATTR(smf_snapshot, S_IRUGO, smf_snapshot_read, NULL, SMF_SNAP_IMAGE_SIZE);
+
 /* SMF Version */
 static ssize_t show_smf_version(struct device *dev,
                 struct device_attribute *devattr, char *buf)
@@ -2160,6 +2316,9 @@ static int smf_probe(struct platform_device *pdev)
                 return -ENOMEM;
 
         mutex_init(&data->lock); 
+        spin_lock_init(&data->snap_lock);
+        INIT_DELAYED_WORK(&data->snap_work, smf_snap_work);
+        platform_set_drvdata(pdev, data);
 
         /* PSU attributes */
         data->psu_mask = smf_devices[data->kind].psu_mask;
@@ -2184,15 +2343,25 @@ static int smf_probe(struct platform_device *pdev)
         data->hwmon_dev = devm_hwmon_device_register_with_groups(dev,
                         smf_devices[data->kind].name,
                         data, smf_groups);
+        if (IS_ERR(data->hwmon_dev))
+                return PTR_ERR(data->hwmon_dev);
+
+        err = device_create_bin_file(dev, &bin_attr_smf_snapshot);
+        if (err)
+                return err;
 
-        return PTR_ERR_OR_ZERO(data->hwmon_dev);
+        schedule_delayed_work(&data->snap_work, 0);
+        return 0;
 }
 
 
 static int smf_remove(struct platform_device *pdev)
 {
+        struct smf_data *data = platform_get_drvdata(pdev);
         struct resource *res;
 
+        cancel_delayed_work_sync(&data->snap_work);
+        device_remove_bin_file(&pdev->dev, &bin_attr_smf_snapshot);
         res = platform_get_resource(pdev, IORESOURCE_IO, 0);
         release_region(res->start, IOREGION_LENGTH);
         return 0;
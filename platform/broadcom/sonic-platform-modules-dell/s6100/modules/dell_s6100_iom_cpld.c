@@ -6,6 +6,9 @@
 #include <linux/i2c.h>
 #include <linux/slab.h>
 #include <linux/list.h>
+#include <linux/interrupt.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
 
 
 //iom cpld slave address
@@ -44,9 +47,24 @@
 #define  QSFP_ABS_MASK0    0x28
 #define  QSFP_ABS_MASK1    0x29
 
+/*
+ * Transceiver presence changes are latched in the driver and signaled
+ * with sysfs_notify() on qsfp_modprs_event. The IOM CPLD interrupt is
+ * used when the client has an IRQ, otherwise qsfp_modprs is read every
+ * modprs_poll_ms.
+ */
+static unsigned int modprs_poll_ms = 200;
+module_param(modprs_poll_ms, uint, 0444);
+MODULE_PARM_DESC(modprs_poll_ms, "qsfp_modprs poll interval (ms) when the IOM CPLD has no IRQ, 0 to disable");
+
 struct cpld_data {
     struct i2c_client *client;
     struct mutex  update_lock;
+    struct delayed_work modprs_work;
+    int irq;
+    u16 modprs;
+    atomic_t modprs_events;
+    bool use_i2c;
 };
 
 
@@ -97,6 +115,100 @@ int dell_s6100_iom_cpld_write(struct cpld_data *data,unsigned short cpld_addr, u
 
     return ret;
 }
+
+/*
+ * Reads len adjacent registers from reg under one lock hold: a single
+ * address write and block read when the adapter does plain I2C,
+ * otherwise one address set and read per register.
+ */
+static int dell_s6100_iom_cpld_read_seq(struct cpld_data *data, u8 reg, u8 *buf, int len)
+{
+    u8 addr[2] = { 0x00, reg };
+    struct i2c_msg msgs[2] = {
+        { .addr = data->client->addr, .flags = 0, .len = sizeof(addr), .buf = addr },
+        { .addr = data->client->addr, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+    int ret = 0;
+    int i;
+
+    mutex_lock(&data->update_lock);
+    if (data->use_i2c) {
+        ret = i2c_transfer(data->client->adapter, msgs, ARRAY_SIZE(msgs));
+        ret = ret == ARRAY_SIZE(msgs) ? 0 : (ret < 0 ? ret : -EIO);
+    } else {
+        for (i = 0; i < len; i++) {
+            ret = i2c_smbus_write_byte_data(data->client, 0x00, reg + i);
+            if (ret < 0)
+                break;
+            ret = i2c_smbus_read_byte(data->client);
+            if (ret < 0)
+                break;
+            buf[i] = (u8)ret;
+            ret = 0;
+        }
+    }
+    mutex_unlock(&data->update_lock);
+
+    return ret;
+}
+
+/* 16-bit register pair, low byte at reg */
+static int dell_s6100_iom_cpld_read16(struct cpld_data *data, u8 reg)
+{
+    u8 buf[2];
+    int ret;
+
+    ret = dell_s6100_iom_cpld_read_seq(data, reg, buf, sizeof(buf));
+    if (ret < 0)
+        return ret;
+
+    return buf[0] | (buf[1] << 8);
+}
+
+static ssize_t show_reg16(struct cpld_data *data, u8 reg, char *buf)
+{
+    int ret;
+
+    ret = dell_s6100_iom_cpld_read16(data, reg);
+    if(ret < 0)
+        return sprintf(buf, "read error");
+
+    return sprintf(buf,"0x%04x\n",ret);
+}
+
+static void dell_s6100_iom_cpld_update_modprs(struct cpld_data *data)
+{
+    int ret;
+
+    ret = dell_s6100_iom_cpld_read16(data, QSFP_MOD_PRS_REG0);
+    if(ret < 0 || (u16)ret == data->modprs)
+        return;
+
+    data->modprs = (u16)ret;
+    atomic_inc(&data->modprs_events);
+    sysfs_notify(&data->client->dev.kobj, NULL, "qsfp_modprs_event");
+}
+
+static irqreturn_t dell_s6100_iom_cpld_irq(int irq, void *dev_id)
+{
+    struct cpld_data *data = dev_id;
+
+    /* Reading the latched absent interrupts acknowledges them */
+    dell_s6100_iom_cpld_read16(data, QSFP_ABS_INT0);
+    dell_s6100_iom_cpld_update_modprs(data);
+
+    return IRQ_HANDLED;
+}
+
+static void dell_s6100_iom_cpld_modprs_work(struct work_struct *work)
+{
+    struct cpld_data *data = container_of(to_delayed_work(work),
+                                          struct cpld_data, modprs_work);
+
+    dell_s6100_iom_cpld_update_modprs(data);
+    schedule_delayed_work(&data->modprs_work, msecs_to_jiffies(modprs_poll_ms));
+}
+
 static ssize_t get_cpldver(struct device *dev, struct device_attribute *devattr, char *buf) 
 {
     int ret;
@@ -110,61 +222,54 @@ static ssize_t get_cpldver(struct device *dev, struct device_attribute *devattr,
     return sprintf(buf,"IOM CPLD Version:0x%02x\n",devdata);
 }
 
-static ssize_t get_modprs(struct device *dev, struct device_attribute *devattr, char *buf) 
+static ssize_t get_modprs(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_MOD_PRS_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
+    return show_reg16(data, QSFP_MOD_PRS_REG0, buf);
+}
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_MOD_PRS_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
+static ssize_t get_modprs_event(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+    struct cpld_data *data = dev_get_drvdata(dev);
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return sprintf(buf,"%u\n",atomic_read(&data->modprs_events));
 }
 
-static ssize_t get_lpmode(struct device *dev, struct device_attribute *devattr, char *buf) 
+/*
+ * Presence, interrupt status, lpmode and reset of all the QSFPs of the
+ * IOM, read together from QSFP_RST_CRTL_REG0..QSFP_MOD_PRS_REG1:
+ * "<modprs> <int_sta> <lpmode> <reset>"
+ */
+static ssize_t get_qsfp_status(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
+    u8 regs[QSFP_MOD_PRS_REG1 - QSFP_RST_CRTL_REG0 + 1];
     struct cpld_data *data = dev_get_drvdata(dev);
+    int ret;
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_LPMODE_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_LPMODE_REG1);
+#define REG16(reg) (regs[(reg) - QSFP_RST_CRTL_REG0] | (regs[(reg) + 1 - QSFP_RST_CRTL_REG0] << 8))
+    ret = dell_s6100_iom_cpld_read_seq(data, QSFP_RST_CRTL_REG0, regs, sizeof(regs));
     if(ret < 0)
         return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return sprintf(buf,"0x%04x 0x%04x 0x%04x 0x%04x\n",
+                   REG16(QSFP_MOD_PRS_REG0), REG16(QSFP_INT_STA_REG0),
+                   REG16(QSFP_LPMODE_REG0), REG16(QSFP_RST_CRTL_REG0));
+#undef REG16
 }
 
-static ssize_t get_reset(struct device *dev, struct device_attribute *devattr, char *buf) 
+static ssize_t get_lpmode(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_RST_CRTL_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
+    return show_reg16(data, QSFP_LPMODE_REG0, buf);
+}
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_RST_CRTL_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
+static ssize_t get_reset(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+    struct cpld_data *data = dev_get_drvdata(dev);
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_RST_CRTL_REG0, buf);
 }
 
 static ssize_t set_lpmode(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count) 
@@ -201,40 +306,16 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr, c
 
 static ssize_t get_int_sta(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT_STA_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT_STA_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT_STA_REG0, buf);
 }
 
 static ssize_t get_abs_sta(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_STA_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_STA_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_ABS_STA_REG0, buf);
 }
 
 static ssize_t get_trig_mod(struct device *dev, struct device_attribute *devattr, char *buf)
@@ -280,59 +361,23 @@ static ssize_t get_int_combine(struct device *dev, struct device_attribute *deva
 
 static ssize_t get_int(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT0, buf);
 }
 
 static ssize_t get_abs_int(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_INT0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_INT1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_ABS_INT0, buf);
 }
 
 static ssize_t get_int_mask(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT_MASK0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_INT_MASK1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT_MASK0, buf);
 }
 
 static ssize_t set_int_mask(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
@@ -353,21 +398,9 @@ static ssize_t set_int_mask(struct device *dev, struct device_attribute *devattr
 
 static ssize_t get_abs_mask(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_MASK0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_s6100_iom_cpld_read(data,IOM_CPLD_SLAVE_ADD,QSFP_ABS_MASK1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_ABS_MASK0, buf);
 }
 
 static ssize_t set_abs_mask(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
@@ -416,6 +449,8 @@ static ssize_t set_sep_reset(struct device *dev, struct device_attribute *devatt
 
 static DEVICE_ATTR(iom_cpld_vers,S_IRUGO,get_cpldver, NULL);
 static DEVICE_ATTR(qsfp_modprs, S_IRUGO,get_modprs, NULL);
+static DEVICE_ATTR(qsfp_modprs_event, S_IRUGO,get_modprs_event, NULL);
+static DEVICE_ATTR(qsfp_status, S_IRUGO, get_qsfp_status, NULL);
 static DEVICE_ATTR(qsfp_lpmode, S_IRUGO | S_IWUSR,get_lpmode,set_lpmode);
 static DEVICE_ATTR(qsfp_reset,  S_IRUGO | S_IWUSR,get_reset, set_reset);
 static DEVICE_ATTR(qsfp_int_sta, S_IRUGO, get_int_sta, NULL);
@@ -432,6 +467,8 @@ static struct attribute *i2c_cpld_attrs[] = {
     &dev_attr_qsfp_lpmode.attr,
     &dev_attr_qsfp_reset.attr,
     &dev_attr_qsfp_modprs.attr,
+    &dev_attr_qsfp_modprs_event.attr,
+    &dev_attr_qsfp_status.attr,
     &dev_attr_iom_cpld_vers.attr,
     &dev_attr_qsfp_int_sta.attr,
     &dev_attr_qsfp_abs_sta.attr,
@@ -453,6 +490,8 @@ static int dell_s6100_iom_cpld_probe(struct i2c_client *client,
         const struct i2c_device_id *dev_id)
 {
     int status;
+    int ret;
+    struct cpld_data *data;
 
     if (!i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA)) {
         dev_dbg(&client->dev, "i2c_check_functionality failed (0x%x)\n", client->addr);
@@ -462,12 +501,40 @@ static int dell_s6100_iom_cpld_probe(struct i2c_client *client,
 
     dev_info(&client->dev, "chip found\n");
     dell_s6100_iom_cpld_add_client(client);
+    data = i2c_get_clientdata(client);
+    if (!data) {
+        status = -ENOMEM;
+        goto exit;
+    }
+    data->use_i2c = i2c_check_functionality(client->adapter, I2C_FUNC_I2C);
 
     /* Register sysfs hooks */
     status = sysfs_create_group(&client->dev.kobj, &i2c_cpld_attr_grp);
     if (status) {
         printk(KERN_INFO "Cannot create sysfs\n");
     }
+
+    /* If the IOM is not present the read fails, as for qsfp_modprs */
+    ret = dell_s6100_iom_cpld_read16(data, QSFP_MOD_PRS_REG0);
+    data->modprs = ret < 0 ? 0 : (u16)ret;
+    INIT_DELAYED_WORK(&data->modprs_work, dell_s6100_iom_cpld_modprs_work);
+
+    if (client->irq > 0) {
+        ret = devm_request_threaded_irq(&client->dev, client->irq, NULL,
+                                        dell_s6100_iom_cpld_irq,
+                                        IRQF_ONESHOT | IRQF_SHARED,
+                                        dev_name(&client->dev), data);
+        if (ret == 0) {
+            data->irq = client->irq;
+            return 0;
+        }
+        dev_warn(&client->dev, "Cannot request IRQ %d (%d), polling qsfp_modprs\n",
+                 client->irq, ret);
+    }
+
+    if (modprs_poll_ms)
+        schedule_delayed_work(&data->modprs_work, msecs_to_jiffies(modprs_poll_ms));
+
     return 0;
 
 exit:
@@ -476,6 +543,12 @@ exit:
 
 static int dell_s6100_iom_cpld_remove(struct i2c_client *client)
 {
+    struct cpld_data *data = i2c_get_clientdata(client);
+
+    if (data->irq > 0)
+        devm_free_irq(&client->dev, data->irq, data);
+    cancel_delayed_work_sync(&data->modprs_work);
+    sysfs_remove_group(&client->dev.kobj, &i2c_cpld_attr_grp);
     dell_s6100_iom_cpld_remove_client(client);
     return 0;
 }
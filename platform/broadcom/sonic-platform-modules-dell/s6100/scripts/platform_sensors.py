@@ -12,6 +12,11 @@ import os
 import sys
 import logging
 
+try:
+    from sonic_platform import smf_snapshot
+except ImportError:
+    smf_snapshot = None
+
 S6100_MAX_FAN_TRAYS = 4
 S6100_MAX_PSUS = 2
 S6100_MAX_IOMS = 4
@@ -25,6 +30,12 @@ iom_status_list = []
 
 
 def get_pmc_register(reg_name):
+    # All the sensors of one run are decoded from one SMF snapshot
+    if smf_snapshot is not None:
+        retval = smf_snapshot.get_pmc_register(reg_name)
+        if retval is not None:
+            return retval
+
     retval = 'ERR'
     mb_reg_file = MAILBOX_DIR+'/'+reg_name
 
@@ -10,6 +10,7 @@
 
 try:
     import os
+    import select
     from sonic_platform_base.platform_base import PlatformBase
     from sonic_platform_base.chassis_base import ChassisBase
     from sonic_platform.sfp import Sfp
@@ -19,6 +20,7 @@ try:
     from sonic_platform.thermal import Thermal
     from sonic_platform.component import Component
     from sonic_platform.watchdog import Watchdog
+    from sonic_platform import smf_snapshot
     from eeprom import Eeprom
     import time
 except ImportError as e:
@@ -40,6 +42,12 @@ class Chassis(ChassisBase):
     HWMON_NODE = os.listdir(HWMON_DIR)[0]
     MAILBOX_DIR = HWMON_DIR + HWMON_NODE
     POLL_INTERVAL = 1 # Poll interval in seconds
+    # Presence changes are signaled on qsfp_modprs_event of the IOM CPLDs,
+    # presence is still checked every EVENT_POLL_INTERVAL in case the
+    # driver neither has the IRQ nor polls
+    IOM_CPLD_DIRS = ["/sys/class/i2c-adapter/i2c-%d/%d-003e/" % (bus, bus)
+                     for bus in range(14, 18)]
+    EVENT_POLL_INTERVAL = 60
 
     reset_reason_dict = {}
     reset_reason_dict[11] = ChassisBase.REBOOT_CAUSE_POWER_LOSS
@@ -82,6 +90,8 @@ class Chassis(ChassisBase):
             self._component_list.append(component)
 
         self._watchdog = Watchdog()
+        self._modprs_event_files = []
+        self._modprs_poller = self._open_modprs_events()
         self._transceiver_presence = self._get_transceiver_presence()
 
     def _get_reboot_reason_smf_register(self):
@@ -97,6 +107,10 @@ class Chassis(ChassisBase):
     def _get_pmc_register(self, reg_name):
         # On successful read, returns the value read from given
         # reg_name and on failure returns 'ERR'
+        rv = smf_snapshot.get_pmc_register(reg_name)
+        if rv is not None:
+            return rv
+
         rv = 'ERR'
         mb_reg_file = self.MAILBOX_DIR + '/' + reg_name
 
@@ -236,6 +250,34 @@ class Chassis(ChassisBase):
 
         return (ChassisBase.REBOOT_CAUSE_HARDWARE_OTHER, "Invalid Reason")
 
+    def _open_modprs_events(self):
+        # Returns a poll object for the qsfp_modprs_event attributes,
+        # None if the IOM CPLD driver does not provide them
+        poller = select.poll()
+        for cpld_dir in self.IOM_CPLD_DIRS:
+            try:
+                event_file = open(cpld_dir + 'qsfp_modprs_event', 'r')
+                event_file.read()
+            except IOError:
+                continue
+            poller.register(event_file, select.POLLPRI | select.POLLERR)
+            self._modprs_event_files.append(event_file)
+
+        if not self._modprs_event_files:
+            return None
+        return poller
+
+    def _wait_modprs_event(self, timer):
+        # Blocks until an IOM CPLD signals a presence change or timer
+        # (in secs) expires, then re-arms the notifications
+        self._modprs_poller.poll(int(timer * 1000))
+        for event_file in self._modprs_event_files:
+            try:
+                event_file.seek(0)
+                event_file.read()
+            except IOError:
+                pass
+
     def _get_transceiver_presence(self):
 
         cpld2_modprs = self._get_register(
@@ -300,14 +342,22 @@ class Chassis(ChassisBase):
         else:
             return False, ret_dict # Incorrect timeout
 
+        if self._modprs_poller is not None:
+            poll_interval = self.EVENT_POLL_INTERVAL
+        else:
+            poll_interval = self.POLL_INTERVAL
+
         while True:
             if forever:
-                timer = self.POLL_INTERVAL
+                timer = poll_interval
             else:
-                timer = min(timeout, self.POLL_INTERVAL)
+                timer = min(timeout, poll_interval)
                 start_time = time.time()
 
-            time.sleep(timer)
+            if self._modprs_poller is not None:
+                self._wait_modprs_event(timer)
+            else:
+                time.sleep(timer)
             cur_presence = self._get_transceiver_presence()
 
             # Update dict only if a change has been detected
@@ -12,6 +12,7 @@ import os.path
 
 try:
     from sonic_platform_base.fan_base import FanBase
+    from sonic_platform import smf_snapshot
 except ImportError as e:
     raise ImportError(str(e) + "- required module not found")
 
@@ -55,6 +56,10 @@ class Fan(FanBase):
     def _get_pmc_register(self, reg_name):
         # On successful read, returns the value read from given
         # reg_name and on failure returns 'ERR'
+        rv = smf_snapshot.get_pmc_register(reg_name)
+        if rv is not None:
+            return rv
+
         rv = 'ERR'
         mb_reg_file = self.MAILBOX_DIR+'/'+reg_name
 
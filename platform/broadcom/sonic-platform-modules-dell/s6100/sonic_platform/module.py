@@ -15,6 +15,7 @@ try:
     from sonic_platform.sfp import Sfp
     from sonic_platform.component import Component
     from sonic_platform.eeprom import Eeprom
+    from sonic_platform import smf_snapshot
 except ImportError as e:
     raise ImportError(str(e) + "- required module not found")
 
@@ -86,6 +87,10 @@ class Module(ModuleBase):
     def _get_pmc_register(self, reg_name):
         # On successful read, returns the value read from given
         # reg_name and on failure returns 'ERR'
+        rv = smf_snapshot.get_pmc_register(reg_name)
+        if rv is not None:
+            return rv
+
         rv = 'ERR'
         mb_reg_file = self.MAILBOX_DIR + '/' + reg_name
 
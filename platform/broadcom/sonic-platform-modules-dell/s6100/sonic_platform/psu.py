@@ -13,6 +13,7 @@ try:
     import os
     from sonic_platform_base.psu_base import PsuBase
     from sonic_platform.fan import Fan
+    from sonic_platform import smf_snapshot
 except ImportError as e:
     raise ImportError(str(e) + "- required module not found")
 
@@ -49,6 +50,10 @@ class Psu(PsuBase):
     def _get_pmc_register(self, reg_name):
         # On successful read, returns the value read from given
         # reg_name and on failure returns 'ERR'
+        rv = smf_snapshot.get_pmc_register(reg_name)
+        if rv is not None:
+            return rv
+
         rv = 'ERR'
         mb_reg_file = self.MAILBOX_DIR + '/' + reg_name
 
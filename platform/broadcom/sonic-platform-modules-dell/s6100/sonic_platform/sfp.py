@@ -11,6 +11,7 @@
 try:
     import os
     import time
+    import functools
     from sonic_platform_base.chassis_base import ChassisBase
     from sonic_platform_base.sfp_base import SfpBase
     from sonic_platform_base.sonic_sfp.sff8436 import sff8436InterfaceId
@@ -28,6 +29,17 @@ INFO_OFFSET = 128
 DOM_OFFSET = 0
 DOM_OFFSET1 = 384
 
+# EEPROM regions decoded through sff8436_parser, by page offset:
+# first byte and length, relative to the page offset
+EEPROM_REGIONS = {
+    DOM_OFFSET: (0, 128),       # lower page 0
+    INFO_OFFSET: (0, 128),      # upper page 0
+    DOM_OFFSET1: (128, 128),    # upper page 3
+}
+
+# Upper page 0 only holds static ID fields, it is kept for a few seconds
+INFO_CACHE_TIME = 5
+
 cable_length_tup = ('Length(km)', 'Length OM3(2m)', 'Length OM2(m)',
                     'Length OM1(m)', 'Length Cable Assembly(m)')
 
@@ -98,6 +110,23 @@ sff8436_parser = {
 }
 
 
+def eeprom_batch(func):
+    """
+    Reads each EEPROM region at most once during a call of func,
+    including the getters it calls
+    """
+    @functools.wraps(func)
+    def wrapper(self, *args, **kwargs):
+        self._batch_depth += 1
+        try:
+            return func(self, *args, **kwargs)
+        finally:
+            self._batch_depth -= 1
+            if self._batch_depth == 0:
+                self._eeprom_regions.clear()
+    return wrapper
+
+
 class Sfp(SfpBase):
     """
     DELLEMC Platform-specific Sfp class
@@ -113,6 +142,10 @@ class Sfp(SfpBase):
         self.sfp_ctrl_idx = sfp_ctrl_idx
         self.sfpInfo = sff8436InterfaceId()
         self.sfpDomInfo = sff8436Dom()
+        self._batch_depth = 0
+        self._eeprom_regions = {}
+        self._info_region = None
+        self._info_time = 0
 
     def _read_eeprom_bytes(self, eeprom_path, offset, num_bytes):
         eeprom_raw = []
@@ -141,6 +174,30 @@ class Sfp(SfpBase):
         eeprom.close()
         return eeprom_raw
 
+    def _get_eeprom_region(self, page_offset):
+        """
+        Returns the EEPROM region of page_offset, from the cache when
+        it was read during the current call
+        """
+        now = time.time()
+        if (page_offset == INFO_OFFSET and self._info_region is not None and
+                0 <= now - self._info_time < INFO_CACHE_TIME):
+            return self._info_region
+
+        if page_offset in self._eeprom_regions:
+            return self._eeprom_regions[page_offset]
+
+        start, length = EEPROM_REGIONS[page_offset]
+        region = self._read_eeprom_bytes(
+            self.eeprom_path, page_offset + start, length)
+        if self._batch_depth > 0:
+            self._eeprom_regions[page_offset] = region
+        if page_offset == INFO_OFFSET and region is not None:
+            self._info_region = region
+            self._info_time = now
+
+        return region
+
     def _get_eeprom_data(self, eeprom_key):
         eeprom_data = None
         page_offset = None
@@ -149,11 +206,19 @@ class Sfp(SfpBase):
             return None
 
         page_offset = sff8436_parser[eeprom_key][PAGE_OFFSET]
-        eeprom_data_raw = self._read_eeprom_bytes(
-            self.eeprom_path,
-            (sff8436_parser[eeprom_key][PAGE_OFFSET] +
-             sff8436_parser[eeprom_key][KEY_OFFSET]),
-            sff8436_parser[eeprom_key][KEY_WIDTH])
+        key_offset = sff8436_parser[eeprom_key][KEY_OFFSET]
+        key_width = sff8436_parser[eeprom_key][KEY_WIDTH]
+        start, length = EEPROM_REGIONS[page_offset]
+        if (start <= key_offset and key_offset + key_width <= start + length):
+            region = self._get_eeprom_region(page_offset)
+            if (region is not None):
+                eeprom_data_raw = region[key_offset - start:
+                                         key_offset - start + key_width]
+            else:
+                eeprom_data_raw = None
+        else:
+            eeprom_data_raw = self._read_eeprom_bytes(
+                self.eeprom_path, page_offset + key_offset, key_width)
         if (eeprom_data_raw is not None):
             # Offset 128 is used to retrieve sff8436InterfaceId Info
             # Offset 0 is used to retrieve sff8436Dom Info
@@ -168,6 +233,7 @@ class Sfp(SfpBase):
 
         return eeprom_data
 
+    @eeprom_batch
     def get_transceiver_info(self):
         """
         Retrieves transceiver info of this SFP
@@ -259,6 +325,7 @@ class Sfp(SfpBase):
 
         return transceiver_info_dict
 
+    @eeprom_batch
     def get_transceiver_threshold_info(self):
         """
         Retrieves transceiver threshold info of this SFP
@@ -314,6 +381,7 @@ class Sfp(SfpBase):
 
         return transceiver_dom_threshold_dict
 
+    @eeprom_batch
     def get_transceiver_bulk_status(self):
         """
         Retrieves transceiver bulk status of this SFP
@@ -388,6 +456,7 @@ class Sfp(SfpBase):
 
         return transceiver_dom_dict
 
+    @eeprom_batch
     def get_name(self):
         """
         Retrieves the name of the sfp
@@ -430,8 +499,12 @@ class Sfp(SfpBase):
         if ((reg_value & mask) == 0):
             return True
 
+        # Module removed, its ID fields are not valid anymore
+        self._info_region = None
+
         return False
 
+    @eeprom_batch
     def get_model(self):
         """
         Retrieves the model number (or part number) of the sfp
@@ -444,6 +517,7 @@ class Sfp(SfpBase):
 
         return vendor_pn
 
+    @eeprom_batch
     def get_serial(self):
         """
         Retrieves the serial number of the sfp
@@ -488,6 +562,7 @@ class Sfp(SfpBase):
 
         return reset_status
 
+    @eeprom_batch
     def get_rx_los(self):
         """
         Retrieves the RX LOS (lost-of-signal) status of SFP
@@ -526,6 +601,7 @@ class Sfp(SfpBase):
 
         return rx_los
 
+    @eeprom_batch
     def get_tx_fault(self):
         """
         Retrieves the TX fault status of SFP
@@ -564,6 +640,7 @@ class Sfp(SfpBase):
 
         return tx_fault
 
+    @eeprom_batch
     def get_tx_disable(self):
         """
         Retrieves the tx_disable status of this SFP
@@ -602,6 +679,7 @@ class Sfp(SfpBase):
 
         return tx_disable
 
+    @eeprom_batch
     def get_tx_disable_channel(self):
         """
         Retrieves the TX disabled channels in this SFP
@@ -672,6 +750,7 @@ class Sfp(SfpBase):
 
         return lpmode_state
 
+    @eeprom_batch
     def get_power_override(self):
         """
         Retrieves the power-override status of this SFP
@@ -689,6 +768,7 @@ class Sfp(SfpBase):
 
         return power_override_state
 
+    @eeprom_batch
     def get_temperature(self):
         """
         Retrieves the temperature of this SFP
@@ -701,6 +781,7 @@ class Sfp(SfpBase):
 
         return temperature
 
+    @eeprom_batch
     def get_voltage(self):
         """
         Retrieves the supply voltage of this SFP
@@ -713,6 +794,7 @@ class Sfp(SfpBase):
 
         return voltage
 
+    @eeprom_batch
     def get_tx_bias(self):
         """
         Retrieves the TX bias current of this SFP
@@ -733,6 +815,7 @@ class Sfp(SfpBase):
 
         return tx_bias_list
 
+    @eeprom_batch
     def get_rx_power(self):
         """
         Retrieves the received optical power for this SFP
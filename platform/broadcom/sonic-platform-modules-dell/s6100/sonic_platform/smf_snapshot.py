@@ -0,0 +1,235 @@
+#!/usr/bin/env python
+
+#############################################################################
+# DELLEMC S6100
+#
+# Module contains a decoder of the SMF sensor register snapshot, which
+# serves the hwmon attributes of the SMF from a single sysfs read
+#
+#############################################################################
+
+try:
+    import struct
+    import time
+except ImportError as e:
+    raise ImportError(str(e) + "- required module not found")
+
+SNAPSHOT_FILE = "/sys/devices/platform/SMF.512/smf_snapshot"
+
+# Registers of the snapshot image, indexed by SMF register address
+TEMP_SENSOR_1 = 0x0014
+SMF_FAN_SPEED_ADDR = 0x00F3
+FAN_TRAY_PRESENCE = 0x0113
+FAN_STATUS_GROUP_B = 0x0115
+PSU_1_STATUS = 0x0237
+PSU_1_TEMPERATURE = 0x0239
+PSU_1_FAN_SPEED = 0x023B
+PSU_1_FAN_STATUS = 0x023D
+PSU_1_INPUT_VOLTAGE = 0x023E
+PSU_1_INPUT_CURRENT = 0x0242
+PSU_1_INPUT_POWER = 0x0246
+PSU_1_OUTPUT_POWER = 0x0248
+PSU_2_STATUS = 0x0270
+PSU_2_TEMPERATURE = 0x0272
+PSU_2_FAN_SPEED = 0x0274
+PSU_2_FAN_STATUS = 0x0276
+PSU_2_INPUT_VOLTAGE = 0x0277
+PSU_2_INPUT_CURRENT = 0x027B
+PSU_2_INPUT_POWER = 0x027F
+PSU_2_OUTPUT_POWER = 0x0281
+CPU_1_VOLTAGE = 0x02A8
+SWITCH_CURRENT_S6100 = 0x02E4
+IO_MODULE_STATUS = 0x0310
+IO_MODULE_PRESENCE = 0x0311
+
+SNAPSHOT_SIZE = IO_MODULE_PRESENCE + 1
+# Refresh time in ms since boot and age in ms, little endian
+TRAILER_FORMAT = "<QI"
+IMAGE_SIZE = SNAPSHOT_SIZE + struct.calcsize(TRAILER_FORMAT)
+
+
+def _reg8(image, reg):
+    return image[reg]
+
+
+def _reg16(image, reg):
+    return (image[reg] << 8) + image[reg + 1]
+
+
+def _signed(value):
+    if value & 0x8000:
+        value = -(value & 0x7fff)
+    return value
+
+
+# The conversions below follow the show functions of dell_s6100_lpc
+
+def _temp(reg):
+    def decode(image):
+        value = _reg16(image, reg)
+        if value > 65500:
+            value = 0
+        return "%d" % (_signed(value) * 100)
+    return decode
+
+
+def _fan(reg):
+    def decode(image):
+        return "%u" % (_signed(_reg16(image, reg)) & 0xffffffff)
+    return decode
+
+
+def _scaled(reg, scale):
+    def decode(image):
+        return "%d" % (_reg16(image, reg) * scale)
+    return decode
+
+
+def _power(reg):
+    def decode(image):
+        value = _reg16(image, reg)
+        if value == 0xffff:
+            value = 0
+        return "%u" % (value * 100000)
+    return decode
+
+
+def _hex(reg, invert=False):
+    def decode(image):
+        value = _reg8(image, reg)
+        if invert:
+            value = ~value & 0xff
+        return "%x" % value
+    return decode
+
+
+def _bit_clear(reg, bit):
+    def decode(image):
+        return "%d" % (0 if ~_reg8(image, reg) & (1 << bit) else 1)
+    return decode
+
+
+def _bit(reg, bit):
+    def decode(image):
+        return "%d" % ((_reg8(image, reg) >> bit) & 1)
+    return decode
+
+
+def _build_decoders():
+    decoders = {}
+
+    for i in range(13):
+        decoders["temp{}_input".format(i + 1)] = _temp(TEMP_SENSOR_1 + i * 2)
+    decoders["temp14_input"] = _temp(PSU_1_TEMPERATURE)
+    decoders["temp15_input"] = _temp(PSU_2_TEMPERATURE)
+
+    for i in range(28):
+        decoders["in{}_input".format(i + 1)] = \
+            _scaled(CPU_1_VOLTAGE + i * 2, 10)
+    for i in range(2):
+        decoders["in{}_input".format(29 + i)] = \
+            _scaled(PSU_1_INPUT_VOLTAGE + i * 2, 10)
+        decoders["in{}_input".format(31 + i)] = \
+            _scaled(PSU_2_INPUT_VOLTAGE + i * 2, 10)
+        decoders["curr{}_input".format(21 + i)] = \
+            _scaled(SWITCH_CURRENT_S6100 + i * 2, 10)
+        decoders["curr{}_input".format(601 + i)] = \
+            _scaled(PSU_1_INPUT_CURRENT + i * 2, 10)
+        decoders["curr{}_input".format(701 + i)] = \
+            _scaled(PSU_2_INPUT_CURRENT + i * 2, 10)
+
+    for i in range(10):
+        decoders["fan{}_input".format(i + 1)] = \
+            _fan(SMF_FAN_SPEED_ADDR + i * 2)
+        decoders["fan{}_fault".format(i + 1)] = \
+            _bit_clear(FAN_TRAY_PRESENCE, i // 2)
+        decoders["fan{}_alarm".format(i + 1)] = \
+            _bit_clear(FAN_STATUS_GROUP_B, i // 2)
+    decoders["fan11_input"] = _fan(PSU_1_FAN_SPEED)
+    decoders["fan12_input"] = _fan(PSU_2_FAN_SPEED)
+    for psu_fan, reg in (("fan11", PSU_1_FAN_STATUS),
+                         ("fan12", PSU_2_FAN_STATUS)):
+        decoders[psu_fan + "_airflow"] = _bit(reg, 0)
+        decoders[psu_fan + "_alarm"] = _bit(reg, 1)
+        decoders[psu_fan + "_fault"] = _bit(reg, 2)
+    decoders["fan_tray_presence"] = _hex(FAN_TRAY_PRESENCE, invert=True)
+
+    decoders["power1_input"] = _power(PSU_1_INPUT_POWER)
+    decoders["power2_input"] = _power(PSU_1_OUTPUT_POWER)
+    decoders["power3_input"] = _power(PSU_2_INPUT_POWER)
+    decoders["power4_input"] = _power(PSU_2_OUTPUT_POWER)
+    decoders["psu1_presence"] = _hex(PSU_1_STATUS)
+    decoders["psu2_presence"] = _hex(PSU_2_STATUS)
+
+    decoders["iom_status"] = _hex(IO_MODULE_STATUS)
+    decoders["iom_presence"] = _hex(IO_MODULE_PRESENCE)
+
+    return decoders
+
+
+class SmfSnapshot(object):
+    """
+    Values of the SMF hwmon attributes decoded from the smf_snapshot
+    image. A snapshot older than max_age seconds, or an attribute the
+    snapshot does not cover, reads as None and the caller reads the
+    hwmon attribute instead. The image is read at most once per hold
+    seconds, so the attributes read in one pass come from one read.
+    """
+
+    DECODERS = _build_decoders()
+
+    def __init__(self, path=SNAPSHOT_FILE, max_age=3.0, hold=0.5):
+        self.path = path
+        self.max_age = max_age
+        self.hold = hold
+        self._image = None
+        self._time = None
+
+    def _read_image(self):
+        try:
+            with open(self.path, 'rb') as fd:
+                raw = fd.read(IMAGE_SIZE)
+        except (IOError, OSError):
+            return None
+
+        if len(raw) != IMAGE_SIZE:
+            return None
+        _, age = struct.unpack_from(TRAILER_FORMAT, raw, SNAPSHOT_SIZE)
+        if age > self.max_age * 1000:
+            return None
+        return bytearray(raw[:SNAPSHOT_SIZE])
+
+    def refresh(self):
+        now = time.time()
+        if self._time is None or not 0 <= now - self._time < self.hold:
+            self._image = self._read_image()
+            self._time = now
+        return self._image
+
+    def get(self, reg_name):
+        """
+        Returns the value of hwmon attribute reg_name as its sysfs file
+        reads, or None when the snapshot cannot serve it
+        """
+        decode = self.DECODERS.get(reg_name)
+        if decode is None:
+            return None
+
+        image = self.refresh()
+        if image is None:
+            return None
+        return decode(image)
+
+
+_snapshot = None
+
+
+def get_pmc_register(reg_name):
+    """
+    Returns the value of hwmon attribute reg_name from the snapshot
+    shared by the platform objects, or None
+    """
+    global _snapshot
+    if _snapshot is None:
+        _snapshot = SmfSnapshot()
+    return _snapshot.get(reg_name)
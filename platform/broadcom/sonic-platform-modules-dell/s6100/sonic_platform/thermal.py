@@ -12,6 +12,7 @@
 try:
     import os
     from sonic_platform_base.thermal_base import ThermalBase
+    from sonic_platform import smf_snapshot
 except ImportError as e:
     raise ImportError(str(e) + "- required module not found")
 
@@ -135,8 +136,13 @@ class Thermal(ThermalBase):
             A float number of current temperature in Celsius up to
             nearest thousandth of one degree Celsius, e.g. 30.125
         """
-        thermal_temperature = self._read_sysfs_file(
-            self.thermal_temperature_file)
+        thermal_temperature = None
+        if not self.is_cpu_thermal:
+            thermal_temperature = smf_snapshot.get_pmc_register(
+                os.path.basename(self.thermal_temperature_file))
+        if thermal_temperature is None:
+            thermal_temperature = self._read_sysfs_file(
+                self.thermal_temperature_file)
         if (thermal_temperature != 'ERR'):
             thermal_temperature = float(thermal_temperature)
         else:
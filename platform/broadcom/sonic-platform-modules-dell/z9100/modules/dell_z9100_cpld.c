@@ -12,6 +12,9 @@
 #include <linux/i2c.h>
 #include <linux/slab.h>
 #include <linux/list.h>
+#include <linux/workqueue.h>
+#include <linux/jiffies.h>
+#include <linux/notifier.h>
 
 
 //iom cpld slave address
@@ -48,9 +51,34 @@
 #define  QSFP_ABS_MASK0    0x28
 #define  QSFP_ABS_MASK1    0x29
 
+/*
+ * qsfp_modprs is served from a cache that lives modprs_cache_ms. The
+ * QSFP presence interrupt of the CPLDs is routed to GPIO SUS6 of the
+ * ICH: dell_ich invalidates the cache of every CPLD on the SCI and the
+ * CPLD is read again right away. A change is signaled with
+ * sysfs_notify() on qsfp_modprs_event.
+ */
+static unsigned int modprs_cache_ms = 1000;
+module_param(modprs_cache_ms, uint, 0644);
+MODULE_PARM_DESC(modprs_cache_ms, "qsfp_modprs cache lifetime (ms), 0 reads the CPLD on every access");
+static unsigned int modprs_poll_ms;
+module_param(modprs_poll_ms, uint, 0444);
+MODULE_PARM_DESC(modprs_poll_ms, "qsfp_modprs refresh interval (ms) besides the presence interrupt, 0 to disable");
+
+/* Provided by dell_ich */
+extern int dell_ich_register_sus6_notifier(struct notifier_block *nb);
+extern int dell_ich_unregister_sus6_notifier(struct notifier_block *nb);
+
 struct cpld_data {
     struct i2c_client *client;
     struct mutex  update_lock;
+    struct delayed_work modprs_work;
+    struct notifier_block sus6_nb;
+    bool use_i2c;
+    bool modprs_valid;          /* Protected by update_lock */
+    u16 modprs;
+    unsigned long modprs_time;
+    atomic_t modprs_events;
 };
 
 
@@ -102,6 +130,130 @@ int dell_z9100_iom_cpld_write(struct cpld_data *data,u8 reg, u8 value)
 
     return ret;
 }
+
+/*
+ * Reads len adjacent registers from reg under one lock hold: a single
+ * address write and block read when the adapter does plain I2C,
+ * otherwise one address set and read per register.
+ */
+static int dell_z9100_iom_cpld_read_seq(struct cpld_data *data, u8 reg, u8 *buf, int len)
+{
+    u8 addr[2] = { 0x00, reg };
+    struct i2c_msg msgs[2] = {
+        { .addr = data->client->addr, .flags = 0, .len = sizeof(addr), .buf = addr },
+        { .addr = data->client->addr, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+    int ret = 0;
+    int i;
+
+    mutex_lock(&data->update_lock);
+    if (data->use_i2c) {
+        ret = i2c_transfer(data->client->adapter, msgs, ARRAY_SIZE(msgs));
+        ret = ret == ARRAY_SIZE(msgs) ? 0 : (ret < 0 ? ret : -EIO);
+    } else {
+        for (i = 0; i < len; i++) {
+            ret = i2c_smbus_write_byte_data(data->client, 0x00, reg + i);
+            if (ret < 0)
+                break;
+            ret = i2c_smbus_read_byte(data->client);
+            if (ret < 0)
+                break;
+            buf[i] = (u8)ret;
+            ret = 0;
+        }
+    }
+    mutex_unlock(&data->update_lock);
+
+    return ret;
+}
+
+/* 16-bit register pair, low byte at reg */
+static int dell_z9100_iom_cpld_read16(struct cpld_data *data, u8 reg)
+{
+    u8 buf[2];
+    int ret;
+
+    ret = dell_z9100_iom_cpld_read_seq(data, reg, buf, sizeof(buf));
+    if (ret < 0)
+        return ret;
+
+    return buf[0] | (buf[1] << 8);
+}
+
+static ssize_t show_reg16(struct cpld_data *data, u8 reg, char *buf)
+{
+    int ret;
+
+    ret = dell_z9100_iom_cpld_read16(data, reg);
+    if(ret < 0)
+        return sprintf(buf, "read error");
+
+    return sprintf(buf,"0x%04x\n",ret);
+}
+
+/* Reads qsfp_modprs into the cache, signals a change */
+static int dell_z9100_iom_cpld_update_modprs(struct cpld_data *data)
+{
+    bool changed;
+    int ret;
+
+    ret = dell_z9100_iom_cpld_read16(data, QSFP_MOD_PRS_REG0);
+    if(ret < 0)
+        return ret;
+
+    mutex_lock(&data->update_lock);
+    changed = data->modprs != (u16)ret;
+    data->modprs = (u16)ret;
+    data->modprs_time = jiffies;
+    data->modprs_valid = true;
+    mutex_unlock(&data->update_lock);
+
+    if (changed) {
+        atomic_inc(&data->modprs_events);
+        sysfs_notify(&data->client->dev.kobj, NULL, "qsfp_modprs_event");
+    }
+
+    return ret;
+}
+
+static int dell_z9100_iom_cpld_get_modprs(struct cpld_data *data)
+{
+    int ret = -EAGAIN;
+
+    mutex_lock(&data->update_lock);
+    if (data->modprs_valid && modprs_cache_ms &&
+            time_before(jiffies, data->modprs_time + msecs_to_jiffies(modprs_cache_ms)))
+        ret = data->modprs;
+    mutex_unlock(&data->update_lock);
+
+    if (ret < 0)
+        ret = dell_z9100_iom_cpld_update_modprs(data);
+
+    return ret;
+}
+
+static void dell_z9100_iom_cpld_modprs_work(struct work_struct *work)
+{
+    struct cpld_data *data = container_of(to_delayed_work(work),
+                                          struct cpld_data, modprs_work);
+
+    dell_z9100_iom_cpld_update_modprs(data);
+    if (modprs_poll_ms)
+        schedule_delayed_work(&data->modprs_work, msecs_to_jiffies(modprs_poll_ms));
+}
+
+/* Called from the dell_ich SCI handler on a QSFP presence interrupt */
+static int dell_z9100_iom_cpld_sus6_event(struct notifier_block *nb,
+                                          unsigned long count, void *unused)
+{
+    struct cpld_data *data = container_of(nb, struct cpld_data, sus6_nb);
+
+    WRITE_ONCE(data->modprs_valid, false);
+    mod_delayed_work(system_wq, &data->modprs_work, 0);
+
+    return NOTIFY_OK;
+}
+
 static ssize_t get_cpldver(struct device *dev, struct device_attribute *devattr, char *buf) 
 {
     int ret;
@@ -115,61 +267,59 @@ static ssize_t get_cpldver(struct device *dev, struct device_attribute *devattr,
     return sprintf(buf,"IOM CPLD Version:0x%02x\n",devdata);
 }
 
-static ssize_t get_modprs(struct device *dev, struct device_attribute *devattr, char *buf) 
+static ssize_t get_modprs(struct device *dev, struct device_attribute *devattr, char *buf)
 {
     int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_MOD_PRS_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_MOD_PRS_REG1);
+    ret = dell_z9100_iom_cpld_get_modprs(data);
     if(ret < 0)
         return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return sprintf(buf,"0x%04x\n",ret);
 }
 
-static ssize_t get_lpmode(struct device *dev, struct device_attribute *devattr, char *buf) 
+static ssize_t get_modprs_event(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_LPMODE_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
+    return sprintf(buf,"%u\n",atomic_read(&data->modprs_events));
+}
+
+/*
+ * Presence, interrupt status, lpmode and reset of all the QSFPs of the
+ * CPLD, read together from QSFP_RST_CRTL_REG0..QSFP_MOD_PRS_REG1:
+ * "<modprs> <int_sta> <lpmode> <reset>"
+ */
+static ssize_t get_qsfp_status(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+    u8 regs[QSFP_MOD_PRS_REG1 - QSFP_RST_CRTL_REG0 + 1];
+    struct cpld_data *data = dev_get_drvdata(dev);
+    int ret;
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_LPMODE_REG1);
+#define REG16(reg) (regs[(reg) - QSFP_RST_CRTL_REG0] | (regs[(reg) + 1 - QSFP_RST_CRTL_REG0] << 8))
+    ret = dell_z9100_iom_cpld_read_seq(data, QSFP_RST_CRTL_REG0, regs, sizeof(regs));
     if(ret < 0)
         return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return sprintf(buf,"0x%04x 0x%04x 0x%04x 0x%04x\n",
+                   REG16(QSFP_MOD_PRS_REG0), REG16(QSFP_INT_STA_REG0),
+                   REG16(QSFP_LPMODE_REG0), REG16(QSFP_RST_CRTL_REG0));
+#undef REG16
 }
 
-static ssize_t get_reset(struct device *dev, struct device_attribute *devattr, char *buf) 
+static ssize_t get_lpmode(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_RST_CRTL_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
+    return show_reg16(data, QSFP_LPMODE_REG0, buf);
+}
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_RST_CRTL_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
+static ssize_t get_reset(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+    struct cpld_data *data = dev_get_drvdata(dev);
 
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_RST_CRTL_REG0, buf);
 }
 
 static ssize_t set_lpmode(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count) 
@@ -206,40 +356,15 @@ static ssize_t set_reset(struct device *dev, struct device_attribute *devattr, c
 
 static ssize_t get_int_sta(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT_STA_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT_STA_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT_STA_REG0, buf);
 }
 
 static ssize_t get_abs_sta(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
-    struct cpld_data *data = dev_get_drvdata(dev);
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_STA_REG0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_STA_REG1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    /* Same registers as qsfp_modprs */
+    return get_modprs(dev, devattr, buf);
 }
 
 static ssize_t get_trig_mod(struct device *dev, struct device_attribute *devattr, char *buf)
@@ -285,59 +410,23 @@ static ssize_t get_int_combine(struct device *dev, struct device_attribute *deva
 
 static ssize_t get_int(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT0, buf);
 }
 
 static ssize_t get_abs_int(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_INT0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_INT1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_ABS_INT0, buf);
 }
 
 static ssize_t get_int_mask(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT_MASK0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_INT_MASK1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_INT_MASK0, buf);
 }
 
 static ssize_t set_int_mask(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
@@ -358,21 +447,9 @@ static ssize_t set_int_mask(struct device *dev, struct device_attribute *devattr
 
 static ssize_t get_abs_mask(struct device *dev, struct device_attribute *devattr, char *buf)
 {
-    int ret;
-    u16 devdata=0;
     struct cpld_data *data = dev_get_drvdata(dev);
 
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_MASK0);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata = (u16)ret & 0xff;
-
-    ret = dell_z9100_iom_cpld_read(data,QSFP_ABS_MASK1);
-    if(ret < 0)
-        return sprintf(buf, "read error");
-    devdata |= (u16)(ret & 0xff) << 8;
-
-    return sprintf(buf,"0x%04x\n",devdata);
+    return show_reg16(data, QSFP_ABS_MASK0, buf);
 }
 
 static ssize_t set_abs_mask(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
@@ -393,6 +470,8 @@ static ssize_t set_abs_mask(struct device *dev, struct device_attribute *devattr
 
 static DEVICE_ATTR(iom_cpld_vers,S_IRUGO,get_cpldver, NULL);
 static DEVICE_ATTR(qsfp_modprs, S_IRUGO,get_modprs, NULL);
+static DEVICE_ATTR(qsfp_modprs_event, S_IRUGO,get_modprs_event, NULL);
+static DEVICE_ATTR(qsfp_status, S_IRUGO, get_qsfp_status, NULL);
 static DEVICE_ATTR(qsfp_lpmode, S_IRUGO | S_IWUSR,get_lpmode,set_lpmode);
 static DEVICE_ATTR(qsfp_reset,  S_IRUGO | S_IWUSR,get_reset, set_reset);
 static DEVICE_ATTR(qsfp_int_sta, S_IRUGO, get_int_sta, NULL);
@@ -408,6 +487,8 @@ static struct attribute *i2c_cpld_attrs[] = {
     &dev_attr_qsfp_lpmode.attr,
     &dev_attr_qsfp_reset.attr,
     &dev_attr_qsfp_modprs.attr,
+    &dev_attr_qsfp_modprs_event.attr,
+    &dev_attr_qsfp_status.attr,
     &dev_attr_iom_cpld_vers.attr,
     &dev_attr_qsfp_int_sta.attr,
     &dev_attr_qsfp_abs_sta.attr,
@@ -428,6 +509,8 @@ static int dell_z9100_iom_cpld_probe(struct i2c_client *client,
         const struct i2c_device_id *dev_id)
 {
     int status;
+    int ret;
+    struct cpld_data *data;
 
     if (!i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_BYTE_DATA)) {
         dev_dbg(&client->dev, "i2c_check_functionality failed (0x%x)\n", client->addr);
@@ -437,12 +520,33 @@ static int dell_z9100_iom_cpld_probe(struct i2c_client *client,
 
     dev_info(&client->dev, "chip found- New\n");
     dell_z9100_iom_cpld_add_client(client);
+    data = i2c_get_clientdata(client);
+    if (!data) {
+        status = -ENOMEM;
+        goto exit;
+    }
+    data->use_i2c = i2c_check_functionality(client->adapter, I2C_FUNC_I2C);
+    INIT_DELAYED_WORK(&data->modprs_work, dell_z9100_iom_cpld_modprs_work);
 
     /* Register sysfs hooks */
     status = sysfs_create_group(&client->dev.kobj, &i2c_cpld_attr_grp);
     if (status) {
         printk(KERN_INFO "Cannot create sysfs\n");
     }
+
+    /* Initial presence, changes from here on are signaled */
+    ret = dell_z9100_iom_cpld_read16(data, QSFP_MOD_PRS_REG0);
+    if (ret >= 0) {
+        data->modprs = (u16)ret;
+        data->modprs_time = jiffies;
+        data->modprs_valid = true;
+    }
+
+    data->sus6_nb.notifier_call = dell_z9100_iom_cpld_sus6_event;
+    dell_ich_register_sus6_notifier(&data->sus6_nb);
+
+    if (modprs_poll_ms)
+        schedule_delayed_work(&data->modprs_work, msecs_to_jiffies(modprs_poll_ms));
     return 0;
 
 exit:
@@ -451,6 +555,11 @@ exit:
 
 static int dell_z9100_iom_cpld_remove(struct i2c_client *client)
 {
+    struct cpld_data *data = i2c_get_clientdata(client);
+
+    dell_ich_unregister_sus6_notifier(&data->sus6_nb);
+    cancel_delayed_work_sync(&data->modprs_work);
+    sysfs_remove_group(&client->dev.kobj, &i2c_cpld_attr_grp);
     dell_z9100_iom_cpld_remove_client(client);
     return 0;
 }
@@ -47,6 +47,7 @@
 #include <linux/workqueue.h>
 #include <linux/i2c.h>
 #include <linux/moduleparam.h>
+#include <linux/ktime.h>
 
 
 void __iomem * fpga_base_addr = NULL;
@@ -161,6 +162,13 @@ struct fpgalogic_i2c {
     u8 (*reg_get)(struct fpgalogic_i2c *i2c, int reg);
     u32 timeout;
     struct mutex lock;
+    /* transfer statistics, updated under the adapter bus lock */
+    u32 xfer_count;
+    u32 err_count;
+    u32 timeout_count;
+    u32 last_us;
+    u32 max_us;
+    u64 total_us;
 };
 /* registers */
 #define FPGAI2C_REG_PRELOW        0
@@ -197,6 +205,9 @@ struct fpgalogic_i2c {
 #define FPGAI2C_REG_SR_TIP    (1 << 1) /* Transfer in progress */
 #define FPGAI2C_REG_SR_IF        (1 << 0) /* Interrupt flag */
 
+/* One byte plus ACK takes 90us at 100kHz */
+#define FPGAI2C_TIP_SPIN_US      100
+
 enum {
     STATE_DONE = 0,
     STATE_INIT,
@@ -216,7 +227,6 @@ enum {
 #define FPGALOGIC_I2C_BASE        0x00006000
 #define FPGALOGIC_CH_OFFSET    0x10
 
-#define i2c_bus_controller_numb 1
 #define I2C_PCI_MAX_BUS         (16)
 #define I2C_PCI_MAX_BUS_REV00   (7)
 #define DELL_I2C_CLOCK_LEGACY   0
@@ -320,7 +330,6 @@ static int total_i2c_pci_bus = 0;
 static uint32_t board_rev_type = 0;
 static struct fpgalogic_i2c    fpgalogic_i2c[I2C_PCI_MAX_BUS];
 static struct i2c_adapter     i2c_pci_adap[I2C_PCI_MAX_BUS];
-static struct mutex         i2c_xfer_lock[I2C_PCI_MAX_BUS];
 
 static void fpgai2c_reg_set_8(struct fpgalogic_i2c *i2c, int reg, u8 value)
 {
@@ -375,15 +384,29 @@ static inline u8 fpgai2c_reg_get_32be(struct fpgalogic_i2c *i2c, int reg)
 static inline void fpgai2c_reg_set(struct fpgalogic_i2c *i2c, int reg, u8 value)
 {
     i2c->reg_set(i2c, reg, value);
-    udelay(100);
 }
 
 static inline u8 fpgai2c_reg_get(struct fpgalogic_i2c *i2c, int reg)
 {
-    udelay(100);
     return i2c->reg_get(i2c, reg);
 }
 
+/*
+ * Spin until the byte in flight is done. Returns -EBUSY if TIP is
+ * still set after FPGAI2C_TIP_SPIN_US, the caller then sleeps instead.
+ */
+static int fpgai2c_wait_tip(struct fpgalogic_i2c *i2c)
+{
+    int spin = FPGAI2C_TIP_SPIN_US;
+
+    while (fpgai2c_reg_get(i2c, FPGAI2C_REG_STATUS) & FPGAI2C_REG_STAT_TIP) {
+        if (spin-- <= 0)
+            return -EBUSY;
+        udelay(1);
+    }
+    return 0;
+}
+
 static void fpgai2c_dump(struct fpgalogic_i2c *i2c)
 {
     u8 tmp;
@@ -690,7 +713,7 @@ void dell_release_mutex(struct fpgalogic_i2c *i2c)
     mutex_unlock(&i2c->lock);
 }
 
-static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+static int fpgai2c_do_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
 {
     struct fpgalogic_i2c *i2c = i2c_get_adapdata(adap);
     int ret;
@@ -707,8 +730,14 @@ static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
     if (!use_irq) {
         /* Handle the transfer */
         while (time_before(jiffies, timeout)) {
+            /* Burst: keep driving the state machine while each byte
+             * completes within the spin window.
+             */
             dell_get_mutex(i2c);
-            ret = fpgai2c_poll(i2c);
+            do {
+                ret = fpgai2c_poll(i2c);
+            } while (ret == 0 && i2c->state != STATE_DONE &&
+                     i2c->state != STATE_ERROR && fpgai2c_wait_tip(i2c) == 0);
             dell_release_mutex(i2c);
 
             if (i2c->state == STATE_DONE || i2c->state == STATE_ERROR)
@@ -743,6 +772,47 @@ static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
     }
 }
 
+/*
+ * Each FPGA I2C master has its own adapter, state and MSI vector, so
+ * transfers on different buses only serialise on their own bus lock.
+ */
+static int fpgai2c_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs, int num)
+{
+    struct fpgalogic_i2c *i2c = i2c_get_adapdata(adap);
+    ktime_t start = ktime_get();
+    u32 cost;
+    int ret;
+
+    ret = fpgai2c_do_xfer(adap, msgs, num);
+
+    cost = (u32)ktime_us_delta(ktime_get(), start);
+    i2c->xfer_count++;
+    i2c->last_us = cost;
+    i2c->total_us += cost;
+    if (cost > i2c->max_us)
+        i2c->max_us = cost;
+    if (ret == -ETIMEDOUT)
+        i2c->timeout_count++;
+    else if (ret < 0)
+        i2c->err_count++;
+
+    return ret;
+}
+
+static ssize_t get_xfer_stats(struct device *dev, struct device_attribute *devattr, char *buf)
+{
+    struct fpgalogic_i2c *i2c = i2c_get_adapdata(to_i2c_adapter(dev));
+    u64 avg = 0;
+
+    if (i2c->xfer_count)
+        avg = div_u64(i2c->total_us, i2c->xfer_count);
+
+    return sprintf(buf, "xfers %u errors %u timeouts %u last_us %u max_us %u avg_us %llu\n",
+                   i2c->xfer_count, i2c->err_count, i2c->timeout_count,
+                   i2c->last_us, i2c->max_us, avg);
+}
+static DEVICE_ATTR(xfer_stats, S_IRUGO, get_xfer_stats, NULL);
+
 static int fpgai2c_init(struct fpgalogic_i2c *i2c)
 {
     int prescale;
@@ -917,8 +987,6 @@ static int i2c_pci_init (void)
 
     memset (&i2c_pci_adap, 0, sizeof(i2c_pci_adap));
     memset (&fpgalogic_i2c, 0, sizeof(fpgalogic_i2c));
-    for(i=0; i < i2c_bus_controller_numb; i++)
-        mutex_init(&i2c_xfer_lock[i]);
 
     /* Initialize driver's itnernal data structures */
     i2c_init_internal_data();
@@ -939,6 +1007,8 @@ static int i2c_pci_init (void)
             return( -ENODEV );
         }
         i2c_set_adapdata(&i2c_pci_adap[i], &fpgalogic_i2c[i]);
+        if (device_create_file(&i2c_pci_adap[i].dev, &dev_attr_xfer_stats))
+            PRINT("Cannot create xfer_stats for bus %d\n", i);
 
         PRINT( "Registered bus id: %s\n", kobject_name(&i2c_pci_adap[ i ].dev.kobj));
     }
@@ -950,6 +1020,7 @@ static void i2c_pci_deinit(void)
 {
     int i;
     for( i = 0; i < total_i2c_pci_bus; i++ ){
+        device_remove_file(&i2c_pci_adap[i].dev, &dev_attr_xfer_stats);
         i2c_del_adapter(&i2c_pci_adap[i]);
     }
 
@@ -36,8 +36,32 @@
 #define EEPROM_MASK   20
 #define ATTR_R 1
 #define ATTR_W 2
+#define DNI_BMC_POOL_SIZE 8
+#define DNI_BMC_BULK_MAX  16
+
+struct dni_bmc_slot;
+
+/* One IPMI request of a dni_bmc_run() batch */
+struct dni_bmc_req {
+    char cmd;
+    char *data;
+    int data_len;
+    uint8_t *rsp;               /* optional, gets the bytes after the completion code */
+    int rsp_len;                /* room in rsp, then the number of bytes received */
+    int ret;                    /* what dni_bmc_cmd() would have returned */
+    struct dni_bmc_slot *slot;
+};
+
+struct dni_bmc_reg {
+    uint8_t bus;
+    uint8_t addr;
+    uint8_t reg;
+    int value;
+};
 
 extern int dni_bmc_cmd(char set_cmd, char *cmd_data, int cmd_data_len);
+extern int dni_bmc_run(struct dni_bmc_req *reqs, int num);
+extern int dni_bmc_get_regs(struct dni_bmc_reg *regs, int num);
 extern int dni_create_user(void);
 extern unsigned char dni_log2 (unsigned char num);
 extern void device_release(struct device *dev);
@@ -51,13 +75,6 @@ static ipmi_user_t ipmi_mh_user = NULL;
 static struct ipmi_user_hndl ipmi_hndlrs = { .ipmi_recv_hndl = msg_handler,};
 static atomic_t dummy_count = ATOMIC_INIT(0);
 
-static struct ipmi_smi_msg halt_smi_msg = {
-        .done = dummy_smi_free
-};
-static struct ipmi_recv_msg halt_recv_msg = {
-        .done = dummy_recv_free
-};
-
 enum{
     BUS0 = 0,
     BUS1,
@@ -57,343 +57,91 @@ static struct platform_device ag9064_cpld = {
     },
 };
 
-static ssize_t get_present(struct device *dev, struct device_attribute \
-                            *dev_attr, char *buf)
+/* SWPLD holding the register of QSFP1~8, QSFP9~16 ... QSFP57~64 */
+static const uint8_t qsfp_swpld_addr[8] = {
+    SWPLD1_ADDR, SWPLD2_ADDR, SWPLD4_ADDR, SWPLD3_ADDR,
+    SWPLD1_ADDR, SWPLD2_ADDR, SWPLD4_ADDR, SWPLD3_ADDR,
+};
+
+/* Fetch the eight registers of a 64 bits port map in one batch */
+static ssize_t get_qsfp_bits(const uint8_t *qsfp_reg, char *buf)
 {
-    int ret;
+    struct dni_bmc_reg regs[8];
     u64 data = 0;
-    uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    int cmd_data_len;
-    set_cmd = CMD_GETDATA;
-
-    dni_klock();
-
-    /*QSFP1~8*/
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_1;
-    cmd_data[3] = 1;
-    cmd_data_len = sizeof(cmd_data);
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data = (u64)(ret & 0xff);
-
-    /*QSFP9~16*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_2;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 8;
-
-    /*QSFP17~24*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_3;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 16;
-
-    /*QSFP25~32*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_4;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 24;
-
-    /*QSFP33~40*/
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_5;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 32;
+    int i, ret;
 
-    /*QSFP41~48*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_6;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 40;
+    for (i = 0; i < 8; i++) {
+        regs[i].bus = BMC_BUS_5;
+        regs[i].addr = qsfp_swpld_addr[i];
+        regs[i].reg = qsfp_reg[i];
+    }
 
-    /*QSFP49~56*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_7;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 48;
+    dni_klock();
+    ret = dni_bmc_get_regs(regs, 8);
+    dni_kunlock();
+    if (ret < 0)
+        return ret;
 
-    /*QSFP57~64*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_PRESENCE_8;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 56;
+    for (i = 0; i < 8; i++) {
+        data |= (u64)(regs[i].value & 0xff) << (i * 8);
+    }
 
-    dni_kunlock();
     return sprintf(buf, "0x%016llx\n", data);
 }
 
-static ssize_t get_lpmode(struct device *dev, struct device_attribute \
+static ssize_t get_present(struct device *dev, struct device_attribute \
                             *dev_attr, char *buf)
 {
-    int ret;
-    u64 data = 0;
-    uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    int cmd_data_len;
-    set_cmd = CMD_GETDATA;
-
-    dni_klock();
+    static const uint8_t qsfp_reg[8] = {
+        QSFP_PRESENCE_1, QSFP_PRESENCE_2, QSFP_PRESENCE_3, QSFP_PRESENCE_4,
+        QSFP_PRESENCE_5, QSFP_PRESENCE_6, QSFP_PRESENCE_7, QSFP_PRESENCE_8,
+    };
 
-    /*QSFP1~8*/
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_1;
-    cmd_data[3] = 1;
-    cmd_data_len = sizeof(cmd_data);
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data = (u64)(ret & 0xff);
-
-    /*QSFP9~16*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_2;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 8;
-
-    /*QSFP17~24*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_3;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 16;
-
-    /*QSFP25~32*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_4;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 24;
-
-    /*QSFP33~40*/
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_5;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 32;
-
-    /*QSFP41~48*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_6;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 40;
-
-    /*QSFP49~56*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_7;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 48;
+    return get_qsfp_bits(qsfp_reg, buf);
+}
 
-    /*QSFP57~64*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_LP_MODE_8;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 56;
+static ssize_t get_lpmode(struct device *dev, struct device_attribute \
+                            *dev_attr, char *buf)
+{
+    static const uint8_t qsfp_reg[8] = {
+        QSFP_LP_MODE_1, QSFP_LP_MODE_2, QSFP_LP_MODE_3, QSFP_LP_MODE_4,
+        QSFP_LP_MODE_5, QSFP_LP_MODE_6, QSFP_LP_MODE_7, QSFP_LP_MODE_8,
+    };
 
-    dni_kunlock();
- 
-    return sprintf(buf, "0x%016llx\n", data);
+    return get_qsfp_bits(qsfp_reg, buf);
 }
 
 static ssize_t get_reset(struct device *dev, struct device_attribute \
                             *dev_attr, char *buf)
 {
-    int ret;
-    u64 data = 0;
-    uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    int cmd_data_len;
-    set_cmd = CMD_GETDATA;
-
-    dni_klock();
-
-    /*QSFP1~8*/
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_RESET_1;
-    cmd_data[3] = 1;
-    cmd_data_len = sizeof(cmd_data);
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data = (u64)(ret & 0xff);
-
-    /*QSFP9~16*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_RESET_2;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 8;
-
-    /*QSFP17~24*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_RESET_3;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 16;
-
-    /*QSFP25~32*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_RESET_4;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 24;
-
-    /*QSFP33~40*/
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_RESET_5;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 32;
-
-    /*QSFP41~48*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_RESET_6;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 40;
+    static const uint8_t qsfp_reg[8] = {
+        QSFP_RESET_1, QSFP_RESET_2, QSFP_RESET_3, QSFP_RESET_4,
+        QSFP_RESET_5, QSFP_RESET_6, QSFP_RESET_7, QSFP_RESET_8,
+    };
 
-    /*QSFP49~56*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_RESET_7;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 48;
-
-    /*QSFP57~64*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_RESET_8;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 56;
-
-    dni_kunlock();
-
-    return sprintf(buf, "0x%016llx\n", data);
+    return get_qsfp_bits(qsfp_reg, buf);
 }
 
 static ssize_t get_response(struct device *dev, struct device_attribute \
                             *dev_attr, char *buf)
 {
-    int ret;
-    u64 data = 0;
-    uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    int cmd_data_len;
-    set_cmd = CMD_GETDATA;
-
-    dni_klock();
-
-    /*QSFP1~8*/
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_1;
-    cmd_data[3] = 1;
-    cmd_data_len = sizeof(cmd_data);
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data = (u64)(ret & 0xff);
-
-    /*QSFP9~16*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_2;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 8;
-
-    /*QSFP17~24*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_3;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 16;
-
-    /*QSFP25~32*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_4;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 24;
-
-    /*QSFP33~40*/
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_5;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 32;
+    static const uint8_t qsfp_reg[8] = {
+        QSFP_RESPONSE_1, QSFP_RESPONSE_2, QSFP_RESPONSE_3, QSFP_RESPONSE_4,
+        QSFP_RESPONSE_5, QSFP_RESPONSE_6, QSFP_RESPONSE_7, QSFP_RESPONSE_8,
+    };
 
-    /*QSFP41~48*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_6;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 40;
-
-    /*QSFP49~56*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_7;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 48;
-
-    /*QSFP57~64*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_RESPONSE_8;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 56;
-
-    dni_kunlock();
-
-    return sprintf(buf, "0x%016llx\n", data);
+    return get_qsfp_bits(qsfp_reg, buf);
 }
 
 static ssize_t get_interrupt(struct device *dev, struct device_attribute \
                             *dev_attr, char *buf)
 {
-    int ret;
-    u64 data = 0;
-    uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    int cmd_data_len;
-    set_cmd = CMD_GETDATA;
-
-    dni_klock();
-
-    /*QSFP1~8*/
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_1;
-    cmd_data[3] = 1;
-    cmd_data_len = sizeof(cmd_data);
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data = (u64)(ret & 0xff);
+    static const uint8_t qsfp_reg[8] = {
+        QSFP_INTERRUPT_1, QSFP_INTERRUPT_2, QSFP_INTERRUPT_3, QSFP_INTERRUPT_4,
+        QSFP_INTERRUPT_5, QSFP_INTERRUPT_6, QSFP_INTERRUPT_7, QSFP_INTERRUPT_8,
+    };
 
-    /*QSFP9~16*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_2;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 8;
-
-    /*QSFP17~24*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_3;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 16;
-
-    /*QSFP25~32*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_4;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 24;
-
-    /*QSFP33~40*/
-    cmd_data[1] = SWPLD1_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_5;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 32;
-
-    /*QSFP41~48*/
-    cmd_data[1] = SWPLD2_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_6;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 40;
-
-    /*QSFP49~56*/
-    cmd_data[1] = SWPLD4_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_7;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 48;
-
-    /*QSFP57~64*/
-    cmd_data[1] = SWPLD3_ADDR;
-    cmd_data[2] = QSFP_INTERRUPT_8;
-    ret = dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
-    data |= (u64)(ret & 0xff) << 56;
-
-    dni_kunlock();
-
-    return sprintf(buf, "0x%016llx\n", data);
+    return get_qsfp_bits(qsfp_reg, buf);
 }
 
 static ssize_t set_lpmode(struct device *dev, struct device_attribute *devattr, const char *buf, size_t count)
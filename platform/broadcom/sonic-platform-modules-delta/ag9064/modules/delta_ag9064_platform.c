@@ -11,6 +11,7 @@
 #include <asm/segment.h>
 #include <asm/uaccess.h>
 #include <linux/buffer_head.h>
+#include <linux/semaphore.h>
 
 #include "delta_ag9064_common.h"
 
@@ -142,70 +143,273 @@ int dni_create_user(void)
 }
 EXPORT_SYMBOL(dni_create_user);
 
-int dni_bmc_cmd(char set_cmd, char *cmd_data, int cmd_data_len)
+/*
+ * Requests in flight each own a slot of the pool. A slot goes back to
+ * the pool once both of its messages have been freed, by the SMI driver
+ * and by the waiter, so it is never reused under the message handler.
+ */
+struct dni_bmc_slot {
+    struct ipmi_smi_msg smi_msg;
+    struct ipmi_recv_msg recv_msg;
+    struct completion comp;
+    atomic_t refs;
+};
+
+static struct dni_bmc_slot dni_bmc_pool[DNI_BMC_POOL_SIZE];
+static unsigned long dni_bmc_pool_busy;
+static struct semaphore dni_bmc_pool_sem;
+
+static int bmc_max_inflight = DNI_BMC_POOL_SIZE;
+module_param(bmc_max_inflight, int, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(bmc_max_inflight, "IPMI requests a batch keeps in flight, 1 sends them one by one");
+
+static bool bmc_bulk_read = true;
+module_param(bmc_bulk_read, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(bmc_bulk_read, "Read adjacent registers of a device with one IPMI request");
+
+static void dni_bmc_slot_put(struct dni_bmc_slot *slot)
+{
+    if (atomic_dec_and_test(&slot->refs)) {
+        clear_bit(slot - dni_bmc_pool, &dni_bmc_pool_busy);
+        up(&dni_bmc_pool_sem);
+    }
+}
+
+static void dni_bmc_smi_free(struct ipmi_smi_msg *msg)
+{
+    dni_bmc_slot_put(container_of(msg, struct dni_bmc_slot, smi_msg));
+}
+
+static void dni_bmc_recv_free(struct ipmi_recv_msg *msg)
+{
+    dni_bmc_slot_put(container_of(msg, struct dni_bmc_slot, recv_msg));
+}
+
+static struct dni_bmc_slot *dni_bmc_slot_get(bool wait)
+{
+    struct dni_bmc_slot *slot;
+    int i;
+
+    if (wait)
+        down(&dni_bmc_pool_sem);
+    else if (down_trylock(&dni_bmc_pool_sem))
+        return NULL;
+
+    /* the semaphore leaves at least one bit clear for us */
+    for (i = 0; test_and_set_bit(i, &dni_bmc_pool_busy); i++)
+        ;
+
+    slot = &dni_bmc_pool[i];
+    slot->smi_msg.done = dni_bmc_smi_free;
+    slot->recv_msg.done = dni_bmc_recv_free;
+    init_completion(&slot->comp);
+    /* both messages, plus ours until the request is queued */
+    atomic_set(&slot->refs, 3);
+    return slot;
+}
+
+static void dni_bmc_submit(struct dni_bmc_req *req, struct dni_bmc_slot *slot)
 {
     int rv;
     struct ipmi_system_interface_addr addr;
     struct kernel_ipmi_msg msg;
-    struct completion comp;
 
     addr.addr_type = IPMI_SYSTEM_INTERFACE_ADDR_TYPE;   
     addr.channel = IPMI_BMC_CHANNEL;                    
     addr.lun = 0;
 
     msg.netfn = DELTA_NETFN;
-    msg.cmd = set_cmd;
-    msg.data_len = cmd_data_len;
-    msg.data = cmd_data;
-    
-    init_completion(&comp);
-    rv = ipmi_request_supply_msgs(ipmi_mh_user, (struct ipmi_addr*)&addr, 0,&msg, &comp, &halt_smi_msg, &halt_recv_msg, 0);
+    msg.cmd = req->cmd;
+    msg.data_len = req->data_len;
+    msg.data = req->data;
+
+    req->slot = slot;
+    rv = ipmi_request_supply_msgs(ipmi_mh_user, (struct ipmi_addr*)&addr, 0, &msg, &slot->comp, &slot->smi_msg, &slot->recv_msg, 0);
     if (rv) {
-        return -6;
+        /* some errors are returned before the messages are freed */
+        if (atomic_read(&slot->refs) == 3) {
+            atomic_set(&slot->refs, 1);
+        }
+        req->slot = NULL;
+        req->ret = -6;
+        if (req->rsp)
+            req->rsp_len = 0;
     }
-    wait_for_completion(&comp);
+    dni_bmc_slot_put(slot);
+}
+
+static void dni_bmc_complete(struct dni_bmc_req *req)
+{
+    struct dni_bmc_slot *slot = req->slot;
+    struct ipmi_recv_msg *recv_msg;
+    int len;
+
+    if (!slot)
+        return;
 
-    switch(msg.cmd)
+    recv_msg = &slot->recv_msg;
+    wait_for_completion(&slot->comp);
+
+    switch (req->cmd)
     {
         case CMD_GETDATA:
-            if( rv == 0)
-            {
-                return halt_recv_msg.msg.data[1];
-            }
-            else
-            {
-                printk(KERN_ERR "IPMI get error!\n");
-                return -6;
-            }
-            break; 
-        case CMD_SETDATA:
-            if( rv == 0)
-            {
-                return rv;
-            }
-            else
-            {
-                printk(KERN_ERR "IPMI set error!\n");
-                return -6;
-            }
         case CMD_DEVICE_SCAN:
-            if( rv == 0)
-            {
-                return halt_recv_msg.msg.data[1];
-            }
-            else
-            {
-                printk(KERN_ERR "IPMI scan error!\n");
-                return -6;
-            }
+            req->ret = recv_msg->msg.data[1];
+            break;
+        default:
+            req->ret = 0;
             break;
     }
 
-    ipmi_free_recv_msg(&halt_recv_msg);
+    if (req->rsp) {
+        /* data[0] is the completion code */
+        len = recv_msg->msg.data_len - 1;
+        if (len < 0 || recv_msg->msg.data[0] != 0)
+            len = 0;
+        if (len > req->rsp_len)
+            len = req->rsp_len;
+        memcpy(req->rsp, &recv_msg->msg.data[1], len);
+        req->rsp_len = len;
+    }
+
+    req->slot = NULL;
+    ipmi_free_recv_msg(recv_msg);
+}
+
+/*
+ * Run a batch of requests, up to bmc_max_inflight of them queued to the
+ * BMC at once. They complete in order. Returns 0, or -6 when any failed.
+ */
+int dni_bmc_run(struct dni_bmc_req *reqs, int num)
+{
+    struct dni_bmc_slot *slot;
+    int window = clamp(bmc_max_inflight, 1, DNI_BMC_POOL_SIZE);
+    int head = 0, tail = 0, rv = 0;
+
+    /* reqs[tail] .. reqs[head - 1] are in flight */
+    while (tail < num) {
+        /* only sleep for a slot when none of ours is left to retire */
+        if (head < num && head - tail < window &&
+            (slot = dni_bmc_slot_get(head == tail)) != NULL) {
+            dni_bmc_submit(&reqs[head++], slot);
+            continue;
+        }
+        dni_bmc_complete(&reqs[tail]);
+        if (reqs[tail].ret < 0)
+            rv = -6;
+        tail++;
+    }
 
     return rv;
 }
+EXPORT_SYMBOL(dni_bmc_run);
+
+int dni_bmc_cmd(char set_cmd, char *cmd_data, int cmd_data_len)
+{
+    struct dni_bmc_req req = {
+        .cmd = set_cmd,
+        .data = cmd_data,
+        .data_len = cmd_data_len,
+    };
+
+    dni_bmc_run(&req, 1);
+    return req.ret;
+}
 EXPORT_SYMBOL(dni_bmc_cmd);
+
+/*
+ * Read a list of registers, regs[i].value is the register or -6.
+ * Adjacent registers of one device are fetched by a single GETDATA
+ * with a length when bmc_bulk_read is set, and all the requests are
+ * pipelined. Registers a bulk answer comes short of are read again
+ * one by one.
+ */
+int dni_bmc_get_regs(struct dni_bmc_reg *regs, int num)
+{
+    struct dni_bmc_bulk {
+        uint8_t data[4];
+        uint8_t rsp[DNI_BMC_BULK_MAX];
+    } *bulk;
+    struct dni_bmc_req *reqs;
+    int *group;
+    int i, g, off, ngrp = 0, nreq;
+
+    /* at worst every register is a group of its own and read twice */
+    reqs = kcalloc(num * 2, sizeof(*reqs), GFP_KERNEL);
+    bulk = kcalloc(num * 2, sizeof(*bulk), GFP_KERNEL);
+    group = kcalloc(num, sizeof(*group), GFP_KERNEL);
+    if (!reqs || !bulk || !group) {
+        kfree(reqs);
+        kfree(bulk);
+        kfree(group);
+        return -ENOMEM;
+    }
+
+    for (i = 0; i < num; i++) {
+        for (g = 0; bmc_bulk_read && g < ngrp; g++) {
+            if (bulk[g].data[0] == regs[i].bus && bulk[g].data[1] == regs[i].addr &&
+                bulk[g].data[2] + bulk[g].data[3] == regs[i].reg &&
+                bulk[g].data[3] < DNI_BMC_BULK_MAX)
+                break;
+        }
+        if (g == ngrp) {
+            g = ngrp++;
+            bulk[g].data[0] = regs[i].bus;
+            bulk[g].data[1] = regs[i].addr;
+            bulk[g].data[2] = regs[i].reg;
+        }
+        bulk[g].data[3]++;
+        group[i] = g;
+    }
+
+    for (g = 0; g < ngrp; g++) {
+        reqs[g].cmd = CMD_GETDATA;
+        reqs[g].data = bulk[g].data;
+        reqs[g].data_len = sizeof(bulk[g].data);
+        if (bulk[g].data[3] > 1) {
+            reqs[g].rsp = bulk[g].rsp;
+            reqs[g].rsp_len = bulk[g].data[3];
+        }
+    }
+    dni_bmc_run(reqs, ngrp);
+
+    nreq = ngrp;
+    for (i = 0; i < num; i++) {
+        g = group[i];
+        off = regs[i].reg - bulk[g].data[2];
+        if (reqs[g].ret < 0) {
+            regs[i].value = -6;
+        } else if (!reqs[g].rsp) {
+            regs[i].value = reqs[g].ret & 0xff;
+        } else if (off < reqs[g].rsp_len) {
+            regs[i].value = bulk[g].rsp[off];
+        } else {
+            bulk[nreq].data[0] = regs[i].bus;
+            bulk[nreq].data[1] = regs[i].addr;
+            bulk[nreq].data[2] = regs[i].reg;
+            bulk[nreq].data[3] = 1;
+            reqs[nreq].cmd = CMD_GETDATA;
+            reqs[nreq].data = bulk[nreq].data;
+            reqs[nreq].data_len = sizeof(bulk[nreq].data);
+            group[i] = nreq++;
+        }
+    }
+
+    if (nreq > ngrp) {
+        dni_bmc_run(&reqs[ngrp], nreq - ngrp);
+        for (i = 0; i < num; i++) {
+            if (group[i] >= ngrp) {
+                regs[i].value = reqs[group[i]].ret < 0 ? -6 : reqs[group[i]].ret & 0xff;
+            }
+        }
+    }
+
+    kfree(reqs);
+    kfree(bulk);
+    kfree(group);
+    return 0;
+}
+EXPORT_SYMBOL(dni_bmc_get_regs);
 /*----------------   IPMI - stop   ------------- */
 
 /*----------------   I2C device   - start   ------------- */
@@ -1286,6 +1490,7 @@ static int __init delta_ag9064_platform_init(void)
     printk("ag9064_platform module initialization\n");
 
     mutex_init(&dni_lock);
+    sema_init(&dni_bmc_pool_sem, DNI_BMC_POOL_SIZE);
 
     adapter = i2c_get_adapter(BUS2);
     i2c_client_9548 = i2c_new_device(adapter, &i2c_info_pca9548[0]);
@@ -5,6 +5,137 @@ unsigned char swpld2_reg_addr;
 unsigned char swpld3_reg_addr;
 unsigned char swpld4_reg_addr;
 
+/*
+ * Shadow of the SWPLD registers, under dni_lock. How long a value is
+ * trusted depends on the attribute reading it, see swpld_attr_ttl().
+ * Writes through this module update the shadow.
+ */
+#define SWPLD_NUM       4
+#define SWPLD_REG_NUM   256
+
+enum swpld_ttl {
+    SWPLD_TTL_STATIC,           /* versions and board ids, kept until a refresh */
+    SWPLD_TTL_SLOW,             /* LEDs and settings */
+    SWPLD_TTL_VOLATILE,         /* power good and interrupt status */
+    SWPLD_TTL_NONE,             /* raw register access, always read */
+};
+
+struct swpld_shadow {
+    DECLARE_BITMAP(valid, SWPLD_REG_NUM);
+    unsigned long updated[SWPLD_REG_NUM];
+    uint8_t value[SWPLD_REG_NUM];
+};
+
+static struct swpld_shadow swpld_shadow[SWPLD_NUM];
+
+static unsigned int swpld_slow_ms = 1000;
+module_param(swpld_slow_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(swpld_slow_ms, "Max age in ms of a cached SWPLD LED or setting register");
+
+static unsigned int swpld_volatile_ms = 100;
+module_param(swpld_volatile_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(swpld_volatile_ms, "Max age in ms of a cached SWPLD status register, 0 disables caching them");
+
+static struct swpld_shadow *swpld_shadow_of(uint8_t addr)
+{
+    return &swpld_shadow[addr - SWPLD4_ADDR];
+}
+
+static enum swpld_ttl swpld_attr_ttl(int index)
+{
+    switch (index) {
+        case SWPLD1_MAJOR_VER:
+        case SWPLD1_MINOR_VER:
+        case SWPLD2_MAJOR_VER:
+        case SWPLD2_MINOR_VER:
+        case SWPLD3_MAJOR_VER:
+        case SWPLD3_MINOR_VER:
+        case SB_VER:
+        case PLATFORM_TYPE:
+        case SW_BOARD_ID1 ... SWPLD4_VER:
+            return SWPLD_TTL_STATIC;
+        case SWPLD1_SCRTCH_REG:
+        case SWPLD2_SCRTCH_REG:
+        case SWPLD3_SCRTCH_REG:
+        case PSU1_GREEN_LED ... PSU_LED_MODE:
+        case FAN_LED ... FAN_MOD4_LED:
+        case CPLD_SPI_WP:
+        case RJ45_CONSOLE_SEL:
+        case FAN_EEPROM_WP:
+            return SWPLD_TTL_SLOW;
+        case SWPLD1_REG_VALUE:
+        case SWPLD2_REG_VALUE:
+        case SWPLD3_REG_VALUE:
+        case SWPLD4_REG_VALUE:
+            return SWPLD_TTL_NONE;
+        default:
+            return SWPLD_TTL_VOLATILE;
+    }
+}
+
+static int swpld_shadow_fresh(struct swpld_shadow *sh, uint8_t reg, enum swpld_ttl ttl)
+{
+    unsigned int max_age;
+
+    if (!test_bit(reg, sh->valid))
+        return 0;
+
+    switch (ttl) {
+        case SWPLD_TTL_STATIC:
+            return 1;
+        case SWPLD_TTL_SLOW:
+            max_age = swpld_slow_ms;
+            break;
+        case SWPLD_TTL_VOLATILE:
+            max_age = swpld_volatile_ms;
+            break;
+        default:
+            return 0;
+    }
+
+    return max_age && time_before(jiffies, sh->updated[reg] + msecs_to_jiffies(max_age));
+}
+
+/* Returns the register, or what dni_bmc_cmd() failed with */
+static int swpld_read(uint8_t addr, uint8_t reg, enum swpld_ttl ttl)
+{
+    struct swpld_shadow *sh = swpld_shadow_of(addr);
+    uint8_t cmd_data[4] = { BMC_BUS_5, addr, reg, 1 };
+    int ret;
+
+    if (swpld_shadow_fresh(sh, reg, ttl))
+        return sh->value[reg];
+
+    ret = dni_bmc_cmd(CMD_GETDATA, cmd_data, sizeof(cmd_data));
+    if (ret < 0) {
+        clear_bit(reg, sh->valid);
+        return ret;
+    }
+
+    sh->value[reg] = ret & 0xff;
+    sh->updated[reg] = jiffies;
+    set_bit(reg, sh->valid);
+    return ret & 0xff;
+}
+
+static int swpld_write(uint8_t addr, uint8_t reg, uint8_t value)
+{
+    struct swpld_shadow *sh = swpld_shadow_of(addr);
+    uint8_t cmd_data[4] = { BMC_BUS_5, addr, reg, value };
+    int ret;
+
+    ret = dni_bmc_cmd(CMD_SETDATA, cmd_data, sizeof(cmd_data));
+    if (ret < 0) {
+        clear_bit(reg, sh->valid);
+        return ret;
+    }
+
+    sh->value[reg] = value;
+    sh->updated[reg] = jiffies;
+    set_bit(reg, sh->valid);
+    return 0;
+}
+
 /*----------------    CPLD  - start   ------------- */
 /*    SWPLD1  -- device   */
 static struct platform_device swpld1_device = {
@@ -46,17 +177,11 @@ static ssize_t get_swpld_reg(struct device *dev, struct device_attribute *dev_at
     int ret;
     int mask;
     int value;
-    int cmd_data_len;
     char note[200];
     uint8_t cmd_data[4]={0};
-    uint8_t get_cmd;       
     struct sensor_device_attribute *attr = to_sensor_dev_attr(dev_attr);
 
     dni_klock();
-    cmd_data_len = sizeof(cmd_data);
-    get_cmd = CMD_GETDATA;
-    cmd_data[0] = BMC_BUS_5;
-    cmd_data[3] = 1;
     mask  = attribute_data[attr->index].mask;
     sprintf(note, "\n%s\n",attribute_data[attr->index].note);
 
@@ -94,7 +219,7 @@ static ssize_t get_swpld_reg(struct device *dev, struct device_attribute *dev_at
                 dni_kunlock();
                 return sprintf(buf, "%d not found", attr->index);
         }
-        ret = dni_bmc_cmd(get_cmd, cmd_data, cmd_data_len);
+        ret = swpld_read(cmd_data[1], cmd_data[2], SWPLD_TTL_NONE);
         ret = ret & 0xff;
         dni_kunlock();
         return sprintf(buf, "0x%02x\n", ret);
@@ -118,7 +243,7 @@ static ssize_t get_swpld_reg(struct device *dev, struct device_attribute *dev_at
                 return sprintf(buf, "%d not found", attr->index);
         }
         cmd_data[2] = attribute_data[attr->index].reg;
-        value = dni_bmc_cmd(get_cmd, cmd_data, cmd_data_len);
+        value = swpld_read(cmd_data[1], cmd_data[2], swpld_attr_ttl(attr->index));
         value = value & mask;
         switch (mask) {
             case 0xFF:
@@ -155,19 +280,12 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
     int err; 
     int value; 
     int set_data; 
-    int cmd_data_len;    
     uint8_t cmd_data[4]={0};
-    uint8_t set_cmd;
-    uint8_t get_cmd;
     unsigned long set_data_ul;
     unsigned char mask;  
     unsigned char mask_out;      
     struct sensor_device_attribute *attr = to_sensor_dev_attr(dev_attr);
 
-    cmd_data_len = sizeof(cmd_data);
-    set_cmd = CMD_SETDATA;
-    get_cmd = CMD_GETDATA;
-
     dni_klock();
 
     err = kstrtoul(buf, 0, &set_data_ul);
@@ -176,7 +294,7 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
         return err;
     }
 
-    if (set_data > 0xff){
+    if (set_data_ul > 0xff){
         printk(KERN_ALERT "address out of range (0x00-0xFF)\n");
         dni_kunlock();
         return count;
@@ -225,7 +343,7 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
                 dni_kunlock();
                 return sprintf(buf, "%d not found", attr->index); 
         }
-        dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
+        swpld_write(cmd_data[1], cmd_data[2], cmd_data[3]);
         dni_kunlock();
         return count;
     }
@@ -252,10 +370,9 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
                 return sprintf(buf, "%d not found", attr->index); 
         }
 
-        value = dni_bmc_cmd(get_cmd, cmd_data, cmd_data_len);
+        value = swpld_read(cmd_data[1], cmd_data[2], swpld_attr_ttl(attr->index));
         mask  = attribute_data[attr->index].mask;
         mask_out = value & ~(mask);
-        cmd_data[3] = set_data;
         switch (mask) {
             case 0xFF:
                 set_data = mask_out | (set_data & mask);  
@@ -278,7 +395,7 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
             default :
                 set_data = mask_out | (set_data << dni_log2(mask) );        
         }   
-        dni_bmc_cmd(set_cmd, cmd_data, cmd_data_len);
+        swpld_write(cmd_data[1], cmd_data[2], set_data);
         dni_kunlock();
         return count;
     }
@@ -286,6 +403,20 @@ static ssize_t set_swpld_reg(struct device *dev, struct device_attribute *dev_at
     return count;
 }
 
+/* Drop the shadow of the SWPLD, the next reads go to the BMC */
+static ssize_t set_cache_refresh(struct device *dev, struct device_attribute *dev_attr,
+             const char *buf, size_t count)
+{
+    struct cpld_platform_data *pdata = dev->platform_data;
+
+    dni_klock();
+    bitmap_zero(swpld_shadow_of(pdata->reg_addr)->valid, SWPLD_REG_NUM);
+    dni_kunlock();
+    return count;
+}
+
+static DEVICE_ATTR(cache_refresh, S_IWUSR, NULL, set_cache_refresh);
+
 //SWPLD
 static SENSOR_DEVICE_ATTR(swpld1_reg_addr,   S_IRUGO | S_IWUSR, get_swpld_reg, set_swpld_reg, SWPLD1_REG_ADDR);
 static SENSOR_DEVICE_ATTR(swpld1_reg_value,  S_IRUGO | S_IWUSR, get_swpld_reg, set_swpld_reg, SWPLD1_REG_VALUE);
@@ -341,6 +472,7 @@ static SENSOR_DEVICE_ATTR(mb_pwr_ok,         S_IRUGO | S_IWUSR, get_swpld_reg, s
 static SENSOR_DEVICE_ATTR(fan_eeprom_wp,     S_IRUGO | S_IWUSR, get_swpld_reg, set_swpld_reg, FAN_EEPROM_WP);
 
 static struct attribute *swpld1_device_attrs[] = {
+    &dev_attr_cache_refresh.attr,
     &sensor_dev_attr_swpld1_reg_value.dev_attr.attr,
     &sensor_dev_attr_swpld1_reg_addr.dev_attr.attr,
     &sensor_dev_attr_swpld1_major_ver.dev_attr.attr,
@@ -359,6 +491,7 @@ static struct attribute *swpld1_device_attrs[] = {
 };
 
 static struct attribute *swpld2_device_attrs[] = {
+    &dev_attr_cache_refresh.attr,
     &sensor_dev_attr_swpld2_reg_value.dev_attr.attr,
     &sensor_dev_attr_swpld2_reg_addr.dev_attr.attr,
     &sensor_dev_attr_swpld2_major_ver.dev_attr.attr,
@@ -374,6 +507,7 @@ static struct attribute *swpld2_device_attrs[] = {
 };
 
 static struct attribute *swpld3_device_attrs[] = {
+    &dev_attr_cache_refresh.attr,
     &sensor_dev_attr_swpld3_reg_value.dev_attr.attr,
     &sensor_dev_attr_swpld3_reg_addr.dev_attr.attr,
     &sensor_dev_attr_swpld3_major_ver.dev_attr.attr,
@@ -385,6 +519,7 @@ static struct attribute *swpld3_device_attrs[] = {
 };
 
 static struct attribute *swpld4_device_attrs[] = {
+    &dev_attr_cache_refresh.attr,
     &sensor_dev_attr_sw_board_id1.dev_attr.attr,
     &sensor_dev_attr_sw_board_id2.dev_attr.attr,
     &sensor_dev_attr_swbd_ver.dev_attr.attr,
@@ -20,6 +20,10 @@
 #include <linux/err.h>
 #include <linux/platform_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include "mei_dev.h"
 #include "client.h"
@@ -136,34 +140,70 @@ struct mei_msg{
 	struct mei_i2c_data_ext data;
 };
 
+/*
+ * All the SMLINK adapters talk through the same HECI queue. It is set up
+ * once, and again after a failed exchange, instead of before every message.
+ */
+static HECI_DEVICE mei_heci;
+static bool mei_heci_ready;
+static DEFINE_MUTEX(mei_heci_lock);
+
+/* Per exchange costs, read from debugfs mei_i2c/stats */
+struct mei_i2c_stats {
+	u64 calls;		/* smbus_xfer calls */
+	u64 xfers;		/* HECI message exchanges */
+	u64 errors;
+	u64 retries;		/* HeciMsgSend retries */
+	u64 inits;		/* HECI set ups */
+	u64 setup_ns;		/* set up and message build */
+	u64 xfer_ns;		/* send and receive */
+	u64 max_ns;
+};
+static struct mei_i2c_stats mei_stats;
+static struct dentry *mei_debugfs_dir;
+
+static void mei_heci_setup(void)
+{
+	UINT32 dwTimeout;
+
+	if (mei_heci_ready)
+		return;
+
+	dwTimeout = 2000000 / HECI_TIMEOUT_UNIT;
+
+	mei_heci.Bus  = HECI_BUS;
+	mei_heci.Dev  = HECI_DEV;
+	mei_heci.Fun  = HECI_FUN;
+	mei_heci.Hidm = HECI_HIDM_MSI;
+	mei_heci.Mbar = HECI_MBAR_DEFAULT;
+	mei_heci_ready = !EFI_ERROR(HeciInit(&mei_heci, &dwTimeout));
+	mei_stats.inits++;
+}
+
 #define DEBUG_MSG 0
+/* Called with mei_heci_lock held */
 static  int mei_TxRx(u8 sensor_bus, u16 addr,  u8 command, char read_write, int size, union i2c_smbus_data * data, int pec)
 {
 	struct mei_msg_hdr mei_hdr;
 	int rets;
-	unsigned char  * recv_buf;
+	u32 recv_dw[8];
+	unsigned char  * recv_buf = (unsigned char *)recv_dw;
 	int retry = 0;
 	int len = 0;
 	int i = 0;
 
-	struct mei_msg * msg;
+	struct mei_msg msg_buf;
+	struct mei_msg * msg = &msg_buf;
 //	unsigned char  blen;
 
-	UINT32 timeout, dwTimeout;
+	UINT32 timeout;
         UINT32 blen;
-	HECI_DEVICE sHeciDev;
+	EFI_STATUS status = EFI_SUCCESS;
+	ktime_t start, sent;
+	u64 elapsed;
 
-	recv_buf = kmalloc(sizeof(unsigned char) * (32), GFP_KERNEL);
-	msg = kmalloc(sizeof(struct mei_msg), GFP_KERNEL);
-
-	dwTimeout = 2000000 / HECI_TIMEOUT_UNIT;
-
-	sHeciDev.Bus  = HECI_BUS;
-	sHeciDev.Dev  = HECI_DEV;
-	sHeciDev.Fun  = HECI_FUN;
-	sHeciDev.Hidm = HECI_HIDM_MSI;
-	sHeciDev.Mbar = HECI_MBAR_DEFAULT;
-	HeciInit(&sHeciDev, &dwTimeout);
+	start = ktime_get();
+	mei_heci_setup();
 
 	msg->data.Cmd = 0x0A;
 	if(read_write){
@@ -255,13 +295,15 @@ static  int mei_TxRx(u8 sensor_bus, u16 addr,  u8 command, char read_write, int
 		}
 	}
 #endif
+	sent = ktime_get();
 	retry = 3;
 	while(retry){
 		timeout = HECI_SEND_TIMEOUT / HECI_TIMEOUT_UNIT;
-		rets = HeciMsgSend(&sHeciDev, &timeout, (HECI_MSG_HEADER *)msg);
+		rets = HeciMsgSend(&mei_heci, &timeout, (HECI_MSG_HEADER *)msg);
 		if (rets != 0){
 			printk("HeciMsgSend ret: %d\n",rets);
 			retry --;
+			mei_stats.retries++;
 			continue;
 		}else{
 			break;
@@ -271,11 +313,11 @@ static  int mei_TxRx(u8 sensor_bus, u16 addr,  u8 command, char read_write, int
 	{
 		if(size == I2C_SMBUS_WORD_DATA){
             blen = 8;
-			HeciMsgRecv(&sHeciDev, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
+			status = HeciMsgRecv(&mei_heci, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
         }
 		else if(size == I2C_SMBUS_BYTE_DATA || size == I2C_SMBUS_QUICK || size == I2C_SMBUS_BYTE){
             blen = 7;
-			HeciMsgRecv(&sHeciDev, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
+			status = HeciMsgRecv(&mei_heci, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
         }
 #if (DEBUG_MSG)
 		if(size == I2C_SMBUS_BLOCK_DATA){
@@ -305,22 +347,69 @@ static  int mei_TxRx(u8 sensor_bus, u16 addr,  u8 command, char read_write, int
 	else
 	{
 		blen = 6;
-		HeciMsgRecv(&sHeciDev, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
+		status = HeciMsgRecv(&mei_heci, &timeout, (HECI_MSG_HEADER *)recv_buf, &blen);
 #if (DEBUG_MSG)
 		printk("recv: 0x%02x%02x%02x%02x , 0x%02x , 0x%02x \n", recv_buf[3], recv_buf[2], recv_buf[1], recv_buf[0], recv_buf[4], recv_buf[5]);
 #endif
 	}
 
 	rets = recv_buf[5];
-	
-	kfree(recv_buf);
-	kfree(msg);
+
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), sent));
+	mei_stats.xfers++;
+	mei_stats.setup_ns += ktime_to_ns(ktime_sub(sent, start));
+	mei_stats.xfer_ns += elapsed;
+	if (elapsed > mei_stats.max_ns)
+		mei_stats.max_ns = elapsed;
+	/* the queue state is unknown after a failure, set it up again */
+	if (!retry || EFI_ERROR(status))
+		mei_heci_ready = false;
+	if (rets || !retry || EFI_ERROR(status))
+		mei_stats.errors++;
+
 	if(rets)
 		return -1;
 	else
 		return 0;
 }
 
+/*
+ * I2C block read as word reads, two bytes per HECI exchange, all of them
+ * in the caller's HECI session. The device has to move its register
+ * pointer on by itself, as EEPROMs do.
+ */
+static int mei_i2c_block_read(struct mei_smb_priv *priv, u16 addr, u8 command,
+		       union i2c_smbus_data *data, int pec)
+{
+	union i2c_smbus_data part;
+	int len = data->block[0];
+	int i, ret;
+
+	if (len < 1 || len > I2C_SMBUS_BLOCK_MAX)
+		return -EINVAL;
+
+	for (i = 0; i < len; ) {
+		if (len - i >= 2) {
+			ret = mei_TxRx(priv->sensorbus, addr, command + i, I2C_SMBUS_READ,
+				       I2C_SMBUS_WORD_DATA, &part, pec);
+			if (ret)
+				return ret;
+			data->block[i + 1] = part.word & 0xff;
+			data->block[i + 2] = part.word >> 8;
+			i += 2;
+		} else {
+			ret = mei_TxRx(priv->sensorbus, addr, command + i, I2C_SMBUS_READ,
+				       I2C_SMBUS_BYTE_DATA, &part, pec);
+			if (ret)
+				return ret;
+			data->block[i + 1] = part.byte;
+			i++;
+		}
+	}
+
+	return 0;
+}
+
 /* Return negative errno on error. */
 static s32 mei_i2c_access(struct i2c_adapter *adap, u16 addr,
 		       unsigned short flags, char read_write, u8 command,
@@ -335,7 +424,9 @@ static s32 mei_i2c_access(struct i2c_adapter *adap, u16 addr,
 
     if (flags & I2C_CLIENT_PEC)
         pec = 1;
-    
+
+	mutex_lock(&mei_heci_lock);
+	mei_stats.calls++;
 	switch (size) {
 	case I2C_SMBUS_QUICK:
 
@@ -362,13 +453,20 @@ static s32 mei_i2c_access(struct i2c_adapter *adap, u16 addr,
 		ret = mei_TxRx(priv->sensorbus, addr, command, read_write, size, data, pec);
 		break;
 	case I2C_SMBUS_I2C_BLOCK_DATA:
-		printk("I2C_SMBUS_I2C_BLOCK_DATA unsupported!!%d\n",size);
+		if (read_write == I2C_SMBUS_READ) {
+			ret = mei_i2c_block_read(priv, addr, command, data, pec);
+			break;
+		}
+		printk("I2C_SMBUS_I2C_BLOCK_DATA write unsupported!!%d\n",size);
+		ret = -EOPNOTSUPP;
 		break;
 	default:
+		mutex_unlock(&mei_heci_lock);
 		dev_err(&priv->pci_dev->dev, "Unsupported transaction %d\n",
 			size);
 		return -EOPNOTSUPP;
 	}
+	mutex_unlock(&mei_heci_lock);
 
 	if (ret)
 		return ret;
@@ -381,9 +479,41 @@ static u32 mei_i2c_func(struct i2c_adapter *adapter)
 
 	return I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_BYTE |
 	       I2C_FUNC_SMBUS_BYTE_DATA | I2C_FUNC_SMBUS_WORD_DATA |
-	       I2C_FUNC_SMBUS_BLOCK_DATA ;
+	       I2C_FUNC_SMBUS_BLOCK_DATA | I2C_FUNC_SMBUS_READ_I2C_BLOCK;
+}
+
+static int mei_i2c_stats_show(struct seq_file *m, void *v)
+{
+	struct mei_i2c_stats stats;
+
+	mutex_lock(&mei_heci_lock);
+	stats = mei_stats;
+	mutex_unlock(&mei_heci_lock);
+
+	seq_printf(m, "calls:          %llu\n", stats.calls);
+	seq_printf(m, "xfers:          %llu\n", stats.xfers);
+	seq_printf(m, "errors:         %llu\n", stats.errors);
+	seq_printf(m, "retries:        %llu\n", stats.retries);
+	seq_printf(m, "inits:          %llu\n", stats.inits);
+	seq_printf(m, "avg_setup_ns:   %llu\n", stats.xfers ? div64_u64(stats.setup_ns, stats.xfers) : 0);
+	seq_printf(m, "avg_xfer_ns:    %llu\n", stats.xfers ? div64_u64(stats.xfer_ns, stats.xfers) : 0);
+	seq_printf(m, "max_xfer_ns:    %llu\n", stats.max_ns);
+	return 0;
+}
+
+static int mei_i2c_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mei_i2c_stats_show, inode->i_private);
 }
 
+static const struct file_operations mei_i2c_stats_fops = {
+	.owner		= THIS_MODULE,
+	.open		= mei_i2c_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static const struct i2c_algorithm smbus_algorithm = {
 	.smbus_xfer	= mei_i2c_access,
 	.functionality	= mei_i2c_func,
@@ -563,12 +693,22 @@ static int __init mei_i2c_init(void)
 	struct mei_device *dev;
 	struct pci_driver *pci_drv;
 
-	return pci_register_driver(&mei_i2c_driver);
+	mei_debugfs_dir = debugfs_create_dir("mei_i2c", NULL);
+	if (!IS_ERR_OR_NULL(mei_debugfs_dir))
+		debugfs_create_file("stats", 0444, mei_debugfs_dir, NULL,
+				    &mei_i2c_stats_fops);
+
+	ret = pci_register_driver(&mei_i2c_driver);
+	if (ret)
+		debugfs_remove_recursive(mei_debugfs_dir);
+	return ret;
 }
 
 static void __exit mei_i2c_exit(void)
 {
 	pci_unregister_driver(&mei_i2c_driver);
+	debugfs_remove_recursive(mei_debugfs_dir);
+	HeciClose(&mei_heci);
 }
 
 MODULE_AUTHOR("Delta Networks, Inc.");
@@ -51,6 +51,7 @@ typedef union
 
 /****** Function  *****/
 VOID* HeciMbarRead(IN HECI_DEVICE *pThis);
+static HECI_MBAR_REGS* HeciMbarMap(IN HECI_DEVICE *pThis);
 VOID  HeciTrace(IN HECI_DEVICE*, IN CHAR8*, IN HECI_MSG_HEADER*, IN INT32);
 
 EFI_STATUS HeciInit (   HECI_DEVICE   *pThis,
@@ -61,7 +62,6 @@ EFI_STATUS HeciInit (   HECI_DEVICE   *pThis,
   HECI_HOST_CSR   sHCsr;
   HECI_ME_CSR     sMeCsr;
   HECI_MBAR_REGS *pMbarRegs;
-  VOID *pAddrPoint;
   
   if (pThis == NULL || (pThis->Mbar & 0xF) != 0 || pThis->Hidm > HECI_HIDM_LAST)
   {
@@ -86,8 +86,7 @@ EFI_STATUS HeciInit (   HECI_DEVICE   *pThis,
   }
   
   // Check MBAR, 
-  pAddrPoint = HeciMbarRead(pThis);
-  pMbarRegs = (HECI_MBAR_REGS*)ioremap_nocache(pAddrPoint, 0x1000);
+  pMbarRegs = HeciMbarMap(pThis);
   if (pMbarRegs == NULL)
   {
     printk("[HECI-%d] Init failed (device disabled)\n", pThis->Fun);
@@ -127,7 +126,6 @@ EFI_STATUS HeciInit (   HECI_DEVICE   *pThis,
     *pTimeout = Timeout;
   }
   pThis->Mefs1.DWord = HeciPciReadMefs1();
-  iounmap((VOID *)pMbarRegs);
   return Status;
 } 
 
@@ -139,7 +137,6 @@ EFI_STATUS HecClearQue (    HECI_DEVICE   *pThis,
   HECI_HOST_CSR   sHCsr;
   HECI_ME_CSR     sMeCsr;
   HECI_MBAR_REGS *pMbarRegs;
-  VOID *pAddrPoint;
   
   if (pThis == NULL)
   {
@@ -148,8 +145,7 @@ EFI_STATUS HecClearQue (    HECI_DEVICE   *pThis,
   }
   
   // Check for HECI availability on PCI
-  pAddrPoint = HeciMbarRead(pThis);
-  pMbarRegs = (HECI_MBAR_REGS*)ioremap_nocache(pAddrPoint, 0x1000);
+  pMbarRegs = HeciMbarMap(pThis);
   printk("pMbarRegs: %x\n", pMbarRegs);
 
   if (pMbarRegs == NULL)
@@ -229,7 +225,6 @@ GO_FAIL:
     *pTimeout = Timeout;
   }
   pThis->Mefs1.DWord = HeciPciReadMefs1();
-  iounmap((VOID *)pMbarRegs);
   return Status;
 } 
 
@@ -245,7 +240,6 @@ EFI_STATUS HeciMsgRecv (    HECI_DEVICE     *pThis,
   HECI_HOST_CSR   sHCsr;
   HECI_ME_CSR     sMeCsr;
   HECI_MBAR_REGS  *pMbarRegs;
-  VOID *pAddrPoint;
   
   if (pThis == NULL || pMsgBuf == NULL ||
       pBufLen == NULL || *pBufLen < sizeof(HECI_MSG_HEADER))
@@ -255,8 +249,7 @@ EFI_STATUS HeciMsgRecv (    HECI_DEVICE     *pThis,
   }
 
   // Check for HECI availability on PCI
-  pAddrPoint = HeciMbarRead(pThis);
-  pMbarRegs = (HECI_MBAR_REGS*)ioremap_nocache(pAddrPoint, 0x1000);
+  pMbarRegs = HeciMbarMap(pThis);
   if (pMbarRegs == NULL)
   {
     printk("[HECI-%d] Receive failed (device disabled)\n", pThis->Fun);
@@ -379,7 +372,6 @@ EFI_STATUS HeciMsgRecv (    HECI_DEVICE     *pThis,
     *pTimeout = Timeout;
   }
   pThis->Mefs1.DWord = HeciPciReadMefs1();
-  iounmap((VOID *)pMbarRegs);
   return Status;
 } 
 
@@ -394,7 +386,6 @@ EFI_STATUS HeciMsgSend (    HECI_DEVICE     *pThis,
   HECI_HOST_CSR   sHCsr;
   HECI_ME_CSR     sMeCsr;
   HECI_MBAR_REGS *pMbarRegs;
-  VOID *pAddrPoint;
   
   if (pThis == NULL || pMessage == NULL)
   {
@@ -404,8 +395,7 @@ EFI_STATUS HeciMsgSend (    HECI_DEVICE     *pThis,
   HeciTrace(pThis, "Send msg: ", pMessage, sizeof(HECI_MSG_HEADER) + pMessage->Bits.Length);
   
   // Check for HECI availability 
-  pAddrPoint = HeciMbarRead(pThis);
-  pMbarRegs = (HECI_MBAR_REGS*)ioremap_nocache(pAddrPoint, 0x1000);
+  pMbarRegs = HeciMbarMap(pThis);
   if (pMbarRegs == NULL)
   {
     printk("[HECI-%d] Send failed (device disabled)\n", pThis->Fun);
@@ -485,7 +475,6 @@ EFI_STATUS HeciMsgSend (    HECI_DEVICE     *pThis,
     *pTimeout = Timeout;
   }
   pThis->Mefs1.DWord = HeciPciReadMefs1();
-  iounmap((VOID *)pMbarRegs);
   return Status;
 } 
 
@@ -554,6 +543,38 @@ VOID *HeciMbarRead(HECI_DEVICE *pThis)
   return (VOID*)(INTN)Mbar.QWord;
 } 
 
+//
+// The MBAR stays mapped between messages, it is only mapped again
+// when the BAR moves.
+static HECI_MBAR_REGS *HeciMbarMap(HECI_DEVICE *pThis)
+{
+  VOID *pAddrPoint;
+
+  pAddrPoint = HeciMbarRead(pThis);
+  if (pThis->MbarRegs != NULL && pThis->MbarMapped == (UINT64)(INTN)pAddrPoint)
+  {
+    return (HECI_MBAR_REGS*)pThis->MbarRegs;
+  }
+
+  HeciClose(pThis);
+  if (pAddrPoint == NULL)
+  {
+    return NULL;
+  }
+  pThis->MbarRegs = ioremap_nocache((resource_size_t)(INTN)pAddrPoint, 0x1000);
+  pThis->MbarMapped = (UINT64)(INTN)pAddrPoint;
+  return (HECI_MBAR_REGS*)pThis->MbarRegs;
+}
+
+VOID HeciClose(HECI_DEVICE *pThis)
+{
+  if (pThis->MbarRegs != NULL)
+  {
+    iounmap(pThis->MbarRegs);
+    pThis->MbarRegs = NULL;
+  }
+}
+
 
 
 VOID HeciTrace(     HECI_DEVICE     *pThis,
@@ -96,6 +96,8 @@ typedef struct
   UINT32     HMtu;    // Max transfer unit configured by ME minus header
   UINT32     MeMtu;   // Max transfer unit configured by ME minus header
   HECI_MEFS1 Mefs1;   // ME Firmware Status at recent operation
+  VOID       *MbarRegs;   // MBAR mapping kept between messages
+  UINT64     MbarMapped;  // MBAR address of MbarRegs
 } HECI_DEVICE;
 
 /****** Function  *****/
@@ -138,6 +140,11 @@ EFI_STATUS HeciMsgSend (    HECI_DEVICE     *pThis,
                             UINT32          *pTimeout,
                             HECI_MSG_HEADER *pMessage);
 
+/**
+ * @param pThis      Pointer to HECI device structure, its MBAR gets unmapped
+ */
+VOID HeciClose (            HECI_DEVICE     *pThis);
+
 
   
 #define HeciPciReadMefs1()   PciRead32(PCI_LIB_ADDRESS(HECI_BUS, HECI_DEV, HECI_FUN, HECI_REG_MEFS1))
\ No newline at end of file
@@ -22,6 +22,7 @@
 #include <linux/hwmon.h>
 #include <linux/hwmon-sysfs.h>
 #include <linux/err.h>
+#include <linux/jiffies.h>
 
 
 static ssize_t set_pwm(struct device *dev, struct device_attribute *devattr,
@@ -58,12 +59,21 @@ static const unsigned short normal_i2c[] = { 0x2C, 0x2D, 0x2E, 0x2F, 0x4C,
 #define EMC2305_DEVICE 0x34
 #define EMC2305_VENDOR 0x5D
 #define MAX_FAN_SPEED 23000
+#define EMC2305_FANS 5
+
+/* The tach of all fans is read in one pass once older than this */
+static unsigned int update_interval_ms = 1000;
+module_param(update_interval_ms, uint, 0644);
+MODULE_PARM_DESC(update_interval_ms, "Fan tach cache lifetime in ms");
 
 struct emc2305_data
 {
   struct device   *hwmon_dev;
   struct attribute_group  attrs;
   struct mutex    lock;
+  bool            valid;
+  unsigned long   last_updated;   /* in jiffies */
+  int             tach[EMC2305_FANS];
 };
 
 static int emc2305_probe(struct i2c_client *client,
@@ -128,18 +138,37 @@ static struct attribute *emc2305_attr[] =
   NULL
 };
 
+/* Tach register of a fan, from the cache refreshed for all fans at once */
+static int emc2305_read_tach(struct i2c_client *client, int index)
+{
+  struct emc2305_data *data = i2c_get_clientdata(client);
+  int i, val;
+
+  mutex_lock(&data->lock);
+  if (!data->valid ||
+      time_after(jiffies, data->last_updated + msecs_to_jiffies(update_interval_ms)))
+  {
+    for (i = 0; i < EMC2305_FANS; i++)
+    {
+      data->tach[i] = i2c_smbus_read_word_swapped(client,
+                                                  EMC2305_REG_FAN_TACH(i));
+    }
+    data->valid = true;
+    data->last_updated = jiffies;
+  }
+  val = data->tach[index];
+  mutex_unlock(&data->lock);
+  return val;
+}
+
 static ssize_t show_fan_percentage(struct device *dev, struct device_attribute *  devattr,
                         char *buf)
 {
   struct sensor_device_attribute *attr = to_sensor_dev_attr(devattr);
   struct i2c_client *client = to_i2c_client(dev);
-  struct emc2305_data *data = i2c_get_clientdata(client);
   int val;
 
-  mutex_lock(&data->lock);
-  val = i2c_smbus_read_word_swapped(client,
-                                    EMC2305_REG_FAN_TACH(attr->index));
-  mutex_unlock(&data->lock);
+  val = emc2305_read_tach(client, attr->index);
   /* Left shift 3 bits for showing correct RPM */
   val = val >> 3;
   if ((int)(3932160 * 2 / (val > 0 ? val : 1) == 960))return sprintf(buf,     "%d\n", 0);
@@ -194,14 +223,9 @@ static ssize_t show_fan(struct device *dev, struct device_attribute *devattr,
 {
   struct sensor_device_attribute *attr = to_sensor_dev_attr(devattr);
   struct i2c_client *client = to_i2c_client(dev);
-  struct emc2305_data *data = i2c_get_clientdata(client);
   int val;
 
-
-  mutex_lock(&data->lock);
-  val = i2c_smbus_read_word_swapped(client,
-                                    EMC2305_REG_FAN_TACH(attr->index));
-  mutex_unlock(&data->lock);
+  val = emc2305_read_tach(client, attr->index);
   /* Left shift 3 bits for showing correct RPM */
   val = val >> 3;
   return sprintf(buf, "%d\n", 3932160 * 2 / (val > 0 ? val : 1));
@@ -351,7 +375,7 @@ static int emc2305_probe(struct i2c_client *client,
     goto exit_remove;
   }
 
-  for (i = 0; i < 5; i++)
+  for (i = 0; i < EMC2305_FANS; i++)
   {
     /* set minimum drive to 0% */
     i2c_smbus_write_byte_data(client, EMC2305_REG_FAN_MIN_DRIVE(i), FAN_MINIMUN);
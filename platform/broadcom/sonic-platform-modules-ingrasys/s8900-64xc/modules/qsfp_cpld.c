@@ -31,6 +31,8 @@
 #include <linux/i2c-mux-gpio.h>
 #include <linux/platform_device.h>
 #include <linux/delay.h>
+#include <linux/gpio.h>
+#include <linux/workqueue.h>
 
 
 #ifdef DEBUG
@@ -86,6 +88,38 @@
 #define BIT_ABS 1
 #define BIT_ABS_2 5
 
+/* CPLD1 & CPLD2 0x2a~0x2f is empty */
+#define CPLD_EMPTY_REG_START 0x2a
+#define CPLD_EMPTY_REG_END   0x2f
+#define INT_ABS_REG_MAX      (0x31 - 0x20 + 1)
+#define RST_LP_REG_MAX       (0x3F - 0x30 + 1)
+
+/*
+ * The port registers of the CPLDs are read with one block read per
+ * register range and kept for status_cache_ms. The snapshot is refreshed
+ * in the background every status_poll_ms, or on the CPLD interrupt when
+ * irq_gpio is given, and a change of the present or interrupt bits is
+ * notified with sysfs_notify() on the bitmap attributes.
+ */
+static unsigned int status_cache_ms = 100;
+module_param(status_cache_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(status_cache_ms, "Lifetime of the port status snapshot in ms");
+
+static unsigned int status_poll_ms = 1000;
+module_param(status_poll_ms, uint, S_IRUGO);
+MODULE_PARM_DESC(status_poll_ms, "Port status poll interval in ms without interrupt, 0 disables polling");
+
+static int irq_gpio = -1;
+module_param(irq_gpio, int, S_IRUGO);
+MODULE_PARM_DESC(irq_gpio, "GPIO of the CPLD interrupt, -1 polls the port status");
+
+static bool block_read = true;
+module_param(block_read, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(block_read, "Read the CPLD port registers with I2C block reads");
+
+/* Resync interval of the snapshot when the interrupt is used */
+#define STATUS_RESYNC_MS 10000
+
 static ssize_t sfp_eeprom_read(struct i2c_client *, loff_t, u8 *,int);
 static ssize_t sfp_eeprom_write(struct i2c_client *, loff_t, const char *,int);
 
@@ -640,13 +674,52 @@ struct i2c_device_platform_data {
     struct i2c_client              *client;
 };
 
-/* module_platform_driver */
-static ssize_t
-get_prs_cpld_reg(struct device *dev,
-                 struct device_attribute *devattr,
-                 char *buf, int signal)
+/* Port register snapshot of all CPLDs */
+static struct {
+    struct mutex lock;
+    char valid;                     /* !=0 if registers are valid */
+    unsigned long last_updated;     /* In jiffies */
+    u8 int_abs[CPLD_DEVICE_NUM][INT_ABS_REG_MAX];
+    u8 rst_lp[RST_LP_REG_MAX];
+    u64 modprs;
+    u64 intr;
+    struct delayed_work work;
+    int irq;
+} cpld_status = {
+    .irq = -1,
+};
+
+static int
+cpld_read_regs(struct i2c_client *client, int first, int last, u8 *buf)
 {
+    int len = last - first + 1;
     int ret;
+    int i;
+
+    if (block_read &&
+        i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        ret = i2c_smbus_read_i2c_block_data(client, first, len, buf);
+        if (ret == len) {
+            return 0;
+        }
+        DEBUG_PRINT("block read of reg 0x%x failed (%d), fall back to byte reads", first, ret);
+    }
+
+    for (i = 0; i < len; i++) {
+        ret = i2c_smbus_read_byte_data(client, first + i);
+        if (ret < 0) {
+            return ret;
+        }
+        buf[i] = ret;
+    }
+
+    return 0;
+}
+
+/* Bitmap of one signal of the status registers, call with cpld_status.lock held */
+static u64
+cpld_prs_bitmap(int signal)
+{
     u64 data = 0;
     u64 shift = 0;
     int i = 0;
@@ -655,97 +728,259 @@ get_prs_cpld_reg(struct device *dev,
     int bit = 0;
     int bit_mask = 0;
     int bit_mask_2 = 0;
-    int (*reg)[CPLD_DEVICE_NUM][2];
-    struct cpld_platform_data *pdata = NULL;
-
-    pdata = dev->platform_data;
+    int ret;
 
-    switch(signal) {
-        case sig_int:
-            bit = BIT_INT;
-            reg = (typeof(reg)) &int_abs_reg;
-            break;
-        case sig_abs:
-            bit = BIT_ABS;
-            reg = (typeof(reg)) &int_abs_reg;
-            break;
-        default:
-            return sprintf(buf, "signal/na");
-    }
+    bit = (signal == sig_int) ? BIT_INT : BIT_ABS;
     bit_mask = 0x1 << bit;
     bit_mask_2 = 0x1 << BIT_ABS_2;
 
     for (i=0; i<CPLD_DEVICE_NUM; ++i) {
-        for (j = (*reg)[i][0]; j <= (*reg)[i][1]; ++j) {
-            /* CPLD2 & CPLD3 0x2a~0x2f is empty */
-            if (j >= 0x2a && j <= 0x2f && i < SFP_CPLD_DEVICE_NUM) {
+        for (j = int_abs_reg[i][0]; j <= int_abs_reg[i][1]; ++j) {
+            if (j >= CPLD_EMPTY_REG_START && j <= CPLD_EMPTY_REG_END && i < SFP_CPLD_DEVICE_NUM) {
                 continue;
             }
-            ret = i2c_smbus_read_byte_data(pdata[i].client, j);
-            if (ret < 0) {
-                return sprintf((char *)buf, "i2c_smbus_read_byte_data/na");
-            }
+            ret = cpld_status.int_abs[i][j - int_abs_reg[i][0]];
             shift = ((u64) ((ret & bit_mask) >> bit)) << port;
             data |= shift;
-            DEBUG_PRINT("port=%d, shift=0x%016llx, ret=%x, bit_mask=%08x, bit=%08x, data=0x%016llx\n", port, shift, ret, bit_mask, bit, data);
             /* CPLD2 and CPLD3 have BIT 1 and BIT 5 for present */
             if (i < SFP_CPLD_DEVICE_NUM) {
                 port++;
                 shift = ((u64) ((ret & bit_mask_2) >> BIT_ABS_2)) << port;
                 data |= shift;
-                DEBUG_PRINT("port=%d, shift=0x%016llx, ret=%x, bit_mask_2=0x%x, bit=%x, data=0x%016llx\n", port, shift, ret, bit_mask_2, bit, data);
             }
 
             port++;
         }
     }
 
+    return data;
+}
+
+/* Bitmap of one signal of the config registers, call with cpld_status.lock held */
+static u64
+cpld_rst_lp_bitmap(int signal)
+{
+    u64 data = 0;
+    int bit = (signal == sig_rst) ? BIT_RST : BIT_LPM;
+    int j;
+
+    for (j = 0; j < RST_LP_REG_MAX; ++j) {
+        data |= ((u64) ((cpld_status.rst_lp[j] >> bit) & 0x1)) << j;
+    }
+
+    return data;
+}
+
+/* Notify the bitmap attributes of the changed bits */
+static void
+cpld_status_notify(u64 modprs_changed, u64 intr_changed)
+{
+    struct kobject *kobj = &s8900_64xc_cpld.dev.kobj;
+    int i;
+
+    if (modprs_changed) {
+        sysfs_notify(kobj, NULL, "qsfp_modprs");
+        for (i = 0; i < CPLD_DEVICE_NUM; i++) {
+            if ((modprs_changed >> (i * CPLD_MUX_OFFSET)) & ((1ULL << CPLD_MUX_OFFSET) - 1)) {
+                char name[16];
+
+                snprintf(name, sizeof(name), "cpld%d_modprs", i + 1);
+                sysfs_notify(kobj, NULL, name);
+            }
+        }
+    }
+    if (intr_changed) {
+        sysfs_notify(kobj, NULL, "qsfp_int");
+    }
+}
+
+/* Refresh the snapshot when it is older than status_cache_ms, or always
+ * when force is set. Call with cpld_status.lock held.
+ */
+static int
+cpld_status_update(int force)
+{
+    struct cpld_platform_data *pdata = s8900_64xc_cpld_platform_data;
+    u64 modprs, intr;
+    int ret = 0;
+    int i;
+
+    if (!force && cpld_status.valid &&
+        time_before(jiffies, cpld_status.last_updated + msecs_to_jiffies(status_cache_ms))) {
+        return 0;
+    }
+
+    for (i = 0; i < CPLD_DEVICE_NUM && ret == 0; i++) {
+        u8 *buf = cpld_status.int_abs[i];
+
+        if (i < SFP_CPLD_DEVICE_NUM) {
+            ret = cpld_read_regs(pdata[i].client, int_abs_reg[i][0],
+                                 CPLD_EMPTY_REG_START - 1, buf);
+            if (ret == 0) {
+                ret = cpld_read_regs(pdata[i].client, CPLD_EMPTY_REG_END + 1, int_abs_reg[i][1],
+                                     buf + (CPLD_EMPTY_REG_END + 1 - int_abs_reg[i][0]));
+            }
+        } else {
+            ret = cpld_read_regs(pdata[i].client, int_abs_reg[i][0], int_abs_reg[i][1], buf);
+        }
+    }
+    if (ret == 0) {
+        ret = cpld_read_regs(pdata[cpld_3].client, rst_lp_reg[cpld_3][0],
+                             rst_lp_reg[cpld_3][1], cpld_status.rst_lp);
+    }
+    if (ret < 0) {
+        cpld_status.valid = 0;
+        return ret;
+    }
+
+    modprs = cpld_prs_bitmap(sig_abs);
+    intr = cpld_prs_bitmap(sig_int);
+    if (cpld_status.valid) {
+        cpld_status_notify(modprs ^ cpld_status.modprs, intr ^ cpld_status.intr);
+    }
+    cpld_status.modprs = modprs;
+    cpld_status.intr = intr;
+    cpld_status.valid = 1;
+    cpld_status.last_updated = jiffies;
+
+    return 0;
+}
+
+static void
+cpld_status_work(struct work_struct *work)
+{
+    mutex_lock(&cpld_status.lock);
+    cpld_status_update(1);
+    mutex_unlock(&cpld_status.lock);
+
+    if (cpld_status.irq >= 0) {
+        schedule_delayed_work(&cpld_status.work, msecs_to_jiffies(STATUS_RESYNC_MS));
+    } else if (status_poll_ms) {
+        schedule_delayed_work(&cpld_status.work, msecs_to_jiffies(max(status_poll_ms, 100U)));
+    }
+}
+
+static irqreturn_t
+cpld_irq_handler(int irq, void *dev_id)
+{
+    mod_delayed_work(system_wq, &cpld_status.work, 0);
+    return IRQ_HANDLED;
+}
+
+static int
+cpld_irq_init(void)
+{
+    int irq;
+    int ret;
+
+    if (irq_gpio < 0) {
+        return -ENODEV;
+    }
+
+    ret = gpio_request(irq_gpio, "s8900_64xc_cpld_int");
+    if (ret) {
+        return ret;
+    }
+    ret = gpio_direction_input(irq_gpio);
+    if (ret) {
+        goto error;
+    }
+    irq = gpio_to_irq(irq_gpio);
+    if (irq < 0) {
+        ret = irq;
+        goto error;
+    }
+    ret = request_irq(irq, cpld_irq_handler, IRQF_TRIGGER_FALLING,
+                      "s8900_64xc_cpld", &cpld_status);
+    if (ret) {
+        goto error;
+    }
+
+    cpld_status.irq = irq;
+    return 0;
+
+error:
+    gpio_free(irq_gpio);
+    return ret;
+}
+
+static void
+cpld_irq_exit(void)
+{
+    if (cpld_status.irq >= 0) {
+        free_irq(cpld_status.irq, &cpld_status);
+        gpio_free(irq_gpio);
+        cpld_status.irq = -1;
+    }
+}
+
+/* module_platform_driver */
+static ssize_t
+get_prs_cpld_reg(struct device *dev,
+                 struct device_attribute *devattr,
+                 char *buf, int signal)
+{
+    u64 data;
+    int ret;
+
+    if (signal != sig_int && signal != sig_abs) {
+        return sprintf(buf, "signal/na");
+    }
+
+    mutex_lock(&cpld_status.lock);
+    ret = cpld_status_update(0);
+    data = (signal == sig_abs) ? cpld_status.modprs : cpld_status.intr;
+    mutex_unlock(&cpld_status.lock);
+
+    if (ret < 0) {
+        return sprintf((char *)buf, "i2c_smbus_read_byte_data/na");
+    }
+
     return sprintf((char *)buf, "0x%016llx\n", data);
 }
 
+/* present bitmap of the ports of one CPLD */
+static ssize_t
+get_cpld_modprs(struct device *dev,
+                struct device_attribute *devattr,
+                char *buf, int cpld)
+{
+    int ports = (cpld < SFP_CPLD_DEVICE_NUM) ? CPLD_MUX_OFFSET : TOTAL_PORT_NUM - 2 * CPLD_MUX_OFFSET;
+    u64 data;
+    int ret;
+
+    mutex_lock(&cpld_status.lock);
+    ret = cpld_status_update(0);
+    data = (cpld_status.modprs >> (cpld * CPLD_MUX_OFFSET)) & ((1ULL << ports) - 1);
+    mutex_unlock(&cpld_status.lock);
+
+    if (ret < 0) {
+        return sprintf((char *)buf, "i2c_smbus_read_byte_data/na");
+    }
+
+    return sprintf((char *)buf, "0x%0*llx\n", ports / 4, data);
+}
+
 /* module_platform_driver */
 static ssize_t
 get_rst_lp_cpld_reg(struct device *dev,
                     struct device_attribute *devattr,
                     char *buf, int signal)
 {
+    u64 data;
     int ret;
-    u64 data = 0;
-    u64 shift = 0;
-    int i = 0;
-    int j = 0;
-    int port = 0;
-    int bit = 0;
-    int bit_mask = 0;
-    int (*reg)[CPLD_DEVICE_NUM][2];
-    struct cpld_platform_data *pdata = NULL;
-
-    pdata = dev->platform_data;
 
-    switch(signal) {
-        case sig_rst:
-            bit = BIT_RST;
-            reg = (typeof(reg)) &rst_lp_reg;
-            break;
-        case sig_lpm:
-            bit = BIT_LPM;
-            reg = (typeof(reg)) &rst_lp_reg;
-            break;
-        default:
-            return sprintf(buf, "na");
+    if (signal != sig_rst && signal != sig_lpm) {
+        return sprintf(buf, "na");
     }
-    bit_mask = 0x1 << bit;
 
-    for (i=2; i<CPLD_DEVICE_NUM; ++i) {
-        for (j = (*reg)[i][0]; j <= (*reg)[i][1]; ++j) {
-            ret = i2c_smbus_read_byte_data(pdata[i].client, j);
-            if (ret < 0) {
-                return sprintf(buf, "na");
-            }
-            shift = ((u64) ((ret & bit_mask) >> bit)) << port;
-            data |= shift;
-            port++;
-        }
+    mutex_lock(&cpld_status.lock);
+    ret = cpld_status_update(0);
+    data = cpld_rst_lp_bitmap(signal);
+    mutex_unlock(&cpld_status.lock);
+
+    if (ret < 0) {
+        return sprintf(buf, "na");
     }
 
     return sprintf(buf, "0x%04llx\n", data);
@@ -759,15 +994,12 @@ set_rst_lp_cpld_reg(struct device *dev,
     unsigned long data;
     int err;
     struct cpld_platform_data *pdata = dev->platform_data;
-    u8 current_reg_val = 0;
+    u8 regs[RST_LP_REG_MAX];
     u8 new_reg_val = 0;
     int value;
-    int i = 0;
     int j = 0;
-    int port = 0;
     int ret = 0;
     int bit = 0;
-    int (*reg)[CPLD_DEVICE_NUM][2];
 
     err = kstrtoul(buf, 16, &data);
     if (err)
@@ -776,46 +1008,50 @@ set_rst_lp_cpld_reg(struct device *dev,
     switch(signal) {
         case sig_rst:
             bit = BIT_RST;
-            reg = (typeof(reg)) &rst_lp_reg;
             break;
         case sig_lpm:
             bit = BIT_LPM;
-            reg = (typeof(reg)) &rst_lp_reg;
             break;
         default:
             return sprintf((char *)buf, "signal/na");
     }
 
-    for (i=2; i<CPLD_DEVICE_NUM; ++i) {
-        for (j = (*reg)[i][0]; j <= (*reg)[i][1]; ++j) {
-            //read reg value
-            current_reg_val = i2c_smbus_read_byte_data(pdata[i].client, j);
-            if (current_reg_val < 0) {
-                return current_reg_val;
-            }
+    mutex_lock(&cpld_status.lock);
 
-            //get new value of port N from data
-            value = (data >> port) & 0x1;
+    //read reg values
+    ret = cpld_read_regs(pdata[cpld_3].client, rst_lp_reg[cpld_3][0],
+                         rst_lp_reg[cpld_3][1], regs);
+    if (ret < 0) {
+        goto exit;
+    }
 
-            //set value on bit N of new_reg_val
-            if (value > 0) {
-                new_reg_val = current_reg_val | (u8) (0x1 << bit);
-            } else {
-                new_reg_val = current_reg_val & (u8) ~(0x1 << bit);
-            }
-            //write reg value if changed
-            if (current_reg_val != new_reg_val) {
-                ret = i2c_smbus_write_byte_data(pdata[i].client, j,
-                                                (u8)(new_reg_val));
-                if (ret < 0){
-                    return ret;
-                }
+    for (j = 0; j < RST_LP_REG_MAX; ++j) {
+        //get new value of port N from data
+        value = (data >> j) & 0x1;
+
+        //set value on bit N of new_reg_val
+        if (value > 0) {
+            new_reg_val = regs[j] | (u8) (0x1 << bit);
+        } else {
+            new_reg_val = regs[j] & (u8) ~(0x1 << bit);
+        }
+        //write reg value if changed
+        if (regs[j] != new_reg_val) {
+            ret = i2c_smbus_write_byte_data(pdata[cpld_3].client,
+                                            rst_lp_reg[cpld_3][0] + j,
+                                            new_reg_val);
+            if (ret < 0) {
+                break;
             }
-            port++;
+            regs[j] = new_reg_val;
         }
     }
 
-    return count;
+    memcpy(cpld_status.rst_lp, regs, sizeof(regs));
+
+exit:
+    mutex_unlock(&cpld_status.lock);
+    return (ret < 0) ? ret : count;
 }
 
 static ssize_t
@@ -855,14 +1091,50 @@ get_modprs(struct device *dev,
     return get_prs_cpld_reg(dev, devattr, buf, sig_abs);
 }
 
+static ssize_t
+get_int(struct device *dev,
+        struct device_attribute *devattr, char *buf)
+{
+    return get_prs_cpld_reg(dev, devattr, buf, sig_int);
+}
+
+static ssize_t
+get_cpld1_modprs(struct device *dev,
+                 struct device_attribute *devattr, char *buf)
+{
+    return get_cpld_modprs(dev, devattr, buf, cpld_1);
+}
+
+static ssize_t
+get_cpld2_modprs(struct device *dev,
+                 struct device_attribute *devattr, char *buf)
+{
+    return get_cpld_modprs(dev, devattr, buf, cpld_2);
+}
+
+static ssize_t
+get_cpld3_modprs(struct device *dev,
+                 struct device_attribute *devattr, char *buf)
+{
+    return get_cpld_modprs(dev, devattr, buf, cpld_3);
+}
+
 static DEVICE_ATTR(qsfp_modprs, S_IRUGO, get_modprs, NULL);
 static DEVICE_ATTR(qsfp_lpmode, S_IRUGO | S_IWUSR, get_lpmode, set_lpmode);
 static DEVICE_ATTR(qsfp_reset,  S_IRUGO | S_IWUSR, get_reset, set_reset);
+static DEVICE_ATTR(qsfp_int, S_IRUGO, get_int, NULL);
+static DEVICE_ATTR(cpld1_modprs, S_IRUGO, get_cpld1_modprs, NULL);
+static DEVICE_ATTR(cpld2_modprs, S_IRUGO, get_cpld2_modprs, NULL);
+static DEVICE_ATTR(cpld3_modprs, S_IRUGO, get_cpld3_modprs, NULL);
 
 static struct attribute *s8900_64xc_cpld_attrs[] = {
     &dev_attr_qsfp_lpmode.attr,
     &dev_attr_qsfp_reset.attr,
     &dev_attr_qsfp_modprs.attr,
+    &dev_attr_qsfp_int.attr,
+    &dev_attr_cpld1_modprs.attr,
+    &dev_attr_cpld2_modprs.attr,
+    &dev_attr_cpld3_modprs.attr,
     NULL,
 };
 
@@ -1655,6 +1927,12 @@ cpld_probe(struct platform_device *pdev)
     if (ret)
         goto error;
 
+    ret = cpld_irq_init();
+    if (ret) {
+        DEBUG_PRINT("cpld interrupt not available (%d), port status is polled", ret);
+    }
+    schedule_delayed_work(&cpld_status.work, 0);
+
     return 0;
 
 error:
@@ -1678,6 +1956,8 @@ static int __exit cpld_remove(struct platform_device *pdev)
     struct i2c_adapter *parent = NULL;
     struct cpld_platform_data *pdata = pdev->dev.platform_data;
 
+    cpld_irq_exit();
+    cancel_delayed_work_sync(&cpld_status.work);
     sysfs_remove_group(&pdev->dev.kobj, &s8900_64xc_cpld_attr_grp);
 
     if (!pdata) {
@@ -1723,6 +2003,9 @@ static int __init ingrasys_s8900_64xc_platform_init(void)
 
     //mdelay(10000);
 
+    mutex_init(&cpld_status.lock);
+    INIT_DELAYED_WORK(&cpld_status.work, cpld_status_work);
+
     ret = platform_driver_register(&cpld_driver);
     if (ret) {
         ERROR_MSG("Fail to register cpld driver\n");
@@ -10,6 +10,9 @@
 #include <linux/jiffies.h>
 #include <linux/dmi.h>
 #include <linux/i2c.h>
+#include <linux/gpio.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include "inv_swps.h"
 
 static int ctl_major;
@@ -27,6 +30,26 @@ static struct inv_ioexp_layout_s *ioexp_layout = NULL;
 static struct inv_port_layout_s *port_layout = NULL;
 int io_no_init = 0;
 module_param(io_no_init, int, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+/* GPIO of the wired-OR IOEXP INT line (active low), -1 for plain polling */
+int ioexp_int_gpio = -1;
+module_param(ioexp_int_gpio, int, S_IRUSR | S_IRGRP);
+static int ioexp_int_irq = -1;
+static int ioexp_int_event;
+static unsigned long ioexp_int_next_full;
+static struct workqueue_struct *swp_poll_wq = NULL;
+static int *swp_poll_group_of = NULL;   /* group index of each minor */
+static int swp_poll_group_total;
+static void swp_poll_group_worker(struct work_struct *work);
+
+struct swp_poll_group_s {
+    struct work_struct work;
+    int root_nr;   /* I2C bus number of the root adapter */
+    int err_code;
+};
+static struct swp_poll_group_s swp_poll_groups[SWP_POLL_GROUP_MAX];
+static struct swp_port_status_s port_status;
+static struct device *modctl_dev_p = NULL;
+static DEFINE_MUTEX(port_status_lock);
 static void swp_polling_worker(struct work_struct *work);
 static DECLARE_DELAYED_WORK(swp_polling, swp_polling_worker);
 
@@ -107,11 +130,17 @@ static int
 _get_polling_period(void) {
 
     int retval = 0;
+    int period = SWP_POLLING_PERIOD;
 
-    if (SWP_POLLING_PERIOD == 0) {
+    if (ioexp_int_irq >= 0) {
+        period = SWP_SAFETY_POLLING_PERIOD;
+    } else if (ioexp_int_gpio >= 0) {
+        period = SWP_INT_POLLING_PERIOD;
+    }
+    if (period == 0) {
         return 0;
     }
-    retval = ((SWP_POLLING_PERIOD * HZ) / 1000);
+    retval = ((period * HZ) / 1000);
     if (retval == 0) {
         return 1;
     }
@@ -292,6 +321,84 @@ show_attr_auto_config(struct device *dev_p,
 }
 
 
+static void
+_set_port_status_bit(uint8_t *map_p,
+                     int port_id,
+                     int val){
+
+    if ((port_id < 0) || (port_id >= (SWP_PORT_STATUS_BYTES * 8))) {
+        return;
+    }
+    if (val > 0) {
+        map_p[port_id / 8] |= (1 << (port_id % 8));
+    }
+}
+
+
+static void
+update_port_status(void){
+    /* [Note]
+     *  Only reads the IOEXP cache which was just refreshed by the polling
+     *  round, so it does not touch I2C.
+     */
+    struct swp_port_status_s curr;
+    struct ioexp_obj_s *ioexp_p = NULL;
+    int minor_curr, port_id, offset;
+
+    memset(&curr, 0, sizeof(curr));
+    curr.port_total = port_total;
+    for (minor_curr=0; minor_curr<port_total; minor_curr++) {
+        port_id = port_layout[minor_curr].port_id;
+        offset  = port_layout[minor_curr].ioexp_offset;
+        ioexp_p = get_ioexp_obj(port_layout[minor_curr].ioexp_id);
+        if (!ioexp_p) {
+            continue;
+        }
+        _set_port_status_bit(curr.present, port_id,
+                             ioexp_p->get_present(ioexp_p, offset));
+        _set_port_status_bit(curr.rxlos, port_id,
+                             ioexp_p->get_rxlos(ioexp_p, offset));
+        _set_port_status_bit(curr.tx_fault, port_id,
+                             ioexp_p->get_tx_fault(ioexp_p, offset));
+        _set_port_status_bit(curr.lpmod, port_id,
+                             ioexp_p->get_lpmod(ioexp_p, offset));
+        _set_port_status_bit(curr.reset, port_id,
+                             ioexp_p->get_reset(ioexp_p, offset));
+    }
+    mutex_lock(&port_status_lock);
+    curr.seq = port_status.seq;
+    if (memcmp(&curr, &port_status, sizeof(curr)) != 0) {
+        curr.seq++;
+        memcpy(&port_status, &curr, sizeof(curr));
+        if (modctl_dev_p) {
+            sysfs_notify(&modctl_dev_p->kobj, NULL, "port_status");
+        }
+    }
+    mutex_unlock(&port_status_lock);
+}
+
+
+static ssize_t
+read_bin_port_status(struct file *file_p,
+                     struct kobject *kobj_p,
+                     struct bin_attribute *attr_p,
+                     char *buf_p,
+                     loff_t off,
+                     size_t count){
+
+    if (off >= sizeof(port_status)) {
+        return 0;
+    }
+    if (count > (sizeof(port_status) - off)) {
+        count = sizeof(port_status) - off;
+    }
+    mutex_lock(&port_status_lock);
+    memcpy(buf_p, ((char *)&port_status) + off, count);
+    mutex_unlock(&port_status_lock);
+    return count;
+}
+
+
 static ssize_t
 show_attr_block_poll(struct device *dev_p,
                      struct device_attribute *attr_p,
@@ -1162,6 +1269,26 @@ show_attr_auto_tx_disable(struct device *dev_p,
 }
 
 
+static ssize_t
+show_attr_poll_time(struct device *dev_p,
+                    struct device_attribute *attr_p,
+                    char *buf_p){
+
+    unsigned long avg = 0;
+    struct transvr_obj_s *tobj_p = dev_get_drvdata(dev_p);
+    if(!tobj_p){
+        return -ENODEV;
+    }
+    if (tobj_p->poll_count) {
+        avg = tobj_p->poll_total_us / tobj_p->poll_count;
+    }
+    /* <last> <max> <avg> (usec) <count> */
+    return snprintf(buf_p, 64, "%lu %lu %lu %lu\n",
+                    tobj_p->poll_last_us, tobj_p->poll_max_us,
+                    avg, tobj_p->poll_count);
+}
+
+
 /* ========== Store functions: transceiver (R/W) attribute ==========
  */
 static ssize_t
@@ -1707,6 +1834,8 @@ static DEVICE_ATTR(reset_swps,      S_IWUSR,         NULL,
 static DEVICE_ATTR(auto_config,     S_IRUGO|S_IWUSR, show_attr_auto_config,     store_attr_auto_config);
 static DEVICE_ATTR(block_poll,      S_IRUGO|S_IWUSR, show_attr_block_poll,      store_attr_block_poll);
 static DEVICE_ATTR(io_no_init,      S_IRUGO|S_IWUSR, show_attr_io_no_init,      store_attr_io_no_init);
+static BIN_ATTR(port_status,        S_IRUGO,         read_bin_port_status,      NULL,
+                sizeof(struct swp_port_status_s));
 
 
 /* ========== Transceiver attribute: from eeprom ==========
@@ -1754,6 +1883,7 @@ static DEVICE_ATTR(soft_tx_disable, S_IRUGO|S_IWUSR, show_attr_soft_tx_disable,
 static DEVICE_ATTR(auto_tx_disable, S_IRUGO|S_IWUSR, show_attr_auto_tx_disable, store_attr_auto_tx_disable);
 static DEVICE_ATTR(extphy_offset,   S_IRUGO|S_IWUSR, show_attr_extphy_offset,   store_attr_extphy_offset);
 static DEVICE_ATTR(extphy_reg,      S_IRUGO|S_IWUSR, show_attr_extphy_reg,      store_attr_extphy_reg);
+static DEVICE_ATTR(poll_time,       S_IRUGO,         show_attr_poll_time,       NULL);
 
 /* ========== IO Expander attribute: from expander ==========
  */
@@ -1813,13 +1943,32 @@ clean_swps_common(void){
     dev_t dev_num;
     struct device *device_p;
 
+    mutex_lock(&port_status_lock);
+    modctl_dev_p = NULL;
+    mutex_unlock(&port_status_lock);
     device_p = get_swpdev_by_name(SWP_DEV_MODCTL);
     if (device_p){
         dev_num = MKDEV(ctl_major, 1);
         device_unregister(device_p);
         device_destroy(swp_class_p, dev_num);
     }
+    if (ioexp_int_irq >= 0) {
+        free_irq(ioexp_int_irq, &swp_polling);
+        ioexp_int_irq = -1;
+    }
     cancel_delayed_work_sync(&swp_polling);
+    if (swp_poll_wq) {
+        destroy_workqueue(swp_poll_wq);
+        swp_poll_wq = NULL;
+    }
+    if (swp_poll_group_of) {
+        kfree(swp_poll_group_of);
+        swp_poll_group_of = NULL;
+    }
+    if (ioexp_int_gpio >= 0) {
+        gpio_free(ioexp_int_gpio);
+        ioexp_int_gpio = -1;
+    }
     if (platform_p) {
         kfree(platform_p);
     }
@@ -2294,6 +2443,7 @@ check_transvr_obj_one(char *dev_name){
      */
     struct transvr_obj_s *tobj_p = NULL;
     int retval = -9;
+    int state;
 
     tobj_p = _get_transvr_obj(dev_name);
     if (!tobj_p) {
@@ -2303,7 +2453,12 @@ check_transvr_obj_one(char *dev_name){
     }
     /* Check transceiver current status */
     lock_transvr_obj(tobj_p);
+    state = tobj_p->state;
     retval = tobj_p->check(tobj_p);
+    /* Drop cached DOM values on insertion, removal or any other change */
+    if (tobj_p->state != state) {
+        invalidate_transvr_cache(tobj_p);
+    }
     unlock_transvr_obj(tobj_p);
     switch (retval) {
         case 0:
@@ -2329,50 +2484,211 @@ check_transvr_obj_one(char *dev_name){
 
 
 static int
-check_transvr_objs(void){
+check_transvr_obj_timed(int minor_curr){
 
     char dev_name[32];
-    int port_id, err_code;
-    int minor_curr = 0;
+    int err_code;
+    unsigned long cost;
+    ktime_t start;
+    struct transvr_obj_s *tobj_p = NULL;
+
+    /* Generate device name */
+    memset(dev_name, 0, sizeof(dev_name));
+    snprintf(dev_name, sizeof(dev_name), "%s%d",
+             SWP_DEV_PORT, port_layout[minor_curr].port_id);
+    /* Handle current status */
+    start = ktime_get();
+    err_code = check_transvr_obj_one(dev_name);
+    cost = (unsigned long)ktime_us_delta(ktime_get(), start);
+    tobj_p = _get_transvr_obj(dev_name);
+    if (tobj_p) {
+        tobj_p->poll_last_us = cost;
+        tobj_p->poll_total_us += cost;
+        tobj_p->poll_count++;
+        if (cost > tobj_p->poll_max_us) {
+            tobj_p->poll_max_us = cost;
+        }
+    }
+    switch (err_code) {
+        case  0:
+        case -1:
+        case -2:
+            break;
 
+        case -9:
+        default:
+            SWPS_DEBUG("%s: %s internal error <err>:%d\n",
+                    __func__, dev_name, err_code);
+            break;
+    }
+    return err_code;
+}
+
+
+static void
+swp_poll_group_worker(struct work_struct *work){
+
+    struct swp_poll_group_s *group_p;
+    int minor_curr;
+    int group_id;
+
+    group_p  = container_of(work, struct swp_poll_group_s, work);
+    group_id = group_p - swp_poll_groups;
+    group_p->err_code = 0;
     for (minor_curr=0; minor_curr<port_total; minor_curr++) {
-        /* Generate device name */
-        port_id = port_layout[minor_curr].port_id;
-        memset(dev_name, 0, sizeof(dev_name));
-        snprintf(dev_name, sizeof(dev_name), "%s%d", SWP_DEV_PORT, port_id);
-        /* Handle current status */
-        err_code = check_transvr_obj_one(dev_name);
-        switch (err_code) {
-            case  0:
-            case -1:
-                break;
+        if (swp_poll_group_of[minor_curr] != group_id) {
+            continue;
+        }
+        if (check_transvr_obj_timed(minor_curr) == -2) {
+            /* The topology reset is global, leave it to the caller
+             * once every group is done.
+             */
+            group_p->err_code = -2;
+            break;
+        }
+    }
+}
 
-            case -2:
-                SWPS_DEBUG("%s: %s reset I2C GO.\n",
-                           __func__, dev_name);
-                if (reset_i2c_topology() < 0) {
-                    goto err_check_transvr_objs;
-                }
-                SWPS_DEBUG("%s: %s reset I2C OK.\n",
-                           __func__, dev_name);
-                break;
 
-            case -9:
-            default:
-                SWPS_DEBUG("%s: %s internal error <err>:%d\n",
-                        __func__, dev_name, err_code);
+static int
+_get_root_i2c_nr(int chan_id){
+
+    struct i2c_adapter *adap_p = NULL;
+    struct i2c_adapter *root_p = NULL;
+    int root_nr = -1;
+
+    adap_p = i2c_get_adapter(chan_id);
+    if (!adap_p) {
+        return -1;
+    }
+    root_p = adap_p;
+    while (i2c_parent_is_i2c_adapter(root_p)) {
+        root_p = i2c_parent_is_i2c_adapter(root_p);
+    }
+    root_nr = root_p->nr;
+    i2c_put_adapter(adap_p);
+    return root_nr;
+}
+
+
+static int
+init_poll_groups(void){
+    /* [Note]
+     *  Ports behind the same root adapter share its bus lock anyway,
+     *  so they are polled in one group. Different root buses are
+     *  polled concurrently and a NAKing module only holds up its own.
+     */
+    int minor_curr, group_id, root_nr;
+
+    swp_poll_group_total = 0;
+    swp_poll_group_of = kzalloc(sizeof(int) * port_total, GFP_KERNEL);
+    if (!swp_poll_group_of) {
+        goto err_init_poll_groups;
+    }
+    for (minor_curr=0; minor_curr<port_total; minor_curr++) {
+        root_nr = _get_root_i2c_nr(port_layout[minor_curr].chan_id);
+        for (group_id=0; group_id<swp_poll_group_total; group_id++) {
+            if (swp_poll_groups[group_id].root_nr == root_nr) {
                 break;
+            }
+        }
+        if (group_id == swp_poll_group_total) {
+            if (swp_poll_group_total < SWP_POLL_GROUP_MAX) {
+                swp_poll_groups[group_id].root_nr = root_nr;
+                INIT_WORK(&swp_poll_groups[group_id].work,
+                          swp_poll_group_worker);
+                swp_poll_group_total++;
+            } else {
+                group_id = SWP_POLL_GROUP_MAX - 1;
+            }
         }
+        swp_poll_group_of[minor_curr] = group_id;
     }
+    swp_poll_wq = alloc_workqueue("swps_poll", WQ_UNBOUND,
+                                  SWP_POLL_GROUP_MAX);
+    if (!swp_poll_wq) {
+        goto err_init_poll_groups;
+    }
+    SWPS_DEBUG("%s: %d poll group(s).\n", __func__, swp_poll_group_total);
+    return 0;
+
+err_init_poll_groups:
+    SWPS_ERR("%s: fail.\n", __func__);
+    return -1;
+}
+
+
+static int
+check_transvr_objs(void){
+
+    int group_id;
+    int need_reset = 0;
+
+    for (group_id=0; group_id<swp_poll_group_total; group_id++) {
+        queue_work(swp_poll_wq, &swp_poll_groups[group_id].work);
+    }
+    for (group_id=0; group_id<swp_poll_group_total; group_id++) {
+        flush_work(&swp_poll_groups[group_id].work);
+        if (swp_poll_groups[group_id].err_code == -2) {
+            need_reset = 1;
+        }
+    }
+    if (!need_reset) {
+        return 0;
+    }
+    SWPS_DEBUG("%s: reset I2C GO.\n", __func__);
+    if (reset_i2c_topology() < 0) {
+        goto err_check_transvr_objs;
+    }
+    SWPS_DEBUG("%s: reset I2C OK.\n", __func__);
     return 0;
 
 err_check_transvr_objs:
-    SWPS_ERR("%s: %s reset_i2c_topology fail.\n",
-               __func__, dev_name);
+    SWPS_ERR("%s: reset_i2c_topology fail.\n", __func__);
     return -1;
 }
 
 
+static int
+check_transvr_objs_by_int(void){
+
+    char dev_name[32];
+    int port_id, minor_curr;
+    struct transvr_obj_s *tobj_p = NULL;
+
+    for (minor_curr=0; minor_curr<port_total; minor_curr++) {
+        port_id = port_layout[minor_curr].port_id;
+        memset(dev_name, 0, sizeof(dev_name));
+        snprintf(dev_name, sizeof(dev_name), "%s%d", SWP_DEV_PORT, port_id);
+        tobj_p = _get_transvr_obj(dev_name);
+        if ((!tobj_p) || (!tobj_p->ioexp_obj_p) ||
+            (!tobj_p->ioexp_obj_p->changed)) {
+            continue;
+        }
+        if (check_transvr_obj_one(dev_name) == -2) {
+            SWPS_DEBUG("%s: %s reset I2C GO.\n", __func__, dev_name);
+            if (reset_i2c_topology() < 0) {
+                SWPS_ERR("%s: %s reset_i2c_topology fail.\n",
+                         __func__, dev_name);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+static irqreturn_t
+ioexp_int_handler(int irq, void *dev_id){
+
+    ioexp_int_event = 1;
+    if (!block_polling) {
+        mod_delayed_work(system_wq, &swp_polling, 0);
+    }
+    return IRQ_HANDLED;
+}
+
+
 static void
 swp_polling_worker(struct work_struct *work){
 
@@ -2380,10 +2696,32 @@ swp_polling_worker(struct work_struct *work){
     if (flag_i2c_reset) {
         goto polling_reset_i2c;
     }
+    /* IOEXP INT mode: only re-read what the INT line points at, and run
+     * the full round below as a safety net every SWP_SAFETY_POLLING_PERIOD.
+     */
+    if ((ioexp_int_gpio >= 0) &&
+        time_before(jiffies, ioexp_int_next_full)) {
+        if ((!ioexp_int_event) && gpio_get_value(ioexp_int_gpio)) {
+            goto polling_schedule_round;
+        }
+        ioexp_int_event = 0;
+        if (check_ioexp_objs_by_int(ioexp_int_gpio) < 0) {
+            goto polling_reset_i2c;
+        }
+        update_port_status();
+        if (check_transvr_objs_by_int() < 0) {
+            flag_i2c_reset = 1;
+        }
+        goto polling_schedule_round;
+    }
+    ioexp_int_event = 0;
+    ioexp_int_next_full = jiffies +
+                          msecs_to_jiffies(SWP_SAFETY_POLLING_PERIOD);
     /* Check IOEXP */
     if (check_ioexp_objs() < 0) {
         goto polling_reset_i2c;
     }
+    update_port_status();
     /* Check transceiver */
     if (check_transvr_objs() < 0) {
         SWPS_DEBUG("%s: check_transvr_objs fail.\n", __func__);
@@ -2524,6 +2862,10 @@ register_transvr_common_attr(struct device *device_p){
         err_attr = "dev_attr_wavelength";
         goto err_transvr_comm_attr;
     }
+    if (device_create_file(device_p, &dev_attr_poll_time) < 0) {
+        err_attr = "dev_attr_poll_time";
+        goto err_transvr_comm_attr;
+    }
     return 0;
 
 err_transvr_comm_attr:
@@ -2801,6 +3143,10 @@ register_modctl_attr(struct device *device_p){
         err_msg = "dev_attr_io_no_init";
         goto err_reg_modctl_attr;
     }
+    if (device_create_bin_file(device_p, &bin_attr_port_status) < 0) {
+        err_msg = "bin_attr_port_status";
+        goto err_reg_modctl_attr;
+    }
 
     return 0;
 
@@ -2893,6 +3239,9 @@ register_modctl_device(void) {
         err_msg = "register_modctl_attr fail";
         goto err_register_modctl_device_2;
     }
+    mutex_lock(&port_status_lock);
+    modctl_dev_p = device_p;
+    mutex_unlock(&port_status_lock);
     return 0;
 
 err_register_modctl_device_2:
@@ -3142,9 +3491,43 @@ err_init_dev_topology:
 }
 
 
+static void
+init_ioexp_int(void){
+
+    int irq;
+
+    if (ioexp_int_gpio < 0) {
+        return;
+    }
+    if (gpio_request(ioexp_int_gpio, "swps_ioexp_int") < 0) {
+        SWPS_ERR("%s: request GPIO-%d fail, use polling.\n",
+                 __func__, ioexp_int_gpio);
+        ioexp_int_gpio = -1;
+        return;
+    }
+    gpio_direction_input(ioexp_int_gpio);
+    ioexp_int_next_full = jiffies;
+    /* Most ICH GPIOs can not raise an IRQ, then we poll the INT level
+     * which costs one LPC I/O access instead of an I2C round.
+     */
+    irq = gpio_to_irq(ioexp_int_gpio);
+    if ((irq >= 0) &&
+        (request_irq(irq, ioexp_int_handler, IRQF_TRIGGER_FALLING,
+                     "swps_ioexp_int", &swp_polling) == 0)) {
+        ioexp_int_irq = irq;
+    }
+    SWPS_INFO("%s: IOEXP INT on GPIO-%d <irq>:%d\n",
+              __func__, ioexp_int_gpio, ioexp_int_irq);
+}
+
+
 static int
 init_polling_task(void){
 
+    if (init_poll_groups() < 0) {
+        return -1;
+    }
+    init_ioexp_int();
     if (SWP_POLLING_ENABLE){
         schedule_delayed_work(&swp_polling, _get_polling_period());
     }
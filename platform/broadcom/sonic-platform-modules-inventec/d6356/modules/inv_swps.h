@@ -12,6 +12,9 @@
 #define SWP_RESET_PWD         "inventec"
 #define SWP_POLLING_PERIOD    (300)  /* msec */
 #define SWP_POLLING_ENABLE    (1)
+#define SWP_INT_POLLING_PERIOD    (20)    /* msec, IOEXP INT line check */
+#define SWP_SAFETY_POLLING_PERIOD (3000)  /* msec, full round with IOEXP INT */
+#define SWP_POLL_GROUP_MAX    (8)    /* root I2C buses polled in parallel */
 #define SWP_AUTOCONFIG_ENABLE (1)
 
 /* Module information */
@@ -127,6 +130,23 @@ struct inv_platform_s {
     char name[64];
 };
 
+/* Binary attribute "port_status" of the module control device.
+ * Bit N of each map is the value of that attribute on port N, read from
+ * the IOEXP cache. seq is bumped and poll() waiters are woken up on
+ * every change.
+ */
+#define SWP_PORT_STATUS_BYTES (16)   /* up to 128 ports */
+
+struct swp_port_status_s {
+    uint32_t seq;
+    uint32_t port_total;
+    uint8_t  present[SWP_PORT_STATUS_BYTES];
+    uint8_t  rxlos[SWP_PORT_STATUS_BYTES];
+    uint8_t  tx_fault[SWP_PORT_STATUS_BYTES];
+    uint8_t  lpmod[SWP_PORT_STATUS_BYTES];
+    uint8_t  reset[SWP_PORT_STATUS_BYTES];
+};
+
 struct inv_ioexp_layout_s {
     int ioexp_id;
     int ioexp_type;
@@ -1,5 +1,6 @@
 #include <linux/slab.h>
 #include <linux/i2c.h>
+#include <linux/gpio.h>
 #include "io_expander.h"
 
 /* For build single module using (Ex: ONL platform) */
@@ -2412,6 +2413,42 @@ check_ioexp_objs(void){
 EXPORT_SYMBOL(check_ioexp_objs);
 
 
+int
+check_ioexp_objs_by_int(int int_gpio){
+    /* [Note]
+     *  The IOEXP INT lines are wired-OR to one GPIO (active low).
+     *  Reading an input port clears the INT of that IOEXP, so we stop
+     *  walking the list as soon as the line is released and only mark
+     *  the IOEXPs whose input data really changed.
+     */
+    struct ioexp_data_s old_data[ARRAY_SIZE(ioexp_head_p->chip_data)];
+    struct ioexp_obj_s *ioexp_curr_p = ioexp_head_p;
+
+    while (ioexp_curr_p){
+        ioexp_curr_p->changed = 0;
+        ioexp_curr_p = ioexp_curr_p->next;
+    }
+    ioexp_curr_p = ioexp_head_p;
+    while (ioexp_curr_p){
+        memcpy(old_data, ioexp_curr_p->chip_data, sizeof(old_data));
+        if ( (ioexp_curr_p->check(ioexp_curr_p)) < 0){
+            SWPS_INFO("check IOEXP-%d fail! <type>:%d\n",
+                     ioexp_curr_p->ioexp_id, ioexp_curr_p->ioexp_type);
+            return -1;
+        }
+        if (memcmp(old_data, ioexp_curr_p->chip_data, sizeof(old_data))) {
+            ioexp_curr_p->changed = 1;
+        }
+        if (gpio_get_value(int_gpio)) {
+            break;
+        }
+        ioexp_curr_p = ioexp_curr_p->next;
+    }
+    return 0;
+}
+EXPORT_SYMBOL(check_ioexp_objs_by_int);
+
+
 struct ioexp_obj_s *
 get_ioexp_obj(int ioexp_id){
 
@@ -125,6 +125,7 @@ struct ioexp_obj_s {
     struct mutex lock;
     int mode;
     int state;
+    int changed;   /* Input data changed in the last check_ioexp_objs_by_int() */
 
     /* ===========================================
      *  Object public functions
@@ -165,6 +166,7 @@ int  create_ioexp_obj(int ioexp_id,
                       int run_mode);
 int  init_ioexp_objs(void);
 int  check_ioexp_objs(void);
+int  check_ioexp_objs_by_int(int int_gpio);
 void clean_ioexp_objs(void);
 
 void unlock_ioexp_all(void);
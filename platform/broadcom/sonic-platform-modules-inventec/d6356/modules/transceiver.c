@@ -173,11 +173,35 @@ int
 _sfp_detect_class_by_1g_ethernet(struct transvr_obj_s* self);
 
 
+/* Put page 0 back when the lock section left an upper page selected.
+ * optoe reads upper page 0 without selecting it, so it must not find
+ * another page there. Done once per section, not after every read.
+ */
+static void
+_common_restore_page(struct transvr_obj_s *self) {
+
+    if ((self->page_sel == VAL_TRANSVR_PAGE_FREE) ||
+        (self->page_sel == 0) ||
+        (!self->i2c_client_p)) {
+        return;
+    }
+    self->i2c_client_p->addr = self->page_addr;
+    if (i2c_smbus_write_byte_data(self->i2c_client_p,
+                                  VAL_TRANSVR_PAGE_SELECT_OFFSET,
+                                  0) < 0) {
+        SWPS_DEBUG("%s: restore page 0 fail <port>:%s\n",
+                   __func__, self->swp_name);
+    }
+    self->page_sel = VAL_TRANSVR_PAGE_FREE;
+}
+
+
 void
 lock_transvr_obj(struct transvr_obj_s *self) {
 
     mutex_lock(&self->lock);
     self->curr_page = VAL_TRANSVR_PAGE_FREE;
+    self->page_sel  = VAL_TRANSVR_PAGE_FREE;
 }
 EXPORT_SYMBOL(lock_transvr_obj);
 
@@ -185,12 +209,30 @@ EXPORT_SYMBOL(lock_transvr_obj);
 void
 unlock_transvr_obj(struct transvr_obj_s *self) {
 
+    _common_restore_page(self);
     self->curr_page = VAL_TRANSVR_PAGE_FREE;
     mutex_unlock(&self->lock);
 }
 EXPORT_SYMBOL(unlock_transvr_obj);
 
 
+void
+invalidate_transvr_cache(struct transvr_obj_s *self) {
+
+    self->dom_cache_mask = 0;
+}
+EXPORT_SYMBOL(invalidate_transvr_cache);
+
+
+static int
+_transvr_cache_hit(struct transvr_obj_s *self,
+                   int  (*attr_update_func)(struct transvr_obj_s *self, int show_err));
+
+static void
+_transvr_cache_fill(struct transvr_obj_s *self,
+                    int  (*attr_update_func)(struct transvr_obj_s *self, int show_err));
+
+
 static int
 _check_by_mode(struct transvr_obj_s *self,
                int  (*attr_update_func)(struct transvr_obj_s *self, int show_err),
@@ -230,7 +272,18 @@ _check_by_mode(struct transvr_obj_s *self,
     goto ok_check_by_mode_1;
 
 ok_check_by_mode_1:
-    return attr_update_func(self, 0);
+    /* Only the polling task tracks insertion and removal */
+    if (self->mode != TRANSVR_MODE_POLLING) {
+        return attr_update_func(self, 0);
+    }
+    if (_transvr_cache_hit(self, attr_update_func)) {
+        return 0;
+    }
+    return_val = attr_update_func(self, 0);
+    if (return_val >= 0) {
+        _transvr_cache_fill(self, attr_update_func);
+    }
+    return return_val;
 
 err_check_by_mode_1:
     SWPS_INFO("_check_by_mode: mode:%d state:%d\n", self->mode, self->state);
@@ -275,6 +328,7 @@ _common_setup_page(struct transvr_obj_s *self,
      *   -3 : Undefined case
      */
     int retval = DEBUG_TRANSVR_INT_VAL;
+    int sel    = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     /* Check */
@@ -305,15 +359,30 @@ _common_setup_page(struct transvr_obj_s *self,
     goto err_common_setup_page;
 
 upper_common_setup_page:
-    if (i2c_smbus_write_byte_data(self->i2c_client_p,
-                                  VAL_TRANSVR_PAGE_SELECT_OFFSET,
-                                  page) < 0) {
-        emsg   = "I2C R/W failure";
-        retval = -2;
-        goto err_common_setup_page;
+    /* Still selected, e.g. read again after a lower page access */
+    if ((self->page_addr == addr) &&
+        (self->page_sel == page)) {
+        self->curr_page = page;
+        return 0;
+    }
+    /* Skip the select and its settle time if the module is on the page */
+    sel = i2c_smbus_read_byte_data(self->i2c_client_p,
+                                   VAL_TRANSVR_PAGE_SELECT_OFFSET);
+    if (sel != page) {
+        if (i2c_smbus_write_byte_data(self->i2c_client_p,
+                                      VAL_TRANSVR_PAGE_SELECT_OFFSET,
+                                      page) < 0) {
+            self->page_sel = VAL_TRANSVR_PAGE_FREE;
+            emsg   = "I2C R/W failure";
+            retval = -2;
+            goto err_common_setup_page;
+        }
+        usleep_range(VAL_TRANSVR_PAGE_SELECT_DELAY * 1000,
+                     (VAL_TRANSVR_PAGE_SELECT_DELAY + 1) * 1000);
     }
+    self->page_addr = addr;
+    self->page_sel  = page;
     self->curr_page = page;
-    mdelay(VAL_TRANSVR_PAGE_SELECT_DELAY);
     return 0;
 
 err_common_setup_page:
@@ -361,6 +430,43 @@ err_common_setup_password:
 }
 */
 
+/* Read <len> bytes from <offset> of the current page in I2C block reads of up
+ * to I2C_SMBUS_BLOCK_MAX bytes. A chunk falls back to byte reads when the
+ * adapter (or the mux in front of the transceiver) can't do block reads or
+ * the block read fails.
+ */
+static int
+_common_read_block(struct transvr_obj_s *self,
+                   int offset,
+                   int len,
+                   uint8_t *buf){
+
+    int i, chunk;
+    int err   = 0;
+    int block = i2c_check_functionality(self->i2c_client_p->adapter,
+                                        I2C_FUNC_SMBUS_READ_I2C_BLOCK);
+
+    while (len > 0) {
+        chunk = (len > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : len;
+        if (!block ||
+            (i2c_smbus_read_i2c_block_data(self->i2c_client_p,
+                                           offset, chunk, buf) != chunk)) {
+            for (i=0; i<chunk; i++) {
+                err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+                if (err < 0){
+                    return err;
+                }
+                buf[i] = (uint8_t)err;
+            }
+        }
+        offset += chunk;
+        buf    += chunk;
+        len    -= chunk;
+    }
+    return 0;
+}
+
+
 static int
 _common_update_uint8_attr(struct transvr_obj_s *self,
                           int addr,
@@ -371,7 +477,6 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
                           char *caller,
                           int show_e){
 
-    int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
@@ -380,13 +485,10 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_uint8_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_uint8_attr;
-        }
-        buf[i] = err;
+    err = _common_read_block(self, offset, len, buf);
+    if (err < 0){
+        emsg = "I2C R/W fail!";
+        goto err_common_update_uint8_attr;
     }
     return 0;
 
@@ -410,8 +512,9 @@ _common_update_int_attr(struct transvr_obj_s *self,
                         char *caller,
                         int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -419,13 +522,16 @@ _common_update_int_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_int_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_int_attr;
         }
-        buf[i] = (int)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (int)tmp[j];
+        }
     }
     return 0;
 
@@ -449,8 +555,9 @@ _common_update_string_attr(struct transvr_obj_s *self,
                            char *caller,
                            int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -458,13 +565,16 @@ _common_update_string_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_string_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_string_attr;
         }
-        buf[i] = (char)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (char)tmp[j];
+        }
     }
     return 0;
 
@@ -1655,6 +1765,100 @@ _common_count_wavelength(struct transvr_obj_s *self,
 }
 
 
+/* Identity fields read by _common_update_attr_all() when the transceiver
+ * gets connected. They can't change until it is removed.
+ */
+static int (* const transvr_static_update_funcs[])(struct transvr_obj_s *self, int show_err) = {
+    _common_update_attr_id,
+    _common_update_attr_extended_id,
+    _common_update_attr_connector,
+    _common_update_attr_transvr_comp,
+    _common_update_attr_transvr_comp_ext,
+    _common_update_attr_vendor_name,
+    _common_update_attr_vendor_pn,
+    _common_update_attr_vendor_rev,
+    _common_update_attr_vendor_sn,
+    _common_update_attr_br,
+    _common_update_attr_len_smf,
+    _common_update_attr_len_om1,
+    _common_update_attr_len_om2,
+    _common_update_attr_len_om3,
+    _common_update_attr_len_om4,
+    _common_update_attr_option,
+    _common_update_attr_comp_rev,
+    _common_update_attr_diag_type,
+    _common_update_attr_wavelength,
+};
+
+/* DOM values, reused for TRANSVR_DOM_CACHE_MS */
+static int (* const transvr_dom_update_funcs[TRANSVR_DOM_CACHE_NUM])(struct transvr_obj_s *self, int show_err) = {
+    _sfp_update_attr_curr_temp,
+    _sfp_update_attr_curr_voltage,
+    _sfp_update_attr_curr_tx_bias,
+    _sfp_update_attr_curr_tx_power,
+    _sfp_update_attr_curr_rx_power,
+    _qsfp_update_attr_curr_temp,
+    _qsfp_update_attr_curr_voltage,
+    _qsfp_update_attr_curr_tx_bias,
+    _qsfp_update_attr_curr_tx_power,
+    _qsfp_update_attr_curr_rx_power,
+};
+
+
+static int
+_transvr_dom_cache_index(int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i;
+
+    for (i=0; i<TRANSVR_DOM_CACHE_NUM; i++) {
+        if (transvr_dom_update_funcs[i] == attr_update_func) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+static int
+_transvr_cache_hit(struct transvr_obj_s *self,
+                   int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i;
+
+    if (!TRANSVR_INFO_CACHE_ENABLE ||
+        self->state != STATE_TRANSVR_CONNECTED) {
+        return 0;
+    }
+    for (i=0; i<ARRAY_SIZE(transvr_static_update_funcs); i++) {
+        if (transvr_static_update_funcs[i] == attr_update_func) {
+            return 1;
+        }
+    }
+    i = _transvr_dom_cache_index(attr_update_func);
+    if ((i >= 0) &&
+        (self->dom_cache_mask & (1 << i)) &&
+        time_before(jiffies, self->dom_cache_jiffies[i] +
+                             msecs_to_jiffies(TRANSVR_DOM_CACHE_MS))) {
+        return 1;
+    }
+    return 0;
+}
+
+
+static void
+_transvr_cache_fill(struct transvr_obj_s *self,
+                    int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i = _transvr_dom_cache_index(attr_update_func);
+
+    if (i < 0) {
+        return;
+    }
+    self->dom_cache_jiffies[i] = jiffies;
+    self->dom_cache_mask |= (1 << i);
+}
+
+
 int
 common_get_id(struct transvr_obj_s *self){
 
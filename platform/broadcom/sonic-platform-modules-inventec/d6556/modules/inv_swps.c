@@ -2097,6 +2097,7 @@ check_transvr_obj_one(char *dev_name){
      */
     struct transvr_obj_s *tobj_p = NULL;
     int retval = -9;
+    int state;
 
     tobj_p = _get_transvr_obj(dev_name);
     if (!tobj_p) {
@@ -2106,7 +2107,12 @@ check_transvr_obj_one(char *dev_name){
     }
     /* Check transceiver current status */
     lock_transvr_obj(tobj_p);
+    state = tobj_p->state;
     retval = tobj_p->check(tobj_p);
+    /* Drop cached DOM values on insertion, removal or any other change */
+    if (tobj_p->state != state) {
+        invalidate_transvr_cache(tobj_p);
+    }
     unlock_transvr_obj(tobj_p);
     switch (retval) {
         case 0:
@@ -191,6 +191,22 @@ unlock_transvr_obj(struct transvr_obj_s *self) {
 }
 
 
+void
+invalidate_transvr_cache(struct transvr_obj_s *self) {
+
+    self->dom_cache_mask = 0;
+}
+
+
+static int
+_transvr_cache_hit(struct transvr_obj_s *self,
+                   int  (*attr_update_func)(struct transvr_obj_s *self, int show_err));
+
+static void
+_transvr_cache_fill(struct transvr_obj_s *self,
+                    int  (*attr_update_func)(struct transvr_obj_s *self, int show_err));
+
+
 static int
 _check_by_mode(struct transvr_obj_s *self,
                int  (*attr_update_func)(struct transvr_obj_s *self, int show_err),
@@ -230,7 +246,18 @@ _check_by_mode(struct transvr_obj_s *self,
     goto ok_check_by_mode_1;
 
 ok_check_by_mode_1:
-    return attr_update_func(self, 0);
+    /* Only the polling task tracks insertion and removal */
+    if (self->mode != TRANSVR_MODE_POLLING) {
+        return attr_update_func(self, 0);
+    }
+    if (_transvr_cache_hit(self, attr_update_func)) {
+        return 0;
+    }
+    return_val = attr_update_func(self, 0);
+    if (return_val >= 0) {
+        _transvr_cache_fill(self, attr_update_func);
+    }
+    return return_val;
 
 err_check_by_mode_1:
     SWPS_INFO("_check_by_mode: mode:%d state:%d\n", self->mode, self->state);
@@ -361,6 +388,43 @@ err_common_setup_password:
 }
 */
 
+/* Read <len> bytes from <offset> of the current page in I2C block reads of up
+ * to I2C_SMBUS_BLOCK_MAX bytes. A chunk falls back to byte reads when the
+ * adapter (or the mux in front of the transceiver) can't do block reads or
+ * the block read fails.
+ */
+static int
+_common_read_block(struct transvr_obj_s *self,
+                   int offset,
+                   int len,
+                   uint8_t *buf){
+
+    int i, chunk;
+    int err   = 0;
+    int block = i2c_check_functionality(self->i2c_client_p->adapter,
+                                        I2C_FUNC_SMBUS_READ_I2C_BLOCK);
+
+    while (len > 0) {
+        chunk = (len > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : len;
+        if (!block ||
+            (i2c_smbus_read_i2c_block_data(self->i2c_client_p,
+                                           offset, chunk, buf) != chunk)) {
+            for (i=0; i<chunk; i++) {
+                err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+                if (err < 0){
+                    return err;
+                }
+                buf[i] = (uint8_t)err;
+            }
+        }
+        offset += chunk;
+        buf    += chunk;
+        len    -= chunk;
+    }
+    return 0;
+}
+
+
 static int
 _common_update_uint8_attr(struct transvr_obj_s *self,
                           int addr,
@@ -371,7 +435,6 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
                           char *caller,
                           int show_e){
 
-    int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
@@ -380,13 +443,10 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_uint8_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_uint8_attr;
-        }
-        buf[i] = err;
+    err = _common_read_block(self, offset, len, buf);
+    if (err < 0){
+        emsg = "I2C R/W fail!";
+        goto err_common_update_uint8_attr;
     }
     return 0;
 
@@ -410,8 +470,9 @@ _common_update_int_attr(struct transvr_obj_s *self,
                         char *caller,
                         int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -419,13 +480,16 @@ _common_update_int_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_int_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_int_attr;
         }
-        buf[i] = (int)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (int)tmp[j];
+        }
     }
     return 0;
 
@@ -449,8 +513,9 @@ _common_update_string_attr(struct transvr_obj_s *self,
                            char *caller,
                            int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -458,13 +523,16 @@ _common_update_string_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_string_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_string_attr;
         }
-        buf[i] = (char)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (char)tmp[j];
+        }
     }
     return 0;
 
@@ -1655,6 +1723,100 @@ _common_count_wavelength(struct transvr_obj_s *self,
 }
 
 
+/* Identity fields read by _common_update_attr_all() when the transceiver
+ * gets connected. They can't change until it is removed.
+ */
+static int (* const transvr_static_update_funcs[])(struct transvr_obj_s *self, int show_err) = {
+    _common_update_attr_id,
+    _common_update_attr_extended_id,
+    _common_update_attr_connector,
+    _common_update_attr_transvr_comp,
+    _common_update_attr_transvr_comp_ext,
+    _common_update_attr_vendor_name,
+    _common_update_attr_vendor_pn,
+    _common_update_attr_vendor_rev,
+    _common_update_attr_vendor_sn,
+    _common_update_attr_br,
+    _common_update_attr_len_smf,
+    _common_update_attr_len_om1,
+    _common_update_attr_len_om2,
+    _common_update_attr_len_om3,
+    _common_update_attr_len_om4,
+    _common_update_attr_option,
+    _common_update_attr_comp_rev,
+    _common_update_attr_diag_type,
+    _common_update_attr_wavelength,
+};
+
+/* DOM values, reused for TRANSVR_DOM_CACHE_MS */
+static int (* const transvr_dom_update_funcs[TRANSVR_DOM_CACHE_NUM])(struct transvr_obj_s *self, int show_err) = {
+    _sfp_update_attr_curr_temp,
+    _sfp_update_attr_curr_voltage,
+    _sfp_update_attr_curr_tx_bias,
+    _sfp_update_attr_curr_tx_power,
+    _sfp_update_attr_curr_rx_power,
+    _qsfp_update_attr_curr_temp,
+    _qsfp_update_attr_curr_voltage,
+    _qsfp_update_attr_curr_tx_bias,
+    _qsfp_update_attr_curr_tx_power,
+    _qsfp_update_attr_curr_rx_power,
+};
+
+
+static int
+_transvr_dom_cache_index(int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i;
+
+    for (i=0; i<TRANSVR_DOM_CACHE_NUM; i++) {
+        if (transvr_dom_update_funcs[i] == attr_update_func) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+static int
+_transvr_cache_hit(struct transvr_obj_s *self,
+                   int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i;
+
+    if (!TRANSVR_INFO_CACHE_ENABLE ||
+        self->state != STATE_TRANSVR_CONNECTED) {
+        return 0;
+    }
+    for (i=0; i<ARRAY_SIZE(transvr_static_update_funcs); i++) {
+        if (transvr_static_update_funcs[i] == attr_update_func) {
+            return 1;
+        }
+    }
+    i = _transvr_dom_cache_index(attr_update_func);
+    if ((i >= 0) &&
+        (self->dom_cache_mask & (1 << i)) &&
+        time_before(jiffies, self->dom_cache_jiffies[i] +
+                             msecs_to_jiffies(TRANSVR_DOM_CACHE_MS))) {
+        return 1;
+    }
+    return 0;
+}
+
+
+static void
+_transvr_cache_fill(struct transvr_obj_s *self,
+                    int  (*attr_update_func)(struct transvr_obj_s *self, int show_err)) {
+
+    int i = _transvr_dom_cache_index(attr_update_func);
+
+    if (i < 0) {
+        return;
+    }
+    self->dom_cache_jiffies[i] = jiffies;
+    self->dom_cache_mask |= (1 << i);
+}
+
+
 int
 common_get_id(struct transvr_obj_s *self){
 
@@ -13,6 +13,8 @@
 /* advanced features control */
 #define TRANSVR_INFO_DUMP_ENABLE        (1)
 #define TRANSVR_INFO_CACHE_ENABLE       (1)
+#define TRANSVR_DOM_CACHE_MS            (1000)  /* DOM values cache lifetime */
+#define TRANSVR_DOM_CACHE_NUM           (10)
 #define TRANSVR_UEVENT_ENABLE           (1)
 
 /* Transceiver type define */
@@ -676,6 +678,9 @@ struct transvr_obj_s {
     struct ioexp_obj_s  *ioexp_obj_p;
     struct transvr_worker_s *worker_p;
     struct mutex lock;
+    /* DOM update time, valid while the bit in dom_cache_mask is set */
+    unsigned long dom_cache_jiffies[TRANSVR_DOM_CACHE_NUM];
+    unsigned int  dom_cache_mask;
     char swp_name[32];
     int auto_config;
     int auto_tx_disable;
@@ -800,6 +805,7 @@ create_transvr_obj(char *swp_name,
 
 void lock_transvr_obj(struct transvr_obj_s *self);
 void unlock_transvr_obj(struct transvr_obj_s *self);
+void invalidate_transvr_cache(struct transvr_obj_s *self);
 int isolate_transvr_obj(struct transvr_obj_s *self);
 
 int resync_channel_tier_2(struct transvr_obj_s *self);
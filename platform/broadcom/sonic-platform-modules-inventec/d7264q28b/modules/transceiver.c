@@ -354,6 +354,43 @@ err_common_setup_password:
 }
 */
 
+/* Read <len> bytes from <offset> of the current page in I2C block reads of up
+ * to I2C_SMBUS_BLOCK_MAX bytes. A chunk falls back to byte reads when the
+ * adapter (or the mux in front of the transceiver) can't do block reads or
+ * the block read fails.
+ */
+static int
+_common_read_block(struct transvr_obj_s *self,
+                   int offset,
+                   int len,
+                   uint8_t *buf){
+
+    int i, chunk;
+    int err   = 0;
+    int block = i2c_check_functionality(self->i2c_client_p->adapter,
+                                        I2C_FUNC_SMBUS_READ_I2C_BLOCK);
+
+    while (len > 0) {
+        chunk = (len > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : len;
+        if (!block ||
+            (i2c_smbus_read_i2c_block_data(self->i2c_client_p,
+                                           offset, chunk, buf) != chunk)) {
+            for (i=0; i<chunk; i++) {
+                err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+                if (err < 0){
+                    return err;
+                }
+                buf[i] = (uint8_t)err;
+            }
+        }
+        offset += chunk;
+        buf    += chunk;
+        len    -= chunk;
+    }
+    return 0;
+}
+
+
 static int
 _common_update_uint8_attr(struct transvr_obj_s *self,
                           int addr,
@@ -364,7 +401,6 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
                           char *caller,
                           int show_e){
 
-    int   i;
     int   err  = DEBUG_TRANSVR_INT_VAL;
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
@@ -373,13 +409,10 @@ _common_update_uint8_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_uint8_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
-        if (err < 0){
-            emsg = "I2C R/W fail!";
-            goto err_common_update_uint8_attr;
-        }
-        buf[i] = err;
+    err = _common_read_block(self, offset, len, buf);
+    if (err < 0){
+        emsg = "I2C R/W fail!";
+        goto err_common_update_uint8_attr;
     }
     return 0;
 
@@ -403,8 +436,9 @@ _common_update_int_attr(struct transvr_obj_s *self,
                         char *caller,
                         int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -412,13 +446,16 @@ _common_update_int_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_int_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_int_attr;
         }
-        buf[i] = (int)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (int)tmp[j];
+        }
     }
     return 0;
 
@@ -442,8 +479,9 @@ _common_update_string_attr(struct transvr_obj_s *self,
                            char *caller,
                            int show_e){
 
-    int   i;
+    int   i, j, chunk;
     int   err  = DEBUG_TRANSVR_INT_VAL;
+    uint8_t tmp[I2C_SMBUS_BLOCK_MAX];
     char *emsg = DEBUG_TRANSVR_STR_VAL;
 
     err = _common_setup_page(self, addr, page, offset, len, show_e);
@@ -451,13 +489,16 @@ _common_update_string_attr(struct transvr_obj_s *self,
         emsg = "setup EEPROM page fail";
         goto err_common_update_string_attr;
     }
-    for (i=0; i<len; i++) {
-        err = i2c_smbus_read_byte_data(self->i2c_client_p, (offset + i));
+    for (i=0; i<len; i+=chunk) {
+        chunk = ((len - i) > I2C_SMBUS_BLOCK_MAX) ? I2C_SMBUS_BLOCK_MAX : (len - i);
+        err = _common_read_block(self, (offset + i), chunk, tmp);
         if (err < 0){
             emsg = "I2C R/W fail!";
             goto err_common_update_string_attr;
         }
-        buf[i] = (char)err;
+        for (j=0; j<chunk; j++) {
+            buf[i + j] = (char)tmp[j];
+        }
     }
     return 0;
 
@@ -35,6 +35,14 @@
 #define PMBUS_NAME_SIZE		24
 #define PMBUS_BLOCK_READ_SIZE		32
 
+static unsigned int update_interval_ms = 1000;
+module_param(update_interval_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(update_interval_ms, "Max age in ms of the cached status and telemetry");
+
+static unsigned int mfr_interval_ms = 60000;
+module_param(mfr_interval_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(mfr_interval_ms, "Max age in ms of the cached mfr_* strings");
+
 struct pmbus_sensor {
 	struct pmbus_sensor *next;
 	char name[PMBUS_NAME_SIZE];	/* sysfs sensor name */
@@ -109,6 +117,8 @@ struct pmbus_data {
 	struct mutex update_lock;
 	bool valid;
 	unsigned long last_updated;	/* in jiffies */
+	bool mfr_valid;
+	unsigned long mfr_updated;	/* in jiffies */
 
 	/*
 	 * A single status register covers multiple attributes,
@@ -125,6 +135,7 @@ void pmbus_clear_cache(struct i2c_client *client)
 	struct pmbus_data *data = i2c_get_clientdata(client);
 
 	data->valid = false;
+	data->mfr_valid = false;
 }
 
 int pmbus_set_page(struct i2c_client *client, u8 page)
@@ -391,10 +402,20 @@ static struct pmbus_data *pmbus_update_device(struct device *dev)
 	struct pmbus_mfr *mfr;
 
 	mutex_lock(&data->update_lock);
-	if (time_after(jiffies, data->last_updated + HZ) || !data->valid) {
-		int i, j;
+	if (time_after(jiffies, data->last_updated + msecs_to_jiffies(update_interval_ms)) ||
+	    !data->valid) {
+		int i, j, k, start;
+		bool mfr_due = !data->mfr_valid ||
+			time_after(jiffies, data->mfr_updated + msecs_to_jiffies(mfr_interval_ms));
 
-		for (i = 0; i < info->pages; i++) {
+		/*
+		 * Everything of a page is read before moving to the next one,
+		 * starting from the page the device is on, so a refresh costs
+		 * one page change per page at most.
+		 */
+		start = data->currpage < info->pages ? data->currpage : 0;
+		for (k = 0; k < info->pages; k++) {
+			i = (start + k) % info->pages;
 			data->status[PB_STATUS_BASE + i]
 			    = _pmbus_read_byte_data(client, i,
 						    data->status_register);
@@ -407,32 +428,47 @@ static struct pmbus_data *pmbus_update_device(struct device *dev)
 					= _pmbus_read_byte_data(client, i,
 								s->reg);
 			}
-		}
 
-		if (info->func[0] & PMBUS_HAVE_STATUS_INPUT)
-			data->status[PB_STATUS_INPUT_BASE]
-			  = _pmbus_read_byte_data(client, 0,
-						  PMBUS_STATUS_INPUT);
-
-		if (info->func[0] & PMBUS_HAVE_STATUS_VMON)
-			data->status[PB_STATUS_VMON_BASE]
-			  = _pmbus_read_byte_data(client, 0,
-						  PMBUS_VIRT_STATUS_VMON);
-
-		for (sensor = data->sensors; sensor; sensor = sensor->next) {
-			if (!data->valid || sensor->update)
-				sensor->data
-				    = _pmbus_read_word_data(client,
-							    sensor->page,
-							    sensor->reg);
+			if (i == 0 && (info->func[0] & PMBUS_HAVE_STATUS_INPUT))
+				data->status[PB_STATUS_INPUT_BASE]
+				  = _pmbus_read_byte_data(client, 0,
+							  PMBUS_STATUS_INPUT);
+
+			if (i == 0 && (info->func[0] & PMBUS_HAVE_STATUS_VMON))
+				data->status[PB_STATUS_VMON_BASE]
+				  = _pmbus_read_byte_data(client, 0,
+							  PMBUS_VIRT_STATUS_VMON);
+
+			for (sensor = data->sensors; sensor; sensor = sensor->next) {
+				if (sensor->page != i)
+					continue;
+				if (!data->valid || sensor->update)
+					sensor->data
+					    = _pmbus_read_word_data(client,
+								    sensor->page,
+								    sensor->reg);
+			}
+
+			/* read mfg data, the strings only change with the PSU */
+			if (mfr_due) {
+				for (mfr = data->mfr; mfr; mfr = mfr->next) {
+					if (mfr->page == i)
+						mfr->data = _pmbus_read_block_data(client, mfr->page, mfr->reg, mfr->data_buf);
+				}
+			}
+
+			pmbus_clear_fault_page(client, i);
 		}
 
-		/* read mfg data */
-		for (mfr = data->mfr; mfr; mfr = mfr->next) {
-			mfr->data = _pmbus_read_block_data(client, mfr->page, mfr->reg, mfr->data_buf);
+		if (mfr_due) {
+			data->mfr_valid = true;
+			for (mfr = data->mfr; mfr; mfr = mfr->next) {
+				if (mfr->data < 0)
+					data->mfr_valid = false;
+			}
+			data->mfr_updated = jiffies;
 		}
 
-		pmbus_clear_faults(client);
 		data->last_updated = jiffies;
 		data->valid = 1;
 	}
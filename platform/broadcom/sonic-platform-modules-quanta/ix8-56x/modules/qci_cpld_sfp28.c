@@ -38,6 +38,8 @@
 #include <linux/idr.h>
 #include <linux/ctype.h>
 #include <linux/string.h>
+#include <linux/workqueue.h>
+#include <linux/sysfs.h>
 
 static DEFINE_IDA(cpld_ida);
 
@@ -61,8 +63,36 @@ struct cpld_data {
 	struct mutex lock;
 	struct device *port_dev[16];
 	struct sfp_data *port_data[16];
+
+	/* the four group words of port 0..15, refreshed by poll_work */
+	struct i2c_client *client;
+	bool block_read;	/* groups read with one I2C block read */
+	bool status_valid;
+	u64 status;
+	u16 present_changed;	/* latched until port_events is read */
+	u16 rx_los_changed;
+	u16 tx_fault_changed;
+	struct delayed_work poll_work;
 };
 
+/* Layout of the port_events binary attribute, bit n is port n */
+struct cpld_port_events {
+	__le16 present;
+	__le16 rx_los;
+	__le16 tx_fault;
+	__le16 present_changed;
+	__le16 rx_los_changed;
+	__le16 tx_fault_changed;
+} __packed;
+
+static unsigned int poll_ms = 100;
+module_param(poll_ms, uint, S_IRUGO);
+MODULE_PARM_DESC(poll_ms, "Status refresh period in ms, 0 reads the CPLD on each access");
+
+static bool block_read = true;
+module_param(block_read, bool, S_IRUGO);
+MODULE_PARM_DESC(block_read, "Read the four groups with one I2C block read when the CPLD supports it");
+
 static int cpld_probe(struct i2c_client *client,
 			 const struct i2c_device_id *id);
 static int cpld_remove(struct i2c_client *client);
@@ -111,107 +141,210 @@ static inline u8 port_remapping(u8 phy_port)
 	return (phy_port % 2) ? (phy_port - 1) : (phy_port + 1);
 }
 
-//SFP
-static ssize_t get_tx_fault(struct device *dev,
-			     struct device_attribute *devattr,
-			     char *buf)
+/* Read the four group words, port n is the nibble n of the result */
+static int cpld_read_groups(struct cpld_data *data, u64 *status)
 {
-	struct sfp_data *data = dev_get_drvdata(dev);
-	struct i2c_client *client = data->cpld_client;
-	u8 group = (u8)(data->cpld_port / 4);
-	u8 group_port = data->cpld_port % 4;
+	struct i2c_client *client = data->client;
+	u8 buf[8];
+	u64 raw = 0;
 	s32 value;
+	int i;
 
-	dev_dbg(&client->dev, "port_id %d => cpld_port %d, group %d(%d)\n", data->port_id,
-				data->cpld_port + 1, group + 1, group_port + 1);
-
-	value = i2c_smbus_read_word_data(client, get_group_cmd(group));
-	if (value < 0)
-		return -ENODEV;
+	if (data->block_read &&
+	    i2c_smbus_read_i2c_block_data(client, get_group_cmd(0), sizeof(buf), buf) == sizeof(buf)) {
+		for (i = 0; i < sizeof(buf); i++)
+			raw |= (u64)buf[i] << (i * 8);
+		*status = raw;
+		return 0;
+	}
 
-	dev_dbg(&client->dev, "read group%d value= %x\n", group + 1, value);
+	for (i = 0; i < 4; i++) {
+		value = i2c_smbus_read_word_data(client, get_group_cmd(i));
+		if (value < 0)
+			return value;
+		raw |= (u64)(value & 0xffff) << (i * 16);
+	}
+	*status = raw;
+	return 0;
+}
 
-	value >>= (group_port * 4);
-	value &= TX_FAULT_MASK;
+/* Bitmap of port 0..15 of the bits in mask of each port nibble */
+static u16 cpld_status_bitmap(struct cpld_data *data, u64 status, u8 mask)
+{
+	u16 bitmap = 0;
+	int i;
 
-	return sprintf(buf, "%d\n", value ? 1 : 0);
+	for (i = 0; i < 16; i++) {
+		if ((status >> (data->port_data[i]->cpld_port * 4)) & mask)
+			bitmap |= BIT(i);
+	}
+	return bitmap;
 }
 
-static ssize_t get_tx_dis(struct device *dev,
-			     struct device_attribute *devattr,
-			     char *buf)
+/*
+ * Read the four groups, latch what moved since the last snapshot and
+ * wake up the pollers of port_events and of the changed port attributes.
+ */
+static int cpld_update_status(struct cpld_data *data)
 {
-	struct sfp_data *data = dev_get_drvdata(dev);
-	struct i2c_client *client = data->cpld_client;
-	u8 group = (u8)(data->cpld_port / 4);
-	u8 group_port = data->cpld_port % 4;
-	s32 value;
+	u16 present, rx_los, tx_fault;
+	u16 present_changed = 0, rx_los_changed = 0, tx_fault_changed = 0;
+	u64 status;
+	int err, i;
 
-	dev_dbg(&client->dev, "port_id %d => cpld_port %d, group %d(%d)\n", data->port_id,
-				data->cpld_port + 1, group + 1, group_port + 1);
+	err = cpld_read_groups(data, &status);
+	if (err < 0)
+		return err;
 
-	value = i2c_smbus_read_word_data(client, get_group_cmd(group));
-	if (value < 0)
-		return -ENODEV;
+	//FIXME: if present is not low active
+	present = ~cpld_status_bitmap(data, status, PRE_N_MASK);
+	rx_los = cpld_status_bitmap(data, status, RX_LOS_MASK);
+	tx_fault = cpld_status_bitmap(data, status, TX_FAULT_MASK);
+
+	mutex_lock(&data->lock);
+	if (data->status_valid) {
+		present_changed = present ^ ~cpld_status_bitmap(data, data->status, PRE_N_MASK);
+		rx_los_changed = rx_los ^ cpld_status_bitmap(data, data->status, RX_LOS_MASK);
+		tx_fault_changed = tx_fault ^ cpld_status_bitmap(data, data->status, TX_FAULT_MASK);
+		data->present_changed |= present_changed;
+		data->rx_los_changed |= rx_los_changed;
+		data->tx_fault_changed |= tx_fault_changed;
+	}
+	data->status = status;
+	data->status_valid = true;
+	mutex_unlock(&data->lock);
+
+	for (i = 0; i < 16; i++) {
+		if (present_changed & BIT(i))
+			sysfs_notify(&data->port_dev[i]->kobj, NULL, "pre_n");
+		if (rx_los_changed & BIT(i))
+			sysfs_notify(&data->port_dev[i]->kobj, NULL, "rx_los");
+		if (tx_fault_changed & BIT(i))
+			sysfs_notify(&data->port_dev[i]->kobj, NULL, "tx_fault");
+	}
+	if (present_changed | rx_los_changed | tx_fault_changed)
+		sysfs_notify(&data->client->dev.kobj, NULL, "port_events");
 
-	dev_dbg(&client->dev, "read group%d value= %x\n", group + 1, value);
+	return 0;
+}
 
-	value >>= (group_port * 4);
-	value &= TX_DIS_MASK;
+static void cpld_poll_work(struct work_struct *work)
+{
+	struct cpld_data *data = container_of(to_delayed_work(work),
+					      struct cpld_data, poll_work);
 
-	return sprintf(buf, "%d\n", value ? 1 : 0);
+	cpld_update_status(data);
+	schedule_delayed_work(&data->poll_work, msecs_to_jiffies(poll_ms));
 }
 
-static ssize_t get_pre_n(struct device *dev,
-			     struct device_attribute *devattr,
-			     char *buf)
+/* Group words from the snapshot, or from the CPLD when not polling */
+static int cpld_get_status(struct cpld_data *data, u64 *status)
 {
-	struct sfp_data *data = dev_get_drvdata(dev);
-	struct i2c_client *client = data->cpld_client;
-	u8 group = (u8)(data->cpld_port / 4);
-	u8 group_port = data->cpld_port % 4;
-	s32 value;
+	int err;
 
-	dev_dbg(&client->dev, "port_id %d => cpld_port %d, group %d(%d)\n", data->port_id,
-				data->cpld_port + 1, group + 1, group_port + 1);
+	if (!poll_ms || !data->status_valid) {
+		err = cpld_update_status(data);
+		if (err < 0)
+			return err;
+	}
 
-	value = i2c_smbus_read_word_data(client, get_group_cmd(group));
-	if (value < 0)
-		return -ENODEV;
+	mutex_lock(&data->lock);
+	*status = data->status;
+	mutex_unlock(&data->lock);
+	return 0;
+}
 
-	dev_dbg(&client->dev, "read group%d value= %x\n", group + 1, value);
+/* Reading from the start hands over the latched changes and clears them */
+static ssize_t read_port_events(struct file *filp, struct kobject *kobj,
+				struct bin_attribute *attr,
+				char *buf, loff_t off, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(container_of(kobj, struct device, kobj));
+	struct cpld_data *data = i2c_get_clientdata(client);
+	struct cpld_port_events events;
+	u64 status;
 
-	value >>= (group_port * 4);
-	value &= PRE_N_MASK;
+	if (off >= sizeof(events))
+		return 0;
+	if (count > sizeof(events) - off)
+		count = sizeof(events) - off;
 
-	//FIXME: if present is not low active
-	return sprintf(buf, "%d\n", value ? 0 : 1);
+	if (cpld_get_status(data, &status) < 0)
+		return -ENODEV;
+
+	mutex_lock(&data->lock);
+	events.present = cpu_to_le16(~cpld_status_bitmap(data, status, PRE_N_MASK));
+	events.rx_los = cpu_to_le16(cpld_status_bitmap(data, status, RX_LOS_MASK));
+	events.tx_fault = cpu_to_le16(cpld_status_bitmap(data, status, TX_FAULT_MASK));
+	events.present_changed = cpu_to_le16(data->present_changed);
+	events.rx_los_changed = cpu_to_le16(data->rx_los_changed);
+	events.tx_fault_changed = cpu_to_le16(data->tx_fault_changed);
+	if (off == 0) {
+		data->present_changed = 0;
+		data->rx_los_changed = 0;
+		data->tx_fault_changed = 0;
+	}
+	mutex_unlock(&data->lock);
+
+	memcpy(buf, (u8 *)&events + off, count);
+	return count;
 }
 
-static ssize_t get_rx_los(struct device *dev,
-			     struct device_attribute *devattr,
-			     char *buf)
+static struct bin_attribute bin_attr_port_events = {
+	.attr = {
+		.name = "port_events",
+		.mode = S_IRUGO,
+	},
+	.size = sizeof(struct cpld_port_events),
+	.read = read_port_events,
+};
+
+/* Bits in mask of the nibble of a port */
+static ssize_t get_port_status(struct device *dev, char *buf, u8 mask, bool active_low)
 {
 	struct sfp_data *data = dev_get_drvdata(dev);
 	struct i2c_client *client = data->cpld_client;
-	u8 group = (u8)(data->cpld_port / 4);
-	u8 group_port = data->cpld_port % 4;
-	s32 value;
-
-	dev_dbg(&client->dev, "port_id %d => cpld_port %d, group %d(%d)\n", data->port_id,
-				data->cpld_port + 1, group + 1, group_port + 1);
+	u64 status;
+	u8 value;
 
-	value = i2c_smbus_read_word_data(client, get_group_cmd(group));
-	if (value < 0)
+	if (cpld_get_status(i2c_get_clientdata(client), &status) < 0)
 		return -ENODEV;
 
-	dev_dbg(&client->dev, "read group%d value= %x\n", group + 1, value);
+	value = (status >> (data->cpld_port * 4)) & mask;
+
+	return sprintf(buf, "%d\n", (value ? 1 : 0) ^ active_low);
+}
+
+//SFP
+static ssize_t get_tx_fault(struct device *dev,
+			     struct device_attribute *devattr,
+			     char *buf)
+{
+	return get_port_status(dev, buf, TX_FAULT_MASK, false);
+}
 
-	value >>= (group_port * 4);
-	value &= RX_LOS_MASK;
+static ssize_t get_tx_dis(struct device *dev,
+			     struct device_attribute *devattr,
+			     char *buf)
+{
+	return get_port_status(dev, buf, TX_DIS_MASK, false);
+}
 
-	return sprintf(buf, "%d\n", value ? 1 : 0);
+static ssize_t get_pre_n(struct device *dev,
+			     struct device_attribute *devattr,
+			     char *buf)
+{
+	//FIXME: if present is not low active
+	return get_port_status(dev, buf, PRE_N_MASK, true);
 }
+
+static ssize_t get_rx_los(struct device *dev,
+			     struct device_attribute *devattr,
+			     char *buf)
+{
+	return get_port_status(dev, buf, RX_LOS_MASK, false);
+}
+
 static ssize_t set_tx_dis(struct device *dev,
 			    struct device_attribute *devattr,
 			    const char *buf,
@@ -219,6 +352,7 @@ static ssize_t set_tx_dis(struct device *dev,
 {
 	struct sfp_data *data = dev_get_drvdata(dev);
 	struct i2c_client *client = data->cpld_client;
+	struct cpld_data *cpld = i2c_get_clientdata(client);
 	u8 group = (u8)(data->cpld_port / 4);
 	u8 group_port = data->cpld_port % 4;
 	s32 value;
@@ -233,10 +367,12 @@ static ssize_t set_tx_dis(struct device *dev,
 	if ((disable != 1) && (disable != 0))
 		return -EINVAL;
 
-//	mutex_lock(&data->lock);
+	mutex_lock(&cpld->lock);
 	value = i2c_smbus_read_word_data(client, get_group_cmd(group));
-	if (value < 0)
+	if (value < 0) {
+		mutex_unlock(&cpld->lock);
 		return -ENODEV;
+	}
 
 	dev_dbg(&client->dev, "read group%d value= %x\n", group + 1, value);
 
@@ -246,8 +382,13 @@ static ssize_t set_tx_dis(struct device *dev,
 
 	dev_dbg(&client->dev, "write group%d value= %x\n", group + 1, value);
 
-	i2c_smbus_write_word_data(client, get_group_cmd(group), (u16)value);
-//	mutex_unlock(&data->lock);
+	if (i2c_smbus_write_word_data(client, get_group_cmd(group), (u16)value) == 0 &&
+	    cpld->status_valid) {
+		/* keep the snapshot in step until the next refresh */
+		cpld->status &= ~((u64)0xffff << (group * 16));
+		cpld->status |= (u64)(value & 0xffff) << (group * 16);
+	}
+	mutex_unlock(&cpld->lock);
 
 	return count;
 }
@@ -310,6 +451,11 @@ static int cpld_probe(struct i2c_client *client,
 	if (!data)
 		return -ENOMEM;
 
+	i2c_set_clientdata(client, data);
+	mutex_init(&data->lock);
+	data->client = client;
+	INIT_DELAYED_WORK(&data->poll_work, cpld_poll_work);
+
 	/* register sfp port data to sysfs */
 	for (i = 0; i < 16; i++)
 	{
@@ -345,8 +491,30 @@ static int cpld_probe(struct i2c_client *client,
 		// if (status)	printk("err status\n");
 	}
 
-	i2c_set_clientdata(client, data);
-	mutex_init(&data->lock);
+	/*
+	 * Use one block read for the four groups only when the CPLD returns
+	 * the same words as the group reads.
+	 */
+	if (block_read &&
+	    i2c_check_functionality(client->adapter, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+		u64 words, block;
+
+		if (cpld_read_groups(data, &words) == 0) {
+			data->block_read = true;
+			if (cpld_read_groups(data, &block) < 0 || block != words)
+				data->block_read = false;
+		}
+		dev_info(&client->dev, "group block read %s\n",
+			 data->block_read ? "enabled" : "not supported");
+	}
+
+	cpld_update_status(data);
+	if (poll_ms)
+		schedule_delayed_work(&data->poll_work, msecs_to_jiffies(poll_ms));
+
+	err = sysfs_create_bin_file(&client->dev.kobj, &bin_attr_port_events);
+	if (err)
+		dev_warn(&client->dev, "failed to create port_events (%d)\n", err);
 
 	dev_info(&client->dev, "%s device found\n", client->name);
 
@@ -376,6 +544,9 @@ static int cpld_remove(struct i2c_client *client)
 	int i;
 //	int id;
 
+	sysfs_remove_bin_file(&client->dev.kobj, &bin_attr_port_events);
+	cancel_delayed_work_sync(&data->poll_work);
+
 	for (i = 15; i >= 0; i--)
 	{
 		dev_info(data->port_dev[i], "Remove %s port-%d\n", data->port_data[i]->type , data->port_data[i]->port_id);
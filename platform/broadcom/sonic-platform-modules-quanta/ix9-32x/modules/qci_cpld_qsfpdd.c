@@ -36,6 +36,9 @@
 #include <linux/slab.h>
 #include <linux/kdev_t.h>
 #include <linux/idr.h>
+#include <linux/interrupt.h>
+#include <linux/workqueue.h>
+#include <linux/sysfs.h>
 
 static DEFINE_IDA(cpld_ida);
 
@@ -57,8 +60,30 @@ struct cpld_data {
 	struct mutex lock;
 	struct device *port_dev[16];
 	struct sfp_data *port_data[16];
+
+	/* present and interrupt bits of port 0..15, updated by irq or poll */
+	struct i2c_client *client;
+	int irq;		/* 0 when polling */
+	bool status_valid;
+	u16 present;
+	u16 interrupt;
+	u16 present_changed;	/* latched until port_events is read */
+	u16 interrupt_changed;
+	struct delayed_work poll_work;
 };
 
+/* Layout of the port_events binary attribute, bit n is port n */
+struct cpld_port_events {
+	__le16 present;
+	__le16 interrupt;
+	__le16 present_changed;
+	__le16 interrupt_changed;
+} __packed;
+
+static unsigned int poll_ms = 100;
+module_param(poll_ms, uint, S_IRUGO);
+MODULE_PARM_DESC(poll_ms, "Presence/IntL poll period in ms when the CPLD has no irq, 0 reads on demand");
+
 static int cpld_probe(struct i2c_client *client,
 			 const struct i2c_device_id *id);
 static int cpld_remove(struct i2c_client *client);
@@ -105,6 +130,119 @@ static inline u8 port_remapping(u8 phy_port)
 	return (phy_port % 2) ? (phy_port - 1) : (phy_port + 1);
 }
 
+/*
+ * Read the four groups, latch what moved since the last snapshot and
+ * wake up the pollers of port_events.
+ */
+static int cpld_update_status(struct cpld_data *data)
+{
+	struct i2c_client *client = data->client;
+	u16 present = 0, interrupt = 0, changed;
+	u8 nibble;
+	u64 raw = 0;
+	s32 value;
+	int i;
+
+	for (i = 0; i < 4; i++) {
+		value = i2c_smbus_read_word_data(client, get_group_cmd(i));
+		if (value < 0)
+			return value;
+		raw |= (u64)(value & 0xffff) << (i * 16);
+	}
+
+	for (i = 0; i < 16; i++) {
+		nibble = (raw >> (port_remapping(i) * 4)) & 0xf;
+		//FIXME: if present is not low active
+		if (!(nibble & MODULE_PRESENT_MASK))
+			present |= BIT(i);
+		if (nibble & INTERRUPT_MASK)
+			interrupt |= BIT(i);
+	}
+
+	mutex_lock(&data->lock);
+	changed = 0;
+	if (data->status_valid) {
+		data->present_changed |= present ^ data->present;
+		data->interrupt_changed |= interrupt ^ data->interrupt;
+		changed = (present ^ data->present) | (interrupt ^ data->interrupt);
+	}
+	data->present = present;
+	data->interrupt = interrupt;
+	data->status_valid = true;
+	mutex_unlock(&data->lock);
+
+	if (changed)
+		sysfs_notify(&client->dev.kobj, NULL, "port_events");
+
+	return 0;
+}
+
+static irqreturn_t cpld_irq_thread(int irq, void *dev_id)
+{
+	struct cpld_data *data = dev_id;
+
+	cpld_update_status(data);
+	return IRQ_HANDLED;
+}
+
+static void cpld_poll_work(struct work_struct *work)
+{
+	struct cpld_data *data = container_of(to_delayed_work(work),
+					      struct cpld_data, poll_work);
+
+	cpld_update_status(data);
+	schedule_delayed_work(&data->poll_work, msecs_to_jiffies(poll_ms));
+}
+
+/* Reading from the start hands over the latched changes and clears them */
+static ssize_t read_port_events(struct file *filp, struct kobject *kobj,
+				struct bin_attribute *attr,
+				char *buf, loff_t off, size_t count)
+{
+	struct i2c_client *client = to_i2c_client(container_of(kobj, struct device, kobj));
+	struct cpld_data *data = i2c_get_clientdata(client);
+	struct cpld_port_events events;
+	int err;
+
+	if (off >= sizeof(events))
+		return 0;
+	if (count > sizeof(events) - off)
+		count = sizeof(events) - off;
+
+	if (!data->irq && !poll_ms) {
+		err = cpld_update_status(data);
+		if (err < 0)
+			return -ENODEV;
+	}
+
+	mutex_lock(&data->lock);
+	if (!data->status_valid) {
+		mutex_unlock(&data->lock);
+		return -EAGAIN;
+	}
+	events.present = cpu_to_le16(data->present);
+	events.interrupt = cpu_to_le16(data->interrupt);
+	events.present_changed = cpu_to_le16(data->present_changed);
+	events.interrupt_changed = cpu_to_le16(data->interrupt_changed);
+	if (off == 0) {
+		data->present_changed = 0;
+		data->interrupt_changed = 0;
+	}
+	mutex_unlock(&data->lock);
+
+	memcpy(buf, (u8 *)&events + off, count);
+	return count;
+}
+
+static struct bin_attribute bin_attr_port_events = {
+	.attr = {
+		.name = "port_events",
+		.mode = S_IRUGO,
+	},
+	.size = sizeof(struct cpld_port_events),
+	.read = read_port_events,
+};
+
 static ssize_t get_reset(struct device *dev,
 			     struct device_attribute *devattr,
 			     char *buf)
@@ -361,6 +499,28 @@ static int cpld_probe(struct i2c_client *client,
 	i2c_set_clientdata(client, data);
 	mutex_init(&data->lock);
 
+	data->client = client;
+	INIT_DELAYED_WORK(&data->poll_work, cpld_poll_work);
+	cpld_update_status(data);
+
+	if (client->irq > 0) {
+		data->irq = client->irq;
+		err = devm_request_threaded_irq(&client->dev, client->irq, NULL,
+						cpld_irq_thread, IRQF_ONESHOT | IRQF_SHARED,
+						client->name, data);
+		if (err) {
+			dev_warn(&client->dev, "irq %d unavailable (%d), polling instead\n",
+				 client->irq, err);
+			data->irq = 0;
+		}
+	}
+	if (!data->irq && poll_ms)
+		schedule_delayed_work(&data->poll_work, msecs_to_jiffies(poll_ms));
+
+	err = sysfs_create_bin_file(&client->dev.kobj, &bin_attr_port_events);
+	if (err)
+		dev_warn(&client->dev, "failed to create port_events (%d)\n", err);
+
 	dev_info(&client->dev, "%s device found\n", client->name);
 
 
@@ -390,6 +550,11 @@ static int cpld_remove(struct i2c_client *client)
 	struct cpld_data *data = i2c_get_clientdata(client);
 	int i;
 
+	sysfs_remove_bin_file(&client->dev.kobj, &bin_attr_port_events);
+	if (data->irq)
+		devm_free_irq(&client->dev, data->irq, data);
+	cancel_delayed_work_sync(&data->poll_work);
+
 	for (i = 15; i >= 0; i--)
 	{
 		dev_info(data->port_dev[i], "Remove qsfpdd port-%d\n", data->port_data[i]->port_id);
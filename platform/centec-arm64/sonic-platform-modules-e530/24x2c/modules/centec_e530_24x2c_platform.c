@@ -741,15 +741,19 @@ static int e530_24x2c_exit_led(void)
 #if SEP("drivers:sfp")
 #define MAX_SFP_EEPROM_DATA_LEN 256
 #define MAX_SFP_EEPROM_NUM 3
+#define MAX_SFP_EEPROM_LEN (MAX_SFP_EEPROM_NUM * MAX_SFP_EEPROM_DATA_LEN)
 struct sfp_info_t {
-    char eeprom[MAX_SFP_EEPROM_NUM][MAX_SFP_EEPROM_DATA_LEN+1];
-    unsigned short data_len[MAX_SFP_EEPROM_NUM];
+    /* pages cached by userspace, page n at offset n * MAX_SFP_EEPROM_DATA_LEN */
+    char eeprom[MAX_SFP_EEPROM_LEN];
+    size_t data_len;
     int presence;
     int enable;
     spinlock_t lock;
 };
 static struct class *sfp_class = NULL;
 static struct device *sfp_dev[SFP_NUM+QSFP_NUM+1] = {NULL};
+/* sfp_all: presence bitmap of all the ports, bit (n-1) for sfpn */
+static struct device *sfp_all_dev = NULL;
 static struct sfp_info_t sfp_info[SFP_NUM+QSFP_NUM+1];
 
 static ssize_t e530_24x2c_sfp_read_presence(struct device *dev, struct device_attribute *attr, char *buf)
@@ -780,6 +784,7 @@ static ssize_t e530_24x2c_sfp_write_presence(struct device *dev, struct device_a
     const char *name = dev_name(dev);
     unsigned long flags = 0;
     int presence = simple_strtol(buf, NULL, 10);
+    int changed = 0;
 
     sscanf(name, "sfp%d", &portNum);
 
@@ -790,12 +795,41 @@ static ssize_t e530_24x2c_sfp_write_presence(struct device *dev, struct device_a
     }
 
     spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
+    changed = (sfp_info[portNum].presence != presence);
     sfp_info[portNum].presence = presence;
     spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
-    
+
+    /* wake up the pollers of the port and of sfp_all */
+    if (changed)
+    {
+        sysfs_notify(&dev->kobj, NULL, "sfp_presence");
+        if (IS_VALID_PTR(sfp_all_dev))
+        {
+            sysfs_notify(&sfp_all_dev->kobj, NULL, "sfp_presence");
+        }
+    }
+
     return size;
 }
 
+static ssize_t e530_24x2c_sfp_read_all_presence(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    int portNum = 0;
+    unsigned long flags = 0;
+    unsigned int bitmap = 0;
+
+    for (portNum = 1; portNum <= SFP_NUM+QSFP_NUM; portNum++)
+    {
+        spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
+        if (sfp_info[portNum].presence)
+        {
+            bitmap |= (1U << (portNum - 1));
+        }
+        spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
+    }
+    return sprintf(buf, "0x%08x\n", bitmap);
+}
+
 static ssize_t e530_24x2c_sfp_read_enable(struct device *dev, struct device_attribute *attr, char *buf)
 {
     int ret = 0;
@@ -920,10 +954,11 @@ static ssize_t e530_24x2c_sfp_write_enable(struct device *dev, struct device_att
     return size;
 }
 
-static ssize_t e530_24x2c_sfp_read_eeprom(struct device *dev, struct device_attribute *attr, char *buf)
+static ssize_t e530_24x2c_sfp_read_eeprom(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                                         char *buf, loff_t off, size_t count)
 {
     int portNum = 0;
-    const char *name = dev_name(dev);
+    const char *name = dev_name(container_of(kobj, struct device, kobj));
     unsigned long flags = 0;
     size_t size = 0;
 
@@ -932,22 +967,25 @@ static ssize_t e530_24x2c_sfp_read_eeprom(struct device *dev, struct device_attr
     if ((portNum < 1) || (portNum > SFP_NUM+QSFP_NUM))
     {
         printk(KERN_CRIT "sfp read eeprom, invalid port number!\n");
-        buf[0] = '\0';
-        return 0;
+        return -EINVAL;
     }
 
     spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
-    memcpy(buf, sfp_info[portNum].eeprom[0], sfp_info[portNum].data_len[0]);
-    size = sfp_info[portNum].data_len[0];
+    if (off < sfp_info[portNum].data_len)
+    {
+        size = min(count, (size_t)(sfp_info[portNum].data_len - off));
+        memcpy(buf, sfp_info[portNum].eeprom + off, size);
+    }
     spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
 
     return size;
 }
 
-static ssize_t e530_24x2c_sfp_write_eeprom(struct device *dev, struct device_attribute *attr, const char *buf, size_t size)
+static ssize_t e530_24x2c_sfp_write_eeprom(struct file *filp, struct kobject *kobj, struct bin_attribute *attr,
+                                          char *buf, loff_t off, size_t count)
 {
     int portNum = 0;
-    const char *name = dev_name(dev);
+    const char *name = dev_name(container_of(kobj, struct device, kobj));
     unsigned long flags = 0;
 
     sscanf(name, "sfp%d", &portNum);
@@ -955,20 +993,41 @@ static ssize_t e530_24x2c_sfp_write_eeprom(struct device *dev, struct device_att
     if ((portNum < 1) || (portNum > SFP_NUM+QSFP_NUM))
     {
         printk(KERN_CRIT "sfp write eeprom, invalid port number!\n");
-        return size;
+        return -EINVAL;
+    }
+
+    /* sysfs already limits off + count to the attribute size */
+    if ((off >= MAX_SFP_EEPROM_LEN) || (count > MAX_SFP_EEPROM_LEN - off))
+    {
+        return -EFBIG;
     }
 
     spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
-    memcpy(sfp_info[portNum].eeprom[0], buf, size);
-    sfp_info[portNum].data_len[0] = size;
+    memcpy(sfp_info[portNum].eeprom + off, buf, count);
+    /* a write at offset 0 starts a new cache, later pages extend it */
+    if (0 == off)
+    {
+        sfp_info[portNum].data_len = count;
+    }
+    else if (off + count > sfp_info[portNum].data_len)
+    {
+        sfp_info[portNum].data_len = off + count;
+    }
     spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
-    
-    return size;
+
+    return count;
 }
 
 static DEVICE_ATTR(sfp_presence, S_IRUGO|S_IWUSR, e530_24x2c_sfp_read_presence, e530_24x2c_sfp_write_presence);
 static DEVICE_ATTR(sfp_enable, S_IRUGO|S_IWUSR, e530_24x2c_sfp_read_enable, e530_24x2c_sfp_write_enable);
-static DEVICE_ATTR(sfp_eeprom, S_IRUGO|S_IWUSR, e530_24x2c_sfp_read_eeprom, e530_24x2c_sfp_write_eeprom);
+/* sfp_all/sfp_presence, same name as the per port attribute */
+static struct device_attribute dev_attr_sfp_all_presence = __ATTR(sfp_presence, S_IRUGO, e530_24x2c_sfp_read_all_presence, NULL);
+static struct bin_attribute bin_attr_sfp_eeprom = {
+    .attr = {.name = "sfp_eeprom", .mode = S_IRUGO|S_IWUSR},
+    .size = MAX_SFP_EEPROM_LEN,
+    .read = e530_24x2c_sfp_read_eeprom,
+    .write = e530_24x2c_sfp_write_eeprom,
+};
 
 static int e530_24x2c_init_sfp(void)
 {
@@ -986,7 +1045,7 @@ static int e530_24x2c_init_sfp(void)
     for (i=1; i<=SFP_NUM+QSFP_NUM; i++)
     {
         memset(&(sfp_info[i].eeprom), 0, sizeof(sfp_info[i].eeprom));
-        memset(&(sfp_info[i].data_len), 0, sizeof(sfp_info[i].data_len));
+        sfp_info[i].data_len = 0;
         spin_lock_init(&(sfp_info[i].lock));
 
         sfp_dev[i] = device_create(sfp_class, NULL, MKDEV(223,i), NULL, "sfp%d", i);
@@ -1011,14 +1070,28 @@ static int e530_24x2c_init_sfp(void)
             continue;
         }
 
-        ret = device_create_file(sfp_dev[i], &dev_attr_sfp_eeprom);
+        ret = device_create_bin_file(sfp_dev[i], &bin_attr_sfp_eeprom);
         if (ret != 0)
         {
             printk(KERN_CRIT "create e530_24x2c sfp[%d] device attr:eeprom failed\n", i);
             continue;
         }
     }
-    
+
+    sfp_all_dev = device_create(sfp_class, NULL, MKDEV(223,0), NULL, "sfp_all");
+    if (IS_INVALID_PTR(sfp_all_dev))
+    {
+        sfp_all_dev = NULL;
+        printk(KERN_CRIT "create e530_24x2c sfp_all device failed\n");
+        return ret;
+    }
+
+    ret = device_create_file(sfp_all_dev, &dev_attr_sfp_all_presence);
+    if (ret != 0)
+    {
+        printk(KERN_CRIT "create e530_24x2c sfp_all device attr:presence failed\n");
+    }
+
     return ret;
 }
 
@@ -1032,12 +1105,19 @@ static int e530_24x2c_exit_sfp(void)
         {
             device_remove_file(sfp_dev[i], &dev_attr_sfp_presence);
             device_remove_file(sfp_dev[i], &dev_attr_sfp_enable);
-            device_remove_file(sfp_dev[i], &dev_attr_sfp_eeprom);
+            device_remove_bin_file(sfp_dev[i], &bin_attr_sfp_eeprom);
             device_destroy(sfp_class, MKDEV(223,i));
             sfp_dev[i] = NULL;
         }
     }
 
+    if (IS_VALID_PTR(sfp_all_dev))
+    {
+        device_remove_file(sfp_all_dev, &dev_attr_sfp_all_presence);
+        device_destroy(sfp_class, MKDEV(223,0));
+        sfp_all_dev = NULL;
+    }
+
     if (IS_VALID_PTR(sfp_class))
     {
         class_destroy(sfp_class);
@@ -750,6 +750,8 @@ struct sfp_info_t {
 };
 static struct class *sfp_class = NULL;
 static struct device *sfp_dev[SFP_NUM+QSFP_NUM+1] = {NULL};
+/* sfp_all: presence bitmap of all the ports, bit (n-1) for sfpn */
+static struct device *sfp_all_dev = NULL;
 static struct sfp_info_t sfp_info[SFP_NUM+QSFP_NUM+1];
 
 static ssize_t e530_24x2q_sfp_read_presence(struct device *dev, struct device_attribute *attr, char *buf)
@@ -780,6 +782,7 @@ static ssize_t e530_24x2q_sfp_write_presence(struct device *dev, struct device_a
     const char *name = dev_name(dev);
     unsigned long flags = 0;
     int presence = simple_strtol(buf, NULL, 10);
+    int changed = 0;
 
     sscanf(name, "sfp%d", &portNum);
 
@@ -790,12 +793,41 @@ static ssize_t e530_24x2q_sfp_write_presence(struct device *dev, struct device_a
     }
 
     spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
+    changed = (sfp_info[portNum].presence != presence);
     sfp_info[portNum].presence = presence;
     spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
-    
+
+    /* wake up the pollers of the port and of sfp_all */
+    if (changed)
+    {
+        sysfs_notify(&dev->kobj, NULL, "sfp_presence");
+        if (IS_VALID_PTR(sfp_all_dev))
+        {
+            sysfs_notify(&sfp_all_dev->kobj, NULL, "sfp_presence");
+        }
+    }
+
     return size;
 }
 
+static ssize_t e530_24x2q_sfp_read_all_presence(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    int portNum = 0;
+    unsigned long flags = 0;
+    unsigned int bitmap = 0;
+
+    for (portNum = 1; portNum <= SFP_NUM+QSFP_NUM; portNum++)
+    {
+        spin_lock_irqsave(&(sfp_info[portNum].lock), flags);
+        if (sfp_info[portNum].presence)
+        {
+            bitmap |= (1U << (portNum - 1));
+        }
+        spin_unlock_irqrestore(&(sfp_info[portNum].lock), flags);
+    }
+    return sprintf(buf, "0x%08x\n", bitmap);
+}
+
 static ssize_t e530_24x2q_sfp_read_enable(struct device *dev, struct device_attribute *attr, char *buf)
 {
     int ret = 0;
@@ -969,6 +1001,8 @@ static ssize_t e530_24x2q_sfp_write_eeprom(struct device *dev, struct device_att
 static DEVICE_ATTR(sfp_presence, S_IRUGO|S_IWUSR, e530_24x2q_sfp_read_presence, e530_24x2q_sfp_write_presence);
 static DEVICE_ATTR(sfp_enable, S_IRUGO|S_IWUSR, e530_24x2q_sfp_read_enable, e530_24x2q_sfp_write_enable);
 static DEVICE_ATTR(sfp_eeprom, S_IRUGO|S_IWUSR, e530_24x2q_sfp_read_eeprom, e530_24x2q_sfp_write_eeprom);
+/* sfp_all/sfp_presence, same name as the per port attribute */
+static struct device_attribute dev_attr_sfp_all_presence = __ATTR(sfp_presence, S_IRUGO, e530_24x2q_sfp_read_all_presence, NULL);
 
 static int e530_24x2q_init_sfp(void)
 {
@@ -1018,7 +1052,21 @@ static int e530_24x2q_init_sfp(void)
             continue;
         }
     }
-    
+
+    sfp_all_dev = device_create(sfp_class, NULL, MKDEV(223,0), NULL, "sfp_all");
+    if (IS_INVALID_PTR(sfp_all_dev))
+    {
+        sfp_all_dev = NULL;
+        printk(KERN_CRIT "create e530_24x2q sfp_all device failed\n");
+        return ret;
+    }
+
+    ret = device_create_file(sfp_all_dev, &dev_attr_sfp_all_presence);
+    if (ret != 0)
+    {
+        printk(KERN_CRIT "create e530_24x2q sfp_all device attr:presence failed\n");
+    }
+
     return ret;
 }
 
@@ -1038,6 +1086,13 @@ static int e530_24x2q_exit_sfp(void)
         }
     }
 
+    if (IS_VALID_PTR(sfp_all_dev))
+    {
+        device_remove_file(sfp_all_dev, &dev_attr_sfp_all_presence);
+        device_destroy(sfp_class, MKDEV(223,0));
+        sfp_all_dev = NULL;
+    }
+
     if (IS_VALID_PTR(sfp_class))
     {
         class_destroy(sfp_class);
@@ -19,6 +19,8 @@
 #include <linux/wait.h>
 #include <linux/interrupt.h>
 #include <linux/version.h>
+#include <linux/eventfd.h>
+#include <linux/mm.h>
 #include <linux/dma-mapping.h>
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0))
 #include <linux/irqdomain.h>
@@ -40,6 +42,12 @@ module_param(dma_pool_size, charp, 0);
 MODULE_PARM_DESC(dma_pool_size,
                  "Specify DMA memory pool size (default 4MB)");
 
+/* DMA memory reserved for the kernel packet path */
+static unsigned int knet_dma_size = 0;
+module_param(knet_dma_size, uint, 0);
+MODULE_PARM_DESC(knet_dma_size,
+                 "Specify DMA memory size in MB taken from the tail of the pool for the kernel packet path (default 0, at least 2)");
+
 /*****************************************************************************
  * defines
  *****************************************************************************/
@@ -88,6 +96,8 @@ typedef struct dal_isr_s
     int trigger;
     int count;
     wait_queue_head_t wqh;
+    struct eventfd_ctx* evfd;       /* signaled instead of poll if bound */
+    unsigned int event_cnt;
 } dal_isr_t;
 
 #if defined(SOC_ACTIVE)
@@ -107,6 +117,9 @@ typedef struct dal_kernel_local_dev_s
 
     /* Dma ctl Physical address*/
     uintptr dma_phys_address;
+
+    /* I/O mapped size */
+    unsigned long long mem_size;
 } dal_kern_local_dev_t;
 #endif
 
@@ -120,6 +133,9 @@ typedef struct dal_kernel_pcie_dev_s
 
     /* Physical address */
     unsigned long long phys_address;
+
+    /* I/O mapped size */
+    unsigned long long mem_size;
 } dal_kern_pcie_dev_t;
 
 typedef struct _dma_segment
@@ -136,8 +152,6 @@ typedef struct _dma_segment
     int blk_cnt;                /* Current number of blocks allocated */
 } dma_segment_t;
 
-typedef irqreturn_t (*p_func) (int irq, void* dev_id);
-
 /***************************************************************************
  *declared
  ***************************************************************************/
@@ -167,6 +181,8 @@ static unsigned long long dma_phy_base[DAL_MAX_CHIP_NUM];
 static unsigned int* wb_virt_base[DAL_MAX_CHIP_NUM];
 static unsigned long long wb_phy_base[DAL_MAX_CHIP_NUM];
 static unsigned int dma_mem_size = 0xc00000;
+static unsigned int knet_dma_offset[DAL_MAX_CHIP_NUM];
+static dal_mpool_mem_t* knet_dma_pool[DAL_MAX_CHIP_NUM];
 static unsigned int wb_mem_size =  0x4000000;
 static unsigned int msi_irq_base[DAL_MAX_CHIP_NUM][CTC_MAX_INTR_NUM];
 static unsigned int msi_irq_num[DAL_MAX_CHIP_NUM];
@@ -175,6 +191,7 @@ static unsigned int active_type[DAL_MAX_CHIP_NUM] = {0};
 static struct class *dal_class;
 
 static LIST_HEAD(_dma_seg);
+static DEFINE_SPINLOCK(dal_reg_lock);
 static int dal_debug = 0;
 module_param(dal_debug, int, 0);
 MODULE_PARM_DESC(dal_debug, "Set debug level (default 0)");
@@ -198,8 +215,6 @@ MODULE_DEVICE_TABLE(of, linux_dal_of_match);
 
 static wait_queue_head_t poll_intr[CTC_MAX_INTR_NUM];
 
-p_func intr_handler_fun[CTC_MAX_INTR_NUM];
-
 static int poll_intr_trigger[CTC_MAX_INTR_NUM];
 
 static struct file_operations dal_intr_fops[CTC_MAX_INTR_NUM] =
@@ -249,234 +264,46 @@ static struct file_operations dal_intr_fops[CTC_MAX_INTR_NUM] =
 
 #define _KERNEL_INTERUPT_PROCESS
 static irqreturn_t
-intr0_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-
-    if(poll_intr_trigger[0])
-    {
-        return IRQ_HANDLED;
-    }
-
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
-    {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[0] = 1;
-           wake_up(&poll_intr[0]);
-        }
-
-        if (p_dal_isr->isr_knet)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr_knet(p_dal_isr->isr_knet_data);
-        }
-    }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr1_handler(int irq, void* dev_id)
+intr_handler(int irq, void* dev_id)
 {
     dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
+    int intr_idx = p_dal_isr - dal_isr;
 
-    if(poll_intr_trigger[1])
+    if(poll_intr_trigger[intr_idx])
     {
         return IRQ_HANDLED;
     }
 
     disable_irq_nosync(irq);
 
-    if (p_dal_isr)
+    if (p_dal_isr->isr)
     {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[1] = 1;
-           wake_up(&poll_intr[1]);
-        }
+        /* kernel mode interrupt handler */
+        p_dal_isr->isr(p_dal_isr->isr_data);
     }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr2_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[2])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
+    else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
     {
-        if (p_dal_isr->isr)
+        /* user mode interrupt handler, re-enabled by CMD_EN_INTERRUPTS or CMD_ACK_INTERRUPTS */
+        p_dal_isr->event_cnt++;
+        if (p_dal_isr->evfd)
         {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[2] = 1;
-           wake_up(&poll_intr[2]);
-        }
-    }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr3_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[3])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
-    {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[3] = 1;
-           wake_up(&poll_intr[3]);
-        }
-    }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr4_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[4])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
-    {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[4] = 1;
-           wake_up(&poll_intr[4]);
-        }
-    }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr5_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[5])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
-    {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[5] = 1;
-           wake_up(&poll_intr[5]);
-        }
-    }
-
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr6_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[6])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
-    {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
+#if (LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0))
+            eventfd_signal(p_dal_isr->evfd);
+#else
+            eventfd_signal(p_dal_isr->evfd, 1);
+#endif
         }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
+        else
         {
-            /* user mode interrupt handler */
-           poll_intr_trigger[6] = 1;
-           wake_up(&poll_intr[6]);
+            poll_intr_trigger[intr_idx] = 1;
+            wake_up(&poll_intr[intr_idx]);
         }
     }
 
-    return IRQ_HANDLED;
-}
-
-static irqreturn_t
-intr7_handler(int irq, void* dev_id)
-{
-    dal_isr_t* p_dal_isr = (dal_isr_t*)dev_id;
-    if(poll_intr_trigger[7])
-    {
-        return IRQ_HANDLED;
-    }
-    disable_irq_nosync(irq);
-
-    if (p_dal_isr)
+    if (p_dal_isr->isr_knet)
     {
-        if (p_dal_isr->isr)
-        {
-            /* kernel mode interrupt handler */
-            p_dal_isr->isr(p_dal_isr->isr_data);
-        }
-        else if ((NULL == p_dal_isr->isr) && (NULL == p_dal_isr->isr_data))
-        {
-            /* user mode interrupt handler */
-           poll_intr_trigger[7] = 1;
-           wake_up(&poll_intr[7]);
-        }
+        /* kernel mode interrupt handler */
+        p_dal_isr->isr_knet(p_dal_isr->isr_knet_data);
     }
 
     return IRQ_HANDLED;
@@ -529,6 +356,7 @@ dal_interrupt_register(unsigned int irq, int prio, void (* isr)(void*), void* da
     dal_isr[intr_num].isr = isr;
     dal_isr[intr_num].isr_data = data;
     dal_isr[intr_num].count++;
+    dal_isr[intr_num].event_cnt = 0;
 
     init_waitqueue_head(&poll_intr[intr_num]);
 
@@ -550,7 +378,7 @@ dal_interrupt_register(unsigned int irq, int prio, void (* isr)(void*), void* da
     irq_flags = IRQF_DISABLED;
 #endif
     if ((ret = request_irq(irq,
-                           intr_handler_fun[intr_num],
+                           intr_handler,
                            irq_flags,
                            int_name,
                            &dal_isr[intr_num])) < 0)
@@ -602,6 +430,11 @@ dal_interrupt_unregister(unsigned int irq)
 
     free_irq(irq, &dal_isr[intr_idx]);
 
+    if (dal_isr[intr_idx].evfd)
+    {
+        eventfd_ctx_put(dal_isr[intr_idx].evfd);
+        dal_isr[intr_idx].evfd = NULL;
+    }
     dal_isr[intr_idx].irq = 0;
 
     dal_intr_num--;
@@ -647,10 +480,56 @@ dal_interrupt_disconnect(unsigned int irq)
     return -1;
 }
 
+int
+dal_interrupt_set_en(unsigned int irq, unsigned int enable)
+{
+    enable ? enable_irq(irq) : disable_irq_nosync(irq);
+    return 0;
+}
+
+void*
+dal_knet_dma_alloc(unsigned int lchip, int size)
+{
+    if ((lchip >= DAL_MAX_CHIP_NUM) || (NULL == knet_dma_pool[lchip]))
+    {
+        return NULL;
+    }
+
+    return dal_mpool_alloc(lchip, knet_dma_pool[lchip], size, DAL_MPOOL_TYPE_USELESS);
+}
+
+void
+dal_knet_dma_free(unsigned int lchip, void* ptr)
+{
+    if ((lchip >= DAL_MAX_CHIP_NUM) || (NULL == knet_dma_pool[lchip]))
+    {
+        return;
+    }
+
+    dal_mpool_free(lchip, knet_dma_pool[lchip], ptr);
+}
+
+unsigned long long
+dal_knet_dma_virt_to_phy(unsigned int lchip, void* ptr)
+{
+    return dma_phy_base[lchip] + ((char*)ptr - (char*)dma_virt_base[lchip]);
+}
+
+void*
+dal_knet_dma_phy_to_virt(unsigned int lchip, unsigned long long phy)
+{
+    return (char*)dma_virt_base[lchip] + (phy - dma_phy_base[lchip]);
+}
+
 static dal_ops_t g_dal_ops =
 {
     interrupt_connect:dal_interrupt_connect,
     interrupt_disconnect:dal_interrupt_disconnect,
+    interrupt_set_en:dal_interrupt_set_en,
+    dma_alloc:dal_knet_dma_alloc,
+    dma_free:dal_knet_dma_free,
+    dma_virt_to_phy:dal_knet_dma_virt_to_phy,
+    dma_phy_to_virt:dal_knet_dma_phy_to_virt,
 };
 
 int
@@ -661,13 +540,6 @@ dal_get_dal_ops(dal_ops_t **dal_ops)
     return 0;
 }
 
-int
-dal_interrupt_set_en(unsigned int irq, unsigned int enable)
-{
-    enable ? enable_irq(irq) : disable_irq_nosync(irq);
-    return 0;
-}
-
 static int
 _dal_set_msi_enabe(unsigned int lchip, unsigned int irq_num, unsigned int msi_type)
 {
@@ -872,6 +744,132 @@ dal_user_interrupt_set_en(unsigned long arg)
     return dal_interrupt_set_en(dal_intr_parm.irq, dal_intr_parm.enable);
 }
 
+static int
+_dal_get_intr_idx(unsigned int irq)
+{
+    int intr_idx = 0;
+
+    for (intr_idx = 0; intr_idx < CTC_MAX_INTR_NUM; intr_idx++)
+    {
+        if ((0 != irq) && (dal_isr[intr_idx].irq == irq))
+        {
+            return intr_idx;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Bind an eventfd to a user mode interrupt, the eventfd is signaled instead of
+ * waking up /dev/dal_intrN, so that all interrupts can be waited by one epoll.
+ * fd < 0 unbinds the eventfd and falls back to poll.
+ */
+int
+dal_user_interrupt_set_eventfd(unsigned long arg)
+{
+    dal_intr_eventfd_t intr_eventfd;
+    struct eventfd_ctx* evfd = NULL;
+    struct eventfd_ctx* old_evfd = NULL;
+    int intr_idx = 0;
+
+    if (copy_from_user(&intr_eventfd, (void*)arg, sizeof(dal_intr_eventfd_t)))
+    {
+        return -EFAULT;
+    }
+
+    intr_idx = _dal_get_intr_idx(intr_eventfd.irq);
+    if (intr_idx < 0)
+    {
+        printk("irq%d is not registered! set eventfd failed\n", intr_eventfd.irq);
+        return -EINVAL;
+    }
+
+    if (intr_eventfd.fd >= 0)
+    {
+        evfd = eventfd_ctx_fdget(intr_eventfd.fd);
+        if (IS_ERR(evfd))
+        {
+            return PTR_ERR(evfd);
+        }
+    }
+
+    /* wait for the running handler, the depth of disable_irq is balanced */
+    disable_irq(intr_eventfd.irq);
+    old_evfd = dal_isr[intr_idx].evfd;
+    dal_isr[intr_idx].evfd = evfd;
+    enable_irq(intr_eventfd.irq);
+
+    if (old_evfd)
+    {
+        eventfd_ctx_put(old_evfd);
+    }
+
+    return 0;
+}
+
+/*
+ * Re-enable a batch of user mode interrupts after they are handled, one ioctl
+ * instead of one CMD_EN_INTERRUPTS per interrupt.
+ */
+int
+dal_user_interrupt_ack(unsigned long arg)
+{
+    dal_intr_ack_t intr_ack;
+    unsigned int index = 0;
+
+    if (copy_from_user(&intr_ack, (void*)arg, sizeof(dal_intr_ack_t)))
+    {
+        return -EFAULT;
+    }
+
+    if (intr_ack.irq_num > CTC_MAX_INTR_NUM)
+    {
+        return -EINVAL;
+    }
+
+    for (index = 0; index < intr_ack.irq_num; index++)
+    {
+        if (_dal_get_intr_idx(intr_ack.irq[index]) < 0)
+        {
+            return -EINVAL;
+        }
+    }
+
+    for (index = 0; index < intr_ack.irq_num; index++)
+    {
+        dal_interrupt_set_en(intr_ack.irq[index], 1);
+    }
+
+    return 0;
+}
+
+int
+dal_user_interrupt_get_count(unsigned long arg)
+{
+    dal_intr_count_t intr_count;
+    int intr_idx = 0;
+
+    if (copy_from_user(&intr_count, (void*)arg, sizeof(dal_intr_count_t)))
+    {
+        return -EFAULT;
+    }
+
+    intr_idx = _dal_get_intr_idx(intr_count.irq);
+    if (intr_idx < 0)
+    {
+        return -EINVAL;
+    }
+    intr_count.count = dal_isr[intr_idx].event_cnt;
+
+    if (copy_to_user((dal_intr_count_t*)arg, (void*)&intr_count, sizeof(dal_intr_count_t)))
+    {
+        return -EFAULT;
+    }
+
+    return 0;
+}
+
 /*
  * Function: _dal_dma_segment_free
  */
@@ -1188,6 +1186,57 @@ _dal_pgfree(void* ptr)
     return -1;
 }
 
+/*
+ * Function: _dal_knet_dma_init
+ *
+ * Purpose:
+ *    Reserve the tail of the DMA pool for the kernel packet path.
+ * Notes:
+ *    The SDK gets the reserved part by knet_tx_offset/knet_tx_size of
+ *    CMD_GET_DMA_INFO and must not allocate from it. The kernel is the only
+ *    user of the kernel copy of dal_mpool.
+ */
+static void
+_dal_knet_dma_init(int lchip)
+{
+    unsigned int size = knet_dma_size * MB_SIZE;
+
+    knet_dma_offset[lchip] = dma_mem_size;
+    if ((0 == knet_dma_size) || (NULL == dma_virt_base[lchip]))
+    {
+        return;
+    }
+
+    if ((knet_dma_size < 2) || (size >= dma_mem_size))
+    {
+        printk("knet_dma_size %uMB is invalid, dma_mem_size 0x%x\n", knet_dma_size, dma_mem_size);
+        return;
+    }
+
+    dal_mpool_init(lchip);
+    knet_dma_pool[lchip] = dal_mpool_create(lchip, (char*)dma_virt_base[lchip] + (dma_mem_size - size), size);
+    if (NULL == knet_dma_pool[lchip])
+    {
+        printk("Create knet dma pool failed!\n");
+        return;
+    }
+    knet_dma_offset[lchip] = dma_mem_size - size;
+
+    printk("knet dma offset 0x%x size 0x%x\n", knet_dma_offset[lchip], size);
+}
+
+static void
+_dal_knet_dma_deinit(int lchip)
+{
+    if (knet_dma_pool[lchip])
+    {
+        dal_mpool_destroy(lchip, knet_dma_pool[lchip]);
+        dal_mpool_deinit(lchip);
+        knet_dma_pool[lchip] = NULL;
+    }
+    knet_dma_offset[lchip] = dma_mem_size;
+}
+
 static void
 dal_alloc_dma_pool(int lchip, int size)
 {
@@ -1230,6 +1279,8 @@ dal_alloc_dma_pool(int lchip, int size)
     //dma_virt_base [lchip]= ioremap_nocache(dma_phy_base[lchip], size);
 #endif
     }
+
+    _dal_knet_dma_init(lchip);
 }
 
 static void
@@ -1241,6 +1292,7 @@ dal_free_dma_pool(int lchip)
 #endif
 
     ret = ret;
+    _dal_knet_dma_deinit(lchip);
     if (use_high_memory)
     {
         iounmap(dma_virt_base[lchip]);
@@ -1404,6 +1456,131 @@ dal_pci_write(unsigned long arg)
     return 0;
 }
 
+static int
+_dal_get_mem_info(unsigned char lchip, unsigned long long* phys_address, unsigned long long* mem_size)
+{
+    if (!VERIFY_CHIP_INDEX(lchip))
+    {
+        return -1;
+    }
+
+    if (DAL_CPU_MODE_TYPE_PCIE == active_type[lchip])
+    {
+        *phys_address = ((dal_kern_pcie_dev_t*)(dal_dev[lchip]))->phys_address;
+        *mem_size = ((dal_kern_pcie_dev_t*)(dal_dev[lchip]))->mem_size;
+        return 0;
+    }
+#if defined(SOC_ACTIVE)
+    if (DAL_CPU_MODE_TYPE_LOCAL == active_type[lchip])
+    {
+        *phys_address = ((dal_kern_local_dev_t*)(dal_dev[lchip]))->phys_address;
+        *mem_size = ((dal_kern_local_dev_t*)(dal_dev[lchip]))->mem_size;
+        return 0;
+    }
+#endif
+
+    return -1;
+}
+
+static int
+_dal_reg_op(unsigned char lchip, dal_reg_op_t* p_op)
+{
+    unsigned int value = 0;
+    unsigned long flags;
+
+    switch (p_op->op)
+    {
+    case DAL_REG_OP_READ:
+        return _dal_pci_read(lchip, p_op->reg_addr, &p_op->value);
+
+    case DAL_REG_OP_WRITE:
+        return _dal_pci_write(lchip, p_op->reg_addr, p_op->value);
+
+    case DAL_REG_OP_RMW:
+        /* serialize the read-modify-write of all users */
+        spin_lock_irqsave(&dal_reg_lock, flags);
+        if (_dal_pci_read(lchip, p_op->reg_addr, &value))
+        {
+            spin_unlock_irqrestore(&dal_reg_lock, flags);
+            return -1;
+        }
+        _dal_pci_write(lchip, p_op->reg_addr, (value & ~p_op->mask) | (p_op->value & p_op->mask));
+        spin_unlock_irqrestore(&dal_reg_lock, flags);
+        p_op->value = value;
+        return 0;
+
+    default:
+        return -1;
+    }
+}
+
+/*
+ * Function: dal_pci_batch
+ *
+ * Purpose:
+ *    Do a vector of register read/write/read-modify-write in one ioctl.
+ * Notes:
+ *    The ops are done in order and stop at the first failed one, op_done
+ *    returns the number of the ops done.
+ */
+int
+dal_pci_batch(unsigned long arg)
+{
+    dal_reg_batch_t batch;
+    dal_reg_op_t ops[DAL_REG_BATCH_CHUNK];
+    dal_reg_op_t __user* p_user_op = NULL;
+    unsigned long long phys_address = 0;
+    unsigned long long mem_size = 0;
+    unsigned int num = 0;
+    unsigned int index = 0;
+    int ret = 0;
+
+    if (copy_from_user(&batch, (void*)arg, sizeof(dal_reg_batch_t)))
+    {
+        return -EFAULT;
+    }
+
+    if ((batch.op_num > DAL_REG_BATCH_MAX) ||
+        _dal_get_mem_info((unsigned char)batch.lchip, &phys_address, &mem_size))
+    {
+        return -EINVAL;
+    }
+
+    p_user_op = (dal_reg_op_t __user*)(uintptr_t)batch.op_addr;
+    for (batch.op_done = 0; (0 == ret) && (batch.op_done < batch.op_num); batch.op_done += num)
+    {
+        num = batch.op_num - batch.op_done;
+        num = (num > DAL_REG_BATCH_CHUNK) ? DAL_REG_BATCH_CHUNK : num;
+        if (copy_from_user(ops, p_user_op + batch.op_done, num * sizeof(dal_reg_op_t)))
+        {
+            return -EFAULT;
+        }
+
+        for (index = 0; index < num; index++)
+        {
+            if (((unsigned long long)ops[index].reg_addr + sizeof(unsigned int) > mem_size) ||
+                _dal_reg_op((unsigned char)batch.lchip, &ops[index]))
+            {
+                ret = -EINVAL;
+                break;
+            }
+        }
+
+        if (copy_to_user(p_user_op + batch.op_done, ops, index * sizeof(dal_reg_op_t)))
+        {
+            return -EFAULT;
+        }
+        num = index;
+    }
+
+    if (copy_to_user((dal_reg_batch_t*)arg, (void*)&batch, sizeof(dal_reg_batch_t)))
+    {
+        return -EFAULT;
+    }
+
+    return ret;
+}
+
 int
 dal_pci_conf_read(unsigned char lchip, unsigned int offset, unsigned int* value)
 {
@@ -1550,6 +1727,8 @@ linux_get_dma_info(unsigned long arg)
     dma_para.phy_base_hi = dma_phy_base[dma_para.lchip] >> 32;
     dma_para.virt_base = dma_virt_base[dma_para.lchip];
     dma_para.size = dma_mem_size;
+    dma_para.knet_tx_offset = knet_dma_offset[dma_para.lchip];
+    dma_para.knet_tx_size = dma_mem_size - knet_dma_offset[dma_para.lchip];
 
     printk("dal dma phy addr: 0x%llx, virt addr: %p.\n", dma_phy_base[dma_para.lchip], dma_virt_base[dma_para.lchip]);
 
@@ -1729,6 +1908,52 @@ dal_user_cache_flush(unsigned long arg)
     return 0;
 }
 
+/*
+ * Invalidate or flush a list of ranges, e.g. all descriptors and buffers
+ * handled in one round, in one ioctl.
+ */
+static int
+dal_user_cache_list(unsigned long arg, int flush)
+{
+#ifndef DMA_MEM_MODE_PLATFORM
+    dal_dma_cache_list_t cache_list;
+    dal_dma_cache_info_t info[DAL_DMA_CACHE_LIST_CHUNK];
+    dal_dma_cache_info_t __user* p_user_info = NULL;
+    unsigned int done = 0;
+    unsigned int num = 0;
+    unsigned int index = 0;
+
+    if (copy_from_user(&cache_list, (void*)arg, sizeof(dal_dma_cache_list_t)))
+    {
+        return -EFAULT;
+    }
+
+    if (cache_list.num > DAL_DMA_CACHE_LIST_MAX)
+    {
+        return -EINVAL;
+    }
+
+    p_user_info = (dal_dma_cache_info_t __user*)(uintptr_t)cache_list.info_addr;
+    for (done = 0; done < cache_list.num; done += num)
+    {
+        num = cache_list.num - done;
+        num = (num > DAL_DMA_CACHE_LIST_CHUNK) ? DAL_DMA_CACHE_LIST_CHUNK : num;
+        if (copy_from_user(info, p_user_info + done, num * sizeof(dal_dma_cache_info_t)))
+        {
+            return -EFAULT;
+        }
+
+        for (index = 0; index < num; index++)
+        {
+            flush ? dal_cache_flush(info[index].ptr, info[index].length)
+                  : dal_cache_inval(info[index].ptr, info[index].length);
+        }
+    }
+#endif
+    /* the DMA memory of DMA_MEM_MODE_PLATFORM is coherent */
+    return 0;
+}
+
 int
 dal_dma_direct_read(unsigned char lchip, unsigned int offset, unsigned int* value)
 {
@@ -1823,6 +2048,7 @@ static int linux_dal_local_probe(struct platform_device *pdev)
 
     res = platform_get_resource(pdev, IORESOURCE_MEM, 0);
     dev->phys_address = res->start;
+    dev->mem_size = resource_size(res);
     dev->logic_address = devm_ioremap_resource(&pdev->dev, res);
     if (IS_ERR(dev->logic_address))
     {
@@ -1963,6 +2189,7 @@ int linux_dal_pcie_probe(struct pci_dev* pdev, const struct pci_device_id* id)
     }
 
     dev->phys_address = pci_resource_start(pdev, bar);
+    dev->mem_size = pci_resource_len(dev->pci_dev, bar);
     dev->logic_address = (uintptr)ioremap_nocache(dev->phys_address,
                                                 pci_resource_len(dev->pci_dev, bar));
 
@@ -2116,6 +2343,15 @@ linux_dal_ioctl(struct inode* inode, struct file* file,
     case CMD_EN_INTERRUPTS:
         return dal_user_interrupt_set_en(arg);
 
+    case CMD_SET_INTR_EVENTFD:
+        return dal_user_interrupt_set_eventfd(arg);
+
+    case CMD_ACK_INTERRUPTS:
+        return dal_user_interrupt_ack(arg);
+
+    case CMD_GET_INTR_COUNT:
+        return dal_user_interrupt_get_count(arg);
+
     case CMD_SET_MSI_CAP:
         return dal_set_msi_cap(arg);
 
@@ -2136,6 +2372,15 @@ linux_dal_ioctl(struct inode* inode, struct file* file,
 
     case CMD_GET_WB_INFO:
         return linux_get_wb_info(arg);
+
+    case CMD_REG_BATCH:
+        return dal_pci_batch(arg);
+
+    case CMD_CACHE_INVAL_LIST:
+        return dal_user_cache_list(arg, 0);
+
+    case CMD_CACHE_FLUSH_LIST:
+        return dal_user_cache_list(arg, 1);
     default:
         break;
     }
@@ -2143,6 +2388,31 @@ linux_dal_ioctl(struct inode* inode, struct file* file,
     return 0;
 }
 
+/*
+ * Map the register space of the chip, DAL_MMAP_REG_OFFSET(lchip) selects the chip.
+ */
+static int
+linux_dal_mmap(struct file* filp, struct vm_area_struct* vma)
+{
+    unsigned long long offset = (unsigned long long)vma->vm_pgoff << PAGE_SHIFT;
+    unsigned long size = vma->vm_end - vma->vm_start;
+    unsigned long long phys_address = 0;
+    unsigned long long mem_size = 0;
+    unsigned char lchip = offset / DAL_MMAP_REG_OFFSET(1);
+
+    offset %= DAL_MMAP_REG_OFFSET(1);
+    if (_dal_get_mem_info(lchip, &phys_address, &mem_size) ||
+        (offset + size > PAGE_ALIGN(mem_size)))
+    {
+        return -EINVAL;
+    }
+
+    vma->vm_page_prot = pgprot_noncached(vma->vm_page_prot);
+
+    return io_remap_pfn_range(vma, vma->vm_start, (phys_address + offset) >> PAGE_SHIFT,
+                              size, vma->vm_page_prot);
+}
+
 static unsigned int
 linux_dal_poll0(struct file* filp, struct poll_table_struct* p)
 {
@@ -2327,6 +2597,7 @@ static struct file_operations fops =
     .ioctl = linux_dal_ioctl,
 #endif
 #endif
+    .mmap = linux_dal_mmap,
 };
 
 static int __init
@@ -2381,16 +2652,6 @@ linux_dal_init(void)
     dal_class = class_create(THIS_MODULE, DAL_NAME);
     device_create(dal_class, NULL, MKDEV(DAL_DEV_MAJOR, 0), NULL, DAL_NAME);
 
-    /* init interrupt function */
-    intr_handler_fun[0] = intr0_handler;
-    intr_handler_fun[1] = intr1_handler;
-    intr_handler_fun[2] = intr2_handler;
-    intr_handler_fun[3] = intr3_handler;
-    intr_handler_fun[4] = intr4_handler;
-    intr_handler_fun[5] = intr5_handler;
-    intr_handler_fun[6] = intr6_handler;
-    intr_handler_fun[7] = intr7_handler;
-
     return ret;
 }
 
@@ -76,6 +76,61 @@ struct dal_intr_parm_s
 };
 typedef struct dal_intr_parm_s dal_intr_parm_t;
 
+struct dal_intr_eventfd_s
+{
+    unsigned int irq;
+    int fd;                 /* eventfd, -1 to unbind */
+};
+typedef struct dal_intr_eventfd_s dal_intr_eventfd_t;
+
+struct dal_intr_ack_s
+{
+    unsigned int irq_num;
+    unsigned int irq[CTC_MAX_INTR_NUM];
+};
+typedef struct dal_intr_ack_s dal_intr_ack_t;
+
+struct dal_intr_count_s
+{
+    unsigned int irq;
+    unsigned int count;     /* output: number of user mode interrupts */
+};
+typedef struct dal_intr_count_s dal_intr_count_t;
+
+enum dal_reg_op_type_e
+{
+    DAL_REG_OP_READ,
+    DAL_REG_OP_WRITE,
+    DAL_REG_OP_RMW,         /* value = (old & ~mask) | (value & mask), returns old */
+    DAL_REG_OP_MAX
+};
+typedef enum dal_reg_op_type_e dal_reg_op_type_t;
+
+struct dal_reg_op_s
+{
+    unsigned int op;        /* dal_reg_op_type_t */
+    unsigned int reg_addr;
+    unsigned int value;
+    unsigned int mask;
+};
+typedef struct dal_reg_op_s dal_reg_op_t;
+
+#define DAL_REG_BATCH_MAX   4096
+#define DAL_REG_BATCH_CHUNK 32
+
+struct dal_reg_batch_s
+{
+    unsigned int lchip;
+    unsigned int op_num;
+    unsigned int op_done;           /* output: number of ops done */
+    unsigned int rsv;
+    unsigned long long op_addr;     /* user address of dal_reg_op_t[op_num] */
+};
+typedef struct dal_reg_batch_s dal_reg_batch_t;
+
+/* mmap offset of the register space of the chip on DAL_DEV_NAME */
+#define DAL_MMAP_REG_OFFSET(lchip) ((unsigned long long)(lchip) << 28)
+
 struct dal_irq_mapping_s
 {
     unsigned int hw_irq;
@@ -138,6 +193,17 @@ struct dal_dma_cache_info_s
 };
 typedef struct dal_dma_cache_info_s dal_dma_cache_info_t;
 
+#define DAL_DMA_CACHE_LIST_MAX   4096
+#define DAL_DMA_CACHE_LIST_CHUNK 64
+
+struct dal_dma_cache_list_s
+{
+    unsigned int num;
+    unsigned int rsv;
+    unsigned long long info_addr;   /* user address of dal_dma_cache_info_t[num] */
+};
+typedef struct dal_dma_cache_list_s dal_dma_cache_list_t;
+
 #define CMD_MAGIC 'C'
 #define CMD_WRITE_CHIP              _IO(CMD_MAGIC, 0) /* for humber ioctrol*/
 #define CMD_READ_CHIP               _IO(CMD_MAGIC, 1) /* for humber ioctrol*/
@@ -164,6 +230,12 @@ typedef struct dal_dma_cache_info_s dal_dma_cache_info_t;
 #define CMD_REG_DMA_CHAN             _IO(CMD_MAGIC, 22)
 #define CMD_HANDLE_NETIF             _IO(CMD_MAGIC, 23)
 #define CMD_GET_WB_INFO              _IO(CMD_MAGIC, 24)
+#define CMD_SET_INTR_EVENTFD         _IO(CMD_MAGIC, 25)
+#define CMD_ACK_INTERRUPTS           _IO(CMD_MAGIC, 26)
+#define CMD_GET_INTR_COUNT           _IO(CMD_MAGIC, 27)
+#define CMD_REG_BATCH                _IO(CMD_MAGIC, 28)
+#define CMD_CACHE_INVAL_LIST         _IO(CMD_MAGIC, 29)
+#define CMD_CACHE_FLUSH_LIST         _IO(CMD_MAGIC, 30)
 
 enum dal_version_e
 {
@@ -178,9 +250,16 @@ enum dal_version_e
 };
 typedef enum dal_version_e dal_version_t;
 
+/* services for the kernel packet path, the isr connected is called in hard irq
+   context after the irq is disabled, and re-enables it by interrupt_set_en */
 struct dal_ops_s {
     int     (*interrupt_connect)(unsigned int irq, int prio, void (*)(void*), void *data);
     int     (*interrupt_disconnect)(unsigned int irq);
+    int     (*interrupt_set_en)(unsigned int irq, unsigned int enable);
+    void*   (*dma_alloc)(unsigned int lchip, int size);   /* from the knet_dma_size part */
+    void    (*dma_free)(unsigned int lchip, void* ptr);
+    unsigned long long (*dma_virt_to_phy)(unsigned int lchip, void* ptr);
+    void*   (*dma_phy_to_virt)(unsigned int lchip, unsigned long long phy);
 };
 typedef struct dal_ops_s dal_ops_t;
 
@@ -8,6 +8,7 @@
 #ifdef __KERNEL__
 #include <linux/spinlock.h>
 #include <linux/slab.h>
+#include <linux/string.h>
 
 #define DAL_MALLOC(x) kmalloc(x, GFP_ATOMIC)
 #define DAL_FREE(x) kfree(x)
@@ -21,6 +22,7 @@ static spinlock_t dal_mpool_lock[DAL_MAX_CHIP_NUM];
 #else /* !__KERNEL__*/
 
 #include <stdlib.h>
+#include <string.h>
 #include "sal.h"
 #define DAL_MALLOC(x) sal_malloc(x)
 #define DAL_FREE(x) sal_free(x)
@@ -39,9 +41,241 @@ dal_mpool_mem_t* g_free_block_ptr = NULL;
 #define DAL_CACHE_LINE_BYTES 256
 #endif
 
+/*
+ * Each pool is managed by size classes, the sizes are counted in cache lines.
+ * Class 0-3 are 1-4 lines, then each power of two is split into 4 classes,
+ * so that a block is at most 25% larger than the request, e.g.
+ * class 4-7: 5-8 lines, class 8-11: 10, 12, 14, 16 lines.
+ * A free block is kept in the largest class not larger than it, the
+ * allocation takes the first non-empty class not smaller than the request,
+ * and splits the rest back. The blocks are found by address in the hash, and
+ * a freed block is merged with its free neighbours.
+ */
+#define DAL_MPOOL_CLASS_NUM    96
+#define DAL_MPOOL_BMP_NUM      ((DAL_MPOOL_CLASS_NUM + 31) / 32)
+#define DAL_MPOOL_HASH_NUM     256
+#define DAL_MPOOL_HASH(addr)   ((((unsigned long)(addr)) / DAL_CACHE_LINE_BYTES) % DAL_MPOOL_HASH_NUM)
+
+struct dal_mpool_ctl_s
+{
+    dal_mpool_mem_t mem;                /* must be the first, the pool returned */
+    unsigned char* brk;                 /* begin of the part never allocated */
+    int used;
+    unsigned int class_bmp[DAL_MPOOL_BMP_NUM];
+    dal_mpool_mem_t* free_list[DAL_MPOOL_CLASS_NUM];
+    dal_mpool_mem_t* addr_hash[DAL_MPOOL_HASH_NUM];     /* used and free blocks by address */
+    dal_mpool_mem_t* end_hash[DAL_MPOOL_HASH_NUM];      /* free blocks by end address */
+};
+typedef struct dal_mpool_ctl_s dal_mpool_ctl_t;
+
 static dal_mpool_mem_t* p_desc_pool[DAL_MAX_CHIP_NUM] = {0};
 static dal_mpool_mem_t* p_data_pool[DAL_MAX_CHIP_NUM] = {0};
 
+static int
+_dal_mpool_fls(unsigned int value)
+{
+    int bit = 0;
+
+    while (value)
+    {
+        bit++;
+        value >>= 1;
+    }
+
+    return bit;
+}
+
+/* size in cache lines of the class */
+static int
+_dal_mpool_class_size(int class_id)
+{
+    int exp = class_id / 4 + 1;
+
+    if (class_id < 4)
+    {
+        return class_id + 1;
+    }
+
+    return (5 + class_id % 4) << (exp - 2);
+}
+
+/* the largest class not larger than lines */
+static int
+_dal_mpool_floor_class(int lines)
+{
+    int exp = 0;
+    int msb = 0;
+
+    if (lines <= 4)
+    {
+        return lines - 1;
+    }
+
+    exp = _dal_mpool_fls(lines) - 1;
+    msb = lines >> (exp - 2);
+    if (4 == msb)
+    {
+        return 4 * (exp - 2) + 3;
+    }
+
+    return 4 * (exp - 1) + msb - 5;
+}
+
+/* the smallest class not smaller than lines */
+static int
+_dal_mpool_ceil_class(int lines)
+{
+    int class_id = _dal_mpool_floor_class(lines);
+
+    if (_dal_mpool_class_size(class_id) < lines)
+    {
+        class_id++;
+    }
+
+    return class_id;
+}
+
+static void
+_dal_mpool_hash_insert(dal_mpool_mem_t** hash, int key, dal_mpool_mem_t* node)
+{
+    node->hash_next = hash[key];
+    hash[key] = node;
+}
+
+static dal_mpool_mem_t*
+_dal_mpool_addr_lookup(dal_mpool_ctl_t* ctl, unsigned char* address)
+{
+    dal_mpool_mem_t* node = ctl->addr_hash[DAL_MPOOL_HASH(address)];
+
+    while (node && (node->address != address))
+    {
+        node = node->hash_next;
+    }
+
+    return node;
+}
+
+static void
+_dal_mpool_addr_remove(dal_mpool_ctl_t* ctl, dal_mpool_mem_t* node)
+{
+    dal_mpool_mem_t** pp_node = &ctl->addr_hash[DAL_MPOOL_HASH(node->address)];
+
+    while (*pp_node != node)
+    {
+        pp_node = &(*pp_node)->hash_next;
+    }
+    *pp_node = node->hash_next;
+}
+
+static dal_mpool_mem_t*
+_dal_mpool_end_lookup(dal_mpool_ctl_t* ctl, unsigned char* end)
+{
+    dal_mpool_mem_t* node = ctl->end_hash[DAL_MPOOL_HASH(end)];
+
+    while (node && ((node->address + node->size) != end))
+    {
+        node = node->end_hash_next;
+    }
+
+    return node;
+}
+
+/* insert a free block to its class and the end hash */
+static void
+_dal_mpool_free_insert(dal_mpool_ctl_t* ctl, dal_mpool_mem_t* node)
+{
+    int class_id = _dal_mpool_floor_class(node->size / DAL_CACHE_LINE_BYTES);
+    int key = DAL_MPOOL_HASH(node->address + node->size);
+
+    node->type = -1;
+    node->prev = NULL;
+    node->next = ctl->free_list[class_id];
+    if (node->next)
+    {
+        node->next->prev = node;
+    }
+    ctl->free_list[class_id] = node;
+    ctl->class_bmp[class_id / 32] |= (1U << (class_id % 32));
+
+    node->end_hash_next = ctl->end_hash[key];
+    ctl->end_hash[key] = node;
+}
+
+static void
+_dal_mpool_free_remove(dal_mpool_ctl_t* ctl, dal_mpool_mem_t* node)
+{
+    int class_id = _dal_mpool_floor_class(node->size / DAL_CACHE_LINE_BYTES);
+    dal_mpool_mem_t** pp_node = &ctl->end_hash[DAL_MPOOL_HASH(node->address + node->size)];
+
+    if (node->prev)
+    {
+        node->prev->next = node->next;
+    }
+    else
+    {
+        ctl->free_list[class_id] = node->next;
+        if (NULL == node->next)
+        {
+            ctl->class_bmp[class_id / 32] &= ~(1U << (class_id % 32));
+        }
+    }
+    if (node->next)
+    {
+        node->next->prev = node->prev;
+    }
+
+    while (*pp_node != node)
+    {
+        pp_node = &(*pp_node)->end_hash_next;
+    }
+    *pp_node = node->end_hash_next;
+}
+
+/* the first non-empty class from class_id, or -1 */
+static int
+_dal_mpool_find_class(dal_mpool_ctl_t* ctl, int class_id)
+{
+    unsigned int bmp = 0;
+    int index = class_id / 32;
+
+    if (class_id >= DAL_MPOOL_CLASS_NUM)
+    {
+        return -1;
+    }
+
+    bmp = ctl->class_bmp[index] & ~((1U << (class_id % 32)) - 1);
+    while (0 == bmp)
+    {
+        if (++index >= DAL_MPOOL_BMP_NUM)
+        {
+            return -1;
+        }
+        bmp = ctl->class_bmp[index];
+    }
+
+    return index * 32 + _dal_mpool_fls(bmp & (~bmp + 1)) - 1;
+}
+
+dal_mpool_mem_t*
+_dal_mpool_create(void* base, int size, int type)
+{
+    dal_mpool_ctl_t* ctl = NULL;
+
+    ctl = (dal_mpool_ctl_t*)DAL_MALLOC(sizeof(dal_mpool_ctl_t));
+    if (ctl == NULL)
+    {
+        return NULL;
+    }
+
+    memset(ctl, 0, sizeof(dal_mpool_ctl_t));
+    ctl->mem.address = base;
+    ctl->mem.size = (size > 0) ? size : 0;
+    ctl->mem.type = type;
+    ctl->brk = base;
+
+    return &ctl->mem;
+}
+
 int
 dal_mpool_init(uint8_t lchip)
 {
@@ -55,33 +289,28 @@ dal_mpool_deinit(uint8_t lchip)
     return 0;
 }
 
-dal_mpool_mem_t*
-_dal_mpool_create(void* base, int size, int type)
+static void
+_dal_mpool_destroy(dal_mpool_mem_t* pool)
 {
-    dal_mpool_mem_t* head = NULL;
-    dal_mpool_mem_t* tail = NULL;
+    dal_mpool_ctl_t* ctl = (dal_mpool_ctl_t*)pool;
+    dal_mpool_mem_t* ptr, * next;
+    int key = 0;
 
-    head = (dal_mpool_mem_t*)DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (head == NULL)
+    if (NULL == pool)
     {
-        return NULL;
+        return;
     }
 
-    tail = (dal_mpool_mem_t*)DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (tail == NULL)
+    for (key = 0; key < DAL_MPOOL_HASH_NUM; key++)
     {
-        DAL_FREE(head);
-        return NULL;
+        for (ptr = ctl->addr_hash[key]; ptr; ptr = next)
+        {
+            next = ptr->hash_next;
+            DAL_FREE(ptr);
+        }
     }
 
-    head->size = tail->size = 0;
-    head->type = type;
-    head->address = base;
-    tail->address = head->address + size;
-    head->next = tail;
-    tail->next = NULL;
-
-    return head;
+    DAL_FREE(ctl);
 }
 
 dal_mpool_mem_t*
@@ -113,8 +342,7 @@ dal_mpool_create(unsigned char lchip, void* base, int size)
     if (NULL == p_desc_pool[lchip])
     {
         MPOOL_UNLOCK();
-        DAL_FREE(head->next);
-        DAL_FREE(head);
+        _dal_mpool_destroy(head);
         return NULL;
     }
 
@@ -123,10 +351,9 @@ dal_mpool_create(unsigned char lchip, void* base, int size)
     if (NULL == p_data_pool[lchip])
     {
         MPOOL_UNLOCK();
-        DAL_FREE(head->next);
-        DAL_FREE(head);
-        DAL_FREE(p_desc_pool[lchip]->next);
-        DAL_FREE(p_desc_pool[lchip]);
+        _dal_mpool_destroy(head);
+        _dal_mpool_destroy(p_desc_pool[lchip]);
+        p_desc_pool[lchip] = NULL;
         return NULL;
     }
 
@@ -136,38 +363,61 @@ dal_mpool_create(unsigned char lchip, void* base, int size)
 }
 
 dal_mpool_mem_t*
-_dal_mpool_alloc_comon(dal_mpool_mem_t* ptr,  int size, int type)
+_dal_mpool_alloc_comon(dal_mpool_mem_t* pool, int size, int type)
 {
-    dal_mpool_mem_t* new_ptr = NULL;
+    dal_mpool_ctl_t* ctl = (dal_mpool_ctl_t*)pool;
+    dal_mpool_mem_t* node = NULL;
+    dal_mpool_mem_t* rest = NULL;
+    int class_id = 0;
 
-    while (ptr && ptr->next)
+    if ((NULL == pool) || (size <= 0))
     {
-        if (ptr->next->address - (ptr->address + ptr->size) >= size)
-        {
-            break;
-        }
-
-        ptr = ptr->next;
+        return NULL;
     }
 
-    if (!(ptr && ptr->next))
+    class_id = _dal_mpool_find_class(ctl, _dal_mpool_ceil_class(size / DAL_CACHE_LINE_BYTES));
+    if (class_id >= 0)
     {
-        return NULL;
+        node = ctl->free_list[class_id];
+        _dal_mpool_free_remove(ctl, node);
+
+        /* give the rest back */
+        if (node->size > size)
+        {
+            rest = DAL_MALLOC(sizeof(dal_mpool_mem_t));
+            if (rest)
+            {
+                rest->address = node->address + size;
+                rest->size = node->size - size;
+                node->size = size;
+                _dal_mpool_hash_insert(ctl->addr_hash, DAL_MPOOL_HASH(rest->address), rest);
+                _dal_mpool_free_insert(ctl, rest);
+            }
+        }
     }
+    else if ((pool->address + pool->size - ctl->brk) >= size)
+    {
+        node = DAL_MALLOC(sizeof(dal_mpool_mem_t));
+        if (!node)
+        {
+            return NULL;
+        }
 
-    new_ptr = DAL_MALLOC(sizeof(dal_mpool_mem_t));
-    if (!new_ptr)
+        node->address = ctl->brk;
+        node->size = size;
+        ctl->brk += size;
+        _dal_mpool_hash_insert(ctl->addr_hash, DAL_MPOOL_HASH(node->address), node);
+    }
+    else
     {
         return NULL;
     }
 
-    new_ptr->type = type;
-    new_ptr->address = ptr->address + ptr->size;
-    new_ptr->size = size;
-    new_ptr->next = ptr->next;
-    ptr->next = new_ptr;
+    node->type = type;
+    node->next = NULL;
+    ctl->used += node->size;
 
-    return new_ptr;
+    return node;
 }
 
 void*
@@ -189,37 +439,19 @@ dal_mpool_alloc(unsigned char lchip, dal_mpool_mem_t* pool, int size, int type)
     {
         case DAL_MPOOL_TYPE_USELESS:
             ptr = pool;
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
             break;
         case DAL_MPOOL_TYPE_DESC:
             ptr = p_desc_pool[lchip];
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
             break;
         case DAL_MPOOL_TYPE_DATA:
             ptr = p_data_pool[lchip];
-            new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
-            if (NULL == new_ptr)
-            {
-                MPOOL_UNLOCK();
-                return NULL;
-            }
             break;
         default:
-            MPOOL_UNLOCK();
-            return NULL;
             break;
     }
 
+    new_ptr = _dal_mpool_alloc_comon(ptr, size, type);
+
     MPOOL_UNLOCK();
     if( NULL == new_ptr )
     {
@@ -229,56 +461,74 @@ dal_mpool_alloc(unsigned char lchip, dal_mpool_mem_t* pool, int size, int type)
     return new_ptr->address;
 }
 
-void
-_dal_mpool_free(dal_mpool_mem_t* ptr, void* addr, int type)
+/* return 0 if the block is found and freed */
+int
+_dal_mpool_free(dal_mpool_mem_t* pool, void* addr, int type)
 {
-    unsigned char* address = (unsigned char*)addr;
-    dal_mpool_mem_t* prev = NULL;
+    dal_mpool_ctl_t* ctl = (dal_mpool_ctl_t*)pool;
+    dal_mpool_mem_t* node = NULL;
+    dal_mpool_mem_t* neighbor = NULL;
 
-    while (ptr && ptr->next)
+    if (NULL == pool)
     {
-        if (ptr->next->address == address)
-        {
-            break;
-        }
+        return -1;
+    }
 
-        ptr = ptr->next;
+    node = _dal_mpool_addr_lookup(ctl, (unsigned char*)addr);
+    if ((NULL == node) || (-1 == node->type))
+    {
+        return -1;
     }
+    ctl->used -= node->size;
 
-    if (ptr && ptr->next)
+    /* merge with the free block before */
+    neighbor = _dal_mpool_end_lookup(ctl, node->address);
+    if (neighbor)
     {
-        prev = ptr;
-        ptr = ptr->next;
-        prev->next = ptr->next;
-        DAL_FREE(ptr);
+        _dal_mpool_free_remove(ctl, neighbor);
+        _dal_mpool_addr_remove(ctl, node);
+        neighbor->size += node->size;
+        DAL_FREE(node);
+        node = neighbor;
     }
 
-    return;
+    /* merge with the free block after */
+    neighbor = _dal_mpool_addr_lookup(ctl, node->address + node->size);
+    if (neighbor && (-1 == neighbor->type))
+    {
+        _dal_mpool_free_remove(ctl, neighbor);
+        _dal_mpool_addr_remove(ctl, neighbor);
+        node->size += neighbor->size;
+        DAL_FREE(neighbor);
+    }
+
+    /* give the block at the end back to the never allocated part */
+    if ((node->address + node->size) == ctl->brk)
+    {
+        _dal_mpool_addr_remove(ctl, node);
+        ctl->brk = node->address;
+        DAL_FREE(node);
+        return 0;
+    }
+
+    _dal_mpool_free_insert(ctl, node);
+
+    return 0;
 }
 
 void
 dal_mpool_free(unsigned char lchip, dal_mpool_mem_t* pool, void* addr)
 {
-    dal_mpool_mem_t* ptr = pool;
-
     MPOOL_LOCK();
 
-    switch(pool->type)
+    /* the block may be allocated by type from the desc or data pool,
+       USELESS (GB only) is not mixed with them */
+    if (_dal_mpool_free(pool, addr, pool->type))
     {
-        case DAL_MPOOL_TYPE_USELESS:
-            ptr = pool;
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_USELESS);
-            break;
-        case DAL_MPOOL_TYPE_DESC:
-            ptr = p_desc_pool[lchip];
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_DESC);
-            break;
-        case DAL_MPOOL_TYPE_DATA:
-            ptr = p_data_pool[lchip];
-            _dal_mpool_free(ptr, addr, DAL_MPOOL_TYPE_DATA);
-            break;
-        default:
-            break;
+        if (_dal_mpool_free(p_desc_pool[lchip], addr, DAL_MPOOL_TYPE_DESC))
+        {
+            _dal_mpool_free(p_data_pool[lchip], addr, DAL_MPOOL_TYPE_DATA);
+        }
     }
 
     MPOOL_UNLOCK();
@@ -288,27 +538,13 @@ dal_mpool_free(unsigned char lchip, dal_mpool_mem_t* pool, void* addr)
 int
 dal_mpool_destroy(unsigned char lchip, dal_mpool_mem_t* pool)
 {
-    dal_mpool_mem_t* ptr, * next;
-
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
-
-    for (ptr = p_desc_pool[lchip]; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
-
-    for (ptr = p_data_pool[lchip]; ptr; ptr = next)
-    {
-        next = ptr->next;
-        DAL_FREE(ptr);
-    }
+    _dal_mpool_destroy(pool);
+    _dal_mpool_destroy(p_desc_pool[lchip]);
+    _dal_mpool_destroy(p_data_pool[lchip]);
+    p_desc_pool[lchip] = NULL;
+    p_data_pool[lchip] = NULL;
 
     MPOOL_UNLOCK();
 
@@ -319,16 +555,12 @@ int
 dal_mpool_usage(dal_mpool_mem_t* pool, int type)
 {
     int usage = 0;
-    dal_mpool_mem_t* ptr;
     uint8_t lchip = 0;
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next)
+    if (pool && ((pool->type == type) || (-1 == type)))
     {
-        if (ptr->type == type || ptr->type == -1)
-        {
-            usage += ptr->size;
-        }
+        usage = ((dal_mpool_ctl_t*)pool)->used;
     }
 
     MPOOL_UNLOCK();
@@ -339,16 +571,27 @@ dal_mpool_usage(dal_mpool_mem_t* pool, int type)
 int
 dal_mpool_debug(dal_mpool_mem_t* pool)
 {
+    dal_mpool_ctl_t* ctl = (dal_mpool_ctl_t*)pool;
     dal_mpool_mem_t* ptr;
     int index = 0;
+    int count = 0;
     uint8_t lchip = 0;
     MPOOL_LOCK();
 
-    for (ptr = pool; ptr; ptr = ptr->next)
+    DAL_PRINT("mpool: address=%p, size=0x%x, used=0x%x, never allocated=0x%x \n", pool->address, pool->size,
+              ctl->used, (int)(pool->address + pool->size - ctl->brk));
+    for (index = 0; index < DAL_MPOOL_CLASS_NUM; index++)
     {
- /*        DAL_PRINT("%2dst mpool block: address=0x%8x, size=0x%x \n", index, (unsigned int)ptr->address, ptr->size);*/
-	 DAL_PRINT("%2dst mpool block: address=%p, size=0x%x \n", index, ptr->address, ptr->size);  /* note*/
-        index++;
+        count = 0;
+        for (ptr = ctl->free_list[index]; ptr; ptr = ptr->next)
+        {
+            count++;
+        }
+        if (count)
+        {
+            DAL_PRINT("%2dst free class: size>=0x%x, count=%d \n", index,
+                      _dal_mpool_class_size(index) * DAL_CACHE_LINE_BYTES, count);
+        }
     }
 
     MPOOL_UNLOCK();
@@ -32,6 +32,9 @@ struct dal_mpool_mem_s
     int size;
     int type;
     struct dal_mpool_mem_s* next;
+    struct dal_mpool_mem_s* prev;           /* free list of the size class */
+    struct dal_mpool_mem_s* hash_next;      /* by address */
+    struct dal_mpool_mem_s* end_hash_next;  /* by end address, free block only */
 };
 typedef struct dal_mpool_mem_s dal_mpool_mem_t;
 
@@ -67,6 +67,13 @@ struct at24_data {
         unsigned write_max;
         unsigned num_addresses;
 
+        /*
+         * Copy of the whole chip, read once and served to all readers.
+         * It is invalidated by a write through this driver.
+         */
+        u8 *cache;
+        bool cache_valid;
+
         /*
          * Some chips tie up multiple I2C addresses; dummy devices reserve
          * them for us, and we'll use them with SMBus calls.
@@ -140,7 +147,9 @@ static ssize_t at24_eeprom_read(struct at24_data *at24, char *buf,
     struct i2c_msg msg[2];
     struct i2c_client *client;
     unsigned long timeout, read_time;
+    u8 msgbuf[2];
     int status;
+    size_t i;
 
     memset(msg, 0, sizeof(msg));
 
@@ -165,7 +174,21 @@ static ssize_t at24_eeprom_read(struct at24_data *at24, char *buf,
     if (count > io_limit)
         count = io_limit;
 
-    count = 1;
+    if (!at24->use_smbus) {
+        i = 0;
+        if (at24->chip.flags & AT24_FLAG_ADDR16)
+            msgbuf[i++] = offset >> 8;
+        msgbuf[i++] = offset;
+
+        msg[0].addr = client->addr;
+        msg[0].buf = msgbuf;
+        msg[0].len = i;
+
+        msg[1].addr = client->addr;
+        msg[1].flags = I2C_M_RD;
+        msg[1].buf = buf;
+        msg[1].len = count;
+    }
 
     /*
      * Reads fail if the previous write didn't complete yet. We may
@@ -176,17 +199,28 @@ static ssize_t at24_eeprom_read(struct at24_data *at24, char *buf,
     do {
         read_time = jiffies;
 
-        status = i2c_smbus_write_byte_data(client, (offset >> 8) & 0x0ff, offset & 0x0ff );
-        status = i2c_smbus_read_byte(client);
-        if (status >= 0) {
-            buf[0] = status;
-            status = count;
+        if (!at24->use_smbus) {
+            /* address write and the whole block in one transfer */
+            status = i2c_transfer(client->adapter, msg, 2);
+            if (status == 2)
+                status = count;
+        } else {
+            /* set the address once, the chip increments it on each sequential read */
+            status = i2c_smbus_write_byte_data(client, (offset >> 8) & 0x0ff, offset & 0x0ff );
+            for (i = 0; (status >= 0) && (i < count); i++) {
+                status = i2c_smbus_read_byte(client);
+                if (status < 0)
+                    break;
+                buf[i] = status;
+            }
+            if (i > 0)
+                status = i;
         }
 
         dev_dbg(&client->dev, "read %zu@%d --> %d (%ld)\n", count, offset, status, jiffies);
-        
-        if (status == count)
-            return count;
+
+        if (status > 0)
+            return status;
 
         /* REVISIT: at HZ=100, this is sloooow */
         msleep(1);
@@ -195,6 +229,25 @@ static ssize_t at24_eeprom_read(struct at24_data *at24, char *buf,
     return -ETIMEDOUT;
 }
 
+/*
+ * Read the whole chip into the cache, with the lock held.
+ */
+static int at24_fill_cache(struct at24_data *at24)
+{
+    unsigned off = 0;
+    ssize_t status;
+
+    while (off < at24->chip.byte_len) {
+        status = at24_eeprom_read(at24, at24->cache + off, off, at24->chip.byte_len - off);
+        if (status <= 0)
+            return status ? status : -EIO;
+        off += status;
+    }
+    at24->cache_valid = true;
+
+    return 0;
+}
+
 static ssize_t at24_read(struct at24_data *at24,
                 char *buf, loff_t off, size_t count)
 {
@@ -211,6 +264,15 @@ static ssize_t at24_read(struct at24_data *at24,
      */
     mutex_lock(&at24->lock);
 
+    /* the sysfs layer already limited off + count to the chip size */
+    if (!at24->cache_valid)
+        at24_fill_cache(at24);
+    if (at24->cache_valid) {
+        memcpy(buf, at24->cache + off, count);
+        mutex_unlock(&at24->lock);
+        return count;
+    }
+
     while (count) {
         ssize_t status;
 
@@ -309,6 +371,9 @@ static ssize_t at24_write(struct at24_data *at24, const char *buf, loff_t off,
      */
     mutex_lock(&at24->lock);
 
+    /* the chip is reread on the next read */
+    at24->cache_valid = false;
+
     while (count) {
         ssize_t status;
 
@@ -439,6 +504,10 @@ static int at24_probe(struct i2c_client *client, const struct i2c_device_id *id)
     at24->chip = chip;
     at24->num_addresses = num_addresses;
 
+    at24->cache = devm_kzalloc(&client->dev, chip.byte_len, GFP_KERNEL);
+    if (!at24->cache)
+        return -ENOMEM;
+
     printk(KERN_ALERT "at24_probe chip.byte_len = 0x%x\n", chip.byte_len);
     printk(KERN_ALERT "at24_probe chip.flags = 0x%x\n", chip.flags);
     printk(KERN_ALERT "at24_probe chip.magic = 0x%lx\n", id->driver_data);
@@ -490,6 +559,12 @@ static int at24_probe(struct i2c_client *client, const struct i2c_device_id *id)
         }
     }
 
+    /* the contents don't change, read them once for all the readers */
+    mutex_lock(&at24->lock);
+    if (at24_fill_cache(at24))
+        dev_warn(&client->dev, "read eeprom failed, retry on the first access\n");
+    mutex_unlock(&at24->lock);
+
     err = sysfs_create_bin_file(&client->dev.kobj, &at24->bin);
     if (err)
         goto err_clients;
@@ -26,6 +26,7 @@
 #include <linux/err.h>
 #include <linux/platform_device.h>
 #include <linux/types.h>
+#include <linux/jiffies.h>
 #include <uapi/linux/stat.h>
 
 #define DRIVER_NAME "ms200i_cpld"
@@ -92,6 +93,13 @@
 #define CPLD4_EX_CP_I2CDR0_I2C          0xA313
 #define CPLD4_EX_CP_I2CID0_I2C          0xA314
 
+/* One I2C master in each of CPLD2, CPLD3 and CPLD4, shared by its ports */
+#define NUM_I2C_MASTER                  3
+
+/* Status register poll interval while waiting for a byte transfer */
+#define I2C_WAIT_MIN_US                 10
+#define I2C_WAIT_MAX_US                 20
+
 enum {
     I2C_SR_BIT_RXAK = 0,
     I2C_SR_BIT_MIF,
@@ -127,6 +135,7 @@ enum {
 
 struct ms200i_i2c_data {
         int portid;
+        struct mutex *lock;     /* lock of the I2C master of the port */
         unsigned REG_FDR0;
         unsigned REG_CR0;
         unsigned REG_SR0;
@@ -137,6 +146,7 @@ struct ms200i_i2c_data {
 struct ms200i_cpld_data {
         struct i2c_adapter *i2c_adapter[LENGTH_PORT_CPLD];
         struct mutex       cpld_lock;
+        struct mutex       i2c_lock[NUM_I2C_MASTER];
         unsigned char sfpp_lpmode[2];
         unsigned char sfpp_reset[2];
 };
@@ -389,9 +399,10 @@ static struct platform_device cel_ms200i_lpc_dev = {
 };
 
 
+/* timeout is in microseconds, the status is polled between sleeps */
 static int i2c_wait_ack(struct i2c_adapter *a,unsigned timeout,int writing){
     int error = 0;
-    unsigned tick=0;
+    unsigned long deadline = jiffies + usecs_to_jiffies(timeout) + 1;
     int Status;
 
     struct ms200i_i2c_data *new_data = i2c_get_adapdata(a);
@@ -401,14 +412,6 @@ static int i2c_wait_ack(struct i2c_adapter *a,unsigned timeout,int writing){
 
     while(1){
         Status = inb(new_data->REG_SR0);
-        tick++;
-        if(tick > timeout){
-            info("Status %2.2X",Status);
-            info("Error Timeout");
-            error = -ETIMEDOUT;
-            break;
-        }
-
 
         if(Status & (1 << I2C_SR_BIT_MIF)){
             break;
@@ -417,6 +420,14 @@ static int i2c_wait_ack(struct i2c_adapter *a,unsigned timeout,int writing){
         if(writing == 0 && (Status & (1<<I2C_SR_BIT_MCF))){
             break;
         }
+
+        if(time_after(jiffies, deadline)){
+            info("Status %2.2X",Status);
+            info("Error Timeout");
+            error = -ETIMEDOUT;
+            break;
+        }
+        usleep_range(I2C_WAIT_MIN_US, I2C_WAIT_MAX_US);
     }
     Status = inb(new_data->REG_SR0);
     outb(0, new_data->REG_SR0);
@@ -458,11 +469,15 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
 
         struct ms200i_i2c_data *new_data;
 
-        mutex_lock(&cpld_data->cpld_lock);
+        if (size == I2C_SMBUS_I2C_BLOCK_DATA &&
+            (data->block[0] == 0 || data->block[0] > I2C_SMBUS_BLOCK_MAX))
+                return -EINVAL;
 
         /* Write the command register */
         new_data = i2c_get_adapdata(a);
 
+        mutex_lock(new_data->lock);
+
         unsigned int  portid = new_data->portid;
 
 #ifdef DEBUG_KERN
@@ -473,7 +488,8 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
                                     size == 2 ? "BYTE_DATA" :
                                     size == 3 ? "WORD_DATA" :
                                     size == 4 ? "PROC_CALL" :
-                                    size == 5 ? "BLOCK_DATA" :  "ERROR"
+                                    size == 5 ? "BLOCK_DATA" :
+                                    size == 8 ? "I2C_BLOCK_DATA" :  "ERROR"
             ,cmd,data->word);
 #endif
         /* Map the size to what the chip understands */
@@ -483,6 +499,7 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
             case I2C_SMBUS_BYTE_DATA:
             case I2C_SMBUS_WORD_DATA:
             case I2C_SMBUS_BLOCK_DATA:
+            case I2C_SMBUS_I2C_BLOCK_DATA:
                 break;
             default:
                 printk(KERN_INFO "Unsupported transaction %d\n", size);
@@ -536,6 +553,7 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
         if(size == I2C_SMBUS_BYTE_DATA ||
             size == I2C_SMBUS_WORD_DATA ||
             size == I2C_SMBUS_BLOCK_DATA ||
+            size == I2C_SMBUS_I2C_BLOCK_DATA ||
             (size == I2C_SMBUS_BYTE && rw == I2C_SMBUS_WRITE)){
 
             //sent command code to data register
@@ -556,6 +574,7 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
             case I2C_SMBUS_WORD_DATA:
                     cnt = 2;  break;
             case I2C_SMBUS_BLOCK_DATA:
+            case I2C_SMBUS_I2C_BLOCK_DATA:
             // in block data mode keep number of byte in block[0]
                     cnt = data->block[0];
                               break;
@@ -582,11 +601,13 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
                     size == I2C_SMBUS_BYTE ||
                     size == I2C_SMBUS_BYTE_DATA ||
                     size == I2C_SMBUS_WORD_DATA ||
-                    size == I2C_SMBUS_BLOCK_DATA
+                    size == I2C_SMBUS_BLOCK_DATA ||
+                    size == I2C_SMBUS_I2C_BLOCK_DATA
             )){
             int bid=0;
             info( "MS prepare to sent [%d bytes]",cnt);
-            if(size == I2C_SMBUS_BLOCK_DATA ){
+            if(size == I2C_SMBUS_BLOCK_DATA ||
+                    size == I2C_SMBUS_I2C_BLOCK_DATA){
                 bid=1;      // block[0] is cnt;
                 cnt+=1;     // offset from block[0]
             }
@@ -607,7 +628,8 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
         if( rw == I2C_SMBUS_READ && (
                 size == I2C_SMBUS_BYTE_DATA ||
                 size == I2C_SMBUS_WORD_DATA ||
-                size == I2C_SMBUS_BLOCK_DATA
+                size == I2C_SMBUS_BLOCK_DATA ||
+                size == I2C_SMBUS_I2C_BLOCK_DATA
             )){
             info( "MS Repeated Start");
 
@@ -633,8 +655,11 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
                 size == I2C_SMBUS_BYTE ||
                 size == I2C_SMBUS_BYTE_DATA ||
                 size == I2C_SMBUS_WORD_DATA ||
-                size == I2C_SMBUS_BLOCK_DATA
+                size == I2C_SMBUS_BLOCK_DATA ||
+                size == I2C_SMBUS_I2C_BLOCK_DATA
             )){
+            // i2c block data is stored from block[1], block[0] is the count
+            int boff = (size == I2C_SMBUS_I2C_BLOCK_DATA) ? 1 : 0;
 
             switch(size){
                 case I2C_SMBUS_BYTE:
@@ -645,6 +670,8 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
                 case I2C_SMBUS_BLOCK_DATA:
                     //will be changed after recived first data
                         cnt = 3;  break;
+                case I2C_SMBUS_I2C_BLOCK_DATA:
+                        cnt = data->block[0];  break;
                 default:
                         cnt = 0;  break;
             }
@@ -679,9 +706,9 @@ static int ms200i_i2c_access(struct i2c_adapter *a, u16 addr,
                         info ( "SET STOP in read loop");
                         SET_REG_BIT_L(REG_CR0,I2C_CR_BIT_MSTA);
                     }
-                    data->block[bid] = inb(REG_DR0);
+                    data->block[bid + boff] = inb(REG_DR0);
 
-                    info( "DATA IN [%d] %2.2X",bid,data->block[bid]);
+                    info( "DATA IN [%d] %2.2X",bid,data->block[bid + boff]);
 
                     if(size==I2C_SMBUS_BLOCK_DATA && bid == 0){
                         cnt = data->block[0] + 1;
@@ -704,7 +731,7 @@ Done:
         printk(KERN_INFO "END --- Error code  %d",error);
 #endif
 
-        mutex_unlock(&cpld_data->cpld_lock);
+        mutex_unlock(new_data->lock);
 
         return error;
 }
@@ -715,7 +742,8 @@ static u32 ms200i_i2c_func(struct i2c_adapter *a)
             I2C_FUNC_SMBUS_BYTE |
             I2C_FUNC_SMBUS_BYTE_DATA |
             I2C_FUNC_SMBUS_WORD_DATA |
-            I2C_FUNC_SMBUS_BLOCK_DATA;
+            I2C_FUNC_SMBUS_BLOCK_DATA |
+            I2C_FUNC_SMBUS_I2C_BLOCK;
 }
 
 static const struct i2c_algorithm ms200i_i2c_algorithm = {
@@ -755,6 +783,7 @@ static struct i2c_adapter * cel_ms200i_i2c_init(struct platform_device *pdev, in
             new_data->REG_SR0   = CPLD2_EX_CP_I2CSR0_I2C;
             new_data->REG_DR0   = CPLD2_EX_CP_I2CDR0_I2C;
             new_data->REG_ID0   = CPLD2_EX_CP_I2CID0_I2C;
+            new_data->lock      = &cpld_data->i2c_lock[0];
 
         }else if((portid >= 3 && portid <= 33)){
             new_data->REG_FDR0  = CPLD3_EX_CP_I2CFDR0_I2C;
@@ -762,6 +791,7 @@ static struct i2c_adapter * cel_ms200i_i2c_init(struct platform_device *pdev, in
             new_data->REG_SR0   = CPLD3_EX_CP_I2CSR0_I2C;
             new_data->REG_DR0   = CPLD3_EX_CP_I2CDR0_I2C;
             new_data->REG_ID0   = CPLD3_EX_CP_I2CID0_I2C;
+            new_data->lock      = &cpld_data->i2c_lock[1];
 
         }else if((portid >= 34 && portid <= 64)){
             new_data->REG_FDR0  = CPLD4_EX_CP_I2CFDR0_I2C;
@@ -769,6 +799,7 @@ static struct i2c_adapter * cel_ms200i_i2c_init(struct platform_device *pdev, in
             new_data->REG_SR0   = CPLD4_EX_CP_I2CSR0_I2C;
             new_data->REG_DR0   = CPLD4_EX_CP_I2CDR0_I2C;
             new_data->REG_ID0   = CPLD4_EX_CP_I2CID0_I2C;
+            new_data->lock      = &cpld_data->i2c_lock[2];
         }
         outb(portid,new_data->REG_ID0);
         outb(0x1F,new_data->REG_FDR0); // 0x1F 100kHz
@@ -788,6 +819,7 @@ static int cel_ms200i_lpc_drv_probe(struct platform_device *pdev)
         struct resource *res;
         int ret =0;
         int portid_count;
+        int i;
 
         cpld_data = devm_kzalloc(&pdev->dev, sizeof(struct ms200i_cpld_data),
                         GFP_KERNEL);
@@ -795,6 +827,8 @@ static int cel_ms200i_lpc_drv_probe(struct platform_device *pdev)
             return -ENOMEM;
 
         mutex_init(&cpld_data->cpld_lock);
+        for (i = 0; i < NUM_I2C_MASTER; i++)
+            mutex_init(&cpld_data->i2c_lock[i]);
 
         res = platform_get_resource(pdev, IORESOURCE_IO, 0);
         if (unlikely(!res)) {
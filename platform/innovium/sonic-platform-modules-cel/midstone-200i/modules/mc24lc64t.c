@@ -17,34 +17,73 @@
 #include <linux/types.h>
 #include <linux/delay.h>
 #include <linux/jiffies.h>
+#include <linux/bitops.h>
+
+/*
+ * The 24LC64 holds 8 KiB and ignores the upper three bits of the word
+ * address, so the 64 KiB attribute sees the contents wrapped around.
+ * Blocks are cached in memory the first time they are read: the EEPROM
+ * is only written by manufacturing, never through this driver.
+ */
+#define MC24LC64T_SIZE          8192
+#define MC24LC64T_BLOCK_SIZE    32
+#define MC24LC64T_NUM_BLOCKS    (MC24LC64T_SIZE / MC24LC64T_BLOCK_SIZE)
 
 struct mc24lc64t_data {
         struct i2c_client       *fake_client;
         struct mutex            update_lock;
+        bool                    use_i2c;
+        DECLARE_BITMAP(valid, MC24LC64T_NUM_BLOCKS);
+        u8                      cache[MC24LC64T_SIZE];
 };
 
-static ssize_t mc24lc64t_read(struct file *filp, struct kobject *kobj,
-                            struct bin_attribute *bin_attr,
-                            char *buf, loff_t off, size_t count)
+/*
+ * Sequential read: word address write, repeated start, then len bytes
+ */
+static int mc24lc64t_read_i2c(struct i2c_client *client, unsigned int addr,
+                            u8 *buf, size_t len)
 {
-        struct i2c_client *client = kobj_to_i2c_client(kobj);
-        struct mc24lc64t_data *drvdata = i2c_get_clientdata(client);
-        unsigned long timeout, read_time, i = 0;
+        u8 waddr[2] = { addr >> 8, addr & 0xff };
+        struct i2c_msg msgs[2] = {
+                {
+                        .addr = client->addr,
+                        .flags = 0,
+                        .len = sizeof(waddr),
+                        .buf = waddr,
+                },
+                {
+                        .addr = client->addr,
+                        .flags = I2C_M_RD,
+                        .len = len,
+                        .buf = buf,
+                },
+        };
         int status;
 
-        mutex_lock(&drvdata->update_lock);
+        status = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+        if (status < 0)
+                return status;
 
-        if (i2c_smbus_write_byte_data(client, off>>8, off))
-        {
-                status = -EIO;
-                goto exit;
-        }
+        return status == ARRAY_SIZE(msgs) ? 0 : -EIO;
+}
 
-        msleep(1);
+/*
+ * SMBus only adapters: word address write, then one current address
+ * read per byte
+ */
+static int mc24lc64t_read_smbus(struct i2c_client *client, unsigned int addr,
+                              u8 *buf, size_t len)
+{
+        unsigned long timeout, read_time;
+        size_t i = 0;
+        int status;
 
-begin:
+        if (i2c_smbus_write_byte_data(client, addr >> 8, addr & 0xff))
+                return -EIO;
 
-        if (i < count)
+        msleep(1);
+
+        while (i < len)
         {
                 timeout = jiffies + msecs_to_jiffies(25); /* 25 mS timeout*/
                 do {
@@ -52,22 +91,69 @@ begin:
 
                         status = i2c_smbus_read_byte(client);
                         if (status >= 0)
-                        {
-                                buf[i++] = status;
-                                goto begin;
-                        }
+                                break;
                 } while (time_before(read_time, timeout));
 
-                status = -ETIMEDOUT;
-                goto exit;
+                if (status < 0)
+                        return -ETIMEDOUT;
+
+                buf[i++] = status;
         }
 
-        status = count;
+        return 0;
+}
+
+static ssize_t mc24lc64t_read(struct file *filp, struct kobject *kobj,
+                            struct bin_attribute *bin_attr,
+                            char *buf, loff_t off, size_t count)
+{
+        struct i2c_client *client = kobj_to_i2c_client(kobj);
+        struct mc24lc64t_data *drvdata = i2c_get_clientdata(client);
+        unsigned int addr, block, first, last, n;
+        u8 *dst;
+        size_t i = 0;
+        int status = 0;
+
+        mutex_lock(&drvdata->update_lock);
+
+        while (i < count)
+        {
+                addr = (off + i) & (MC24LC64T_SIZE - 1);
+                block = addr / MC24LC64T_BLOCK_SIZE;
+
+                if (!test_bit(block, drvdata->valid))
+                {
+                        /* Fill the run of uncached blocks up to the end of the request */
+                        first = block;
+                        last = (min_t(size_t, addr + count - i, MC24LC64T_SIZE) - 1) /
+                               MC24LC64T_BLOCK_SIZE;
+                        while (block < last && !test_bit(block + 1, drvdata->valid))
+                                block++;
+
+                        dst = &drvdata->cache[first * MC24LC64T_BLOCK_SIZE];
+                        n = (block - first + 1) * MC24LC64T_BLOCK_SIZE;
+
+                        if (drvdata->use_i2c)
+                                status = mc24lc64t_read_i2c(client, first * MC24LC64T_BLOCK_SIZE, dst, n);
+                        else
+                                status = mc24lc64t_read_smbus(client, first * MC24LC64T_BLOCK_SIZE, dst, n);
+                        if (status)
+                                goto exit;
+
+                        for (block = first; block < first + n / MC24LC64T_BLOCK_SIZE; block++)
+                                set_bit(block, drvdata->valid);
+                }
+
+                n = min_t(size_t, count - i,
+                          MC24LC64T_BLOCK_SIZE - addr % MC24LC64T_BLOCK_SIZE);
+                memcpy(&buf[i], &drvdata->cache[addr], n);
+                i += n;
+        }
 
 exit:
         mutex_unlock(&drvdata->update_lock);
 
-        return status;
+        return i ? i : status;
 }
 
 static struct bin_attribute mc24lc64t_bit_attr = {
@@ -84,9 +170,11 @@ static int mc24lc64t_probe(struct i2c_client *client,
 {
         struct i2c_adapter *adapter = client->adapter;
         struct mc24lc64t_data *drvdata;
+        bool use_i2c = i2c_check_functionality(adapter, I2C_FUNC_I2C);
         int err;
 
-        if (!i2c_check_functionality(adapter, I2C_FUNC_SMBUS_WRITE_BYTE_DATA
+        if (!use_i2c &&
+            !i2c_check_functionality(adapter, I2C_FUNC_SMBUS_WRITE_BYTE_DATA
                                      | I2C_FUNC_SMBUS_READ_BYTE))
                 return -EPFNOSUPPORT;
 
@@ -94,6 +182,8 @@ static int mc24lc64t_probe(struct i2c_client *client,
                         sizeof(struct mc24lc64t_data), GFP_KERNEL)))
                 return -ENOMEM;
 
+        drvdata->use_i2c = use_i2c;
+
         drvdata->fake_client = i2c_new_dummy(client->adapter, client->addr + 1);
         if (!drvdata->fake_client)
                 return -ENOMEM;
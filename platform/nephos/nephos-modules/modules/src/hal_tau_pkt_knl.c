@@ -41,6 +41,10 @@
 #include <linux/pci.h>
 #include <linux/module.h>
 #include <linux/if.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/pkt_sched.h>
 
 /* netif */
 #include <netif_osal.h>
@@ -70,6 +74,32 @@
 #define HAL_TAU_PKT_TCH_CNT(__unit__, __channel__)      (_hal_tau_pkt_intr_vec[1 + (__channel__)].intr_cnt)
 #define HAL_TAU_PKT_RCH_CNT(__unit__, __channel__)      (_hal_tau_pkt_intr_vec[5 + (__channel__)].intr_cnt)
 
+#define HAL_TAU_PKT_RCH_VEC_BASE                        (5)
+
+/* Tx skb followed by more packets from the stack, the doorbell can be postponed */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+#define HAL_TAU_PKT_SKB_XMIT_MORE(__skb__)              (netdev_xmit_more())
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 18, 0)
+#define HAL_TAU_PKT_SKB_XMIT_MORE(__skb__)              ((__skb__)->xmit_more)
+#else
+#define HAL_TAU_PKT_SKB_XMIT_MORE(__skb__)              (0)
+#endif
+
+#ifndef ETH_P_LLDP
+#define ETH_P_LLDP                                      (0x88CC)
+#endif
+
+/* ndo_select_queue prototype of the kernel */
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+#define HAL_TAU_PKT_SELECT_QUEUE_ARGS                   struct net_device *ptr_sb_dev
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(4, 19, 0)
+#define HAL_TAU_PKT_SELECT_QUEUE_ARGS                   struct net_device *ptr_sb_dev, select_queue_fallback_t fallback
+#elif LINUX_VERSION_CODE >= KERNEL_VERSION(3, 14, 0)
+#define HAL_TAU_PKT_SELECT_QUEUE_ARGS                   void *ptr_accel_priv, select_queue_fallback_t fallback
+#else
+#define HAL_TAU_PKT_SELECT_QUEUE_ARGS                   void *ptr_accel_priv
+#endif
+
 
 /* This flag value will be specified when user inserts kernel module. */
 #define HAL_TAU_PKT_DBG_ERR             (0x1UL << 0)
@@ -82,6 +112,17 @@
 
 /* Will be set when inserting kernel module */
 UI32_T          ext_dbg_flag = 0;
+UI32_T          rx_napi = 0;
+UI32_T          nl_batch_num = 16;
+UI32_T          stats_ms = 1000;
+UI32_T          tx_channels = HAL_TAU_PKT_TX_CHANNEL_LAST;
+UI32_T          rx_copybreak = 256;
+UI32_T          rx_thread_prio = 0;
+UI32_T          tx_thread_prio = 0;
+UI32_T          err_thread_prio = 0;
+UI32_T          rx_thread_cpus = 0;
+UI32_T          tx_thread_cpus = 0;
+UI32_T          err_thread_cpus = 0;
 
 #define HAL_TAU_PKT_DBG(__flag__, ...)      do                  \
 {                                                               \
@@ -102,6 +143,7 @@ typedef struct
 typedef struct HAL_TAU_PKT_PROFILE_NODE_S
 {
     HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_profile;
+    UI32_T                              order;      /* to sort the profiles with the same priority */
     struct HAL_TAU_PKT_PROFILE_NODE_S   *ptr_next_node;
 
 } HAL_TAU_PKT_PROFILE_NODE_T;
@@ -112,6 +154,13 @@ typedef struct
     struct net_device                   *ptr_net_dev;
     HAL_TAU_PKT_PROFILE_NODE_T          *ptr_profile_list;  /* the profiles binding to this interface */
 
+    /* Index of ptr_profile_list for Rx lookup, both sorted by priority:
+     * the profiles only matching IPP reason codes are linked to the list of each code,
+     * the others are linked to the generic list
+     */
+    HAL_TAU_PKT_PROFILE_NODE_T          *ptr_rsn_list[HAL_TAU_PKT_IPP_RSN_LAST];
+    HAL_TAU_PKT_PROFILE_NODE_T          *ptr_generic_list;
+
 } HAL_TAU_PKT_NETIF_PORT_DB_T;
 
 
@@ -149,6 +198,9 @@ static HAL_TAU_PKT_INTR_VEC_T           _hal_tau_pkt_intr_vec[] =
 
 static HAL_TAU_PKT_NETIF_PROFILE_T              *_ptr_hal_tau_pkt_profile_entry[HAL_TAU_PKT_NET_PROFILE_NUM_MAX] = {0};
 static HAL_TAU_PKT_NETIF_PORT_DB_T              _hal_tau_pkt_port_db[HAL_TAU_PKT_MAX_PORT_NUM];
+/* intf id to port DB, maintained on intf create/destroy */
+static HAL_TAU_PKT_NETIF_PORT_DB_T              *_ptr_hal_tau_pkt_intf_entry[HAL_TAU_PKT_MAX_PORT_NUM] = {0};
+static UI32_T                                   _hal_tau_pkt_profile_order = 0;
 
 /*****************************************************************************
  * MACRO VLAUE DECLARATIONS
@@ -186,15 +238,25 @@ typedef struct
 
 } HAL_TAU_PKT_ISR_COOKIE_T;
 
+/* The queue is a lock-free SPSC ring. sema serializes the consumers and
+ * prod_sema, if created, serializes the producers of a queue that is fed
+ * by more than one task.
+ */
 typedef struct
 {
     NPS_HUGE_T                      que_id;
     NPS_SEMAPHORE_ID_T              sema;
+    NPS_SEMAPHORE_ID_T              prod_sema;
     UI32_T                          len;      /* Software CPU queue maximum length.        */
     UI32_T                          weight;   /* The weight for thread de-queue algorithm. */
+    UI32_T                          depth;    /* Drop the packets beyond the depth, 0: len */
+    I32_T                           deficit;  /* The remaining credit of WRR/DWRR turn.    */
 
 } HAL_TAU_PKT_SW_QUEUE_T;
 
+#define HAL_TAU_PKT_FLUSH_BULK_NUM      (32)
+#define HAL_TAU_PKT_RX_DEQUE_BULK_NUM   (32)
+
 typedef struct
 {
     /* handleErrorTask */
@@ -229,6 +291,7 @@ typedef struct
     UI32_T                          used_gpd_num;
     UI32_T                          free_gpd_num;
     UI32_T                          gpd_num;
+    UI32_T                          pend_gpd_num; /* filled GPDs not resumed to HW yet, see xmit_more */
 
     HAL_TAU_PKT_TX_GPD_T            *ptr_gpd_start_addr;
     HAL_TAU_PKT_TX_GPD_T            *ptr_gpd_align_start_addr;
@@ -265,9 +328,21 @@ typedef struct
      */
     BOOL_T                          net_tx_allowed;
 
+    /* TRUE when the Tx queue of the channel is suspended on all the net
+     * intf for the Tx GPD ring is nearly full, the Tx done task wakes it
+     * only after enough GPDs are reclaimed
+     */
+    BOOL_T                          net_tx_suspended[HAL_TAU_PKT_TX_CHANNEL_LAST];
+
 } HAL_TAU_PKT_TX_CB_T;
 
 /* ----------------------------------------------------------------------------------- RX structure */
+typedef struct
+{
+    struct sk_buff                  *ptr_skb;
+    NPS_ADDR_T                      phy_addr;
+} HAL_TAU_PKT_RX_RECYCLE_BUF_T;
+
 typedef struct
 {
     NPS_SEMAPHORE_ID_T              sema;
@@ -278,8 +353,27 @@ typedef struct
     HAL_TAU_PKT_RX_GPD_T            *ptr_gpd_align_start_addr;
     BOOL_T                          err_flag;
     struct sk_buff                  **pptr_skb_ring;
+
+    /* SW GPDs of the packet not yet completed by the GPD with ch=0 */
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd;
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_last_gpd;
+
+    /* Consumed payload buffers kept DMA mapped to refill the GPD ring,
+     * the stack holds up to gpd_num buffers and is used LIFO so that the
+     * most recently used buffers are reused first
+     */
+    NPS_ISRLOCK_ID_T                recycle_lock;
+    HAL_TAU_PKT_RX_RECYCLE_BUF_T    *ptr_recycle_buf;
+    UI32_T                          recycle_cnt;
 } HAL_TAU_PKT_RX_PDMA_T;
 
+typedef struct
+{
+    struct napi_struct              napi;
+    UI32_T                          unit;
+    HAL_TAU_PKT_RX_CHANNEL_T        channel;
+} HAL_TAU_PKT_RX_NAPI_T;
+
 typedef struct
 {
     /* Rx system configuration */
@@ -293,9 +387,14 @@ typedef struct
     NPS_THREAD_ID_T                 isr_task_id[HAL_TAU_PKT_RX_CHANNEL_LAST];
     HAL_TAU_PKT_ISR_COOKIE_T        isr_task_cookie[HAL_TAU_PKT_RX_CHANNEL_LAST];
 
+    /* rxNapiPoll, replaces handleRxDoneTask when napi_mode=TRUE */
+    BOOL_T                          napi_mode;   /* only changed when Rx is stopped */
+    struct net_device               napi_dev;    /* dummy netdev to host the NAPI contexts */
+    HAL_TAU_PKT_RX_NAPI_T           napi[HAL_TAU_PKT_RX_CHANNEL_LAST];
+
     /* rxTask */
     HAL_TAU_PKT_SW_QUEUE_T          sw_queue[HAL_TAU_PKT_RX_QUEUE_NUM];
-    UI32_T                          deque_idx;
+    UI32_T                          deque_idx;   /* next queue for RR, current queue for WRR/DWRR */
     NPS_SEMAPHORE_ID_T              sync_sema;
     NPS_THREAD_ID_T                 task_id;
     NPS_SEMAPHORE_ID_T              deinit_sema; /* To sync-up the Rx-stop and thread flush queues */
@@ -420,6 +519,7 @@ _hal_tau_pkt_dispatcher(
 {
     UI32_T                      unit = (UI32_T)((NPS_HUGE_T)ptr_cookie);
     HAL_TAU_PKT_DRV_CB_T        *ptr_cb = HAL_TAU_PKT_GET_DRV_CB_PTR(unit);
+    HAL_TAU_PKT_RX_CB_T         *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
     NPS_IRQ_FLAGS_T             irq_flag = 0;
 
     UI32_T                      idx = 0, vec = sizeof(_hal_tau_pkt_intr_vec) / sizeof(HAL_TAU_PKT_INTR_VEC_T);
@@ -443,7 +543,17 @@ _hal_tau_pkt_dispatcher(
         {
             if (_hal_tau_pkt_intr_vec[idx].intr_reg & intr_status)
             {
-                osal_triggerEvent(&_hal_tau_pkt_intr_vec[idx].intr_event);
+                /* Rx-Done is handled in NAPI poll, which unmasks the interrupt when completed */
+                if ((TRUE == ptr_rx_cb->napi_mode) &&
+                    (idx >= HAL_TAU_PKT_RCH_VEC_BASE) &&
+                    (idx < HAL_TAU_PKT_RCH_VEC_BASE + HAL_TAU_PKT_RX_CHANNEL_LAST))
+                {
+                    napi_schedule(&ptr_rx_cb->napi[idx - HAL_TAU_PKT_RCH_VEC_BASE].napi);
+                }
+                else
+                {
+                    osal_triggerEvent(&_hal_tau_pkt_intr_vec[idx].intr_event);
+                }
                 _hal_tau_pkt_intr_vec[idx].intr_cnt++;
             }
         }
@@ -1103,6 +1213,13 @@ hal_tau_pkt_getRxKnlCnt(
     HAL_TAU_PKT_IOCTL_CH_CNT_COOKIE_T   *ptr_cookie)
 {
     HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    UI32_T                          queue = 0;
+
+    /* each Rx channel enqueues to the queue of the same index */
+    for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
+    {
+        osal_que_getCount(&ptr_rx_cb->sw_queue[queue].que_id, &ptr_rx_cb->cnt.channel[queue].que_len);
+    }
 
     osal_io_copyToUser(&ptr_cookie->rx_cnt, &ptr_rx_cb->cnt, sizeof(HAL_TAU_PKT_RX_CNT_T));
     return (NPS_E_OK);
@@ -1391,7 +1508,8 @@ _hal_tau_pkt_getNetlink(
  * RETURN:
  *      NPS_E_OK    -- Successfully enqueue the data.
  * NOTES:
- *      None
+ *      The producer does not contend with the consumer. Only a queue with
+ *      several producers takes the producer semaphore.
  */
 static NPS_ERROR_NO_T
 _hal_tau_pkt_enQueue(
@@ -1400,9 +1518,16 @@ _hal_tau_pkt_enQueue(
 {
     NPS_ERROR_NO_T          rc = NPS_E_OK;
 
-    osal_takeSemaphore(&ptr_que->sema, NPS_SEMAPHORE_WAIT_FOREVER);
-    rc = osal_que_enque(&ptr_que->que_id, ptr_data);
-    osal_giveSemaphore(&ptr_que->sema);
+    if (0 != ptr_que->prod_sema)
+    {
+        osal_takeSemaphore(&ptr_que->prod_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+        rc = osal_que_enque(&ptr_que->que_id, ptr_data);
+        osal_giveSemaphore(&ptr_que->prod_sema);
+    }
+    else
+    {
+        rc = osal_que_enque(&ptr_que->que_id, ptr_data);
+    }
 
     return (rc);
 }
@@ -1418,7 +1543,8 @@ _hal_tau_pkt_enQueue(
  * RETURN:
  *      NPS_E_OK    -- Successfully dequeue the data.
  * NOTES:
- *      None
+ *      The semaphore only serializes consumers, e.g. the user-space RX
+ *      path against the flush at RX stop.
  */
 static NPS_ERROR_NO_T
 _hal_tau_pkt_deQueue(
@@ -1434,6 +1560,37 @@ _hal_tau_pkt_deQueue(
     return (rc);
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_deQueueBulk
+ * PURPOSE:
+ *      To dequeue up to the specified number of data.
+ * INPUT:
+ *      ptr_que     -- Pointer for the target queue
+ *      pptr_data   -- Array of data pointers to be dequeued
+ *      num         -- Size of the array
+ * OUTPUT:
+ *      ptr_count   -- Number of dequeued data
+ * RETURN:
+ *      NPS_E_OK    -- Successfully dequeue at least one data.
+ *      NPS_E_OTHERS-- The queue is empty.
+ * NOTES:
+ *      None
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_deQueueBulk(
+    HAL_TAU_PKT_SW_QUEUE_T  *ptr_que,
+    void                    **pptr_data,
+    const UI32_T            num,
+    UI32_T                  *ptr_count)
+{
+    NPS_ERROR_NO_T          rc = NPS_E_OK;
+
+    osal_takeSemaphore(&ptr_que->sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    rc = osal_que_dequeBulk(&ptr_que->que_id, pptr_data, num, ptr_count);
+    osal_giveSemaphore(&ptr_que->sema);
+
+    return (rc);
+}
+
 /* FUNCTION NAME: _hal_tau_pkt_getQueueCount
  * PURPOSE:
  *      To obtain the current GPD number in the target RX queue.
@@ -1446,7 +1603,7 @@ _hal_tau_pkt_deQueue(
  *      NPS_E_OK            -- Successfully obtain the GPD count.
  *      NPS_E_BAD_PARAMETER -- Parameter pointer is null.
  * NOTES:
- *      None
+ *      The count is a lock-free snapshot.
  */
 static NPS_ERROR_NO_T
 _hal_tau_pkt_getQueueCount(
@@ -1455,13 +1612,133 @@ _hal_tau_pkt_getQueueCount(
 {
     NPS_ERROR_NO_T          rc = NPS_E_OK;
 
-    osal_takeSemaphore(&ptr_que->sema, NPS_SEMAPHORE_WAIT_FOREVER);
     osal_que_getCount(&ptr_que->que_id, ptr_count);
-    osal_giveSemaphore(&ptr_que->sema);
 
     return (rc);
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_putRecycleRxBuf
+ * PURPOSE:
+ *      To return a consumed RX payload buffer to the recycle stack.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The RX channel of the buffer
+ *      ptr_skb         --  The payload buffer, still DMA mapped
+ *      phy_addr        --  The DMA address of the buffer
+ *      len             --  The DMA mapped length of the buffer
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      The buffer is unmapped and freed if the stack is full or the buffer
+ *      size is no longer the configured one.
+ */
+static void
+_hal_tau_pkt_putRecycleRxBuf(
+    const UI32_T                    unit,
+    const UI32_T                    channel,
+    struct sk_buff                  *ptr_skb,
+    const NPS_ADDR_T                phy_addr,
+    const UI32_T                    len)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
+    NPS_IRQ_FLAGS_T                 irq_flags;
+    BOOL_T                          recycled = FALSE;
+
+    if ((len == ptr_rx_cb->buf_len) && (NULL != ptr_rx_pdma->ptr_recycle_buf))
+    {
+        /* restore the whole buffer, the packet len was set on Rx */
+        ptr_skb->len = len;
+        skb_set_tail_pointer(ptr_skb, len);
+
+        osal_takeIsrLock(&ptr_rx_pdma->recycle_lock, &irq_flags);
+        if (ptr_rx_pdma->recycle_cnt < ptr_rx_pdma->gpd_num)
+        {
+            ptr_rx_pdma->ptr_recycle_buf[ptr_rx_pdma->recycle_cnt].ptr_skb  = ptr_skb;
+            ptr_rx_pdma->ptr_recycle_buf[ptr_rx_pdma->recycle_cnt].phy_addr = phy_addr;
+            ptr_rx_pdma->recycle_cnt++;
+            recycled = TRUE;
+        }
+        osal_giveIsrLock(&ptr_rx_pdma->recycle_lock, &irq_flags);
+    }
+
+    if (FALSE == recycled)
+    {
+        osal_skb_unmapDma(phy_addr, len, DMA_FROM_DEVICE);
+        osal_skb_free(ptr_skb);
+    }
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_getRecycleRxBuf
+ * PURPOSE:
+ *      To take a DMA mapped RX payload buffer from the recycle stack.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The target RX channel
+ * OUTPUT:
+ *      pptr_skb        --  The payload buffer
+ *      ptr_phy_addr    --  The DMA address of the buffer
+ * RETURN:
+ *      NPS_E_OK        --  Successfully take a buffer.
+ *      NPS_E_OTHERS    --  The recycle stack is empty.
+ * NOTES:
+ *      None
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_getRecycleRxBuf(
+    const UI32_T                    unit,
+    const UI32_T                    channel,
+    struct sk_buff                  **pptr_skb,
+    NPS_ADDR_T                      *ptr_phy_addr)
+{
+    NPS_ERROR_NO_T                  rc = NPS_E_OTHERS;
+    HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
+    NPS_IRQ_FLAGS_T                 irq_flags;
+
+    osal_takeIsrLock(&ptr_rx_pdma->recycle_lock, &irq_flags);
+    if (0 != ptr_rx_pdma->recycle_cnt)
+    {
+        ptr_rx_pdma->recycle_cnt--;
+        *pptr_skb     = ptr_rx_pdma->ptr_recycle_buf[ptr_rx_pdma->recycle_cnt].ptr_skb;
+        *ptr_phy_addr = ptr_rx_pdma->ptr_recycle_buf[ptr_rx_pdma->recycle_cnt].phy_addr;
+        rc = NPS_E_OK;
+    }
+    osal_giveIsrLock(&ptr_rx_pdma->recycle_lock, &irq_flags);
+
+    return (rc);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_drainRecycleRxBuf
+ * PURPOSE:
+ *      To unmap and free all the buffers of the recycle stack.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The target RX channel
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      Called when Rx is stopped since the buffer size may be changed
+ *      before Rx is started again.
+ */
+static void
+_hal_tau_pkt_drainRecycleRxBuf(
+    const UI32_T                    unit,
+    const UI32_T                    channel)
+{
+    struct sk_buff                  *ptr_skb = NULL;
+    NPS_ADDR_T                      phy_addr = 0;
+
+    while (NPS_E_OK == _hal_tau_pkt_getRecycleRxBuf(unit, channel, &ptr_skb, &phy_addr))
+    {
+        osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+        osal_skb_free(ptr_skb);
+    }
+}
+
 /* FUNCTION NAME: _hal_tau_pkt_allocRxPayloadBuf
  * PURPOSE:
  *      To allocate the RX packet payload buffer for the GPD.
@@ -1475,7 +1752,8 @@ _hal_tau_pkt_getQueueCount(
  *      NPS_E_OK        --  Successfully allocate the buffer.
  *      NPS_E_NO_MEMORY --  Allocate the buffer failed.
  * NOTES:
- *      None
+ *      A recycled buffer which is still DMA mapped is used if any, a new
+ *      buffer is allocated and mapped otherwise.
  */
 static NPS_ERROR_NO_T
 _hal_tau_pkt_allocRxPayloadBuf(
@@ -1491,8 +1769,14 @@ _hal_tau_pkt_allocRxPayloadBuf(
     HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
     struct sk_buff                  *ptr_skb = NULL;
 
-    ptr_skb = osal_skb_alloc(ptr_rx_cb->buf_len);
-    if (NULL != ptr_skb)
+    if (NPS_E_OK == _hal_tau_pkt_getRecycleRxBuf(unit, channel, &ptr_skb, &phy_addr))
+    {
+        /* give the buffer back to the device */
+        osal_skb_syncDmaForDevice(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+        ptr_rx_pdma->pptr_skb_ring[gpd_idx] = ptr_skb;
+        rc = NPS_E_OK;
+    }
+    else if (NULL != (ptr_skb = osal_skb_alloc(ptr_rx_cb->buf_len)))
     {
         /* map skb to dma */
         phy_addr = osal_skb_mapDma(ptr_skb, DMA_FROM_DEVICE);
@@ -1578,7 +1862,8 @@ _hal_tau_pkt_freeRxPayloadBuf(
  * RETURN:
  *      NPS_E_OK        --  Successfully free the buffer.
  * NOTES:
- *      None
+ *      The buffer must still be DMA mapped, it is recycled to refill the
+ *      GPD ring of its RX channel.
  */
 static NPS_ERROR_NO_T
 _hal_tau_pkt_freeRxPayloadBufGpd(
@@ -1594,7 +1879,8 @@ _hal_tau_pkt_freeRxPayloadBufGpd(
     if (0x0 != phy_addr)
     {
         ptr_skb = ptr_sw_gpd->ptr_cookie;
-        osal_skb_free(ptr_skb);
+        _hal_tau_pkt_putRecycleRxBuf(unit, ptr_sw_gpd->channel, ptr_skb, phy_addr,
+                                     ptr_sw_gpd->rx_gpd.avbl_buf_len);
         rc = NPS_E_OK;
     }
 
@@ -1767,148 +2053,345 @@ _hal_tau_pkt_deinitRxPdmaRingBuf(
     return (rc);
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_recoverTxPdma
+/* FUNCTION NAME: _hal_tau_pkt_updateRecoverTime
  * PURPOSE:
- *      To recover the PDMA status to the initial state.
+ *      To record the duration of a PDMA error recovery.
  * INPUT:
- *      unit            --  The unit ID
- *      channel         --  The target TX channel
+ *      start_time      --  The time when the recovery started in us
  * OUTPUT:
- *      None
+ *      ptr_last_us     --  The duration of the last recovery in us
+ *      ptr_max_us      --  The longest duration of the recoveries in us
  * RETURN:
- *      NPS_E_OK        --  Successfully recover PDMA.
+ *      None
  * NOTES:
- *
+ *      None
  */
-static NPS_ERROR_NO_T
-_hal_tau_pkt_recoverTxPdma(
-    const UI32_T                    unit,
-    const HAL_TAU_PKT_TX_CHANNEL_T  channel)
+static void
+_hal_tau_pkt_updateRecoverTime(
+    const NPS_TIME_T                start_time,
+    UI32_T                          *ptr_last_us,
+    UI32_T                          *ptr_max_us)
 {
-    NPS_ERROR_NO_T                  rc = NPS_E_OK;
-    HAL_TAU_PKT_TX_PDMA_T           *ptr_tx_pdma = HAL_TAU_PKT_GET_TX_PDMA_PTR(unit, channel);
-
-    /* Release the software GPD ring and configure it again. */
-    ptr_tx_pdma->used_idx     = 0;
-    ptr_tx_pdma->free_idx     = 0;
-    ptr_tx_pdma->used_gpd_num = 0;
-    ptr_tx_pdma->free_gpd_num = ptr_tx_pdma->gpd_num;
-
-    _hal_tau_pkt_stopTxChannelReg(unit, channel);
-    rc = _hal_tau_pkt_initTxPdmaRing(unit, channel);
-    _hal_tau_pkt_startTxChannelReg(unit, channel, 0);
+    NPS_TIME_T                      end_time = 0;
 
-    return (rc);
+    osal_getTime(&end_time);
+    *ptr_last_us = end_time - start_time;
+    if (*ptr_last_us > *ptr_max_us)
+    {
+        *ptr_max_us = *ptr_last_us;
+    }
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_recoverRxPdma
+/* FUNCTION NAME: _hal_tau_pkt_swapTxGpd
  * PURPOSE:
- *      To recover the RX PDMA from the error state.
+ *      To swap two GPDs of the TX GPD ring with their SW-GPDs.
  * INPUT:
  *      unit            --  The unit ID
- *      channel         --  The target RX channel
+ *      channel         --  The target TX channel
+ *      idx_a           --  The index of the first GPD
+ *      idx_b           --  The index of the second GPD
  * OUTPUT:
  *      None
  * RETURN:
- *      NPS_E_OK        --  Successfully recovery the PDMA.
- * NOTES:
  *      None
+ * NOTES:
+ *      The channel must be stopped, the cache is not maintained here.
  */
-static NPS_ERROR_NO_T
-_hal_tau_pkt_recoverRxPdma(
+static void
+_hal_tau_pkt_swapTxGpd(
     const UI32_T                    unit,
-    const HAL_TAU_PKT_RX_CHANNEL_T  channel)
+    const HAL_TAU_PKT_TX_CHANNEL_T  channel,
+    const UI32_T                    idx_a,
+    const UI32_T                    idx_b)
 {
-    NPS_ERROR_NO_T                  rc = NPS_E_OK;
-    HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
+    HAL_TAU_PKT_TX_PDMA_T           *ptr_tx_pdma = HAL_TAU_PKT_GET_TX_PDMA_PTR(unit, channel);
+    HAL_TAU_PKT_TX_SW_GPD_T         *ptr_sw_gpd = NULL;
+    HAL_TAU_PKT_TX_GPD_T            tx_gpd;
 
-    /* Release the software GPD ring and configure it again. */
-    ptr_rx_pdma->cur_idx = 0;
+    osal_memcpy(&tx_gpd, (void *)HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, idx_a),
+                sizeof(HAL_TAU_PKT_TX_GPD_T));
+    osal_memcpy((void *)HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, idx_a),
+                (void *)HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, idx_b),
+                sizeof(HAL_TAU_PKT_TX_GPD_T));
+    osal_memcpy((void *)HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, idx_b), &tx_gpd,
+                sizeof(HAL_TAU_PKT_TX_GPD_T));
 
-    _hal_tau_pkt_stopRxChannelReg(unit, channel);
-    rc = _hal_tau_pkt_deinitRxPdmaRingBuf(unit, channel);
-    if (NPS_E_OK != rc)
-    {
-        return (rc);
-    }
-    rc = _hal_tau_pkt_initRxPdmaRing(unit, channel);
-    if (NPS_E_OK != rc)
-    {
-        return (rc);
-    }
-    rc = _hal_tau_pkt_initRxPdmaRingBuf(unit, channel);
-    if (NPS_E_OK != rc)
+    if (NULL != ptr_tx_pdma->pptr_sw_gpd_ring)
     {
-        return (rc);
+        ptr_sw_gpd = ptr_tx_pdma->pptr_sw_gpd_ring[idx_a];
+        ptr_tx_pdma->pptr_sw_gpd_ring[idx_a] = ptr_tx_pdma->pptr_sw_gpd_ring[idx_b];
+        ptr_tx_pdma->pptr_sw_gpd_ring[idx_b] = ptr_sw_gpd;
     }
-    _hal_tau_pkt_startRxChannelReg(unit, channel, ptr_rx_pdma->gpd_num);
-
-    return (rc);
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_freeTxGpdList
+/* FUNCTION NAME: _hal_tau_pkt_reverseTxGpd
  * PURPOSE:
- *      To free the TX SW GPD link list.
+ *      To reverse the order of a range of the TX GPD ring.
  * INPUT:
  *      unit            --  The unit ID
- *      ptr_sw_gpd      --  The pointer of TX SW GPD
+ *      channel         --  The target TX channel
+ *      first_idx       --  The index of the first GPD of the range
+ *      last_idx        --  The index of the last GPD of the range
  * OUTPUT:
  *      None
  * RETURN:
- *      NPS_E_OK        --  Successfully free the GPD list.
+ *      None
  * NOTES:
  *      None
  */
 static void
-_hal_tau_pkt_freeTxGpdList(
-    UI32_T                          unit,
-    HAL_TAU_PKT_TX_SW_GPD_T         *ptr_sw_gpd)
+_hal_tau_pkt_reverseTxGpd(
+    const UI32_T                    unit,
+    const HAL_TAU_PKT_TX_CHANNEL_T  channel,
+    UI32_T                          first_idx,
+    UI32_T                          last_idx)
 {
-    HAL_TAU_PKT_TX_SW_GPD_T         *ptr_sw_gpd_cur = NULL;
-
-    while (NULL != ptr_sw_gpd)
+    while (first_idx < last_idx)
     {
-        ptr_sw_gpd_cur = ptr_sw_gpd;
-        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
-        osal_free(ptr_sw_gpd_cur);
+        _hal_tau_pkt_swapTxGpd(unit, channel, first_idx, last_idx);
+        first_idx++;
+        last_idx--;
     }
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_freeRxGpdList
+/* FUNCTION NAME: _hal_tau_pkt_recoverTxPdma
  * PURPOSE:
- *      To free the RX SW GPD link list.
+ *      To recover the TX PDMA from the error state.
  * INPUT:
  *      unit            --  The unit ID
- *      ptr_sw_gpd      --  The pointer of RX SW GPD
- *      free_payload    --  TRUE: To free the buf in SDK, FALSE: in user process.
+ *      channel         --  The target TX channel
  * OUTPUT:
  *      None
  * RETURN:
- *      NPS_E_OK        --  Successfully recovery the PDMA.
+ *      NPS_E_OK        --  Successfully recover PDMA.
  * NOTES:
- *      None
+ *      1. The packet at free_idx is the one HW stopped at, its GPDs are dropped.
+ *         For ASYNC mode, the caller should take its SW-GPD out of the ring.
+ *      2. The unsent GPDs after it are rotated to the start of the ring, where
+ *         the channel restarts, and they are sent again without being rebuilt.
  */
 static NPS_ERROR_NO_T
-_hal_tau_pkt_freeRxGpdList(
-    UI32_T                          unit,
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd,
-    BOOL_T                          free_payload)
+_hal_tau_pkt_recoverTxPdma(
+    const UI32_T                    unit,
+    const HAL_TAU_PKT_TX_CHANNEL_T  channel)
 {
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd_cur = NULL;
+    NPS_ERROR_NO_T                  rc = NPS_E_OK;
+    HAL_TAU_PKT_TX_CB_T             *ptr_tx_cb = HAL_TAU_PKT_GET_TX_CB_PTR(unit);
+    HAL_TAU_PKT_TX_PDMA_T           *ptr_tx_pdma = HAL_TAU_PKT_GET_TX_PDMA_PTR(unit, channel);
+    volatile HAL_TAU_PKT_TX_GPD_T   *ptr_tx_gpd = NULL;
+    NPS_ADDR_T                      phy_addr = 0;
+    NPS_TIME_T                      start_time = 0;
+    UI32_T                          gpd_idx = 0;
+    UI32_T                          first_idx = 0;
+    UI32_T                          drop_gpd_num = 0;
+    UI32_T                          requeue_gpd_num = 0;
 
-    while (NULL != ptr_sw_gpd)
+    osal_getTime(&start_time);
+    _hal_tau_pkt_stopTxChannelReg(unit, channel);
+
+    for (gpd_idx = 0; gpd_idx < ptr_tx_pdma->gpd_num; gpd_idx++)
     {
-        ptr_sw_gpd_cur = ptr_sw_gpd;
-        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
-        if (TRUE == free_payload)
-        {
-            _hal_tau_pkt_freeRxPayloadBufGpd(unit, ptr_sw_gpd_cur);
-        }
-        osal_free(ptr_sw_gpd_cur);
+        ptr_tx_gpd = HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, gpd_idx);
+        osal_dma_invalidateCache((void *)ptr_tx_gpd, sizeof(HAL_TAU_PKT_TX_GPD_T));
     }
 
-    return (NPS_E_OK);
-}
+    /* Drop the GPDs of the packet which HW stopped at. */
+    while (drop_gpd_num < ptr_tx_pdma->used_gpd_num)
+    {
+        gpd_idx = (ptr_tx_pdma->free_idx + drop_gpd_num) % ptr_tx_pdma->gpd_num;
+        ptr_tx_gpd = HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, gpd_idx);
+        drop_gpd_num++;
+        if (HAL_TAU_PKT_CH_LAST_GPD == ptr_tx_gpd->ch)
+        {
+            break;
+        }
+    }
+    requeue_gpd_num = ptr_tx_pdma->used_gpd_num - drop_gpd_num;
+
+    /* Rotate the unsent GPDs to the start of the ring. */
+    first_idx = (ptr_tx_pdma->free_idx + drop_gpd_num) % ptr_tx_pdma->gpd_num;
+    if ((0 != first_idx) && (0 != requeue_gpd_num))
+    {
+        _hal_tau_pkt_reverseTxGpd(unit, channel, 0, first_idx - 1);
+        _hal_tau_pkt_reverseTxGpd(unit, channel, first_idx, ptr_tx_pdma->gpd_num - 1);
+        _hal_tau_pkt_reverseTxGpd(unit, channel, 0, ptr_tx_pdma->gpd_num - 1);
+    }
+
+    /* Release the other GPDs to SW. */
+    for (gpd_idx = 0; gpd_idx < ptr_tx_pdma->gpd_num; gpd_idx++)
+    {
+        ptr_tx_gpd = HAL_TAU_PKT_GET_TX_GPD_PTR(unit, channel, gpd_idx);
+        if (gpd_idx >= requeue_gpd_num)
+        {
+            osal_memset((void *)ptr_tx_gpd, 0x0, sizeof(HAL_TAU_PKT_TX_GPD_T));
+            ptr_tx_gpd->ioc = HAL_TAU_PKT_IOC_HAS_INTR;
+            ptr_tx_gpd->ch  = HAL_TAU_PKT_CH_LAST_GPD;
+            ptr_tx_gpd->hwo = HAL_TAU_PKT_HWO_SW_OWN;
+        }
+        osal_dma_flushCache((void *)ptr_tx_gpd, sizeof(HAL_TAU_PKT_TX_GPD_T));
+    }
+
+    ptr_tx_pdma->used_idx     = requeue_gpd_num % ptr_tx_pdma->gpd_num;
+    ptr_tx_pdma->free_idx     = 0;
+    ptr_tx_pdma->used_gpd_num = requeue_gpd_num;
+    ptr_tx_pdma->free_gpd_num = ptr_tx_pdma->gpd_num - requeue_gpd_num;
+    ptr_tx_pdma->pend_gpd_num = 0;
+
+    phy_addr = osal_dma_convertVirtToPhy(ptr_tx_pdma->ptr_gpd_align_start_addr);
+    rc = _hal_tau_pkt_setTxGpdStartAddrReg(unit, channel, phy_addr, ptr_tx_pdma->gpd_num);
+    _hal_tau_pkt_startTxChannelReg(unit, channel, requeue_gpd_num);
+
+    ptr_tx_cb->cnt.channel[channel].err_recover_drop    += drop_gpd_num;
+    ptr_tx_cb->cnt.channel[channel].err_recover_requeue += requeue_gpd_num;
+    _hal_tau_pkt_updateRecoverTime(start_time,
+                                   &ptr_tx_cb->cnt.channel[channel].err_recover_last_us,
+                                   &ptr_tx_cb->cnt.channel[channel].err_recover_max_us);
+
+    return (rc);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_recoverRxPdma
+ * PURPOSE:
+ *      To recover the RX PDMA from the error state.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The target RX channel
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        --  Successfully recovery the PDMA.
+ * NOTES:
+ *      Each GPD keeps its DMA mapped buffer, only the GPD is rewritten and
+ *      returned to HW. A new buffer is allocated only for a GPD without one.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_recoverRxPdma(
+    const UI32_T                    unit,
+    const HAL_TAU_PKT_RX_CHANNEL_T  channel)
+{
+    NPS_ERROR_NO_T                  rc = NPS_E_OK;
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
+    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd = NULL;
+    NPS_ADDR_T                      phy_addr = 0;
+    NPS_TIME_T                      start_time = 0;
+    UI32_T                          gpd_idx = 0;
+
+    osal_getTime(&start_time);
+    _hal_tau_pkt_stopRxChannelReg(unit, channel);
+
+    /* Rewrite the GPDs with their own buffers and configure the ring again. */
+    ptr_rx_pdma->cur_idx = 0;
+
+    for (gpd_idx = 0; gpd_idx < ptr_rx_pdma->gpd_num; gpd_idx++)
+    {
+        ptr_rx_gpd = HAL_TAU_PKT_GET_RX_GPD_PTR(unit, channel, gpd_idx);
+        osal_dma_invalidateCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+
+        phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
+        osal_memset((void *)ptr_rx_gpd, 0x0, sizeof(HAL_TAU_PKT_RX_GPD_T));
+
+        if ((0x0 != phy_addr) && (NULL != ptr_rx_pdma->pptr_skb_ring[gpd_idx]))
+        {
+            ptr_rx_gpd->data_buf_addr_hi = NPS_ADDR_64_HI(phy_addr);
+            ptr_rx_gpd->data_buf_addr_lo = NPS_ADDR_64_LOW(phy_addr);
+            ptr_rx_gpd->avbl_buf_len     = ptr_rx_cb->buf_len;
+        }
+        else
+        {
+            rc = _hal_tau_pkt_allocRxPayloadBuf(unit, channel, gpd_idx);
+            if (NPS_E_OK != rc)
+            {
+                ptr_rx_cb->cnt.no_memory++;
+                break;
+            }
+        }
+
+        ptr_rx_gpd->ioc = HAL_TAU_PKT_IOC_HAS_INTR;
+        ptr_rx_gpd->hwo = HAL_TAU_PKT_HWO_HW_OWN;
+        osal_dma_flushCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+    }
+
+    if (NPS_E_OK == rc)
+    {
+        phy_addr = osal_dma_convertVirtToPhy(ptr_rx_pdma->ptr_gpd_align_start_addr);
+        rc = _hal_tau_pkt_setRxGpdStartAddrReg(unit, channel, phy_addr, ptr_rx_pdma->gpd_num);
+    }
+    if (NPS_E_OK == rc)
+    {
+        _hal_tau_pkt_startRxChannelReg(unit, channel, ptr_rx_pdma->gpd_num);
+    }
+
+    _hal_tau_pkt_updateRecoverTime(start_time,
+                                   &ptr_rx_cb->cnt.channel[channel].err_recover_last_us,
+                                   &ptr_rx_cb->cnt.channel[channel].err_recover_max_us);
+
+    return (rc);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_freeTxGpdList
+ * PURPOSE:
+ *      To free the TX SW GPD link list.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      ptr_sw_gpd      --  The pointer of TX SW GPD
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        --  Successfully free the GPD list.
+ * NOTES:
+ *      None
+ */
+static void
+_hal_tau_pkt_freeTxGpdList(
+    UI32_T                          unit,
+    HAL_TAU_PKT_TX_SW_GPD_T         *ptr_sw_gpd)
+{
+    HAL_TAU_PKT_TX_SW_GPD_T         *ptr_sw_gpd_cur = NULL;
+
+    while (NULL != ptr_sw_gpd)
+    {
+        ptr_sw_gpd_cur = ptr_sw_gpd;
+        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+        osal_free(ptr_sw_gpd_cur);
+    }
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_freeRxGpdList
+ * PURPOSE:
+ *      To free the RX SW GPD link list.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      ptr_sw_gpd      --  The pointer of RX SW GPD
+ *      free_payload    --  TRUE: To free the buf in SDK, FALSE: in user process.
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        --  Successfully recovery the PDMA.
+ * NOTES:
+ *      None
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_freeRxGpdList(
+    UI32_T                          unit,
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd,
+    BOOL_T                          free_payload)
+{
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd_cur = NULL;
+
+    while (NULL != ptr_sw_gpd)
+    {
+        ptr_sw_gpd_cur = ptr_sw_gpd;
+        ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+        if (TRUE == free_payload)
+        {
+            _hal_tau_pkt_freeRxPayloadBufGpd(unit, ptr_sw_gpd_cur);
+        }
+        osal_free(ptr_sw_gpd_cur);
+    }
+
+    return (NPS_E_OK);
+}
 
 /* ----------------------------------------------------------------------------------- pkt_drv */
 /* FUNCTION NAME: _hal_tau_pkt_txEnQueueBulk
@@ -2044,6 +2527,8 @@ _hal_tau_pkt_rxCheckReason(
     UI32_T                          bitval = 0;
     UI32_T                          bitmap = 0x0;
 
+    *ptr_hit_prof = FALSE;
+
     if (0 == (ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON))
     {
         /* It means that reason doesn't metters */
@@ -2147,19 +2632,27 @@ _hal_tau_pkt_comparePatternWithPayload(
     NPS_ADDR_T                      phy_addr = 0;
     UI8_T                           *ptr_virt_addr = NULL;
     UI32_T                          idx;
+    UI32_T                          payload, pattern, mask;
 
     /* Get the packet payload */
     phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
     ptr_virt_addr = (C8_T *) osal_dma_convertPhyToVirt(phy_addr);
 
-    for (idx=0; idx<NPS_NETIF_PROFILE_PATTERN_LEN; idx++)
+#if (0 != (NPS_NETIF_PROFILE_PATTERN_LEN % 4))
+#error "NPS_NETIF_PROFILE_PATTERN_LEN must be a multiple of word size"
+#endif
+
+    for (idx=0; idx<NPS_NETIF_PROFILE_PATTERN_LEN; idx+=sizeof(UI32_T))
     {
-        /* per-byte comparison  */
-        if ((ptr_virt_addr[offset+idx] & ptr_mask[idx]) != (ptr_pattern[idx] & ptr_mask[idx]))
+        /* per-word comparison, the payload offset may be unaligned */
+        memcpy(&payload, &ptr_virt_addr[offset+idx], sizeof(UI32_T));
+        memcpy(&pattern, &ptr_pattern[idx], sizeof(UI32_T));
+        memcpy(&mask, &ptr_mask[idx], sizeof(UI32_T));
+        if (0 != ((payload ^ pattern) & mask))
         {
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
-                            "prof match failed, byte idx=%d, pattern=0x%02X != 0x%02X, mask=0x%02X\n",
-                            offset+idx, ptr_pattern[idx], ptr_virt_addr[offset+idx], ptr_mask[idx]);
+                            "prof match failed, byte idx=%d, pattern=0x%08X != 0x%08X, mask=0x%08X\n",
+                            offset+idx, pattern, payload, mask);
             return (FALSE);
         }
     }
@@ -2218,21 +2711,72 @@ _hal_tau_pkt_rxCheckPattern(
     }
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_isProfNodeBefore
+ * PURPOSE:
+ *      To compare the order of two profile nodes in the profile list.
+ * INPUT:
+ *      ptr_node_a      -- Pointer of the first node
+ *      ptr_node_b      -- Pointer of the second node
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      TRUE            -- ptr_node_a is checked before ptr_node_b.
+ *      FALSE           -- ptr_node_b is checked before ptr_node_a.
+ * NOTES:
+ *      The profiles with the same priority are checked in the order of creation.
+ */
+static BOOL_T
+_hal_tau_pkt_isProfNodeBefore(
+    const HAL_TAU_PKT_PROFILE_NODE_T    *ptr_node_a,
+    const HAL_TAU_PKT_PROFILE_NODE_T    *ptr_node_b)
+{
+    if (ptr_node_a->ptr_profile->priority != ptr_node_b->ptr_profile->priority)
+    {
+        return ((ptr_node_a->ptr_profile->priority < ptr_node_b->ptr_profile->priority)? TRUE : FALSE);
+    }
+
+    return ((ptr_node_a->order < ptr_node_b->order)? TRUE : FALSE);
+}
+
 static void
 _hal_tau_pkt_matchUserProfile(
     volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd,
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_profile_list,
+    HAL_TAU_PKT_NETIF_PORT_DB_T     *ptr_port_db,
     HAL_TAU_PKT_NETIF_PROFILE_T     **pptr_profile_hit)
 {
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_curr_node = ptr_profile_list;
+    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_rsn_node = NULL;
+    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_generic_node = ptr_port_db->ptr_generic_list;
+    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_curr_node;
     BOOL_T                          hit;
 
     *pptr_profile_hit = NULL;
 
-    while (NULL != ptr_curr_node)
+    /* Only the profiles of the IPP reason code carried by the packet are candidates */
+    if (HAL_TAU_PKT_TMH_TYPE_ITMH_ETH == ptr_rx_gpd->itmh_eth.typ)
     {
-        /* 1st match reason */
-        _hal_tau_pkt_rxCheckReason(ptr_rx_gpd, ptr_curr_node->ptr_profile, &hit);
+        ptr_rsn_node = ptr_port_db->ptr_rsn_list[ptr_rx_gpd->itmh_eth.cp_to_cpu_code];
+    }
+
+    /* Merge the reason list and the generic list in priority order */
+    while ((NULL != ptr_rsn_node) || (NULL != ptr_generic_node))
+    {
+        if ((NULL != ptr_rsn_node) &&
+            ((NULL == ptr_generic_node) ||
+             (TRUE == _hal_tau_pkt_isProfNodeBefore(ptr_rsn_node, ptr_generic_node))))
+        {
+            /* 1st match reason, it has been done by the index */
+            ptr_curr_node = ptr_rsn_node;
+            ptr_rsn_node = ptr_rsn_node->ptr_next_node;
+            hit = TRUE;
+        }
+        else
+        {
+            /* 1st match reason */
+            ptr_curr_node = ptr_generic_node;
+            ptr_generic_node = ptr_generic_node->ptr_next_node;
+            _hal_tau_pkt_rxCheckReason(ptr_rx_gpd, ptr_curr_node->ptr_profile, &hit);
+        }
+
         if (TRUE == hit)
         {
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
@@ -2251,7 +2795,6 @@ _hal_tau_pkt_matchUserProfile(
         }
 
         /* Seach the next profile (priority lower) */
-        ptr_curr_node = ptr_curr_node->ptr_next_node;
     }
 }
 
@@ -2262,14 +2805,12 @@ _hal_tau_pkt_getPacketDest(
     void                            **pptr_cookie)
 {
     UI32_T                          port;
-    HAL_TAU_PKT_PROFILE_NODE_T      *ptr_profile_list;
     HAL_TAU_PKT_NETIF_PROFILE_T     *ptr_profile_hit;
 
     port = ptr_rx_gpd->itmh_eth.igr_phy_port;
-    ptr_profile_list = HAL_TAU_PKT_GET_PORT_PROFILE_LIST(port);
 
     _hal_tau_pkt_matchUserProfile(ptr_rx_gpd,
-                                  ptr_profile_list,
+                                  HAL_TAU_PKT_GET_PORT_DB(port),
                                   &ptr_profile_hit);
     if (NULL != ptr_profile_hit)
     {
@@ -2326,6 +2867,11 @@ _hal_tau_pkt_rxEnQueue(
     struct sk_buff                  *ptr_skb = NULL, *ptr_merge_skb = NULL;
     UI32_T                          copy_offset;
     void                            *ptr_dest;
+    UI32_T                          que_cnt = 0;
+    BOOL_T                          copy_pkt = FALSE;
+#if defined(PERF_EN_TEST)
+    UI32_T                          perf_ts = ptr_sw_gpd->perf_ts;
+#endif
 
 #if defined(PERF_EN_TEST)
     /* To verify kernel Rx performance */
@@ -2338,9 +2884,9 @@ _hal_tau_pkt_rxEnQueue(
 
             total_len += len;
 
-            /* unmap dma */
+            /* the buffers are recycled below */
             phy_addr = NPS_ADDR_32_TO_64(ptr_sw_gpd->rx_gpd.data_buf_addr_hi, ptr_sw_gpd->rx_gpd.data_buf_addr_lo);
-            osal_skb_unmapDma(phy_addr, len, DMA_FROM_DEVICE);
+            osal_skb_syncDmaForCpu(phy_addr, len, DMA_FROM_DEVICE);
             /* next */
             ptr_sw_gpd = ptr_sw_gpd->ptr_next;
         }
@@ -2359,6 +2905,12 @@ _hal_tau_pkt_rxEnQueue(
     if (HAL_TAU_PKT_DEST_NETDEV == dest_type)
 #endif
     {
+        /* the packets merged from multiple gpd or not longer than rx_copybreak are
+         * copied to a new skb, and their buffers are recycled without DMA unmap
+         */
+        copy_pkt = ((NULL != ptr_sw_first_gpd->ptr_next) ||
+                    (ptr_sw_first_gpd->rx_gpd.cnsm_buf_len <= rx_copybreak + ETH_FCS_LEN)) ? TRUE : FALSE;
+
         /* need to encap the packet as skb */
         ptr_sw_gpd = ptr_sw_first_gpd;
         while (NULL != ptr_sw_gpd)
@@ -2377,7 +2929,14 @@ _hal_tau_pkt_rxEnQueue(
             /* note here ptr_skb->len is the total buffer size not means the actual Rx packet len
              * it should be updated later
              */
-            osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+            if (TRUE == copy_pkt)
+            {
+                osal_skb_syncDmaForCpu(phy_addr, len, DMA_FROM_DEVICE);
+            }
+            else
+            {
+                osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_FROM_DEVICE);
+            }
 
             /* reset ptr_skb->len with real packet len instead of total buffer size */
             if (NULL == ptr_sw_gpd->ptr_next)
@@ -2430,11 +2989,34 @@ _hal_tau_pkt_rxEnQueue(
                 HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_ERR | HAL_TAU_PKT_DBG_RX),
                                 "u=%u, rxch=%u, alloc skb failed, size=%u\n",
                                 unit, channel, (total_len - ETH_FCS_LEN));
+                ptr_rx_cb->cnt.no_memory++;
+                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+                return;
             }
 
-            /* free both sw_gpd and the skb attached on it */
+            /* free both sw_gpd and recycle the skb attached on it */
             _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
         }
+        else if (TRUE == copy_pkt)
+        {
+            ptr_merge_skb = osal_skb_alloc(ptr_skb->len);
+            if (NULL != ptr_merge_skb)
+            {
+                memcpy(ptr_merge_skb->data, ptr_skb->data, ptr_skb->len);
+                ptr_skb = ptr_merge_skb;
+
+                /* free both sw_gpd and recycle the skb attached on it */
+                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+            }
+            else
+            {
+                /* send the original buffer */
+                phy_addr = NPS_ADDR_32_TO_64(ptr_sw_first_gpd->rx_gpd.data_buf_addr_hi,
+                                             ptr_sw_first_gpd->rx_gpd.data_buf_addr_lo);
+                osal_skb_unmapDma(phy_addr, ptr_sw_first_gpd->rx_gpd.avbl_buf_len, DMA_FROM_DEVICE);
+                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, FALSE);
+            }
+        }
         else
         {
             /* free only sw_gpd */
@@ -2462,7 +3044,17 @@ _hal_tau_pkt_rxEnQueue(
         {
             /* skip ethernet header only for Linux net interface*/
             ptr_skb->protocol = eth_type_trans(ptr_skb, ptr_net_dev);
-            osal_skb_recv(ptr_skb);
+            if (TRUE == ptr_rx_cb->napi_mode)
+            {
+                napi_gro_receive(&ptr_rx_cb->napi[channel].napi, ptr_skb);
+            }
+            else
+            {
+                osal_skb_recv(ptr_skb);
+            }
+#if defined(PERF_EN_TEST)
+            perf_rxLatency(PERF_LAT_SKB, perf_ts);
+#endif
 #if LINUX_VERSION_CODE < KERNEL_VERSION(4, 11, 0)
             ptr_net_dev->last_rx = jiffies;
 #endif
@@ -2483,10 +3075,35 @@ _hal_tau_pkt_rxEnQueue(
     }
     else if (HAL_TAU_PKT_DEST_SDK == dest_type)
     {
-        while (0 != _hal_tau_pkt_enQueue(&ptr_rx_cb->sw_queue[channel], ptr_sw_gpd))
+        /* bulk traps must not occupy the whole queue beyond the configured depth */
+        if (0 != ptr_rx_cb->sw_queue[channel].depth)
+        {
+            _hal_tau_pkt_getQueueCount(&ptr_rx_cb->sw_queue[channel], &que_cnt);
+            if (que_cnt >= ptr_rx_cb->sw_queue[channel].depth)
+            {
+                ptr_rx_cb->cnt.channel[channel].depth_drop++;
+                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+                return;
+            }
+        }
+
+        if (TRUE == ptr_rx_cb->napi_mode)
+        {
+            /* NAPI poll cannot sleep to wait for user space draining the queue */
+            if (0 != _hal_tau_pkt_enQueue(&ptr_rx_cb->sw_queue[channel], ptr_sw_gpd))
+            {
+                ptr_rx_cb->cnt.channel[channel].enque_drop++;
+                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd, TRUE);
+                return;
+            }
+        }
+        else
         {
-            ptr_rx_cb->cnt.channel[channel].enque_retry++;
-            HAL_TAU_PKT_RX_ENQUE_RETRY_SLEEP();
+            while (0 != _hal_tau_pkt_enQueue(&ptr_rx_cb->sw_queue[channel], ptr_sw_gpd))
+            {
+                ptr_rx_cb->cnt.channel[channel].enque_retry++;
+                HAL_TAU_PKT_RX_ENQUE_RETRY_SLEEP();
+            }
         }
         ptr_rx_cb->cnt.channel[channel].enque_ok++;
 
@@ -2510,156 +3127,453 @@ _hal_tau_pkt_flushRxQueue(
     const UI32_T                unit,
     HAL_TAU_PKT_SW_QUEUE_T      *ptr_que)
 {
-    HAL_TAU_PKT_RX_SW_GPD_T     *ptr_sw_gpd_knl = NULL;
-    NPS_ERROR_NO_T              rc;
+    HAL_TAU_PKT_RX_SW_GPD_T     *ptr_sw_gpd_knl[HAL_TAU_PKT_FLUSH_BULK_NUM];
+    UI32_T                      count = 0;
+    UI32_T                      idx;
 
-    while (1)
+    while (NPS_E_OK == _hal_tau_pkt_deQueueBulk(ptr_que, (void **)ptr_sw_gpd_knl,
+                                                HAL_TAU_PKT_FLUSH_BULK_NUM, &count))
     {
-        rc = _hal_tau_pkt_deQueue(ptr_que, (void **)&ptr_sw_gpd_knl);
-        if (NPS_E_OK == rc)
-        {
-            _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_gpd_knl, TRUE);
-        }
-        else
+        for (idx = 0; idx < count; idx++)
         {
-            break;
+            _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_gpd_knl[idx], TRUE);
         }
     }
 
     return (NPS_E_OK);
 }
 
-/* FUNCTION NAME: _hal_tau_pkt_schedRxDeQueue
+/* FUNCTION NAME: _hal_tau_pkt_copyRxPktToUser
  * PURPOSE:
- *      To dequeue the packets based on the configured algorithm.
+ *      To copy the GPDs and payload of a packet to the user buffers.
  * INPUT:
  *      unit            -- The unit ID
- *      ptr_cookie      -- Pointer of the RX cookie
+ *      ptr_sw_gpd_knl  -- Pointer for the SW Rx GPD link list
+ *      ioctl_gpd_addr  -- User address of the IOCTL GPD array
  * OUTPUT:
  *      None
  * RETURN:
- *      NPS_E_OK        -- Successfully dequeue the packets.
- * NOTES:
  *      None
+ * NOTES:
+ *      The SW Rx GPD link list is freed after copy.
  */
-static NPS_ERROR_NO_T
-_hal_tau_pkt_schedRxDeQueue(
+static void
+_hal_tau_pkt_copyRxPktToUser(
     const UI32_T                    unit,
-    HAL_TAU_PKT_IOCTL_RX_COOKIE_T   *ptr_cookie)
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd_knl,
+    const NPS_ADDR_T                ioctl_gpd_addr)
 {
-    HAL_TAU_PKT_IOCTL_RX_COOKIE_T   ioctl_data;
     HAL_TAU_PKT_IOCTL_RX_GPD_T      ioctl_gpd;
-    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd_knl = NULL;
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd_knl = NULL;
-    UI32_T                          que_cnt = 0;
-    UI32_T                          queue   = 0;
-    UI32_T                          idx     = 0;
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd_knl = ptr_sw_gpd_knl;
     UI32_T                          gpd_idx = 0;
     /* copy Rx sw_gpd */
     volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd = NULL;
     void                            *ptr_virt_addr = NULL;
     NPS_ADDR_T                      phy_addr = 0;
     UI32_T                          buf_len = 0;
-    NPS_ERROR_NO_T                  rc = NPS_E_OK;
 
-    /* normal process */
-    if (TRUE == ptr_rx_cb->running)
+#if defined(PERF_EN_TEST)
+    perf_rxLatency(PERF_LAT_USER, ptr_sw_gpd_knl->perf_ts);
+#endif
+
+    while (NULL != ptr_sw_gpd_knl)
+    {
+        /* get the IOCTL GPD from user */
+        osal_io_copyFromUser(&ioctl_gpd,
+                             ((void *)((NPS_HUGE_T)ioctl_gpd_addr))
+                                 + gpd_idx*sizeof(HAL_TAU_PKT_IOCTL_RX_GPD_T),
+                             sizeof(HAL_TAU_PKT_IOCTL_RX_GPD_T));
+
+        /* get knl buf addr */
+        ptr_rx_gpd = &ptr_sw_gpd_knl->rx_gpd;
+        phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
+
+        ptr_virt_addr = ptr_sw_gpd_knl->ptr_cookie;
+
+        buf_len = (HAL_TAU_PKT_CH_LAST_GPD == ptr_rx_gpd->ch)?
+            ptr_rx_gpd->cnsm_buf_len : ptr_rx_gpd->avbl_buf_len;
+
+        /* the buffer stays mapped and is recycled after copy */
+        osal_skb_syncDmaForCpu(phy_addr, buf_len, DMA_FROM_DEVICE);
+
+        /* overwrite whole rx_gpd to user
+         * the user should re-assign the correct value to data_buf_addr_hi, data_buf_addr_low
+         * after this IOCTL returns
+         */
+        osal_io_copyToUser((void *)((NPS_HUGE_T)ioctl_gpd.hw_gpd_addr),
+                           &ptr_sw_gpd_knl->rx_gpd,
+                           sizeof(HAL_TAU_PKT_RX_GPD_T));
+        /* copy buf */
+        /* DMA buf address allocated by the user is store in ptr_ioctl_data->gpd[idx].cookie */
+        osal_io_copyToUser((void *)((NPS_HUGE_T)ioctl_gpd.dma_buf_addr),
+                           ((struct sk_buff *)ptr_virt_addr)->data, buf_len);
+        ptr_sw_gpd_knl->ptr_cookie = ptr_virt_addr;
+
+        /* next */
+        ptr_sw_gpd_knl = ptr_sw_gpd_knl->ptr_next;
+        gpd_idx++;
+    }
+
+    /* Must free kernel sw_gpd */
+    _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd_knl, TRUE);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_selectRxQueue
+ * PURPOSE:
+ *      To select the next non-empty RX queue based on the scheduling mode.
+ * INPUT:
+ *      unit            -- The unit ID
+ * OUTPUT:
+ *      ptr_queue       -- The selected queue
+ * RETURN:
+ *      NPS_E_OK        -- Successfully select the queue.
+ *      NPS_E_OTHERS    -- All queues are empty.
+ * NOTES:
+ *      RR   -- One packet from each non-empty queue in turns.
+ *      WRR  -- Up to weight packets from each non-empty queue in turns.
+ *      SP   -- The non-empty queue with the largest weight, the smaller
+ *              queue wins the tie.
+ *      DWRR -- Up to weight * HAL_TAU_PKT_RX_SCHED_DWRR_QUANTUM bytes from each
+ *              non-empty queue in turns. The credit is carried to the next turn
+ *              and cleared once the queue becomes empty.
+ *      The credit is consumed by _hal_tau_pkt_chargeRxQueue() after dequeue.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_selectRxQueue(
+    const UI32_T                    unit,
+    UI32_T                          *ptr_queue)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_SW_QUEUE_T          *ptr_que = NULL;
+    UI32_T                          que_cnt[HAL_TAU_PKT_RX_QUEUE_NUM];
+    UI32_T                          queue = 0;
+    UI32_T                          idx   = 0;
+    BOOL_T                          found = FALSE;
+
+    for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
+    {
+        _hal_tau_pkt_getQueueCount(&ptr_rx_cb->sw_queue[queue], &que_cnt[queue]);
+        if (que_cnt[queue] > 0)
+        {
+            found = TRUE;
+        }
+        else if (HAL_TAU_PKT_RX_SCHED_DWRR == ptr_rx_cb->sched_mode)
+        {
+            ptr_rx_cb->sw_queue[queue].deficit = 0;
+        }
+    }
+
+    if (FALSE == found)
+    {
+        return (NPS_E_OTHERS);
+    }
+
+    found = FALSE;
+    if (HAL_TAU_PKT_RX_SCHED_SP == ptr_rx_cb->sched_mode)
+    {
+        for (idx = 0; idx < HAL_TAU_PKT_RX_QUEUE_NUM; idx++)
+        {
+            if ((que_cnt[idx] > 0) &&
+                ((FALSE == found) || (ptr_rx_cb->sw_queue[idx].weight > ptr_rx_cb->sw_queue[queue].weight)))
+            {
+                queue = idx;
+                found = TRUE;
+            }
+        }
+    }
+    else if ((HAL_TAU_PKT_RX_SCHED_WRR  == ptr_rx_cb->sched_mode) ||
+             (HAL_TAU_PKT_RX_SCHED_DWRR == ptr_rx_cb->sched_mode))
+    {
+        /* stay in the current queue until its credit is used up */
+        queue = ptr_rx_cb->deque_idx % HAL_TAU_PKT_RX_QUEUE_NUM;
+        if ((que_cnt[queue] > 0) && (ptr_rx_cb->sw_queue[queue].deficit > 0))
+        {
+            found = TRUE;
+        }
+
+        /* the overdrawn DWRR credit may take several rounds to be paid back */
+        for (idx = 1; (FALSE == found) &&
+             (idx <= (HAL_TAU_PKT_RX_SCHED_MAX_ROUND * HAL_TAU_PKT_RX_QUEUE_NUM)); idx++)
+        {
+            queue = ((ptr_rx_cb->deque_idx + idx) % HAL_TAU_PKT_RX_QUEUE_NUM);
+            if (0 == que_cnt[queue])
+            {
+                continue;
+            }
+
+            ptr_que = &ptr_rx_cb->sw_queue[queue];
+            if (HAL_TAU_PKT_RX_SCHED_WRR == ptr_rx_cb->sched_mode)
+            {
+                ptr_que->deficit = (I32_T)ptr_que->weight;
+            }
+            else
+            {
+                ptr_que->deficit += (I32_T)(ptr_que->weight * HAL_TAU_PKT_RX_SCHED_DWRR_QUANTUM);
+            }
+
+            if (ptr_que->deficit > 0)
+            {
+                found = TRUE;
+            }
+        }
+
+        if (TRUE == found)
+        {
+            ptr_rx_cb->deque_idx = queue;
+        }
+    }
+
+    /* RR, or no queue of WRR/DWRR has credit */
+    if (FALSE == found)
     {
-        /* get queue and count */
         for (idx = 0; idx < HAL_TAU_PKT_RX_QUEUE_NUM; idx++)
         {
-            /* to gurantee the opportunity where each queue can be handler */
+            /* to gurantee the opportunity where each queue can be handled */
             queue = ((ptr_rx_cb->deque_idx + idx) % HAL_TAU_PKT_RX_QUEUE_NUM);
-            _hal_tau_pkt_getQueueCount(&ptr_rx_cb->sw_queue[queue], &que_cnt);
-            if (que_cnt > 0)
+            if (que_cnt[queue] > 0)
             {
-                ptr_rx_cb->deque_idx = ((queue + 1) % HAL_TAU_PKT_RX_QUEUE_NUM);
                 break;
             }
         }
+        ptr_rx_cb->deque_idx = ((queue + 1) % HAL_TAU_PKT_RX_QUEUE_NUM);
+    }
+
+    *ptr_queue = queue;
+    return (NPS_E_OK);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_getRxQueueQuota
+ * PURPOSE:
+ *      To get the number of packets which can be dequeued at once from the
+ *      selected RX queue.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      queue           -- The queue selected by _hal_tau_pkt_selectRxQueue()
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The number of packets.
+ * NOTES:
+ *      The packet length is unknown before dequeue, so DWRR takes one packet
+ *      at a time.
+ */
+static UI32_T
+_hal_tau_pkt_getRxQueueQuota(
+    const UI32_T                    unit,
+    const UI32_T                    queue)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
 
-        /* If all of the queues are empty, wait rxTask event */
-        if (0 == que_cnt)
+    if (HAL_TAU_PKT_RX_SCHED_SP == ptr_rx_cb->sched_mode)
+    {
+        return (HAL_TAU_PKT_RX_DEQUE_BULK_NUM);
+    }
+    if ((HAL_TAU_PKT_RX_SCHED_WRR == ptr_rx_cb->sched_mode) &&
+        (ptr_rx_cb->sw_queue[queue].deficit > 0))
+    {
+        return ((UI32_T)ptr_rx_cb->sw_queue[queue].deficit);
+    }
+
+    return (1);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_chargeRxQueue
+ * PURPOSE:
+ *      To consume the credit of the RX queue by a dequeued packet.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      queue           -- The queue where the packet is dequeued
+ *      ptr_sw_gpd      -- Pointer for the SW Rx GPD link list of the packet
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      None
+ */
+static void
+_hal_tau_pkt_chargeRxQueue(
+    const UI32_T                    unit,
+    const UI32_T                    queue,
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    UI32_T                          len = 0;
+
+    if (HAL_TAU_PKT_RX_SCHED_WRR == ptr_rx_cb->sched_mode)
+    {
+        ptr_rx_cb->sw_queue[queue].deficit--;
+    }
+    else if (HAL_TAU_PKT_RX_SCHED_DWRR == ptr_rx_cb->sched_mode)
+    {
+        while (NULL != ptr_sw_gpd)
         {
-            osal_waitEvent(&ptr_rx_cb->sync_sema);
+            len += (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)?
+                ptr_sw_gpd->rx_gpd.cnsm_buf_len : ptr_sw_gpd->rx_gpd.avbl_buf_len;
+            ptr_sw_gpd = ptr_sw_gpd->ptr_next;
+        }
+        ptr_rx_cb->sw_queue[queue].deficit -= (I32_T)len;
+    }
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_waitRxQueue
+ * PURPOSE:
+ *      To find a non-empty RX queue, and wait rxTask event if all of them are empty.
+ * INPUT:
+ *      unit            -- The unit ID
+ * OUTPUT:
+ *      ptr_queue       -- The non-empty queue
+ * RETURN:
+ *      NPS_E_OK        -- Successfully find the queue.
+ *      NPS_E_OTHERS    -- All queues are empty, it means that all queues are flushed.
+ * NOTES:
+ *      The queue is selected by the configured scheduling mode.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_waitRxQueue(
+    const UI32_T                    unit,
+    UI32_T                          *ptr_queue)
+{
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+
+    if (NPS_E_OK == _hal_tau_pkt_selectRxQueue(unit, ptr_queue))
+    {
+        return (NPS_E_OK);
+    }
+
+    /* If all of the queues are empty, wait rxTask event */
+    osal_waitEvent(&ptr_rx_cb->sync_sema);
+
+    ptr_rx_cb->cnt.wait_event++;
 
-            ptr_rx_cb->cnt.wait_event++;
+    /* re-select the queue */
+    return (_hal_tau_pkt_selectRxQueue(unit, ptr_queue));
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_schedRxDeQueue
+ * PURPOSE:
+ *      To dequeue the packets based on the configured algorithm.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      ptr_cookie      -- Pointer of the RX cookie
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully dequeue the packets.
+ * NOTES:
+ *      None
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_schedRxDeQueue(
+    const UI32_T                    unit,
+    HAL_TAU_PKT_IOCTL_RX_COOKIE_T   *ptr_cookie)
+{
+    HAL_TAU_PKT_IOCTL_RX_COOKIE_T   ioctl_data;
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd_knl = NULL;
+    UI32_T                          queue   = 0;
+    NPS_ERROR_NO_T                  rc = NPS_E_OK;
 
-            /* re-get queue and count */
-            for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
-            {
-                _hal_tau_pkt_getQueueCount(&ptr_rx_cb->sw_queue[queue], &que_cnt);
-                if (que_cnt > 0)
-                {
-                    ptr_rx_cb->deque_idx = ((queue + 1) % HAL_TAU_PKT_RX_QUEUE_NUM);
-                    break;
-                }
-            }
-        }
+    /* normal process */
+    if (TRUE == ptr_rx_cb->running)
+    {
+        /* it means that all queue's are flush -> rx stop flow */
+        rc = _hal_tau_pkt_waitRxQueue(unit, &queue);
 
         /* deque */
-        if ((que_cnt > 0) && (queue < HAL_TAU_PKT_RX_QUEUE_NUM))
+        if (NPS_E_OK == rc)
         {
             rc = _hal_tau_pkt_deQueue(&ptr_rx_cb->sw_queue[queue], (void **)&ptr_sw_gpd_knl);
             if (NPS_E_OK == rc)
             {
                 ptr_rx_cb->cnt.channel[queue].deque_ok++;
-                ptr_sw_first_gpd_knl = ptr_sw_gpd_knl;
+                _hal_tau_pkt_chargeRxQueue(unit, queue, ptr_sw_gpd_knl);
 
                 osal_io_copyFromUser(&ioctl_data, ptr_cookie, sizeof(HAL_TAU_PKT_IOCTL_RX_COOKIE_T));
+                _hal_tau_pkt_copyRxPktToUser(unit, ptr_sw_gpd_knl, ioctl_data.ioctl_gpd_addr);
+            }
+            else
+            {
+                ptr_rx_cb->cnt.channel[queue].deque_fail++;
+            }
+        }
+    }
 
-                while (NULL != ptr_sw_gpd_knl)
-                {
-                    /* get the IOCTL GPD from user */
-                    osal_io_copyFromUser(&ioctl_gpd,
-                                         ((void *)((NPS_HUGE_T)ioctl_data.ioctl_gpd_addr))
-                                             + gpd_idx*sizeof(HAL_TAU_PKT_IOCTL_RX_GPD_T),
-                                         sizeof(HAL_TAU_PKT_IOCTL_RX_GPD_T));
-
-                    /* get knl buf addr */
-                    ptr_rx_gpd = &ptr_sw_gpd_knl->rx_gpd;
-                    phy_addr = NPS_ADDR_32_TO_64(ptr_rx_gpd->data_buf_addr_hi, ptr_rx_gpd->data_buf_addr_lo);
-
-                    ptr_virt_addr = ptr_sw_gpd_knl->ptr_cookie;
-                    osal_skb_unmapDma(phy_addr, ((struct sk_buff *)ptr_virt_addr)->len, DMA_FROM_DEVICE);
-
-                    buf_len = (HAL_TAU_PKT_CH_LAST_GPD == ptr_rx_gpd->ch)?
-                        ptr_rx_gpd->cnsm_buf_len : ptr_rx_gpd->avbl_buf_len;
+    return (rc);
+}
 
-                    /* overwrite whole rx_gpd to user
-                     * the user should re-assign the correct value to data_buf_addr_hi, data_buf_addr_low
-                     * after this IOCTL returns
-                     */
-                    osal_io_copyToUser((void *)((NPS_HUGE_T)ioctl_gpd.hw_gpd_addr),
-                                       &ptr_sw_gpd_knl->rx_gpd,
-                                       sizeof(HAL_TAU_PKT_RX_GPD_T));
-                    /* copy buf */
-                    /* DMA buf address allocated by the user is store in ptr_ioctl_data->gpd[idx].cookie */
-                    osal_io_copyToUser((void *)((NPS_HUGE_T)ioctl_gpd.dma_buf_addr),
-                                       ((struct sk_buff *)ptr_virt_addr)->data, buf_len);
-                    ptr_sw_gpd_knl->ptr_cookie = ptr_virt_addr;
+/* FUNCTION NAME: _hal_tau_pkt_schedRxDeQueueBulk
+ * PURPOSE:
+ *      To dequeue multiple packets in one IOCTL.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      ptr_cookie      -- Pointer of the RX bulk cookie
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully dequeue the packets.
+ *      NPS_E_OTHERS    -- No packet is dequeued.
+ * NOTES:
+ *      It waits only if all queues are empty, then dequeues up to pkt_num packets
+ *      from the queues selected by the scheduling mode.
+ *      pkt_num is updated with the number of dequeued packets.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_schedRxDeQueueBulk(
+    const UI32_T                        unit,
+    HAL_TAU_PKT_IOCTL_RX_BULK_COOKIE_T  *ptr_cookie)
+{
+    HAL_TAU_PKT_IOCTL_RX_BULK_COOKIE_T  ioctl_bulk;
+    HAL_TAU_PKT_IOCTL_RX_COOKIE_T       ioctl_data;
+    HAL_TAU_PKT_RX_CB_T                 *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_SW_GPD_T             *ptr_sw_gpd_knl[HAL_TAU_PKT_RX_DEQUE_BULK_NUM];
+    UI32_T                              queue = 0;
+    UI32_T                              pkt = 0;
+    UI32_T                              num = 0;
+    UI32_T                              count = 0;
+    UI32_T                              pkt_cnt = 0;
+    NPS_ERROR_NO_T                      rc = NPS_E_OTHERS;
 
-                    /* next */
-                    ptr_sw_gpd_knl = ptr_sw_gpd_knl->ptr_next;
-                    gpd_idx++;
-                }
+    osal_io_copyFromUser(&ioctl_bulk, ptr_cookie, sizeof(HAL_TAU_PKT_IOCTL_RX_BULK_COOKIE_T));
 
-                /* Must free kernel sw_gpd */
-                _hal_tau_pkt_freeRxGpdList(unit, ptr_sw_first_gpd_knl, TRUE);
+    /* normal process */
+    if ((TRUE == ptr_rx_cb->running) && (0 != ioctl_bulk.pkt_num) &&
+        (NPS_E_OK == _hal_tau_pkt_waitRxQueue(unit, &queue)))
+    {
+        do
+        {
+            num = _hal_tau_pkt_getRxQueueQuota(unit, queue);
+            num = ((ioctl_bulk.pkt_num - pkt_cnt) < num)? (ioctl_bulk.pkt_num - pkt_cnt) : num;
+            num = (HAL_TAU_PKT_RX_DEQUE_BULK_NUM < num)? HAL_TAU_PKT_RX_DEQUE_BULK_NUM : num;
+            if (NPS_E_OK != _hal_tau_pkt_deQueueBulk(&ptr_rx_cb->sw_queue[queue],
+                                                     (void **)ptr_sw_gpd_knl, num, &count))
+            {
+                break;
             }
-            else
+            ptr_rx_cb->cnt.channel[queue].deque_ok += count;
+
+            for (pkt = 0; pkt < count; pkt++, pkt_cnt++)
             {
-                ptr_rx_cb->cnt.channel[queue].deque_fail++;
+                _hal_tau_pkt_chargeRxQueue(unit, queue, ptr_sw_gpd_knl[pkt]);
+
+                /* each packet is copied to the GPDs of its own RX cookie */
+                osal_io_copyFromUser(&ioctl_data,
+                                     ((void *)((NPS_HUGE_T)ioctl_bulk.rx_cookie_addr))
+                                         + pkt_cnt*sizeof(HAL_TAU_PKT_IOCTL_RX_COOKIE_T),
+                                     sizeof(HAL_TAU_PKT_IOCTL_RX_COOKIE_T));
+                _hal_tau_pkt_copyRxPktToUser(unit, ptr_sw_gpd_knl[pkt], ioctl_data.ioctl_gpd_addr);
             }
-        }
-        else
+        } while ((pkt_cnt < ioctl_bulk.pkt_num) &&
+                 (NPS_E_OK == _hal_tau_pkt_selectRxQueue(unit, &queue)));
+
+        if (pkt_cnt > 0)
         {
-            /* it means that all queue's are flush -> rx stop flow */
-            rc = NPS_E_OTHERS;
+            rc = NPS_E_OK;
         }
     }
 
+    osal_io_copyToUser(&ptr_cookie->pkt_num, &pkt_cnt, sizeof(UI32_T));
+
     return (rc);
 }
 
@@ -2745,30 +3659,48 @@ _hal_tau_pkt_resumeAllIntf(
         ptr_net_dev = HAL_TAU_PKT_GET_PORT_NETDEV(port);
         if (NULL != ptr_net_dev)
         {
-            if (netif_queue_stopped(ptr_net_dev))
-            {
-                netif_wake_queue(ptr_net_dev);
-            }
+            netif_tx_wake_all_queues(ptr_net_dev);
         }
     }
 
     return (NPS_E_OK);
 }
 
+/* The Tx queue N of the net intf is sent on the Tx channel N */
 static NPS_ERROR_NO_T
-_hal_tau_pkt_suspendAllIntf(
-    const UI32_T                        unit)
+_hal_tau_pkt_resumeIntfTxQueue(
+    const UI32_T                        unit,
+    const HAL_TAU_PKT_TX_CHANNEL_T      channel)
 {
     struct net_device                   *ptr_net_dev = NULL;
     UI32_T                              port;
 
-    /* Unregister net devices by id */
     for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
     {
         ptr_net_dev = HAL_TAU_PKT_GET_PORT_NETDEV(port);
-        if (NULL != ptr_net_dev)
+        if ((NULL != ptr_net_dev) && (channel < ptr_net_dev->real_num_tx_queues))
+        {
+            netif_tx_wake_queue(netdev_get_tx_queue(ptr_net_dev, channel));
+        }
+    }
+
+    return (NPS_E_OK);
+}
+
+static NPS_ERROR_NO_T
+_hal_tau_pkt_suspendIntfTxQueue(
+    const UI32_T                        unit,
+    const HAL_TAU_PKT_TX_CHANNEL_T      channel)
+{
+    struct net_device                   *ptr_net_dev = NULL;
+    UI32_T                              port;
+
+    for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
+    {
+        ptr_net_dev = HAL_TAU_PKT_GET_PORT_NETDEV(port);
+        if ((NULL != ptr_net_dev) && (channel < ptr_net_dev->real_num_tx_queues))
         {
-            netif_stop_queue(ptr_net_dev);
+            netif_tx_stop_queue(netdev_get_tx_queue(ptr_net_dev, channel));
         }
     }
 
@@ -2795,25 +3727,31 @@ _hal_tau_pkt_stopAllIntf(
     return (NPS_E_OK);
 }
 
-/* FUNCTION NAME: hal_tau_pkt_sendGpd
+/* FUNCTION NAME: _hal_tau_pkt_sendGpd
  * PURPOSE:
- *      To perform the packet transmission form CPU to the switch.
+ *      To fill the GPDs in the Tx GPD ring and resume the TX channel.
  * INPUT:
  *      unit            --  The unit ID
  *      channel         --  The target TX channel
  *      ptr_sw_gpd      --  Pointer for the SW Tx GPD link list
+ *      xmit_more       --  TRUE if the caller will send more packets soon
  * OUTPUT:
  *      None
  * RETURN:
  *      NPS_E_OK        --  Successfully perform the transferring.
  * NOTES:
- *      None
+ *      In async mode, the resume of the TX channel is postponed while
+ *      xmit_more is TRUE, and the pending GPDs are resumed by one register
+ *      write in the last call of the batch. The pending GPDs are also
+ *      resumed when the Tx queue of the channel is suspended since no more
+ *      call will come.
  */
-NPS_ERROR_NO_T
-hal_tau_pkt_sendGpd(
+static NPS_ERROR_NO_T
+_hal_tau_pkt_sendGpd(
     const UI32_T                    unit,
     const HAL_TAU_PKT_TX_CHANNEL_T  channel,
-          HAL_TAU_PKT_TX_SW_GPD_T   *ptr_sw_gpd)
+          HAL_TAU_PKT_TX_SW_GPD_T   *ptr_sw_gpd,
+    const BOOL_T                    xmit_more)
 {
     NPS_ERROR_NO_T                  rc = NPS_E_OK;
     HAL_TAU_PKT_TX_CB_T             *ptr_tx_cb = HAL_TAU_PKT_GET_TX_CB_PTR(unit);
@@ -2870,26 +3808,43 @@ hal_tau_pkt_sendGpd(
                 ptr_tx_pdma->used_idx      = used_idx;
                 ptr_tx_pdma->used_gpd_num += used_gpd_num;
                 ptr_tx_pdma->free_gpd_num -= used_gpd_num;
-
-                _hal_tau_pkt_resumeTxChannelReg(unit, channel, used_gpd_num);
-                ptr_tx_cb->cnt.channel[channel].send_ok++;
-
-                _hal_tau_pkt_waitTxDone(unit, channel, ptr_sw_first_gpd);
+                ptr_tx_pdma->pend_gpd_num += used_gpd_num;
 
                 /* reserve 1 packet buffer for each port in case that the suspension is too late */
 #define HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_LOW      (HAL_PORT_NUM)
-                if (ptr_tx_pdma->free_gpd_num < HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_LOW)
+#define HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_WAKE     (2 * HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_LOW)
+                if ((ptr_tx_pdma->free_gpd_num < HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_LOW) &&
+                    (FALSE == ptr_tx_cb->net_tx_suspended[channel]))
                 {
                     HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_TX,
-                                    "u=%u, txch=%u, tx avbl gpd < %d, suspend all netdev\n",
+                                    "u=%u, txch=%u, tx avbl gpd < %d, suspend netdev tx queue\n",
                                     unit, channel, HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_LOW);
-                    _hal_tau_pkt_suspendAllIntf(unit);
+                    ptr_tx_cb->net_tx_suspended[channel] = TRUE;
+                    _hal_tau_pkt_suspendIntfTxQueue(unit, channel);
+                }
+
+                if ((FALSE == xmit_more) ||
+                    (TRUE == ptr_tx_cb->net_tx_suspended[channel]) ||
+                    (HAL_TAU_PKT_TX_WAIT_ASYNC != ptr_tx_cb->wait_mode))
+                {
+                    _hal_tau_pkt_resumeTxChannelReg(unit, channel, ptr_tx_pdma->pend_gpd_num);
+                    ptr_tx_pdma->pend_gpd_num = 0;
                 }
+                ptr_tx_cb->cnt.channel[channel].send_ok++;
+
+                _hal_tau_pkt_waitTxDone(unit, channel, ptr_sw_first_gpd);
             }
             else
             {
                 rc = NPS_E_TABLE_FULL;
             }
+
+            /* the last packet of the batch is dropped, resume the ones before it */
+            if ((NPS_E_OK != rc) && (FALSE == xmit_more) && (0 != ptr_tx_pdma->pend_gpd_num))
+            {
+                _hal_tau_pkt_resumeTxChannelReg(unit, channel, ptr_tx_pdma->pend_gpd_num);
+                ptr_tx_pdma->pend_gpd_num = 0;
+            }
         }
         else
         {
@@ -2911,6 +3866,29 @@ hal_tau_pkt_sendGpd(
     return (rc);
 }
 
+/* FUNCTION NAME: hal_tau_pkt_sendGpd
+ * PURPOSE:
+ *      To perform the packet transmission form CPU to the switch.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The target TX channel
+ *      ptr_sw_gpd      --  Pointer for the SW Tx GPD link list
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        --  Successfully perform the transferring.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+hal_tau_pkt_sendGpd(
+    const UI32_T                    unit,
+    const HAL_TAU_PKT_TX_CHANNEL_T  channel,
+          HAL_TAU_PKT_TX_SW_GPD_T   *ptr_sw_gpd)
+{
+    return (_hal_tau_pkt_sendGpd(unit, channel, ptr_sw_gpd, FALSE));
+}
+
 /* ----------------------------------------------------------------------------------- pkt_srv */
 /* ----------------------------------------------------------------------------------- Rx Init */
 static NPS_ERROR_NO_T
@@ -2942,6 +3920,15 @@ _hal_tau_pkt_rxStop(
         return (NPS_E_OK);
     }
 
+    /* NAPI poll doesn't take the PDMA semaphore, wait for the running poll to finish */
+    if (TRUE == ptr_rx_cb->napi_mode)
+    {
+        for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+        {
+            napi_disable(&ptr_rx_cb->napi[channel].napi);
+        }
+    }
+
     /* Deinit Rx PDMA and free buf for Rx GPD */
     for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
     {
@@ -2950,6 +3937,14 @@ _hal_tau_pkt_rxStop(
         osal_takeSemaphore(&ptr_rx_pdma->sema, NPS_SEMAPHORE_WAIT_FOREVER);
         _hal_tau_pkt_stopRxChannelReg(unit, channel);
         rc = _hal_tau_pkt_deinitRxPdmaRingBuf(unit, channel);
+
+        /* free the incomplete Rx packet */
+        if (NULL != ptr_rx_pdma->ptr_sw_first_gpd)
+        {
+            _hal_tau_pkt_freeRxGpdList(unit, ptr_rx_pdma->ptr_sw_first_gpd, TRUE);
+            ptr_rx_pdma->ptr_sw_first_gpd = NULL;
+            ptr_rx_pdma->ptr_sw_last_gpd  = NULL;
+        }
         osal_giveSemaphore(&ptr_rx_pdma->sema);
     }
 
@@ -2961,6 +3956,12 @@ _hal_tau_pkt_rxStop(
         _hal_tau_pkt_flushRxQueue(unit, &ptr_rx_cb->sw_queue[idx]);
     }
 
+    /* unmap the recycled buffers, the buffer size may change before next start */
+    for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+    {
+        _hal_tau_pkt_drainRecycleRxBuf(unit, channel);
+    }
+
     /* Return user thread */
     ptr_rx_cb->running = FALSE;
     ptr_cb->init_flag &= (~HAL_TAU_PKT_INIT_RX_START);
@@ -3005,6 +4006,16 @@ _hal_tau_pkt_rxStart(
         osal_giveSemaphore(&ptr_rx_pdma->sema);
     }
 
+    /* the Rx-Done interrupt may be left masked by the ISR while the NAPI was disabled */
+    if (TRUE == ptr_rx_cb->napi_mode)
+    {
+        for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+        {
+            napi_enable(&ptr_rx_cb->napi[channel].napi);
+            _hal_tau_pkt_unmaskIntr(unit, HAL_TAU_PKT_RCH_REG(unit, channel));
+        }
+    }
+
     /* enable to dequeue rx packets */
     ptr_rx_cb->running = TRUE;
 
@@ -3021,6 +4032,8 @@ _hal_tau_pkt_rxStart(
  *      1. To stop the Rx channel and deinit the Rx subsystem.
  *      2. To init the Rx subsystem and start the Rx channel.
  *      3. To restart the Rx subsystem
+ *      4. To select NAPI poll or Rx threads to handle the Rx-Done interrupt.
+ *      5. To set the Rx queue scheduling mode, and the weight and depth of a queue.
  * INPUT:
  *      unit            -- The unit ID
  *      ptr_cookie      -- Pointer of the RX cookie
@@ -3041,6 +4054,8 @@ hal_tau_pkt_setRxKnlConfig(
     HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
     HAL_TAU_PKT_DRV_CB_T            *ptr_cb = HAL_TAU_PKT_GET_DRV_CB_PTR(unit);
     HAL_TAU_PKT_IOCTL_RX_TYPE_T     rx_type = HAL_TAU_PKT_IOCTL_RX_TYPE_LAST;
+    HAL_TAU_PKT_RX_SCHED_T          sched_mode = HAL_TAU_PKT_RX_SCHED_LAST;
+    UI32_T                          queue = 0, weight = 0, depth = 0;
 
     osal_io_copyFromUser(&rx_type, &ptr_cookie->rx_type, sizeof(HAL_TAU_PKT_IOCTL_RX_TYPE_T));
 
@@ -3061,6 +4076,55 @@ hal_tau_pkt_setRxKnlConfig(
         osal_io_copyFromUser(&ptr_rx_cb->buf_len, &ptr_cookie->buf_len, sizeof(UI32_T));
         _hal_tau_pkt_rxStart(unit);
     }
+    if ((HAL_TAU_PKT_IOCTL_RX_TYPE_NAPI_ENABLE  == rx_type) ||
+        (HAL_TAU_PKT_IOCTL_RX_TYPE_NAPI_DISABLE == rx_type))
+    {
+        /* NAPI is enabled and disabled along with Rx start and stop */
+        if (0 != (ptr_cb->init_flag & HAL_TAU_PKT_INIT_RX_START))
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                             "u=%u, set rx napi mode failed, rx not stop\n", unit);
+            return (NPS_E_OTHERS);
+        }
+
+        ptr_rx_cb->napi_mode = (HAL_TAU_PKT_IOCTL_RX_TYPE_NAPI_ENABLE == rx_type)? TRUE : FALSE;
+    }
+    if (HAL_TAU_PKT_IOCTL_RX_TYPE_SET_SCHED == rx_type)
+    {
+        osal_io_copyFromUser(&sched_mode, &ptr_cookie->sched_mode, sizeof(HAL_TAU_PKT_RX_SCHED_T));
+        if (sched_mode >= HAL_TAU_PKT_RX_SCHED_LAST)
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                             "u=%u, set rx sched mode failed, invalid mode=%d\n", unit, sched_mode);
+            return (NPS_E_OTHERS);
+        }
+
+        /* the credits of the previous mode are meaningless */
+        for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
+        {
+            ptr_rx_cb->sw_queue[queue].deficit = 0;
+        }
+        ptr_rx_cb->sched_mode = sched_mode;
+    }
+    if (HAL_TAU_PKT_IOCTL_RX_TYPE_SET_QUEUE == rx_type)
+    {
+        osal_io_copyFromUser(&queue,  &ptr_cookie->channel, sizeof(UI32_T));
+        osal_io_copyFromUser(&weight, &ptr_cookie->weight,  sizeof(UI32_T));
+        osal_io_copyFromUser(&depth,  &ptr_cookie->depth,   sizeof(UI32_T));
+
+        /* a zero weight queue cannot earn any credit in WRR/DWRR */
+        if ((queue >= HAL_TAU_PKT_RX_QUEUE_NUM) || (0 == weight) ||
+            (depth > ptr_rx_cb->sw_queue[queue].len))
+        {
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                             "u=%u, set rx queue failed, queue=%u, weight=%u, depth=%u\n",
+                             unit, queue, weight, depth);
+            return (NPS_E_OTHERS);
+        }
+
+        ptr_rx_cb->sw_queue[queue].weight = weight;
+        ptr_rx_cb->sw_queue[queue].depth  = depth;
+    }
 
     return (rc);
 }
@@ -3086,7 +4150,18 @@ hal_tau_pkt_getRxKnlConfig(
 {
     HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
 
+    UI32_T                          queue = 0;
+
     osal_io_copyToUser(&ptr_cookie->buf_len, &ptr_rx_cb->buf_len, sizeof(UI32_T));
+    osal_io_copyToUser(&ptr_cookie->sched_mode, &ptr_rx_cb->sched_mode, sizeof(HAL_TAU_PKT_RX_SCHED_T));
+
+    /* the weight and depth of the queue specified by the channel */
+    osal_io_copyFromUser(&queue, &ptr_cookie->channel, sizeof(UI32_T));
+    if (queue < HAL_TAU_PKT_RX_QUEUE_NUM)
+    {
+        osal_io_copyToUser(&ptr_cookie->weight, &ptr_rx_cb->sw_queue[queue].weight, sizeof(UI32_T));
+        osal_io_copyToUser(&ptr_cookie->depth,  &ptr_rx_cb->sw_queue[queue].depth,  sizeof(UI32_T));
+    }
 
     return (NPS_E_OK);
 }
@@ -3154,6 +4229,12 @@ hal_tau_pkt_deinitTask(
         osal_destroyThread(&ptr_rx_cb->isr_task_id[channel]);
     }
 
+    /* Destroy rxNapiPoll, NAPI has been disabled when Rx stopped */
+    for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+    {
+        netif_napi_del(&ptr_rx_cb->napi[channel].napi);
+    }
+
     /* Destroy handleTxDoneTask */
     for (channel = 0; channel < HAL_TAU_PKT_TX_CHANNEL_LAST; channel++)
     {
@@ -3242,8 +4323,12 @@ _hal_tau_pkt_deinitRxPdma(
     /* Free DMA */
     osal_takeSemaphore(&ptr_rx_pdma->sema, NPS_SEMAPHORE_WAIT_FOREVER);
     osal_dma_free(ptr_rx_pdma->ptr_gpd_start_addr);
+    _hal_tau_pkt_drainRecycleRxBuf(unit, channel);
+    osal_free(ptr_rx_pdma->ptr_recycle_buf);
+    ptr_rx_pdma->ptr_recycle_buf = NULL;
     osal_giveSemaphore(&ptr_rx_pdma->sema);
     osal_destroySemaphore(&ptr_rx_pdma->sema);
+    osal_destroyIsrLock(&ptr_rx_pdma->recycle_lock);
 
     return (NPS_E_OK);
 }
@@ -3313,6 +4398,7 @@ _hal_tau_pkt_deinitPktTxCb(
 
         /* Deinitialize Tx GPD-queue (of first SW-GPD) from handleTxDoneTask to txTask */
         osal_destroySemaphore(&ptr_tx_cb->sw_queue.sema);
+        osal_destroySemaphore(&ptr_tx_cb->sw_queue.prod_sema);
         osal_que_destroy(&ptr_tx_cb->sw_queue.que_id);
     }
 
@@ -3542,6 +4628,7 @@ _hal_tau_pkt_handleRxErrStat(
     const UI32_T                    unit,
     const HAL_TAU_PKT_RX_CHANNEL_T  channel)
 {
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
     HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
 
     /* Set the error flag. */
@@ -3549,7 +4636,17 @@ _hal_tau_pkt_handleRxErrStat(
     ptr_rx_pdma->err_flag = TRUE;
     osal_giveSemaphore(&ptr_rx_pdma->sema);
 
-    osal_triggerEvent(HAL_TAU_PKT_RCH_EVENT(unit, channel));
+    if (TRUE == ptr_rx_cb->napi_mode)
+    {
+        /* called in thread context, let the softirq run the poll on bh enable */
+        local_bh_disable();
+        napi_schedule(&ptr_rx_cb->napi[channel].napi);
+        local_bh_enable();
+    }
+    else
+    {
+        osal_triggerEvent(HAL_TAU_PKT_RCH_EVENT(unit, channel));
+    }
 
     return (NPS_E_OK);
 }
@@ -3976,7 +5073,7 @@ _hal_tau_pkt_handleTxDoneTask(
     UI32_T                          loop_cnt = 0;
     NPS_IRQ_FLAGS_T                 irg_flags;
     unsigned long                   timeout  = 0;
-    UI32_T                          bulk_pkt_cnt = 0, idx;
+    UI32_T                          bulk_pkt_cnt = 0;
 
     osal_initRunThread();
     do
@@ -4012,19 +5109,16 @@ _hal_tau_pkt_handleTxDoneTask(
             {
                 if (TRUE == ptr_tx_pdma->err_flag)
                 {
-                    /* flush the incomplete Tx packet */
-                    if (HAL_TAU_PKT_TX_WAIT_ASYNC == ptr_tx_cb->wait_mode)
+                    /* flush the Tx packet which HW stopped at, the recovery
+                     * sends the unsent packets after it again
+                     */
+                    if ((HAL_TAU_PKT_TX_WAIT_ASYNC == ptr_tx_cb->wait_mode) &&
+                        (NULL != ptr_tx_pdma->pptr_sw_gpd_ring[first_gpd_idx]))
                     {
-                        for (idx = 0; idx < ptr_tx_pdma->gpd_num; idx++)
-                        {
-                            if (NULL != ptr_tx_pdma->pptr_sw_gpd_ring[idx])
-                            {
-                                ptr_tx_pdma->pptr_sw_gpd_bulk[bulk_pkt_cnt]
-                                    = ptr_tx_pdma->pptr_sw_gpd_ring[idx];
-                                ptr_tx_pdma->pptr_sw_gpd_ring[idx] = NULL;
-                                bulk_pkt_cnt++;
-                            }
-                        }
+                        ptr_tx_pdma->pptr_sw_gpd_bulk[bulk_pkt_cnt]
+                            = ptr_tx_pdma->pptr_sw_gpd_ring[first_gpd_idx];
+                        ptr_tx_pdma->pptr_sw_gpd_ring[first_gpd_idx] = NULL;
+                        bulk_pkt_cnt++;
                     }
 
                     /* do error recover */
@@ -4036,6 +5130,7 @@ _hal_tau_pkt_handleTxDoneTask(
                     }
                     else
                     {
+                        ptr_tx_cb->cnt.channel[channel].err_recover_fail++;
                         HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_TX | HAL_TAU_PKT_DBG_ERR),
                                         "u=%u, txch=%u, err recover failed\n",
                                         unit, channel);
@@ -4077,36 +5172,238 @@ _hal_tau_pkt_handleTxDoneTask(
             loop_cnt--;
         }
 
-        /* let the netdev resume Tx */
-        _hal_tau_pkt_resumeAllIntf(unit);
+        /* let the netdev resume Tx once enough GPDs are reclaimed */
+        if ((TRUE == ptr_tx_cb->net_tx_suspended[channel]) &&
+            ((ptr_tx_pdma->free_gpd_num >= HAL_TAU_PKT_KNL_TX_RING_AVBL_GPD_WAKE) ||
+             (0 == ptr_tx_pdma->used_gpd_num)))
+        {
+            ptr_tx_cb->net_tx_suspended[channel] = FALSE;
+            _hal_tau_pkt_resumeIntfTxQueue(unit, channel);
+        }
 
         /* update ISR and counter */
         ptr_tx_cb->cnt.channel[channel].tx_done++;
 
         _hal_tau_pkt_unmaskIntr(unit, HAL_TAU_PKT_TCH_REG(unit, channel));
 
-        if (HAL_TAU_PKT_TX_WAIT_SYNC_INTR != ptr_tx_cb->wait_mode)
+        if (HAL_TAU_PKT_TX_WAIT_SYNC_INTR != ptr_tx_cb->wait_mode)
+        {
+            osal_giveIsrLock(&ptr_tx_pdma->ring_lock, &irg_flags);
+        }
+        else
+        {
+            osal_giveSemaphore(&ptr_tx_pdma->sync_intr_sema);
+        }
+
+        /* enque packet after releasing the spinlock */
+        _hal_tau_pkt_txEnQueueBulk(unit, channel, bulk_pkt_cnt);
+        bulk_pkt_cnt = 0;
+
+        /* prevent this task from executing too long */
+        if (!(time_before(jiffies, timeout)))
+        {
+            schedule();
+            timeout = jiffies + 1; /* continuously free tx descriptor for 1 tick */
+        }
+
+    } while (NPS_E_OK == osal_isRunThread());
+    osal_exitRunThread();
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_handleRxDone
+ * PURPOSE:
+ *      To move the Rx-Done GPDs of the specified RX channel to SW-GPDs and
+ *      enqueue the completed packets.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      channel         --  The target RX channel
+ *      budget          --  The maximum number of packets to be handled
+ *      can_sleep       --  TRUE to sleep and retry when out of memory
+ * OUTPUT:
+ *      ptr_pkt_cnt     --  The number of handled packets
+ * RETURN:
+ *      NPS_E_OK        --  Successfully handle the GPDs.
+ *      NPS_E_NO_MEMORY --  Allocate the SW-GPD or payload buffer failed.
+ * NOTES:
+ *      The caller should guarantee that only one context handles the channel,
+ *      by the PDMA semaphore in thread mode and by the NAPI in NAPI mode.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_handleRxDone(
+    const UI32_T                    unit,
+    const HAL_TAU_PKT_RX_CHANNEL_T  channel,
+    const UI32_T                    budget,
+    const BOOL_T                    can_sleep,
+    UI32_T                          *ptr_pkt_cnt)
+{
+    NPS_ERROR_NO_T                  rc = NPS_E_OK;
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
+    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd = NULL;
+    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd = NULL;
+    UI32_T                          loop_cnt = ptr_rx_pdma->gpd_num;
+
+    *ptr_pkt_cnt = 0;
+    while ((loop_cnt > 0) && (*ptr_pkt_cnt < budget))
+    {
+        ptr_rx_gpd = HAL_TAU_PKT_GET_RX_GPD_PTR(unit, channel, ptr_rx_pdma->cur_idx);
+        osal_dma_invalidateCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+
+        /* If hwo=HW, it might be:
+         * 1. err_flag=TRUE  -> HW breakdown -> enque and recover -> break
+         * 2. err_flag=FALSE -> HW busy -> break
+         */
+        if (HAL_TAU_PKT_HWO_HW_OWN == ptr_rx_gpd->hwo)
+        {
+            if (TRUE == ptr_rx_pdma->err_flag)
+            {
+                /* free the last incomplete Rx packet */
+                if (NULL != ptr_rx_pdma->ptr_sw_first_gpd)
+                {
+                    ptr_rx_pdma->ptr_sw_first_gpd->rx_complete = FALSE;
+                    _hal_tau_pkt_rxEnQueue(unit, channel, ptr_rx_pdma->ptr_sw_first_gpd);
+                    ptr_rx_pdma->ptr_sw_first_gpd = NULL;
+                    ptr_rx_pdma->ptr_sw_last_gpd  = NULL;
+                }
+
+                /* do error recover */
+                if (NPS_E_OK == _hal_tau_pkt_recoverRxPdma(unit, channel))
+                {
+                    ptr_rx_pdma->err_flag = FALSE;
+                    ptr_rx_cb->cnt.channel[channel].err_recover++;
+                }
+                else
+                {
+                    ptr_rx_cb->cnt.channel[channel].err_recover_fail++;
+                    HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                                    "u=%u, rxch=%u, err recover failed\n",
+                                    unit, channel);
+                }
+            }
+            break;
+        }
+
+        /* Move HW-GPD to SW-GPD */
+        ptr_sw_gpd = (HAL_TAU_PKT_RX_SW_GPD_T *)osal_alloc(sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
+        if (NULL == ptr_sw_gpd)
+        {
+            ptr_rx_cb->cnt.no_memory++;
+            HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
+                            "u=%u, rxch=%u, alloc sw gpd failed, size=%zu\n",
+                            unit, channel, sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
+            rc = NPS_E_NO_MEMORY;
+            break;
+        }
+        memcpy(&ptr_sw_gpd->rx_gpd, (void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
+        ptr_sw_gpd->ptr_next   = NULL;
+        ptr_sw_gpd->ptr_cookie = ptr_rx_pdma->pptr_skb_ring[ptr_rx_pdma->cur_idx];
+        ptr_sw_gpd->channel    = channel;
+#if defined(PERF_EN_TEST)
+        ptr_sw_gpd->perf_ts    = perf_getTimestamp();
+#endif
+
+        /* If hwo=SW and ch=*, re-alloc-buf and resume */
+        while (NPS_E_OK != _hal_tau_pkt_allocRxPayloadBuf(unit, channel, ptr_rx_pdma->cur_idx))
+        {
+            ptr_rx_cb->cnt.no_memory++;
+            if (FALSE == can_sleep)
+            {
+                rc = NPS_E_NO_MEMORY;
+                break;
+            }
+            HAL_TAU_PKT_ALLOC_MEM_RETRY_SLEEP();
+        }
+        if (NPS_E_OK != rc)
+        {
+            /* the GPD still owns the original buffer, handle it in next round */
+            osal_free(ptr_sw_gpd);
+            break;
+        }
+
+        /* Append the SW-GPD to the link-list of the packet */
+        if (NULL == ptr_rx_pdma->ptr_sw_first_gpd)
         {
-            osal_giveIsrLock(&ptr_tx_pdma->ring_lock, &irg_flags);
+            ptr_rx_pdma->ptr_sw_first_gpd = ptr_sw_gpd;
         }
         else
         {
-            osal_giveSemaphore(&ptr_tx_pdma->sync_intr_sema);
+            ptr_rx_pdma->ptr_sw_last_gpd->ptr_next = ptr_sw_gpd;
         }
+        ptr_rx_pdma->ptr_sw_last_gpd = ptr_sw_gpd;
 
-        /* enque packet after releasing the spinlock */
-        _hal_tau_pkt_txEnQueueBulk(unit, channel, bulk_pkt_cnt);
-        bulk_pkt_cnt = 0;
+        ptr_rx_gpd->ioc = HAL_TAU_PKT_IOC_HAS_INTR;
+        ptr_rx_gpd->hwo = HAL_TAU_PKT_HWO_HW_OWN;
+        osal_dma_flushCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
 
-        /* prevent this task from executing too long */
-        if (!(time_before(jiffies, timeout)))
+        /* If ch=0, enque the SW-GPD link-list */
+        if (HAL_TAU_PKT_CH_LAST_GPD == ptr_sw_gpd->rx_gpd.ch)
         {
-            schedule();
-            timeout = jiffies + 1; /* continuously free tx descriptor for 1 tick */
+            ptr_rx_pdma->ptr_sw_first_gpd->rx_complete = TRUE;
+            _hal_tau_pkt_rxEnQueue(unit, channel, ptr_rx_pdma->ptr_sw_first_gpd);
+            ptr_rx_pdma->ptr_sw_first_gpd = NULL;
+            ptr_rx_pdma->ptr_sw_last_gpd  = NULL;
+            (*ptr_pkt_cnt)++;
         }
 
-    } while (NPS_E_OK == osal_isRunThread());
-    osal_exitRunThread();
+        _hal_tau_pkt_resumeRxChannelReg(unit, channel, 1);
+
+        /* update Rx PDMA */
+        ptr_rx_pdma->cur_idx++;
+        ptr_rx_pdma->cur_idx %= ptr_rx_pdma->gpd_num;
+        loop_cnt--;
+    }
+
+#if defined(NETIF_EN_NETLINK)
+    /* send the samples aggregated in this round */
+    netif_nl_flush(unit);
+#endif
+
+    return (rc);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_rxNapiPoll
+ * PURPOSE:
+ *      To handle the RX done interrupt for the specified RX channel in NAPI mode.
+ * INPUT:
+ *      ptr_napi        --  The NAPI context of the RX channel
+ *      budget          --  The maximum number of packets to be handled
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The number of handled packets, or budget to be polled again.
+ * NOTES:
+ *      The Rx-Done interrupt is kept masked until the poll completes.
+ */
+static int
+_hal_tau_pkt_rxNapiPoll(
+    struct napi_struct              *ptr_napi,
+    int                             budget)
+{
+    HAL_TAU_PKT_RX_NAPI_T           *ptr_rx_napi = container_of(ptr_napi, HAL_TAU_PKT_RX_NAPI_T, napi);
+    UI32_T                          unit = ptr_rx_napi->unit;
+    HAL_TAU_PKT_RX_CHANNEL_T        channel = ptr_rx_napi->channel;
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    NPS_ERROR_NO_T                  rc = NPS_E_OK;
+    UI32_T                          pkt_cnt = 0;
+
+    if ((0 != ptr_rx_cb->buf_len) && (budget > 0))
+    {
+        rc = _hal_tau_pkt_handleRxDone(unit, channel, (UI32_T)budget, FALSE, &pkt_cnt);
+    }
+
+    /* budget exhausted or out of memory, stay in polling mode */
+    if ((NPS_E_OK != rc) || (pkt_cnt >= (UI32_T)budget))
+    {
+        return (budget);
+    }
+
+    /* update ISR and counter */
+    ptr_rx_cb->cnt.channel[channel].rx_done++;
+
+    napi_complete_done(ptr_napi, (int)pkt_cnt);
+    _hal_tau_pkt_unmaskIntr(unit, HAL_TAU_PKT_RCH_REG(unit, channel));
+
+    return ((int)pkt_cnt);
 }
 
 /* FUNCTION NAME: _hal_tau_pkt_handleRxDoneTask
@@ -4133,13 +5430,8 @@ _hal_tau_pkt_handleRxDoneTask(
     /* control block */
     HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
     HAL_TAU_PKT_RX_PDMA_T           *ptr_rx_pdma = HAL_TAU_PKT_GET_RX_PDMA_PTR(unit, channel);
-    volatile HAL_TAU_PKT_RX_GPD_T   *ptr_rx_gpd = NULL;
 
-    BOOL_T                          first = TRUE;
-    BOOL_T                          last = FALSE;
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_gpd = NULL;
-    HAL_TAU_PKT_RX_SW_GPD_T         *ptr_sw_first_gpd = NULL;
-    UI32_T                          loop_cnt = 0;
+    UI32_T                          pkt_cnt = 0;
     unsigned long                   timeout  = 0;
 
     osal_initRunThread();
@@ -4165,127 +5457,7 @@ _hal_tau_pkt_handleRxDoneTask(
 
         /* protect Rx PDMA */
         osal_takeSemaphore(&ptr_rx_pdma->sema, NPS_SEMAPHORE_WAIT_FOREVER);
-        loop_cnt = ptr_rx_pdma->gpd_num;
-        while (loop_cnt > 0)
-        {
-            ptr_rx_gpd = HAL_TAU_PKT_GET_RX_GPD_PTR(unit, channel, ptr_rx_pdma->cur_idx);
-            osal_dma_invalidateCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
-
-            /* If hwo=HW, it might be:
-             * 1. err_flag=TRUE  -> HW breakdown -> enque and recover -> break
-             * 2. err_flag=FALSE -> HW busy -> break
-             */
-            if (HAL_TAU_PKT_HWO_HW_OWN == ptr_rx_gpd->hwo)
-            {
-                if (TRUE == ptr_rx_pdma->err_flag)
-                {
-                    /* free the last incomplete Rx packet */
-                    if ((NULL != ptr_sw_first_gpd) &&
-                        (NULL != ptr_sw_gpd))
-                    {
-                        ptr_sw_gpd->ptr_next = NULL;
-                        ptr_sw_first_gpd->rx_complete = FALSE;
-                        _hal_tau_pkt_rxEnQueue(unit, channel, ptr_sw_first_gpd);
-                        ptr_sw_first_gpd = NULL;
-                    }
-
-                    /* do error recover */
-                    first = TRUE;
-                    last = FALSE;
-                    if (NPS_E_OK == _hal_tau_pkt_recoverRxPdma(unit, channel))
-                    {
-                        ptr_rx_pdma->err_flag = FALSE;
-                        ptr_rx_cb->cnt.channel[channel].err_recover++;
-                    }
-                    else
-                    {
-                        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
-                                        "u=%u, rxch=%u, err recover failed\n",
-                                        unit, channel);
-                    }
-                }
-                else
-                {
-                }
-                break;
-            }
-
-            /* Move HW-GPD to SW-GPD and append to a link-list */
-            if (TRUE == first)
-            {
-                ptr_sw_first_gpd = (HAL_TAU_PKT_RX_SW_GPD_T *)osal_alloc(sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
-                ptr_sw_gpd = ptr_sw_first_gpd;
-                if (NULL != ptr_sw_gpd)
-                {
-                    memcpy(&ptr_sw_gpd->rx_gpd, (void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
-                    first = FALSE;
-                }
-                else
-                {
-                    ptr_rx_cb->cnt.no_memory++;
-                    HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
-                                    "u=%u, rxch=%u, alloc 1st sw gpd failed, size=%zu\n",
-                                    unit, channel, sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
-                    break;
-                }
-            }
-            else
-            {
-                ptr_sw_gpd->ptr_next = (HAL_TAU_PKT_RX_SW_GPD_T *)osal_alloc(sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
-                ptr_sw_gpd = ptr_sw_gpd->ptr_next;
-                if (NULL != ptr_sw_gpd)
-                {
-                    memcpy(&ptr_sw_gpd->rx_gpd, (void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
-                }
-                else
-                {
-                    ptr_rx_cb->cnt.no_memory++;
-                    HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_RX | HAL_TAU_PKT_DBG_ERR),
-                                    "u=%u, rxch=%u, alloc mid sw gpd failed, size=%zu\n",
-                                    unit, channel, sizeof(HAL_TAU_PKT_RX_SW_GPD_T));
-                    break;
-                }
-            }
-
-            ptr_sw_gpd->ptr_cookie = ptr_rx_pdma->pptr_skb_ring[ptr_rx_pdma->cur_idx];
-
-            /* If hwo=SW and ch=0, enque SW-GPD and signal rxTask */
-            if (HAL_TAU_PKT_CH_LAST_GPD == ptr_rx_gpd->ch)
-            {
-                last = TRUE;
-            }
-
-            /* If hwo=SW and ch=*, re-alloc-buf and resume */
-            while (NPS_E_OK != _hal_tau_pkt_allocRxPayloadBuf(unit, channel, ptr_rx_pdma->cur_idx))
-            {
-                ptr_rx_cb->cnt.no_memory++;
-                HAL_TAU_PKT_ALLOC_MEM_RETRY_SLEEP();
-            }
-            ptr_rx_gpd->ioc = HAL_TAU_PKT_IOC_HAS_INTR;
-            ptr_rx_gpd->hwo = HAL_TAU_PKT_HWO_HW_OWN;
-            osal_dma_flushCache((void *)ptr_rx_gpd, sizeof(HAL_TAU_PKT_RX_GPD_T));
-
-            /* Enque the SW-GPD to rxTask */
-            if (TRUE == last)
-            {
-                ptr_sw_gpd->ptr_next = NULL;
-                ptr_sw_first_gpd->rx_complete = TRUE;
-                _hal_tau_pkt_rxEnQueue(unit, channel, ptr_sw_first_gpd);
-                ptr_sw_first_gpd = NULL;
-
-                /* To rebuild the SW GPD link list */
-                first = TRUE;
-                last = FALSE;
-            }
-
-            _hal_tau_pkt_resumeRxChannelReg(unit, channel, 1);
-
-            /* update Rx PDMA */
-            ptr_rx_pdma->cur_idx++;
-            ptr_rx_pdma->cur_idx %= ptr_rx_pdma->gpd_num;
-            loop_cnt--;
-        }
-
+        _hal_tau_pkt_handleRxDone(unit, channel, ptr_rx_pdma->gpd_num, TRUE, &pkt_cnt);
         osal_giveSemaphore(&ptr_rx_pdma->sema);
 
         /* update ISR and counter */
@@ -4316,6 +5488,10 @@ _hal_tau_pkt_net_dev_tx_callback(
     phy_addr = NPS_ADDR_32_TO_64(ptr_sw_gpd->tx_gpd.data_buf_addr_hi, ptr_sw_gpd->tx_gpd.data_buf_addr_lo);
     osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_TO_DEVICE);
 
+    /* report the completion to BQL */
+    netdev_tx_completed_queue(netdev_get_tx_queue(ptr_skb->dev, skb_get_queue_mapping(ptr_skb)),
+                              1, ptr_skb->len);
+
     /* free skb */
     osal_skb_free(ptr_skb);
 
@@ -4323,6 +5499,42 @@ _hal_tau_pkt_net_dev_tx_callback(
     osal_free(ptr_sw_gpd);
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_setTaskSched
+ * PURPOSE:
+ *      To apply the scheduling parameters of the module to a task.
+ * INPUT:
+ *      unit            --  The unit ID
+ *      ptr_name        --  The task name for the debug message
+ *      ptr_task_id     --  The task ID
+ *      priority        --  0 for SCHED_NORMAL, 1 to 99 for SCHED_FIFO
+ *      cpu_mask        --  The CPUs the task can run on, 0 for all
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      A failure is reported but the task keeps running with the default.
+ */
+static void
+_hal_tau_pkt_setTaskSched(
+    const UI32_T            unit,
+    const C8_T              *ptr_name,
+    NPS_THREAD_ID_T         *ptr_task_id,
+    const UI32_T            priority,
+    const UI32_T            cpu_mask)
+{
+    if ((0 != priority) && (NPS_E_OK != osal_setThreadPriority(ptr_task_id, priority)))
+    {
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_ERR,
+                        "u=%u, %s task set priority %u failed\n", unit, ptr_name, priority);
+    }
+    if ((0 != cpu_mask) && (NPS_E_OK != osal_setThreadCpuMask(ptr_task_id, cpu_mask)))
+    {
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_ERR,
+                        "u=%u, %s task set cpu mask 0x%x failed\n", unit, ptr_name, cpu_mask);
+    }
+}
+
 /* FUNCTION NAME: hal_tau_pkt_initTask
  * PURPOSE:
  *      To initialize the Task for packet module.
@@ -4357,6 +5569,11 @@ hal_tau_pkt_initTask(
     rc = osal_createThread("ERROR", HAL_DFLT_CFG_PKT_ERROR_ISR_THREAD_STACK,
                            HAL_DFLT_CFG_PKT_ERROR_ISR_THREAD_PRI, _hal_tau_pkt_handleErrorTask,
                            (void *)((NPS_HUGE_T)unit), &ptr_cb->err_task_id);
+    if (NPS_E_OK == rc)
+    {
+        _hal_tau_pkt_setTaskSched(unit, "ERROR", &ptr_cb->err_task_id,
+                                  err_thread_prio, err_thread_cpus);
+    }
 
     /* Init handleTxDoneTask */
     for (channel = 0; ((channel < HAL_TAU_PKT_TX_CHANNEL_LAST) && (NPS_E_OK == rc)); channel++)
@@ -4368,7 +5585,28 @@ hal_tau_pkt_initTask(
                                HAL_DFLT_CFG_PKT_TX_ISR_THREAD_PRI, _hal_tau_pkt_handleTxDoneTask,
                                (void *)&ptr_tx_cb->isr_task_cookie[channel],
                                &ptr_tx_cb->isr_task_id[channel]);
+        if (NPS_E_OK == rc)
+        {
+            _hal_tau_pkt_setTaskSched(unit, "TX_ISR", &ptr_tx_cb->isr_task_id[channel],
+                                      tx_thread_prio, tx_thread_cpus);
+        }
+    }
+
+    /* Init rxNapiPoll, NAPI is enabled when Rx started in NAPI mode */
+    init_dummy_netdev(&ptr_rx_cb->napi_dev);
+    for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+    {
+        ptr_rx_cb->napi[channel].unit    = unit;
+        ptr_rx_cb->napi[channel].channel = channel;
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 1, 0)
+        netif_napi_add(&ptr_rx_cb->napi_dev, &ptr_rx_cb->napi[channel].napi,
+                       _hal_tau_pkt_rxNapiPoll);
+#else
+        netif_napi_add(&ptr_rx_cb->napi_dev, &ptr_rx_cb->napi[channel].napi,
+                       _hal_tau_pkt_rxNapiPoll, NAPI_POLL_WEIGHT);
+#endif
     }
+    ptr_rx_cb->napi_mode = (0 != rx_napi)? TRUE : FALSE;
 
     /* Init handleRxDoneTask */
     for (channel = 0; ((channel < HAL_TAU_PKT_RX_CHANNEL_LAST) && (NPS_E_OK == rc)); channel++)
@@ -4380,6 +5618,11 @@ hal_tau_pkt_initTask(
                                HAL_DFLT_CFG_PKT_RX_ISR_THREAD_PRI, _hal_tau_pkt_handleRxDoneTask,
                                (void *)&ptr_rx_cb->isr_task_cookie[channel],
                                &ptr_rx_cb->isr_task_id[channel]);
+        if (NPS_E_OK == rc)
+        {
+            _hal_tau_pkt_setTaskSched(unit, "RX_ISR", &ptr_rx_cb->isr_task_id[channel],
+                                      rx_thread_prio, rx_thread_cpus);
+        }
     }
 
     /* Init txTask */
@@ -4398,6 +5641,7 @@ hal_tau_pkt_initTask(
      */
     _hal_tau_pkt_resumeAllIntf(unit);
 
+    osal_memset(ptr_tx_cb->net_tx_suspended, 0, sizeof(ptr_tx_cb->net_tx_suspended));
     ptr_tx_cb->net_tx_allowed = TRUE;
 
     return (rc);
@@ -4535,6 +5779,7 @@ _hal_tau_pkt_initRxPdma(
 
     /* Binary semaphore to protect Rx PDMA */
     osal_createSemaphore("RCH_LCK", NPS_SEMAPHORE_BINARY, &ptr_rx_pdma->sema);
+    osal_createIsrLock("RCH_RCY", &ptr_rx_pdma->recycle_lock);
 
     /* Reset Rx PDMA */
     osal_takeSemaphore(&ptr_rx_pdma->sema, NPS_SEMAPHORE_WAIT_FOREVER);
@@ -4580,6 +5825,20 @@ _hal_tau_pkt_initRxPdma(
         }
     }
 
+    if (NPS_E_OK == rc)
+    {
+        /* Prepare the recycle stack */
+        ptr_rx_pdma->recycle_cnt = 0;
+        ptr_rx_pdma->ptr_recycle_buf = (HAL_TAU_PKT_RX_RECYCLE_BUF_T *)osal_alloc(
+            ptr_rx_pdma->gpd_num * sizeof(HAL_TAU_PKT_RX_RECYCLE_BUF_T));
+
+        if (NULL == ptr_rx_pdma->ptr_recycle_buf)
+        {
+            ptr_rx_cb->cnt.no_memory++;
+            rc = NPS_E_NO_MEMORY;
+        }
+    }
+
     osal_giveSemaphore(&ptr_rx_pdma->sema);
 
     return (rc);
@@ -4654,6 +5913,8 @@ _hal_tau_pkt_initPktTxCb(
         ptr_tx_cb->sw_queue.weight = 0;
 
         osal_createSemaphore("TX_QUE", NPS_SEMAPHORE_BINARY, &ptr_tx_cb->sw_queue.sema);
+        /* Every TX channel's handleTxDoneTask enqueues */
+        osal_createSemaphore("TX_QUE_P", NPS_SEMAPHORE_BINARY, &ptr_tx_cb->sw_queue.prod_sema);
         osal_que_create(&ptr_tx_cb->sw_queue.que_id, ptr_tx_cb->sw_queue.len);
     }
     else if (HAL_TAU_PKT_TX_WAIT_SYNC_POLL == ptr_tx_cb->wait_mode)
@@ -4708,6 +5969,7 @@ _hal_tau_pkt_initPktRxCb(
     {
         ptr_rx_cb->sw_queue[queue].len    = HAL_DFLT_CFG_PKT_RX_QUEUE_LEN;
         ptr_rx_cb->sw_queue[queue].weight = HAL_DFLT_CFG_PKT_RX_QUEUE_WEIGHT;
+        ptr_rx_cb->sw_queue[queue].depth  = HAL_DFLT_CFG_PKT_RX_QUEUE_DEPTH;
 
         osal_createSemaphore("RX_QUE", NPS_SEMAPHORE_BINARY, &ptr_rx_cb->sw_queue[queue].sema);
         osal_que_create(&ptr_rx_cb->sw_queue[queue].que_id, ptr_rx_cb->sw_queue[queue].len);
@@ -4821,15 +6083,23 @@ _hal_tau_pkt_resetIosCreditCfg(
 }
 
 static NPS_ERROR_NO_T
-_hal_tau_pkt_addProfToList(
+_hal_tau_pkt_insertProfNode(
     HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_new_profile,
+    const UI32_T                        order,
     HAL_TAU_PKT_PROFILE_NODE_T          **pptr_profile_list)
 {
     HAL_TAU_PKT_PROFILE_NODE_T      *ptr_new_prof_node;
     HAL_TAU_PKT_PROFILE_NODE_T      *ptr_curr_node, *ptr_prev_node;
 
     ptr_new_prof_node = osal_alloc(sizeof(HAL_TAU_PKT_PROFILE_NODE_T));
+    if (NULL == ptr_new_prof_node)
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                        "alloc prof node failed, id=%d\n", ptr_new_profile->id);
+        return (NPS_E_NO_MEMORY);
+    }
     ptr_new_prof_node->ptr_profile = ptr_new_profile;
+    ptr_new_prof_node->order = order;
 
     /* Create the 1st node in the interface profile list */
     if (NULL == *pptr_profile_list)
@@ -4913,6 +6183,113 @@ _hal_tau_pkt_addProfToList(
     return (NPS_E_OK);
 }
 
+static BOOL_T
+_hal_tau_pkt_isBitmapEmpty(
+    const UI32_T                        *ptr_bitmap,
+    const UI32_T                        size)
+{
+    UI32_T                              idx;
+
+    for (idx = 0; idx < size; idx++)
+    {
+        if (0 != ptr_bitmap[idx])
+        {
+            return (FALSE);
+        }
+    }
+
+    return (TRUE);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_isRsnProf
+ * PURPOSE:
+ *      To check if the profile only matches the IPP reason codes.
+ * INPUT:
+ *      ptr_profile     -- Pointer of the profile
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      TRUE            -- The profile is indexed by the IPP reason codes.
+ *      FALSE           -- The profile is linked to the generic list.
+ * NOTES:
+ *      Such a profile is hit by reason if and only if the packet is ITMH_ETH and
+ *      its cp_to_cpu_code is set in ipp_rsn_bitmap, see _hal_tau_pkt_rxCheckReason.
+ */
+static BOOL_T
+_hal_tau_pkt_isRsnProf(
+    const HAL_TAU_PKT_NETIF_PROFILE_T   *ptr_profile)
+{
+    const HAL_PKT_RX_REASON_BITMAP_T    *ptr_reason_bitmap = &ptr_profile->reason_bitmap;
+
+    if (0 == (ptr_profile->flags & HAL_TAU_PKT_NETIF_PROFILE_FLAGS_REASON))
+    {
+        return (FALSE);
+    }
+
+    if ((FALSE == _hal_tau_pkt_isBitmapEmpty(ptr_reason_bitmap->ipp_excpt_bitmap,
+                                             HAL_TAU_PKT_IPP_EXCPT_BITMAP_SIZE)) ||
+        (FALSE == _hal_tau_pkt_isBitmapEmpty(ptr_reason_bitmap->ipp_l3_excpt_bitmap,
+                                             HAL_TAU_PKT_IPP_L3_EXCPT_BITMAP_SIZE)) ||
+        (FALSE == _hal_tau_pkt_isBitmapEmpty(ptr_reason_bitmap->epp_excpt_bitmap,
+                                             HAL_TAU_PKT_EPP_EXCPT_BITMAP_SIZE)) ||
+        (FALSE == _hal_tau_pkt_isBitmapEmpty(ptr_reason_bitmap->ipp_copy2cpu_bitmap,
+                                             HAL_TAU_PKT_IPP_COPY2CPU_BITMAP_SIZE)) ||
+        (FALSE == _hal_tau_pkt_isBitmapEmpty(ptr_reason_bitmap->epp_copy2cpu_bitmap,
+                                             HAL_TAU_PKT_EPP_COPY2CPU_BITMAP_SIZE)))
+    {
+        return (FALSE);
+    }
+
+    return (TRUE);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_addProfToList
+ * PURPOSE:
+ *      To add the profile to the profile list and the index of the port.
+ * INPUT:
+ *      ptr_new_profile -- Pointer of the profile
+ *      ptr_port_db     -- Pointer of the port DB
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully add the profile.
+ *      NPS_E_NO_MEMORY -- Allocate the profile node failed.
+ * NOTES:
+ *      None
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_addProfToList(
+    HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_new_profile,
+    HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db)
+{
+    NPS_ERROR_NO_T                      rc;
+    UI32_T                              order = _hal_tau_pkt_profile_order++;
+    UI32_T                              rsn;
+
+    rc = _hal_tau_pkt_insertProfNode(ptr_new_profile, order, &ptr_port_db->ptr_profile_list);
+    if (NPS_E_OK != rc)
+    {
+        return (rc);
+    }
+
+    if (TRUE == _hal_tau_pkt_isRsnProf(ptr_new_profile))
+    {
+        for (rsn = 0; (rsn < HAL_TAU_PKT_IPP_RSN_LAST) && (NPS_E_OK == rc); rsn++)
+        {
+            if (0 != (ptr_new_profile->reason_bitmap.ipp_rsn_bitmap[rsn / 32] & (1UL << (rsn % 32))))
+            {
+                rc = _hal_tau_pkt_insertProfNode(ptr_new_profile, order, &ptr_port_db->ptr_rsn_list[rsn]);
+            }
+        }
+    }
+    else
+    {
+        rc = _hal_tau_pkt_insertProfNode(ptr_new_profile, order, &ptr_port_db->ptr_generic_list);
+    }
+
+    return (rc);
+}
+
 static NPS_ERROR_NO_T
 _hal_tau_pkt_addProfToAllIntf(
     HAL_TAU_PKT_NETIF_PROFILE_T         *ptr_new_profile)
@@ -4927,7 +6304,7 @@ _hal_tau_pkt_addProfToAllIntf(
         /* if (NULL != ptr_port_db->ptr_net_dev) */
         if (1)
         {
-            _hal_tau_pkt_addProfToList(ptr_new_profile, &ptr_port_db->ptr_profile_list);
+            _hal_tau_pkt_addProfToList(ptr_new_profile, ptr_port_db);
         }
     }
 
@@ -4935,7 +6312,7 @@ _hal_tau_pkt_addProfToAllIntf(
 }
 
 static HAL_TAU_PKT_NETIF_PROFILE_T *
-_hal_tau_pkt_delProfFromListById(
+_hal_tau_pkt_removeProfNode(
     const UI32_T                            id,
     HAL_TAU_PKT_PROFILE_NODE_T              **pptr_profile_list)
 {
@@ -4994,10 +6371,51 @@ _hal_tau_pkt_delProfFromListById(
         }
     }
 
+    return (ptr_profile);
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_delProfFromListById
+ * PURPOSE:
+ *      To delete the profile from the profile list and the index of the port.
+ * INPUT:
+ *      id              -- The profile ID
+ *      ptr_port_db     -- Pointer of the port DB
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      Pointer of the deleted profile, NULL if not found.
+ * NOTES:
+ *      None
+ */
+static HAL_TAU_PKT_NETIF_PROFILE_T *
+_hal_tau_pkt_delProfFromListById(
+    const UI32_T                            id,
+    HAL_TAU_PKT_NETIF_PORT_DB_T             *ptr_port_db)
+{
+    HAL_TAU_PKT_NETIF_PROFILE_T     *ptr_profile = NULL;
+    UI32_T                          rsn;
+
+    ptr_profile = _hal_tau_pkt_removeProfNode(id, &ptr_port_db->ptr_profile_list);
     if (NULL == ptr_profile)
     {
-        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
-                        "find prof failed, id=%d\n", id);
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_PROFILE | HAL_TAU_PKT_DBG_ERR),
+                        "find prof failed, id=%d\n", id);
+        return (NULL);
+    }
+
+    if (TRUE == _hal_tau_pkt_isRsnProf(ptr_profile))
+    {
+        for (rsn = 0; rsn < HAL_TAU_PKT_IPP_RSN_LAST; rsn++)
+        {
+            if (0 != (ptr_profile->reason_bitmap.ipp_rsn_bitmap[rsn / 32] & (1UL << (rsn % 32))))
+            {
+                _hal_tau_pkt_removeProfNode(id, &ptr_port_db->ptr_rsn_list[rsn]);
+            }
+        }
+    }
+    else
+    {
+        _hal_tau_pkt_removeProfNode(id, &ptr_port_db->ptr_generic_list);
     }
 
     return (ptr_profile);
@@ -5018,7 +6436,7 @@ _hal_tau_pkt_delProfFromAllIntfById(
         /* if (NULL != ptr_port_db->ptr_net_dev) */
         if (1)
         {
-            _hal_tau_pkt_delProfFromListById(id, &ptr_port_db->ptr_profile_list);
+            _hal_tau_pkt_delProfFromListById(id, ptr_port_db);
         }
     }
     return (NPS_E_OK);
@@ -5091,6 +6509,7 @@ _hal_tau_pkt_destroyAllIntf(
             osal_memset(ptr_port_db, 0x0, sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T));
         }
     }
+    osal_memset(_ptr_hal_tau_pkt_intf_entry, 0x0, sizeof(_ptr_hal_tau_pkt_intf_entry));
 
     return (NPS_E_OK);
 }
@@ -5101,6 +6520,7 @@ _hal_tau_pkt_delProfListOnAllIntf(
 {
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
     UI32_T                              port = 0;
+    UI32_T                              rsn;
     HAL_TAU_PKT_PROFILE_NODE_T          *ptr_curr_node, *ptr_next_node;
 
     /* Unregister net devices by id, although the "id" is now relavent to "port" we still perform a search */
@@ -5120,7 +6540,23 @@ _hal_tau_pkt_delProfListOnAllIntf(
                 osal_free(ptr_curr_node);
                 ptr_curr_node = ptr_next_node;
             }
+            ptr_port_db->ptr_profile_list = NULL;
+        }
+
+        /* free the index */
+        for (rsn = 0; rsn <= HAL_TAU_PKT_IPP_RSN_LAST; rsn++)
+        {
+            ptr_curr_node = (rsn < HAL_TAU_PKT_IPP_RSN_LAST)?
+                ptr_port_db->ptr_rsn_list[rsn] : ptr_port_db->ptr_generic_list;
+            while (NULL != ptr_curr_node)
+            {
+                ptr_next_node = ptr_curr_node->ptr_next_node;
+                osal_free(ptr_curr_node);
+                ptr_curr_node = ptr_next_node;
+            }
         }
+        osal_memset(ptr_port_db->ptr_rsn_list, 0x0, sizeof(ptr_port_db->ptr_rsn_list));
+        ptr_port_db->ptr_generic_list = NULL;
     }
 
     return (NPS_E_OK);
@@ -5356,7 +6792,14 @@ static int
 _hal_tau_pkt_net_dev_open(
     struct net_device           *ptr_net_dev)
 {
-    netif_start_queue(ptr_net_dev);
+    UI32_T                      queue;
+
+    /* the packets in flight before stop are not reported to BQL */
+    for (queue = 0; queue < ptr_net_dev->real_num_tx_queues; queue++)
+    {
+        netdev_tx_reset_queue(netdev_get_tx_queue(ptr_net_dev, queue));
+    }
+    netif_tx_start_all_queues(ptr_net_dev);
 
 #if defined(PERF_EN_TEST)
     /* Tx (len, tx_channel, rx_channel, test_skb) */
@@ -5393,7 +6836,7 @@ static int
 _hal_tau_pkt_net_dev_stop(
     struct net_device           *ptr_net_dev)
 {
-    netif_stop_queue(ptr_net_dev);
+    netif_tx_stop_all_queues(ptr_net_dev);
     return 0;
 }
 
@@ -5406,6 +6849,46 @@ _hal_tau_pkt_net_dev_ioctl(
     return 0;
 }
 
+/* FUNCTION NAME: _hal_tau_pkt_net_dev_select_queue
+ * PURPOSE:
+ *      To select the Tx queue, and so the Tx channel, of a packet.
+ * INPUT:
+ *      ptr_net_dev     --  The net intf
+ *      ptr_skb         --  The packet to send
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The Tx queue index
+ * NOTES:
+ *      With more than one Tx queue, the last one is reserved for the
+ *      control packets (skb priority TC_PRIO_CONTROL and above, LACP and
+ *      LLDP) so that they are not stuck behind bulk traffic. The other
+ *      packets are spread over the remaining queues by flow hash.
+ */
+static u16
+_hal_tau_pkt_net_dev_select_queue(
+    struct net_device           *ptr_net_dev,
+    struct sk_buff              *ptr_skb,
+    HAL_TAU_PKT_SELECT_QUEUE_ARGS)
+{
+    UI32_T                      queue_num = ptr_net_dev->real_num_tx_queues;
+    UI16_T                      ethertype;
+
+    if (queue_num <= 1)
+    {
+        return 0;
+    }
+
+    ethertype = ntohs(((struct ethhdr *)ptr_skb->data)->h_proto);
+    if (((ptr_skb->priority & TC_PRIO_MAX) >= TC_PRIO_CONTROL) ||
+        (ETH_P_SLOW == ethertype) || (ETH_P_LLDP == ethertype))
+    {
+        return (queue_num - 1);
+    }
+
+    return ((u16)(((u64)skb_get_hash(ptr_skb) * (queue_num - 1)) >> 32));
+}
+
 static netdev_tx_t
 _hal_tau_pkt_net_dev_tx(
     struct sk_buff              *ptr_skb,
@@ -5413,12 +6896,15 @@ _hal_tau_pkt_net_dev_tx(
 {
     struct net_device_priv      *ptr_priv = netdev_priv(ptr_net_dev);
     HAL_TAU_PKT_TX_CB_T         *ptr_tx_cb;
+    struct netdev_queue         *ptr_txq;
     /* chip meta */
     unsigned int                unit;
     unsigned int                channel        = 0;
     HAL_TAU_PKT_TX_SW_GPD_T     *ptr_sw_gpd    = NULL;
     void                        *ptr_virt_addr = NULL;
     NPS_ADDR_T                  phy_addr       = 0x0;
+    unsigned int                len            = 0;
+    BOOL_T                      xmit_more      = FALSE;
 
     if (NULL == ptr_priv)
     {
@@ -5436,6 +6922,10 @@ _hal_tau_pkt_net_dev_tx(
 
     unit = ptr_priv->unit;
 
+    /* each Tx queue has its own Tx channel */
+    channel = skb_get_queue_mapping(ptr_skb);
+    ptr_txq = netdev_get_tx_queue(ptr_net_dev, channel);
+
     ptr_tx_cb = HAL_TAU_PKT_GET_TX_CB_PTR(unit);
     /* for warm de-init procedure, if any net intf not destroyed, it is possible
      * that kernel still has packets to send causing segmentation fault
@@ -5496,19 +6986,28 @@ _hal_tau_pkt_net_dev_tx(
 #if LINUX_VERSION_CODE <= KERNEL_VERSION(4,6,7)
             ptr_net_dev->trans_start = jiffies;
 #else
-            netdev_get_tx_queue(ptr_net_dev, 0)->trans_start = jiffies;
+            ptr_txq->trans_start = jiffies;
 #endif
+            /* the skb may be freed by the Tx done task once it is sent,
+             * and BQL must be charged before the completion can happen
+             */
+            len = ptr_skb->len;
+            netdev_tx_sent_queue(ptr_txq, len);
+            xmit_more = (HAL_TAU_PKT_SKB_XMIT_MORE(ptr_skb) &&
+                         !netif_xmit_stopped(ptr_txq)) ? TRUE : FALSE;
+
             /* send gpd */
-            if (NPS_E_OK == hal_tau_pkt_sendGpd(unit, channel, ptr_sw_gpd))
+            if (NPS_E_OK == _hal_tau_pkt_sendGpd(unit, channel, ptr_sw_gpd, xmit_more))
             {
                 ptr_priv->stats.tx_packets++;
-                ptr_priv->stats.tx_bytes += ptr_skb->len;
+                ptr_priv->stats.tx_bytes += len;
             }
             else
             {
                 ptr_priv->stats.tx_fifo_errors++;   /* to record the extreme cases where packets are dropped */
                 ptr_priv->stats.tx_dropped++;
 
+                netdev_tx_completed_queue(ptr_txq, 1, len);
                 osal_skb_unmapDma(phy_addr, ptr_skb->len, DMA_TO_DEVICE);
                 osal_skb_free(ptr_skb);
                 osal_free(ptr_sw_gpd);
@@ -5523,9 +7022,9 @@ static void
 _hal_tau_pkt_net_dev_tx_timeout(
     struct net_device           *ptr_net_dev)
 {
-    netif_stop_queue(ptr_net_dev);
+    netif_tx_stop_all_queues(ptr_net_dev);
     osal_sleepThread(1000);
-    netif_wake_queue(ptr_net_dev);
+    netif_tx_wake_all_queues(ptr_net_dev);
 }
 
 static struct net_device_stats *
@@ -5590,6 +7089,7 @@ static struct net_device_ops    _hal_tau_pkt_net_dev_ops =
     .ndo_stop            = _hal_tau_pkt_net_dev_stop,
     .ndo_do_ioctl        = _hal_tau_pkt_net_dev_ioctl,
     .ndo_start_xmit      = _hal_tau_pkt_net_dev_tx,
+    .ndo_select_queue    = _hal_tau_pkt_net_dev_select_queue,
     .ndo_tx_timeout      = _hal_tau_pkt_net_dev_tx_timeout,
     .ndo_get_stats       = _hal_tau_pkt_net_dev_get_stats,
     .ndo_change_mtu      = _hal_tau_pkt_net_dev_set_mtu,
@@ -5639,6 +7139,20 @@ _hal_tau_pkt_setup(
     memset(&ptr_priv->stats, 0, sizeof(struct net_device_stats));
 }
 
+static HAL_TAU_PKT_NETIF_PORT_DB_T *
+_hal_tau_pkt_getIntfEntry(
+    const UI32_T                        id)
+{
+    HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db = NULL;
+
+    if (id < HAL_TAU_PKT_MAX_PORT_NUM)
+    {
+        ptr_port_db = _ptr_hal_tau_pkt_intf_entry[id];
+    }
+
+    return (ptr_port_db);
+}
+
 static NPS_ERROR_NO_T
 _hal_tau_pkt_createIntf(
     const UI32_T                        unit,
@@ -5680,17 +7194,31 @@ _hal_tau_pkt_createIntf(
         return (NPS_E_ENTRY_EXISTS);
     }
 
+    if (net_intf.port >= HAL_TAU_PKT_MAX_PORT_NUM)
+    {
+        HAL_TAU_PKT_DBG((HAL_TAU_PKT_DBG_ERR | HAL_TAU_PKT_DBG_INTF),
+                        "u=%u, create intf failed, invalid phy port=%d\n",
+                        unit, net_intf.port);
+        rc = NPS_E_BAD_PARAMETER;
+        osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+        _hal_tau_pkt_unlockRxChannelAll(unit);
+        return (NPS_E_OK);
+    }
+
     /* Bind the net dev and intf meta data to internel port-based array */
     ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(net_intf.port);
     if (ptr_port_db->ptr_net_dev == NULL)
     {
 
+        /* one Tx queue per Tx channel */
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(3, 17, 0)
-        ptr_net_dev = alloc_netdev(sizeof(struct net_device_priv),
-                                   net_intf.name, NET_NAME_UNKNOWN, _hal_tau_pkt_setup);
+        ptr_net_dev = alloc_netdev_mqs(sizeof(struct net_device_priv),
+                                       net_intf.name, NET_NAME_UNKNOWN, _hal_tau_pkt_setup,
+                                       tx_channels, 1);
 #else
-        ptr_net_dev = alloc_netdev(sizeof(struct net_device_priv),
-                                   net_intf.name, _hal_tau_pkt_setup);
+        ptr_net_dev = alloc_netdev_mqs(sizeof(struct net_device_priv),
+                                       net_intf.name, _hal_tau_pkt_setup,
+                                       tx_channels, 1);
 #endif
         memcpy(ptr_net_dev->dev_addr, net_intf.mac, ptr_net_dev->addr_len);
 
@@ -5709,6 +7237,7 @@ _hal_tau_pkt_createIntf(
         osal_memcpy(&ptr_port_db->meta, &net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
 
         ptr_port_db->ptr_net_dev = ptr_net_dev;
+        _ptr_hal_tau_pkt_intf_entry[net_intf.id] = ptr_port_db;
 
         /* Copy the intf-id to user space */
         osal_io_copyToUser(&ptr_cookie->net_intf, &net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
@@ -5736,7 +7265,6 @@ _hal_tau_pkt_destroyIntf(
 {
     HAL_TAU_PKT_NETIF_INTF_T            net_intf = {0};
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
-    UI32_T                              port = 0;
     NPS_ERROR_NO_T                      rc = NPS_E_ENTRY_NOT_FOUND;
 
     /* Lock all Rx tasks to avoid any access to the intf during packet processing */
@@ -5745,36 +7273,30 @@ _hal_tau_pkt_destroyIntf(
 
     osal_io_copyFromUser(&net_intf, &ptr_cookie->net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
 
-    /* Unregister net devices by id, although the "id" is now relavent to "port" we still perform a search */
-    for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
+    /* Unregister net devices by id */
+    ptr_port_db = _hal_tau_pkt_getIntfEntry(net_intf.id);
+    if (NULL != ptr_port_db)
     {
-        ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(port);
-        if (NULL != ptr_port_db->ptr_net_dev)       /* valid intf */
-        {
-            if (ptr_port_db->meta.id == net_intf.id)
-            {
-                HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_INTF,
-                                "u=%u, find intf %s (id=%d) on phy port=%d, destroy done\n",
-                                unit,
-                                ptr_port_db->meta.name,
-                                ptr_port_db->meta.id,
-                                ptr_port_db->meta.port);
-
-                netif_carrier_off(ptr_port_db->ptr_net_dev);
-                netif_tx_disable(ptr_port_db->ptr_net_dev);
-                unregister_netdev(ptr_port_db->ptr_net_dev);
-                free_netdev(ptr_port_db->ptr_net_dev);
-
-                /* Don't need to remove profiles on this port.
-                 * In fact, the profile is binding to "port" not "intf".
-                 */
-                /* _hal_tau_pkt_destroyProfList(ptr_port_db->ptr_profile_list); */
-
-                osal_memset(ptr_port_db, 0x0, sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T));
-                rc = NPS_E_OK;
-                break;
-            }
-        }
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_INTF,
+                        "u=%u, find intf %s (id=%d) on phy port=%d, destroy done\n",
+                        unit,
+                        ptr_port_db->meta.name,
+                        ptr_port_db->meta.id,
+                        ptr_port_db->meta.port);
+
+        netif_carrier_off(ptr_port_db->ptr_net_dev);
+        netif_tx_disable(ptr_port_db->ptr_net_dev);
+        unregister_netdev(ptr_port_db->ptr_net_dev);
+        free_netdev(ptr_port_db->ptr_net_dev);
+
+        /* Don't need to remove profiles on this port.
+         * In fact, the profile is binding to "port" not "intf".
+         */
+        /* _hal_tau_pkt_destroyProfList(ptr_port_db->ptr_profile_list); */
+
+        _ptr_hal_tau_pkt_intf_entry[net_intf.id] = NULL;
+        osal_memset(ptr_port_db, 0x0, sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T));
+        rc = NPS_E_OK;
     }
 
     osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
@@ -5813,25 +7335,17 @@ _hal_tau_pkt_getIntf(
 {
     HAL_TAU_PKT_NETIF_INTF_T            net_intf = {0};
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
-    UI32_T                              port = 0;
     NPS_ERROR_NO_T                      rc = NPS_E_ENTRY_NOT_FOUND;
 
     osal_io_copyFromUser(&net_intf, &ptr_cookie->net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
 
-    for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
+    ptr_port_db = _hal_tau_pkt_getIntfEntry(net_intf.id);
+    if (NULL != ptr_port_db)
     {
-        ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(port);
-        if (NULL != ptr_port_db->ptr_net_dev)       /* valid intf */
-        {
-            if (ptr_port_db->meta.id == net_intf.id)
-            {
-                HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_INTF, "u=%u, find intf id=%d\n", unit, net_intf.id);
-                _hal_tau_pkt_traverseProfList(net_intf.id, ptr_port_db->ptr_profile_list);
-                osal_io_copyToUser(&ptr_cookie->net_intf, &ptr_port_db->meta, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
-                rc = NPS_E_OK;
-                break;
-            }
-        }
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_INTF, "u=%u, find intf id=%d\n", unit, net_intf.id);
+        _hal_tau_pkt_traverseProfList(net_intf.id, ptr_port_db->ptr_profile_list);
+        osal_io_copyToUser(&ptr_cookie->net_intf, &ptr_port_db->meta, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
+        rc = NPS_E_OK;
     }
 
     osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
@@ -5890,7 +7404,7 @@ _hal_tau_pkt_createProfile(
             HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_PROFILE,
                             "u=%u, bind prof to phy port=%d\n", unit, ptr_profile->port);
             ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(ptr_profile->port);
-            _hal_tau_pkt_addProfToList(ptr_profile, &ptr_port_db->ptr_profile_list);
+            _hal_tau_pkt_addProfToList(ptr_profile, ptr_port_db);
         }
         else
         {
@@ -5990,28 +7504,20 @@ _hal_tau_pkt_getIntfCnt(
     HAL_TAU_PKT_NETIF_INTF_CNT_T        intf_cnt = {0};
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
     struct net_device_priv              *ptr_priv;
-    UI32_T                              port = 0;
     NPS_ERROR_NO_T                      rc = NPS_E_ENTRY_NOT_FOUND;
 
     osal_io_copyFromUser(&net_intf, &ptr_cookie->net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
 
-    for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
+    ptr_port_db = _hal_tau_pkt_getIntfEntry(net_intf.id);
+    if (NULL != ptr_port_db)
     {
-        ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(port);
-        if (NULL != ptr_port_db->ptr_net_dev)       /* valid intf */
-        {
-            if (ptr_port_db->meta.id == net_intf.id)
-            {
-                ptr_priv = netdev_priv(ptr_port_db->ptr_net_dev);
-                intf_cnt.rx_pkt   = ptr_priv->stats.rx_packets;
-                intf_cnt.tx_pkt   = ptr_priv->stats.tx_packets;
-                intf_cnt.tx_error = ptr_priv->stats.tx_errors;
-                intf_cnt.tx_queue_full = ptr_priv->stats.tx_fifo_errors;
+        ptr_priv = netdev_priv(ptr_port_db->ptr_net_dev);
+        intf_cnt.rx_pkt   = ptr_priv->stats.rx_packets;
+        intf_cnt.tx_pkt   = ptr_priv->stats.tx_packets;
+        intf_cnt.tx_error = ptr_priv->stats.tx_errors;
+        intf_cnt.tx_queue_full = ptr_priv->stats.tx_fifo_errors;
 
-                rc = NPS_E_OK;
-                break;
-            }
-        }
+        rc = NPS_E_OK;
     }
 
     osal_io_copyToUser(&ptr_cookie->cnt, &intf_cnt, sizeof(HAL_TAU_PKT_NETIF_INTF_CNT_T));
@@ -6028,33 +7534,272 @@ _hal_tau_pkt_clearIntfCnt(
     HAL_TAU_PKT_NETIF_INTF_T            net_intf = {0};
     HAL_TAU_PKT_NETIF_PORT_DB_T         *ptr_port_db;
     struct net_device_priv              *ptr_priv;
-    UI32_T                              port = 0;
     NPS_ERROR_NO_T                      rc = NPS_E_ENTRY_NOT_FOUND;
 
     osal_io_copyFromUser(&net_intf, &ptr_cookie->net_intf, sizeof(HAL_TAU_PKT_NETIF_INTF_T));
 
+    ptr_port_db = _hal_tau_pkt_getIntfEntry(net_intf.id);
+    if (NULL != ptr_port_db)
+    {
+        ptr_priv = netdev_priv(ptr_port_db->ptr_net_dev);
+        ptr_priv->stats.rx_packets = 0;
+        ptr_priv->stats.tx_packets = 0;
+        ptr_priv->stats.tx_errors  = 0;
+        ptr_priv->stats.tx_fifo_errors = 0;
+
+        rc = NPS_E_OK;
+    }
+
+    osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+
+    return (NPS_E_OK);
+}
+
+#if defined(PERF_EN_TEST)
+static NPS_ERROR_NO_T
+_hal_tau_pkt_runPerfSuite(
+    const UI32_T                        unit,
+    PERF_SUITE_COOKIE_T                 *ptr_cookie)
+{
+    PERF_SUITE_COOKIE_T                 *ptr_suite;
+    NPS_ERROR_NO_T                      rc = NPS_E_OK;
+
+    /* too large to be on the stack */
+    ptr_suite = (PERF_SUITE_COOKIE_T *)osal_alloc(sizeof(PERF_SUITE_COOKIE_T));
+    if (NULL == ptr_suite)
+    {
+        rc = NPS_E_NO_MEMORY;
+        osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+        return (NPS_E_OK);
+    }
+
+    osal_io_copyFromUser(ptr_suite, ptr_cookie, sizeof(PERF_SUITE_COOKIE_T));
+    ptr_suite->unit = unit;
+    ptr_suite->rc = perf_runSuite(ptr_suite);
+    osal_io_copyToUser(ptr_cookie, ptr_suite, sizeof(PERF_SUITE_COOKIE_T));
+
+    osal_free(ptr_suite);
+
+    return (NPS_E_OK);
+}
+#endif
+
+/* ----------------------------------------------------------------------------------- Stats: mmap */
+static HAL_TAU_PKT_STATS_PAGE_T     *_ptr_hal_tau_pkt_stats[NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM];
+static NPS_SEMAPHORE_ID_T           _hal_tau_pkt_stats_sema;
+static struct delayed_work          _hal_tau_pkt_stats_work;
+
+#define HAL_TAU_PKT_STATS_MAP_SIZE  (PAGE_ALIGN(sizeof(HAL_TAU_PKT_STATS_PAGE_T)))
+
+/* FUNCTION NAME: _hal_tau_pkt_initStats
+ * PURPOSE:
+ *      To create the stats page of the unit for mmap.
+ * INPUT:
+ *      unit            -- The unit ID
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK        -- Successfully create the page.
+ *      NPS_E_NO_MEMORY -- Allocate the page failed.
+ * NOTES:
+ *      The page is kept across the drv deinit/init, since it may still be
+ *      mapped by the users. It is freed when the module is removed.
+ */
+static NPS_ERROR_NO_T
+_hal_tau_pkt_initStats(
+    const UI32_T                    unit)
+{
+    HAL_TAU_PKT_STATS_PAGE_T        *ptr_page = _ptr_hal_tau_pkt_stats[unit];
+
+    if (NULL != ptr_page)
+    {
+        return (NPS_E_OK);
+    }
+
+    ptr_page = vmalloc_user(HAL_TAU_PKT_STATS_MAP_SIZE);
+    if (NULL == ptr_page)
+    {
+        HAL_TAU_PKT_DBG(HAL_TAU_PKT_DBG_ERR,
+                        "u=%u, alloc stats page failed, size=%lu\n",
+                        unit, HAL_TAU_PKT_STATS_MAP_SIZE);
+        return (NPS_E_NO_MEMORY);
+    }
+
+    /* vmalloc_user() returns the zeroed memory */
+    ptr_page->magic   = HAL_TAU_PKT_STATS_MAGIC;
+    ptr_page->version = HAL_TAU_PKT_STATS_VERSION;
+    ptr_page->size    = sizeof(HAL_TAU_PKT_STATS_PAGE_T);
+    ptr_page->unit    = unit;
+    _ptr_hal_tau_pkt_stats[unit] = ptr_page;
+
+    return (NPS_E_OK);
+}
+
+static void
+_hal_tau_pkt_deinitStats(
+    void)
+{
+    UI32_T                          unit = 0;
+
+    for (unit = 0; unit < NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM; unit++)
+    {
+        if (NULL != _ptr_hal_tau_pkt_stats[unit])
+        {
+            vfree(_ptr_hal_tau_pkt_stats[unit]);
+            _ptr_hal_tau_pkt_stats[unit] = NULL;
+        }
+    }
+}
+
+/* FUNCTION NAME: _hal_tau_pkt_updateStats
+ * PURPOSE:
+ *      To copy the counters of the unit to its stats page.
+ * INPUT:
+ *      unit            -- The unit ID
+ *      ptr_page        -- The stats page of the unit
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      1. The writer is serialized by _hal_tau_pkt_stats_sema, the readers
+ *         follow the seq protocol described in hal_tau_pkt_knl.h.
+ *      2. The Rx channels are locked so that the intf cannot be destroyed.
+ */
+static void
+_hal_tau_pkt_updateStats(
+    const UI32_T                    unit,
+    HAL_TAU_PKT_STATS_PAGE_T        *ptr_page)
+{
+    HAL_TAU_PKT_TX_CB_T             *ptr_tx_cb = HAL_TAU_PKT_GET_TX_CB_PTR(unit);
+    HAL_TAU_PKT_RX_CB_T             *ptr_rx_cb = HAL_TAU_PKT_GET_RX_CB_PTR(unit);
+    HAL_TAU_PKT_NETIF_PORT_DB_T     *ptr_port_db;
+    HAL_TAU_PKT_STATS_INTF_T        *ptr_intf;
+    struct net_device_priv          *ptr_priv;
+    UI32_T                          port = 0, queue = 0, channel = 0, intf_num = 0;
+
+    _hal_tau_pkt_lockRxChannelAll(unit);
+
+    ptr_page->seq++;
+    smp_wmb();
+
+    ptr_page->update_ms = jiffies_to_msecs(jiffies);
+
+    for (queue = 0; queue < HAL_TAU_PKT_RX_QUEUE_NUM; queue++)
+    {
+        osal_que_getCount(&ptr_rx_cb->sw_queue[queue].que_id, &ptr_rx_cb->cnt.channel[queue].que_len);
+    }
+    osal_memcpy(&ptr_page->tx_cnt, &ptr_tx_cb->cnt, sizeof(HAL_TAU_PKT_TX_CNT_T));
+    osal_memcpy(&ptr_page->rx_cnt, &ptr_rx_cb->cnt, sizeof(HAL_TAU_PKT_RX_CNT_T));
+
+    for (channel = 0; channel < HAL_TAU_PKT_TX_CHANNEL_LAST; channel++)
+    {
+        ptr_page->tx_intr_cnt[channel] = HAL_TAU_PKT_TCH_CNT(unit, channel);
+    }
+    for (channel = 0; channel < HAL_TAU_PKT_RX_CHANNEL_LAST; channel++)
+    {
+        ptr_page->rx_intr_cnt[channel] = HAL_TAU_PKT_RCH_CNT(unit, channel);
+    }
+
     for (port = 0; port < HAL_TAU_PKT_MAX_PORT_NUM; port++)
     {
         ptr_port_db = HAL_TAU_PKT_GET_PORT_DB(port);
         if (NULL != ptr_port_db->ptr_net_dev)       /* valid intf */
         {
-            if (ptr_port_db->meta.id == net_intf.id)
-            {
-                ptr_priv = netdev_priv(ptr_port_db->ptr_net_dev);
-                ptr_priv->stats.rx_packets = 0;
-                ptr_priv->stats.tx_packets = 0;
-                ptr_priv->stats.tx_errors  = 0;
-                ptr_priv->stats.tx_fifo_errors = 0;
+            ptr_priv = netdev_priv(ptr_port_db->ptr_net_dev);
+            ptr_intf = &ptr_page->intf[intf_num++];
+            ptr_intf->id   = ptr_port_db->meta.id;
+            ptr_intf->port = port;
+            ptr_intf->cnt.rx_pkt   = ptr_priv->stats.rx_packets;
+            ptr_intf->cnt.tx_pkt   = ptr_priv->stats.tx_packets;
+            ptr_intf->cnt.tx_error = ptr_priv->stats.tx_errors;
+            ptr_intf->cnt.tx_queue_full = ptr_priv->stats.tx_fifo_errors;
+        }
+    }
+    ptr_page->intf_num = intf_num;
 
-                rc = NPS_E_OK;
-                break;
-            }
+    smp_wmb();
+    ptr_page->seq++;
+
+    _hal_tau_pkt_unlockRxChannelAll(unit);
+}
+
+static void
+_hal_tau_pkt_refreshStats(
+    struct work_struct              *ptr_work)
+{
+    UI32_T                          unit = 0;
+
+    osal_takeSemaphore(&_hal_tau_pkt_stats_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    for (unit = 0; unit < NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM; unit++)
+    {
+        if ((NULL != _ptr_hal_tau_pkt_stats[unit]) &&
+            (0 != (HAL_TAU_PKT_GET_DRV_CB_PTR(unit)->init_flag & HAL_TAU_PKT_INIT_DRV)))
+        {
+            _hal_tau_pkt_updateStats(unit, _ptr_hal_tau_pkt_stats[unit]);
         }
     }
+    osal_giveSemaphore(&_hal_tau_pkt_stats_sema);
 
-    osal_io_copyToUser(&ptr_cookie->rc, &rc, sizeof(NPS_ERROR_NO_T));
+    schedule_delayed_work(&_hal_tau_pkt_stats_work, msecs_to_jiffies(stats_ms));
+}
 
-    return (NPS_E_OK);
+/* FUNCTION NAME: _hal_tau_pkt_dev_mmap
+ * PURPOSE:
+ *      To map the read-only stats page of the unit selected by the offset.
+ * INPUT:
+ *      filf            -- The file of the device
+ *      vma             -- The user VMA
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      0               -- Successfully map the page.
+ *      -EINVAL/-EPERM/-ENODEV -- Failed to map the page.
+ * NOTES:
+ *      None
+ */
+static int
+_hal_tau_pkt_dev_mmap(
+    struct file                     *filf,
+    struct vm_area_struct           *vma)
+{
+    UI32_T                          map_pages = HAL_TAU_PKT_STATS_MAP_SIZE >> PAGE_SHIFT;
+    UI32_T                          unit = 0;
+    int                             ret = 0;
+
+    if ((0 != (vma->vm_pgoff % map_pages)) ||
+        ((vma->vm_end - vma->vm_start) > HAL_TAU_PKT_STATS_MAP_SIZE))
+    {
+        return (-EINVAL);
+    }
+    unit = vma->vm_pgoff / map_pages;
+    if (unit >= NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM)
+    {
+        return (-EINVAL);
+    }
+    if (0 != (vma->vm_flags & VM_WRITE))
+    {
+        return (-EPERM);
+    }
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+
+    osal_takeSemaphore(&_hal_tau_pkt_stats_sema, NPS_SEMAPHORE_WAIT_FOREVER);
+    if (NULL == _ptr_hal_tau_pkt_stats[unit])
+    {
+        ret = -ENODEV;
+    }
+    else
+    {
+        /* the offset selects the unit only */
+        ret = remap_vmalloc_range(vma, _ptr_hal_tau_pkt_stats[unit], 0);
+    }
+    osal_giveSemaphore(&_hal_tau_pkt_stats_sema);
+
+    return (ret);
 }
 
 /* ----------------------------------------------------------------------------------- Init: dev_ops */
@@ -6234,6 +7979,16 @@ _hal_tau_pkt_dev_ioctl(
             ret = _hal_tau_pkt_schedRxDeQueue(unit, (HAL_TAU_PKT_IOCTL_RX_COOKIE_T *)arg);
             break;
 
+        case HAL_TAU_PKT_IOCTL_TYPE_WAIT_RX_FREE_BULK:
+            ret = _hal_tau_pkt_schedRxDeQueueBulk(unit, (HAL_TAU_PKT_IOCTL_RX_BULK_COOKIE_T *)arg);
+            break;
+
+#if defined(PERF_EN_TEST)
+        case HAL_TAU_PKT_IOCTL_TYPE_PERF_SUITE:
+            ret = _hal_tau_pkt_runPerfSuite(unit, (PERF_SUITE_COOKIE_T *)arg);
+            break;
+#endif
+
         case HAL_TAU_PKT_IOCTL_TYPE_WAIT_TX_FREE:
             ret = _hal_tau_pkt_strictTxDeQueue(unit, (HAL_TAU_PKT_IOCTL_TX_COOKIE_T *)arg);
             break;
@@ -6251,7 +8006,9 @@ _hal_tau_pkt_dev_ioctl(
             break;
 
         case HAL_TAU_PKT_IOCTL_TYPE_DEINIT_DRV:
+            osal_takeSemaphore(&_hal_tau_pkt_stats_sema, NPS_SEMAPHORE_WAIT_FOREVER);
             ret = hal_tau_pkt_deinitPktDrv(unit);
+            osal_giveSemaphore(&_hal_tau_pkt_stats_sema);
             break;
 
         case HAL_TAU_PKT_IOCTL_TYPE_INIT_TASK:
@@ -6259,7 +8016,13 @@ _hal_tau_pkt_dev_ioctl(
             break;
 
         case HAL_TAU_PKT_IOCTL_TYPE_INIT_DRV:
+            osal_takeSemaphore(&_hal_tau_pkt_stats_sema, NPS_SEMAPHORE_WAIT_FOREVER);
             ret = hal_tau_pkt_initPktDrv(unit);
+            if (NPS_E_OK == ret)
+            {
+                ret = _hal_tau_pkt_initStats(unit);
+            }
+            osal_giveSemaphore(&_hal_tau_pkt_stats_sema);
             break;
 
         /* counter */
@@ -6328,6 +8091,7 @@ static struct file_operations _hal_tau_pkt_dev_ops =
     .write          = _hal_tau_pkt_dev_tx,
     .read           = _hal_tau_pkt_dev_rx,
     .unlocked_ioctl = _hal_tau_pkt_dev_ioctl,
+    .mmap           = _hal_tau_pkt_dev_mmap,
 #ifdef CONFIG_COMPAT
     .compat_ioctl   = _hal_tau_pkt_dev_compat_ioctl,
 #endif
@@ -6353,6 +8117,7 @@ _hal_tau_pkt_init(void)
     /* Reset all database*/
     osal_memset(_hal_tau_pkt_port_db, 0x0,
                 (HAL_TAU_PKT_MAX_PORT_NUM * sizeof(HAL_TAU_PKT_NETIF_PORT_DB_T)));
+    osal_memset(_ptr_hal_tau_pkt_intf_entry, 0x0, sizeof(_ptr_hal_tau_pkt_intf_entry));
     osal_memset(_hal_tau_pkt_rx_cb, 0x0,
                 NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM*sizeof(HAL_TAU_PKT_RX_CB_T));
     osal_memset(_hal_tau_pkt_tx_cb, 0x0,
@@ -6360,10 +8125,22 @@ _hal_tau_pkt_init(void)
     osal_memset(_hal_tau_pkt_drv_cb, 0x0,
                 NPS_CFG_MAXIMUM_CHIPS_PER_SYSTEM*sizeof(HAL_TAU_PKT_DRV_CB_T));
 
+    if ((0 == tx_channels) || (tx_channels > HAL_TAU_PKT_TX_CHANNEL_LAST))
+    {
+        tx_channels = HAL_TAU_PKT_TX_CHANNEL_LAST;
+    }
+
 #if defined(NETIF_EN_NETLINK)
     netif_nl_init();
 #endif
 
+    osal_createSemaphore("STATS", NPS_SEMAPHORE_BINARY, &_hal_tau_pkt_stats_sema);
+    INIT_DELAYED_WORK(&_hal_tau_pkt_stats_work, _hal_tau_pkt_refreshStats);
+    if (0 != stats_ms)
+    {
+        schedule_delayed_work(&_hal_tau_pkt_stats_work, msecs_to_jiffies(stats_ms));
+    }
+
     return (0);
 }
 
@@ -6372,6 +8149,9 @@ _hal_tau_pkt_exit(void)
 {
     UI32_T                  unit = 0;
 
+    /* Stop refreshing the stats page before the counters are destroyed */
+    cancel_delayed_work_sync(&_hal_tau_pkt_stats_work);
+
     /* 1st. Stop all netdev (if any) to prevent kernel from Tx new packets */
     _hal_tau_pkt_stopAllIntf(unit);
 
@@ -6392,6 +8172,14 @@ _hal_tau_pkt_exit(void)
     _hal_tau_pkt_destroyAllProfile(unit);
     _hal_tau_pkt_destroyAllIntf(unit);
 
+#if defined(NETIF_EN_NETLINK)
+    netif_nl_deinit();
+#endif
+
+    /* No one can map the pages, since the module is not in use */
+    _hal_tau_pkt_deinitStats();
+    osal_destroySemaphore(&_hal_tau_pkt_stats_sema);
+
     osal_deinit();
 
     /* Unregister device */
@@ -6404,6 +8192,39 @@ module_exit(_hal_tau_pkt_exit);
 module_param(ext_dbg_flag, uint, S_IRUGO);
 MODULE_PARM_DESC(ext_dbg_flag, "bit0:Error, bit1:Tx, bit2:Rx, bit3:Intf, bit4:Profile");
 
+module_param(rx_napi, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_napi, "0:Rx threads, 1:NAPI poll, the default Rx mode (default 0)");
+
+module_param(stats_ms, uint, S_IRUGO);
+MODULE_PARM_DESC(stats_ms, "Refresh period of the mmap stats page in ms, 0:no refresh (default 1000)");
+
+module_param(nl_batch_num, uint, S_IRUGO);
+MODULE_PARM_DESC(nl_batch_num, "Max netlink samples aggregated in one skb, 1:no aggregation (default 16)");
+
+module_param(rx_copybreak, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_copybreak, "Copy netdev Rx packets up to this size and recycle the DMA buffer (default 256)");
+
+module_param(tx_channels, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_channels, "Tx channels used by the netdevs, one Tx queue each, the last one for control packets (default 4)");
+
+module_param(rx_thread_prio, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_thread_prio, "SCHED_FIFO priority (1-99) of the Rx done threads, 0:SCHED_NORMAL (default 0)");
+
+module_param(tx_thread_prio, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_thread_prio, "SCHED_FIFO priority (1-99) of the Tx done threads, 0:SCHED_NORMAL (default 0)");
+
+module_param(err_thread_prio, uint, S_IRUGO);
+MODULE_PARM_DESC(err_thread_prio, "SCHED_FIFO priority (1-99) of the error thread, 0:SCHED_NORMAL (default 0)");
+
+module_param(rx_thread_cpus, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_thread_cpus, "CPU mask of the Rx done threads, 0:all CPUs (default 0)");
+
+module_param(tx_thread_cpus, uint, S_IRUGO);
+MODULE_PARM_DESC(tx_thread_cpus, "CPU mask of the Tx done threads, 0:all CPUs (default 0)");
+
+module_param(err_thread_cpus, uint, S_IRUGO);
+MODULE_PARM_DESC(err_thread_cpus, "CPU mask of the error thread, 0:all CPUs (default 0)");
+
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("MediaTek");
 MODULE_DESCRIPTION("NETIF Kernel Module");
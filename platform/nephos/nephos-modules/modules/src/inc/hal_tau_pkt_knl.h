@@ -316,6 +316,9 @@ typedef struct
 /* RX Queue */
 #define HAL_TAU_PKT_RX_QUEUE_NUM            (HAL_TAU_PKT_RX_CHANNEL_LAST)
 #define HAL_DFLT_CFG_PKT_RX_QUEUE_WEIGHT    (10)
+#define HAL_DFLT_CFG_PKT_RX_QUEUE_DEPTH     (0)    /* 0: limited by the queue length only */
+#define HAL_TAU_PKT_RX_SCHED_DWRR_QUANTUM   (256)  /* bytes per weight in each DWRR round */
+#define HAL_TAU_PKT_RX_SCHED_MAX_ROUND      (64)   /* DWRR rounds to earn credit before falling back to RR */
 #define HAL_DFLT_CFG_PKT_RX_QUEUE_LEN       (HAL_DFLT_CFG_PKT_RX_GPD_NUM * 10)
 #define HAL_TAU_PKT_RX_TASK_MAX_LOOP        (HAL_DFLT_CFG_PKT_RX_QUEUE_LEN)
 
@@ -359,7 +362,10 @@ typedef enum
 typedef enum
 {
     HAL_TAU_PKT_RX_SCHED_RR       = 0,
-    HAL_TAU_PKT_RX_SCHED_WRR      = 1
+    HAL_TAU_PKT_RX_SCHED_WRR      = 1,
+    HAL_TAU_PKT_RX_SCHED_SP       = 2,
+    HAL_TAU_PKT_RX_SCHED_DWRR     = 3,
+    HAL_TAU_PKT_RX_SCHED_LAST
 
 } HAL_TAU_PKT_RX_SCHED_T;
 
@@ -1262,6 +1268,13 @@ typedef struct
     UI32_T                              err_recover;
     UI32_T                              ecc_err;
 
+    /* error recovery */
+    UI32_T                              err_recover_fail;
+    UI32_T                              err_recover_drop;     /* GPDs of the packet HW stopped at */
+    UI32_T                              err_recover_requeue;  /* unsent GPDs restarted by recovery */
+    UI32_T                              err_recover_last_us;
+    UI32_T                              err_recover_max_us;
+
 } HAL_TAU_PKT_TX_CHANNEL_CNT_T;
 
 typedef struct
@@ -1325,6 +1338,11 @@ typedef struct HAL_TAU_PKT_RX_SW_GPD_S
 
 #if defined (NPS_EN_NETIF)
     void                                *ptr_cookie;    /* Pointer of virt-addr */
+    UI32_T                              channel;        /* Rx channel the buffer is recycled to */
+#endif
+
+#if defined (PERF_EN_TEST)
+    UI32_T                              perf_ts;        /* GPD done time for latency test */
 #endif
 
 } HAL_TAU_PKT_RX_SW_GPD_T;
@@ -1334,8 +1352,11 @@ typedef struct
     /* queue */
     UI32_T                              enque_ok;
     UI32_T                              enque_retry;
+    UI32_T                              enque_drop;     /* queue full in NAPI mode */
+    UI32_T                              depth_drop;     /* queue exceeds the configured depth */
     UI32_T                              deque_ok;
     UI32_T                              deque_fail;
+    UI32_T                              que_len;        /* snapshot of the queue occupancy */
 
     /* event */
     UI32_T                              trig_event;
@@ -1363,6 +1384,11 @@ typedef struct
     UI32_T                              err_recover;
     UI32_T                              ecc_err;
 
+    /* error recovery */
+    UI32_T                              err_recover_fail;
+    UI32_T                              err_recover_last_us;
+    UI32_T                              err_recover_max_us;
+
 #if defined (NPS_EN_NETIF)
     /* it means that user doesn't create intf on that port */
     UI32_T                              netdev_miss;
@@ -2170,6 +2196,8 @@ typedef enum
     HAL_TAU_PKT_IOCTL_TYPE_NL_DESTROY_NETLINK,
     HAL_TAU_PKT_IOCTL_TYPE_NL_GET_NETLINK,
 #endif
+    HAL_TAU_PKT_IOCTL_TYPE_WAIT_RX_FREE_BULK,    /* waitRxFree for multiple packets */
+    HAL_TAU_PKT_IOCTL_TYPE_PERF_SUITE,           /* perf_runSuite, PERF_EN_TEST only */
     HAL_TAU_PKT_IOCTL_TYPE_LAST
 
 } HAL_TAU_PKT_IOCTL_TYPE_T;
@@ -2178,6 +2206,10 @@ typedef enum
 {
     HAL_TAU_PKT_IOCTL_RX_TYPE_INIT = 0,
     HAL_TAU_PKT_IOCTL_RX_TYPE_DEINIT,
+    HAL_TAU_PKT_IOCTL_RX_TYPE_NAPI_ENABLE,      /* deliver Rx packets in NAPI poll  */
+    HAL_TAU_PKT_IOCTL_RX_TYPE_NAPI_DISABLE,     /* deliver Rx packets in Rx threads */
+    HAL_TAU_PKT_IOCTL_RX_TYPE_SET_SCHED,        /* set the Rx queue scheduling mode */
+    HAL_TAU_PKT_IOCTL_RX_TYPE_SET_QUEUE,        /* set the weight and depth of a Rx queue */
     HAL_TAU_PKT_IOCTL_RX_TYPE_LAST,
 
 } HAL_TAU_PKT_IOCTL_RX_TYPE_T;
@@ -2202,6 +2234,48 @@ typedef struct
 
 } HAL_TAU_PKT_IOCTL_NETIF_COOKIE_T;
 
+/* The read-only stats page, mmap'd from HAL_TAU_PKT_DRIVER_PATH.
+ * The page of a unit locates at offset unit * (sizeof(HAL_TAU_PKT_STATS_PAGE_T)
+ * rounded up to the page size), and is refreshed every stats_ms by the kernel.
+ *
+ * The reader should:
+ * 1. read seq, retry if it is odd (the kernel is updating)
+ * 2. read barrier, copy the counters, read barrier
+ * 3. read seq again, retry if it is changed
+ */
+#define HAL_TAU_PKT_STATS_MAGIC             (0x4e505354)    /* "NPST" */
+#define HAL_TAU_PKT_STATS_VERSION           (2)
+#define HAL_TAU_PKT_STATS_INTF_NUM          (HAL_PORT_NUM + 1) /* CPU port */
+
+typedef struct
+{
+    UI32_T                          id;
+    UI32_T                          port;
+    HAL_TAU_PKT_NETIF_INTF_CNT_T    cnt;
+
+} HAL_TAU_PKT_STATS_INTF_T;
+
+typedef struct
+{
+    /* not changed once the page is created */
+    UI32_T                          magic;
+    UI32_T                          version;
+    UI32_T                          size;           /* sizeof(HAL_TAU_PKT_STATS_PAGE_T) */
+    UI32_T                          unit;
+
+    volatile UI32_T                 seq;
+    UI32_T                          update_ms;      /* the jiffies of the last update in ms */
+
+    HAL_TAU_PKT_TX_CNT_T            tx_cnt;
+    HAL_TAU_PKT_RX_CNT_T            rx_cnt;
+    UI32_T                          tx_intr_cnt[HAL_TAU_PKT_TX_CHANNEL_LAST];
+    UI32_T                          rx_intr_cnt[HAL_TAU_PKT_RX_CHANNEL_LAST];
+
+    UI32_T                          intf_num;       /* the valid entries of intf */
+    HAL_TAU_PKT_STATS_INTF_T        intf[HAL_TAU_PKT_STATS_INTF_NUM];
+
+} HAL_TAU_PKT_STATS_PAGE_T;
+
 typedef struct
 {
     NPS_ADDR_T                      callback;       /* (unit, ptr_sw_gpd, ptr_cookie) */
@@ -2237,9 +2311,24 @@ typedef struct
     NPS_ADDR_T                      ioctl_gpd_addr;     /* waitRxFree[Out]                  */
     UI32_T                          buf_len;            /* setRxCfg[In]                     */
     HAL_TAU_PKT_IOCTL_RX_TYPE_T     rx_type;            /* setRxCfg[In]                     */
+    HAL_TAU_PKT_RX_SCHED_T          sched_mode;         /* setRxCfg[In], getRxCfg[Out]      */
+    UI32_T                          weight;             /* setRxCfg[In], getRxCfg[Out]      */
+    UI32_T                          depth;              /* setRxCfg[In], getRxCfg[Out]      */
 
 } HAL_TAU_PKT_IOCTL_RX_COOKIE_T;
 
+typedef struct
+{
+    UI32_T                          unit;
+    UI32_T                          pkt_num;            /* waitRxFreeBulk[In]: size of the cookie array
+                                                         * waitRxFreeBulk[Out]: number of dequeued packets
+                                                         */
+    NPS_ADDR_T                      rx_cookie_addr;     /* Pointer to HAL_TAU_PKT_IOCTL_RX_COOKIE_T array,
+                                                         * the ioctl_gpd_addr of each cookie receives a packet
+                                                         */
+
+} HAL_TAU_PKT_IOCTL_RX_BULK_COOKIE_T;
+
 typedef struct
 {
     UI32_T                          port;
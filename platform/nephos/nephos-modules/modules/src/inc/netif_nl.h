@@ -98,7 +98,14 @@ netif_nl_getNetlink(
     NETIF_NL_NETLINK_T                  *ptr_netlink);
 
 
+NPS_ERROR_NO_T
+netif_nl_flush(
+    const UI32_T                        unit);
+
 NPS_ERROR_NO_T
 netif_nl_init(void);
 
+NPS_ERROR_NO_T
+netif_nl_deinit(void);
+
 #endif /* end of NETIF_NL_H */
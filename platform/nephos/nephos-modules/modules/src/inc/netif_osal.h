@@ -133,13 +133,19 @@ typedef struct
 typedef struct
 {
     char                    name[OSAL_QUEUE_NAME_LEN + 1];
-    int                     head;           /* index of the queue head entry can be read  */
-    int                     tail;           /* index of the queue tail entry can be write */
-    unsigned int            wr_cnt;         /* enqueue total count                        */
-    unsigned int            rd_cnt;         /* dequeue total count                        */
     unsigned int            capacity;       /* the queue size                             */
     linux_queue_entry_t     *ptr_entry;     /* the queue entry buffer                     */
 
+    /* producer side */
+    int                     tail            /* index of the queue tail entry can be write */
+                            ____cacheline_aligned_in_smp;
+    unsigned int            wr_cnt;         /* enqueue total count                        */
+
+    /* consumer side */
+    int                     head            /* index of the queue head entry can be read  */
+                            ____cacheline_aligned_in_smp;
+    unsigned int            rd_cnt;         /* dequeue total count                        */
+
 } linux_queue_t;
 
 typedef struct
@@ -196,6 +202,16 @@ osal_createThread (
     void                    *ptr_arg,
     NPS_THREAD_ID_T         *ptr_thread_id);
 
+NPS_ERROR_NO_T
+osal_setThreadPriority(
+    NPS_THREAD_ID_T         *ptr_thread_id,
+    const UI32_T            priority);
+
+NPS_ERROR_NO_T
+osal_setThreadCpuMask(
+    NPS_THREAD_ID_T         *ptr_thread_id,
+    const UI32_T            cpu_mask);
+
 NPS_ERROR_NO_T
 osal_stopThread(
     NPS_THREAD_ID_T         *ptr_thread_id);
@@ -299,6 +315,20 @@ osal_que_deque(
     NPS_HUGE_T              *ptr_queue_id,
     void                    **pptr_data);
 
+NPS_ERROR_NO_T
+osal_que_enqueBulk(
+    NPS_HUGE_T              *ptr_queue_id,
+    void                    **pptr_data,
+    const UI32_T            num,
+    UI32_T                  *ptr_count);
+
+NPS_ERROR_NO_T
+osal_que_dequeBulk(
+    NPS_HUGE_T              *ptr_queue_id,
+    void                    **pptr_data,
+    const UI32_T            num,
+    UI32_T                  *ptr_count);
+
 NPS_ERROR_NO_T
 osal_que_destroy(
     NPS_HUGE_T              *ptr_queue_id);
@@ -368,6 +398,18 @@ osal_skb_unmapDma(
     UI32_T                  size,
     enum dma_data_direction dir);
 
+void
+osal_skb_syncDmaForCpu(
+    const dma_addr_t        phy_addr,
+    UI32_T                  size,
+    enum dma_data_direction dir);
+
+void
+osal_skb_syncDmaForDevice(
+    const dma_addr_t        phy_addr,
+    UI32_T                  size,
+    enum dma_data_direction dir);
+
 void
 osal_skb_send(
     struct sk_buff          *ptr_skb);
@@ -24,6 +24,70 @@
 
 /* #define PERF_EN_TEST */
 
+/* -------------------------------------------------------------- suite */
+#define PERF_SUITE_LEN_NUM_MAX      (8)
+#define PERF_SUITE_RESULT_NUM_MAX   (PERF_SUITE_LEN_NUM_MAX * 12)  /* len x (Tx GPD/SKB + Rx) x channel */
+#define PERF_LAT_BUCKET_NUM         (32)    /* bucket n: 2^(n-1) <= latency (ns) < 2^n, the last one holds the rest */
+
+typedef enum
+{
+    PERF_DIR_TX = 0,
+    PERF_DIR_RX,
+    PERF_DIR_LAST,
+
+} PERF_DIR_T;
+
+typedef enum
+{
+    PERF_LAT_SKB = 0,               /* Rx GPD done -> skb delivered to the kernel stack */
+    PERF_LAT_USER,                  /* Rx GPD done -> packet dequeued by the user space */
+    PERF_LAT_LAST,
+
+} PERF_LAT_T;
+
+#define PERF_SUITE_PATH_GPD         (0x1UL << 0)    /* Tx by sendGpd, the user-space ioctl path */
+#define PERF_SUITE_PATH_SKB         (0x1UL << 1)    /* Tx by the netdev, the skb path           */
+
+typedef struct
+{
+    PERF_DIR_T                  dir;
+    BOOL_T                      test_skb;
+    UI32_T                      len;
+    UI32_T                      channel;
+    UI32_T                      num;
+    UI32_T                      duration;       /* us   */
+    UI32_T                      pps;
+    UI32_T                      mbps;
+    UI32_T                      intr;
+    UI32_T                      fail;
+
+} PERF_RESULT_T;
+
+typedef struct
+{
+    UI32_T                      cnt;
+    UI32_T                      max;            /* ns   */
+    UI32_T                      bucket[PERF_LAT_BUCKET_NUM];
+
+} PERF_LAT_HIST_T;
+
+typedef struct
+{
+    UI32_T                      unit;
+    UI32_T                      len_num;                            /* [In]  */
+    UI32_T                      len[PERF_SUITE_LEN_NUM_MAX];        /* [In]  */
+    UI32_T                      pkt_num;                            /* [In]  packets per test, 0: default */
+    UI32_T                      tx_channel_max;                     /* [In]  sweep 1..max Tx channels, 0: skip */
+    UI32_T                      rx_channel_max;                     /* [In]  sweep 1..max Rx channels, 0: skip */
+    UI32_T                      tx_path_bmp;                        /* [In]  PERF_SUITE_PATH_XXX */
+    UI32_T                      lat_duration;                       /* [In]  ms to sample latency, 0: skip */
+    UI32_T                      result_num;                         /* [Out] */
+    PERF_RESULT_T               result[PERF_SUITE_RESULT_NUM_MAX];  /* [Out] */
+    PERF_LAT_HIST_T             lat_hist[PERF_LAT_LAST];            /* [Out] */
+    NPS_ERROR_NO_T              rc;                                 /* [Out] */
+
+} PERF_SUITE_COOKIE_T;
+
 /* FUNCTION NAME: perf_rxCallback
  * PURPOSE:
  *      To count the Rx-gpd for Rx-test.
@@ -78,4 +142,59 @@ perf_test(
     UI32_T                      rx_channel,
     BOOL_T                      test_skb);
 
+/* FUNCTION NAME: perf_runSuite
+ * PURPOSE:
+ *      To run the Tx/Rx tests over the packet lengths and channel numbers,
+ *      and to sample the Rx latency.
+ * INPUT:
+ *      ptr_cookie  -- The suite configuration
+ * OUTPUT:
+ *      ptr_cookie  -- The results of each test and the latency histograms
+ * RETURN:
+ *      NPS_E_OK    -- Successful operation.
+ *      NPS_E_BAD_PARAMETER -- Invalid configuration.
+ * NOTES:
+ *      1. The Rx tests wait for the packets injected by the tester.
+ *      2. The latency is sampled on the normal Rx path, the Rx tests stop the
+ *         delivery of the packets.
+ *      3. Each result is also printed as a "perf," CSV line.
+ */
+NPS_ERROR_NO_T
+perf_runSuite(
+    PERF_SUITE_COOKIE_T         *ptr_cookie);
+
+/* FUNCTION NAME: perf_getTimestamp
+ * PURPOSE:
+ *      To get the timestamp for the latency measurement.
+ * INPUT:
+ *      None
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The lower 32 bits of the monotonic time in ns.
+ * NOTES:
+ *      None
+ */
+UI32_T
+perf_getTimestamp(
+    void);
+
+/* FUNCTION NAME: perf_rxLatency
+ * PURPOSE:
+ *      To record the latency from the Rx GPD done to the measure point.
+ * INPUT:
+ *      point       -- The measure point
+ *      done_ts     -- The timestamp when the Rx GPD is done
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      It does nothing unless the suite is sampling the latency.
+ */
+void
+perf_rxLatency(
+    const PERF_LAT_T            point,
+    const UI32_T                done_ts);
+
 #endif /* end of NETIF_PERF_H */
@@ -36,6 +36,14 @@
 #define OSAL_MDC_DMA_LIST_NAME              "RSRV_DMA"
 #define OSAL_MDC_DMA_SEMAPHORE_NAME         "DMALIST"
 
+#define OSAL_MDC_DMA_HASH_NUM               (1024)      /* buckets of the allocated nodes, power of 2 */
+#define OSAL_MDC_DMA_HASH_SHIFT             (6)         /* lower bits of virt addr skipped by the hash */
+#define OSAL_MDC_DMA_BIN_NUM                (40)        /* bins of the available nodes, in log2 of size */
+#define OSAL_MDC_DMA_SLAB_ALIGN             (256)       /* granularity of the payload size classes */
+#define OSAL_MDC_DMA_SLAB_SZ_MAX            (16 * 1024) /* the largest payload served by the slab */
+#define OSAL_MDC_DMA_SLAB_CLASS_NUM         (OSAL_MDC_DMA_SLAB_SZ_MAX / OSAL_MDC_DMA_SLAB_ALIGN)
+#define OSAL_MDC_DMA_SLAB_CACHE_NUM         (1024)      /* cached free buffers per size class */
+
 /* NAMING CONSTANT DECLARATIONS
  */
 
@@ -63,7 +71,7 @@ typedef struct OSAL_MDC_LIST_S
 
 #endif /* End of defined(NPS_LINUX_KERNEL_MODE) */
 
-typedef struct
+typedef struct OSAL_MDC_DMA_NODE_S
 {
     NPS_ADDR_T          phy_addr;
     void                *ptr_virt_addr;
@@ -73,6 +81,15 @@ typedef struct
     BOOL_T              available;
 #endif
 
+#if defined(NPS_LINUX_KERNEL_MODE)
+    OSAL_MDC_LIST_NODE_T        *ptr_list_node;     /* the list node which holds this data */
+    struct OSAL_MDC_DMA_NODE_S  *ptr_hash_next;     /* next allocated node in the same hash bucket */
+#if defined(NPS_EN_DMA_RESERVED)
+    struct OSAL_MDC_DMA_NODE_S  *ptr_bin_prev;      /* available nodes in the same bin, */
+    struct OSAL_MDC_DMA_NODE_S  *ptr_bin_next;      /* or cached nodes in the same slab class */
+#endif
+#endif
+
 } OSAL_MDC_DMA_NODE_T;
 
 typedef struct
@@ -87,6 +104,15 @@ typedef struct
     void                *ptr_dma_list;      /* the type should be casted again when use */
     NPS_SEMAPHORE_ID_T  sema;
 
+#if defined(NPS_LINUX_KERNEL_MODE)
+    OSAL_MDC_DMA_NODE_T *ptr_hash[OSAL_MDC_DMA_HASH_NUM];       /* allocated nodes by virt addr */
+#if defined(NPS_EN_DMA_RESERVED)
+    OSAL_MDC_DMA_NODE_T *ptr_bin[OSAL_MDC_DMA_BIN_NUM];         /* available nodes by log2 of size */
+    OSAL_MDC_DMA_NODE_T *ptr_slab[OSAL_MDC_DMA_SLAB_CLASS_NUM]; /* cached free buffers by size class */
+    UI32_T              slab_cnt[OSAL_MDC_DMA_SLAB_CLASS_NUM];
+#endif
+#endif
+
 } OSAL_MDC_DMA_INFO_T;
 
 #if defined(NPS_LINUX_USER_MODE)
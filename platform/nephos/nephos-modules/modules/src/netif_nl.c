@@ -31,6 +31,7 @@
 #include <net/genetlink.h>
 
 extern UI32_T       ext_dbg_flag;
+extern UI32_T       nl_batch_num;
 
 #define NETIF_NL_DBG(__flag__, ...)      do                     \
 {                                                               \
@@ -44,6 +45,8 @@ extern UI32_T       ext_dbg_flag;
 
 #define NETIF_NL_FAMILY_NUM_MAX                                 (256)
 #define NETIF_NL_INTF_NUM_MAX                                   (256)
+#define NETIF_NL_DEST_CACHE_NUM                                 (16)
+#define NETIF_NL_FWD_BATCH_NUM                                  (3)     /* evicted, no room, full */
 
 #define NETIF_NL_GET_FAMILY_META(__idx__)                       &(_netif_nl_cb.fam_entry[__idx__].meta)
 #define NETIF_NL_GET_INTF_IGR_SAMPLE_RATE(__inft_id__)          (_netif_nl_cb.intf_entry[__inft_id__].igr_sample_rate)
@@ -59,6 +62,9 @@ extern UI32_T       ext_dbg_flag;
 
 #define NETIF_NL_UNREGISTER_FAMILY(__family__)                  genl_unregister_family(__family__)
 #define NETIF_NL_ALLOC_SKB(__len__)                             genlmsg_new(__len__, GFP_ATOMIC)
+#define NETIF_NL_ALLOC_BATCH_SKB(__len__)                       nlmsg_new(__len__, GFP_ATOMIC)
+#define NETIF_NL_BATCH_SKB_LEN                                  (NLMSG_DEFAULT_SIZE)
+#define NETIF_NL_GET_MSG_TOTAL_SIZE(__payload__)                genlmsg_total_size(__payload__)
 #define NETIF_NL_FREE_SKB(__ptr_skb__)                          nlmsg_free(__ptr_skb__)
 
 #define NETIF_NL_SEND_PKT(__ptr_family__, __mcgrp_id__, __ptr_skb__)                                                    \
@@ -155,11 +161,34 @@ typedef struct
     UI32_T                              trunc_size;
 } NETIF_NL_INTF_ENTRY_T;
 
+/* the family and mc group resolved from the names of a rx destination */
+typedef struct
+{
+    BOOL_T                              valid;
+    NETIF_NL_RX_DST_NETLINK_T           dest;
+    NETIF_NL_FAMILY_T                   *ptr_nl_family;
+    UI32_T                              mcgrp_id;
+
+    /* the samples aggregated in one skb, each sample is still a netlink msg */
+    struct sk_buff                      *ptr_batch_skb;
+    UI32_T                              batch_cnt;
+} NETIF_NL_DEST_CACHE_T;
+
+typedef struct
+{
+    NETIF_NL_FAMILY_T                   *ptr_nl_family;
+    UI32_T                              mcgrp_id;
+    struct sk_buff                      *ptr_nl_skb;
+} NETIF_NL_BATCH_T;
+
 typedef struct
 {
     NETIF_NL_FAMILY_ENTRY_T             fam_entry[NETIF_NL_FAMILY_NUM_MAX];
     NETIF_NL_INTF_ENTRY_T               intf_entry[NETIF_NL_INTF_NUM_MAX];     /* sorted in intf_id */
     UI32_T                              seq_num;
+    NETIF_NL_DEST_CACHE_T               dest_cache[NETIF_NL_DEST_CACHE_NUM];   /* hashed by dest names */
+    UI32_T                              pend_batch_num;
+    NPS_ISRLOCK_ID_T                    lock;                                  /* protect seq_num and dest_cache */
 } NETIF_NL_CB_T;
 
 static NETIF_NL_CB_T                    _netif_nl_cb;
@@ -370,6 +399,53 @@ _netif_nl_setNlMcgroupDefault(
     return (NPS_E_OK);
 }
 
+void
+_netif_nl_detachBatch(
+    NETIF_NL_CB_T                   *ptr_cb,
+    NETIF_NL_DEST_CACHE_T           *ptr_cache,
+    NETIF_NL_BATCH_T                *ptr_batch)
+{
+    ptr_batch->ptr_nl_family = ptr_cache->ptr_nl_family;
+    ptr_batch->mcgrp_id      = ptr_cache->mcgrp_id;
+    ptr_batch->ptr_nl_skb    = ptr_cache->ptr_batch_skb;
+
+    if (NULL != ptr_cache->ptr_batch_skb)
+    {
+        ptr_cache->ptr_batch_skb = NULL;
+        ptr_cache->batch_cnt     = 0;
+        ptr_cb->pend_batch_num--;
+    }
+}
+
+NPS_ERROR_NO_T
+_netif_nl_sendNetlinkSkb(
+    NETIF_NL_FAMILY_T       *ptr_nl_family,
+    UI32_T                  nl_mcgrp_id,
+    struct sk_buff          *ptr_nl_skb);
+
+void
+_netif_nl_sendBatch(
+    NETIF_NL_BATCH_T                *ptr_batch,
+    const UI32_T                    batch_num)
+{
+    UI32_T                          idx;
+
+    /* the skb is consumed by kernel even if the sending failed */
+    for (idx = 0; idx < batch_num; idx++)
+    {
+        if ((NULL != ptr_batch[idx].ptr_nl_skb) && (0 == ptr_batch[idx].ptr_nl_skb->len))
+        {
+            NETIF_NL_FREE_SKB(ptr_batch[idx].ptr_nl_skb);
+        }
+        else if (NULL != ptr_batch[idx].ptr_nl_skb)
+        {
+            _netif_nl_sendNetlinkSkb(ptr_batch[idx].ptr_nl_family,
+                                     ptr_batch[idx].mcgrp_id,
+                                     ptr_batch[idx].ptr_nl_skb);
+        }
+    }
+}
+
 #define NETIF_NL_IS_FAMILY_ENTRY_VALID(__idx__)         \
                                     (TRUE == _netif_nl_cb.fam_entry[__idx__].valid) ? (TRUE) : (FALSE)
 NPS_ERROR_NO_T
@@ -453,12 +529,31 @@ netif_nl_destroyNetlink(
     NETIF_NL_CB_T                   *ptr_cb = &_netif_nl_cb;
     UI32_T                          entry_idx = netlink_id;
     NETIF_NL_FAMILY_T               *ptr_nl_family;
+    NETIF_NL_BATCH_T                batch[NETIF_NL_DEST_CACHE_NUM];
+    NPS_IRQ_FLAGS_T                 irq_flags;
+    UI32_T                          idx;
     int                             ret;
     NPS_ERROR_NO_T                  rc;
 
     if (TRUE == NETIF_NL_IS_FAMILY_ENTRY_VALID(entry_idx))
     {
         ptr_nl_family = NETIF_NL_GET_FAMILY_META(entry_idx);
+
+        /* drop the cached lookups and send the pending samples before unregister */
+        osal_memset(batch, 0x0, sizeof(batch));
+        osal_takeIsrLock(&ptr_cb->lock, &irq_flags);
+        for (idx = 0; idx < NETIF_NL_DEST_CACHE_NUM; idx++)
+        {
+            if ((TRUE == ptr_cb->dest_cache[idx].valid) &&
+                (ptr_nl_family == ptr_cb->dest_cache[idx].ptr_nl_family))
+            {
+                _netif_nl_detachBatch(ptr_cb, &ptr_cb->dest_cache[idx], &batch[idx]);
+                ptr_cb->dest_cache[idx].valid = FALSE;
+            }
+        }
+        osal_giveIsrLock(&ptr_cb->lock, &irq_flags);
+        _netif_nl_sendBatch(batch, NETIF_NL_DEST_CACHE_NUM);
+
         ret = NETIF_NL_UNREGISTER_FAMILY(ptr_nl_family);
         if (0 == ret)
         {
@@ -589,23 +684,13 @@ _netif_nl_getMcgrpIdByName(
     return (rc);
 }
 
-NPS_ERROR_NO_T
-_netif_nl_allocPsampleSkb(
-    NETIF_NL_CB_T               *ptr_cb,
-    NETIF_NL_FAMILY_T           *ptr_nl_family,
+UI32_T
+_netif_nl_getPsampleMsgLen(
     struct sk_buff              *ptr_ori_skb,
-    struct sk_buff              **pptr_nl_skb)
+    UI32_T                      *ptr_data_len)
 {
     UI32_T                      msg_hdr_len;
     UI32_T                      data_len;
-    struct sk_buff              *ptr_nl_skb;
-    UI16_T                      igr_intf_idx;
-    struct net_device_priv      *ptr_priv;
-    UI32_T                      rate;
-    UI32_T                      intf_id;
-    void                        *ptr_nl_hdr = NULL;
-    struct nlattr               *ptr_nl_attr;
-    NPS_ERROR_NO_T              rc = NPS_E_OK;
 
     /* make sure the total len (original pkt len + hdr msg) < PSAMPLE_MAX_PACKET_SIZE */
 
@@ -615,8 +700,6 @@ _netif_nl_allocPsampleSkb(
                   NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T)) +    /* PSAMPLE_ATTR_SAMPLE_GROUP */
                   NETIF_NL_GET_ATTR_TOTAL_SIZE(sizeof(UI32_T));     /* PSAMPLE_ATTR_GROUP_SEQ */
 
-    data_len = NETIF_NL_GET_ATTR_TOTAL_SIZE(ptr_ori_skb->len);
-
     if ((msg_hdr_len + NETIF_NL_GET_ATTR_TOTAL_SIZE(ptr_ori_skb->len)) > NETIF_NL_PSAMPLE_PKT_LEN_MAX)
     {
         data_len = NETIF_NL_PSAMPLE_PKT_LEN_MAX - msg_hdr_len - NLA_HDRLEN - NLA_ALIGNTO;
@@ -626,78 +709,60 @@ _netif_nl_allocPsampleSkb(
         data_len = ptr_ori_skb->len;
     }
 
-    ptr_nl_skb = NETIF_NL_ALLOC_SKB(NETIF_NL_GET_ATTR_TOTAL_SIZE(data_len) + msg_hdr_len);
-    if (NULL != ptr_nl_skb)
-    {
-        /* to create a netlink msg header (cmd=0) */
-        ptr_nl_hdr = NETIF_NL_SET_SKB_ATTR_HDR(ptr_nl_skb, ptr_nl_family, 0, 0);
-        if (NULL != ptr_nl_hdr)
-        {
-            /* obtain the intf index for the igr_port */
-            igr_intf_idx = ptr_ori_skb->dev->ifindex;
-            NETIF_NL_SET_16_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_IIFINDEX,
-                                     (UI16_T)igr_intf_idx);
-
-            /* meta header */
-            /* use the igr port id as the index for the database to get sample rate */
-            ptr_priv = netdev_priv(ptr_ori_skb->dev);
-            intf_id  = ptr_priv->port;
-            rate = NETIF_NL_GET_INTF_IGR_SAMPLE_RATE(intf_id);
-            NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_RATE, rate);
-            NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_ORIGSIZE, data_len);
-            NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_GROUP,
-                                     NETIF_NL_PSAMPLE_DFLT_USR_GROUP_ID);
-            NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_GROUP_SEQ, ptr_cb->seq_num);
-            ptr_cb->seq_num++;
-
-            /* data */
-            ptr_nl_attr = (struct nlattr *)skb_put(ptr_nl_skb, NETIF_NL_GET_ATTR_TOTAL_SIZE(data_len));
-            ptr_nl_attr->nla_type = NETIF_NL_PSAMPLE_ATTR_DATA;
-            /* get the attr size without padding, since it's the last one */
-            ptr_nl_attr->nla_len = NETIF_NL_GET_ATTR_SIZE(data_len);
-            skb_copy_bits(ptr_ori_skb, 0, nla_data(ptr_nl_attr), data_len);
-
-            NETIF_NL_END_SKB_ATTR_HDR(ptr_nl_skb, ptr_nl_hdr);
-        }
-        else
-        {
-            rc = NPS_E_OTHERS;
-        }
-    }
-    else
-    {
-        rc = NPS_E_OTHERS;
-    }
-
-    *pptr_nl_skb = ptr_nl_skb;
+    *ptr_data_len = data_len;
 
-    return (rc);
+    /* the room taken by the whole netlink msg in the skb */
+    return (NETIF_NL_GET_MSG_TOTAL_SIZE(msg_hdr_len + NETIF_NL_GET_ATTR_TOTAL_SIZE(data_len)));
 }
 
 NPS_ERROR_NO_T
-_netif_nl_allocNetlinkSkb(
-    NETIF_NL_CB_T           *ptr_cb,
-    NETIF_NL_FAMILY_T       *ptr_nl_family,
-    struct sk_buff          *ptr_ori_skb,
-    struct sk_buff          **pptr_nl_skb)
+_netif_nl_putPsampleMsg(
+    NETIF_NL_CB_T               *ptr_cb,
+    NETIF_NL_FAMILY_T           *ptr_nl_family,
+    struct sk_buff              *ptr_ori_skb,
+    const UI32_T                data_len,
+    struct sk_buff              *ptr_nl_skb)
 {
-    NPS_ERROR_NO_T      rc = NPS_E_OK;
+    UI16_T                      igr_intf_idx;
+    struct net_device_priv      *ptr_priv;
+    UI32_T                      rate;
+    UI32_T                      intf_id;
+    void                        *ptr_nl_hdr = NULL;
+    struct nlattr               *ptr_nl_attr;
+    NPS_ERROR_NO_T              rc = NPS_E_OK;
 
-    /* need to fill specific skb header format */
-    if (NETIF_NL_FAMILY_IS_PSAMPLE(ptr_nl_family))
+    /* to create a netlink msg header (cmd=0) */
+    ptr_nl_hdr = NETIF_NL_SET_SKB_ATTR_HDR(ptr_nl_skb, ptr_nl_family, 0, 0);
+    if (NULL != ptr_nl_hdr)
     {
-        rc = _netif_nl_allocPsampleSkb(ptr_cb, ptr_nl_family,
-                                       ptr_ori_skb, pptr_nl_skb);
-        if (NPS_E_OK != rc)
-        {
-            NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
-                         "[DBG] alloc netlink skb failed\n");
-        }
+        /* obtain the intf index for the igr_port */
+        igr_intf_idx = ptr_ori_skb->dev->ifindex;
+        NETIF_NL_SET_16_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_IIFINDEX,
+                                 (UI16_T)igr_intf_idx);
+
+        /* meta header */
+        /* use the igr port id as the index for the database to get sample rate */
+        ptr_priv = netdev_priv(ptr_ori_skb->dev);
+        intf_id  = ptr_priv->port;
+        rate = NETIF_NL_GET_INTF_IGR_SAMPLE_RATE(intf_id);
+        NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_RATE, rate);
+        NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_ORIGSIZE, data_len);
+        NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_SAMPLE_GROUP,
+                                 NETIF_NL_PSAMPLE_DFLT_USR_GROUP_ID);
+        NETIF_NL_SET_32_BIT_ATTR(ptr_nl_skb, NETIF_NL_PSAMPLE_ATTR_GROUP_SEQ, ptr_cb->seq_num);
+        ptr_cb->seq_num++;
+
+        /* data */
+        ptr_nl_attr = (struct nlattr *)skb_put(ptr_nl_skb, NETIF_NL_GET_ATTR_TOTAL_SIZE(data_len));
+        ptr_nl_attr->nla_type = NETIF_NL_PSAMPLE_ATTR_DATA;
+        /* get the attr size without padding, since it's the last one */
+        ptr_nl_attr->nla_len = NETIF_NL_GET_ATTR_SIZE(data_len);
+        skb_copy_bits(ptr_ori_skb, 0, nla_data(ptr_nl_attr), data_len);
+
+        NETIF_NL_END_SKB_ATTR_HDR(ptr_nl_skb, ptr_nl_hdr);
     }
     else
     {
-        NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
-                     "[DBG] unknown netlink family\n");
         rc = NPS_E_OTHERS;
     }
 
@@ -737,17 +802,46 @@ _netif_nl_freeNetlinkSkb(
     NETIF_NL_FREE_SKB(ptr_nl_skb);
 }
 
+UI32_T
+_netif_nl_hashDest(
+    const NETIF_NL_RX_DST_NETLINK_T *ptr_nl_dest)
+{
+    UI32_T                      hash = 0;
+    UI32_T                      idx;
+
+    for (idx = 0; (idx < NETIF_NL_NETLINK_NAME_LEN) && ('\0' != ptr_nl_dest->name[idx]); idx++)
+    {
+        hash = (hash * 31) + (UI8_T)ptr_nl_dest->name[idx];
+    }
+    for (idx = 0; (idx < NETIF_NL_NETLINK_NAME_LEN) && ('\0' != ptr_nl_dest->mc_group_name[idx]); idx++)
+    {
+        hash = (hash * 31) + (UI8_T)ptr_nl_dest->mc_group_name[idx];
+    }
+
+    return (hash % NETIF_NL_DEST_CACHE_NUM);
+}
+
 NPS_ERROR_NO_T
-_netif_nl_forwardPkt(
+_netif_nl_lookupDestCache(
     NETIF_NL_CB_T                   *ptr_cb,
     NETIF_NL_RX_DST_NETLINK_T       *ptr_nl_dest,
-    struct sk_buff                  *ptr_ori_skb)
+    NETIF_NL_DEST_CACHE_T           **pptr_cache,
+    NETIF_NL_BATCH_T                *ptr_evict_batch)
 {
-    struct sk_buff              *ptr_nl_skb = NULL;
+    NETIF_NL_DEST_CACHE_T       *ptr_cache = &ptr_cb->dest_cache[_netif_nl_hashDest(ptr_nl_dest)];
     NETIF_NL_FAMILY_T           *ptr_nl_family;
     UI32_T                      nl_mcgrp_id;
     NPS_ERROR_NO_T              rc;
 
+    if ((TRUE == ptr_cache->valid) &&
+        (0 == strncmp(ptr_cache->dest.name, ptr_nl_dest->name, NETIF_NL_NETLINK_NAME_LEN)) &&
+        (0 == strncmp(ptr_cache->dest.mc_group_name, ptr_nl_dest->mc_group_name, NETIF_NL_NETLINK_NAME_LEN)))
+    {
+        *pptr_cache = ptr_cache;
+        return (NPS_E_OK);
+    }
+
+    /* resolve the names once, and take over the slot from the previous dest */
     rc = _netif_nl_getFamilyByName(ptr_cb, ptr_nl_dest->name,
                                    &ptr_nl_family);
     if (NPS_E_OK == rc)
@@ -756,19 +850,95 @@ _netif_nl_forwardPkt(
                                         &nl_mcgrp_id);
         if (NPS_E_OK == rc)
         {
-            rc = _netif_nl_allocNetlinkSkb(ptr_cb, ptr_nl_family,
-                                           ptr_ori_skb, &ptr_nl_skb);
-            if (NPS_E_OK == rc)
+            if (TRUE == ptr_cache->valid)
+            {
+                _netif_nl_detachBatch(ptr_cb, ptr_cache, ptr_evict_batch);
+            }
+            osal_memcpy(&ptr_cache->dest, ptr_nl_dest, sizeof(NETIF_NL_RX_DST_NETLINK_T));
+            ptr_cache->ptr_nl_family = ptr_nl_family;
+            ptr_cache->mcgrp_id      = nl_mcgrp_id;
+            ptr_cache->valid         = TRUE;
+            *pptr_cache = ptr_cache;
+        }
+    }
+
+    return (rc);
+}
+
+NPS_ERROR_NO_T
+_netif_nl_forwardPkt(
+    NETIF_NL_CB_T                   *ptr_cb,
+    NETIF_NL_RX_DST_NETLINK_T       *ptr_nl_dest,
+    struct sk_buff                  *ptr_ori_skb)
+{
+    NETIF_NL_DEST_CACHE_T       *ptr_cache = NULL;
+    NETIF_NL_BATCH_T            batch[NETIF_NL_FWD_BATCH_NUM];
+    NPS_IRQ_FLAGS_T             irq_flags;
+    UI32_T                      msg_len;
+    UI32_T                      data_len;
+    NPS_ERROR_NO_T              rc;
+
+    osal_memset(batch, 0x0, sizeof(batch));
+
+    osal_takeIsrLock(&ptr_cb->lock, &irq_flags);
+    rc = _netif_nl_lookupDestCache(ptr_cb, ptr_nl_dest, &ptr_cache, &batch[0]);
+    if (NPS_E_OK == rc)
+    {
+        /* need to fill specific skb header format */
+        if (NETIF_NL_FAMILY_IS_PSAMPLE(ptr_cache->ptr_nl_family))
+        {
+            msg_len = _netif_nl_getPsampleMsgLen(ptr_ori_skb, &data_len);
+
+            /* no room for this sample, send the previous ones first */
+            if ((NULL != ptr_cache->ptr_batch_skb) &&
+                (skb_tailroom(ptr_cache->ptr_batch_skb) < msg_len))
+            {
+                _netif_nl_detachBatch(ptr_cb, ptr_cache, &batch[1]);
+            }
+
+            if (NULL == ptr_cache->ptr_batch_skb)
             {
-                rc = _netif_nl_sendNetlinkSkb(ptr_nl_family, nl_mcgrp_id,
-                                              ptr_nl_skb);
-                if (NPS_E_OK != rc)
+                ptr_cache->ptr_batch_skb = NETIF_NL_ALLOC_BATCH_SKB(
+                    (msg_len > NETIF_NL_BATCH_SKB_LEN)? msg_len : NETIF_NL_BATCH_SKB_LEN);
+                if (NULL != ptr_cache->ptr_batch_skb)
                 {
-                    /* _netif_nl_freeNetlinkSkb(ptr_nl_skb); */
+                    ptr_cb->pend_batch_num++;
                 }
             }
+
+            if (NULL != ptr_cache->ptr_batch_skb)
+            {
+                rc = _netif_nl_putPsampleMsg(ptr_cb, ptr_cache->ptr_nl_family, ptr_ori_skb,
+                                             data_len, ptr_cache->ptr_batch_skb);
+                if (NPS_E_OK == rc)
+                {
+                    ptr_cache->batch_cnt++;
+                }
+
+                /* the rest are sent by netif_nl_flush() at the end of the rx round */
+                if (ptr_cache->batch_cnt >= nl_batch_num)
+                {
+                    _netif_nl_detachBatch(ptr_cb, ptr_cache, &batch[2]);
+                }
+            }
+            else
+            {
+                NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
+                             "[DBG] alloc netlink skb failed\n");
+                rc = NPS_E_OTHERS;
+            }
+        }
+        else
+        {
+            NETIF_NL_DBG(NETIF_NL_DBG_NETLINK,
+                         "[DBG] unknown netlink family\n");
+            rc = NPS_E_OTHERS;
         }
     }
+    osal_giveIsrLock(&ptr_cb->lock, &irq_flags);
+
+    /* send out of the lock */
+    _netif_nl_sendBatch(batch, NETIF_NL_FWD_BATCH_NUM);
 
     return (rc);
 }
@@ -795,10 +965,39 @@ netif_nl_rxSkb(
     return (rc);
 }
 
+NPS_ERROR_NO_T
+netif_nl_flush(
+    const UI32_T                unit)
+{
+    NETIF_NL_CB_T               *ptr_cb = &_netif_nl_cb;
+    NETIF_NL_BATCH_T            batch[NETIF_NL_DEST_CACHE_NUM];
+    NPS_IRQ_FLAGS_T             irq_flags;
+    UI32_T                      idx;
+
+    /* a sample added after the check is flushed by its own rx path */
+    if (0 == ptr_cb->pend_batch_num)
+    {
+        return (NPS_E_OK);
+    }
+
+    osal_memset(batch, 0x0, sizeof(batch));
+    osal_takeIsrLock(&ptr_cb->lock, &irq_flags);
+    for (idx = 0; idx < NETIF_NL_DEST_CACHE_NUM; idx++)
+    {
+        _netif_nl_detachBatch(ptr_cb, &ptr_cb->dest_cache[idx], &batch[idx]);
+    }
+    osal_giveIsrLock(&ptr_cb->lock, &irq_flags);
+
+    _netif_nl_sendBatch(batch, NETIF_NL_DEST_CACHE_NUM);
+
+    return (NPS_E_OK);
+}
+
 NPS_ERROR_NO_T
 netif_nl_init(void)
 {
     osal_memset(&_netif_nl_cb, 0x0, sizeof(NETIF_NL_CB_T));
+    osal_createIsrLock("NL_LOCK", &_netif_nl_cb.lock);
 
     return (NPS_E_OK);
 }
@@ -806,6 +1005,22 @@ netif_nl_init(void)
 NPS_ERROR_NO_T
 netif_nl_deinit(void)
 {
+    NETIF_NL_CB_T               *ptr_cb = &_netif_nl_cb;
+    UI32_T                      idx;
+
+    /* all the rx paths are stopped, drop the pending samples */
+    for (idx = 0; idx < NETIF_NL_DEST_CACHE_NUM; idx++)
+    {
+        if (NULL != ptr_cb->dest_cache[idx].ptr_batch_skb)
+        {
+            _netif_nl_freeNetlinkSkb(ptr_cb->dest_cache[idx].ptr_batch_skb);
+            ptr_cb->dest_cache[idx].ptr_batch_skb = NULL;
+        }
+        ptr_cb->dest_cache[idx].valid = FALSE;
+    }
+    ptr_cb->pend_batch_num = 0;
+    osal_destroyIsrLock(&ptr_cb->lock);
+
     return (NPS_E_OK);
 }
 
@@ -36,6 +36,9 @@
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 11, 0)
 #include <linux/sched/signal.h>
 #endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+#include <uapi/linux/sched/types.h>
+#endif
 #include <netif_osal.h>
 
 /* ----------------------------------------------------------------------------------- macro value */
@@ -151,8 +154,6 @@ osal_createThread(
 
     /* init */
     ptr_thread_node->ptr_task = kthread_create((int(*)(void *))function, ptr_arg, ptr_thread_name);
-    ptr_thread_node->ptr_task->policy = SCHED_RR;
-    ptr_thread_node->ptr_task->rt_priority = priority;
     ptr_thread_node->is_stop = FALSE;
 
     *ptr_thread_id = (NPS_THREAD_ID_T)ptr_thread_node;
@@ -168,6 +169,89 @@ osal_createThread(
     return (NPS_E_OK);
 }
 
+/* priority 0 runs the thread with SCHED_NORMAL, 1 to 99 with SCHED_FIFO */
+NPS_ERROR_NO_T
+osal_setThreadPriority(
+    NPS_THREAD_ID_T         *ptr_thread_id,
+    const UI32_T            priority)
+{
+    linux_thread_t          *ptr_thread_node = (linux_thread_t *)(*ptr_thread_id);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 9, 0)
+    struct sched_attr       attr = {0};
+
+    if (priority >= MAX_RT_PRIO)
+    {
+        return (NPS_E_BAD_PARAMETER);
+    }
+
+    /* sched_setscheduler_nocheck() is not exported any more */
+    attr.size           = sizeof(attr);
+    attr.sched_policy   = (0 == priority)? SCHED_NORMAL : SCHED_FIFO;
+    attr.sched_priority = priority;
+    if (0 != sched_setattr_nocheck(ptr_thread_node->ptr_task, &attr))
+#else
+    struct sched_param      param = {0};
+
+    if (priority >= MAX_RT_PRIO)
+    {
+        return (NPS_E_BAD_PARAMETER);
+    }
+
+    param.sched_priority = priority;
+    if (0 != sched_setscheduler_nocheck(ptr_thread_node->ptr_task,
+                                        (0 == priority)? SCHED_NORMAL : SCHED_FIFO, &param))
+#endif
+    {
+        return (NPS_E_OTHERS);
+    }
+
+    return (NPS_E_OK);
+}
+
+/* bit n of cpu_mask allows CPU n, 0 allows all the CPUs */
+NPS_ERROR_NO_T
+osal_setThreadCpuMask(
+    NPS_THREAD_ID_T         *ptr_thread_id,
+    const UI32_T            cpu_mask)
+{
+    linux_thread_t          *ptr_thread_node = (linux_thread_t *)(*ptr_thread_id);
+    cpumask_var_t           mask;
+    UI32_T                  cpu;
+    NPS_ERROR_NO_T          rc = NPS_E_OK;
+
+    if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+    {
+        return (NPS_E_NO_MEMORY);
+    }
+
+    if (0 == cpu_mask)
+    {
+        cpumask_copy(mask, cpu_possible_mask);
+    }
+    else
+    {
+        for (cpu = 0; (cpu < 32) && (cpu < nr_cpu_ids); cpu++)
+        {
+            if (0 != (cpu_mask & (1U << cpu)))
+            {
+                cpumask_set_cpu(cpu, mask);
+            }
+        }
+        if (!cpumask_intersects(mask, cpu_online_mask))
+        {
+            rc = NPS_E_BAD_PARAMETER;
+        }
+    }
+
+    if ((NPS_E_OK == rc) && (0 != set_cpus_allowed_ptr(ptr_thread_node->ptr_task, mask)))
+    {
+        rc = NPS_E_OTHERS;
+    }
+
+    free_cpumask_var(mask);
+    return (rc);
+}
+
 NPS_ERROR_NO_T
 osal_stopThread(
     NPS_THREAD_ID_T         *ptr_thread_id)
@@ -479,7 +563,14 @@ osal_getTime(
     return (NPS_E_OK);
 }
 
-/* queue */
+/* queue
+ *
+ * The queue is a single-producer/single-consumer ring. The producer only
+ * writes tail and wr_cnt, the consumer only writes head and rd_cnt. The
+ * counters are published with release semantics and read with acquire
+ * semantics, so one producer and one consumer need no lock. Several
+ * producers or several consumers must be serialized by the caller.
+ */
 NPS_ERROR_NO_T
 osal_que_create(
     NPS_HUGE_T              *ptr_queue_id,
@@ -504,55 +595,103 @@ NPS_ERROR_NO_T
 osal_que_enque(
     NPS_HUGE_T              *ptr_queue_id,
     void                    *ptr_data)
+{
+    UI32_T                  count = 0;
+
+    osal_que_enqueBulk(ptr_queue_id, &ptr_data, 1, &count);
+
+    return ((1 == count)? NPS_E_OK : NPS_E_OTHERS);
+}
+
+NPS_ERROR_NO_T
+osal_que_deque(
+    NPS_HUGE_T              *ptr_queue_id,
+    void                    **pptr_data)
+{
+    UI32_T                  count = 0;
+
+    osal_que_dequeBulk(ptr_queue_id, pptr_data, 1, &count);
+
+    return ((1 == count)? NPS_E_OK : NPS_E_OTHERS);
+}
+
+NPS_ERROR_NO_T
+osal_que_enqueBulk(
+    NPS_HUGE_T              *ptr_queue_id,
+    void                    **pptr_data,
+    const UI32_T            num,
+    UI32_T                  *ptr_count)
 {
     linux_queue_t           *ptr_queue = (linux_queue_t *)(*ptr_queue_id);
+    unsigned int            wr_cnt = ptr_queue->wr_cnt;
+    unsigned int            room;
+    UI32_T                  idx;
 
-    if (ptr_queue->wr_cnt - ptr_queue->rd_cnt >= ptr_queue->capacity)
+    /* pairs with the release of rd_cnt by the consumer */
+    room = ptr_queue->capacity - (wr_cnt - smp_load_acquire(&ptr_queue->rd_cnt));
+    if (room > num)
     {
-        return (NPS_E_OTHERS);
+        room = num;
     }
 
-    /* save data to the tail */
-    ptr_queue->ptr_entry[ptr_queue->tail].ptr_data = ptr_data;
-
-    /* calculate tail and wr_cnt */
-    ptr_queue->tail++;
-    if (ptr_queue->tail >= ptr_queue->capacity)
+    for (idx = 0; idx < room; idx++)
     {
-        ptr_queue->tail = 0;
+        /* save data to the tail */
+        ptr_queue->ptr_entry[ptr_queue->tail].ptr_data = pptr_data[idx];
+
+        ptr_queue->tail++;
+        if (ptr_queue->tail >= ptr_queue->capacity)
+        {
+            ptr_queue->tail = 0;
+        }
     }
 
-    ptr_queue->wr_cnt++;
+    /* publish the entries to the consumer */
+    smp_store_release(&ptr_queue->wr_cnt, wr_cnt + room);
 
-    return (NPS_E_OK);
+    *ptr_count = room;
+
+    return ((room > 0)? NPS_E_OK : NPS_E_OTHERS);
 }
 
 NPS_ERROR_NO_T
-osal_que_deque(
+osal_que_dequeBulk(
     NPS_HUGE_T              *ptr_queue_id,
-    void                    **pptr_data)
+    void                    **pptr_data,
+    const UI32_T            num,
+    UI32_T                  *ptr_count)
 {
     linux_queue_t           *ptr_queue = (linux_queue_t *)(*ptr_queue_id);
+    unsigned int            rd_cnt = ptr_queue->rd_cnt;
+    unsigned int            avbl;
+    UI32_T                  idx;
 
-    if (ptr_queue->wr_cnt == ptr_queue->rd_cnt)
+    /* pairs with the release of wr_cnt by the producer */
+    avbl = smp_load_acquire(&ptr_queue->wr_cnt) - rd_cnt;
+    if (avbl > num)
     {
-        return (NPS_E_OTHERS);
+        avbl = num;
     }
 
-    /* get data from head */
-    *pptr_data = ptr_queue->ptr_entry[ptr_queue->head].ptr_data;
-    ptr_queue->ptr_entry[ptr_queue->head].ptr_data = NULL;
-
-    /* calculate head and rd_cnt */
-    ptr_queue->head++;
-    if (ptr_queue->head >= ptr_queue->capacity)
+    for (idx = 0; idx < avbl; idx++)
     {
-        ptr_queue->head = 0;
+        /* get data from head */
+        pptr_data[idx] = ptr_queue->ptr_entry[ptr_queue->head].ptr_data;
+        ptr_queue->ptr_entry[ptr_queue->head].ptr_data = NULL;
+
+        ptr_queue->head++;
+        if (ptr_queue->head >= ptr_queue->capacity)
+        {
+            ptr_queue->head = 0;
+        }
     }
 
-    ptr_queue->rd_cnt++;
+    /* give the entries back to the producer */
+    smp_store_release(&ptr_queue->rd_cnt, rd_cnt + avbl);
 
-    return (NPS_E_OK);
+    *ptr_count = avbl;
+
+    return ((avbl > 0)? NPS_E_OK : NPS_E_OTHERS);
 }
 
 NPS_ERROR_NO_T
@@ -575,7 +714,7 @@ osal_que_getCount(
 {
     linux_queue_t           *ptr_queue = (linux_queue_t *)(*ptr_queue_id);
 
-    *ptr_count = ptr_queue->wr_cnt - ptr_queue->rd_cnt;
+    *ptr_count = READ_ONCE(ptr_queue->wr_cnt) - READ_ONCE(ptr_queue->rd_cnt);
 
     return (NPS_E_OK);
 }
@@ -733,6 +872,28 @@ osal_skb_unmapDma(
     dma_unmap_single(ptr_dev, phy_addr, size, dir);
 }
 
+void
+osal_skb_syncDmaForCpu(
+    const dma_addr_t            phy_addr,
+    UI32_T                      size,
+    enum dma_data_direction     dir)
+{
+    struct device           *ptr_dev = &_ptr_ext_pci_dev->dev;
+
+    dma_sync_single_for_cpu(ptr_dev, phy_addr, size, dir);
+}
+
+void
+osal_skb_syncDmaForDevice(
+    const dma_addr_t            phy_addr,
+    UI32_T                      size,
+    enum dma_data_direction     dir)
+{
+    struct device           *ptr_dev = &_ptr_ext_pci_dev->dev;
+
+    dma_sync_single_for_device(ptr_dev, phy_addr, size, dir);
+}
+
 void
 osal_skb_send(
     struct sk_buff          *ptr_skb)
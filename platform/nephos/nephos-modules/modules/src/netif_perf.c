@@ -87,14 +87,6 @@ typedef NPS_ERROR_NO_T
     UI32_T                     *ptr_intr_cnt);
 
 /* -------------------------------------------------------------- structs */
-typedef enum
-{
-    PERF_DIR_TX = 0,
-    PERF_DIR_RX,
-    PERF_DIR_LAST,
-
-} PERF_DIR_T;
-
 typedef struct
 {
     UI32_T                      unit;
@@ -146,6 +138,15 @@ typedef struct
 
 } PERF_RX_PERF_CB_T;
 
+typedef struct
+{
+    BOOL_T                      enable;
+    atomic_t                    cnt    [PERF_LAT_LAST];
+    UI32_T                      max    [PERF_LAT_LAST];
+    atomic_t                    bucket [PERF_LAT_LAST][PERF_LAT_BUCKET_NUM];
+
+} PERF_LAT_CB_T;
+
 /* -------------------------------------------------------------- statics */
 static PERF_TX_PERF_CB_T        _perf_tx_perf_cb =
 {
@@ -173,6 +174,8 @@ static PERF_RX_PERF_CB_T        _perf_rx_perf_cb =
 #endif
 };
 
+static PERF_LAT_CB_T            _perf_lat_cb;
+
 /* -------------------------------------------------------------- functions */
 static void
 _perf_duplicateRxPacket(
@@ -184,26 +187,55 @@ _perf_duplicateRxPacket(
 }
 
 static void
-_perf_showPerf(
+_perf_fillResult(
     PERF_DIR_T                  dir,
     UI32_T                      channel,
     UI32_T                      len,
     UI32_T                      num,
     UI32_T                      intr,
-    UI32_T                      duration)
+    UI32_T                      duration,
+    BOOL_T                      test_skb,
+    PERF_RESULT_T               *ptr_result)
 {
     UI32_T                      tx_channel = 0;
-    UI32_T                      tx_fail = 0;
 
-    if (duration < 1000)
+    osal_memset(ptr_result, 0x0, sizeof(PERF_RESULT_T));
+    ptr_result->dir      = dir;
+    ptr_result->test_skb = test_skb;
+    ptr_result->len      = len;
+    ptr_result->channel  = channel;
+    ptr_result->num      = num;
+    ptr_result->duration = duration;
+    ptr_result->intr     = intr;
+
+    if (duration >= 1000)
+    {
+        ptr_result->pps  = (num * 1000) / (duration / 1000);
+        ptr_result->mbps = ((num / 1000) * len * 8) / (duration / 1000);
+    }
+
+    if (PERF_DIR_TX == dir)
     {
-        osal_printf("***Error***, %d packets cost < 1000 us.\n", num);
+        for (tx_channel = 0; tx_channel < channel; tx_channel++)
+        {
+            ptr_result->fail += _perf_tx_perf_cb.send_fail[tx_channel];
+        }
+    }
+}
+
+static void
+_perf_showPerf(
+    const PERF_RESULT_T         *ptr_result)
+{
+    if (ptr_result->duration < 1000)
+    {
+        osal_printf("***Error***, %d packets cost < 1000 us.\n", ptr_result->num);
         return ;
     }
 
     osal_printf("\n");
 
-    if (PERF_DIR_TX == dir)
+    if (PERF_DIR_TX == ptr_result->dir)
     {
         osal_printf("Tx-perf\n");
     }
@@ -213,27 +245,35 @@ _perf_showPerf(
     }
 
     osal_printf("------------------------------------\n");
-    osal_printf("channel number          : %d\n", channel);
-    osal_printf("packet length    (bytes): %d\n", len);
-    osal_printf("packet number           : %d\n", num);
-    osal_printf("time duration    (us)   : %d\n", duration);
+    osal_printf("channel number          : %d\n", ptr_result->channel);
+    osal_printf("packet length    (bytes): %d\n", ptr_result->len);
+    osal_printf("packet number           : %d\n", ptr_result->num);
+    osal_printf("time duration    (us)   : %d\n", ptr_result->duration);
     osal_printf("------------------------------------\n");
-    osal_printf("avg. packet rate (pps)  : %d\n", (num * 1000) / (duration / 1000));
-    osal_printf("avg. throughput  (Mbps) : %d\n", ((num / 1000) * len * 8) / (duration / 1000));
-    osal_printf("interrupt number        : %d\n", intr);
+    osal_printf("avg. packet rate (pps)  : %d\n", ptr_result->pps);
+    osal_printf("avg. throughput  (Mbps) : %d\n", ptr_result->mbps);
+    osal_printf("interrupt number        : %d\n", ptr_result->intr);
 
-    if (PERF_DIR_TX == dir)
+    if (PERF_DIR_TX == ptr_result->dir)
     {
-        for (tx_channel = 0; tx_channel < channel; tx_channel++)
-        {
-            tx_fail += _perf_tx_perf_cb.send_fail[tx_channel];
-        }
-        osal_printf("Tx fail                 : %d\n", tx_fail);
+        osal_printf("Tx fail                 : %d\n", ptr_result->fail);
     }
 
     osal_printf("------------------------------------\n");
 }
 
+static void
+_perf_showPerfCsv(
+    const PERF_RESULT_T         *ptr_result)
+{
+    /* perf,dir,path,len,channel,num,duration_us,pps,mbps,intr,fail */
+    osal_printf("perf,%s,%s,%u,%u,%u,%u,%u,%u,%u,%u\n",
+                (PERF_DIR_TX == ptr_result->dir)? "tx" : "rx",
+                (PERF_DIR_RX == ptr_result->dir)? "-" : ((TRUE == ptr_result->test_skb)? "skb" : "gpd"),
+                ptr_result->len, ptr_result->channel, ptr_result->num, ptr_result->duration,
+                ptr_result->pps, ptr_result->mbps, ptr_result->intr, ptr_result->fail);
+}
+
 static void
 _perf_getIntrCnt(
     UI32_T                      unit,
@@ -314,11 +354,23 @@ _perf_txTask(
             if (TRUE == test_skb)
             {
                 ptr_skb = osal_skb_alloc(len);
+                if (NULL == ptr_skb)
+                {
+                    osal_printf("***Error***, alloc skb fail.\n");
+                    break;
+                }
                 ptr_skb->len = len;
                 _perf_tx_perf_cb.get_netdev(unit, port, &ptr_skb->dev);
+                if (NULL == ptr_skb->dev)
+                {
+                    osal_printf("***Error***, port-%d netdev not found.\n", port);
+                    osal_skb_free(ptr_skb);
+                    break;
+                }
 
                 /* send skb */
                 osal_skb_send(ptr_skb);
+                _perf_tx_perf_cb.send_ok[channel]++;
             }
             else
             {
@@ -396,6 +448,7 @@ _perf_txInit(
     const UI32_T                unit,
     const UI32_T                tx_channel,
     const UI32_T                len,
+    const UI32_T                num,
     BOOL_T                      test_skb)
 {
     UI32_T                      channel = 0;
@@ -412,7 +465,7 @@ _perf_txInit(
         _perf_tx_perf_cb.tx_cookie[channel].unit     = unit;
         _perf_tx_perf_cb.tx_cookie[channel].channel  = channel;
         _perf_tx_perf_cb.tx_cookie[channel].len      = len;
-        _perf_tx_perf_cb.tx_cookie[channel].num      = PERF_TX_PERF_NUM / tx_channel;
+        _perf_tx_perf_cb.tx_cookie[channel].num      = num / tx_channel;
         _perf_tx_perf_cb.tx_cookie[channel].port     = 0;
         _perf_tx_perf_cb.tx_cookie[channel].test_skb = test_skb;
 
@@ -444,15 +497,17 @@ static void
 _perf_rxInit(
     const UI32_T                unit,
     const UI32_T                rx_channel,
-    const UI32_T                len)
+    const UI32_T                len,
+    const UI32_T                num)
 {
     /* enable duplicate Rx packets to channels */
     _perf_duplicateRxPacket(unit, rx_channel, TRUE);
 
     /* create Rx callback resources */
-    _perf_rx_perf_cb.target_num = PERF_RX_PERF_NUM;
+    _perf_rx_perf_cb.target_num = num;
     _perf_rx_perf_cb.target_len = len;
     _perf_rx_perf_cb.recv_pass = 0;
+    _perf_rx_perf_cb.recv_fail = 0;
 
     osal_createEvent("RX_START", &_perf_rx_perf_cb.start_sync);
     osal_createEvent("RX_END",   &_perf_rx_perf_cb.end_sync);
@@ -534,32 +589,21 @@ perf_rxTest(void)
     return (NPS_E_OK);
 }
 
-/* FUNCTION NAME: perf_test
- * PURPOSE:
- *      To do Tx-test or Rx-test.
- * INPUT:
- *      len         -- Test length
- *      tx_channel  -- Test Tx channel numbers
- *      rx_channel  -- Test Rx channel numbers
- *      test_skb    -- Test GPD or SKB
- * OUTPUT:
- *      None
- * RETURN:
- *      NPS_E_OK    -- Successful operation.
- * NOTES:
- *      None
- */
-NPS_ERROR_NO_T
-perf_test(
+static NPS_ERROR_NO_T
+_perf_runTest(
+    UI32_T                      unit,
     UI32_T                      len,
+    UI32_T                      num,
     UI32_T                      tx_channel,
     UI32_T                      rx_channel,
-    BOOL_T                      test_skb)
+    BOOL_T                      test_skb,
+    PERF_RESULT_T               *ptr_tx_result,
+    PERF_RESULT_T               *ptr_rx_result)
 {
     NPS_ERROR_NO_T              rc = NPS_E_OK;
     NPS_TIME_T                  start_time;
     NPS_TIME_T                  end_time;
-    UI32_T                      unit = 0, channel = 0;
+    UI32_T                      channel = 0;
     UI32_T                      tx_pkt_cnt = 0, tx_start_intr = 0, tx_end_intr = 0;
     UI32_T                      rx_pkt_cnt = 0, rx_start_intr = 0, rx_end_intr = 0;
 
@@ -573,8 +617,8 @@ perf_test(
     {
         _perf_getIntrCnt(unit, PERF_DIR_TX, &tx_start_intr);
         _perf_getIntrCnt(unit, PERF_DIR_RX, &rx_start_intr);
-        _perf_txInit(unit, tx_channel, len, test_skb);
-        _perf_rxInit(unit, rx_channel, len);
+        _perf_txInit(unit, tx_channel, len, num, test_skb);
+        _perf_rxInit(unit, rx_channel, len, num);
 
         /* wait 1st Rx GPD done */
         osal_waitEvent(&_perf_rx_perf_cb.start_sync);
@@ -599,16 +643,18 @@ perf_test(
         _perf_getIntrCnt(unit, PERF_DIR_TX, &tx_end_intr);
         _perf_getIntrCnt(unit, PERF_DIR_RX, &rx_end_intr);
 
-        _perf_showPerf(PERF_DIR_TX,
-            tx_channel, len, tx_pkt_cnt, tx_end_intr - tx_start_intr, end_time - start_time);
+        _perf_fillResult(PERF_DIR_TX,
+            tx_channel, len, tx_pkt_cnt, tx_end_intr - tx_start_intr, end_time - start_time,
+            test_skb, ptr_tx_result);
 
-        _perf_showPerf(PERF_DIR_RX,
-            rx_channel, len, rx_pkt_cnt, rx_end_intr - rx_start_intr, end_time - start_time);
+        _perf_fillResult(PERF_DIR_RX,
+            rx_channel, len, rx_pkt_cnt, rx_end_intr - rx_start_intr, end_time - start_time,
+            FALSE, ptr_rx_result);
     }
     else if (tx_channel > 0)
     {
         _perf_getIntrCnt(unit, PERF_DIR_TX, &tx_start_intr);
-        _perf_txInit(unit, tx_channel, len, test_skb);
+        _perf_txInit(unit, tx_channel, len, num, test_skb);
 
         /* ------------- in-time ------------- */
         osal_getTime(&start_time);
@@ -627,13 +673,14 @@ perf_test(
         _perf_txDeinit(unit, tx_channel);
         _perf_getIntrCnt(unit, PERF_DIR_TX, &tx_end_intr);
 
-        _perf_showPerf(PERF_DIR_TX,
-            tx_channel, len, tx_pkt_cnt, tx_end_intr - tx_start_intr, end_time - start_time);
+        _perf_fillResult(PERF_DIR_TX,
+            tx_channel, len, tx_pkt_cnt, tx_end_intr - tx_start_intr, end_time - start_time,
+            test_skb, ptr_tx_result);
     }
     else if (rx_channel > 0)
     {
         _perf_getIntrCnt(unit, PERF_DIR_RX, &rx_start_intr);
-        _perf_rxInit(unit, rx_channel, len);
+        _perf_rxInit(unit, rx_channel, len, num);
 
         /* wait 1st Rx GPD done */
         osal_waitEvent(&_perf_rx_perf_cb.start_sync);
@@ -647,10 +694,221 @@ perf_test(
         _perf_rxDeinit(unit, rx_channel);
         _perf_getIntrCnt(unit, PERF_DIR_RX, &rx_end_intr);
 
-        _perf_showPerf(PERF_DIR_RX,
-            rx_channel, len, PERF_RX_PERF_NUM, rx_end_intr - rx_start_intr, end_time - start_time);
+        _perf_fillResult(PERF_DIR_RX,
+            rx_channel, len, num, rx_end_intr - rx_start_intr, end_time - start_time,
+            FALSE, ptr_rx_result);
+    }
+
+    return (rc);
+}
+
+
+/* FUNCTION NAME: perf_test
+ * PURPOSE:
+ *      To do Tx-test or Rx-test.
+ * INPUT:
+ *      len         -- Test length
+ *      tx_channel  -- Test Tx channel numbers
+ *      rx_channel  -- Test Rx channel numbers
+ *      test_skb    -- Test GPD or SKB
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      NPS_E_OK    -- Successful operation.
+ * NOTES:
+ *      None
+ */
+NPS_ERROR_NO_T
+perf_test(
+    UI32_T                      len,
+    UI32_T                      tx_channel,
+    UI32_T                      rx_channel,
+    BOOL_T                      test_skb)
+{
+    NPS_ERROR_NO_T              rc = NPS_E_OK;
+    PERF_RESULT_T               tx_result;
+    PERF_RESULT_T               rx_result;
+
+    rc = _perf_runTest(0, len, (tx_channel > 0)? PERF_TX_PERF_NUM : PERF_RX_PERF_NUM,
+                       tx_channel, rx_channel, test_skb, &tx_result, &rx_result);
+    if (NPS_E_OK == rc)
+    {
+        if (tx_channel > 0)
+        {
+            _perf_showPerf(&tx_result);
+        }
+        if (rx_channel > 0)
+        {
+            _perf_showPerf(&rx_result);
+        }
     }
 
     return (rc);
 }
 
+/* FUNCTION NAME: perf_runSuite
+ * PURPOSE:
+ *      To run the Tx/Rx tests over the packet lengths and channel numbers,
+ *      and to sample the Rx latency.
+ * INPUT:
+ *      ptr_cookie  -- The suite configuration
+ * OUTPUT:
+ *      ptr_cookie  -- The results of each test and the latency histograms
+ * RETURN:
+ *      NPS_E_OK    -- Successful operation.
+ *      NPS_E_BAD_PARAMETER -- Invalid configuration.
+ * NOTES:
+ *      1. The Rx tests wait for the packets injected by the tester.
+ *      2. The latency is sampled on the normal Rx path, the Rx tests stop the
+ *         delivery of the packets.
+ *      3. Each result is also printed as a "perf," CSV line.
+ */
+NPS_ERROR_NO_T
+perf_runSuite(
+    PERF_SUITE_COOKIE_T         *ptr_cookie)
+{
+    UI32_T                      unit = ptr_cookie->unit;
+    UI32_T                      num = (0 != ptr_cookie->pkt_num)? ptr_cookie->pkt_num : PERF_TX_PERF_NUM;
+    UI32_T                      len_idx = 0, channel = 0, point = 0, idx = 0;
+    PERF_RESULT_T               *ptr_result = NULL;
+    PERF_RESULT_T               dummy_result;
+    PERF_LAT_HIST_T             *ptr_hist = NULL;
+
+    ptr_cookie->result_num = 0;
+    osal_memset(ptr_cookie->lat_hist, 0x0, sizeof(ptr_cookie->lat_hist));
+
+    if ((ptr_cookie->len_num > PERF_SUITE_LEN_NUM_MAX) ||
+        (ptr_cookie->tx_channel_max > PERF_TX_CHANNEL_NUM_MAX) ||
+        (ptr_cookie->rx_channel_max > PERF_RX_CHANNEL_NUM_MAX))
+    {
+        return (NPS_E_BAD_PARAMETER);
+    }
+
+    osal_printf("perf,dir,path,len,channel,num,duration_us,pps,mbps,intr,fail\n");
+    for (len_idx = 0; len_idx < ptr_cookie->len_num; len_idx++)
+    {
+        for (channel = 1; channel <= ptr_cookie->tx_channel_max; channel++)
+        {
+            if (0 != (ptr_cookie->tx_path_bmp & PERF_SUITE_PATH_GPD))
+            {
+                ptr_result = &ptr_cookie->result[ptr_cookie->result_num++];
+                _perf_runTest(unit, ptr_cookie->len[len_idx], num, channel, 0, FALSE,
+                              ptr_result, &dummy_result);
+                _perf_showPerfCsv(ptr_result);
+            }
+            if (0 != (ptr_cookie->tx_path_bmp & PERF_SUITE_PATH_SKB))
+            {
+                ptr_result = &ptr_cookie->result[ptr_cookie->result_num++];
+                _perf_runTest(unit, ptr_cookie->len[len_idx], num, channel, 0, TRUE,
+                              ptr_result, &dummy_result);
+                _perf_showPerfCsv(ptr_result);
+            }
+        }
+
+        for (channel = 1; channel <= ptr_cookie->rx_channel_max; channel++)
+        {
+            ptr_result = &ptr_cookie->result[ptr_cookie->result_num++];
+            _perf_runTest(unit, ptr_cookie->len[len_idx], num, 0, channel, FALSE,
+                          &dummy_result, ptr_result);
+            _perf_showPerfCsv(ptr_result);
+        }
+    }
+
+    if (0 != ptr_cookie->lat_duration)
+    {
+        for (point = 0; point < PERF_LAT_LAST; point++)
+        {
+            atomic_set(&_perf_lat_cb.cnt[point], 0);
+            _perf_lat_cb.max[point] = 0;
+            for (idx = 0; idx < PERF_LAT_BUCKET_NUM; idx++)
+            {
+                atomic_set(&_perf_lat_cb.bucket[point][idx], 0);
+            }
+        }
+
+        _perf_lat_cb.enable = TRUE;
+        osal_sleepThread(ptr_cookie->lat_duration * 1000);
+        _perf_lat_cb.enable = FALSE;
+
+        /* perf_lat,point,cnt,max_ns,bucket_0,...,bucket_31 */
+        for (point = 0; point < PERF_LAT_LAST; point++)
+        {
+            ptr_hist = &ptr_cookie->lat_hist[point];
+            ptr_hist->cnt = atomic_read(&_perf_lat_cb.cnt[point]);
+            ptr_hist->max = _perf_lat_cb.max[point];
+
+            osal_printf("perf_lat,%s,%u,%u", (PERF_LAT_SKB == point)? "skb" : "user",
+                        ptr_hist->cnt, ptr_hist->max);
+            for (idx = 0; idx < PERF_LAT_BUCKET_NUM; idx++)
+            {
+                ptr_hist->bucket[idx] = atomic_read(&_perf_lat_cb.bucket[point][idx]);
+                osal_printf(",%u", ptr_hist->bucket[idx]);
+            }
+            osal_printf("\n");
+        }
+    }
+
+    return (NPS_E_OK);
+}
+
+/* FUNCTION NAME: perf_getTimestamp
+ * PURPOSE:
+ *      To get the timestamp for the latency measurement.
+ * INPUT:
+ *      None
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      The lower 32 bits of the monotonic time in ns.
+ * NOTES:
+ *      None
+ */
+UI32_T
+perf_getTimestamp(
+    void)
+{
+    return ((UI32_T)ktime_get_ns());
+}
+
+/* FUNCTION NAME: perf_rxLatency
+ * PURPOSE:
+ *      To record the latency from the Rx GPD done to the measure point.
+ * INPUT:
+ *      point       -- The measure point
+ *      done_ts     -- The timestamp when the Rx GPD is done
+ * OUTPUT:
+ *      None
+ * RETURN:
+ *      None
+ * NOTES:
+ *      The max is updated without lock, it is only a hint when several
+ *      Rx channels record at the same time.
+ */
+void
+perf_rxLatency(
+    const PERF_LAT_T            point,
+    const UI32_T                done_ts)
+{
+    UI32_T                      latency = 0;
+    UI32_T                      bucket = 0;
+
+    if (FALSE == _perf_lat_cb.enable)
+    {
+        return ;
+    }
+
+    /* the unsigned subtraction handles the wrap-around of the timestamp */
+    latency = perf_getTimestamp() - done_ts;
+    bucket  = fls(latency);
+    if (bucket >= PERF_LAT_BUCKET_NUM)
+    {
+        bucket = PERF_LAT_BUCKET_NUM - 1;
+    }
+
+    atomic_inc(&_perf_lat_cb.cnt[point]);
+    atomic_inc(&_perf_lat_cb.bucket[point][bucket]);
+    if (latency > _perf_lat_cb.max[point])
+    {
+        _perf_lat_cb.max[point] = latency;
+    }
+}
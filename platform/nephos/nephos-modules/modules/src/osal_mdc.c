@@ -126,7 +126,6 @@ typedef struct
 #define osal_mdc_list_next(__list__, __node__, __next__)                _osal_mdc_list_next(__list__, __node__, __next__)
 #define osal_mdc_list_locateHead(__list__, __node__)                    _osal_mdc_list_locateHead(__list__, __node__)
 #define osal_mdc_list_insertToHead(__list__, __data__)                  _osal_mdc_list_insertToHead(__list__, __data__)
-#define osal_mdc_list_deleteByData(__list__, __data__)                  _osal_mdc_list_deleteByData(__list__, __data__)
 
 #if defined(NPS_EN_DMA_RESERVED)
 #define osal_mdc_list_insertBefore(__list__, __node__, __data__)        _osal_mdc_list_insertBefore(__list__, __node__, __data__)
@@ -332,35 +331,6 @@ _osal_mdc_list_deleteTargetNode(
     return (NPS_E_OK);
 }
 
-static NPS_ERROR_NO_T
-_osal_mdc_list_deleteByData(
-    OSAL_MDC_LIST_T         *ptr_list,
-    void                    *ptr_delete_data)
-{
-    OSAL_MDC_LIST_NODE_T    *ptr_tmp_node;
-    NPS_ERROR_NO_T          rc = NPS_E_OTHERS;
-
-    if (NULL != ptr_list)
-    {
-        ptr_tmp_node = ptr_list->ptr_head_node;
-        while (NULL != ptr_tmp_node)
-        {
-            if (ptr_tmp_node->ptr_data == ptr_delete_data)
-            {
-                rc = _osal_mdc_list_deleteTargetNode(ptr_list, ptr_tmp_node);
-                break;
-            }
-            else
-            {
-                ptr_tmp_node = ptr_tmp_node->ptr_next;
-            }
-        }
-    }
-
-    return (rc);
-}
-
-
 static NPS_ERROR_NO_T
 _osal_mdc_list_locateHead(
     OSAL_MDC_LIST_T         *ptr_list,
@@ -840,33 +810,41 @@ _osal_mdc_restorePciConfig(
 /* --------------------------------------------------------------------------- DMA */
 #if defined(NPS_LINUX_KERNEL_MODE)
 
+#define OSAL_MDC_DMA_HASH_IDX(__ptr_virt_addr__)                                                \
+    ((UI32_T)(((NPS_HUGE_T)(__ptr_virt_addr__) >> OSAL_MDC_DMA_HASH_SHIFT) & (OSAL_MDC_DMA_HASH_NUM - 1)))
+
+static void
+_osal_mdc_insertDmaHash(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    OSAL_MDC_DMA_NODE_T     *ptr_node_data)
+{
+    UI32_T                  idx = OSAL_MDC_DMA_HASH_IDX(ptr_node_data->ptr_virt_addr);
+
+    ptr_node_data->ptr_hash_next = ptr_dma_info->ptr_hash[idx];
+    ptr_dma_info->ptr_hash[idx]  = ptr_node_data;
+}
+
 static NPS_ERROR_NO_T
-_osal_mdc_searchDmaVirtAddr(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
+_osal_mdc_removeDmaHash(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
     const void              *ptr_virt_addr,
-    OSAL_MDC_LIST_NODE_T    **pptr_node,
     OSAL_MDC_DMA_NODE_T     **pptr_node_data)
 {
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node;
-    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
-    NPS_ERROR_NO_T          rc;
+    OSAL_MDC_DMA_NODE_T     **pptr_curr_node_data;
 
-    rc = osal_mdc_list_locateHead(ptr_dma_list, &ptr_curr_node);
-    while (NPS_E_OK == rc)
+    pptr_curr_node_data = &ptr_dma_info->ptr_hash[OSAL_MDC_DMA_HASH_IDX(ptr_virt_addr)];
+    while (NULL != *pptr_curr_node_data)
     {
-        rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
-        if (NPS_E_OK == rc)
+        if ((*pptr_curr_node_data)->ptr_virt_addr == ptr_virt_addr)
         {
-            if (ptr_curr_node_data->ptr_virt_addr == ptr_virt_addr)
-            {
-                *pptr_node      = ptr_curr_node;
-                *pptr_node_data = ptr_curr_node_data;
-                break;
-            }
-            rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node, &ptr_curr_node);
+            *pptr_node_data      = *pptr_curr_node_data;
+            *pptr_curr_node_data = (*pptr_node_data)->ptr_hash_next;
+            (*pptr_node_data)->ptr_hash_next = NULL;
+            return (NPS_E_OK);
         }
+        pptr_curr_node_data = &(*pptr_curr_node_data)->ptr_hash_next;
     }
-    return (rc);
+    return (NPS_E_ENTRY_NOT_FOUND);
 }
 
 static NPS_ERROR_NO_T
@@ -884,13 +862,10 @@ _osal_mdc_destroyDmaNodeList(
         while (NPS_E_OK == rc)
         {
             rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
-            if ((NPS_E_OK == rc) && (NULL != ptr_curr_node_data))
+            if (NPS_E_OK == rc)
             {
-                rc = osal_mdc_list_deleteByData(ptr_dma_list, ptr_curr_node_data);
-                if (NPS_E_OK == rc)
-                {
-                    kfree(ptr_curr_node_data);
-                }
+                _osal_mdc_list_deleteTargetNode(ptr_dma_list, ptr_curr_node);
+                kfree(ptr_curr_node_data);
             }
             rc = osal_mdc_list_locateHead(ptr_dma_list, &ptr_curr_node);
         }
@@ -899,6 +874,14 @@ _osal_mdc_destroyDmaNodeList(
         {
             ptr_dma_info->ptr_dma_list = NULL;
         }
+
+        /* all of the nodes are freed */
+        memset(ptr_dma_info->ptr_hash, 0x0, sizeof(ptr_dma_info->ptr_hash));
+#if defined(NPS_EN_DMA_RESERVED)
+        memset(ptr_dma_info->ptr_bin, 0x0, sizeof(ptr_dma_info->ptr_bin));
+        memset(ptr_dma_info->ptr_slab, 0x0, sizeof(ptr_dma_info->ptr_slab));
+        memset(ptr_dma_info->slab_cnt, 0x0, sizeof(ptr_dma_info->slab_cnt));
+#endif
     }
     return (rc);
 }
@@ -940,6 +923,55 @@ _osal_mdc_dumpRsrvDmaList(void)
 }
 #endif
 
+static UI32_T
+_osal_mdc_getRsrvDmaBin(
+    const NPS_ADDR_T        size)
+{
+    UI32_T                  bin = (UI32_T)fls64((u64)size);
+
+    /* bin n holds the nodes of size [2^n, 2^(n+1)) */
+    bin = (bin > 0)? (bin - 1) : 0;
+    return ((bin < OSAL_MDC_DMA_BIN_NUM)? bin : (OSAL_MDC_DMA_BIN_NUM - 1));
+}
+
+static void
+_osal_mdc_insertRsrvDmaBin(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    OSAL_MDC_DMA_NODE_T     *ptr_node_data)
+{
+    UI32_T                  bin = _osal_mdc_getRsrvDmaBin(ptr_node_data->size);
+
+    ptr_node_data->ptr_bin_prev = NULL;
+    ptr_node_data->ptr_bin_next = ptr_dma_info->ptr_bin[bin];
+    if (NULL != ptr_dma_info->ptr_bin[bin])
+    {
+        ptr_dma_info->ptr_bin[bin]->ptr_bin_prev = ptr_node_data;
+    }
+    ptr_dma_info->ptr_bin[bin] = ptr_node_data;
+}
+
+/* the node size must not be changed before it is removed from the bin */
+static void
+_osal_mdc_removeRsrvDmaBin(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    OSAL_MDC_DMA_NODE_T     *ptr_node_data)
+{
+    if (NULL != ptr_node_data->ptr_bin_prev)
+    {
+        ptr_node_data->ptr_bin_prev->ptr_bin_next = ptr_node_data->ptr_bin_next;
+    }
+    else
+    {
+        ptr_dma_info->ptr_bin[_osal_mdc_getRsrvDmaBin(ptr_node_data->size)] = ptr_node_data->ptr_bin_next;
+    }
+    if (NULL != ptr_node_data->ptr_bin_next)
+    {
+        ptr_node_data->ptr_bin_next->ptr_bin_prev = ptr_node_data->ptr_bin_prev;
+    }
+    ptr_node_data->ptr_bin_prev = NULL;
+    ptr_node_data->ptr_bin_next = NULL;
+}
+
 static NPS_ERROR_NO_T
 _osal_mdc_createRsrvDmaNodeList(
     OSAL_MDC_DMA_INFO_T     *ptr_dma_info)
@@ -957,12 +989,23 @@ _osal_mdc_createRsrvDmaNodeList(
         ptr_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
         if (NULL != ptr_node_data)
         {
+            memset(ptr_node_data, 0x0, sizeof(OSAL_MDC_DMA_NODE_T));
             ptr_node_data->ptr_virt_addr = ptr_dma_info->ptr_rsrv_virt_addr;
             ptr_node_data->phy_addr      = ptr_dma_info->rsrv_phy_addr;
             ptr_node_data->size          = ptr_dma_info->rsrv_size;
             ptr_node_data->available     = TRUE;
             rc = osal_mdc_list_insertToHead((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
                                             ptr_node_data);
+            if (NPS_E_OK == rc)
+            {
+                ptr_node_data->ptr_list_node =
+                    ((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list)->ptr_head_node;
+                _osal_mdc_insertRsrvDmaBin(ptr_dma_info, ptr_node_data);
+            }
+            else
+            {
+                kfree(ptr_node_data);
+            }
         }
         else
         {
@@ -974,111 +1017,79 @@ _osal_mdc_createRsrvDmaNodeList(
 
 static NPS_ERROR_NO_T
 _osal_mdc_searchAvblRsrvDmaNode(
-    OSAL_MDC_LIST_T         *ptr_dma_list,
-    const UI32_T            size,
-    OSAL_MDC_LIST_NODE_T    **pptr_avbl_node)
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    const NPS_ADDR_T        size,
+    OSAL_MDC_DMA_NODE_T     **pptr_avbl_node_data)
 {
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node;
     OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
-    NPS_ERROR_NO_T          rc;
+    UI32_T                  bin = _osal_mdc_getRsrvDmaBin(size);
+    UI32_T                  idx;
 
-    rc = osal_mdc_list_locateHead(ptr_dma_list, &ptr_curr_node);
-    while (NPS_E_OK == rc)
+    /* all of the nodes in the upper bins are large enough */
+    idx = (size > ((NPS_ADDR_T)1 << bin))? (bin + 1) : bin;
+    for (; idx < OSAL_MDC_DMA_BIN_NUM; idx++)
     {
-        rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
-        if (NPS_E_OK == rc)
+        if (NULL != ptr_dma_info->ptr_bin[idx])
         {
-            if ((TRUE == ptr_curr_node_data->available) && (ptr_curr_node_data->size >= size))
-            {
-                *pptr_avbl_node = ptr_curr_node;
-                break;
-            }
+            *pptr_avbl_node_data = ptr_dma_info->ptr_bin[idx];
+            return (NPS_E_OK);
         }
-        rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node, &ptr_curr_node);
     }
-    return (rc);
+
+    /* the nodes in the same bin might be smaller than the size */
+    ptr_curr_node_data = ptr_dma_info->ptr_bin[bin];
+    while (NULL != ptr_curr_node_data)
+    {
+        if (ptr_curr_node_data->size >= size)
+        {
+            *pptr_avbl_node_data = ptr_curr_node_data;
+            return (NPS_E_OK);
+        }
+        ptr_curr_node_data = ptr_curr_node_data->ptr_bin_next;
+    }
+    return (NPS_E_NO_MEMORY);
 }
 
 static NPS_ERROR_NO_T
 _osal_mdc_splitRsrvDmaNodes(
     OSAL_MDC_LIST_T         *ptr_dma_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_ori_node,
-    const UI32_T            size,
+    OSAL_MDC_DMA_NODE_T     *ptr_ori_node_data,
+    const NPS_ADDR_T        size,
     OSAL_MDC_DMA_NODE_T     **pptr_new_node_data)
 {
-    OSAL_MDC_DMA_NODE_T     *ptr_ori_node_data;
     NPS_ERROR_NO_T          rc;
 
-    rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_ori_node, (void **)&ptr_ori_node_data);
+    *pptr_new_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
+    if (NULL == *pptr_new_node_data)
+    {
+        return (NPS_E_NO_MEMORY);
+    }
+
+    /* Create a new node */
+    memset(*pptr_new_node_data, 0x0, sizeof(OSAL_MDC_DMA_NODE_T));
+    (*pptr_new_node_data)->size          = size;
+    (*pptr_new_node_data)->phy_addr      = ptr_ori_node_data->phy_addr;
+    (*pptr_new_node_data)->ptr_virt_addr = ptr_ori_node_data->ptr_virt_addr;
+    (*pptr_new_node_data)->available     = TRUE;
 
+    rc = osal_mdc_list_insertBefore(ptr_dma_list, ptr_ori_node_data->ptr_list_node,
+                                    (void *)*pptr_new_node_data);
     if (NPS_E_OK == rc)
     {
-        *pptr_new_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
-
-        /* Create a new node */
-        (*pptr_new_node_data)->size          = size;
-        (*pptr_new_node_data)->phy_addr      = ptr_ori_node_data->phy_addr;
-        (*pptr_new_node_data)->ptr_virt_addr = ptr_ori_node_data->ptr_virt_addr;
-        (*pptr_new_node_data)->available     = TRUE;
+        (*pptr_new_node_data)->ptr_list_node = ptr_ori_node_data->ptr_list_node->ptr_prev;
 
         /* Update the original node */
         ptr_ori_node_data->size              -= size;
         ptr_ori_node_data->phy_addr          += size;
         ptr_ori_node_data->ptr_virt_addr =
             (void *)((NPS_HUGE_T)ptr_ori_node_data->ptr_virt_addr + (NPS_HUGE_T)size);
-
-        rc = osal_mdc_list_insertBefore(ptr_dma_list, ptr_ori_node, (void *)*pptr_new_node_data);
-        if (NPS_E_OK != rc)
-        {
-            OSAL_MDC_ERR("insert rsrv dma node to list failed, size=%d, rc=%d\n", size, rc);
-            /* Recovery */
-            ptr_ori_node_data->size          += size;
-            ptr_ori_node_data->phy_addr      -= size;
-            ptr_ori_node_data->ptr_virt_addr =
-                (void *)((NPS_HUGE_T)ptr_ori_node_data->ptr_virt_addr - (NPS_HUGE_T)size);
-            kfree(*pptr_new_node_data);
-        }
     }
-    return (rc);
-}
-
-static void *
-_osal_mdc_allocRsrvDmaMem(
-    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
-    const UI32_T            size)
-{
-    OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
-    OSAL_MDC_LIST_NODE_T    *ptr_node = NULL;
-    OSAL_MDC_DMA_NODE_T     *ptr_node_data;
-    OSAL_MDC_DMA_NODE_T     *ptr_new_node_data;
-    void                    *ptr_virt_addr = NULL;
-    NPS_ERROR_NO_T          rc;
-
-    rc = _osal_mdc_searchAvblRsrvDmaNode(ptr_dma_list, size, &ptr_node);
-    if (NPS_E_OK == rc)
+    else
     {
-        rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_node, (void **)&ptr_node_data);
-        if (NPS_E_OK == rc)
-        {
-            /* If the node size just fit the user's requirement, just give it to user */
-            if (ptr_node_data->size == size)
-            {
-                ptr_node_data->available = FALSE;
-                ptr_virt_addr = ptr_node_data->ptr_virt_addr;
-            }
-            /* or split a new node with user required size. */
-            else
-            {
-                rc = _osal_mdc_splitRsrvDmaNodes(ptr_dma_list, ptr_node, size, &ptr_new_node_data);
-                if (NPS_E_OK == rc)
-                {
-                    ptr_new_node_data->available = FALSE;
-                    ptr_virt_addr = ptr_new_node_data->ptr_virt_addr;
-                }
-            }
-        }
+        OSAL_MDC_ERR("insert rsrv dma node to list failed, size=%d, rc=%d\n", (UI32_T)size, rc);
+        kfree(*pptr_new_node_data);
     }
-    return (ptr_virt_addr);
+    return (rc);
 }
 
 static NPS_ERROR_NO_T
@@ -1089,53 +1100,148 @@ _osal_mdc_mergeTwoRsrvDmaNodes(
 {
     ptr_first_node_data->size += ptr_second_node_data->size;
 
-    osal_mdc_list_deleteByData(ptr_dma_list, ptr_second_node_data);
+    _osal_mdc_list_deleteTargetNode(ptr_dma_list, ptr_second_node_data->ptr_list_node);
+    kfree(ptr_second_node_data);
     return (NPS_E_OK);
 }
 
 static NPS_ERROR_NO_T
 _osal_mdc_mergeRsrvDmaNodes(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
     OSAL_MDC_LIST_T         *ptr_dma_list,
-    OSAL_MDC_LIST_NODE_T    *ptr_curr_node)
+    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data)
 {
     OSAL_MDC_LIST_NODE_T    *ptr_prev_node;
     OSAL_MDC_LIST_NODE_T    *ptr_next_node;
-    OSAL_MDC_DMA_NODE_T     *ptr_curr_node_data;
     OSAL_MDC_DMA_NODE_T     *ptr_prev_node_data;
     OSAL_MDC_DMA_NODE_T     *ptr_next_node_data;
     NPS_ERROR_NO_T          rc;
 
-    rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_curr_node, (void **)&ptr_curr_node_data);
+    /* First, check if the previous node is available */
+    rc = osal_mdc_list_prev(ptr_dma_list, ptr_curr_node_data->ptr_list_node, &ptr_prev_node);
     if (NPS_E_OK == rc)
     {
-        /* First, check if the previous node is available */
-        rc = osal_mdc_list_prev(ptr_dma_list, ptr_curr_node, &ptr_prev_node);
-        if (NPS_E_OK == rc)
+        osal_mdc_list_getNodeData(ptr_dma_list, ptr_prev_node, (void **)&ptr_prev_node_data);
+        if (TRUE == ptr_prev_node_data->available)
         {
-            osal_mdc_list_getNodeData(ptr_dma_list, ptr_prev_node, (void **)&ptr_prev_node_data);
-            if (TRUE == ptr_prev_node_data->available)
-            {
-                _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_prev_node_data, ptr_curr_node_data);
-                ptr_curr_node      = ptr_prev_node;
-                ptr_curr_node_data = ptr_prev_node_data;
-            }
+            _osal_mdc_removeRsrvDmaBin(ptr_dma_info, ptr_prev_node_data);
+            _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_prev_node_data, ptr_curr_node_data);
+            ptr_curr_node_data = ptr_prev_node_data;
         }
+    }
 
-        /* then, check if the next node is available */
-        rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node, &ptr_next_node);
-        if (NPS_E_OK == rc)
+    /* then, check if the next node is available */
+    rc = osal_mdc_list_next(ptr_dma_list, ptr_curr_node_data->ptr_list_node, &ptr_next_node);
+    if (NPS_E_OK == rc)
+    {
+        osal_mdc_list_getNodeData(ptr_dma_list, ptr_next_node, (void **)&ptr_next_node_data);
+        if (TRUE == ptr_next_node_data->available)
+        {
+            _osal_mdc_removeRsrvDmaBin(ptr_dma_info, ptr_next_node_data);
+            _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_curr_node_data, ptr_next_node_data);
+        }
+    }
+
+    _osal_mdc_insertRsrvDmaBin(ptr_dma_info, ptr_curr_node_data);
+    return (NPS_E_OK);
+}
+
+static UI32_T
+_osal_mdc_getDmaSlabClass(
+    const NPS_ADDR_T        size)
+{
+    return ((0 == size)? 0 : (UI32_T)((size - 1) / OSAL_MDC_DMA_SLAB_ALIGN));
+}
+
+static void
+_osal_mdc_drainDmaSlab(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info)
+{
+    OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
+    OSAL_MDC_DMA_NODE_T     *ptr_node_data;
+    UI32_T                  cls;
+
+    /* give the cached buffers back to the bins, then they can be merged */
+    for (cls = 0; cls < OSAL_MDC_DMA_SLAB_CLASS_NUM; cls++)
+    {
+        while (NULL != ptr_dma_info->ptr_slab[cls])
+        {
+            ptr_node_data = ptr_dma_info->ptr_slab[cls];
+            ptr_dma_info->ptr_slab[cls] = ptr_node_data->ptr_bin_next;
+            ptr_node_data->ptr_bin_next = NULL;
+            ptr_node_data->available    = TRUE;
+            _osal_mdc_mergeRsrvDmaNodes(ptr_dma_info, ptr_dma_list, ptr_node_data);
+        }
+        ptr_dma_info->slab_cnt[cls] = 0;
+    }
+}
+
+static void *
+_osal_mdc_allocRsrvDmaMem(
+    OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
+    const UI32_T            size)
+{
+    OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
+    OSAL_MDC_DMA_NODE_T     *ptr_node_data = NULL;
+    OSAL_MDC_DMA_NODE_T     *ptr_new_node_data;
+    NPS_ADDR_T              alloc_size = size;
+    UI32_T                  cls;
+    NPS_ERROR_NO_T          rc;
+
+    /* The payload buffers are served by the size classes of the slab,
+     * the size is rounded up so that the buffers of a class can be reused.
+     */
+    if (size <= OSAL_MDC_DMA_SLAB_SZ_MAX)
+    {
+        cls = _osal_mdc_getDmaSlabClass(size);
+        if (NULL != ptr_dma_info->ptr_slab[cls])
+        {
+            ptr_node_data = ptr_dma_info->ptr_slab[cls];
+            ptr_dma_info->ptr_slab[cls] = ptr_node_data->ptr_bin_next;
+            ptr_node_data->ptr_bin_next = NULL;
+            ptr_dma_info->slab_cnt[cls]--;
+            _osal_mdc_insertDmaHash(ptr_dma_info, ptr_node_data);
+            return (ptr_node_data->ptr_virt_addr);
+        }
+        alloc_size = (NPS_ADDR_T)(cls + 1) * OSAL_MDC_DMA_SLAB_ALIGN;
+    }
+
+    rc = _osal_mdc_searchAvblRsrvDmaNode(ptr_dma_info, alloc_size, &ptr_node_data);
+    if (NPS_E_OK != rc)
+    {
+        /* the cached buffers might split the memory, release them and retry */
+        _osal_mdc_drainDmaSlab(ptr_dma_info);
+        rc = _osal_mdc_searchAvblRsrvDmaNode(ptr_dma_info, alloc_size, &ptr_node_data);
+    }
+
+    if (NPS_E_OK == rc)
+    {
+        _osal_mdc_removeRsrvDmaBin(ptr_dma_info, ptr_node_data);
+
+        /* If the node size just fit the user's requirement, just give it to user */
+        if (ptr_node_data->size == alloc_size)
         {
-            rc = osal_mdc_list_getNodeData(ptr_dma_list, ptr_next_node, (void **)&ptr_next_node_data);
+            ptr_node_data->available = FALSE;
+        }
+        /* or split a new node with user required size. */
+        else
+        {
+            rc = _osal_mdc_splitRsrvDmaNodes(ptr_dma_list, ptr_node_data, alloc_size, &ptr_new_node_data);
+            _osal_mdc_insertRsrvDmaBin(ptr_dma_info, ptr_node_data);
             if (NPS_E_OK == rc)
             {
-                if (TRUE == ptr_next_node_data->available)
-                {
-                    _osal_mdc_mergeTwoRsrvDmaNodes(ptr_dma_list, ptr_curr_node_data, ptr_next_node_data);
-                }
+                ptr_new_node_data->available = FALSE;
+                ptr_node_data = ptr_new_node_data;
             }
         }
     }
-    return (rc);
+
+    if (NPS_E_OK == rc)
+    {
+        _osal_mdc_insertDmaHash(ptr_dma_info, ptr_node_data);
+        return (ptr_node_data->ptr_virt_addr);
+    }
+    return (NULL);
 }
 
 static NPS_ERROR_NO_T
@@ -1144,15 +1250,28 @@ _osal_mdc_freeRsrvDmaMem(
     void                    *ptr_virt_addr)
 {
     OSAL_MDC_LIST_T         *ptr_dma_list = (OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list;
-    OSAL_MDC_LIST_NODE_T    *ptr_node = NULL;
     OSAL_MDC_DMA_NODE_T     *ptr_node_data = NULL;
+    UI32_T                  cls;
     NPS_ERROR_NO_T          rc;
 
-    rc = _osal_mdc_searchDmaVirtAddr(ptr_dma_list, ptr_virt_addr, &ptr_node, &ptr_node_data);
+    rc = _osal_mdc_removeDmaHash(ptr_dma_info, ptr_virt_addr, &ptr_node_data);
     if (NPS_E_OK == rc)
     {
+        /* keep the payload buffer in the slab for the next allocation */
+        if (ptr_node_data->size <= OSAL_MDC_DMA_SLAB_SZ_MAX)
+        {
+            cls = _osal_mdc_getDmaSlabClass(ptr_node_data->size);
+            if (ptr_dma_info->slab_cnt[cls] < OSAL_MDC_DMA_SLAB_CACHE_NUM)
+            {
+                ptr_node_data->ptr_bin_next = ptr_dma_info->ptr_slab[cls];
+                ptr_dma_info->ptr_slab[cls] = ptr_node_data;
+                ptr_dma_info->slab_cnt[cls]++;
+                return (NPS_E_OK);
+            }
+        }
+
         ptr_node_data->available = TRUE;
-        _osal_mdc_mergeRsrvDmaNodes(ptr_dma_list, ptr_node);
+        _osal_mdc_mergeRsrvDmaNodes(ptr_dma_info, ptr_dma_list, ptr_node_data);
     }
     return (rc);
 }
@@ -1292,12 +1411,23 @@ _osal_mdc_allocSysDmaMem(
     if (NULL != ptr_virt_addr)
     {
         ptr_node_data = kmalloc(sizeof(OSAL_MDC_DMA_NODE_T), GFP_KERNEL);
-        ptr_node_data->phy_addr      = (NPS_ADDR_T)phy_addr;
-        ptr_node_data->ptr_virt_addr = ptr_virt_addr;
-        ptr_node_data->size          = size;
+        rc = (NULL != ptr_node_data)? NPS_E_OK : NPS_E_NO_MEMORY;
+        if (NPS_E_OK == rc)
+        {
+            memset(ptr_node_data, 0x0, sizeof(OSAL_MDC_DMA_NODE_T));
+            ptr_node_data->phy_addr      = (NPS_ADDR_T)phy_addr;
+            ptr_node_data->ptr_virt_addr = ptr_virt_addr;
+            ptr_node_data->size          = size;
 
-        rc = osal_mdc_list_insertToHead((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list, ptr_node_data);
-        if (NPS_E_OK != rc)
+            rc = osal_mdc_list_insertToHead((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list, ptr_node_data);
+        }
+        if (NPS_E_OK == rc)
+        {
+            ptr_node_data->ptr_list_node =
+                ((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list)->ptr_head_node;
+            _osal_mdc_insertDmaHash(ptr_dma_info, ptr_node_data);
+        }
+        else
         {
             kfree(ptr_node_data);
             dma_free_coherent(ptr_dma_info->ptr_dma_dev, size,
@@ -1313,19 +1443,17 @@ _osal_mdc_freeSysDmaMem(
     OSAL_MDC_DMA_INFO_T     *ptr_dma_info,
     void                    *ptr_virt_addr)
 {
-    OSAL_MDC_LIST_NODE_T    *ptr_node = NULL;
     OSAL_MDC_DMA_NODE_T     *ptr_node_data = NULL;
     NPS_ERROR_NO_T          rc;
 
-    rc = _osal_mdc_searchDmaVirtAddr((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                                     ptr_virt_addr, &ptr_node, &ptr_node_data);
+    rc = _osal_mdc_removeDmaHash(ptr_dma_info, ptr_virt_addr, &ptr_node_data);
     if (NPS_E_OK == rc)
     {
         dma_free_coherent(ptr_dma_info->ptr_dma_dev, ptr_node_data->size,
                           ptr_virt_addr, ptr_node_data->phy_addr);
 
-        osal_mdc_list_deleteByData((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
-                                   ptr_node_data);
+        _osal_mdc_list_deleteTargetNode((OSAL_MDC_LIST_T *)ptr_dma_info->ptr_dma_list,
+                                        ptr_node_data->ptr_list_node);
         kfree(ptr_node_data);
     }
     return (rc);
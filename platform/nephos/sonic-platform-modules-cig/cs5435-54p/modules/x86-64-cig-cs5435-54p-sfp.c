@@ -0,0 +1 @@
+../../common/modules/x86-64-cig-sfp.c
\ No newline at end of file
@@ -156,6 +156,11 @@
 #define CPLD_SLAVE2_INTERRUPT_QSFP_CR56 0x0200
 #define CPLD_SLAVE2_INTERRUPT_PRESENT56 0x0400
 
+#define CPLD_SLAVE1_INTERRUPT_PRESENT (CPLD_SLAVE1_INTERRUPT_PRESENT08 | CPLD_SLAVE1_INTERRUPT_PRESENT16 | \
+									   CPLD_SLAVE1_INTERRUPT_PRESENT24)
+#define CPLD_SLAVE2_INTERRUPT_PRESENT (CPLD_SLAVE2_INTERRUPT_PRESENT32 | CPLD_SLAVE2_INTERRUPT_PRESENT40 | \
+									   CPLD_SLAVE2_INTERRUPT_PRESENT48 | CPLD_SLAVE2_INTERRUPT_PRESENT56)
+
 #define CPLD_SLAVE1_INTERRUPT_RX_LOST08 0x0008
 #define CPLD_SLAVE1_INTERRUPT_RX_LOST16 0x0010
 #define CPLD_SLAVE1_INTERRUPT_RX_LOST24 0x0020
@@ -218,5 +223,16 @@ struct subsys_private {
 void cs6436_54p_sysfs_add_client(struct i2c_client *client);
 void cs6436_54p_sysfs_remove_client(struct i2c_client *client);
 
+/* Events of the CPLD interrupt, for the drivers of the ports */
+#define CIG_CPLD_EVENT_PRESENT 1	/* presence of a port changed */
+
+struct notifier_block;
+int cig_cpld_register_notifier(struct notifier_block *nb);
+void cig_cpld_unregister_notifier(struct notifier_block *nb);
+
+/* Registers of the slave CPLDs, through ADDR_REG_SFP_STATUS_* */
+int cig_cpld_write_slave_cpld_register(u8 reg_addr, u8 reg_data);
+int cig_cpld_read_slave_cpld_register(u8 reg_addr, u8 *reg_data);
+
 
 #endif /* I2C_LPC8584_H */
@@ -1240,8 +1240,6 @@ int cpld_sysfs_add_attr(struct kobject* kobj, char* attr_name)
     return sysfs_create_file(kobj, attr);
 }
 
-static int cig_cpld_write_slave_cpld_register(u8 reg_addr, u8 reg_data);
-static int cig_cpld_read_slave_cpld_register(u8 reg_addr, u8 *reg_data);
 
 
 static ssize_t cpld_sysfs_show(struct kobject *kobj, struct attribute *attr, char *buffer)
@@ -1452,16 +1450,46 @@ static void cpld_setup_cdev(struct cpld_dev_type *dev)
 #include <linux/interrupt.h>
 #include <linux/gpio.h>
 #include <linux/irq.h>
+#include <linux/notifier.h>
 
 static spinlock_t		irq_inter_lock;
 static struct delayed_work irq_inter_work;
 static unsigned long irq_inter_delay;
 
+/* GPIO of the CPLD interrupt, -1 leaves the interrupt off */
+static int irq_gpio = 289;
+static int cpld_irq = -1;
 
-static int cig_cpld_write_slave_cpld_register(u8 reg_addr, u8 reg_data)
+static BLOCKING_NOTIFIER_HEAD(cig_cpld_notifier_list);
+
+/*
+ * Registers nb for the CIG_CPLD_EVENT_* events of the CPLD interrupt,
+ * fails with -ENODEV when the interrupt is not available.
+ */
+int cig_cpld_register_notifier(struct notifier_block *nb)
+{
+	if (cpld_irq < 0)
+		return -ENODEV;
+
+	return blocking_notifier_chain_register(&cig_cpld_notifier_list, nb);
+}
+EXPORT_SYMBOL(cig_cpld_register_notifier);
+
+void cig_cpld_unregister_notifier(struct notifier_block *nb)
+{
+	blocking_notifier_chain_unregister(&cig_cpld_notifier_list, nb);
+}
+EXPORT_SYMBOL(cig_cpld_unregister_notifier);
+
+/* Serializes the accesses to the slave CPLDs, one register at a time */
+static DEFINE_MUTEX(slave_cpld_lock);
+
+
+int cig_cpld_write_slave_cpld_register(u8 reg_addr, u8 reg_data)
 {
 	u8 read_status = 0;
 	u8 wait_time_out = WAIT_TIME_OUT_COUNT;
+	mutex_lock(&slave_cpld_lock);
 	DEB2(printk("<=======write=========>"));
 	cig_cpld_write_register(ADDR_REG_SFP_STATUS_ADDR, reg_addr << 1);
 	DEB2(printk("[62]=%x\n",reg_addr << 1));
@@ -1478,19 +1506,21 @@ static int cig_cpld_write_slave_cpld_register(u8 reg_addr, u8 reg_data)
 			break;
 	}while(read_status != 0x02);
 	DEB2(printk("<=======write=========>"));
-
+	mutex_unlock(&slave_cpld_lock);
 
 	if(wait_time_out == 0)
 		return -1;
 
 	return 1;
 }
+EXPORT_SYMBOL(cig_cpld_write_slave_cpld_register);
 
 
-static int cig_cpld_read_slave_cpld_register(u8 reg_addr, u8 *reg_data)
+int cig_cpld_read_slave_cpld_register(u8 reg_addr, u8 *reg_data)
 {
 	u8 read_status = 0;
 	u8 wait_time_out = WAIT_TIME_OUT_COUNT;
+	mutex_lock(&slave_cpld_lock);
 	DEB2(printk("<========read=========>"));
 	cig_cpld_write_register(ADDR_REG_SFP_STATUS_ADDR, reg_addr << 1 | 1);
 	DEB2(printk("[62]=%x\n",reg_addr << 1 | 1));
@@ -1508,12 +1538,14 @@ static int cig_cpld_read_slave_cpld_register(u8 reg_addr, u8 *reg_data)
 	cig_cpld_read_register(ADDR_REG_SFP_STATUS_RX,reg_data);
 	DEB2(printk("[64]=%x\n",*reg_data));
 	DEB2(printk("<========read=========>"));
+	mutex_unlock(&slave_cpld_lock);
 
 	if(wait_time_out == 0)
 		return -1;
 
 	return 1;
 }
+EXPORT_SYMBOL(cig_cpld_read_slave_cpld_register);
 
 
 
@@ -1543,6 +1575,8 @@ int send_usrmsg(char *pbuf, uint16_t len)
 
     int ret;
 
+    if(!nlsk || !len)
+        return -1;
 
     nl_skb = nlmsg_new(len, GFP_ATOMIC);
     if(!nl_skb)
@@ -1703,6 +1737,7 @@ static void irq_inter_wapper(struct work_struct * work)
 	u8 i = 0;
 	char kmsg[64]={0};
 	u8 tmp[3] = {0};
+	u8 present_event = 0;
 
 	DEB2(printk("CPLD_MASTER_INTERRUPT\r\n"));
 
@@ -1716,6 +1751,8 @@ static void irq_inter_wapper(struct work_struct * work)
 		cig_cpld_read_slave_cpld_register(CPLD_SLAVE1_INTERRUPT_STATUS_H_REG,&data_high8);
 		cig_cpld_read_slave_cpld_register(CPLD_SLAVE1_INTERRUPT_STATUS_L_REG,&data_low8);
 		data_16 = data_low8 | data_high8 << 8;
+		if((data_16 & CPLD_SLAVE1_INTERRUPT_PRESENT) != CPLD_SLAVE1_INTERRUPT_PRESENT)
+			present_event = 1;
 		if(
 			!(data_16 & CPLD_SLAVE1_INTERRUPT_PRESENT08) ||
 			!(data_16 & CPLD_SLAVE1_INTERRUPT_PRESENT16) ||
@@ -1806,6 +1843,8 @@ static void irq_inter_wapper(struct work_struct * work)
 		cig_cpld_read_slave_cpld_register(CPLD_SLAVE2_INTERRUPT_STATUS_H_REG,&data_high8);
 		cig_cpld_read_slave_cpld_register(CPLD_SLAVE2_INTERRUPT_STATUS_L_REG,&data_low8);
 		data_16 = data_low8 | data_high8 << 8;
+		if((data_16 & CPLD_SLAVE2_INTERRUPT_PRESENT) != CPLD_SLAVE2_INTERRUPT_PRESENT)
+			present_event = 1;
 		if(
 			!(data_16 & CPLD_SLAVE2_INTERRUPT_PRESENT32) ||
 			!(data_16 & CPLD_SLAVE2_INTERRUPT_PRESENT40) ||
@@ -2052,6 +2091,9 @@ static void irq_inter_wapper(struct work_struct * work)
 	irq_interrupt_qsfp_next = irq_interrupt_qsfp_current;
 
     send_usrmsg(kmsg, strlen(kmsg));
+
+	if(present_event)
+		blocking_notifier_call_chain(&cig_cpld_notifier_list, CIG_CPLD_EVENT_PRESENT, NULL);
 }
 
 static void disableIrq(unsigned short maskReg, unsigned short mask)
@@ -2088,6 +2130,57 @@ static irqreturn_t irq_inter_isr(int irq, void *handle)
 }
 
 
+static int cpld_irq_init(void)
+{
+	int rc;
+
+	INIT_DELAYED_WORK(&irq_inter_work, irq_inter_wapper);
+	irq_inter_delay = msecs_to_jiffies(25);
+
+	if (irq_gpio < 0)
+		return -ENODEV;
+
+	rc = gpio_request(irq_gpio, "cpld-irq");
+	if (rc)
+		return rc;
+	gpio_direction_input(irq_gpio);
+
+	rc = gpio_to_irq(irq_gpio);
+	if (rc < 0)
+		goto err_gpio;
+
+	cpld_irq = rc;
+	rc = request_irq(cpld_irq, irq_inter_isr, IRQF_TRIGGER_FALLING, "cpld", NULL);
+	if (rc) {
+		cpld_irq = -1;
+		goto err_gpio;
+	}
+
+	/* Port status interrupts of the slave CPLDs */
+	cig_cpld_write_slave_cpld_register(CPLD_SLAVE1_INTERRUPT_MASK_REG, 0x0);
+	cig_cpld_write_slave_cpld_register(CPLD_SLAVE2_INTERRUPT_MASK_REG, 0x0);
+	enableIrq(CPLD_MASTER_INTERRUPT_MASK_REG, CPLD_MASTER_INTERRUPT_CPLD1 | CPLD_MASTER_INTERRUPT_CPLD2);
+
+	return 0;
+
+err_gpio:
+	gpio_free(irq_gpio);
+	return rc;
+}
+
+static void cpld_irq_exit(void)
+{
+	if (cpld_irq < 0)
+		return;
+
+	disableIrq(CPLD_MASTER_INTERRUPT_MASK_REG, CPLD_MASTER_INTERRUPT_CPLD1 | CPLD_MASTER_INTERRUPT_CPLD2);
+	free_irq(cpld_irq, NULL);
+	cancel_delayed_work_sync(&irq_inter_work);
+	gpio_free(irq_gpio);
+	cpld_irq = -1;
+}
+
+
 #define CIG_CPLD_CHR_NAME "cpld"
 
 
@@ -2096,7 +2189,6 @@ static int __init cpld_init(void)
 	int rval,rc=0;
 	dev_t dev;
 	u8 s_data;
-	int isr_GPIO_num = 289;
 
 	DEB2(printk("cpld_init\n");)
 
@@ -2146,6 +2238,12 @@ static int __init cpld_init(void)
 	rval = lpc_bus_init();
 	rval = lpc_register_driver(&i2c_lpc_driver, 1);
 
+/**************************************************************************************/
+
+	rval = cpld_irq_init();
+	if (rval)
+		printk(KERN_INFO "cpld: interrupt not available (%d), port status is polled\n", rval);
+
 /**************************************************************************************/
 	return 0;
 error1:
@@ -2164,6 +2262,8 @@ static void __exit cpld_exit(void)
 
     DEB2(printk("cpld_exit\n"));
 
+    cpld_irq_exit();
+
     lpc_unregister_driver(&i2c_lpc_driver);
     lpc_bus_exit();
     dev_t devno = MKDEV(cpld_major, cpld_minor);
@@ -2189,6 +2289,7 @@ module_param(cpld_major, int, S_IRUGO);
 module_param(cpld_minor, int, S_IRUGO);
 module_param(i2c_debug, int, S_IRUGO);
 module_param(board_id, int, S_IRUGO);
+module_param(irq_gpio, int, S_IRUGO);
 
 module_init(cpld_init);
 module_exit(cpld_exit);
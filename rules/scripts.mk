@@ -2,9 +2,6 @@
 ARP_UPDATE_SCRIPT = arp_update
 $(ARP_UPDATE_SCRIPT)_PATH = files/scripts
 
-ARP_UPDATE_VARS_TEMPLATE = arp_update_vars.j2
-$(ARP_UPDATE_VARS_TEMPLATE)_PATH = files/build_templates
-
 CONFIGDB_LOAD_SCRIPT = configdb-load.sh
 $(CONFIGDB_LOAD_SCRIPT)_PATH = files/scripts
 
@@ -22,7 +19,6 @@ $(SYSCTL_NET_CONFIG)_PATH = files/image_config/sysctl
 
 SONIC_COPY_FILES += $(CONFIGDB_LOAD_SCRIPT) \
                     $(ARP_UPDATE_SCRIPT) \
-                    $(ARP_UPDATE_VARS_TEMPLATE) \
                     $(BUFFERS_CONFIG_TEMPLATE) \
                     $(QOS_CONFIG_TEMPLATE) \
                     $(SUPERVISOR_PROC_EXIT_LISTENER_SCRIPT) \
@@ -1,4 +1,4 @@
 USER_OBJS :=
 
-LIBS := -levent -lexplain
+LIBS := -levent -lexplain -lrt
 
@@ -4,23 +4,29 @@
  *  device (interface) module
  */
 
+#include <assert.h>
 #include <err.h>
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <time.h>
 #include <net/ethernet.h>
 #include <netinet/ip.h>
+#include <netinet/ip6.h>
 #include <netinet/udp.h>
 #include <netinet/ether.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <libexplain/ioctl.h>
 #include <linux/filter.h>
-#include <netpacket/packet.h>
+#include <linux/bpf.h>
+#include <linux/if_packet.h>
 
 #include "dhcp_device.h"
 
@@ -39,44 +45,93 @@
 #define DHCP_OPTIONS_HEADER_SIZE 240
 /** Offset of DHCP GIADDR */
 #define DHCP_GIADDR_OFFSET 24
+/** Offset of DHCP XID */
+#define DHCP_XID_OFFSET 4
+/** Offset of BOOTP op */
+#define DHCP_OP_OFFSET 0
+/** Offset of DHCP magic cookie */
+#define DHCP_COOKIE_OFFSET 236
+/** DHCP magic cookie */
+#define DHCP_COOKIE 0x63825363
+/** Start of IPv6 header of a captured frame */
+#define IPV6_START_OFFSET (ETHER_START_OFFSET + ETHER_HDR_LEN)
+/** Start of UDP header of a captured DHCPv6 frame */
+#define UDPV6_START_OFFSET (IPV6_START_OFFSET + sizeof(struct ip6_hdr))
+/** Start of DHCPv6 message of a captured frame */
+#define DHCPV6_START_OFFSET (UDPV6_START_OFFSET + sizeof(struct udphdr))
+/** Start of the options of a DHCPv6 relay message, after msg-type, hop-count, link-address and peer-address */
+#define DHCPV6_RELAY_OPTIONS_OFFSET 34
+/** DHCPv6 Relay Message option */
+#define DHCPV6_OPTION_RELAY_MSG 9
+/** DHCPv6 Interface-Id option, the relay puts the name of the downlink it received the message on in it */
+#define DHCPV6_OPTION_INTERFACE_ID 18
+/** Bytes of a captured frame needed to reach the type of option 53 when it is the first DHCP option */
+#define DHCP_MIN_SNAPLEN (DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE + 3)
+
+/** Size of a TPACKET_V3 receive ring block, a DHCP packet is far smaller */
+#define RX_RING_BLOCK_SIZE  (1 << 16)
+/** Frame size handed to the kernel, V3 packs packets back to back within a block */
+#define RX_RING_FRAME_SIZE  (1 << 11)
+/** Time (msec) after which the kernel hands over a partially filled block */
+#define RX_RING_BLOCK_TMO   100
+
+/** Number of entries of the relay transaction table, a power of 2 */
+#define RELAY_XACT_TABLE_SIZE   4096
+/** Entries probed from the hashed one, a transaction finding none free is not measured */
+#define RELAY_XACT_MAX_PROBE    16
+/** Time (usec) after which a transaction that was not relayed frees its entry */
+#define RELAY_XACT_TIMEOUT_US   (10 * 1000000ULL)
 
 #define OP_LDHA     (BPF_LD  | BPF_H   | BPF_ABS)   /** bpf ldh Abs */
 #define OP_LDHI     (BPF_LD  | BPF_H   | BPF_IND)   /** bpf ldh Ind */
 #define OP_LDB      (BPF_LD  | BPF_B   | BPF_ABS)   /** bpf ldb Abs*/
+#define OP_LDWA     (BPF_LD  | BPF_W   | BPF_ABS)   /** bpf ld Abs */
 #define OP_JEQ      (BPF_JMP | BPF_JEQ | BPF_K)     /** bpf jeq */
 #define OP_JGT      (BPF_JMP | BPF_JGT | BPF_K)     /** bpf jgt */
 #define OP_RET      (BPF_RET | BPF_K)               /** bpf ret */
 #define OP_JSET     (BPF_JMP | BPF_JSET | BPF_K)    /** bpf jset */
 #define OP_LDXB     (BPF_LDX | BPF_B    | BPF_MSH)  /** bpf ldxb */
 
-/** Berkeley Packet Filter program for "udp and (port 67 or port 68)".
- * This program is obtained using the following command tcpdump:
- * `tcpdump -dd "udp and (port 67 or port 68)"`
+/** Berkeley Packet Filter program for IPv4 BOOTP packets with the DHCP magic cookie, "udp and (port 67 or port 68)
+ * and udp[8] <= 2 and udp[244:4] = 0x63825363" for an IP header without options, and for DHCPv6 packets,
+ * "ip6 and udp and (port 546 or port 547)" without extension headers. When option 53 is the first DHCP option, only
+ * the bytes up to the message type are returned, otherwise the whole packet is returned for read_callback to walk
+ * the options. tcpdump cannot express the truncation, this program is hand written.
  */
 static struct sock_filter dhcp_bpf_code[] = {
     {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x0000000c}, // (000) ldh      [12]
-    {.code = OP_JEQ,  .jt = 0,  .jf = 7,  .k = 0x000086dd}, // (001) jeq      #0x86dd          jt 2	jf 9
-    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x00000014}, // (002) ldb      [20]
-    {.code = OP_JEQ,  .jt = 0,  .jf = 18, .k = 0x00000011}, // (003) jeq      #0x11            jt 4	jf 22
-    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000036}, // (004) ldh      [54]
-    {.code = OP_JEQ,  .jt = 15, .jf = 0,  .k = 0x00000043}, // (005) jeq      #0x43            jt 21	jf 6
-    {.code = OP_JEQ,  .jt = 14, .jf = 0,  .k = 0x00000044}, // (006) jeq      #0x44            jt 21	jf 7
-    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000038}, // (007) ldh      [56]
-    {.code = OP_JEQ,  .jt = 12, .jf = 11, .k = 0x00000043}, // (008) jeq      #0x43            jt 21	jf 20
-    {.code = OP_JEQ,  .jt = 0,  .jf = 12, .k = 0x00000800}, // (009) jeq      #0x800           jt 10	jf 22
-    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x00000017}, // (010) ldb      [23]
-    {.code = OP_JEQ,  .jt = 0,  .jf = 10, .k = 0x00000011}, // (011) jeq      #0x11            jt 12	jf 22
-    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000014}, // (012) ldh      [20]
-    {.code = OP_JSET, .jt = 8,  .jf = 0,  .k = 0x00001fff}, // (013) jset     #0x1fff          jt 22	jf 14
-    {.code = OP_LDXB, .jt = 0,  .jf = 0,  .k = 0x0000000e}, // (014) ldxb     4*([14]&0xf)
-    {.code = OP_LDHI, .jt = 0,  .jf = 0,  .k = 0x0000000e}, // (015) ldh      [x + 14]
-    {.code = OP_JEQ,  .jt = 4,  .jf = 0,  .k = 0x00000043}, // (016) jeq      #0x43            jt 21	jf 17
-    {.code = OP_JEQ,  .jt = 3,  .jf = 0,  .k = 0x00000044}, // (017) jeq      #0x44            jt 21	jf 18
-    {.code = OP_LDHI, .jt = 0,  .jf = 0,  .k = 0x00000010}, // (018) ldh      [x + 16]
-    {.code = OP_JEQ,  .jt = 1,  .jf = 0,  .k = 0x00000043}, // (019) jeq      #0x43            jt 21	jf 20
-    {.code = OP_JEQ,  .jt = 0,  .jf = 1,  .k = 0x00000044}, // (020) jeq      #0x44            jt 21	jf 22
-    {.code = OP_RET,  .jt = 0,  .jf = 0,  .k = 0x00040000}, // (021) ret      #262144
-    {.code = OP_RET,  .jt = 0,  .jf = 0,  .k = 0x00000000}, // (022) ret      #0
+    {.code = OP_JEQ,  .jt = 0,  .jf = 20, .k = 0x00000800}, // (001) jeq      #0x800           jt 2	jf 22
+    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x0000000e}, // (002) ldb      [14]
+    {.code = OP_JEQ,  .jt = 0,  .jf = 28, .k = 0x00000045}, // (003) jeq      #0x45            jt 4	jf 32
+    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x00000017}, // (004) ldb      [23]
+    {.code = OP_JEQ,  .jt = 0,  .jf = 26, .k = 0x00000011}, // (005) jeq      #0x11            jt 6	jf 32
+    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000014}, // (006) ldh      [20]
+    {.code = OP_JSET, .jt = 24, .jf = 0,  .k = 0x00001fff}, // (007) jset     #0x1fff          jt 32	jf 8
+    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000022}, // (008) ldh      [34]
+    {.code = OP_JEQ,  .jt = 4,  .jf = 0,  .k = 0x00000043}, // (009) jeq      #0x43            jt 14	jf 10
+    {.code = OP_JEQ,  .jt = 3,  .jf = 0,  .k = 0x00000044}, // (010) jeq      #0x44            jt 14	jf 11
+    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000024}, // (011) ldh      [36]
+    {.code = OP_JEQ,  .jt = 1,  .jf = 0,  .k = 0x00000043}, // (012) jeq      #0x43            jt 14	jf 13
+    {.code = OP_JEQ,  .jt = 0,  .jf = 18, .k = 0x00000044}, // (013) jeq      #0x44            jt 14	jf 32
+    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x0000002a}, // (014) ldb      [42]
+    {.code = OP_JEQ,  .jt = 1,  .jf = 0,  .k = 0x00000001}, // (015) jeq      #0x1             jt 17	jf 16
+    {.code = OP_JEQ,  .jt = 0,  .jf = 15, .k = 0x00000002}, // (016) jeq      #0x2             jt 17	jf 32
+    {.code = OP_LDWA, .jt = 0,  .jf = 0,  .k = 0x00000116}, // (017) ld       [278]
+    {.code = OP_JEQ,  .jt = 0,  .jf = 13, .k = 0x63825363}, // (018) jeq      #0x63825363      jt 19	jf 32
+    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x0000011a}, // (019) ldb      [282]
+    {.code = OP_JEQ,  .jt = 0,  .jf = 10, .k = 0x00000035}, // (020) jeq      #0x35            jt 21	jf 31
+    {.code = OP_RET,  .jt = 0,  .jf = 0,  .k = DHCP_MIN_SNAPLEN}, // (021) ret  #285
+    {.code = OP_JEQ,  .jt = 0,  .jf = 9,  .k = 0x000086dd}, // (022) jeq      #0x86dd          jt 23	jf 32
+    {.code = OP_LDB,  .jt = 0,  .jf = 0,  .k = 0x00000014}, // (023) ldb      [20]
+    {.code = OP_JEQ,  .jt = 0,  .jf = 7,  .k = 0x00000011}, // (024) jeq      #0x11            jt 25	jf 32
+    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000036}, // (025) ldh      [54]
+    {.code = OP_JEQ,  .jt = 4,  .jf = 0,  .k = 0x00000222}, // (026) jeq      #0x222           jt 31	jf 27
+    {.code = OP_JEQ,  .jt = 3,  .jf = 0,  .k = 0x00000223}, // (027) jeq      #0x223           jt 31	jf 28
+    {.code = OP_LDHA, .jt = 0,  .jf = 0,  .k = 0x00000038}, // (028) ldh      [56]
+    {.code = OP_JEQ,  .jt = 1,  .jf = 0,  .k = 0x00000222}, // (029) jeq      #0x222           jt 31	jf 30
+    {.code = OP_JEQ,  .jt = 0,  .jf = 1,  .k = 0x00000223}, // (030) jeq      #0x223           jt 31	jf 32
+    {.code = OP_RET,  .jt = 0,  .jf = 0,  .k = 0x00040000}, // (031) ret      #262144
+    {.code = OP_RET,  .jt = 0,  .jf = 0,  .k = 0x00000000}, // (032) ret      #0
 };
 
 /** Filter program socket struct */
@@ -84,24 +139,188 @@ static struct sock_fprog dhcp_sock_bfp = {
     .len = sizeof(dhcp_bpf_code) / sizeof(*dhcp_bpf_code), .filter = dhcp_bpf_code
 };
 
-/** Aggregate device of DHCP interfaces. It contains aggregate counters from
-    all interfaces
+/** Max number of instructions of the eBPF counting program */
+#define EBPF_PROG_MAX_INSN  96
+/** Number of entries of the eBPF counter map, indexed by dir * DHCP_MESSAGE_TYPE_COUNT + type */
+#define EBPF_MAP_ENTRIES    (DHCP_DIR_COUNT * DHCP_MESSAGE_TYPE_COUNT)
+/** Return value of the eBPF program for packets left to user space, same as the classic filter */
+#define EBPF_RET_PASS       0x00040000
+
+/** Jump targets of the eBPF counting program */
+typedef enum
+{
+    EBPF_LABEL_DROP,        /** packet is counted or of no interest, do not copy it */
+    EBPF_LABEL_PASS,        /** packet is parsed in user space */
+    EBPF_LABEL_IPV6,        /** IPv6 frame */
+    EBPF_LABEL_PORT_OK,     /** DHCP UDP port matched */
+    EBPF_LABEL_RX,          /** packet is received */
+    EBPF_LABEL_DIR,         /** direction is known */
+    EBPF_LABEL_SERVER,      /** message is sent by the server */
+    EBPF_LABEL_COUNT,       /** packet counts */
+
+    EBPF_LABEL_NUM
+} ebpf_label_t;
+
+/** eBPF program under construction */
+typedef struct
+{
+    struct bpf_insn insn[EBPF_PROG_MAX_INSN];   /** program instructions */
+    int8_t jmp_label[EBPF_PROG_MAX_INSN];       /** label of a jump instruction, -1 if none */
+    int label_pc[EBPF_LABEL_NUM];               /** instruction index of a label */
+    uint32_t len;                               /** number of instructions */
+} ebpf_prog_t;
+
+/** Relay transaction, a DHCP message received by the relay and waiting to be forwarded */
+typedef struct
+{
+    uint64_t ts_us;                 /** capture time of the message, 0 if the entry is free */
+    dhcp_device_context_t *agg_dev; /** aggregate device of the vlan the message is relayed for */
+    uint32_t xid;                   /** DHCP transaction ID */
+    dhcp_relay_leg_t leg;           /** relay leg */
+    bool received;                  /** captured on the receiving side, else on the forwarding one */
+} relay_xact_t;
+
+/** Relay transactions, open addressing with linear probing so that the capture path never allocates */
+static relay_xact_t relay_xacts[RELAY_XACT_TABLE_SIZE];
+
+/** Downlink (vlan) interfaces. Each one has an aggregate device containing aggregate counters from the vlan
+    and the uplinks relaying for it
  */
-static dhcp_device_context_t aggregate_dev = {0};
+static dhcp_device_context_t **vlan_devs = NULL;
+/** Number of downlink (vlan) interfaces */
+static uint32_t vlan_dev_nr = 0;
+
+/** Capture device of the shared socket. It owns the socket, ring and buffer, packets are handed to the interface
+    with the matching ifindex
+ */
+static dhcp_device_context_t shared_dev = {0};
+/** Interfaces captured through the shared socket */
+static dhcp_device_context_t **shared_devs = NULL;
+/** Number of interfaces captured through the shared socket */
+static uint32_t shared_dev_nr = 0;
 
 /** Monitored DHCP message type */
 static dhcp_message_type_t monitored_msgs[] = {
     DHCP_MESSAGE_TYPE_DISCOVER,
     DHCP_MESSAGE_TYPE_OFFER,
     DHCP_MESSAGE_TYPE_REQUEST,
-    DHCP_MESSAGE_TYPE_ACK
+    DHCP_MESSAGE_TYPE_ACK,
+    DHCPV6_MESSAGE_TYPE_SOLICIT,
+    DHCPV6_MESSAGE_TYPE_ADVERTISE,
+    DHCPV6_MESSAGE_TYPE_REQUEST,
+    DHCPV6_MESSAGE_TYPE_REPLY
 };
 
 /** Number of monitored DHCP message type */
 static uint8_t monitored_msg_sz = sizeof(monitored_msgs) / sizeof(*monitored_msgs);
 
 /**
- * @code handle_dhcp_option_53(context, dhcp_option, dir, iphdr, dhcphdr);
+ * @code find_aggregate(vlan_ip);
+ *
+ * @brief finds the aggregate device of the vlan with the given IP address
+ *
+ * @param vlan_ip       vlan IP address
+ *
+ * @return pointer to the aggregate device, NULL if no monitored vlan has this address
+ */
+static dhcp_device_context_t* find_aggregate(in_addr_t vlan_ip)
+{
+    for (uint32_t i = 0; i < vlan_dev_nr; i++) {
+        if (vlan_devs[i]->ip == vlan_ip) {
+            return vlan_devs[i]->agg_dev;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @code find_relay_xact(agg_dev, xid, leg, ts_us, free_xact);
+ *
+ * @brief finds the entry of a relay transaction in the transaction table
+ *
+ * @param agg_dev           aggregate device of the vlan
+ * @param xid               DHCP transaction ID
+ * @param leg               relay leg
+ * @param ts_us             current time (usec), older entries than RELAY_XACT_TIMEOUT_US are free
+ * @param free_xact(out)    first free entry probed, NULL if none
+ *
+ * @return pointer to the entry of the transaction, NULL if it is not in the table
+ */
+static relay_xact_t* find_relay_xact(dhcp_device_context_t *agg_dev,
+                                     uint32_t xid,
+                                     dhcp_relay_leg_t leg,
+                                     uint64_t ts_us,
+                                     relay_xact_t **free_xact)
+{
+    uint32_t hash = (xid * 2654435761u) ^ leg;
+
+    *free_xact = NULL;
+    for (uint32_t i = 0; i < RELAY_XACT_MAX_PROBE; i++) {
+        relay_xact_t *xact = &relay_xacts[(hash + i) & (RELAY_XACT_TABLE_SIZE - 1)];
+
+        if ((xact->ts_us == 0) || (xact->ts_us + RELAY_XACT_TIMEOUT_US < ts_us)) {
+            if (*free_xact == NULL) {
+                *free_xact = xact;
+            }
+        } else if ((xact->xid == xid) && (xact->leg == leg) && (xact->agg_dev == agg_dev)) {
+            return xact;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @code update_relay_latency(context, agg_dev, xid, leg, ts_us);
+ *
+ * @brief tracks a relay transaction. The receiving side (downlink for client messages, uplink for server ones)
+ *        and the forwarding side each record the capture time of the message, whichever comes second adds the
+ *        time between both to the latency histogram of the vlan. Interfaces are read from separate sockets, so
+ *        the forwarded copy may be handled first. Retransmissions restart the transaction, and only the first
+ *        forwarded copy of a message sent to several servers is measured.
+ *
+ * @param context       Device (interface) context
+ * @param agg_dev       aggregate device of the vlan the message is relayed for
+ * @param xid           DHCP transaction ID
+ * @param leg           relay leg
+ * @param ts_us         capture time of the message (usec)
+ *
+ * @return none
+ */
+static void update_relay_latency(dhcp_device_context_t *context,
+                                 dhcp_device_context_t *agg_dev,
+                                 uint32_t xid,
+                                 dhcp_relay_leg_t leg,
+                                 uint64_t ts_us)
+{
+    relay_xact_t *free_xact;
+    relay_xact_t *xact = find_relay_xact(agg_dev, xid, leg, ts_us, &free_xact);
+    bool received = (leg == DHCP_RELAY_LEG_CLIENT) != context->is_uplink;
+
+    if ((xact != NULL) && (xact->received != received) &&
+        (received ? xact->ts_us >= ts_us : ts_us >= xact->ts_us)) {
+        uint64_t latency = received ? xact->ts_us - ts_us : ts_us - xact->ts_us;
+        uint32_t bucket = latency ? 64 - __builtin_clzll(latency) : 0;
+
+        if (bucket >= DHCP_LATENCY_BUCKETS) {
+            bucket = DHCP_LATENCY_BUCKETS - 1;
+        }
+        agg_dev->latency[DHCP_COUNTERS_CURRENT][leg][bucket]++;
+        xact->ts_us = 0;
+    } else if ((xact != NULL) && !received && xact->received) {
+        // forwarded before it was received, not this transaction
+    } else if ((xact != NULL) || ((xact = free_xact) != NULL)) {
+        xact->ts_us = ts_us;
+        xact->agg_dev = agg_dev;
+        xact->xid = xid;
+        xact->leg = leg;
+        xact->received = received;
+    }
+}
+
+/**
+ * @code handle_dhcp_option_53(context, dhcp_option, dir, iphdr, dhcphdr, ts_us);
  *
  * @brief handle the logic related to DHCP option 53
  *
@@ -110,6 +329,7 @@ static uint8_t monitored_msg_sz = sizeof(monitored_msgs) / sizeof(*monitored_msg
  * @param dir           packet direction
  * @param iphdr         pointer to packet IP header
  * @param dhcphdr       pointer to DHCP header
+ * @param ts_us         capture time of the packet (usec)
  *
  * @return none
  */
@@ -117,9 +337,13 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
                                   const u_char *dhcp_option,
                                   dhcp_packet_direction_t dir,
                                   struct ip *iphdr,
-                                  uint8_t *dhcphdr)
+                                  uint8_t *dhcphdr,
+                                  uint64_t ts_us)
 {
+    dhcp_device_context_t *agg_dev = NULL;
+    dhcp_relay_leg_t leg = DHCP_RELAY_LEG_CLIENT;
     in_addr_t giaddr;
+
     switch (dhcp_option[2])
     {
     // DHCP messages send by client
@@ -130,26 +354,317 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
     case DHCP_MESSAGE_TYPE_INFORM:
         giaddr = ntohl(dhcphdr[DHCP_GIADDR_OFFSET] << 24 | dhcphdr[DHCP_GIADDR_OFFSET + 1] << 16 |
                        dhcphdr[DHCP_GIADDR_OFFSET + 2] << 8 | dhcphdr[DHCP_GIADDR_OFFSET + 3]);
-        if ((context->vlan_ip == giaddr && context->is_uplink && dir == DHCP_TX) ||
-            (!context->is_uplink && dir == DHCP_RX && iphdr->ip_dst.s_addr == INADDR_BROADCAST)) {
-            context->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
-            aggregate_dev.counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+        if (context->is_uplink && dir == DHCP_TX) {
+            agg_dev = find_aggregate(giaddr);
+        } else if (!context->is_uplink && dir == DHCP_RX && iphdr->ip_dst.s_addr == INADDR_BROADCAST) {
+            agg_dev = context->agg_dev;
         }
         break;
     // DHCP messages send by server
     case DHCP_MESSAGE_TYPE_OFFER:
     case DHCP_MESSAGE_TYPE_ACK:
     case DHCP_MESSAGE_TYPE_NAK:
-        if ((context->vlan_ip == iphdr->ip_dst.s_addr && context->is_uplink && dir == DHCP_RX) ||
-            (!context->is_uplink && dir == DHCP_TX)) {
-            context->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
-            aggregate_dev.counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+        leg = DHCP_RELAY_LEG_SERVER;
+        if (context->is_uplink && dir == DHCP_RX) {
+            agg_dev = find_aggregate(iphdr->ip_dst.s_addr);
+        } else if (!context->is_uplink && dir == DHCP_TX) {
+            agg_dev = context->agg_dev;
         }
         break;
     default:
         syslog(LOG_WARNING, "handle_dhcp_option_53(%s): Unknown DHCP option 53 type %d", context->intf, dhcp_option[2]);
         break;
     }
+
+    // uplink messages are counted for the vlan they are relayed for, the one owning the relay agent address
+    if (agg_dev != NULL) {
+        uint32_t xid = dhcphdr[DHCP_XID_OFFSET] << 24 | dhcphdr[DHCP_XID_OFFSET + 1] << 16 |
+                       dhcphdr[DHCP_XID_OFFSET + 2] << 8 | dhcphdr[DHCP_XID_OFFSET + 3];
+
+        context->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+        agg_dev->counters[DHCP_COUNTERS_CURRENT][dir][dhcp_option[2]]++;
+        update_relay_latency(context, agg_dev, xid, leg, ts_us);
+    }
+}
+
+/**
+ * @code packet_direction(context, ethhdr);
+ *
+ * @brief tells whether this device (interface) sent the frame
+ *
+ * @param context       Device (interface) context
+ * @param ethhdr        pointer to the Ether header of the frame
+ *
+ * @return DHCP_TX if the source mac is the device mac, DHCP_RX otherwise
+ */
+static dhcp_packet_direction_t packet_direction(dhcp_device_context_t *context, struct ether_header *ethhdr)
+{
+    return (ethhdr->ether_shost[0] == context->mac[0] &&
+            ethhdr->ether_shost[1] == context->mac[1] &&
+            ethhdr->ether_shost[2] == context->mac[2] &&
+            ethhdr->ether_shost[3] == context->mac[3] &&
+            ethhdr->ether_shost[4] == context->mac[4] &&
+            ethhdr->ether_shost[5] == context->mac[5]) ?
+            DHCP_TX : DHCP_RX;
+}
+
+/**
+ * @code dhcpv6_message_type(msg_type);
+ *
+ * @brief maps a DHCPv6 msg-type to its counter
+ *
+ * @param msg_type      msg-type field of a DHCPv6 message
+ *
+ * @return counter index, DHCP_MESSAGE_TYPE_COUNT if the message is not counted
+ */
+static dhcp_message_type_t dhcpv6_message_type(uint8_t msg_type)
+{
+    switch (msg_type)
+    {
+    case 1:
+        return DHCPV6_MESSAGE_TYPE_SOLICIT;
+    case 2:
+        return DHCPV6_MESSAGE_TYPE_ADVERTISE;
+    case 3:
+        return DHCPV6_MESSAGE_TYPE_REQUEST;
+    case 7:
+        return DHCPV6_MESSAGE_TYPE_REPLY;
+    case 12:
+        return DHCPV6_MESSAGE_TYPE_RELAY_FORW;
+    case 13:
+        return DHCPV6_MESSAGE_TYPE_RELAY_REPL;
+    default:
+        return DHCP_MESSAGE_TYPE_COUNT;
+    }
+}
+
+/**
+ * @code dhcpv6_relayed_message_type(msg, msg_sz);
+ *
+ * @brief finds the type of the message carried in the Relay Message option of a RELAY-FORW/RELAY-REPL message
+ *
+ * @param msg           pointer to the DHCPv6 relay message
+ * @param msg_sz        captured length of the message
+ *
+ * @return counter index of the relayed message, DHCP_MESSAGE_TYPE_COUNT if it is not found or not counted
+ */
+static dhcp_message_type_t dhcpv6_relayed_message_type(const uint8_t *msg, ssize_t msg_sz)
+{
+    ssize_t offset = DHCPV6_RELAY_OPTIONS_OFFSET;
+
+    while (offset + 4 < msg_sz) {
+        uint16_t code = msg[offset] << 8 | msg[offset + 1];
+        uint16_t len = msg[offset + 2] << 8 | msg[offset + 3];
+
+        if ((code == DHCPV6_OPTION_RELAY_MSG) && (len > 0)) {
+            return dhcpv6_message_type(msg[offset + 4]);
+        }
+        offset += 4 + len;
+    }
+
+    return DHCP_MESSAGE_TYPE_COUNT;
+}
+
+/**
+ * @code dhcpv6_relay_aggregate(msg, msg_sz);
+ *
+ * @brief finds the aggregate device of the vlan a RELAY-FORW/RELAY-REPL message is relayed for. With a single
+ *        vlan, it is that vlan. Otherwise the vlan is named by the Interface-Id option of the message.
+ *
+ * @param msg           pointer to the DHCPv6 relay message
+ * @param msg_sz        captured length of the message
+ *
+ * @return pointer to the aggregate device, NULL if the vlan is not known
+ */
+static dhcp_device_context_t* dhcpv6_relay_aggregate(const uint8_t *msg, ssize_t msg_sz)
+{
+    ssize_t offset = DHCPV6_RELAY_OPTIONS_OFFSET;
+
+    if (vlan_dev_nr == 1) {
+        return vlan_devs[0]->agg_dev;
+    }
+
+    while (offset + 4 < msg_sz) {
+        uint16_t code = msg[offset] << 8 | msg[offset + 1];
+        uint16_t len = msg[offset + 2] << 8 | msg[offset + 3];
+
+        if (code == DHCPV6_OPTION_INTERFACE_ID) {
+            for (uint32_t i = 0; i < vlan_dev_nr; i++) {
+                if ((offset + 4 + len <= msg_sz) && (strlen(vlan_devs[i]->intf) == len) &&
+                    (memcmp(vlan_devs[i]->intf, msg + offset + 4, len) == 0)) {
+                    return vlan_devs[i]->agg_dev;
+                }
+            }
+            break;
+        }
+        offset += 4 + len;
+    }
+
+    return NULL;
+}
+
+/**
+ * @code handle_dhcpv6_packet(context, buffer, buffer_sz);
+ *
+ * @brief parses a captured DHCPv6 packet and updates device counters. The relay receives SOLICIT/REQUEST and sends
+ *        ADVERTISE/REPLY on the downlink, and sends RELAY-FORW and receives RELAY-REPL on the uplinks. A relay
+ *        message is counted both as itself and as the message it carries, so the health checks match the messages
+ *        of the downlink against the relayed ones as for DHCPv4. Relay messages of an unknown vlan are counted
+ *        on the uplink only.
+ *
+ * @param context       Device (interface) context
+ * @param buffer        pointer to the start of the captured Ethernet frame
+ * @param buffer_sz     captured length of the frame
+ *
+ * @return none
+ */
+static void handle_dhcpv6_packet(dhcp_device_context_t *context, uint8_t *buffer, ssize_t buffer_sz)
+{
+    struct udphdr *udp = (struct udphdr*) (buffer + UDPV6_START_OFFSET);
+    const uint8_t *msg = buffer + DHCPV6_START_OFFSET;
+    ssize_t msg_sz = buffer_sz - DHCPV6_START_OFFSET;
+
+    if ((msg_sz > 0) && (ntohs(udp->len) > sizeof(struct udphdr))) {
+        dhcp_packet_direction_t dir = packet_direction(context, (struct ether_header*) buffer);
+        dhcp_message_type_t type = dhcpv6_message_type(msg[0]);
+        dhcp_message_type_t relayed = DHCP_MESSAGE_TYPE_COUNT;
+        dhcp_device_context_t *agg_dev = context->agg_dev;
+        bool counted = false;
+
+        if (ntohs(udp->len) - sizeof(struct udphdr) < msg_sz) {
+            msg_sz = ntohs(udp->len) - sizeof(struct udphdr);
+        }
+
+        switch (type)
+        {
+        case DHCPV6_MESSAGE_TYPE_SOLICIT:
+        case DHCPV6_MESSAGE_TYPE_REQUEST:
+            counted = !context->is_uplink && dir == DHCP_RX;
+            break;
+        case DHCPV6_MESSAGE_TYPE_ADVERTISE:
+        case DHCPV6_MESSAGE_TYPE_REPLY:
+            counted = !context->is_uplink && dir == DHCP_TX;
+            break;
+        case DHCPV6_MESSAGE_TYPE_RELAY_FORW:
+            counted = context->is_uplink && dir == DHCP_TX;
+            relayed = dhcpv6_relayed_message_type(msg, msg_sz);
+            agg_dev = dhcpv6_relay_aggregate(msg, msg_sz);
+            break;
+        case DHCPV6_MESSAGE_TYPE_RELAY_REPL:
+            counted = context->is_uplink && dir == DHCP_RX;
+            relayed = dhcpv6_relayed_message_type(msg, msg_sz);
+            agg_dev = dhcpv6_relay_aggregate(msg, msg_sz);
+            break;
+        default:
+            break;
+        }
+
+        if (counted) {
+            context->counters[DHCP_COUNTERS_CURRENT][dir][type]++;
+            if (agg_dev != NULL) {
+                agg_dev->counters[DHCP_COUNTERS_CURRENT][dir][type]++;
+            }
+
+            if ((relayed != DHCP_MESSAGE_TYPE_COUNT) &&
+                (relayed != DHCPV6_MESSAGE_TYPE_RELAY_FORW) && (relayed != DHCPV6_MESSAGE_TYPE_RELAY_REPL)) {
+                context->counters[DHCP_COUNTERS_CURRENT][dir][relayed]++;
+                if (agg_dev != NULL) {
+                    agg_dev->counters[DHCP_COUNTERS_CURRENT][dir][relayed]++;
+                }
+            }
+        }
+    } else {
+        syslog(LOG_WARNING, "handle_dhcpv6_packet(%s): read length (%ld) is too small to capture DHCPv6 message",
+               context->intf, buffer_sz);
+    }
+}
+
+/**
+ * @code handle_dhcp_packet(context, buffer, buffer_sz, ts_us);
+ *
+ * @brief parses a captured DHCP packet and updates device counters
+ *
+ * @param context       Device (interface) context
+ * @param buffer        pointer to the start of the captured Ethernet frame
+ * @param buffer_sz     captured length of the frame
+ * @param ts_us         capture time of the frame (usec)
+ *
+ * @return none
+ */
+static void handle_dhcp_packet(dhcp_device_context_t *context, uint8_t *buffer, ssize_t buffer_sz, uint64_t ts_us)
+{
+    struct ether_header *ethhdr = (struct ether_header*) buffer;
+    struct ip *iphdr = (struct ip*) (buffer + IP_START_OFFSET);
+    struct udphdr *udp = (struct udphdr*) (buffer + UDP_START_OFFSET);
+    uint8_t *dhcphdr = buffer + DHCP_START_OFFSET;
+    int dhcp_option_offset = DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE;
+
+    if ((buffer_sz >= ETHER_HDR_LEN) && (ntohs(ethhdr->ether_type) == ETHERTYPE_IPV6)) {
+        handle_dhcpv6_packet(context, buffer, buffer_sz);
+        return;
+    }
+
+    if ((buffer_sz > UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) &&
+        (ntohs(udp->len) > DHCP_OPTIONS_HEADER_SIZE)) {
+        int dhcp_sz = ntohs(udp->len) < buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr) ?
+                      ntohs(udp->len) : buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr);
+        int dhcp_option_sz = dhcp_sz - DHCP_OPTIONS_HEADER_SIZE;
+        const u_char *dhcp_option = buffer + dhcp_option_offset;
+        dhcp_packet_direction_t dir = packet_direction(context, ethhdr);
+        int offset = 0;
+        int stop_dhcp_processing = 0;
+        while ((offset < (dhcp_option_sz + 1)) && dhcp_option[offset] != 255) {
+            switch (dhcp_option[offset])
+            {
+            case 53:
+                if (offset < (dhcp_option_sz + 2)) {
+                    handle_dhcp_option_53(context, &dhcp_option[offset], dir, iphdr, dhcphdr, ts_us);
+                }
+                stop_dhcp_processing = 1; // break while loop since we are only interested in Option 53
+                break;
+            default:
+                break;
+            }
+
+            if (stop_dhcp_processing == 1) {
+                break;
+            }
+
+            if (dhcp_option[offset] == 0) { // DHCP Option Padding
+                offset++;
+            } else {
+                offset += dhcp_option[offset + 1] + 2;
+            }
+        }
+    } else {
+        syslog(LOG_WARNING, "handle_dhcp_packet(%s): read length (%ld) is too small to capture DHCP options",
+               context->intf, buffer_sz);
+    }
+}
+
+/**
+ * @code demux_device(context, ifindex);
+ *
+ * @brief finds the device (interface) a packet read from context's socket was captured on
+ *
+ * @param context       Device (interface) context owning the socket
+ * @param ifindex       interface index the packet was captured on
+ *
+ * @return device (interface) context, NULL if the interface is not monitored
+ */
+static dhcp_device_context_t* demux_device(dhcp_device_context_t *context, int ifindex)
+{
+    if (context->ifindex == ifindex) {
+        return context;
+    }
+
+    for (uint32_t i = 0; i < shared_dev_nr; i++) {
+        if (shared_devs[i]->ifindex == ifindex) {
+            return shared_devs[i];
+        }
+    }
+
+    return NULL;
 }
 
 /**
@@ -166,59 +681,350 @@ static void handle_dhcp_option_53(dhcp_device_context_t *context,
 static void read_callback(int fd, short event, void *arg)
 {
     dhcp_device_context_t *context = (dhcp_device_context_t*) arg;
+    struct sockaddr_ll addr;
+    struct iovec iov = {.iov_base = context->buffer, .iov_len = context->snaplen};
+    uint8_t control[CMSG_SPACE(sizeof(struct timespec))];
+    struct msghdr msg = {
+        .msg_name = &addr, .msg_namelen = sizeof(addr),
+        .msg_iov = &iov, .msg_iovlen = 1,
+        .msg_control = control, .msg_controllen = sizeof(control)
+    };
     ssize_t buffer_sz;
 
-    while ((event == EV_READ) &&
-           ((buffer_sz = recv(fd, context->buffer, context->snaplen, MSG_DONTWAIT)) > 0)) {
-        struct ether_header *ethhdr = (struct ether_header*) context->buffer;
-        struct ip *iphdr = (struct ip*) (context->buffer + IP_START_OFFSET);
-        struct udphdr *udp = (struct udphdr*) (context->buffer + UDP_START_OFFSET);
-        uint8_t *dhcphdr = context->buffer + DHCP_START_OFFSET;
-        int dhcp_option_offset = DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE;
-
-        if ((buffer_sz > UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) &&
-            (ntohs(udp->len) > DHCP_OPTIONS_HEADER_SIZE)) {
-            int dhcp_sz = ntohs(udp->len) < buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr) ?
-                          ntohs(udp->len) : buffer_sz - UDP_START_OFFSET - sizeof(struct udphdr);
-            int dhcp_option_sz = dhcp_sz - DHCP_OPTIONS_HEADER_SIZE;
-            const u_char *dhcp_option = context->buffer + dhcp_option_offset;
-            dhcp_packet_direction_t dir = (ethhdr->ether_shost[0] == context->mac[0] &&
-                                           ethhdr->ether_shost[1] == context->mac[1] &&
-                                           ethhdr->ether_shost[2] == context->mac[2] &&
-                                           ethhdr->ether_shost[3] == context->mac[3] &&
-                                           ethhdr->ether_shost[4] == context->mac[4] &&
-                                           ethhdr->ether_shost[5] == context->mac[5]) ?
-                                           DHCP_TX : DHCP_RX;
-            int offset = 0;
-            int stop_dhcp_processing = 0;
-            while ((offset < (dhcp_option_sz + 1)) && dhcp_option[offset] != 255) {
-                switch (dhcp_option[offset])
-                {
-                case 53:
-                    if (offset < (dhcp_option_sz + 2)) {
-                        handle_dhcp_option_53(context, &dhcp_option[offset], dir, iphdr, dhcphdr);
-                    }
-                    stop_dhcp_processing = 1; // break while loop since we are only interested in Option 53
-                    break;
-                default:
-                    break;
-                }
+    while ((event == EV_READ) && ((buffer_sz = recvmsg(fd, &msg, MSG_DONTWAIT)) > 0)) {
+        dhcp_device_context_t *dev = demux_device(context, addr.sll_ifindex);
+        if (dev != NULL) {
+            struct timespec ts = {0};
+            struct cmsghdr *cmsg;
 
-                if (stop_dhcp_processing == 1) {
-                    break;
+            // kernel capture time of the packet, the ring path has it in the frame header
+            for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SCM_TIMESTAMPNS)) {
+                    memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
                 }
+            }
+            if (ts.tv_sec == 0) {
+                clock_gettime(CLOCK_REALTIME, &ts);
+            }
+            handle_dhcp_packet(dev, context->buffer, buffer_sz, ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+        }
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_controllen = sizeof(control);
+    }
+}
 
-                if (dhcp_option[offset] == 0) { // DHCP Option Padding
-                    offset++;
-                } else {
-                    offset += dhcp_option[offset + 1] + 2;
-                }
+/**
+ * @code read_ring_callback(fd, event, arg);
+ *
+ * @brief callback for libevent which is called when the kernel has handed over receive ring blocks. Packets are
+ *        processed in place and every consumed block is returned to the kernel.
+ *
+ * @param fd            socket the ring is attached to
+ * @param event         libevent triggered event
+ * @param arg           user provided argument for callback (interface context)
+ *
+ * @return none
+ */
+static void read_ring_callback(int fd, short event, void *arg)
+{
+    dhcp_device_context_t *context = (dhcp_device_context_t*) arg;
+
+    while (event == EV_READ) {
+        struct tpacket_block_desc *block =
+            (struct tpacket_block_desc*) (context->ring + context->ring_block * RX_RING_BLOCK_SIZE);
+
+        if ((block->hdr.bh1.block_status & TP_STATUS_USER) == 0) {
+            break;
+        }
+        __sync_synchronize();
+
+        struct tpacket3_hdr *pkt = (struct tpacket3_hdr*) ((uint8_t*) block + block->hdr.bh1.offset_to_first_pkt);
+        for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++) {
+            struct sockaddr_ll *addr = (struct sockaddr_ll*) ((uint8_t*) pkt + TPACKET_ALIGN(sizeof(*pkt)));
+            dhcp_device_context_t *dev = demux_device(context, addr->sll_ifindex);
+            ssize_t buffer_sz = pkt->tp_snaplen < context->snaplen ? pkt->tp_snaplen : context->snaplen;
+
+            if (dev != NULL) {
+                // kernel capture time, as read on the recv() path
+                handle_dhcp_packet(dev, (uint8_t*) pkt + pkt->tp_mac, buffer_sz,
+                                   pkt->tp_sec * 1000000ULL + pkt->tp_nsec / 1000);
             }
-        } else {
-            syslog(LOG_WARNING, "read_callback(%s): read length (%ld) is too small to capture DHCP options",
-                   context->intf, buffer_sz);
+            pkt = (struct tpacket3_hdr*) ((uint8_t*) pkt + pkt->tp_next_offset);
+        }
+
+        __sync_synchronize();
+        block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+        context->ring_block = (context->ring_block + 1) % context->ring_block_nr;
+    }
+}
+
+/**
+ * @code ebpf_emit(prog, code, dst, src, off, imm);
+ *
+ * @brief appends an instruction to an eBPF program
+ *
+ * @return none
+ */
+static void ebpf_emit(ebpf_prog_t *prog, uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+    assert(prog->len < EBPF_PROG_MAX_INSN);
+
+    prog->insn[prog->len] = (struct bpf_insn) {.code = code, .dst_reg = dst, .src_reg = src, .off = off, .imm = imm};
+    prog->jmp_label[prog->len] = -1;
+    prog->len++;
+}
+
+/**
+ * @code ebpf_emit_jmp(prog, op, dst, imm, label);
+ *
+ * @brief appends a conditional jump comparing dst to imm, or an unconditional jump if op is BPF_JA
+ *
+ * @return none
+ */
+static void ebpf_emit_jmp(ebpf_prog_t *prog, uint8_t op, uint8_t dst, int32_t imm, ebpf_label_t label)
+{
+    ebpf_emit(prog, BPF_JMP | op | BPF_K, dst, 0, 0, imm);
+    prog->jmp_label[prog->len - 1] = label;
+}
+
+/**
+ * @code ebpf_emit_jne32(prog, dst, imm, label);
+ *
+ * @brief appends a jump taken if the 32 bit value in dst differs from imm. Immediates are sign extended by
+ *        BPF_JMP, so imm is moved to a scratch register first.
+ *
+ * @return none
+ */
+static void ebpf_emit_jne32(ebpf_prog_t *prog, uint8_t dst, uint32_t imm, ebpf_label_t label)
+{
+    ebpf_emit(prog, BPF_ALU | BPF_MOV | BPF_K, BPF_REG_2, 0, 0, imm);
+    ebpf_emit(prog, BPF_JMP | BPF_JNE | BPF_X, dst, BPF_REG_2, 0, 0);
+    prog->jmp_label[prog->len - 1] = label;
+}
+
+/**
+ * @code ebpf_emit_ld_abs(prog, size, offset);
+ *
+ * @brief appends a load of the packet data at offset to R0. The program returns 0 if offset is out of the packet.
+ *
+ * @return none
+ */
+static void ebpf_emit_ld_abs(ebpf_prog_t *prog, uint8_t size, int32_t offset)
+{
+    ebpf_emit(prog, BPF_LD | size | BPF_ABS, 0, 0, 0, offset);
+}
+
+/**
+ * @code ebpf_label(prog, label);
+ *
+ * @brief places label at the next instruction
+ *
+ * @return none
+ */
+static void ebpf_label(ebpf_prog_t *prog, ebpf_label_t label)
+{
+    prog->label_pc[label] = prog->len;
+}
+
+/**
+ * @code build_ebpf_prog(context, map_fd, prog);
+ *
+ * @brief builds the eBPF socket filter counting DHCP messages of this interface in the map. It applies the same
+ *        relay checks as handle_dhcp_option_53 with the interface mac, vlan IP and uplink flag built in. Counted
+ *        and irrelevant packets are dropped in the kernel. DHCPv6 packets and packets whose first DHCP option is
+ *        not option 53 are passed to user space as the classic filter does.
+ *
+ * @param context       Device (interface) context
+ * @param map_fd        eBPF counter map
+ * @param prog(out)     built program
+ *
+ * @return none
+ */
+static void build_ebpf_prog(dhcp_device_context_t *context, int map_fd, ebpf_prog_t *prog)
+{
+    uint32_t mac_hi = context->mac[0] << 24 | context->mac[1] << 16 | context->mac[2] << 8 | context->mac[3];
+    uint32_t mac_lo = context->mac[4] << 8 | context->mac[5];
+
+    prog->len = 0;
+
+    // R6: context, required by the packet loads. R7: direction, R8: message type
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);
+
+    ebpf_emit_ld_abs(prog, BPF_H, ETHER_START_OFFSET + 12);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, ETHERTYPE_IPV6, EBPF_LABEL_IPV6);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, ETHERTYPE_IP, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_B, IP_START_OFFSET + 9);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, IPPROTO_UDP, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_H, IP_START_OFFSET + 6);
+    ebpf_emit_jmp(prog, BPF_JSET, BPF_REG_0, 0x1fff, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_B, IP_START_OFFSET);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, 0x45, EBPF_LABEL_DROP);
+
+    ebpf_emit_ld_abs(prog, BPF_H, UDP_START_OFFSET);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 67, EBPF_LABEL_PORT_OK);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 68, EBPF_LABEL_PORT_OK);
+    ebpf_emit_ld_abs(prog, BPF_H, UDP_START_OFFSET + 2);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 67, EBPF_LABEL_PORT_OK);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 68, EBPF_LABEL_PORT_OK);
+    ebpf_emit_jmp(prog, BPF_JA, 0, 0, EBPF_LABEL_DROP);
+
+    ebpf_label(prog, EBPF_LABEL_PORT_OK);
+    ebpf_emit_ld_abs(prog, BPF_B, DHCP_START_OFFSET + DHCP_OP_OFFSET);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 0, EBPF_LABEL_DROP);
+    ebpf_emit_jmp(prog, BPF_JGT, BPF_REG_0, 2, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_W, DHCP_START_OFFSET + DHCP_COOKIE_OFFSET);
+    ebpf_emit_jne32(prog, BPF_REG_0, DHCP_COOKIE, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_H, UDP_START_OFFSET + 4);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_2, 0, 0, DHCP_OPTIONS_HEADER_SIZE);
+    ebpf_emit(prog, BPF_JMP | BPF_JGE | BPF_X, BPF_REG_2, BPF_REG_0, 0, 0);
+    prog->jmp_label[prog->len - 1] = EBPF_LABEL_PASS;
+    ebpf_emit_ld_abs(prog, BPF_B, DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, 53, EBPF_LABEL_PASS);
+    ebpf_emit_ld_abs(prog, BPF_B, DHCP_START_OFFSET + DHCP_OPTIONS_HEADER_SIZE + 2);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_8, BPF_REG_0, 0, 0);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_8, 0, EBPF_LABEL_PASS);
+    ebpf_emit_jmp(prog, BPF_JGT, BPF_REG_8, DHCP_MESSAGE_TYPE_INFORM, EBPF_LABEL_PASS);
+
+    ebpf_emit_ld_abs(prog, BPF_W, ETHER_START_OFFSET + 6);
+    ebpf_emit_jne32(prog, BPF_REG_0, mac_hi, EBPF_LABEL_RX);
+    ebpf_emit_ld_abs(prog, BPF_H, ETHER_START_OFFSET + 10);
+    ebpf_emit_jne32(prog, BPF_REG_0, mac_lo, EBPF_LABEL_RX);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, DHCP_TX);
+    ebpf_emit_jmp(prog, BPF_JA, 0, 0, EBPF_LABEL_DIR);
+    ebpf_label(prog, EBPF_LABEL_RX);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_7, 0, 0, DHCP_RX);
+    ebpf_label(prog, EBPF_LABEL_DIR);
+
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_8, DHCP_MESSAGE_TYPE_OFFER, EBPF_LABEL_SERVER);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_8, DHCP_MESSAGE_TYPE_ACK, EBPF_LABEL_SERVER);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_8, DHCP_MESSAGE_TYPE_NAK, EBPF_LABEL_SERVER);
+    // DHCP messages send by client
+    if (context->is_uplink) {
+        ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_7, DHCP_TX, EBPF_LABEL_DROP);
+        ebpf_emit_ld_abs(prog, BPF_W, DHCP_START_OFFSET + DHCP_GIADDR_OFFSET);
+        ebpf_emit_jne32(prog, BPF_REG_0, ntohl(context->vlan_ip), EBPF_LABEL_DROP);
+    } else {
+        ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_7, DHCP_RX, EBPF_LABEL_DROP);
+        ebpf_emit_ld_abs(prog, BPF_W, IP_START_OFFSET + 16);
+        ebpf_emit_jne32(prog, BPF_REG_0, ntohl(INADDR_BROADCAST), EBPF_LABEL_DROP);
+    }
+    ebpf_emit_jmp(prog, BPF_JA, 0, 0, EBPF_LABEL_COUNT);
+    // DHCP messages send by server
+    ebpf_label(prog, EBPF_LABEL_SERVER);
+    if (context->is_uplink) {
+        ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_7, DHCP_RX, EBPF_LABEL_DROP);
+        ebpf_emit_ld_abs(prog, BPF_W, IP_START_OFFSET + 16);
+        ebpf_emit_jne32(prog, BPF_REG_0, ntohl(context->vlan_ip), EBPF_LABEL_DROP);
+    } else {
+        ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_7, DHCP_TX, EBPF_LABEL_DROP);
+    }
+
+    ebpf_label(prog, EBPF_LABEL_COUNT);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MUL | BPF_K, BPF_REG_7, 0, 0, DHCP_MESSAGE_TYPE_COUNT);
+    ebpf_emit(prog, BPF_ALU64 | BPF_ADD | BPF_X, BPF_REG_7, BPF_REG_8, 0, 0);
+    ebpf_emit(prog, BPF_STX | BPF_MEM | BPF_W, BPF_REG_10, BPF_REG_7, -4, 0);
+    ebpf_emit(prog, BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, map_fd);
+    ebpf_emit(prog, 0, 0, 0, 0, 0);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0);
+    ebpf_emit(prog, BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4);
+    ebpf_emit(prog, BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 0, EBPF_LABEL_DROP);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, 1);
+    ebpf_emit(prog, BPF_STX | BPF_XADD | BPF_DW, BPF_REG_0, BPF_REG_1, 0, 0);
+
+    ebpf_label(prog, EBPF_LABEL_DROP);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0);
+    ebpf_emit(prog, BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+    // DHCPv6 is left to user space
+    ebpf_label(prog, EBPF_LABEL_IPV6);
+    ebpf_emit_ld_abs(prog, BPF_B, IPV6_START_OFFSET + 6);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, IPPROTO_UDP, EBPF_LABEL_DROP);
+    ebpf_emit_ld_abs(prog, BPF_H, UDPV6_START_OFFSET);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 546, EBPF_LABEL_PASS);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 547, EBPF_LABEL_PASS);
+    ebpf_emit_ld_abs(prog, BPF_H, UDPV6_START_OFFSET + 2);
+    ebpf_emit_jmp(prog, BPF_JEQ, BPF_REG_0, 546, EBPF_LABEL_PASS);
+    ebpf_emit_jmp(prog, BPF_JNE, BPF_REG_0, 547, EBPF_LABEL_DROP);
+
+    ebpf_label(prog, EBPF_LABEL_PASS);
+    ebpf_emit(prog, BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, EBPF_RET_PASS);
+    ebpf_emit(prog, BPF_JMP | BPF_EXIT, 0, 0, 0, 0);
+
+    for (uint32_t pc = 0; pc < prog->len; pc++) {
+        if (prog->jmp_label[pc] >= 0) {
+            prog->insn[pc].off = prog->label_pc[prog->jmp_label[pc]] - pc - 1;
+        }
+    }
+}
+
+/**
+ * @code attach_ebpf_counters(context);
+ *
+ * @brief creates the eBPF counter map of this interface and attaches the counting program to its socket
+ *
+ * @param context       Device (interface) context
+ *
+ * @return 0 on success, otherwise for failure
+ */
+static int attach_ebpf_counters(dhcp_device_context_t *context)
+{
+    int rv = -1;
+    int prog_fd = -1;
+
+    do {
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_type = BPF_MAP_TYPE_ARRAY;
+        attr.key_size = sizeof(uint32_t);
+        attr.value_size = sizeof(uint64_t);
+        attr.max_entries = EBPF_MAP_ENTRIES;
+        context->ebpf_map = syscall(__NR_bpf, BPF_MAP_CREATE, &attr, sizeof(attr));
+        if (context->ebpf_map < 0) {
+            syslog(LOG_WARNING, "bpf: failed to create counter map for '%s' with '%s'\n",
+                   context->intf, strerror(errno));
+            break;
+        }
+
+        ebpf_prog_t prog;
+        build_ebpf_prog(context, context->ebpf_map, &prog);
+
+        static char log_buf[4096];
+        memset(&attr, 0, sizeof(attr));
+        attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+        attr.insns = (uintptr_t) prog.insn;
+        attr.insn_cnt = prog.len;
+        attr.license = (uintptr_t) "GPL";
+        attr.log_buf = (uintptr_t) log_buf;
+        attr.log_size = sizeof(log_buf);
+        attr.log_level = 1;
+        prog_fd = syscall(__NR_bpf, BPF_PROG_LOAD, &attr, sizeof(attr));
+        if (prog_fd < 0) {
+            syslog(LOG_WARNING, "bpf: failed to load counting program for '%s' with '%s': %s\n",
+                   context->intf, strerror(errno), log_buf);
+            break;
+        }
+
+        if (setsockopt(context->sock, SOL_SOCKET, SO_ATTACH_BPF, &prog_fd, sizeof(prog_fd)) != 0) {
+            syslog(LOG_WARNING, "setsockopt: failed to attach counting program to '%s' with '%s'\n",
+                   context->intf, strerror(errno));
+            break;
         }
+
+        rv = 0;
+    } while (0);
+
+    // the socket holds a reference to the attached program
+    if (prog_fd >= 0) {
+        close(prog_fd);
     }
+
+    if ((rv != 0) && (context->ebpf_map >= 0)) {
+        close(context->ebpf_map);
+        context->ebpf_map = -1;
+    }
+
+    return rv;
 }
 
 /**
@@ -243,6 +1049,31 @@ static bool dhcp_device_is_dhcp_inactive(uint64_t counters[][DHCP_DIR_COUNT][DHC
     return rv;
 }
 
+/**
+ * @code dhcp_device_is_context_inactive(context);
+ *
+ * @brief Check if there were no DHCP activity to judge the health of a device on. An aggregate device is checked
+ *        over its own vlan, other devices are idle only if all vlans are
+ *
+ * @param context   Device (interface) context
+ *
+ * @return true if there were no DHCP activity, false otherwise
+ */
+static bool dhcp_device_is_context_inactive(dhcp_device_context_t *context)
+{
+    bool inactive = true;
+
+    if (context->agg_dev == context) {
+        inactive = dhcp_device_is_dhcp_inactive(context->counters);
+    } else {
+        for (uint32_t i = 0; inactive && (i < vlan_dev_nr); i++) {
+            inactive = dhcp_device_is_dhcp_inactive(vlan_devs[i]->agg_dev->counters);
+        }
+    }
+
+    return inactive;
+}
+
 /**
  * @code dhcp_device_is_dhcp_msg_unhealthy(type, counters);
  *
@@ -333,15 +1164,17 @@ static dhcp_mon_status_t dhcp_device_check_negative_health(uint64_t counters[][D
  *
  * @param check_type    type of health check
  * @param counters      current/snapshot counter
+ * @param inactive      no DHCP traffic was relayed in the last window
  *
  * @return DHCP_MON_STATUS_HEALTHY, DHCP_MON_STATUS_UNHEALTHY, or DHCP_MON_STATUS_INDETERMINATE
  */
 static dhcp_mon_status_t dhcp_device_check_health(dhcp_mon_check_t check_type,
-                                                  uint64_t counters[][DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT])
+                                                  uint64_t counters[][DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT],
+                                                  bool inactive)
 {
     dhcp_mon_status_t rv = DHCP_MON_STATUS_HEALTHY;
 
-    if (dhcp_device_is_dhcp_inactive(aggregate_dev.counters)) {
+    if (inactive) {
         rv = DHCP_MON_STATUS_INDETERMINATE;
     } else if (check_type == DHCP_MON_CHECK_POSITIVE) {
         rv = dhcp_device_check_positive_health(counters);
@@ -386,6 +1219,26 @@ static void dhcp_print_counters(const char *vlan_intf,
         DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCP_MESSAGE_TYPE_ACK],
         DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCP_MESSAGE_TYPE_ACK]
     );
+
+    syslog(
+        LOG_NOTICE,
+        "[%*s-%*s rx/tx] Solicit: %*lu/%*lu, Advertise: %*lu/%*lu, Request: %*lu/%*lu, Reply: %*lu/%*lu, "
+        "Relay-Forw: %*lu/%*lu, Relay-Repl: %*lu/%*lu\n",
+        IF_NAMESIZE, vlan_intf,
+        (int) strlen(counter_desc[type]), counter_desc[type],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_SOLICIT],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_SOLICIT],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_ADVERTISE],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_ADVERTISE],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_REQUEST],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_REQUEST],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_REPLY],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_REPLY],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_RELAY_FORW],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_RELAY_FORW],
+        DHCP_COUNTER_WIDTH, counters[DHCP_RX][DHCPV6_MESSAGE_TYPE_RELAY_REPL],
+        DHCP_COUNTER_WIDTH, counters[DHCP_TX][DHCPV6_MESSAGE_TYPE_RELAY_REPL]
+    );
 }
 
 /**
@@ -422,6 +1275,7 @@ static int init_socket(dhcp_device_context_t *context, const char *intf)
 
         strncpy(context->intf, intf, sizeof(context->intf) - 1);
         context->intf[sizeof(context->intf) - 1] = '\0';
+        context->ifindex = addr.sll_ifindex;
 
         rv = 0;
     } while (0);
@@ -429,6 +1283,184 @@ static int init_socket(dhcp_device_context_t *context, const char *intf)
     return rv;
 }
 
+/**
+ * @code init_rx_ring(context, block_nr);
+ *
+ * @brief switches the socket to TPACKET_V3 and maps a receive ring of block_nr blocks
+ *
+ * @param context           pointer to device (interface) context
+ * @param block_nr          number of ring blocks
+ *
+ * @return 0 on success, otherwise for failure
+ */
+static int init_rx_ring(dhcp_device_context_t *context, uint32_t block_nr)
+{
+    int rv = -1;
+
+    do {
+        int version = TPACKET_V3;
+        if (setsockopt(context->sock, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+            syslog(LOG_WARNING, "setsockopt: failed to set TPACKET_V3 on '%s' with '%s'\n",
+                   context->intf, strerror(errno));
+            break;
+        }
+
+        struct tpacket_req3 req;
+        memset(&req, 0, sizeof(req));
+        req.tp_block_size = RX_RING_BLOCK_SIZE;
+        req.tp_block_nr = block_nr;
+        req.tp_frame_size = RX_RING_FRAME_SIZE;
+        req.tp_frame_nr = (RX_RING_BLOCK_SIZE / RX_RING_FRAME_SIZE) * block_nr;
+        req.tp_retire_blk_tov = RX_RING_BLOCK_TMO;
+        if (setsockopt(context->sock, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+            syslog(LOG_WARNING, "setsockopt: failed to set up receive ring on '%s' with '%s'\n",
+                   context->intf, strerror(errno));
+            break;
+        }
+
+        context->ring = mmap(NULL, (size_t) RX_RING_BLOCK_SIZE * block_nr, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_LOCKED, context->sock, 0);
+        if (context->ring == MAP_FAILED) {
+            syslog(LOG_WARNING, "mmap: failed to map receive ring of '%s' with '%s'\n",
+                   context->intf, strerror(errno));
+            context->ring = NULL;
+            break;
+        }
+        context->ring_block_nr = block_nr;
+        context->ring_block = 0;
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code start_socket_capture(context, ring_blocks, ebpf_counters, base);
+ *
+ * @brief attaches bpf program to the socket of context and registers it with libevent, reading through a
+ *        receive ring when possible
+ *
+ * @param context           pointer to device (interface) context owning the socket
+ * @param ring_blocks       number of receive ring blocks, 0 to capture with recv()
+ * @param ebpf_counters     count DHCP messages with the eBPF program, falls back to the classic filter
+ * @param base              pointer to libevent base
+ *
+ * @return 0 on success, otherwise for failure
+ */
+static int start_socket_capture(dhcp_device_context_t *context,
+                                uint32_t ring_blocks,
+                                uint8_t ebpf_counters,
+                                struct event_base *base)
+{
+    int rv = -1;
+
+    do {
+        if (ebpf_counters && (attach_ebpf_counters(context) == 0)) {
+            syslog(LOG_INFO, "start_socket_capture(%s): DHCP messages are counted by eBPF", context->intf);
+        } else if (setsockopt(context->sock, SOL_SOCKET, SO_ATTACH_FILTER,
+                              &dhcp_sock_bfp, sizeof(dhcp_sock_bfp)) != 0) {
+            syslog(LOG_ALERT, "setsockopt: failed to attach filter with '%s'\n", strerror(errno));
+            break;
+        }
+
+        event_callback_fn callback = read_ring_callback;
+        if ((ring_blocks == 0) || (init_rx_ring(context, ring_blocks) != 0)) {
+            if (ring_blocks != 0) {
+                syslog(LOG_WARNING, "start_socket_capture(%s): falling back to recv() capture", context->intf);
+            }
+
+            context->buffer = (uint8_t *) malloc(context->snaplen);
+            if (context->buffer == NULL) {
+                syslog(LOG_ALERT, "malloc: failed to allocate memory for socket buffer '%s'\n", strerror(errno));
+                break;
+            }
+            callback = read_callback;
+
+            // have packets stamped as they are queued, read_callback gets the stamp with each packet
+            int on = 1;
+            if (setsockopt(context->sock, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0) {
+                syslog(LOG_WARNING, "setsockopt: failed to enable timestamps of '%s' with '%s'\n",
+                       context->intf, strerror(errno));
+            }
+        }
+
+        struct event *ev = event_new(base, context->sock, EV_READ | EV_PERSIST, callback, context);
+        if (ev == NULL) {
+            syslog(LOG_ALERT, "event_new: failed to allocate memory for libevent event '%s'\n", strerror(errno));
+            break;
+        }
+        event_add(ev, NULL);
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code dhcp_latency_percentile(latency, permille);
+ *
+ * @brief finds the bucket of a latency histogram holding the given percentile
+ *
+ * @param latency   latency histogram
+ * @param permille  percentile, in per mille
+ *
+ * @return upper bound (usec) of the bucket, 0 for an empty histogram
+ */
+static uint64_t dhcp_latency_percentile(uint64_t latency[DHCP_LATENCY_BUCKETS], uint32_t permille)
+{
+    uint64_t total = 0;
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < DHCP_LATENCY_BUCKETS; i++) {
+        total += latency[i];
+    }
+
+    for (uint32_t i = 0; (total > 0) && (i < DHCP_LATENCY_BUCKETS); i++) {
+        sum += latency[i];
+        if (sum * 1000 >= total * permille) {
+            return 1ULL << i;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @code dhcp_print_latency(vlan_intf, type, latency);
+ *
+ * @brief prints relay latency percentiles to syslog
+ *
+ * @param vlan_intf vlan interface name
+ * @param type      counter type
+ * @param latency   relay latency histograms
+ *
+ * @return none
+ */
+static void dhcp_print_latency(const char *vlan_intf,
+                               dhcp_counters_type_t type,
+                               uint64_t latency[][DHCP_LATENCY_BUCKETS])
+{
+    static const char *counter_desc[DHCP_COUNTERS_COUNT] = {
+        [DHCP_COUNTERS_CURRENT] = " Current",
+        [DHCP_COUNTERS_SNAPSHOT] = "Snapshot"
+    };
+
+    syslog(
+        LOG_NOTICE,
+        "[%*s-%*s latency usec] Client p50/p90/p99: <%lu/<%lu/<%lu, Server p50/p90/p99: <%lu/<%lu/<%lu\n",
+        IF_NAMESIZE, vlan_intf,
+        (int) strlen(counter_desc[type]), counter_desc[type],
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_CLIENT], 500),
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_CLIENT], 900),
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_CLIENT], 990),
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_SERVER], 500),
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_SERVER], 900),
+        dhcp_latency_percentile(latency[DHCP_RELAY_LEG_SERVER], 990)
+    );
+}
+
 /**
  * @code initialize_intf_mac_and_ip_addr(context);
  *
@@ -498,15 +1530,13 @@ int dhcp_device_get_ip(dhcp_device_context_t *context, in_addr_t *ip)
 }
 
 /**
- * @code dhcp_device_get_aggregate_context();
+ * @code dhcp_device_get_aggregate_context(idx);
  *
  * @brief Accessor method
- *
- * @return pointer to aggregate device (interface) context
  */
-dhcp_device_context_t* dhcp_device_get_aggregate_context()
+dhcp_device_context_t* dhcp_device_get_aggregate_context(uint32_t idx)
 {
-    return &aggregate_dev;
+    return idx < vlan_dev_nr ? vlan_devs[idx]->agg_dev : NULL;
 }
 
 /**
@@ -527,8 +1557,16 @@ int dhcp_device_init(dhcp_device_context_t **context, const char *intf, uint8_t
                 (initialize_intf_mac_and_ip_addr(dev_context) == 0)) {
 
                 dev_context->is_uplink = is_uplink;
+                dev_context->buffer = NULL;
+                dev_context->ring = NULL;
+                dev_context->ring_block_nr = 0;
+                dev_context->ring_block = 0;
+                dev_context->ebpf_map = -1;
+                dev_context->agg_dev = NULL;
+                memset(dev_context->ebpf_counters, 0, sizeof(dev_context->ebpf_counters));
 
                 memset(dev_context->counters, 0, sizeof(dev_context->counters));
+                memset(dev_context->latency, 0, sizeof(dev_context->latency));
 
                 *context = dev_context;
                 rv = 0;
@@ -543,14 +1581,78 @@ int dhcp_device_init(dhcp_device_context_t **context, const char *intf, uint8_t
 }
 
 /**
- * @code dhcp_device_start_capture(context, snaplen, base, vlan_ip);
+ * @code dhcp_device_init_aggregate(context, name);
+ *
+ * @brief creates the aggregate device of a downlink (vlan) interface
+ */
+int dhcp_device_init_aggregate(dhcp_device_context_t *context, const char *name)
+{
+    int rv = -1;
+
+    do {
+        if ((context == NULL) || context->is_uplink || (context->agg_dev != NULL)) {
+            syslog(LOG_ALERT, "dhcp_device_init_aggregate: invalid downlink interface context\n");
+            break;
+        }
+
+        dhcp_device_context_t **devs = realloc(vlan_devs, (vlan_dev_nr + 1) * sizeof(*vlan_devs));
+        if (devs == NULL) {
+            syslog(LOG_ALERT, "realloc: failed to allocate memory for vlan '%s'\n", context->intf);
+            break;
+        }
+        vlan_devs = devs;
+
+        dhcp_device_context_t *agg_dev = (dhcp_device_context_t *) calloc(1, sizeof(dhcp_device_context_t));
+        if (agg_dev == NULL) {
+            syslog(LOG_ALERT, "calloc: failed to allocate aggregate device memory for '%s'\n", context->intf);
+            break;
+        }
+
+        strncpy(agg_dev->intf, name, sizeof(agg_dev->intf) - 1);
+        agg_dev->sock = -1;
+        agg_dev->ebpf_map = -1;
+        agg_dev->ip = context->ip;
+        agg_dev->vlan_ip = context->ip;
+        agg_dev->agg_dev = agg_dev;
+
+        context->agg_dev = agg_dev;
+        vlan_devs[vlan_dev_nr++] = context;
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code capture_vlan_ip(context);
+ *
+ * @brief vlan IP address built in the eBPF program of an interface. A downlink relays for its own address, an
+ *        uplink for the address of the vlan when there is a single one.
+ *
+ * @param context           pointer to device (interface) context
+ *
+ * @return vlan IP address, 0 when an uplink relays for several vlans
+ */
+static in_addr_t capture_vlan_ip(dhcp_device_context_t *context)
+{
+    if (!context->is_uplink) {
+        return context->ip;
+    }
+
+    return vlan_dev_nr == 1 ? vlan_devs[0]->ip : 0;
+}
+
+/**
+ * @code dhcp_device_start_capture(context, snaplen, ring_blocks, ebpf_counters, base);
  *
  * @brief starts packet capture on this interface
  */
 int dhcp_device_start_capture(dhcp_device_context_t *context,
                               size_t snaplen,
-                              struct event_base *base,
-                              in_addr_t vlan_ip)
+                              uint32_t ring_blocks,
+                              uint8_t ebpf_counters,
+                              struct event_base *base)
 {
     int rv = -1;
 
@@ -560,33 +1662,84 @@ int dhcp_device_start_capture(dhcp_device_context_t *context,
             break;
         }
 
-        if (snaplen < UDP_START_OFFSET + sizeof(struct udphdr) + DHCP_OPTIONS_HEADER_SIZE) {
-            syslog(LOG_ALERT, "dhcp_device_start_capture(%s): snap length is too low to capture DHCP options", context->intf);
+        if (snaplen < DHCP_MIN_SNAPLEN) {
+            syslog(LOG_ALERT, "dhcp_device_start_capture(%s): snap length %zu is too low to capture DHCP options, "
+                   "at least %zu bytes are needed", context->intf, snaplen, DHCP_MIN_SNAPLEN);
             break;
         }
 
-        context->vlan_ip = vlan_ip;
+        context->vlan_ip = capture_vlan_ip(context);
+        context->snaplen = snaplen;
+
+        // the eBPF program counts uplink messages of one vlan only
+        rv = start_socket_capture(context, ring_blocks, ebpf_counters && (context->vlan_ip != 0), base);
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code dhcp_device_add_shared_capture(context);
+ *
+ * @brief hands packet capture of this interface over to the shared socket
+ */
+int dhcp_device_add_shared_capture(dhcp_device_context_t *context)
+{
+    int rv = -1;
+
+    do {
+        if (context == NULL) {
+            syslog(LOG_ALERT, "NULL interface context pointer'\n");
+            break;
+        }
 
-        context->buffer = (uint8_t *) malloc(snaplen);
-        if (context->buffer == NULL) {
-            syslog(LOG_ALERT, "malloc: failed to allocate memory for socket buffer '%s'\n", strerror(errno));
+        dhcp_device_context_t **devs = realloc(shared_devs, (shared_dev_nr + 1) * sizeof(*shared_devs));
+        if (devs == NULL) {
+            syslog(LOG_ALERT, "realloc: failed to allocate memory for shared capture of '%s'\n", context->intf);
             break;
         }
-        context->snaplen = snaplen;
+        shared_devs = devs;
+        shared_devs[shared_dev_nr++] = context;
 
-        if (setsockopt(context->sock, SOL_SOCKET, SO_ATTACH_FILTER, &dhcp_sock_bfp, sizeof(dhcp_sock_bfp)) != 0) {
-            syslog(LOG_ALERT, "setsockopt: failed to attach filter with '%s'\n", strerror(errno));
+        context->vlan_ip = capture_vlan_ip(context);
+
+        // the interface socket is not read, close it so that the kernel does not queue traffic to it
+        close(context->sock);
+        context->sock = -1;
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code dhcp_device_start_shared_capture(snaplen, ring_blocks, base);
+ *
+ * @brief starts packet capture of all interfaces added with dhcp_device_add_shared_capture on one socket
+ */
+int dhcp_device_start_shared_capture(size_t snaplen, uint32_t ring_blocks, struct event_base *base)
+{
+    int rv = -1;
+
+    do {
+        if (snaplen < DHCP_MIN_SNAPLEN) {
+            syslog(LOG_ALERT, "dhcp_device_start_shared_capture: snap length %zu is too low to capture DHCP options, "
+                   "at least %zu bytes are needed", snaplen, DHCP_MIN_SNAPLEN);
             break;
         }
 
-        struct event *ev = event_new(base, context->sock, EV_READ | EV_PERSIST, read_callback, context);
-        if (ev == NULL) {
-            syslog(LOG_ALERT, "event_new: failed to allocate memory for libevent event '%s'\n", strerror(errno));
+        // not bound to any interface, packets of interfaces that are not monitored are dropped by demux_device
+        shared_dev.sock = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK, htons(ETH_P_ALL));
+        if (shared_dev.sock < 0) {
+            syslog(LOG_ALERT, "socket: failed to open socket with '%s'\n", strerror(errno));
             break;
         }
-        event_add(ev, NULL);
 
-        rv = 0;
+        strncpy(shared_dev.intf, "shared", sizeof(shared_dev.intf) - 1);
+        shared_dev.snaplen = snaplen;
+
+        rv = start_socket_capture(&shared_dev, ring_blocks, 0, base);
     } while (0);
 
     return rv;
@@ -599,6 +1752,19 @@ int dhcp_device_start_capture(dhcp_device_context_t *context,
  */
 void dhcp_device_shutdown(dhcp_device_context_t *context)
 {
+    if (context->ring != NULL) {
+        munmap(context->ring, (size_t) RX_RING_BLOCK_SIZE * context->ring_block_nr);
+    }
+    if (context->sock >= 0) {
+        close(context->sock);
+    }
+    if (context->ebpf_map >= 0) {
+        close(context->ebpf_map);
+    }
+    if ((context->agg_dev != NULL) && (context->agg_dev != context)) {
+        free(context->agg_dev);
+    }
+    free(context->buffer);
     free(context);
 }
 
@@ -613,12 +1779,78 @@ dhcp_mon_status_t dhcp_device_get_status(dhcp_mon_check_t check_type, dhcp_devic
     dhcp_mon_status_t rv = DHCP_MON_STATUS_HEALTHY;
 
     if (context != NULL) {
-        rv = dhcp_device_check_health(check_type, context->counters);
+        rv = dhcp_device_check_health(check_type, context->counters, dhcp_device_is_context_inactive(context));
+    }
+
+    return rv;
+}
+
+/**
+ * @code dhcp_device_get_msg_status(check_type, context, type);
+ *
+ * @brief collects DHCP relay status info of one message type for a given interface
+ */
+dhcp_mon_status_t dhcp_device_get_msg_status(dhcp_mon_check_t check_type,
+                                             dhcp_device_context_t *context,
+                                             dhcp_message_type_t type)
+{
+    dhcp_mon_status_t rv = DHCP_MON_STATUS_HEALTHY;
+
+    if ((context != NULL) && (type < DHCP_MESSAGE_TYPE_COUNT)) {
+        if (dhcp_device_is_context_inactive(context)) {
+            rv = DHCP_MON_STATUS_INDETERMINATE;
+        } else if (check_type == DHCP_MON_CHECK_POSITIVE) {
+            if (dhcp_device_is_dhcp_msg_unhealthy(type, context->counters)) {
+                rv = DHCP_MON_STATUS_UNHEALTHY;
+            }
+        } else if (check_type == DHCP_MON_CHECK_NEGATIVE) {
+            if (context->counters[DHCP_COUNTERS_CURRENT][DHCP_TX][type] >
+                context->counters[DHCP_COUNTERS_SNAPSHOT][DHCP_TX][type]) {
+                rv = DHCP_MON_STATUS_UNHEALTHY;
+            }
+        }
     }
 
     return rv;
 }
 
+/**
+ * @code dhcp_device_sync_counters(context);
+ *
+ * @brief adds the DHCP messages counted by eBPF since the last call to device and aggregate counters
+ */
+void dhcp_device_sync_counters(dhcp_device_context_t *context)
+{
+    if ((context != NULL) && (context->ebpf_map >= 0)) {
+        dhcp_device_context_t *agg_dev = find_aggregate(context->vlan_ip);
+
+        for (uint32_t dir = 0; dir < DHCP_DIR_COUNT; dir++) {
+            for (uint32_t type = 0; type < DHCP_MESSAGE_TYPE_COUNT; type++) {
+                uint32_t key = dir * DHCP_MESSAGE_TYPE_COUNT + type;
+                uint64_t value;
+                union bpf_attr attr;
+
+                memset(&attr, 0, sizeof(attr));
+                attr.map_fd = context->ebpf_map;
+                attr.key = (uintptr_t) &key;
+                attr.value = (uintptr_t) &value;
+                if (syscall(__NR_bpf, BPF_MAP_LOOKUP_ELEM, &attr, sizeof(attr)) != 0) {
+                    syslog(LOG_WARNING, "bpf: failed to read counters of '%s' with '%s'\n",
+                           context->intf, strerror(errno));
+                    return;
+                }
+
+                uint64_t delta = value - context->ebpf_counters[dir][type];
+                context->ebpf_counters[dir][type] = value;
+                context->counters[DHCP_COUNTERS_CURRENT][dir][type] += delta;
+                if (agg_dev != NULL) {
+                    agg_dev->counters[DHCP_COUNTERS_CURRENT][dir][type] += delta;
+                }
+            }
+        }
+    }
+}
+
 /**
  * @code dhcp_device_update_snapshot(context);
  *
@@ -630,6 +1862,10 @@ void dhcp_device_update_snapshot(dhcp_device_context_t *context)
         memcpy(context->counters[DHCP_COUNTERS_SNAPSHOT],
                context->counters[DHCP_COUNTERS_CURRENT],
                sizeof(context->counters[DHCP_COUNTERS_SNAPSHOT]));
+        memcpy(context->latency[DHCP_COUNTERS_SNAPSHOT],
+               context->latency[DHCP_COUNTERS_CURRENT],
+               sizeof(context->latency[DHCP_COUNTERS_SNAPSHOT]));
+        memset(context->latency[DHCP_COUNTERS_CURRENT], 0, sizeof(context->latency[DHCP_COUNTERS_CURRENT]));
     }
 }
 
@@ -642,5 +1878,8 @@ void dhcp_device_print_status(dhcp_device_context_t *context, dhcp_counters_type
 {
     if (context != NULL) {
         dhcp_print_counters(context->intf, type, context->counters[type]);
+        if (context->agg_dev == context) {
+            dhcp_print_latency(context->intf, type, context->latency[type]);
+        }
     }
 }
@@ -31,6 +31,14 @@ typedef enum
     DHCP_MESSAGE_TYPE_RELEASE  = 7,
     DHCP_MESSAGE_TYPE_INFORM   = 8,
 
+    /** DHCPv6 messages are counted past the DHCPv4 ones */
+    DHCPV6_MESSAGE_TYPE_SOLICIT,
+    DHCPV6_MESSAGE_TYPE_ADVERTISE,
+    DHCPV6_MESSAGE_TYPE_REQUEST,
+    DHCPV6_MESSAGE_TYPE_REPLY,
+    DHCPV6_MESSAGE_TYPE_RELAY_FORW,
+    DHCPV6_MESSAGE_TYPE_RELAY_REPL,
+
     DHCP_MESSAGE_TYPE_COUNT
 } dhcp_message_type_t;
 
@@ -43,6 +51,18 @@ typedef enum
     DHCP_DIR_COUNT
 } dhcp_packet_direction_t;
 
+/** relay legs whose latency is measured */
+typedef enum
+{
+    DHCP_RELAY_LEG_CLIENT,  /** client message, downlink RX to uplink TX */
+    DHCP_RELAY_LEG_SERVER,  /** server message, uplink RX to downlink TX */
+
+    DHCP_RELAY_LEG_COUNT
+} dhcp_relay_leg_t;
+
+/** Relay latency histogram buckets, bucket n counts latencies of [2^(n-1), 2^n) usec, the last one all above */
+#define DHCP_LATENCY_BUCKETS    24
+
 /** counters type */
 typedef enum
 {
@@ -60,6 +80,24 @@ typedef enum
     DHCP_MON_STATUS_INDETERMINATE,  /** DHCP relay health could not be determined */
 } dhcp_mon_status_t;
 
+/** relay alarm level */
+typedef enum
+{
+    DHCP_ALARM_CLEAR,           /** DHCP relay is healthy, or not unhealthy for long enough */
+    DHCP_ALARM_WARNING,         /** DHCP relay has been unhealthy for the warning threshold */
+    DHCP_ALARM_CRITICAL,        /** DHCP relay has been unhealthy for the critical threshold */
+
+    DHCP_ALARM_COUNT
+} dhcp_alarm_level_t;
+
+/** relay alarm of one DHCP message type */
+typedef struct
+{
+    uint32_t level;                 /** dhcp_alarm_level_t */
+    uint32_t count;                 /** count of consecutive unhealthy checks */
+    uint64_t since;                 /** time the level was entered, seconds since the epoch */
+} dhcp_alarm_t;
+
 /** dhcp check type */
 typedef enum
 {
@@ -68,18 +106,31 @@ typedef enum
 } dhcp_mon_check_t;
 
 /** DHCP device (interface) context */
-typedef struct
+typedef struct dhcp_device_context
 {
-    int sock;                       /** Raw socket associated with this device/interface */
+    int sock;                       /** Raw socket associated with this device/interface, -1 if shared */
+    int ifindex;                    /** interface index of this device (interface) */
     in_addr_t ip;                   /** network address of this device (interface) */
     uint8_t mac[ETHER_ADDR_LEN];    /** hardware address of this device (interface) */
-    in_addr_t vlan_ip;              /** Vlan IP address */
+    in_addr_t vlan_ip;              /** Vlan IP address, 0 for an uplink relaying for several vlans */
     uint8_t is_uplink;              /** north interface? */
     char intf[IF_NAMESIZE];         /** device (interface) name */
     uint8_t *buffer;                /** buffer used to read socket data */
     size_t snaplen;                 /** snap length or buffer size */
+    uint8_t *ring;                  /** mmap'ed TPACKET_V3 receive ring, NULL when capturing with recv() */
+    uint32_t ring_block_nr;         /** number of blocks in the receive ring */
+    uint32_t ring_block;            /** next receive ring block to be consumed */
+    int ebpf_map;                   /** eBPF counter map, -1 when counting in user space */
+    uint64_t ebpf_counters[DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
+                                    /** eBPF counters as last read from the map */
     uint64_t counters[DHCP_COUNTERS_COUNT][DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
                                     /** current/snapshot counters of DHCP packets */
+    uint64_t latency[DHCP_COUNTERS_COUNT][DHCP_RELAY_LEG_COUNT][DHCP_LATENCY_BUCKETS];
+                                    /** relay latency of the running/last window, aggregate devices only */
+    dhcp_alarm_t alarm[DHCP_MESSAGE_TYPE_COUNT];
+                                    /** relay alarms by message type, checked devices only */
+    struct dhcp_device_context *agg_dev;
+                                    /** aggregate device of a downlink, itself for an aggregate, NULL otherwise */
 } dhcp_device_context_t;
 
 /**
@@ -95,13 +146,15 @@ typedef struct
 int dhcp_device_get_ip(dhcp_device_context_t *context, in_addr_t *ip);
 
 /**
- * @code dhcp_device_get_aggregate_context();
+ * @code dhcp_device_get_aggregate_context(idx);
  *
  * @brief Accessor method
  *
- * @return pointer to aggregate device (interface) context
+ * @param idx           index of the vlan, in the order the aggregate devices were created
+ *
+ * @return pointer to aggregate device (interface) context, NULL past the last vlan
  */
-dhcp_device_context_t* dhcp_device_get_aggregate_context();
+dhcp_device_context_t* dhcp_device_get_aggregate_context(uint32_t idx);
 
 /**
  * @code dhcp_device_init(context, intf, is_uplink);
@@ -119,21 +172,63 @@ int dhcp_device_init(dhcp_device_context_t **context,
                      uint8_t is_uplink);
 
 /**
- * @code dhcp_device_start_capture(context, snaplen, base, vlan_ip);
+ * @code dhcp_device_init_aggregate(context, name);
+ *
+ * @brief creates the aggregate device of a downlink (vlan) interface. It counts the messages of the vlan and the
+ *        ones relayed for it on the uplinks, which are matched on the vlan IP address (DHCPv4) or on the
+ *        Interface-Id option (DHCPv6). All downlinks are to be added before capture starts.
+ *
+ * @param context           pointer to downlink device (interface) context
+ * @param name              aggregate device name
+ *
+ * @return 0 on success, otherwise for failure
+ */
+int dhcp_device_init_aggregate(dhcp_device_context_t *context, const char *name);
+
+/**
+ * @code dhcp_device_start_capture(context, snaplen, ring_blocks, ebpf_counters, base);
  *
  * @brief starts packet capture on this interface
  *
  * @param context           pointer to device (interface) context
  * @param snaplen           length of packet capture
+ * @param ring_blocks       number of TPACKET_V3 receive ring blocks, 0 to capture with recv()
+ * @param ebpf_counters     count DHCP messages in the kernel with an eBPF socket filter, not used on uplinks
+ *                          relaying for several vlans
  * @param base              pointer to libevent base
- * @param vlan_ip           vlan IP address
  *
  * @return 0 on success, otherwise for failure
  */
 int dhcp_device_start_capture(dhcp_device_context_t *context,
                               size_t snaplen,
-                              struct event_base *base,
-                              in_addr_t vlan_ip);
+                              uint32_t ring_blocks,
+                              uint8_t ebpf_counters,
+                              struct event_base *base);
+
+/**
+ * @code dhcp_device_add_shared_capture(context);
+ *
+ * @brief hands packet capture of this interface over to the shared socket. Packets are read once from a socket
+ *        that is not bound to any interface and handed to the device with the matching ifindex.
+ *
+ * @param context           pointer to device (interface) context
+ *
+ * @return 0 on success, otherwise for failure
+ */
+int dhcp_device_add_shared_capture(dhcp_device_context_t *context);
+
+/**
+ * @code dhcp_device_start_shared_capture(snaplen, ring_blocks, base);
+ *
+ * @brief starts packet capture of all interfaces added with dhcp_device_add_shared_capture on one socket
+ *
+ * @param snaplen           length of packet capture
+ * @param ring_blocks       number of TPACKET_V3 receive ring blocks, 0 to capture with recv()
+ * @param base              pointer to libevent base
+ *
+ * @return 0 on success, otherwise for failure
+ */
+int dhcp_device_start_shared_capture(size_t snaplen, uint32_t ring_blocks, struct event_base *base);
 
 /**
  * @code dhcp_device_shutdown(context);
@@ -159,19 +254,45 @@ void dhcp_device_shutdown(dhcp_device_context_t *context);
  */
 dhcp_mon_status_t dhcp_device_get_status(dhcp_mon_check_t check_type, dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_device_get_msg_status(check_type, context, type);
+ *
+ * @brief collects DHCP relay status info of one message type for a given interface. A positive check expects the
+ *        received messages of that type to be relayed, a negative check expects none to be transmitted.
+ *
+ * @param check_type        Type of validation
+ * @param context           Device (interface) context
+ * @param type              DHCP message type
+ *
+ * @return DHCP_MON_STATUS_HEALTHY, DHCP_MON_STATUS_UNHEALTHY, or DHCP_MON_STATUS_INDETERMINATE
+ */
+dhcp_mon_status_t dhcp_device_get_msg_status(dhcp_mon_check_t check_type,
+                                             dhcp_device_context_t *context,
+                                             dhcp_message_type_t type);
+
+/**
+ * @code dhcp_device_sync_counters(context);
+ *
+ * @param context   Device (interface) context
+ *
+ * @brief adds the DHCP messages counted by eBPF since the last call to device and aggregate counters
+ */
+void dhcp_device_sync_counters(dhcp_device_context_t *context);
+
 /**
  * @code dhcp_device_update_snapshot(context);
  *
  * @param context   Device (interface) context
  *
- * @brief Update device/interface counters snapshot
+ * @brief Update device/interface counters snapshot. The relay latency of the running window becomes the snapshot
+ *        and a new window is started
  */
 void dhcp_device_update_snapshot(dhcp_device_context_t *context);
 
 /**
  * @code dhcp_device_print_status(context, type);
  *
- * @brief prints status counters to syslog. If context is null, it will print aggregate status
+ * @brief prints status counters to syslog, and the relay latency percentiles of aggregate devices
  *
  * @param context       Device (interface) context
  * @param counters_type Counter type to be printed
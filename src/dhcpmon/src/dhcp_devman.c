@@ -8,12 +8,16 @@
 #include <string.h>
 #include <syslog.h>
 #include <sys/queue.h>
+#include <sys/mman.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "dhcp_devman.h"
 
 /** Prefix appended to Aggregation device */
-#define AGG_DEV_PREFIX  "Agg-"
 
 /** struct for interface information */
 struct intf
@@ -33,21 +37,127 @@ static uint32_t dhcp_num_north_intf = 0;
 /** dhcp_num_mgmt_intf number of mgmt interfaces */
 static uint32_t dhcp_num_mgmt_intf = 0;
 
-/** On Device  vlan interface IP address corresponding vlan downlink IP
- *  This IP is used to filter Offer/Ack packet coming from DHCP server */
-static in_addr_t vlan_ip = 0;
-
 /** mgmt interface */
 static struct intf *mgmt_intf = NULL;
 
+/** first downlink interface name, it names the shared memory segment */
+static const char *south_intf_name = NULL;
+
+/** shared memory segment counter snapshots are published to */
+static dhcp_shm_t *shm = NULL;
+/** size of the shared memory segment */
+static size_t shm_sz = 0;
+/** name of the shared memory segment */
+static char shm_name[sizeof(DHCP_SHM_PREFIX) + IF_NAMESIZE];
+
 /**
- * @code dhcp_devman_get_vlan_intf();
+ * @code dhcp_devman_shm_init();
+ *
+ * @brief creates the shared memory segment with one entry per interface and one per aggregate device
+ *
+ * @return none
+ */
+static void dhcp_devman_shm_init()
+{
+    struct intf *int_ptr;
+    uint32_t intf_count = dhcp_num_south_intf;
+    int fd = -1;
+
+    LIST_FOREACH(int_ptr, &intfs, entry) {
+        intf_count++;
+    }
+
+    do {
+        snprintf(shm_name, sizeof(shm_name), "%s%s", DHCP_SHM_PREFIX, south_intf_name);
+        fd = shm_open(shm_name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+        if (fd < 0) {
+            syslog(LOG_WARNING, "shm_open: failed to create '%s' with '%s'\n", shm_name, strerror(errno));
+            break;
+        }
+
+        shm_sz = sizeof(dhcp_shm_t) + intf_count * sizeof(dhcp_shm_intf_t);
+        if (ftruncate(fd, shm_sz) != 0) {
+            syslog(LOG_WARNING, "ftruncate: failed to size '%s' with '%s'\n", shm_name, strerror(errno));
+            shm_unlink(shm_name);
+            break;
+        }
+
+        shm = mmap(NULL, shm_sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (shm == MAP_FAILED) {
+            syslog(LOG_WARNING, "mmap: failed to map '%s' with '%s'\n", shm_name, strerror(errno));
+            shm = NULL;
+            shm_unlink(shm_name);
+            break;
+        }
+
+        shm->magic = DHCP_SHM_MAGIC;
+        shm->version = DHCP_SHM_VERSION;
+        shm->seq = 0;
+        shm->intf_count = intf_count;
+        shm->timestamp = 0;
+
+        uint32_t i = 0;
+        LIST_FOREACH(int_ptr, &intfs, entry) {
+            snprintf(shm->intf[i].name, sizeof(shm->intf[i].name), "%s", int_ptr->name);
+            shm->intf[i].is_uplink = int_ptr->is_uplink;
+            i++;
+        }
+        for (uint32_t idx = 0; idx < dhcp_num_south_intf; idx++, i++) {
+            snprintf(shm->intf[i].name, sizeof(shm->intf[i].name), "%s", dhcp_devman_get_agg_dev(idx)->intf);
+        }
+    } while (0);
+
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+/**
+ * @code dhcp_devman_shm_publish();
+ *
+ * @brief copies the snapshot counters and relay alarms of all interfaces to the shared memory segment in one
+ *        seqlock write
+ *
+ * @return none
+ */
+static void dhcp_devman_shm_publish()
+{
+    struct intf *int_ptr;
+    uint32_t i = 0;
+
+    if (shm == NULL) {
+        return;
+    }
+
+    shm->seq++;
+    __sync_synchronize();
+
+    LIST_FOREACH(int_ptr, &intfs, entry) {
+        memcpy(shm->intf[i].counters, int_ptr->dev_context->counters[DHCP_COUNTERS_SNAPSHOT],
+               sizeof(shm->intf[0].counters));
+        memcpy(shm->intf[i++].alarm, int_ptr->dev_context->alarm, sizeof(shm->intf[0].alarm));
+    }
+    for (uint32_t idx = 0; idx < dhcp_num_south_intf; idx++) {
+        memcpy(shm->intf[i].counters, dhcp_devman_get_agg_dev(idx)->counters[DHCP_COUNTERS_SNAPSHOT],
+               sizeof(shm->intf[0].counters));
+        memcpy(shm->intf[i].alarm, dhcp_devman_get_agg_dev(idx)->alarm, sizeof(shm->intf[0].alarm));
+        memcpy(shm->intf[i++].latency, dhcp_devman_get_agg_dev(idx)->latency[DHCP_COUNTERS_SNAPSHOT],
+               sizeof(shm->intf[0].latency));
+    }
+    shm->timestamp = time(NULL);
+
+    __sync_synchronize();
+    shm->seq++;
+}
+
+/**
+ * @code dhcp_devman_get_agg_dev(idx);
  *
  * Accessor method
  */
-dhcp_device_context_t* dhcp_devman_get_agg_dev()
+dhcp_device_context_t* dhcp_devman_get_agg_dev(uint32_t idx)
 {
-    return dhcp_device_get_aggregate_context();
+    return dhcp_device_get_aggregate_context(idx);
 }
 
 /**
@@ -63,8 +173,8 @@ dhcp_device_context_t* dhcp_devman_get_mgmt_dev()
 /**
  * @code dhcp_devman_init();
  *
- * initializes device (interface) manager that keeps track of interfaces and assert that there is one south
- * interface and as many north interfaces
+ * initializes device (interface) manager that keeps track of interfaces and assert that there are south
+ * interfaces and as many north interfaces
  */
 void dhcp_devman_init()
 {
@@ -81,6 +191,12 @@ void dhcp_devman_shutdown()
 {
     struct intf *int_ptr, *prev_intf = NULL;
 
+    if (shm != NULL) {
+        munmap(shm, shm_sz);
+        shm_unlink(shm_name);
+        shm = NULL;
+    }
+
     LIST_FOREACH(int_ptr, &intfs, entry) {
         dhcp_device_shutdown(int_ptr->dev_context);
         if (prev_intf) {
@@ -117,7 +233,9 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
             break;
         case 'd':
             dhcp_num_south_intf++;
-            assert(dhcp_num_south_intf <= 1);
+            if (south_intf_name == NULL) {
+                south_intf_name = name;
+            }
             break;
         case 'm':
             dhcp_num_mgmt_intf++;
@@ -130,13 +248,10 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
 
         rv = dhcp_device_init(&dev->dev_context, dev->name, dev->is_uplink);
         if (rv == 0 && intf_type == 'd') {
-            rv = dhcp_device_get_ip(dev->dev_context, &vlan_ip);
+            char agg_name[IF_NAMESIZE];
 
-            dhcp_device_context_t *agg_dev = dhcp_device_get_aggregate_context();
-
-            strncpy(agg_dev->intf, AGG_DEV_PREFIX, sizeof(AGG_DEV_PREFIX));
-            strncpy(agg_dev->intf + sizeof(AGG_DEV_PREFIX) - 1, name, sizeof(agg_dev->intf) - sizeof(AGG_DEV_PREFIX));
-            agg_dev->intf[sizeof(agg_dev->intf) - 1] = '\0';
+            snprintf(agg_name, sizeof(agg_name), "%s%s", AGG_DEV_PREFIX, name);
+            rv = dhcp_device_init_aggregate(dev->dev_context, agg_name);
         }
 
         LIST_INSERT_HEAD(&intfs, dev, entry);
@@ -149,18 +264,24 @@ int dhcp_devman_add_intf(const char *name, char intf_type)
 }
 
 /**
- * @code dhcp_devman_start_capture(snaplen, base);
+ * @code dhcp_devman_start_capture(snaplen, ring_blocks, shared_sock, ebpf_counters, base);
  *
  * @brief start packet capture on the devman interface list
  */
-int dhcp_devman_start_capture(size_t snaplen, struct event_base *base)
+int dhcp_devman_start_capture(size_t snaplen,
+                              uint32_t ring_blocks,
+                              uint8_t shared_sock,
+                              uint8_t ebpf_counters,
+                              struct event_base *base)
 {
     int rv = -1;
     struct intf *int_ptr;
 
-    if ((dhcp_num_south_intf == 1) && (dhcp_num_north_intf >= 1)) {
+    if ((dhcp_num_south_intf >= 1) && (dhcp_num_north_intf >= 1)) {
         LIST_FOREACH(int_ptr, &intfs, entry) {
-            rv = dhcp_device_start_capture(int_ptr->dev_context, snaplen, base, vlan_ip);
+            rv = shared_sock ? dhcp_device_add_shared_capture(int_ptr->dev_context) :
+                               dhcp_device_start_capture(int_ptr->dev_context, snaplen, ring_blocks,
+                                                         ebpf_counters, base);
             if (rv == 0) {
                 syslog(LOG_INFO,
                        "Capturing DHCP packets on interface %s, ip: 0x%08x, mac [%02x:%02x:%02x:%02x:%02x:%02x] \n",
@@ -172,6 +293,14 @@ int dhcp_devman_start_capture(size_t snaplen, struct event_base *base)
                 break;
             }
         }
+
+        if ((rv == 0) && shared_sock) {
+            rv = dhcp_device_start_shared_capture(snaplen, ring_blocks, base);
+        }
+
+        if (rv == 0) {
+            dhcp_devman_shm_init();
+        }
     }
     else {
         syslog(LOG_ERR, "Invalid number of interfaces, downlink/south %d, uplink/north %d\n",
@@ -191,6 +320,32 @@ dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_devic
     return dhcp_device_get_status(check_type, context);
 }
 
+/**
+ * @code dhcp_devman_get_msg_status(check_type, context, type);
+ *
+ * @brief collects DHCP relay status info of one message type.
+ */
+dhcp_mon_status_t dhcp_devman_get_msg_status(dhcp_mon_check_t check_type,
+                                             dhcp_device_context_t *context,
+                                             dhcp_message_type_t type)
+{
+    return dhcp_device_get_msg_status(check_type, context, type);
+}
+
+/**
+ * @code dhcp_devman_sync_counters();
+ *
+ * @brief collects the DHCP messages counted by eBPF on all interfaces
+ */
+void dhcp_devman_sync_counters()
+{
+    struct intf *int_ptr;
+
+    LIST_FOREACH(int_ptr, &intfs, entry) {
+        dhcp_device_sync_counters(int_ptr->dev_context);
+    }
+}
+
 /**
  * @code dhcp_devman_update_snapshot(context);
  *
@@ -205,7 +360,11 @@ void dhcp_devman_update_snapshot(dhcp_device_context_t *context)
             dhcp_device_update_snapshot(int_ptr->dev_context);
         }
 
-        dhcp_device_update_snapshot(dhcp_devman_get_agg_dev());
+        for (uint32_t idx = 0; idx < dhcp_num_south_intf; idx++) {
+            dhcp_device_update_snapshot(dhcp_devman_get_agg_dev(idx));
+        }
+
+        dhcp_devman_shm_publish();
     } else {
         dhcp_device_update_snapshot(context);
     }
@@ -225,7 +384,9 @@ void dhcp_devman_print_status(dhcp_device_context_t *context, dhcp_counters_type
             dhcp_device_print_status(int_ptr->dev_context, type);
         }
 
-        dhcp_device_print_status(dhcp_devman_get_agg_dev(), type);
+        for (uint32_t idx = 0; idx < dhcp_num_south_intf; idx++) {
+            dhcp_device_print_status(dhcp_devman_get_agg_dev(idx), type);
+        }
     } else {
         dhcp_device_print_status(context, type);
     }
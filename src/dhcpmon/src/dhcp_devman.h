@@ -11,11 +11,45 @@
 
 #include "dhcp_device.h"
 
+/** Prefix of the shared memory segment counters are published to, followed by the first downlink interface name */
+#define DHCP_SHM_PREFIX     "/dhcpmon-"
+/** Magic number of the shared memory segment */
+#define DHCP_SHM_MAGIC      0x44484d31
+/** Layout version of the shared memory segment */
+#define DHCP_SHM_VERSION    3
+/** Prefix of the aggregate device name, followed by the downlink (vlan) interface name */
+#define AGG_DEV_PREFIX      "Agg-"
+
+/** Counters of one interface in the shared memory segment */
+typedef struct
+{
+    char name[IF_NAMESIZE];         /** interface name, "Agg-" prefixed for the aggregate device */
+    uint8_t is_uplink;              /** north interface? */
+    uint64_t counters[DHCP_DIR_COUNT][DHCP_MESSAGE_TYPE_COUNT];
+                                    /** snapshot counters of DHCP packets */
+    uint64_t latency[DHCP_RELAY_LEG_COUNT][DHCP_LATENCY_BUCKETS];
+                                    /** relay latency histograms of the last window, aggregate devices only */
+    dhcp_alarm_t alarm[DHCP_MESSAGE_TYPE_COUNT];
+                                    /** relay alarms by message type, aggregate and mgmt devices only */
+} dhcp_shm_intf_t;
+
+/** Shared memory segment holding the counter snapshots of the last window. Readers copy the segment and retry
+ *  while seq is odd or has changed during the copy */
+typedef struct
+{
+    uint32_t magic;                 /** DHCP_SHM_MAGIC */
+    uint32_t version;               /** DHCP_SHM_VERSION */
+    volatile uint32_t seq;          /** sequence number, odd while the snapshot is being written */
+    uint32_t intf_count;            /** number of entries in intf */
+    uint64_t timestamp;             /** time of the snapshot, seconds since the epoch */
+    dhcp_shm_intf_t intf[];         /** interfaces, the aggregate devices (one per vlan) last */
+} dhcp_shm_t;
+
 /**
  * @code dhcp_devman_init();
  *
- * @brief initializes device (interface) manager that keeps track of interfaces and assert that there is one south
- *        interface and as many north interfaces
+ * @brief initializes device (interface) manager that keeps track of interfaces and assert that there are south
+ *        (vlan) interfaces and as many north interfaces
  *
  * @return none
  */
@@ -32,13 +66,15 @@ void dhcp_devman_init();
 void dhcp_devman_shutdown();
 
 /**
- * @code dhcp_devman_get_vlan_intf();
+ * @code dhcp_devman_get_agg_dev(idx);
  *
  * @brief Accessor method
  *
- * @return pointer to aggregate device (interface) context
+ * @param idx               index of the vlan
+ *
+ * @return pointer to aggregate device (interface) context of the vlan, NULL past the last vlan
  */
-dhcp_device_context_t* dhcp_devman_get_agg_dev();
+dhcp_device_context_t* dhcp_devman_get_agg_dev(uint32_t idx);
 
 /**
  * @code dhcp_devman_get_mgmt_intf_context();
@@ -56,7 +92,7 @@ dhcp_device_context_t* dhcp_devman_get_mgmt_dev();
  *
  * @param name              interface name
  * @param intf_type         'u' for uplink (north) interface
- *                          'd' for downlink (south) interface
+ *                          'd' for downlink (south) interface, one per monitored vlan
  *                          'm' for mgmt interface
  *
  * @return 0 on success, nonzero otherwise
@@ -64,16 +100,23 @@ dhcp_device_context_t* dhcp_devman_get_mgmt_dev();
 int dhcp_devman_add_intf(const char *name, char intf_type);
 
 /**
- * @code dhcp_devman_start_capture(snaplen, base);
+ * @code dhcp_devman_start_capture(snaplen, ring_blocks, shared_sock, ebpf_counters, base);
  *
  * @brief start packet capture on the devman interface list
  *
  * @param snaplen packet    packet capture snap length
+ * @param ring_blocks       receive ring blocks per interface, 0 to capture with recv()
+ * @param shared_sock       capture all interfaces on one socket and demultiplex by ifindex
+ * @param ebpf_counters     count DHCP messages in the kernel, not used with shared_sock
  * @param base              libevent base
  *
  * @return 0 on success, nonzero otherwise
  */
-int dhcp_devman_start_capture(size_t snaplen, struct event_base *base);
+int dhcp_devman_start_capture(size_t snaplen,
+                              uint32_t ring_blocks,
+                              uint8_t shared_sock,
+                              uint8_t ebpf_counters,
+                              struct event_base *base);
 
 /**
  * @code dhcp_devman_get_status(check_type, context);
@@ -87,12 +130,37 @@ int dhcp_devman_start_capture(size_t snaplen, struct event_base *base);
  */
 dhcp_mon_status_t dhcp_devman_get_status(dhcp_mon_check_t check_type, dhcp_device_context_t *context);
 
+/**
+ * @code dhcp_devman_get_msg_status(check_type, context, type);
+ *
+ * @brief collects DHCP relay status info of one message type.
+ *
+ * @param check_type        Type of validation
+ * @param context           pointer to device (interface) context
+ * @param type              DHCP message type
+ *
+ * @return DHCP_MON_STATUS_HEALTHY, DHCP_MON_STATUS_UNHEALTHY, or DHCP_MON_STATUS_INDETERMINATE
+ */
+dhcp_mon_status_t dhcp_devman_get_msg_status(dhcp_mon_check_t check_type,
+                                             dhcp_device_context_t *context,
+                                             dhcp_message_type_t type);
+
+/**
+ * @code dhcp_devman_sync_counters();
+ *
+ * @brief collects the DHCP messages counted by eBPF on all interfaces
+ *
+ * @return none
+ */
+void dhcp_devman_sync_counters();
+
 /**
  * @code dhcp_devman_update_snapshot(context);
  *
  * @param context           Device (interface) context
  *
- * @brief Update device/interface counters snapshot
+ * @brief Update device/interface counters snapshot. When context is null, the snapshots of all interfaces are
+ *        also published to the shared memory segment
  */
 void dhcp_devman_update_snapshot(dhcp_device_context_t *context);
 
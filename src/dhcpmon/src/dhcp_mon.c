@@ -6,8 +6,11 @@
 
 #include <signal.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/syscall.h>
 #include <syslog.h>
@@ -16,19 +19,50 @@
 #include "dhcp_mon.h"
 #include "dhcp_devman.h"
 
+/** Alarm thresholds of one DHCP message type, counted in health checks */
+typedef struct
+{
+    int warning;                                /** unhealthy checks before a warning, 0 to never warn */
+    int critical;                               /** unhealthy checks before a critical alarm, 0 to never raise it */
+    int clear;                                  /** healthy checks before a raised alarm is cleared */
+} dhcp_mon_threshold_t;
+
+/** Alarm threshold given on the command line */
+typedef struct
+{
+    char intf[IF_NAMESIZE];                     /** vlan or mgmt interface, empty for all of them */
+    int type;                                   /** DHCP message type, 0 for all monitored types */
+    dhcp_mon_threshold_t threshold;             /** thresholds */
+} dhcp_mon_threshold_spec_t;
+
+/** Alarm state of one DHCP message type, the published part is in the alarm of the device context */
+typedef struct
+{
+    dhcp_mon_threshold_t threshold;             /** thresholds, all 0 when the message type is not checked */
+    int healthy_count;                          /** count of consecutive healthy checks while raised */
+    time_t logged;                              /** time the alarm was last written to syslog */
+} dhcp_mon_alarm_state_t;
+
 /** DHCP device/interface state */
 typedef struct
 {
     dhcp_mon_check_t check_type;                /** check type */
-    dhcp_device_context_t* (*get_context)();    /** functor to a device context accessor function */
-    int count;                                  /** count in the number of unhealthy checks */
+    dhcp_device_context_t *context;             /** checked device context */
     const char *msg;                            /** message to be printed if unhealthy state is determined */
+    dhcp_mon_alarm_state_t alarm[DHCP_MESSAGE_TYPE_COUNT];
+                                                /** alarm state by message type */
 } dhcp_mon_state_t;
 
 /** window_interval_sec monitoring window for dhcp relay health checks */
 static int window_interval_sec = 18;
 /** dhcp_unhealthy_max_count max count of consecutive unhealthy statuses before reporting to syslog */
 static int dhcp_unhealthy_max_count = 10;
+/** alarm_log_interval_sec interval at which a raised alarm is written to syslog again */
+static int alarm_log_interval_sec = 300;
+/** alarm_clear_count default count of consecutive healthy checks before a raised alarm is cleared */
+static const int alarm_clear_count = 3;
+/** alarm_critical_factor default critical threshold as a multiple of the warning threshold */
+static const int alarm_critical_factor = 3;
 /** libevent base struct */
 static struct event_base *base;
 /** libevent timeout event struct */
@@ -40,23 +74,185 @@ static struct event *ev_sigterm;
 /** libevent SIGUSR1 signal event struct */
 static struct event *ev_sigusr1;
 
-/** DHCP monitor state data for aggregate device for mgmt device */
-static dhcp_mon_state_t state_data[] = {
-    [0] = {
-        .check_type = DHCP_MON_CHECK_POSITIVE,
-        .get_context = dhcp_devman_get_agg_dev,
-        .count = 0,
-        .msg = "dhcpmon detected disparity in DHCP Relay behavior. Duration: %d (sec) for vlan: '%s'\n"
-    },
-    [1] = {
-        .check_type = DHCP_MON_CHECK_NEGATIVE,
-        .get_context = dhcp_devman_get_mgmt_dev,
-        .count = 0,
-        .msg = "dhcpmon detected DHCP packets traveling through mgmt interface (please check BGP routes.)"
-               " Duration: %d (sec) for intf: '%s'\n"
-    }
+/** DHCP monitor state data for the aggregate device of each vlan and for mgmt device */
+static dhcp_mon_state_t *state_data = NULL;
+/** Number of DHCP monitor state data */
+static uint32_t state_data_nr = 0;
+
+/** Alarm thresholds given on the command line */
+static dhcp_mon_threshold_spec_t *threshold_specs = NULL;
+/** Number of alarm thresholds given on the command line */
+static uint32_t threshold_spec_nr = 0;
+
+/** Names of the DHCP message types, as given in alarm thresholds */
+static const char *msg_names[DHCP_MESSAGE_TYPE_COUNT] = {
+    [DHCP_MESSAGE_TYPE_DISCOVER] = "discover",
+    [DHCP_MESSAGE_TYPE_OFFER] = "offer",
+    [DHCP_MESSAGE_TYPE_REQUEST] = "request",
+    [DHCP_MESSAGE_TYPE_DECLINE] = "decline",
+    [DHCP_MESSAGE_TYPE_ACK] = "ack",
+    [DHCP_MESSAGE_TYPE_NAK] = "nak",
+    [DHCP_MESSAGE_TYPE_RELEASE] = "release",
+    [DHCP_MESSAGE_TYPE_INFORM] = "inform",
+    [DHCPV6_MESSAGE_TYPE_SOLICIT] = "solicit",
+    [DHCPV6_MESSAGE_TYPE_ADVERTISE] = "advertise",
+    [DHCPV6_MESSAGE_TYPE_REQUEST] = "request6",
+    [DHCPV6_MESSAGE_TYPE_REPLY] = "reply",
+    [DHCPV6_MESSAGE_TYPE_RELAY_FORW] = "relay-forw",
+    [DHCPV6_MESSAGE_TYPE_RELAY_REPL] = "relay-repl"
+};
+
+/** DHCP message types checked unless thresholds are given for other types */
+static const dhcp_message_type_t default_msgs[] = {
+    DHCP_MESSAGE_TYPE_DISCOVER,
+    DHCP_MESSAGE_TYPE_OFFER,
+    DHCP_MESSAGE_TYPE_REQUEST,
+    DHCP_MESSAGE_TYPE_ACK,
+    DHCPV6_MESSAGE_TYPE_SOLICIT,
+    DHCPV6_MESSAGE_TYPE_ADVERTISE,
+    DHCPV6_MESSAGE_TYPE_REQUEST,
+    DHCPV6_MESSAGE_TYPE_REPLY
+};
+
+/** Names of the alarm levels */
+static const char *alarm_names[DHCP_ALARM_COUNT] = {
+    [DHCP_ALARM_CLEAR] = "Cleared",
+    [DHCP_ALARM_WARNING] = "Warning",
+    [DHCP_ALARM_CRITICAL] = "Critical"
+};
+
+/** syslog priority of the alarm levels */
+static const int alarm_priorities[DHCP_ALARM_COUNT] = {
+    [DHCP_ALARM_CLEAR] = LOG_NOTICE,
+    [DHCP_ALARM_WARNING] = LOG_WARNING,
+    [DHCP_ALARM_CRITICAL] = LOG_ALERT
 };
 
+/**
+ * @code is_threshold_spec_of(spec, context);
+ *
+ * @brief checks if an alarm threshold given on the command line names a device. An aggregate device is named by its
+ *        vlan interface.
+ *
+ * @param spec      alarm threshold
+ * @param context   checked device context
+ *
+ * @return true if the threshold names the device, false otherwise
+ */
+static bool is_threshold_spec_of(const dhcp_mon_threshold_spec_t *spec, const dhcp_device_context_t *context)
+{
+    const char *intf = context->intf;
+
+    if ((context->agg_dev == context) && (strncmp(intf, AGG_DEV_PREFIX, strlen(AGG_DEV_PREFIX)) == 0)) {
+        intf += strlen(AGG_DEV_PREFIX);
+    }
+
+    return (strcmp(spec->intf, intf) == 0) || (strcmp(spec->intf, context->intf) == 0);
+}
+
+/**
+ * @code init_thresholds(state);
+ *
+ * @brief sets the alarm thresholds of a device, the defaults first, then the thresholds of all devices given on the
+ *        command line and last the thresholds given for the device
+ *
+ * @param state     health check state of the device
+ *
+ * @return none
+ */
+static void init_thresholds(dhcp_mon_state_t *state)
+{
+    for (uint32_t i = 0; i < sizeof(default_msgs) / sizeof(*default_msgs); i++) {
+        dhcp_mon_threshold_t *threshold = &state->alarm[default_msgs[i]].threshold;
+
+        threshold->warning = dhcp_unhealthy_max_count;
+        threshold->critical = dhcp_unhealthy_max_count * alarm_critical_factor;
+        threshold->clear = alarm_clear_count;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < threshold_spec_nr; i++) {
+            const dhcp_mon_threshold_spec_t *spec = &threshold_specs[i];
+
+            if ((pass == 0) ? (spec->intf[0] != '\0') : !is_threshold_spec_of(spec, state->context)) {
+                continue;
+            }
+
+            if (spec->type != 0) {
+                state->alarm[spec->type].threshold = spec->threshold;
+            } else {
+                for (uint32_t j = 0; j < sizeof(default_msgs) / sizeof(*default_msgs); j++) {
+                    state->alarm[default_msgs[j]].threshold = spec->threshold;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @code init_state_data();
+ *
+ * @brief creates the health check state of every aggregate device and of the mgmt device
+ *
+ * @return 0 upon success, otherwise upon failure
+ */
+static int init_state_data()
+{
+    uint32_t agg_dev_nr = 0;
+
+    while (dhcp_devman_get_agg_dev(agg_dev_nr) != NULL) {
+        agg_dev_nr++;
+    }
+
+    state_data = (dhcp_mon_state_t *) calloc(agg_dev_nr + 1, sizeof(dhcp_mon_state_t));
+    if (state_data == NULL) {
+        syslog(LOG_ERR, "Could not allocate memory for health check state!\n");
+        return -1;
+    }
+
+    for (state_data_nr = 0; state_data_nr < agg_dev_nr; state_data_nr++) {
+        state_data[state_data_nr].check_type = DHCP_MON_CHECK_POSITIVE;
+        state_data[state_data_nr].context = dhcp_devman_get_agg_dev(state_data_nr);
+        state_data[state_data_nr].msg =
+            "dhcpmon detected disparity in DHCP Relay behavior. Duration: %d (sec) for vlan: '%s'\n";
+        init_thresholds(&state_data[state_data_nr]);
+    }
+
+    state_data[state_data_nr].check_type = DHCP_MON_CHECK_NEGATIVE;
+    state_data[state_data_nr].context = dhcp_devman_get_mgmt_dev();
+    state_data[state_data_nr].msg =
+        "dhcpmon detected DHCP packets traveling through mgmt interface (please check BGP routes.)"
+        " Duration: %d (sec) for intf: '%s'\n";
+    init_thresholds(&state_data[state_data_nr]);
+    state_data_nr++;
+
+    return 0;
+}
+
+/**
+ * @code print_alarms();
+ *
+ * @brief prints the raised alarms to syslog
+ *
+ * @return none
+ */
+static void print_alarms()
+{
+    for (uint32_t i = 0; i < state_data_nr; i++) {
+        dhcp_device_context_t *context = state_data[i].context;
+
+        for (uint32_t type = DHCP_MESSAGE_TYPE_DISCOVER; type < DHCP_MESSAGE_TYPE_COUNT; type++) {
+            dhcp_alarm_t *alarm = &context->alarm[type];
+
+            if (alarm->level != DHCP_ALARM_CLEAR) {
+                syslog(LOG_NOTICE, "[%*s] %s alarm of %s messages since %lu, unhealthy checks: %u\n",
+                       IF_NAMESIZE, context->intf, alarm_names[alarm->level], msg_names[type],
+                       (unsigned long) alarm->since, alarm->count);
+            }
+        }
+    }
+}
+
 /**
  * @code signal_callback(fd, event, arg);
  *
@@ -71,16 +267,89 @@ static dhcp_mon_state_t state_data[] = {
 static void signal_callback(evutil_socket_t fd, short event, void *arg)
 {
     syslog(LOG_ALERT, "Received signal: '%s'\n", strsignal(fd));
+    dhcp_devman_sync_counters();
     dhcp_devman_print_status(NULL, DHCP_COUNTERS_CURRENT);
+    print_alarms();
     if ((fd == SIGTERM) || (fd == SIGINT)) {
         dhcp_mon_stop();
     }
 }
 
+/**
+ * @code raise_alarm(state, type, now);
+ *
+ * @brief raises the alarm of a message type to the level its thresholds give for the count of unhealthy checks. A
+ *        raised alarm is written to syslog when its level rises and again every alarm_log_interval_sec, the device
+ *        message itself is written once per check by the caller.
+ *
+ * @param state     health check state of the device
+ * @param type      DHCP message type
+ * @param now       time of the check
+ *
+ * @return true if the alarm was written to syslog, false otherwise
+ */
+static bool raise_alarm(dhcp_mon_state_t *state, dhcp_message_type_t type, time_t now)
+{
+    dhcp_mon_alarm_state_t *alarm_state = &state->alarm[type];
+    dhcp_alarm_t *alarm = &state->context->alarm[type];
+    dhcp_alarm_level_t level = DHCP_ALARM_CLEAR;
+    bool raised = false;
+    bool logged = false;
+
+    if ((alarm_state->threshold.critical > 0) && (alarm->count > alarm_state->threshold.critical)) {
+        level = DHCP_ALARM_CRITICAL;
+    } else if ((alarm_state->threshold.warning > 0) && (alarm->count > alarm_state->threshold.warning)) {
+        level = DHCP_ALARM_WARNING;
+    }
+
+    if (level > alarm->level) {
+        alarm->level = level;
+        alarm->since = now;
+        raised = true;
+    }
+
+    if ((alarm->level != DHCP_ALARM_CLEAR) &&
+        (raised || (now - alarm_state->logged >= alarm_log_interval_sec))) {
+        syslog(alarm_priorities[alarm->level], "%s alarm of %s messages for '%s', unhealthy checks: %u\n",
+               alarm_names[alarm->level], msg_names[type], state->context->intf, alarm->count);
+        alarm_state->logged = now;
+        logged = true;
+    }
+
+    return logged;
+}
+
+/**
+ * @code clear_alarm(state, type, now);
+ *
+ * @brief clears a raised alarm of a message type after its clear threshold of consecutive healthy checks
+ *
+ * @param state     health check state of the device
+ * @param type      DHCP message type
+ * @param now       time of the check
+ *
+ * @return none
+ */
+static void clear_alarm(dhcp_mon_state_t *state, dhcp_message_type_t type, time_t now)
+{
+    dhcp_mon_alarm_state_t *alarm_state = &state->alarm[type];
+    dhcp_alarm_t *alarm = &state->context->alarm[type];
+
+    if ((alarm->level != DHCP_ALARM_CLEAR) && (++alarm_state->healthy_count >= alarm_state->threshold.clear)) {
+        syslog(alarm_priorities[DHCP_ALARM_CLEAR], "%s: %s alarm of %s messages for '%s' after %lu (sec)\n",
+               alarm_names[DHCP_ALARM_CLEAR], alarm_names[alarm->level], msg_names[type], state->context->intf,
+               (unsigned long) (now - alarm->since));
+        alarm->level = DHCP_ALARM_CLEAR;
+        alarm->since = now;
+        alarm_state->healthy_count = 0;
+    }
+}
+
 /**
  * @code check_dhcp_relay_health(state_data);
  *
- * @brief check DHCP relay overall health
+ * @brief check DHCP relay health of every message type with alarm thresholds. The device message and the counters
+ *        are written to syslog with the alarms, at most once per check.
  *
  * @param state_data        pointer to dhcpmon state data
  *
@@ -88,29 +357,48 @@ static void signal_callback(evutil_socket_t fd, short event, void *arg)
  */
 static void check_dhcp_relay_health(dhcp_mon_state_t *state_data)
 {
-    dhcp_device_context_t *context = state_data->get_context();
-    dhcp_mon_status_t dhcp_mon_status = dhcp_devman_get_status(state_data->check_type, context);
+    dhcp_device_context_t *context = state_data->context;
+    time_t now = time(NULL);
+    uint32_t logged_count = 0;
 
-    switch (dhcp_mon_status)
-    {
-    case DHCP_MON_STATUS_UNHEALTHY:
-        if (++state_data->count > dhcp_unhealthy_max_count) {
-            syslog(LOG_ALERT, state_data->msg, state_data->count * window_interval_sec, context->intf);
-            dhcp_devman_print_status(context, DHCP_COUNTERS_SNAPSHOT);
-            dhcp_devman_print_status(context, DHCP_COUNTERS_CURRENT);
+    for (uint32_t type = 0; type < DHCP_MESSAGE_TYPE_COUNT; type++) {
+        dhcp_mon_alarm_state_t *alarm_state = &state_data->alarm[type];
+        dhcp_alarm_t *alarm = &context->alarm[type];
+
+        if ((alarm_state->threshold.warning == 0) && (alarm_state->threshold.critical == 0)) {
+            continue;
         }
-        break;
-    case DHCP_MON_STATUS_HEALTHY:
-        state_data->count = 0;
-        break;
-    case DHCP_MON_STATUS_INDETERMINATE:
-        if (state_data->count) {
-            state_data->count++;
+
+        dhcp_mon_status_t dhcp_mon_status = dhcp_devman_get_msg_status(state_data->check_type, context, type);
+
+        switch (dhcp_mon_status)
+        {
+        case DHCP_MON_STATUS_UNHEALTHY:
+            alarm->count++;
+            alarm_state->healthy_count = 0;
+            if (raise_alarm(state_data, type, now) && (alarm->count > logged_count)) {
+                logged_count = alarm->count;
+            }
+            break;
+        case DHCP_MON_STATUS_HEALTHY:
+            alarm->count = 0;
+            clear_alarm(state_data, type, now);
+            break;
+        case DHCP_MON_STATUS_INDETERMINATE:
+            if (alarm->count) {
+                alarm->count++;
+            }
+            break;
+        default:
+            syslog(LOG_ERR, "DHCP Relay returned unknown status %d\n", dhcp_mon_status);
+            break;
         }
-        break;
-    default:
-        syslog(LOG_ERR, "DHCP Relay returned unknown status %d\n", dhcp_mon_status);
-        break;
+    }
+
+    if (logged_count) {
+        syslog(LOG_ALERT, state_data->msg, (int) logged_count * window_interval_sec, context->intf);
+        dhcp_devman_print_status(context, DHCP_COUNTERS_SNAPSHOT);
+        dhcp_devman_print_status(context, DHCP_COUNTERS_CURRENT);
     }
 }
 
@@ -127,7 +415,9 @@ static void check_dhcp_relay_health(dhcp_mon_state_t *state_data)
  */
 static void timeout_callback(evutil_socket_t fd, short event, void *arg)
 {
-    for (uint8_t i = 0; i < sizeof(state_data) / sizeof(*state_data); i++) {
+    dhcp_devman_sync_counters();
+
+    for (uint32_t i = 0; i < state_data_nr; i++) {
         check_dhcp_relay_health(&state_data[i]);
     }
 
@@ -135,19 +425,84 @@ static void timeout_callback(evutil_socket_t fd, short event, void *arg)
 }
 
 /**
- * @code dhcp_mon_init(window_sec, max_count);
+ * @code dhcp_mon_add_threshold(spec);
+ *
+ * @brief adds alarm thresholds given as [<intf>:]<msg>=<warning>,<critical>[,<clear>]
+ */
+int dhcp_mon_add_threshold(const char *spec)
+{
+    dhcp_mon_threshold_spec_t threshold_spec = {.threshold = {.clear = alarm_clear_count}};
+    char msg[16];
+    const char *sep = strchr(spec, ':');
+    const char *eq = strchr(spec, '=');
+    int rv = -1;
+
+    do {
+        if ((eq == NULL) || ((sep != NULL) && (sep > eq))) {
+            break;
+        }
+
+        if (sep != NULL) {
+            if ((sep == spec) || (sep - spec >= (int) sizeof(threshold_spec.intf))) {
+                break;
+            }
+            memcpy(threshold_spec.intf, spec, sep - spec);
+            spec = sep + 1;
+        }
+
+        if ((eq - spec == 0) || (eq - spec >= (int) sizeof(msg))) {
+            break;
+        }
+        memcpy(msg, spec, eq - spec);
+        msg[eq - spec] = '\0';
+
+        if (strcmp(msg, "all") != 0) {
+            for (threshold_spec.type = 1; threshold_spec.type < DHCP_MESSAGE_TYPE_COUNT; threshold_spec.type++) {
+                if (strcmp(msg, msg_names[threshold_spec.type]) == 0) {
+                    break;
+                }
+            }
+            if (threshold_spec.type == DHCP_MESSAGE_TYPE_COUNT) {
+                break;
+            }
+        }
+
+        dhcp_mon_threshold_t *threshold = &threshold_spec.threshold;
+        int n = sscanf(eq + 1, "%d,%d,%d", &threshold->warning, &threshold->critical, &threshold->clear);
+        if ((n < 2) || (threshold->warning < 0) || (threshold->critical < 0) || (threshold->clear < 1) ||
+            ((threshold->warning > 0) && (threshold->critical > 0) && (threshold->critical <= threshold->warning))) {
+            break;
+        }
+
+        dhcp_mon_threshold_spec_t *specs = realloc(threshold_specs, (threshold_spec_nr + 1) * sizeof(*specs));
+        if (specs == NULL) {
+            syslog(LOG_ERR, "realloc: failed to allocate memory for alarm threshold\n");
+            break;
+        }
+        threshold_specs = specs;
+        threshold_specs[threshold_spec_nr++] = threshold_spec;
+
+        rv = 0;
+    } while (0);
+
+    return rv;
+}
+
+/**
+ * @code dhcp_mon_init(window_sec, max_count, log_interval_sec);
  *
  * initializes event base and periodic timer event that continuously collects dhcp relay health status every window_sec
- * seconds. It also writes to syslog when dhcp relay has been unhealthy for consecutive max_count checks.
+ * seconds. It also raises alarms when dhcp relay has been unhealthy for consecutive checks past their thresholds.
  *
  */
-int dhcp_mon_init(int window_sec, int max_count)
+int dhcp_mon_init(int window_sec, int max_count, int log_interval_sec)
 {
     int rv = -1;
 
     do {
         window_interval_sec = window_sec;
         dhcp_unhealthy_max_count = max_count;
+        alarm_log_interval_sec = log_interval_sec;
 
         base = event_base_new();
         if (base == NULL) {
@@ -203,20 +558,32 @@ void dhcp_mon_shutdown()
     event_free(ev_sigusr1);
 
     event_base_free(base);
+
+    free(state_data);
+    state_data = NULL;
+    state_data_nr = 0;
+
+    free(threshold_specs);
+    threshold_specs = NULL;
+    threshold_spec_nr = 0;
 }
 
 /**
- * @code dhcp_mon_start(snaplen);
+ * @code dhcp_mon_start(snaplen, ring_blocks, shared_sock, ebpf_counters);
  *
  * @brief start monitoring DHCP Relay
  */
-int dhcp_mon_start(size_t snaplen)
+int dhcp_mon_start(size_t snaplen, uint32_t ring_blocks, uint8_t shared_sock, uint8_t ebpf_counters)
 {
     int rv = -1;
 
     do
     {
-        if (dhcp_devman_start_capture(snaplen, base) != 0) {
+        if (dhcp_devman_start_capture(snaplen, ring_blocks, shared_sock, ebpf_counters, base) != 0) {
+            break;
+        }
+
+        if (init_state_data() != 0) {
             break;
         }
 
@@ -8,19 +8,38 @@
 #ifndef DHCP_MON_H_
 #define DHCP_MON_H_
 
+#include <stdint.h>
+
+/**
+ * @code dhcp_mon_add_threshold(spec);
+ *
+ * @brief adds alarm thresholds of a DHCP message type, as [<intf>:]<msg>=<warning>,<critical>[,<clear>]. intf is a
+ *        vlan or the mgmt interface, all of them when it is left out. msg is a message type name such as discover
+ *        or solicit, or all for the monitored types. warning and critical are the counts of consecutive unhealthy
+ *        checks raising the alarm levels, 0 to skip a level, and clear the count of consecutive healthy checks
+ *        clearing it. Thresholds of an interface take precedence over those of all interfaces.
+ *
+ * @param spec alarm thresholds
+ *
+ * @return 0 upon success, otherwise upon failure
+ */
+int dhcp_mon_add_threshold(const char *spec);
+
 /**
- * @code dhcp_mon_init(window_ssec, max_count);
+ * @code dhcp_mon_init(window_sec, max_count, log_interval_sec);
  *
  * @brief initializes event base and periodic timer event that continuously collects dhcp relay health status every
- *        window_sec seconds. It also writes to syslog when dhcp relay has been unhealthy for consecutive max_count
- *        checks.
+ *        window_sec seconds. It also raises an alarm per vlan and message type when dhcp relay has been unhealthy
+ *        for consecutive checks past its thresholds, and writes it to syslog when its level rises and every
+ *        log_interval_sec while it is raised.
  *
  * @param window_sec time interval between health checks
- * @param max_count max count of consecutive unhealthy statuses before reporting to syslog
+ * @param max_count default warning threshold of consecutive unhealthy statuses, critical at three times as many
+ * @param log_interval_sec time interval between syslog messages of a raised alarm
  *
  * @return 0 upon success, otherwise upon failure
  */
-int dhcp_mon_init(int window_sec, int max_count);
+int dhcp_mon_init(int window_sec, int max_count, int log_interval_sec);
 
 /**
  * @code dhcp_mon_shutdown();
@@ -32,15 +51,18 @@ int dhcp_mon_init(int window_sec, int max_count);
 void dhcp_mon_shutdown();
 
 /**
- * @code dhcp_mon_start(snaplen);
+ * @code dhcp_mon_start(snaplen, ring_blocks, shared_sock, ebpf_counters);
  *
  * @brief start monitoring DHCP Relay
  *
  * @param snaplen       packet capture length
+ * @param ring_blocks   receive ring blocks per interface, 0 to capture with recv()
+ * @param shared_sock   capture all interfaces on one socket and demultiplex by ifindex
+ * @param ebpf_counters count DHCP messages in the kernel with an eBPF socket filter
  *
  * @return 0 upon success, otherwise upon failure
  */
-int dhcp_mon_start(size_t snaplen);
+int dhcp_mon_start(size_t snaplen, uint32_t ring_blocks, uint8_t shared_sock, uint8_t ebpf_counters);
 
 /**
  * @code dhcp_mon_stop();
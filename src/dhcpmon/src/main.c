@@ -28,6 +28,10 @@ static const uint32_t dhcpmon_default_health_check_window = 18;
 /** dhcpmon_default_unhealthy_max_count: default max consecutive unhealthy status reported before reporting an issue
  *  with DHCP relay */
 static const uint32_t dhcpmon_default_unhealthy_max_count = 10;
+/** dhcpmon_default_alarm_log_interval: default time interval between syslog messages of a raised alarm */
+static const uint32_t dhcpmon_default_alarm_log_interval = 300;
+/** dhcpmon_default_ring_blocks: default number of TPACKET_V3 receive ring blocks per interface */
+static const uint32_t dhcpmon_default_ring_blocks = 8;
 
 /**
  * @code usage(prog);
@@ -40,17 +44,28 @@ static const uint32_t dhcpmon_default_unhealthy_max_count = 10;
  */
 static void usage(const char *prog)
 {
-    printf("Usage: %s -id <south interface> {-iu <north interface>}+ -im <mgmt interface> [-w <snapshot window in sec>]"
-            "[-c <unhealthy status count>] [-s <snap length>] [-d]\n", prog);
+    printf("Usage: %s {-id <south interface>}+ {-iu <north interface>}+ -im <mgmt interface> [-w <snapshot window in sec>]"
+            "[-c <unhealthy status count>] {-t [<intf>:]<msg>=<warning>,<critical>[,<clear>]}* "
+            "[-l <alarm log interval in sec>] [-s <snap length>] [-r <ring blocks>] [-o] [-e] [-d]\n", prog);
     printf("where\n");
-    printf("\tsouth interface: is a vlan interface,\n");
+    printf("\tsouth interface: is a vlan interface, each one is checked on its own,\n");
     printf("\tnorth interface: is a TOR-T1 interface,\n");
     printf("\tsnapshot window: during which DHCP counters are gathered and DHCP status is validated (default %d),\n",
             dhcpmon_default_health_check_window);
-    printf("\tunhealthy status count: count of consecutive unhealthy status before writing an alert to syslog "
-           "(default %d),\n",
+    printf("\tunhealthy status count: count of consecutive unhealthy status before raising a warning, a critical "
+           "alarm is raised at three times as many (default %d),\n",
            dhcpmon_default_unhealthy_max_count);
+    printf("\t-t: alarm thresholds of a message type (discover, offer, request, ack, solicit, advertise, request6, "
+           "reply, ... or all) on a vlan or mgmt interface, or on all of them when intf is left out: counts of "
+           "consecutive unhealthy status raising a warning and a critical alarm, 0 to skip one, and of healthy status "
+           "clearing it (default 3),\n");
+    printf("\talarm log interval: time between syslog messages of a raised alarm (default %d),\n",
+           dhcpmon_default_alarm_log_interval);
     printf("\tsnap length: snap length of packet capture (default %ld),\n", dhcpmon_default_snaplen);
+    printf("\tring blocks: 64KB receive ring blocks per interface, 0 reads packets with recv() (default %d),\n",
+           dhcpmon_default_ring_blocks);
+    printf("\t-o: capture all interfaces on one socket,\n");
+    printf("\t-e: count DHCP messages in the kernel with eBPF, not used with -o,\n");
     printf("\t-d: daemonize %s.\n", prog);
 
     exit(EXIT_SUCCESS);
@@ -109,8 +124,12 @@ int main(int argc, char **argv)
     int i;
     int window_interval = dhcpmon_default_health_check_window;
     int max_unhealthy_count = dhcpmon_default_unhealthy_max_count;
+    int alarm_log_interval = dhcpmon_default_alarm_log_interval;
     size_t snaplen = dhcpmon_default_snaplen;
+    uint32_t ring_blocks = dhcpmon_default_ring_blocks;
     int make_daemon = 0;
+    uint8_t shared_sock = 0;
+    uint8_t ebpf_counters = 0;
 
     setlogmask(LOG_UPTO(LOG_INFO));
     openlog(basename(argv[0]), LOG_CONS | LOG_PID | LOG_NDELAY, LOG_DAEMON);
@@ -136,10 +155,22 @@ int main(int argc, char **argv)
             make_daemon = 1;
             i++;
             break;
+        case 'o':
+            shared_sock = 1;
+            i++;
+            break;
+        case 'e':
+            ebpf_counters = 1;
+            i++;
+            break;
         case 's':
             snaplen = atoi(argv[i + 1]);
             i += 2;
             break;
+        case 'r':
+            ring_blocks = atoi(argv[i + 1]);
+            i += 2;
+            break;
         case 'w':
             window_interval = atoi(argv[i + 1]);
             i += 2;
@@ -148,6 +179,17 @@ int main(int argc, char **argv)
             max_unhealthy_count = atoi(argv[i + 1]);
             i += 2;
             break;
+        case 't':
+            if ((argv[i + 1] == NULL) || (dhcp_mon_add_threshold(argv[i + 1]) != 0)) {
+                fprintf(stderr, "%s: %s: Invalid alarm threshold\n", basename(argv[0]), argv[i + 1]);
+                usage(basename(argv[0]));
+            }
+            i += 2;
+            break;
+        case 'l':
+            alarm_log_interval = atoi(argv[i + 1]);
+            i += 2;
+            break;
         default:
             fprintf(stderr, "%s: %c: Unknown option\n", basename(argv[0]), argv[i][1]);
             usage(basename(argv[0]));
@@ -158,8 +200,8 @@ int main(int argc, char **argv)
         dhcpmon_daemonize();
     }
 
-    if ((dhcp_mon_init(window_interval, max_unhealthy_count) == 0) &&
-        (dhcp_mon_start(snaplen) == 0)) {
+    if ((dhcp_mon_init(window_interval, max_unhealthy_count, alarm_log_interval) == 0) &&
+        (dhcp_mon_start(snaplen, ring_blocks, shared_sock, ebpf_counters) == 0)) {
 
         rv = EXIT_SUCCESS;
 
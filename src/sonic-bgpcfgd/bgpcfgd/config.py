@@ -6,6 +6,7 @@ class ConfigMgr(object):
         self.current_config_raw = None
         self.changes = ""
         self.peer_groups_to_restart = []
+        self.commit_failures = 0  # number of unsuccessful commits, never reset
 
     def reset(self):
         """ Reset stored config """
@@ -14,10 +15,15 @@ class ConfigMgr(object):
         self.changes = ""
         self.peer_groups_to_restart = []
 
-    def update(self):
-        """ Read current config from FRR """
-        self.current_config = None
-        self.current_config_raw = None
+    def update(self, force=False):
+        """
+        Read current config from FRR. The config is read once per commit cycle,
+        the following calls reuse it until self.commit() or self.invalidate()
+        :param force: read the config from FRR even if it was read in this cycle
+        """
+        if not force and self.current_config_raw is not None:
+            return
+        self.invalidate()
         out = self.frr.get_config()
         text = []
         for line in out.split('\n'):
@@ -28,6 +34,11 @@ class ConfigMgr(object):
         self.current_config_raw = text
         self.current_config = self.to_canonical(out)  # FIXME: use text as an input
 
+    def invalidate(self):
+        """ Drop the config read from FRR, the next self.update() reads it again """
+        self.current_config = None
+        self.current_config_raw = None
+
     def push_list(self, cmdlist):
         """
         Prepare new changes for FRR. The changes should be committed by self.commit()
@@ -56,10 +67,13 @@ class ConfigMgr(object):
         :return: True if change was applied successfully, False otherwise
         """
         if self.changes.strip() == "":
+            self.invalidate()  # FRR could be changed outside of bgpcfgd before the next cycle
             return True
         rc_write = self.frr.write(self.changes)
         rc_restart = self.frr.restart_peer_groups(self.peer_groups_to_restart)
         self.reset()
+        if not (rc_write and rc_restart):
+            self.commit_failures += 1
         return rc_write and rc_restart
 
     def get_text(self):
@@ -1,4 +1,4 @@
-from collections import defaultdict
+from collections import defaultdict, OrderedDict
 
 from .log import log_err
 
@@ -8,7 +8,8 @@ class Directory(object):
         as some value is changed. This class works as DB cache mostly """
     def __init__(self):
         self.data = defaultdict(dict)  # storage. A key is a slot name, a value is a dictionary with data
-        self.notify = defaultdict(lambda: defaultdict(list))  # registered callbacks: slot -> path -> handlers[]
+        self.notify = defaultdict(lambda: defaultdict(list))  # registered callbacks: slot -> key -> [(path, handler)]
+        self.pending = None  # handlers to run on release(), in the order they were notified. None when not held
 
     @staticmethod
     def get_slot_name(db, table):
@@ -60,9 +61,15 @@ class Directory(object):
         slot = self.get_slot_name(db, table)
         return self.path_traverse(slot, path)[1]
 
+    @staticmethod
+    def get_path_key(path):
+        """ Return the key of the slot a path starts with. An empty path depends on every key """
+        return path.split("/", 1)[0]
+
     def put(self, db, table, key, value):
         """
-        Put information into the storage. Notify handlers which are dependant to the information
+        Put information into the storage. Notify the handlers which depend on the key, when their
+        dependency became available or its value changed
         :param db: db name
         :param table: table name
         :param key: key to change
@@ -70,12 +77,56 @@ class Directory(object):
         :return:
         """
         slot = self.get_slot_name(db, table)
-        self.data[slot][key] = value
+        subscriptions = []
         if slot in self.notify:
-            for path in self.notify[slot].keys():
-                if self.path_exist(db, table, path):
-                    for handler in self.notify[slot][path]:
-                        handler()
+            for path, handler in self.notify[slot].get(key, []) + self.notify[slot].get('', []):
+                subscriptions.append((path, handler, self.get_dep_value(slot, key, path)))
+        self.data[slot][key] = value
+        for path, handler, (was_found, old_value) in subscriptions:
+            found, new_value = self.get_dep_value(slot, key, path)
+            if found and (not was_found or new_value != old_value):
+                self.notify_handler(handler)
+
+    def get_dep_value(self, slot, key, path):
+        """
+        Return the part of a dependency which the key holds. A dependency on the whole slot
+        changes when any of its keys does
+        :param slot: storage key
+        :param key: key of the slot
+        :param path: path of the dependency
+        :return: a pair: True if the part was found, object if it was found
+        """
+        if path:
+            return self.path_traverse(slot, path)
+        entries = self.data.get(slot, {})
+        return key in entries, entries.get(key)
+
+    def notify_handler(self, handler):
+        """
+        Run the handler, or queue it once until release() when the directory is held
+        :param handler: handler to notify
+        """
+        if self.pending is None:
+            handler()
+        else:
+            self.pending[handler] = None
+
+    def hold(self):
+        """ Queue the handlers notified by put() until release() """
+        if self.pending is None:
+            self.pending = OrderedDict()
+
+    def release(self):
+        """
+        Run every handler queued since hold() once. The handlers notified while they run
+        are queued and run in the same call, then put() runs the handlers again
+        """
+        try:
+            while self.pending:
+                handler, _ = self.pending.popitem(last=False)
+                handler()
+        finally:
+            self.pending = None
 
     def get(self, db, table, key):
         """
@@ -156,4 +207,4 @@ class Directory(object):
         """
         for db, table, path in deps:
             slot = self.get_slot_name(db, table)
-            self.notify[slot][path].append(handler)
\ No newline at end of file
+            self.notify[slot][self.get_path_key(path)].append((path, handler))
\ No newline at end of file
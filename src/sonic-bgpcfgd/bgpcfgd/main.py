@@ -54,7 +54,7 @@ def do_work():
         # BBR Manager
         BBRMgr(common_objs, "CONFIG_DB", "BGP_BBR"),
     ]
-    runner = Runner(common_objs['cfg_mgr'])
+    runner = Runner(common_objs['cfg_mgr'], common_objs['directory'])
     for mgr in managers:
         runner.add_manager(mgr)
     runner.run()
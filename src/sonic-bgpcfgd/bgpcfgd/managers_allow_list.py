@@ -19,6 +19,7 @@ class BGPAllowListMgr(Manager):
     ROUTE_MAP_ENTRY_WITH_COMMUNITY_END = 29990
     ROUTE_MAP_ENTRY_WITHOUT_COMMUNITY_START = 30000
     ROUTE_MAP_ENTRY_WITHOUT_COMMUNITY_END = 65530
+    PREFIX_LIST_SEQ_MAX = 4294967295
 
     V4 = "v4"  # constant for af enum: V4
     V6 = "v6"  # constant for af enum: V6
@@ -228,20 +229,75 @@ class BGPAllowListMgr(Manager):
         constant_list = self.__get_constant_list(af)
         allow_list = self.__to_prefix_list(af, allow_list)
         log_debug("BGPAllowListMgr::__update_prefix_list. af='%s' prefix-list name=%s" % (af, pl_name))
-        exist, correct = self.__is_prefix_list_valid(af, pl_name, allow_list, constant_list)
-        if correct:
-            log_debug("BGPAllowListMgr::__update_prefix_list. the prefix-list '%s' exists and correct" % pl_name)
-            return []
         family = self.__af_to_family(af)
+        entries = self.__get_prefix_list_entries(af, pl_name)
         cmds = []
-        seq_no = 10
-        if exist:
+        if entries:
+            delta = self.__prefix_list_delta(family, pl_name, entries, constant_list, allow_list)
+            if delta is not None:
+                if not delta:
+                    log_debug("BGPAllowListMgr::__update_prefix_list. the prefix-list '%s' exists and correct" % pl_name)
+                return delta
             cmds.append('no %s prefix-list %s' % (family, pl_name))
+        seq_no = 10
         for entry in constant_list + allow_list:
             cmds.append('%s prefix-list %s seq %d %s' % (family, pl_name, seq_no, entry))
             seq_no += 10
         return cmds
 
+    @staticmethod
+    def __prefix_list_delta(family, pl_name, entries, constant_list, allow_list):
+        """
+        Generate commands which change the existing prefix-list entries into constant_list followed by allow_list.
+        Only the entries which are not in allow_list are removed, the missing ones are added after the last entry
+        :param family: prefix-list ip family
+        :param pl_name: prefix-list name
+        :param entries: existing prefix-list entries. seq_no -> rule
+        :param constant_list: a constant list which must be on top of the prefix list
+        :param allow_list: rules of the allow list
+        :return: a list of commands, or None if the constant list is not on top of the prefix-list and the
+                 prefix-list must be recreated
+        """
+        sorted_entries = sorted(entries.items())
+        if [rule for _, rule in sorted_entries[:len(constant_list)]] != list(constant_list):
+            return None
+        allow_set = set(allow_list)
+        presented = set()
+        cmds = []
+        for seq_no, rule in sorted_entries[len(constant_list):]:
+            if rule in allow_set and rule not in presented:
+                presented.add(rule)
+            else:
+                cmds.append('no %s prefix-list %s seq %d %s' % (family, pl_name, seq_no, rule))
+        seq_no = sorted_entries[-1][0]
+        for rule in allow_list:
+            if rule in presented:
+                continue
+            seq_no += 10
+            if seq_no > BGPAllowListMgr.PREFIX_LIST_SEQ_MAX:
+                return None
+            cmds.append('%s prefix-list %s seq %d %s' % (family, pl_name, seq_no, rule))
+            presented.add(rule)
+        return cmds
+
+    def __get_prefix_list_entries(self, af, pl_name):
+        """
+        Parse entries of a prefix-list from the config
+        :param af: address family of the prefix-list
+        :param pl_name: prefix-list name
+        :return: a dictionary seq_no -> rule. Empty if the prefix-list doesn't exist
+        """
+        family = self.__af_to_family(af)
+        match_string = '%s prefix-list %s seq ' % (family, pl_name)
+        entries = {}
+        for line in self.cfg_mgr.get_text():
+            s_line = line.strip()
+            if s_line.startswith(match_string):
+                found = s_line[len(match_string):].split(' ', 1)
+                if found[0].isdigit():
+                    entries[int(found[0])] = found[1] if len(found) > 1 else ''
+        return entries
+
     def __remove_prefix_list(self, af, pl_name):
         """
         Remove prefix-list in the address-family af.
@@ -251,44 +307,12 @@ class BGPAllowListMgr(Manager):
         """
         assert af == self.V4 or af == self.V6
         log_debug("BGPAllowListMgr::__remove_prefix_lists. af='%s' pl_names='%s'" % (af, pl_name))
-        exist, _ = self.__is_prefix_list_valid(af, pl_name, [], [])
-        if not exist:
+        if not self.__get_prefix_list_entries(af, pl_name):
             log_debug("BGPAllowListMgr::__remove_prefix_lists: prefix_list '%s' not found" % pl_name)
             return []
         family = self.__af_to_family(af)
         return ["no %s prefix-list %s" % (family, pl_name)]
 
-    def __is_prefix_list_valid(self, af, pl_name, allow_list, constant_list):
-        """
-        Check that a prefix list exists and it has valid entries
-        :param af: address family of the checked prefix-list
-        :param pl_name: prefix-list name
-        :param allow_list: a prefix-list which must be a part of the valid prefix list
-        :param constant_list: a constant list which must be on top of each "allow" prefix list on the device
-        :return: a tuple. The first element of the tuple has True if the prefix-list exists, False otherwise,
-                 The second element of the tuple has True if the prefix-list contains correct entries, False if not
-        """
-        assert af == self.V4 or af == self.V6
-        family = self.__af_to_family(af)
-        match_string = '%s prefix-list %s seq ' % (family, pl_name)
-        conf = self.cfg_mgr.get_text()
-        if not any(line.strip().startswith(match_string) for line in conf):
-            return False, False  # if the prefix list is not exists, it is not correct
-        constant_set = set(constant_list)
-        allow_set = set(allow_list)
-        for line in conf:
-            if line.startswith(match_string):
-                found = line[len(match_string):].strip().split(' ')
-                rule = " ".join(found[1:])
-                if rule in constant_set:
-                    constant_set.discard(rule)
-                elif rule in allow_set:
-                    if constant_set:
-                        return True, False  # Not everything from constant set is presented
-                    else:
-                        allow_set.discard(rule)
-        return True, len(allow_set) == 0  # allow_set should be presented all
-
     def __update_community(self, community_name, community_value):
         """
         Update community for a peer
@@ -552,13 +576,12 @@ class BGPAllowListMgr(Manager):
                  for the peer_group.
         """
         pg_2_rm = {}
-        for pg in peer_groups:
-            re_peer_group_rm = re.compile(r'^\s*neighbor %s route-map (\S+) in$' % pg)
-            for line in self.cfg_mgr.get_text():
-                result = re_peer_group_rm.match(line)
-                if result:
-                    pg_2_rm[pg] = result.group(1)
-                    break
+        peer_groups = set(peer_groups)
+        re_peer_group_rm = re.compile(r'^\s*neighbor (\S+) route-map (\S+) in$')
+        for line in self.cfg_mgr.get_text():
+            result = re_peer_group_rm.match(line)
+            if result and result.group(1) in peer_groups and result.group(1) not in pg_2_rm:
+                pg_2_rm[result.group(1)] = result.group(2)
         return pg_2_rm
 
     def __get_route_map_calls(self, rms):
@@ -1,4 +1,3 @@
-import re
 from collections import defaultdict
 
 from swsscommon import swsscommon
@@ -107,7 +106,6 @@ class BBRMgr(Manager):
         :return: list of commands prepared for FRR
         """
         bgp_asn = self.directory.get_slot("CONFIG_DB", swsscommon.CFG_DEVICE_METADATA_TABLE_NAME)["localhost"]["bgp_asn"]
-        self.cfg_mgr.update()
         available_peer_groups = self.__get_available_peer_groups()
         available_peers_per_pg = self.__get_available_peers_per_peer_group(available_peer_groups)
         cmds = ["router bgp %s" % bgp_asn]
@@ -125,30 +123,19 @@ class BBRMgr(Manager):
 
     def __get_available_peer_groups(self):
         """
-        Extract configured peer-groups from the config
+        Extract peer-groups of the peers from the peer-group index kept by the peer managers
         :return: set of available peer-groups
         """
-        re_pg = re.compile(r'^\s*neighbor\s+(\S+)\s+peer-group\s*$')
-        res = set()
-        for line in self.cfg_mgr.get_text():
-            m = re_pg.match(line)
-            if m:
-                res.add(m.group(1))
-        return res
+        return set(self.directory.get_slot("LOCAL", "peer_groups").values())
 
     def __get_available_peers_per_peer_group(self, available_peer_groups):
         """
-        Extract mapping peer_group->[peers]
+        Extract mapping peer_group->[peers] from the peer-group index kept by the peer managers
         :param available_peer_groups: list of peer groups to check
         :return: dictionary peer_group->[peers]
         """
-        re_pg = re.compile(r'^\s*neighbor\s+(\S+)\s+peer-group\s+(\S+)\s*$')
         res = defaultdict(list)
-        for line in self.cfg_mgr.get_text():
-            m = re_pg.match(line)
-            if m:
-                peer = m.group(1)
-                pg = m.group(2)
-                if pg in available_peer_groups:
-                    res[pg].append(peer)
+        for peer, pg in sorted(self.directory.get_slot("LOCAL", "peer_groups").items()):
+            if pg in available_peer_groups:
+                res[pg].append(peer)
         return res
@@ -1,4 +1,5 @@
 import json
+import re
 from swsscommon import swsscommon
 
 import jinja2
@@ -23,6 +24,10 @@ class BGPPeerGroupMgr(object):
         tf = common_objs['tf']
         self.policy_template = tf.from_file(base_template + "policies.conf.j2")
         self.peergroup_template = tf.from_file(base_template + "peer-group.conf.j2")
+        # Last commands pushed for ('policy' or 'pg', vrf). Peers sharing the peer-group
+        # render the same commands, only changes are pushed to FRR
+        self.pushed = {}
+        self.commit_failures = self.cfg_mgr.commit_failures
 
     def update(self, name, **kwargs):
         """
@@ -45,7 +50,7 @@ class BGPPeerGroupMgr(object):
         except jinja2.TemplateError as e:
             log_err("Can't render policy template name: '%s': %s" % (name, str(e)))
             return False
-        self.update_entity(policy, "Routing policy for peer '%s'" % name)
+        self.update_entity(policy, "Routing policy for peer '%s'" % name, ('policy', kwargs['vrf']))
         return True
 
     def update_pg(self, name, **kwargs):
@@ -64,16 +69,25 @@ class BGPPeerGroupMgr(object):
             cmd = ('router bgp %s\n' % kwargs['bgp_asn']) + pg
         else:
             cmd = ('router bgp %s vrf %s\n' % (kwargs['bgp_asn'], kwargs['vrf'])) + pg
-        self.update_entity(cmd, "Peer-group for peer '%s'" % name)
+        self.update_entity(cmd, "Peer-group for peer '%s'" % name, ('pg', kwargs['vrf']))
         return True
 
-    def update_entity(self, cmd, txt):
+    def update_entity(self, cmd, txt, key):
         """
-        Send commands to FRR
+        Send commands to FRR, unless they are the same as the last commands sent for the key
         :param cmd: commands to send in a raw form
         :param txt: text for the syslog output
+        :param key: tuple (entity, vrf) the commands configure
         :return:
         """
+        if self.cfg_mgr.commit_failures != self.commit_failures:
+            # The commands of a failed commit could be lost, send everything again
+            self.pushed = {}
+            self.commit_failures = self.cfg_mgr.commit_failures
+        if self.pushed.get(key) == cmd:
+            log_debug("%s is already up to date" % txt)
+            return True
+        self.pushed[key] = cmd
         self.cfg_mgr.push(cmd)
         log_info("%s has been scheduled to be updated" % txt)
         return True
@@ -132,7 +146,9 @@ class BGPPeerMgrBase(Manager):
             table_name,
         )
 
-        self.peers = self.load_peers()
+        self.peers, peer_groups = self.load_peers()
+        for nbr, pg in peer_groups.items():
+            self.directory.put("LOCAL", "peer_groups", nbr, pg)
         self.peer_group_mgr = BGPPeerGroupMgr(self.common_objs, base_template)
         return
 
@@ -214,6 +230,8 @@ class BGPPeerMgrBase(Manager):
             self.apply_op(cmd, vrf)
             key = (vrf, nbr)
             self.peers.add(key)
+            if vrf == 'default':
+                self.update_peer_group_index(nbr, cmd)
             log_info("Peer '(%s|%s)' has been scheduled to be added with attributes '%s'" % print_data)
 
         return True
@@ -281,9 +299,24 @@ class BGPPeerMgrBase(Manager):
         if ret_code:
             log_info("Peer '(%s|%s)' has been removed" % (vrf, nbr))
             self.peers.remove(peer_key)
+            if vrf == 'default' and self.directory.path_exist("LOCAL", "peer_groups", nbr):
+                self.directory.remove("LOCAL", "peer_groups", nbr)
         else:
             log_err("Peer '(%s|%s)' hasn't been removed" % (vrf, nbr))
 
+    def update_peer_group_index(self, nbr, cmd):
+        """
+        Record the peer-group of a default vrf peer in the LOCAL|peer_groups slot, used by BBRMgr
+        :param nbr: neighbor ip address (name for dynamic peer type)
+        :param cmd: rendered commands which add the peer
+        """
+        re_pg = re.compile(r'^\s*neighbor\s+(\S+)\s+peer-group\s+(\S+)\s*$')
+        for line in cmd.split('\n'):
+            m = re_pg.match(line)
+            if m and m.group(1) == nbr:
+                self.directory.put("LOCAL", "peer_groups", nbr, m.group(2))
+                return
+
     def apply_op(self, cmd, vrf):
         """
         Push commands cmd into FRR
@@ -364,26 +397,23 @@ class BGPPeerMgrBase(Manager):
     def load_peers():
         """
         Load peers from FRR.
-        :return: set of peers, which are already installed in FRR
+        :return: set of peers, which are already installed in FRR,
+                 and dictionary neighbor->peer-group for the peers of the default vrf
         """
-        command = ["vtysh", "-c", "show bgp vrfs json"]
+        command = ["vtysh", "-c", "show bgp vrf all neighbors json"]
         ret_code, out, err = run_command(command)
-        if ret_code == 0:
-            js_vrf = json.loads(out)
-            vrfs = js_vrf['vrfs'].keys()
-        else:
-            log_crit("Can't read bgp vrfs: %s" % err)
-            raise Exception("Can't read bgp vrfs: %s" % err)
+        if ret_code != 0:
+            log_crit("Can't read bgp neighbors: %s" % err)
+            raise Exception("Can't read bgp neighbors: %s" % err)
+        # The output is {vrf: {neighbor: {...}, "vrfId": id, "vrfName": name}}
+        js_bgp = json.loads(out)
         peers = set()
-        for vrf in vrfs:
-            command = ["vtysh", "-c", 'show bgp vrf %s neighbors json' % str(vrf)]
-            ret_code, out, err = run_command(command)
-            if ret_code == 0:
-                js_bgp = json.loads(out)
-                for nbr in js_bgp.keys():
+        peer_groups = {}
+        for vrf, js_vrf in js_bgp.items():
+            for nbr, js_nbr in js_vrf.items():
+                if isinstance(js_nbr, dict):
                     peers.add((vrf, nbr))
-            else:
-                log_crit("Can't read vrf '%s' neighbors: %s" % (vrf, str(err)))
-                raise Exception("Can't read vrf '%s' neighbors: %s" % (vrf, str(err)))
+                    if vrf == 'default' and 'peerGroup' in js_nbr:
+                        peer_groups[nbr] = js_nbr['peerGroup']
 
-        return peers
+        return peers, peer_groups
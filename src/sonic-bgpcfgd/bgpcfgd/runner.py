@@ -1,4 +1,5 @@
-from collections import defaultdict
+import time
+from collections import defaultdict, OrderedDict
 from swsscommon import swsscommon
 
 from .log import log_debug, log_crit
@@ -19,20 +20,25 @@ class Runner(object):
         when corresponding db/table is updated
     """
     SELECT_TIMEOUT = 1000
+    MAX_EVENTS_PER_TABLE = 1000  # events read from one table in one cycle
+    COMMIT_INTERVAL = 0.5        # minimal number of seconds between two commits
 
-    def __init__(self, cfg_manager):
+    def __init__(self, cfg_manager, directory=None):
         """ Constructor """
         self.cfg_manager = cfg_manager
+        self.directory = directory  # its dependency handlers run once per cycle, after the events
         self.db_connectors = {}
         self.selector = swsscommon.Select()
         self.callbacks = defaultdict(lambda: defaultdict(list))  # db -> table -> handlers[]
-        self.subscribers = set()
+        self.subscribers = []  # in the order of the managers, the earlier table is handled first
+        self.last_commit = 0.0
 
     def add_manager(self, manager):
         """
         Add a manager to the Runner.
         As soon as new events will be receiving by Runner,
-        handlers of corresponding objects will be executed
+        handlers of corresponding objects will be executed.
+        The events of the tables are handled in the order the managers were added
         :param manager: an object implementing Manager
         """
         db_name = manager.get_database()
@@ -44,27 +50,64 @@ class Runner(object):
         if table_name not in self.callbacks[db]:
             conn = self.db_connectors[db]
             subscriber = swsscommon.SubscriberStateTable(conn, table_name)
-            self.subscribers.add(subscriber)
+            self.subscribers.append(subscriber)
             self.selector.addSelectable(subscriber)
         self.callbacks[db][table_name].append(manager.handler)
 
     def run(self):
         """ Main loop """
+        pending_events = False
+        pending_commit = False
         while g_run:
-            state, _ = self.selector.select(Runner.SELECT_TIMEOUT)
-            if state == self.selector.TIMEOUT:
-                continue
-            elif state == self.selector.ERROR:
-                raise Exception("Received error from select")
+            if not pending_events:
+                timeout = Runner.SELECT_TIMEOUT
+                if pending_commit:
+                    timeout = min(timeout, max(0, int(self.commit_delay() * 1000)))
+                state, _ = self.selector.select(timeout)
+                if state == self.selector.ERROR:
+                    raise Exception("Received error from select")
+                if state == self.selector.TIMEOUT and not pending_commit:
+                    continue
 
+            pending_events = False
+            if self.directory is not None:
+                self.directory.hold()
             for subscriber in self.subscribers:
-                while True:
-                    key, op, fvs = subscriber.pop()
-                    if not key:
-                        break
-                    log_debug("Received message : '%s'" % str((key, op, fvs)))
-                    for callback in self.callbacks[subscriber.getDbConnector().getDbId()][subscriber.getTableName()]:
-                        callback(key, op, dict(fvs))
-            rc = self.cfg_manager.commit()
-            if not rc:
-                log_crit("Runner::commit was unsuccessful")
+                events, more = self.read_events(subscriber)
+                pending_events = pending_events or more
+                callbacks = self.callbacks[subscriber.getDbConnector().getDbId()][subscriber.getTableName()]
+                for key, (op, fvs) in events.items():
+                    for callback in callbacks:
+                        callback(key, op, fvs)
+                pending_commit = pending_commit or bool(events)
+            if self.directory is not None:
+                self.directory.release()
+
+            if pending_commit and self.commit_delay() <= 0:
+                pending_commit = False
+                self.last_commit = time.time()
+                rc = self.cfg_manager.commit()
+                if not rc:
+                    log_crit("Runner::commit was unsuccessful")
+
+    def commit_delay(self):
+        """ Number of seconds until the next commit is allowed """
+        return self.last_commit + Runner.COMMIT_INTERVAL - time.time()
+
+    @staticmethod
+    def read_events(subscriber):
+        """
+        Read up to MAX_EVENTS_PER_TABLE events of a table. The events of the same key
+        are merged into the last one, which carries the whole entry
+        :param subscriber: the table subscriber
+        :return: OrderedDict key -> (op, fvs) in the order of the last events, and True when the table has more events
+        """
+        events = OrderedDict()
+        for _ in range(Runner.MAX_EVENTS_PER_TABLE):
+            key, op, fvs = subscriber.pop()
+            if not key:
+                return events, False
+            log_debug("Received message : '%s'" % str((key, op, fvs)))
+            events.pop(key, None)
+            events[key] = op, dict(fvs)
+        return events, True
@@ -10,8 +10,9 @@ Description: bgpmon.py -- populating bgp related information in stateDB.
     future, then more can be added into this process.
     The script check if there are any bgp activities by monitoring the bgp
     frr.log file timestamp.  If activity is detected, then it will request bgp
-    neighbor state via vtysh cli interface. This bgp activity monitoring is
-    done periodically (every 15 second). When triggered, it looks specifically
+    neighbor state via vtysh cli interface. The timestamp is checked every
+    second, if the log file is not available the neighbor state is requested
+    every 15 seconds. When triggered, it looks specifically
     for the neighbor state in the json output of show ip bgp neighbors json
     and update the state DB for each neighbor accordingly.
     In order to not disturb and hold on to the State DB access too long and
@@ -21,14 +22,16 @@ Description: bgpmon.py -- populating bgp related information in stateDB.
     is a need to perform update or the peer is stale to be removed from the
     state DB
 """
-import commands
 import json
 import os
+import subprocess
 import syslog
 import swsssdk
 import time
 
 PIPE_BATCH_MAX_COUNT = 50
+ACTIVITY_CHECK_INTERVAL = 1  # seconds between two checks of the frr log timestamp
+POLL_INTERVAL = 15           # seconds between two requests when the frr log is not available
 
 class BgpStateGet():
     def __init__(self):
@@ -41,6 +44,7 @@ class BgpStateGet():
         self.new_peer_l = set()
         self.new_peer_state = {}
         self.cached_timestamp = 0
+        self.last_poll = 0
         self.db = swsssdk.SonicV2Connector()
         self.db.connect(self.db.STATE_DB, False)
         client = self.db.get_redis_client(self.db.STATE_DB)
@@ -51,7 +55,7 @@ class BgpStateGet():
     # check its log file has any activities. This is by checking its modified
     # timestamp against the cached timestamp that we keep and if there is a
     # difference, there is activity detected. In case the log file got wiped
-    # out, it will default back to constant pulling every 15 seconds
+    # out, it will default back to constant pulling every POLL_INTERVAL seconds
     def bgp_activity_detected(self):
         try:
             timestamp = os.stat("/var/log/frr/frr.log").st_mtime
@@ -61,7 +65,11 @@ class BgpStateGet():
             else:
                 return False
         except (IOError, OSError):
-            return True
+            now = time.time()
+            if now - self.last_poll >= POLL_INTERVAL or now < self.last_poll:
+                self.last_poll = now
+                return True
+            return False
 
     def update_new_peer_states(self, peer_dict):
         peer_l = peer_dict["peers"].keys()
@@ -71,13 +79,22 @@ class BgpStateGet():
 
     # Get a new snapshot of BGP neighbors and store them in the "new" location
     def get_all_neigh_states(self):
-        cmd = "vtysh -c 'show bgp summary json'"
-        rc, output = commands.getstatusoutput(cmd)
-        if rc:
-            syslog.syslog(syslog.LOG_ERR, "*ERROR* Failed with rc:{} when execute: {}".format(rc, cmd))
+        cmd = ["vtysh", "-c", "show bgp summary json"]
+        try:
+            proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+            output = proc.communicate()[0]
+        except OSError as e:
+            syslog.syslog(syslog.LOG_ERR, "*ERROR* Failed to execute: {}, reason {}".format(" ".join(cmd), str(e)))
+            return
+        if proc.returncode:
+            syslog.syslog(syslog.LOG_ERR, "*ERROR* Failed with rc:{} when execute: {}".format(proc.returncode, " ".join(cmd)))
             return
 
-        peer_info = json.loads(output)
+        try:
+            peer_info = json.loads(output)
+        except ValueError:
+            syslog.syslog(syslog.LOG_ERR, "*ERROR* Invalid output of: {}".format(" ".join(cmd)))
+            return
         # cmd ran successfully, safe to Clean the "new" set/dict for new snapshot
         self.new_peer_l.clear()
         self.new_peer_state.clear()
@@ -158,7 +175,7 @@ def main():
 
     # periodically obtain the new neighbor infomraton and update if necessary
     while True:
-        time.sleep(15)
+        time.sleep(ACTIVITY_CHECK_INTERVAL)
         if bgp_state_get.bgp_activity_detected():
             bgp_state_get.get_all_neigh_states()
             bgp_state_get.update_neigh_states()
@@ -378,23 +378,9 @@ def test__get_available_peer_groups():
         'constants': global_constants,
     }
     m = BBRMgr(common_objs, "CONFIG_DB", "BGP_BBR")
-    m.cfg_mgr.get_text = MagicMock(return_value=[
-        '  neighbor PEER_V4 peer-group',
-        '  neighbor PEER_V6 peer-group',
-        '  address-family ipv4',
-        '    neighbor PEER_V4 allowas-in 1',
-        '    neighbor PEER_V4 soft-reconfiguration inbound',
-        '    neighbor PEER_V4 route-map FROM_BGP_PEER_V4 in',
-        '    neighbor PEER_V4 route-map TO_BGP_PEER_V4 out',
-        '  exit-address-family',
-        '  address-family ipv6',
-        '    neighbor PEER_V6 allowas-in 1',
-        '    neighbor PEER_V6 soft-reconfiguration inbound',
-        '    neighbor PEER_V6 route-map FROM_BGP_PEER_V6 in',
-        '    neighbor PEER_V6 route-map TO_BGP_PEER_V6 out',
-        '  exit-address-family',
-        '     ',
-    ])
+    m.directory.put("LOCAL", "peer_groups", "10.0.0.1", "PEER_V4")
+    m.directory.put("LOCAL", "peer_groups", "10.0.0.10", "PEER_V4")
+    m.directory.put("LOCAL", "peer_groups", "fc00::1", "PEER_V6")
     res = m._BBRMgr__get_available_peer_groups()
     assert res == {"PEER_V4", "PEER_V6"}
 
@@ -407,15 +393,11 @@ def test__get_available_peers_per_peer_group():
         'constants': global_constants,
     }
     m = BBRMgr(common_objs, "CONFIG_DB", "BGP_BBR")
-    m.cfg_mgr.get_text = MagicMock(return_value=[
-        '  neighbor PEER_V4 peer-group',
-        '  neighbor PEER_V6 peer-group',
-        '  neighbor 10.0.0.1 peer-group PEER_V4',
-        '  neighbor fc00::1 peer-group PEER_V6',
-        '  neighbor 10.0.0.10 peer-group PEER_V4',
-        '  neighbor fc00::2 peer-group PEER_V6',
-        '     ',
-    ])
+    m.directory.put("LOCAL", "peer_groups", "fc00::2", "PEER_V6")
+    m.directory.put("LOCAL", "peer_groups", "10.0.0.10", "PEER_V4")
+    m.directory.put("LOCAL", "peer_groups", "fc00::1", "PEER_V6")
+    m.directory.put("LOCAL", "peer_groups", "10.0.0.1", "PEER_V4")
+    m.directory.put("LOCAL", "peer_groups", "10.1.0.1", "BGPMON")
     res = m._BBRMgr__get_available_peers_per_peer_group(['PEER_V4', "PEER_V6"])
     assert dict(res) == {
         "PEER_V4": ['10.0.0.1', '10.0.0.10'],
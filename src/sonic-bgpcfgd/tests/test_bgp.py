@@ -0,0 +1,51 @@
+from bgpcfgd.directory import Directory
+from mock import patch
+
+import swsscommon_test
+
+with patch.dict("sys.modules", swsscommon=swsscommon_test):
+    from bgpcfgd import managers_bgp
+    from bgpcfgd.managers_bgp import BGPPeerMgrBase
+
+
+@patch.object(managers_bgp, 'run_command')
+def test_load_peers(mocked_run_command):
+    mocked_run_command.return_value = (0, """{
+        "default": {
+            "vrfId": 0,
+            "vrfName": "default",
+            "10.0.0.1": {"remoteAs": 64001, "bgpState": "Established", "peerGroup": "PEER_V4"},
+            "fc00::2": {"remoteAs": 64001, "bgpState": "Established", "peerGroup": "PEER_V6"},
+            "10.10.0.1": {"remoteAs": 64003, "bgpState": "Idle"}
+        },
+        "Vrf1": {
+            "vrfId": 5,
+            "vrfName": "Vrf1",
+            "10.1.0.1": {"remoteAs": 64002, "bgpState": "Active", "peerGroup": "PEER_V4"}
+        }
+    }""", "")
+    peers, peer_groups = BGPPeerMgrBase.load_peers()
+    assert peers == {("default", "10.0.0.1"), ("default", "fc00::2"), ("default", "10.10.0.1"), ("Vrf1", "10.1.0.1")}
+    assert peer_groups == {"10.0.0.1": "PEER_V4", "fc00::2": "PEER_V6"}
+    mocked_run_command.assert_called_once_with(["vtysh", "-c", "show bgp vrf all neighbors json"])
+
+@patch.object(managers_bgp, 'run_command')
+def test_load_peers_error(mocked_run_command):
+    mocked_run_command.return_value = (1, "", "error")
+    try:
+        BGPPeerMgrBase.load_peers()
+    except Exception:
+        return
+    assert False, "Exception is expected"
+
+def test_update_peer_group_index():
+    class Peers(object):
+        directory = Directory()
+    m = Peers()
+    cmd = "  neighbor 10.0.0.1 remote-as 64001\n" \
+          "  address-family ipv4\n" \
+          "    neighbor 10.0.0.1 peer-group PEER_V4\n" \
+          "    neighbor 10.0.0.1 allowas-in 1\n"
+    BGPPeerMgrBase.update_peer_group_index(m, "10.0.0.1", cmd)
+    BGPPeerMgrBase.update_peer_group_index(m, "10.0.0.2", cmd)
+    assert m.directory.get_slot("LOCAL", "peer_groups") == {"10.0.0.1": "PEER_V4"}
@@ -38,6 +38,36 @@ def test_update():
     assert c.current_config_raw == [' text1', ' text2', ' text3', ' text4', '    ', '     ']
     assert c.current_config == [['text1'], ['text2'], ['text3'], ['text4']]
 
+def test_update_cached():
+    frr = MagicMock()
+    frr.get_config = MagicMock(return_value = " text1\n")
+    c = ConfigMgr(frr)
+    c.update()
+    c.update()
+    assert frr.get_config.call_count == 1
+    frr.get_config.return_value = " text2\n"
+    c.update(force=True)
+    assert frr.get_config.call_count == 2
+    assert c.current_config == [['text2']]
+    c.commit()
+    assert c.current_config is None
+    c.update()
+    assert frr.get_config.call_count == 3
+
+def test_update_after_commit():
+    frr = MagicMock()
+    frr.get_config = MagicMock(return_value = " text1\n")
+    frr.write = MagicMock(return_value = True)
+    frr.restart_peer_groups = MagicMock(return_value = True)
+    c = ConfigMgr(frr)
+    c.update()
+    c.push("text2")
+    assert c.commit()
+    frr.get_config.return_value = " text1\n text2\n"
+    c.update()
+    assert frr.get_config.call_count == 2
+    assert c.current_config == [['text1'], ['text2']]
+
 def test_push_list():
     frr = MagicMock()
     c = ConfigMgr(frr)
@@ -206,3 +236,16 @@ def test_from_canonical():
     c = ConfigMgr(frr)
     raw = c.from_canonical(canonical)
     assert raw == expected
+
+def test_commit_failures():
+    frr = MagicMock()
+    frr.write = MagicMock(return_value = False)
+    frr.restart_peer_groups = MagicMock(return_value = True)
+    c = ConfigMgr(frr)
+    c.push("text1")
+    assert not c.commit()
+    assert c.commit_failures == 1
+    frr.write.return_value = True
+    c.push("text2")
+    assert c.commit()
+    assert c.commit_failures == 1
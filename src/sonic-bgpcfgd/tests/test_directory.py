@@ -0,0 +1,54 @@
+from mock import MagicMock
+
+from bgpcfgd.directory import Directory
+
+
+def test_put_notifies_key_dependency():
+    d = Directory()
+    asn_handler = MagicMock()
+    lo_handler = MagicMock()
+    d.subscribe([("CONFIG_DB", "DEVICE_METADATA", "localhost/bgp_asn")], asn_handler)
+    d.subscribe([("CONFIG_DB", "LOOPBACK_INTERFACE", "Loopback0")], lo_handler)
+    d.put("CONFIG_DB", "DEVICE_METADATA", "localhost", {"hostname": "switch"})
+    assert asn_handler.call_count == 0
+    d.put("CONFIG_DB", "DEVICE_METADATA", "localhost", {"hostname": "switch", "bgp_asn": "65100"})
+    assert asn_handler.call_count == 1
+    d.put("CONFIG_DB", "DEVICE_METADATA", "localhost", {"hostname": "switch2", "bgp_asn": "65100"})
+    assert asn_handler.call_count == 1
+    d.put("CONFIG_DB", "DEVICE_METADATA", "localhost", {"hostname": "switch2", "bgp_asn": "65200"})
+    assert asn_handler.call_count == 2
+    d.put("CONFIG_DB", "LOOPBACK_INTERFACE", "Loopback1", {})
+    assert lo_handler.call_count == 0
+    d.put("CONFIG_DB", "LOOPBACK_INTERFACE", "Loopback0", {})
+    assert lo_handler.call_count == 1
+
+def test_put_notifies_slot_dependency():
+    d = Directory()
+    handler = MagicMock()
+    d.subscribe([("LOCAL", "interfaces", "")], handler)
+    d.put("LOCAL", "interfaces", "Ethernet0|10.0.0.0/31", {})
+    d.put("LOCAL", "interfaces", "Ethernet4|10.0.0.2/31", {})
+    assert handler.call_count == 2
+    d.put("LOCAL", "interfaces", "Ethernet4|10.0.0.2/31", {})
+    assert handler.call_count == 2
+    d.put("LOCAL", "local_addresses", "10.0.0.0", {})
+    assert handler.call_count == 2
+
+def test_hold_release():
+    d = Directory()
+    calls = []
+    def handler_1():
+        calls.append(1)
+        d.put("LOCAL", "b", "key", len(calls))
+    def handler_2():
+        calls.append(2)
+    d.subscribe([("LOCAL", "a", "")], handler_1)
+    d.subscribe([("LOCAL", "a", ""), ("LOCAL", "b", "")], handler_2)
+    d.hold()
+    d.put("LOCAL", "a", "key1", "1")
+    d.put("LOCAL", "a", "key2", "2")
+    assert calls == []
+    d.release()
+    assert calls == [1, 2]
+    d.put("LOCAL", "a", "key3", "3")
+    assert calls == [1, 2, 1, 2, 2]
@@ -0,0 +1,59 @@
+from mock import MagicMock, patch
+
+import jinja2
+import swsscommon_test
+
+with patch.dict("sys.modules", swsscommon=swsscommon_test):
+    from bgpcfgd.managers_bgp import BGPPeerGroupMgr
+
+
+def constructor():
+    cfg_mgr = MagicMock()
+    cfg_mgr.commit_failures = 0
+    templates = {
+        "base/policies.conf.j2": jinja2.Template("route-map FROM_PEER permit {{ constants.seq }}"),
+        "base/peer-group.conf.j2": jinja2.Template(" neighbor PEER peer-group"),
+    }
+    tf = MagicMock()
+    tf.from_file = lambda path: templates[path]
+    common_objs = {
+        'cfg_mgr': cfg_mgr,
+        'constants': {},
+        'tf': tf,
+    }
+    return BGPPeerGroupMgr(common_objs, "base/")
+
+def pushed(m):
+    return [args[0][0] for args in m.cfg_mgr.push.call_args_list]
+
+def test_update_once_per_vrf():
+    m = constructor()
+    for nbr in ["10.0.0.1", "10.0.0.3", "10.0.0.5"]:
+        assert m.update(nbr, constants={'seq': 100}, vrf='default', bgp_asn=65100, neighbor_addr=nbr)
+    assert m.update("10.0.0.7", constants={'seq': 100}, vrf='Vrf1', bgp_asn=65100, neighbor_addr="10.0.0.7")
+    assert pushed(m) == [
+        "route-map FROM_PEER permit 100",
+        "router bgp 65100\n neighbor PEER peer-group",
+        "route-map FROM_PEER permit 100",
+        "router bgp 65100 vrf Vrf1\n neighbor PEER peer-group",
+    ]
+
+def test_update_changed():
+    m = constructor()
+    m.update("10.0.0.1", constants={'seq': 100}, vrf='default', bgp_asn=65100)
+    m.update("10.0.0.3", constants={'seq': 200}, vrf='default', bgp_asn=65100)
+    m.update("10.0.0.5", constants={'seq': 100}, vrf='default', bgp_asn=65100)
+    assert pushed(m) == [
+        "route-map FROM_PEER permit 100",
+        "router bgp 65100\n neighbor PEER peer-group",
+        "route-map FROM_PEER permit 200",
+        "route-map FROM_PEER permit 100",
+    ]
+
+def test_update_after_commit_failure():
+    m = constructor()
+    m.update("10.0.0.1", constants={'seq': 100}, vrf='default', bgp_asn=65100)
+    m.cfg_mgr.commit_failures = 1
+    m.update("10.0.0.3", constants={'seq': 100}, vrf='default', bgp_asn=65100)
+    m.update("10.0.0.5", constants={'seq': 100}, vrf='default', bgp_asn=65100)
+    assert len(pushed(m)) == 4
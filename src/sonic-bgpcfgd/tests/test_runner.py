@@ -0,0 +1,74 @@
+from mock import MagicMock, patch
+import swsscommon_test
+
+with patch.dict("sys.modules", swsscommon=swsscommon_test):
+    import bgpcfgd.runner
+    from bgpcfgd.runner import Runner
+
+
+def subscriber_with(events, table_name="TABLE"):
+    subscriber = MagicMock()
+    subscriber.pop = MagicMock(side_effect=events + [("", "", ())])
+    subscriber.getTableName = MagicMock(return_value=table_name)
+    subscriber.getDbConnector.return_value.getDbId.return_value = 4
+    return subscriber
+
+def test_read_events_merge():
+    subscriber = subscriber_with([
+        ("key1", "SET", (("a", "1"),)),
+        ("key2", "SET", (("b", "2"),)),
+        ("key1", "DEL", ()),
+        ("key3", "SET", (("c", "3"),)),
+        ("key3", "SET", (("c", "4"),)),
+    ])
+    events, more = Runner.read_events(subscriber)
+    assert not more
+    assert list(events.items()) == [
+        ("key2", ("SET", {"b": "2"})),
+        ("key1", ("DEL", {})),
+        ("key3", ("SET", {"c": "4"})),
+    ]
+
+def test_read_events_limit():
+    subscriber = subscriber_with([("key%d" % i, "SET", ()) for i in range(Runner.MAX_EVENTS_PER_TABLE + 1)])
+    events, more = Runner.read_events(subscriber)
+    assert more
+    assert len(events) == Runner.MAX_EVENTS_PER_TABLE
+    events, more = Runner.read_events(subscriber)
+    assert not more
+    assert list(events.keys()) == ["key%d" % Runner.MAX_EVENTS_PER_TABLE]
+
+def test_run_order_and_single_commit():
+    cfg_mgr = MagicMock()
+    cfg_mgr.commit = MagicMock(return_value=True)
+    runner = Runner(cfg_mgr)
+    runner.selector = MagicMock()
+    runner.selector.select = MagicMock(return_value=("OBJECT", None))
+    calls = []
+    def callback(key, op, fvs):
+        calls.append((key, op, fvs))
+        bgpcfgd.runner.g_run = False
+    runner.subscribers = [
+        subscriber_with([("peer1", "SET", (("asn", "1"),)), ("peer1", "SET", (("asn", "2"),))], "BGP_NEIGHBOR"),
+        subscriber_with([("localhost", "SET", (("bgp_asn", "65100"),))], "DEVICE_METADATA"),
+    ]
+    runner.callbacks[4]["BGP_NEIGHBOR"] = [callback]
+    runner.callbacks[4]["DEVICE_METADATA"] = [callback]
+    bgpcfgd.runner.g_run = True
+    runner.run()
+    assert calls == [("peer1", "SET", {"asn": "2"}), ("localhost", "SET", {"bgp_asn": "65100"})]
+    assert cfg_mgr.commit.call_count == 1
+
+def test_run_directory_handlers_before_commit():
+    calls = MagicMock()
+    calls.cfg_mgr.commit = MagicMock(return_value=True)
+    runner = Runner(calls.cfg_mgr, calls.directory)
+    runner.selector = MagicMock()
+    runner.selector.select = MagicMock(return_value=("OBJECT", None))
+    def callback(key, op, fvs):
+        bgpcfgd.runner.g_run = False
+    runner.subscribers = [subscriber_with([("localhost", "SET", (("bgp_asn", "65100"),))], "DEVICE_METADATA")]
+    runner.callbacks[4]["DEVICE_METADATA"] = [callback]
+    bgpcfgd.runner.g_run = True
+    runner.run()
+    assert [name for name, _, _ in calls.mock_calls] == ["directory.hold", "directory.release", "cfg_mgr.commit"]
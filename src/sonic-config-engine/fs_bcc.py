@@ -0,0 +1,61 @@
+import errno
+import os
+import tempfile
+
+import jinja2
+
+class FileSystemBytecodeCache(jinja2.BytecodeCache):
+    """ A bytecode cache for jinja2 template that stores bytecode in a directory
+
+    Entries are keyed by template path, jinja2 drops an entry whose source
+    checksum no longer matches the template. Entries are replaced atomically
+    so that concurrent renders never load a partial entry.
+    """
+
+    CACHE_DIR = '/var/cache/sonic/cfggen'
+
+    def __init__(self, directory=CACHE_DIR):
+        self._directory = directory
+        try:
+            os.makedirs(self._directory)
+        except OSError as e:
+            if e.errno != errno.EEXIST:
+                self._directory = None
+        if self._directory is not None and not os.access(self._directory, os.W_OK | os.X_OK):
+            self._directory = None
+
+    @property
+    def usable(self):
+        return self._directory is not None
+
+    def _get_cache_filename(self, bucket):
+        return os.path.join(self._directory, '%s.cache' % bucket.key)
+
+    def load_bytecode(self, bucket):
+        if self._directory is None:
+            return
+        try:
+            with open(self._get_cache_filename(bucket), 'rb') as f:
+                bucket.load_bytecode(f)
+        except IOError:
+            pass
+        except Exception:
+            # Corrupted entry, it is rewritten once the template is compiled
+            bucket.reset()
+
+    def dump_bytecode(self, bucket):
+        if self._directory is None:
+            return
+        try:
+            fd, tmp_name = tempfile.mkstemp(dir=self._directory, suffix='.tmp')
+        except OSError:
+            return
+        try:
+            with os.fdopen(fd, 'wb') as f:
+                bucket.write_bytecode(f)
+            os.rename(tmp_name, self._get_cache_filename(bucket))
+        except (IOError, OSError):
+            try:
+                os.remove(tmp_name)
+            except OSError:
+                pass
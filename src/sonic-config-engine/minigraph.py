@@ -11,7 +11,6 @@ import ipaddr as ipaddress
 from collections import defaultdict
 
 from lxml import etree as ET
-from lxml.etree import QName
 
 from portconfig import get_port_config
 from sonic_py_common.multi_asic import get_asic_id_from_name
@@ -42,6 +41,33 @@ BACKEND_ASIC_SUB_ROLE = 'BackEnd'
 # Default Virtual Network Index (VNI)
 vni_default = 8000
 
+# Qualified tag names, built once per tag
+_qnames = {}
+
+# Parsed minigraph trees, keyed by file name and mtime
+_trees = {}
+
+def qn(namespace, tag):
+    """ Return the qualified name '{namespace}tag' of a tag """
+    try:
+        return _qnames[(namespace, tag)]
+    except KeyError:
+        name = _qnames[(namespace, tag)] = '{%s}%s' % (namespace, tag)
+        return name
+
+def parse_xml_root(filename):
+    """ Parse an xml file once per process and return its root element
+
+    The sub role of every BGP peer is looked up in the same minigraph, the
+    tree is shared instead of parsing the file again for each of them. The
+    tree must not be modified by its users.
+    """
+    key = (os.path.abspath(filename), os.stat(filename).st_mtime)
+    if key not in _trees:
+        parser = ET.XMLParser(remove_comments=True, huge_tree=True)
+        _trees[key] = ET.parse(filename, parser).getroot()
+    return _trees[key]
+
 ###############################################################################
 #
 # Minigraph parsing functions
@@ -66,21 +92,21 @@ def parse_device(device):
     deployment_id = None
 
     for node in device:
-        if node.tag == str(QName(ns, "Address")):
-            lo_prefix = node.find(str(QName(ns2, "IPPrefix"))).text
-        elif node.tag == str(QName(ns, "ManagementAddress")):
-            mgmt_prefix = node.find(str(QName(ns2, "IPPrefix"))).text
-        elif node.tag == str(QName(ns, "Hostname")):
+        if node.tag == qn(ns, "Address"):
+            lo_prefix = node.find(qn(ns2, "IPPrefix")).text
+        elif node.tag == qn(ns, "ManagementAddress"):
+            mgmt_prefix = node.find(qn(ns2, "IPPrefix")).text
+        elif node.tag == qn(ns, "Hostname"):
             name = node.text
-        elif node.tag == str(QName(ns, "HwSku")):
+        elif node.tag == qn(ns, "HwSku"):
             hwsku = node.text
-        elif node.tag == str(QName(ns, "DeploymentId")):
+        elif node.tag == qn(ns, "DeploymentId"):
             deployment_id = node.text
-        elif node.tag == str(QName(ns, "ElementType")):
+        elif node.tag == qn(ns, "ElementType"):
             d_type = node.text
 
-    if d_type is None and str(QName(ns3, "type")) in device.attrib:
-        d_type = device.attrib[str(QName(ns3, "type"))]
+    if d_type is None and qn(ns3, "type") in device.attrib:
+        d_type = device.attrib[qn(ns3, "type")]
 
     return (lo_prefix, mgmt_prefix, name, hwsku, d_type, deployment_id)
 
@@ -95,16 +121,16 @@ def parse_png(png, hname):
     console_ports = {}
     is_storage_device = False
     for child in png:
-        if child.tag == str(QName(ns, "DeviceInterfaceLinks")):
-            for link in child.findall(str(QName(ns, "DeviceLinkBase"))):
-                linktype = link.find(str(QName(ns, "ElementType"))).text
+        if child.tag == qn(ns, "DeviceInterfaceLinks"):
+            for link in child.findall(qn(ns, "DeviceLinkBase")):
+                linktype = link.find(qn(ns, "ElementType")).text
                 if linktype == "DeviceSerialLink":
-                    enddevice = link.find(str(QName(ns, "EndDevice"))).text
-                    endport = link.find(str(QName(ns, "EndPort"))).text
-                    startdevice = link.find(str(QName(ns, "StartDevice"))).text
-                    startport = link.find(str(QName(ns, "StartPort"))).text
-                    baudrate = link.find(str(QName(ns, "Bandwidth"))).text
-                    flowcontrol = 1 if link.find(str(QName(ns, "FlowControl"))) is not None and link.find(str(QName(ns, "FlowControl"))).text == 'true' else 0
+                    enddevice = link.find(qn(ns, "EndDevice")).text
+                    endport = link.find(qn(ns, "EndPort")).text
+                    startdevice = link.find(qn(ns, "StartDevice")).text
+                    startport = link.find(qn(ns, "StartPort")).text
+                    baudrate = link.find(qn(ns, "Bandwidth")).text
+                    flowcontrol = 1 if link.find(qn(ns, "FlowControl")) is not None and link.find(qn(ns, "FlowControl")).text == 'true' else 0
                     if enddevice.lower() == hname.lower():
                         console_ports[endport] = {
                             'remote_device': startdevice,
@@ -122,11 +148,11 @@ def parse_png(png, hname):
                 if linktype != "DeviceInterfaceLink" and linktype != "UnderlayInterfaceLink":
                     continue
 
-                enddevice = link.find(str(QName(ns, "EndDevice"))).text
-                endport = link.find(str(QName(ns, "EndPort"))).text
-                startdevice = link.find(str(QName(ns, "StartDevice"))).text
-                startport = link.find(str(QName(ns, "StartPort"))).text
-                bandwidth_node = link.find(str(QName(ns, "Bandwidth")))
+                enddevice = link.find(qn(ns, "EndDevice")).text
+                endport = link.find(qn(ns, "EndPort")).text
+                startdevice = link.find(qn(ns, "StartDevice")).text
+                startport = link.find(qn(ns, "StartPort")).text
+                bandwidth_node = link.find(qn(ns, "Bandwidth"))
                 bandwidth = bandwidth_node.text if bandwidth_node is not None else None
                 if enddevice.lower() == hname.lower():
                     if port_alias_map.has_key(endport):
@@ -141,8 +167,8 @@ def parse_png(png, hname):
                     if bandwidth:
                         port_speeds[startport] = bandwidth
 
-        if child.tag == str(QName(ns, "Devices")):
-            for device in child.findall(str(QName(ns, "Device"))):
+        if child.tag == qn(ns, "Devices"):
+            for device in child.findall(qn(ns, "Device")):
                 (lo_prefix, mgmt_prefix, name, hwsku, d_type, deployment_id) = parse_device(device)
                 device_data = {'lo_addr': lo_prefix, 'type': d_type, 'mgmt_addr': mgmt_prefix, 'hwsku': hwsku }
                 if deployment_id:
@@ -150,26 +176,26 @@ def parse_png(png, hname):
                 devices[name] = device_data
 
                 if name == hname:
-                    cluster = device.find(str(QName(ns, "ClusterName")))
+                    cluster = device.find(qn(ns, "ClusterName"))
 
                     if cluster != None and cluster.text != None and "str" in cluster.text.lower():
                         is_storage_device = True
 
-        if child.tag == str(QName(ns, "DeviceInterfaceLinks")):
-            for if_link in child.findall(str(QName(ns, 'DeviceLinkBase'))):
-                if str(QName(ns3, "type")) in if_link.attrib:
-                    link_type = if_link.attrib[str(QName(ns3, "type"))]
+        if child.tag == qn(ns, "DeviceInterfaceLinks"):
+            for if_link in child.findall(qn(ns, 'DeviceLinkBase')):
+                if qn(ns3, "type") in if_link.attrib:
+                    link_type = if_link.attrib[qn(ns3, "type")]
                     if link_type == 'DeviceSerialLink':
                         for node in if_link:
-                            if node.tag == str(QName(ns, "EndPort")):
+                            if node.tag == qn(ns, "EndPort"):
                                 console_port = node.text.split()[-1]
-                            elif node.tag == str(QName(ns, "EndDevice")):
+                            elif node.tag == qn(ns, "EndDevice"):
                                 console_dev = node.text
                     elif link_type == 'DeviceMgmtLink':
                         for node in if_link:
-                            if node.tag == str(QName(ns, "EndPort")):
+                            if node.tag == qn(ns, "EndPort"):
                                 mgmt_port = node.text.split()[-1]
-                            elif node.tag == str(QName(ns, "EndDevice")):
+                            elif node.tag == qn(ns, "EndDevice"):
                                 mgmt_dev = node.text
 
     return (neighbors, devices, console_dev, console_port, mgmt_dev, mgmt_port, port_speeds, console_ports, is_storage_device)
@@ -177,11 +203,11 @@ def parse_png(png, hname):
 def parse_asic_external_link(link, asic_name, hostname):
     neighbors = {}
     port_speeds = {}
-    enddevice = link.find(str(QName(ns, "EndDevice"))).text
-    endport = link.find(str(QName(ns, "EndPort"))).text
-    startdevice = link.find(str(QName(ns, "StartDevice"))).text
-    startport = link.find(str(QName(ns, "StartPort"))).text
-    bandwidth_node = link.find(str(QName(ns, "Bandwidth")))
+    enddevice = link.find(qn(ns, "EndDevice")).text
+    endport = link.find(qn(ns, "EndPort")).text
+    startdevice = link.find(qn(ns, "StartDevice")).text
+    startport = link.find(qn(ns, "StartPort")).text
+    bandwidth_node = link.find(qn(ns, "Bandwidth"))
     bandwidth = bandwidth_node.text if bandwidth_node is not None else None
     # if chassis internal is false, the interface name will be
     # interface alias which should be converted to asic port name
@@ -205,11 +231,11 @@ def parse_asic_external_link(link, asic_name, hostname):
 def parse_asic_internal_link(link, asic_name, hostname):
     neighbors = {}
     port_speeds = {}
-    enddevice = link.find(str(QName(ns, "EndDevice"))).text
-    endport = link.find(str(QName(ns, "EndPort"))).text
-    startdevice = link.find(str(QName(ns, "StartDevice"))).text
-    startport = link.find(str(QName(ns, "StartPort"))).text
-    bandwidth_node = link.find(str(QName(ns, "Bandwidth")))
+    enddevice = link.find(qn(ns, "EndDevice")).text
+    endport = link.find(qn(ns, "EndPort")).text
+    startdevice = link.find(qn(ns, "StartDevice")).text
+    startport = link.find(qn(ns, "StartPort")).text
+    bandwidth_node = link.find(qn(ns, "Bandwidth"))
     bandwidth = bandwidth_node.text if bandwidth_node is not None else None
     if ((enddevice.lower() == asic_name.lower()) and
             (startdevice.lower() != hostname.lower())):
@@ -233,13 +259,13 @@ def parse_asic_png(png, asic_name, hostname):
     devices = {}
     port_speeds = {}
     for child in png:
-        if child.tag == str(QName(ns, "DeviceInterfaceLinks")):
-            for link in child.findall(str(QName(ns, "DeviceLinkBase"))):
+        if child.tag == qn(ns, "DeviceInterfaceLinks"):
+            for link in child.findall(qn(ns, "DeviceLinkBase")):
                 # Chassis internal node is used in multi-asic device or chassis minigraph
                 # where the minigraph will contain the internal asic connectivity and
                 # external neighbor information. The ChassisInternal node will be used to
                 # determine if the link is internal to the device or chassis.
-                chassis_internal_node = link.find(str(QName(ns, "ChassisInternal")))
+                chassis_internal_node = link.find(qn(ns, "ChassisInternal"))
                 chassis_internal = chassis_internal_node.text if chassis_internal_node is not None else "false"
 
                 # If the link is an external link include the external neighbor
@@ -253,8 +279,8 @@ def parse_asic_png(png, asic_name, hostname):
                     neighbors.update(int_neighbors)
                     port_speeds.update(int_port_speeds)
 
-        if child.tag == str(QName(ns, "Devices")):
-            for device in child.findall(str(QName(ns, "Device"))):
+        if child.tag == qn(ns, "Devices"):
+            for device in child.findall(qn(ns, "Device")):
                 (lo_prefix, mgmt_prefix, name, hwsku, d_type, deployment_id) = parse_device(device)
                 device_data = {'lo_addr': lo_prefix, 'type': d_type, 'mgmt_addr': mgmt_prefix, 'hwsku': hwsku }
                 if deployment_id:
@@ -263,11 +289,11 @@ def parse_asic_png(png, asic_name, hostname):
     return (neighbors, devices, port_speeds)
 
 def parse_loopback_intf(child):
-    lointfs = child.find(str(QName(ns, "LoopbackIPInterfaces")))
+    lointfs = child.find(qn(ns, "LoopbackIPInterfaces"))
     lo_intfs = {}
-    for lointf in lointfs.findall(str(QName(ns1, "LoopbackIPInterface"))):
-        intfname = lointf.find(str(QName(ns, "AttachTo"))).text
-        ipprefix = lointf.find(str(QName(ns1, "PrefixStr"))).text
+    for lointf in lointfs.findall(qn(ns1, "LoopbackIPInterface")):
+        intfname = lointf.find(qn(ns, "AttachTo")).text
+        ipprefix = lointf.find(qn(ns1, "PrefixStr")).text
         lo_intfs[(intfname, ipprefix)] = {}
     return lo_intfs
 
@@ -280,86 +306,86 @@ def parse_dpg(dpg, hname):
             There is just one aclintf node in the minigraph
             Get the aclintfs node first.
         """
-        if aclintfs is None and child.find(str(QName(ns, "AclInterfaces"))) is not None:
-            aclintfs = child.find(str(QName(ns, "AclInterfaces")))
+        if aclintfs is None and child.find(qn(ns, "AclInterfaces")) is not None:
+            aclintfs = child.find(qn(ns, "AclInterfaces"))
         """
             In Multi-NPU platforms the mgmt intfs are defined only for the host not for individual asic
             There is just one mgmtintf node in the minigraph
             Get the mgmtintfs node first. We need mgmt intf to get mgmt ip in per asic dockers.
         """
-        if mgmtintfs is None and child.find(str(QName(ns, "ManagementIPInterfaces"))) is not None:
-            mgmtintfs = child.find(str(QName(ns, "ManagementIPInterfaces")))
-        hostname = child.find(str(QName(ns, "Hostname")))
+        if mgmtintfs is None and child.find(qn(ns, "ManagementIPInterfaces")) is not None:
+            mgmtintfs = child.find(qn(ns, "ManagementIPInterfaces"))
+        hostname = child.find(qn(ns, "Hostname"))
         if hostname.text.lower() != hname.lower():
             continue
 
         vni = vni_default
-        vni_element = child.find(str(QName(ns, "VNI")))
+        vni_element = child.find(qn(ns, "VNI"))
         if vni_element != None:
             if vni_element.text.isdigit():
                 vni = int(vni_element.text)
             else:
                 print >> sys.stderr, "VNI must be an integer (use default VNI %d instead)" % vni_default 
 
-        ipintfs = child.find(str(QName(ns, "IPInterfaces")))
+        ipintfs = child.find(qn(ns, "IPInterfaces"))
         intfs = {}
-        for ipintf in ipintfs.findall(str(QName(ns, "IPInterface"))):
-            intfalias = ipintf.find(str(QName(ns, "AttachTo"))).text
+        for ipintf in ipintfs.findall(qn(ns, "IPInterface")):
+            intfalias = ipintf.find(qn(ns, "AttachTo")).text
             intfname = port_alias_map.get(intfalias, intfalias)
-            ipprefix = ipintf.find(str(QName(ns, "Prefix"))).text
+            ipprefix = ipintf.find(qn(ns, "Prefix")).text
             intfs[(intfname, ipprefix)] = {}
 
         lo_intfs =  parse_loopback_intf(child)
 
-        mvrfConfigs = child.find(str(QName(ns, "MgmtVrfConfigs")))
+        mvrfConfigs = child.find(qn(ns, "MgmtVrfConfigs"))
         mvrf = {}
         if mvrfConfigs != None:
-            mv = mvrfConfigs.find(str(QName(ns1, "MgmtVrfGlobal")))
+            mv = mvrfConfigs.find(qn(ns1, "MgmtVrfGlobal"))
             if mv != None:
-                mvrf_en_flag = mv.find(str(QName(ns, "mgmtVrfEnabled"))).text
+                mvrf_en_flag = mv.find(qn(ns, "mgmtVrfEnabled")).text
                 mvrf["vrf_global"] = {"mgmtVrfEnabled": mvrf_en_flag}
 
         mgmt_intf = {}
-        for mgmtintf in mgmtintfs.findall(str(QName(ns1, "ManagementIPInterface"))):
-            intfname = mgmtintf.find(str(QName(ns, "AttachTo"))).text
-            ipprefix = mgmtintf.find(str(QName(ns1, "PrefixStr"))).text
+        for mgmtintf in mgmtintfs.findall(qn(ns1, "ManagementIPInterface")):
+            intfname = mgmtintf.find(qn(ns, "AttachTo")).text
+            ipprefix = mgmtintf.find(qn(ns1, "PrefixStr")).text
             mgmtipn = ipaddress.IPNetwork(ipprefix)
             gwaddr = ipaddress.IPAddress(int(mgmtipn.network) + 1)
             mgmt_intf[(intfname, ipprefix)] = {'gwaddr': gwaddr}
 
-        pcintfs = child.find(str(QName(ns, "PortChannelInterfaces")))
+        pcintfs = child.find(qn(ns, "PortChannelInterfaces"))
         pc_intfs = []
         pcs = {}
         pc_members = {}
         intfs_inpc = [] # List to hold all the LAG member interfaces 
-        for pcintf in pcintfs.findall(str(QName(ns, "PortChannel"))):
-            pcintfname = pcintf.find(str(QName(ns, "Name"))).text
-            pcintfmbr = pcintf.find(str(QName(ns, "AttachTo"))).text
+        for pcintf in pcintfs.findall(qn(ns, "PortChannel")):
+            pcintfname = pcintf.find(qn(ns, "Name")).text
+            pcintfmbr = pcintf.find(qn(ns, "AttachTo")).text
             pcmbr_list = pcintfmbr.split(';')
             pc_intfs.append(pcintfname)
             for i, member in enumerate(pcmbr_list):
                 pcmbr_list[i] = port_alias_map.get(member, member)
                 intfs_inpc.append(pcmbr_list[i])
                 pc_members[(pcintfname, pcmbr_list[i])] = {'NULL': 'NULL'}
-            if pcintf.find(str(QName(ns, "Fallback"))) != None:
-                pcs[pcintfname] = {'members': pcmbr_list, 'fallback': pcintf.find(str(QName(ns, "Fallback"))).text, 'min_links': str(int(math.ceil(len() * 0.75)))}
+            if pcintf.find(qn(ns, "Fallback")) != None:
+                pcs[pcintfname] = {'members': pcmbr_list, 'fallback': pcintf.find(qn(ns, "Fallback")).text, 'min_links': str(int(math.ceil(len() * 0.75)))}
             else:
                 pcs[pcintfname] = {'members': pcmbr_list, 'min_links': str(int(math.ceil(len(pcmbr_list) * 0.75)))}
 
-        vlanintfs = child.find(str(QName(ns, "VlanInterfaces")))
+        vlanintfs = child.find(qn(ns, "VlanInterfaces"))
         vlans = {}
         vlan_members = {}
         intf_vlan_mbr = defaultdict(list)
-        for vintf in vlanintfs.findall(str(QName(ns, "VlanInterface"))):
-            vlanid = vintf.find(str(QName(ns, "VlanID"))).text
-            vintfmbr = vintf.find(str(QName(ns, "AttachTo"))).text
+        for vintf in vlanintfs.findall(qn(ns, "VlanInterface")):
+            vlanid = vintf.find(qn(ns, "VlanID")).text
+            vintfmbr = vintf.find(qn(ns, "AttachTo")).text
             vmbr_list = vintfmbr.split(';')
             for i, member in enumerate(vmbr_list):
                 intf_vlan_mbr[member].append(vlanid)
-        for vintf in vlanintfs.findall(str(QName(ns, "VlanInterface"))):
-            vintfname = vintf.find(str(QName(ns, "Name"))).text
-            vlanid = vintf.find(str(QName(ns, "VlanID"))).text
-            vintfmbr = vintf.find(str(QName(ns, "AttachTo"))).text
+        for vintf in vlanintfs.findall(qn(ns, "VlanInterface")):
+            vintfname = vintf.find(qn(ns, "Name")).text
+            vlanid = vintf.find(qn(ns, "VlanID")).text
+            vintfmbr = vintf.find(qn(ns, "AttachTo")).text
             vmbr_list = vintfmbr.split(';')
             for i, member in enumerate(vmbr_list):
                 vmbr_list[i] = port_alias_map.get(member, member)
@@ -373,7 +399,7 @@ def parse_dpg(dpg, hname):
 
             # If this VLAN requires a DHCP relay agent, it will contain a <DhcpRelays> element
             # containing a list of DHCP server IPs
-            vintf_node = vintf.find(str(QName(ns, "DhcpRelays")))
+            vintf_node = vintf.find(qn(ns, "DhcpRelays"))
             if vintf_node is not None and vintf_node.text is not None:
                 vintfdhcpservers = vintf_node.text
                 vdhcpserver_list = vintfdhcpservers.split(';')
@@ -385,16 +411,16 @@ def parse_dpg(dpg, hname):
             vlans[sonic_vlan_name] = vlan_attributes
 
         acls = {}
-        for aclintf in aclintfs.findall(str(QName(ns, "AclInterface"))):
-            if aclintf.find(str(QName(ns, "InAcl"))) is not None:
-                aclname = aclintf.find(str(QName(ns, "InAcl"))).text.upper().replace(" ", "_").replace("-", "_")
+        for aclintf in aclintfs.findall(qn(ns, "AclInterface")):
+            if aclintf.find(qn(ns, "InAcl")) is not None:
+                aclname = aclintf.find(qn(ns, "InAcl")).text.upper().replace(" ", "_").replace("-", "_")
                 stage = "ingress"
-            elif aclintf.find(str(QName(ns, "OutAcl"))) is not None:
-                aclname = aclintf.find(str(QName(ns, "OutAcl"))).text.upper().replace(" ", "_").replace("-", "_")
+            elif aclintf.find(qn(ns, "OutAcl")) is not None:
+                aclname = aclintf.find(qn(ns, "OutAcl")).text.upper().replace(" ", "_").replace("-", "_")
                 stage = "egress"
             else:
                 sys.exit("Error: 'AclInterface' must contain either an 'InAcl' or 'OutAcl' subelement.")
-            aclattach = aclintf.find(str(QName(ns, "AttachTo"))).text.split(';')
+            aclattach = aclintf.find(qn(ns, "AttachTo")).text.split(';')
             acl_intfs = []
             is_mirror = False
             is_mirror_v6 = False
@@ -456,7 +482,7 @@ def parse_dpg(dpg, hname):
             else:
                 # This ACL has no interfaces to attach to -- consider this a control plane ACL
                 try:
-                    aclservice = aclintf.find(str(QName(ns, "Type"))).text
+                    aclservice = aclintf.find(qn(ns, "Type")).text
 
                     # If we already have an ACL with this name and this ACL is bound to a different service,
                     # append the service to our list of services
@@ -480,7 +506,7 @@ def parse_dpg(dpg, hname):
 
 def parse_host_loopback(dpg, hname):
     for child in dpg:
-        hostname = child.find(str(QName(ns, "Hostname")))
+        hostname = child.find(qn(ns, "Hostname"))
         if hostname.text.lower() != hname.lower():
             continue
         lo_intfs = parse_loopback_intf(child)
@@ -493,22 +519,22 @@ def parse_cpg(cpg, hname, local_devices=[]):
     bgp_peers_with_range = {}
     for child in cpg:
         tag = child.tag
-        if tag == str(QName(ns, "PeeringSessions")):
-            for session in child.findall(str(QName(ns, "BGPSession"))):
-                start_router = session.find(str(QName(ns, "StartRouter"))).text
-                start_peer = session.find(str(QName(ns, "StartPeer"))).text
-                end_router = session.find(str(QName(ns, "EndRouter"))).text
-                end_peer = session.find(str(QName(ns, "EndPeer"))).text
-                rrclient = 1 if session.find(str(QName(ns, "RRClient"))) is not None else 0
-                if session.find(str(QName(ns, "HoldTime"))) is not None:
-                    holdtime = session.find(str(QName(ns, "HoldTime"))).text
+        if tag == qn(ns, "PeeringSessions"):
+            for session in child.findall(qn(ns, "BGPSession")):
+                start_router = session.find(qn(ns, "StartRouter")).text
+                start_peer = session.find(qn(ns, "StartPeer")).text
+                end_router = session.find(qn(ns, "EndRouter")).text
+                end_peer = session.find(qn(ns, "EndPeer")).text
+                rrclient = 1 if session.find(qn(ns, "RRClient")) is not None else 0
+                if session.find(qn(ns, "HoldTime")) is not None:
+                    holdtime = session.find(qn(ns, "HoldTime")).text
                 else:
                     holdtime = 180
-                if session.find(str(QName(ns, "KeepAliveTime"))) is not None:
-                    keepalive = session.find(str(QName(ns, "KeepAliveTime"))).text
+                if session.find(qn(ns, "KeepAliveTime")) is not None:
+                    keepalive = session.find(qn(ns, "KeepAliveTime")).text
                 else:
                     keepalive = 60
-                nhopself = 1 if session.find(str(QName(ns, "NextHopSelf"))) is not None else 0
+                nhopself = 1 if session.find(qn(ns, "NextHopSelf")) is not None else 0
 
                 if end_router.lower() == hname.lower():
                     if end_router.lower() in local_devices and start_router.lower() in local_devices:
@@ -550,27 +576,27 @@ def parse_cpg(cpg, hname, local_devices=[]):
                             'keepalive': keepalive,
                             'nhopself': nhopself
                         }
-        elif child.tag == str(QName(ns, "Routers")):
-            for router in child.findall(str(QName(ns1, "BGPRouterDeclaration"))):
-                asn = router.find(str(QName(ns1, "ASN"))).text
-                hostname = router.find(str(QName(ns1, "Hostname"))).text
+        elif child.tag == qn(ns, "Routers"):
+            for router in child.findall(qn(ns1, "BGPRouterDeclaration")):
+                asn = router.find(qn(ns1, "ASN")).text
+                hostname = router.find(qn(ns1, "Hostname")).text
                 if hostname.lower() == hname.lower():
                     myasn = asn
-                    peers = router.find(str(QName(ns1, "Peers")))
-                    for bgpPeer in peers.findall(str(QName(ns, "BGPPeer"))):
-                        addr = bgpPeer.find(str(QName(ns, "Address"))).text
-                        if bgpPeer.find(str(QName(ns1, "PeersRange"))) is not None: # FIXME: is better to check for type BGPPeerPassive
-                            name = bgpPeer.find(str(QName(ns1, "Name"))).text
-                            ip_range = bgpPeer.find(str(QName(ns1, "PeersRange"))).text
+                    peers = router.find(qn(ns1, "Peers"))
+                    for bgpPeer in peers.findall(qn(ns, "BGPPeer")):
+                        addr = bgpPeer.find(qn(ns, "Address")).text
+                        if bgpPeer.find(qn(ns1, "PeersRange")) is not None: # FIXME: is better to check for type BGPPeerPassive
+                            name = bgpPeer.find(qn(ns1, "Name")).text
+                            ip_range = bgpPeer.find(qn(ns1, "PeersRange")).text
                             ip_range_group = ip_range.split(';') if ip_range and ip_range != "" else []
                             bgp_peers_with_range[name] = {
                                 'name': name,
                                 'ip_range': ip_range_group
                             }
-                            if bgpPeer.find(str(QName(ns, "Address"))) is not None:
-                                bgp_peers_with_range[name]['src_address'] = bgpPeer.find(str(QName(ns, "Address"))).text
-                            if bgpPeer.find(str(QName(ns1, "PeerAsn"))) is not None:
-                                bgp_peers_with_range[name]['peer_asn'] = bgpPeer.find(str(QName(ns1, "PeerAsn"))).text
+                            if bgpPeer.find(qn(ns, "Address")) is not None:
+                                bgp_peers_with_range[name]['src_address'] = bgpPeer.find(qn(ns, "Address")).text
+                            if bgpPeer.find(qn(ns1, "PeerAsn")) is not None:
+                                bgp_peers_with_range[name]['peer_asn'] = bgpPeer.find(qn(ns1, "PeerAsn")).text
                 else:
                     for peer in bgp_sessions:
                         bgp_session = bgp_sessions[peer]
@@ -598,13 +624,13 @@ def parse_meta(meta, hname):
     deployment_id = None
     region = None
     cloudtype = None
-    device_metas = meta.find(str(QName(ns, "Devices")))
-    for device in device_metas.findall(str(QName(ns1, "DeviceMetadata"))):
-        if device.find(str(QName(ns1, "Name"))).text.lower() == hname.lower():
-            properties = device.find(str(QName(ns1, "Properties")))
-            for device_property in properties.findall(str(QName(ns1, "DeviceProperty"))):
-                name = device_property.find(str(QName(ns1, "Name"))).text
-                value = device_property.find(str(QName(ns1, "Value"))).text
+    device_metas = meta.find(qn(ns, "Devices"))
+    for device in device_metas.findall(qn(ns1, "DeviceMetadata")):
+        if device.find(qn(ns1, "Name")).text.lower() == hname.lower():
+            properties = device.find(qn(ns1, "Properties"))
+            for device_property in properties.findall(qn(ns1, "DeviceProperty")):
+                name = device_property.find(qn(ns1, "Name")).text
+                value = device_property.find(qn(ns1, "Value")).text
                 value_group = value.strip().split(';') if value and value != "" else []
                 if name == "DhcpResources":
                     dhcp_servers = value_group
@@ -628,14 +654,14 @@ def parse_meta(meta, hname):
 
 
 def parse_linkmeta(meta, hname):
-    link = meta.find(str(QName(ns, "Link")))
+    link = meta.find(qn(ns, "Link"))
     linkmetas = {}
-    for linkmeta in link.findall(str(QName(ns1, "LinkMetadata"))):
+    for linkmeta in link.findall(qn(ns1, "LinkMetadata")):
         port = None
         fec_disabled = None
 
         # Sample: ARISTA05T1:Ethernet1/33;switch-t0:fortyGigE0/4
-        key = linkmeta.find(str(QName(ns1, "Key"))).text
+        key = linkmeta.find(qn(ns1, "Key")).text
         endpoints = key.split(';')
         for endpoint in endpoints:
             t = endpoint.split(':')
@@ -646,10 +672,10 @@ def parse_linkmeta(meta, hname):
             # Cannot find a matching hname, something went wrong
             continue
 
-        properties = linkmeta.find(str(QName(ns1, "Properties")))
-        for device_property in properties.findall(str(QName(ns1, "DeviceProperty"))):
-            name = device_property.find(str(QName(ns1, "Name"))).text
-            value = device_property.find(str(QName(ns1, "Value"))).text
+        properties = linkmeta.find(qn(ns1, "Properties"))
+        for device_property in properties.findall(qn(ns1, "DeviceProperty")):
+            name = device_property.find(qn(ns1, "Name")).text
+            value = device_property.find(qn(ns1, "Value")).text
             if name == "FECDisabled":
                 fec_disabled = value
 
@@ -661,13 +687,13 @@ def parse_linkmeta(meta, hname):
 
 def parse_asic_meta(meta, hname):
     sub_role = None
-    device_metas = meta.find(str(QName(ns, "Devices")))
-    for device in device_metas.findall(str(QName(ns1, "DeviceMetadata"))):
-        if device.find(str(QName(ns1, "Name"))).text.lower() == hname.lower():
-            properties = device.find(str(QName(ns1, "Properties")))
-            for device_property in properties.findall(str(QName(ns1, "DeviceProperty"))):
-                name = device_property.find(str(QName(ns1, "Name"))).text
-                value = device_property.find(str(QName(ns1, "Value"))).text
+    device_metas = meta.find(qn(ns, "Devices"))
+    for device in device_metas.findall(qn(ns1, "DeviceMetadata")):
+        if device.find(qn(ns1, "Name")).text.lower() == hname.lower():
+            properties = device.find(qn(ns1, "Properties"))
+            for device_property in properties.findall(qn(ns1, "DeviceProperty")):
+                name = device_property.find(qn(ns1, "Name")).text
+                value = device_property.find(qn(ns1, "Value")).text
                 if name == "SubRole":
                     sub_role = value
     return sub_role
@@ -675,15 +701,15 @@ def parse_asic_meta(meta, hname):
 def parse_deviceinfo(meta, hwsku):
     port_speeds = {}
     port_descriptions = {}
-    for device_info in meta.findall(str(QName(ns, "DeviceInfo"))):
-        dev_sku = device_info.find(str(QName(ns, "HwSku"))).text
+    for device_info in meta.findall(qn(ns, "DeviceInfo")):
+        dev_sku = device_info.find(qn(ns, "HwSku")).text
         if dev_sku == hwsku:
-            interfaces = device_info.find(str(QName(ns, "EthernetInterfaces"))).findall(str(QName(ns1, "EthernetInterface")))
-            interfaces = interfaces + device_info.find(str(QName(ns, "ManagementInterfaces"))).findall(str(QName(ns1, "ManagementInterface")))
+            interfaces = device_info.find(qn(ns, "EthernetInterfaces")).findall(qn(ns1, "EthernetInterface"))
+            interfaces = interfaces + device_info.find(qn(ns, "ManagementInterfaces")).findall(qn(ns1, "ManagementInterface"))
             for interface in interfaces:
-                alias = interface.find(str(QName(ns, "InterfaceName"))).text
-                speed = interface.find(str(QName(ns, "Speed"))).text
-                desc  = interface.find(str(QName(ns, "Description")))
+                alias = interface.find(qn(ns, "InterfaceName")).text
+                speed = interface.find(qn(ns, "Speed")).text
+                desc  = interface.find(qn(ns, "Description"))
                 if desc != None:
                     port_descriptions[port_alias_map.get(alias, alias)] = desc.text
                 port_speeds[port_alias_map.get(alias, alias)] = speed
@@ -853,7 +879,7 @@ def parse_xml(filename, platform=None, port_config_file=None, asic_name=None):
     asic_name -- asic name; to parse multi-asic device minigraph to 
     generate asic specific configuration.
      """
-    root = ET.parse(filename).getroot()
+    root = parse_xml_root(filename)
 
     u_neighbors = None
     u_devices = None
@@ -899,15 +925,15 @@ def parse_xml(filename, platform=None, port_config_file=None, asic_name=None):
     else:
         asic_id = None
 
-    hwsku_qn = QName(ns, "HwSku")
-    hostname_qn = QName(ns, "Hostname")
-    docker_routing_config_mode_qn = QName(ns, "DockerRoutingConfigMode")
+    hwsku_qn = qn(ns, "HwSku")
+    hostname_qn = qn(ns, "Hostname")
+    docker_routing_config_mode_qn = qn(ns, "DockerRoutingConfigMode")
     for child in root:
-        if child.tag == str(hwsku_qn):
+        if child.tag == hwsku_qn:
             hwsku = child.text
-        if child.tag == str(hostname_qn):
+        if child.tag == hostname_qn:
             hostname = child.text
-        if child.tag == str(docker_routing_config_mode_qn):
+        if child.tag == docker_routing_config_mode_qn:
             docker_routing_config_mode = child.text
 
     (ports, alias_map, alias_asic_map) = get_port_config(hwsku=hwsku, platform=platform, port_config_file=port_config_file, asic=asic_id)
@@ -919,33 +945,33 @@ def parse_xml(filename, platform=None, port_config_file=None, asic_name=None):
 
     for child in root:
         if asic_name is None:
-            if child.tag == str(QName(ns, "DpgDec")):
+            if child.tag == qn(ns, "DpgDec"):
                 (intfs, lo_intfs, mvrf, mgmt_intf, vlans, vlan_members, pcs, pc_members, acls, vni) = parse_dpg(child, hostname)
-            elif child.tag == str(QName(ns, "CpgDec")):
+            elif child.tag == qn(ns, "CpgDec"):
                 (bgp_sessions, bgp_internal_sessions, bgp_asn, bgp_peers_with_range, bgp_monitors) = parse_cpg(child, hostname)
-            elif child.tag == str(QName(ns, "PngDec")):
+            elif child.tag == qn(ns, "PngDec"):
                 (neighbors, devices, console_dev, console_port, mgmt_dev, mgmt_port, port_speed_png, console_ports, is_storage_device) = parse_png(child, hostname)
-            elif child.tag == str(QName(ns, "UngDec")):
+            elif child.tag == qn(ns, "UngDec"):
                 (u_neighbors, u_devices, _, _, _, _, _, _) = parse_png(child, hostname)
-            elif child.tag == str(QName(ns, "MetadataDeclaration")):
+            elif child.tag == qn(ns, "MetadataDeclaration"):
                 (syslog_servers, dhcp_servers, ntp_servers, tacacs_servers, mgmt_routes, erspan_dst, deployment_id, region, cloudtype) = parse_meta(child, hostname)
-            elif child.tag == str(QName(ns, "LinkMetadataDeclaration")):
+            elif child.tag == qn(ns, "LinkMetadataDeclaration"):
                 linkmetas = parse_linkmeta(child, hostname)
-            elif child.tag == str(QName(ns, "DeviceInfos")):
+            elif child.tag == qn(ns, "DeviceInfos"):
                 (port_speeds_default, port_descriptions) = parse_deviceinfo(child, hwsku)
         else:
-            if child.tag == str(QName(ns, "DpgDec")):
+            if child.tag == qn(ns, "DpgDec"):
                 (intfs, lo_intfs, mvrf, mgmt_intf, vlans, vlan_members, pcs, pc_members, acls, vni) = parse_dpg(child, asic_name)
                 host_lo_intfs = parse_host_loopback(child, hostname)
-            elif child.tag == str(QName(ns, "CpgDec")):
+            elif child.tag == qn(ns, "CpgDec"):
                 (bgp_sessions, bgp_internal_sessions, bgp_asn, bgp_peers_with_range, bgp_monitors) = parse_cpg(child, asic_name, local_devices)
-            elif child.tag == str(QName(ns, "PngDec")):
+            elif child.tag == qn(ns, "PngDec"):
                 (neighbors, devices, port_speed_png) = parse_asic_png(child, asic_name, hostname)
-            elif child.tag == str(QName(ns, "MetadataDeclaration")):
+            elif child.tag == qn(ns, "MetadataDeclaration"):
                 (sub_role) = parse_asic_meta(child, asic_name)
-            elif child.tag == str(QName(ns, "LinkMetadataDeclaration")):
+            elif child.tag == qn(ns, "LinkMetadataDeclaration"):
                 linkmetas = parse_linkmeta(child, hostname)
-            elif child.tag == str(QName(ns, "DeviceInfos")):
+            elif child.tag == qn(ns, "DeviceInfos"):
                 (port_speeds_default, port_descriptions) = parse_deviceinfo(child, hwsku)
 
     # set the host device type in asic metadata also
@@ -1226,7 +1252,7 @@ def parse_xml(filename, platform=None, port_config_file=None, asic_name=None):
 
 
 def parse_device_desc_xml(filename):
-    root = ET.parse(filename).getroot()
+    root = parse_xml_root(filename)
     (lo_prefix, mgmt_prefix, hostname, hwsku, d_type, _) = parse_device(root)
 
     results = {}
@@ -1247,9 +1273,9 @@ def parse_device_desc_xml(filename):
 def parse_asic_sub_role(filename, asic_name):
     if not os.path.isfile(filename):
         return None
-    root = ET.parse(filename).getroot()
+    root = parse_xml_root(filename)
     for child in root:
-        if child.tag == str(QName(ns, "MetadataDeclaration")):
+        if child.tag == qn(ns, "MetadataDeclaration"):
             sub_role = parse_asic_meta(child, asic_name)
             return sub_role
 
@@ -1257,10 +1283,10 @@ def parse_asic_meta_get_devices(root):
     local_devices = []
 
     for child in root:
-        if child.tag == str(QName(ns, "MetadataDeclaration")):
-            device_metas = child.find(str(QName(ns, "Devices")))
-            for device in device_metas.findall(str(QName(ns1, "DeviceMetadata"))):
-                name = device.find(str(QName(ns1, "Name"))).text.lower()
+        if child.tag == qn(ns, "MetadataDeclaration"):
+            device_metas = child.find(qn(ns, "Devices"))
+            for device in device_metas.findall(qn(ns1, "DeviceMetadata")):
+                name = device.find(qn(ns1, "Name")).text.lower()
                 local_devices.append(name)
 
     return local_devices
@@ -0,0 +1,400 @@
+"""
+Fast loading of OpenConfig ACL JSON into CONFIG_DB ACL_RULE entries.
+
+openconfig_acl.py is the pyangbind binding of openconfig-acl and
+sonic-acl-extension. pybindJSON builds a YANG object for every container and
+leaf of every rule, and runs each leaf through its restriction classes, so a
+file with tens of thousands of rules takes minutes and hundreds of MB to load.
+
+This module checks the JSON against a table of the same leaf restrictions,
+compiled once at import, and converts each acl-entry to its ACL_RULE fields
+while it walks the document. With strict=True the document is first loaded
+through pybindJSON and the binding, as before, and then converted the same way.
+"""
+
+import json
+import re
+
+try:
+    string_types = (str, unicode)
+except NameError:
+    string_types = (str,)
+
+MAX_PRIORITY = 10000
+MIN_PRIORITY = 1
+
+IP_PROTOCOLS = {
+    'IP_ICMP': 1,
+    'IP_IGMP': 2,
+    'IP_TCP': 6,
+    'IP_UDP': 17,
+    'IP_RSVP': 46,
+    'IP_GRE': 47,
+    'IP_AUTH': 51,
+    'IP_PIM': 103,
+    'IP_L2TP': 115,
+}
+
+ETHERTYPES = {
+    'ETHERTYPE_IPV4': 0x0800,
+    'ETHERTYPE_ARP': 0x0806,
+    'ETHERTYPE_VLAN': 0x8100,
+    'ETHERTYPE_IPV6': 0x86DD,
+    'ETHERTYPE_MPLS': 0x8847,
+    'ETHERTYPE_LLDP': 0x88CC,
+    'ETHERTYPE_ROCE': 0x8915,
+}
+
+TCP_FLAGS = {
+    'TCP_FIN': 0x01,
+    'TCP_SYN': 0x02,
+    'TCP_RST': 0x04,
+    'TCP_PSH': 0x08,
+    'TCP_ACK': 0x10,
+    'TCP_URG': 0x20,
+    'TCP_ECE': 0x40,
+    'TCP_CWR': 0x80,
+}
+
+FORWARDING_ACTIONS = ('ACCEPT', 'DROP', 'REJECT')
+LOG_ACTIONS = ('LOG_SYSLOG', 'LOG_NONE')
+
+MIRROR_TABLE_TYPES = ('MIRROR', 'MIRRORV6', 'MIRROR_DSCP')
+CTRLPLANE_TABLE_TYPES = ('CTRLPLANE',)
+IPV6_TABLE_TYPES = ('L3V6', 'MIRRORV6')
+
+# Patterns of the inet types, as in the binding
+IPV4_PREFIX_RE = re.compile(r'^(([0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])\.){3}'
+                            r'([0-9]|[1-9][0-9]|1[0-9][0-9]|2[0-4][0-9]|25[0-5])/(([0-9])|([1-2][0-9])|(3[0-2]))$')
+IPV6_PREFIX_RE = re.compile(r'^((:|[0-9a-fA-F]{0,4}):)([0-9a-fA-F]{0,4}:){0,5}((([0-9a-fA-F]{0,4}:)?(:|[0-9a-fA-F]{0,4}))|'
+                            r'(((25[0-5]|2[0-4][0-9]|[01]?[0-9]?[0-9])\.){3}(25[0-5]|2[0-4][0-9]|[01]?[0-9]?[0-9])))'
+                            r'(/(([0-9])|([0-9]{2})|(1[0-1][0-9])|(12[0-8])))$')
+MAC_RE = re.compile(r'^[0-9a-fA-F]{2}(:[0-9a-fA-F]{2}){5}$')
+PORT_RANGE_RE = re.compile(r'^(6[0-5][0-5][0-3][0-5]|[0-5]?[0-9]?[0-9]?[0-9]?[0-9]?)\.\.'
+                           r'(6[0-5][0-5][0-3][0-5]|[0-5]?[0-9]?[0-9]?[0-9]?[0-9]?)$')
+
+
+class AclJsonError(ValueError):
+    """
+    The document does not match the openconfig-acl model. path is the JSON
+    path of the offending node.
+    """
+    def __init__(self, path, message):
+        super(AclJsonError, self).__init__('%s: %s' % ('/'.join(path), message))
+        self.path = path
+
+
+def _identity(names):
+    def check(value):
+        if isinstance(value, string_types):
+            name = value.rsplit(':', 1)[-1]
+            if name in names:
+                return name
+        raise ValueError('must be one of %s' % ', '.join(sorted(names)))
+    return check
+
+
+def _uint(low, high, null=False, identities=None):
+    def check(value):
+        if null and value == 'null':
+            return None
+        if identities is not None and isinstance(value, string_types) and not value.isdigit():
+            return _identity(identities)(value)
+        if not isinstance(value, bool):
+            try:
+                number = int(value)
+            except (TypeError, ValueError):
+                number = None
+            if number is not None and low <= number <= high:
+                return number
+        raise ValueError('must be an integer in %d..%d' % (low, high))
+    return check
+
+
+def _pattern(*regexes):
+    def check(value):
+        if isinstance(value, string_types):
+            for regex in regexes:
+                if regex.match(value):
+                    return value
+        raise ValueError('%r does not match the type pattern' % (value,))
+    return check
+
+
+def _string(value):
+    if isinstance(value, string_types):
+        return value
+    raise ValueError('must be a string')
+
+
+def _port(value):
+    if value == 'ANY':
+        return None
+    if isinstance(value, string_types) and PORT_RANGE_RE.match(value):
+        return value
+    return _uint(0, 65535)(value)
+
+
+def _tcp_flags(value):
+    if not isinstance(value, list):
+        raise ValueError('must be a list')
+    check = _identity(TCP_FLAGS)
+    return [check(flag) for flag in value]
+
+
+def _ignore(value):
+    return value
+
+
+def _config(leaves):
+    """
+    config container, with state allowed next to it and not checked, like
+    the binding does for config false nodes
+    """
+    return {'config': leaves, 'state': _ignore}
+
+
+# Compiled schema of an acl-entry: containers are dicts, leaves are checks
+# that return the normalized value or raise ValueError
+ACL_ENTRY_SCHEMA = {
+    'sequence-id': _uint(0, 4294967295),
+    'config': {
+        'sequence-id': _uint(0, 4294967295),
+        'description': _string,
+    },
+    'state': _ignore,
+    'l2': _config({
+        'source-mac': _pattern(MAC_RE),
+        'source-mac-mask': _pattern(MAC_RE),
+        'destination-mac': _pattern(MAC_RE),
+        'destination-mac-mask': _pattern(MAC_RE),
+        'ethertype': _uint(1, 65535, identities=ETHERTYPES),
+        'vlan-id': _uint(1, 4095, null=True),
+    }),
+    'ip': _config({
+        'ip-version': _identity(('ipv4', 'ipv6', 'unknown')),
+        'source-ip-address': _pattern(IPV4_PREFIX_RE, IPV6_PREFIX_RE),
+        'source-ip-flow-label': _uint(0, 1048575),
+        'destination-ip-address': _pattern(IPV4_PREFIX_RE, IPV6_PREFIX_RE),
+        'destination-ip-flow-label': _uint(0, 1048575),
+        'dscp': _uint(0, 63),
+        'protocol': _uint(0, 254, identities=IP_PROTOCOLS),
+        'hop-limit': _uint(0, 255),
+    }),
+    'transport': _config({
+        'source-port': _port,
+        'destination-port': _port,
+        'tcp-flags': _tcp_flags,
+    }),
+    'input-interface': {
+        'interface-ref': _config({
+            'interface': _string,
+            'subinterface': _uint(0, 4294967295),
+        }),
+    },
+    'actions': _config({
+        'forwarding-action': _identity(FORWARDING_ACTIONS),
+        'log-action': _identity(LOG_ACTIONS),
+    }),
+    'icmp': {
+        'config': {
+            'type': _uint(0, 255, null=True),
+            'code': _uint(0, 255, null=True),
+        },
+    },
+}
+
+ACL_SET_CONFIG_SCHEMA = {
+    'name': _string,
+    'description': _string,
+}
+
+
+def _check(node, schema, path):
+    """
+    Returns node with its leaves normalized, raises AclJsonError on the
+    first node that does not match schema
+    """
+    if not isinstance(node, dict):
+        raise AclJsonError(path, 'must be a container')
+    result = {}
+    for name, value in node.items():
+        child = schema.get(name)
+        if child is None:
+            raise AclJsonError(path + [name], 'unknown node')
+        if isinstance(child, dict):
+            result[name] = _check(value, child, path + [name])
+        else:
+            try:
+                result[name] = child(value)
+            except ValueError as e:
+                raise AclJsonError(path + [name], str(e))
+    return result
+
+
+def _list(node, path):
+    if not isinstance(node, dict):
+        raise AclJsonError(path, 'must be a list keyed by its key leaf')
+    return node
+
+
+def _get(node, *names):
+    for name in names:
+        node = node.get(name)
+        if node is None:
+            return None
+    return node
+
+
+def table_name(set_name):
+    """
+    ACL_TABLE name of an acl-set
+    """
+    return set_name.replace(' ', '_').replace('-', '_').upper()
+
+
+def convert_entry(table, table_type, entry, mirror_session=None, max_priority=MAX_PRIORITY):
+    """
+    Returns the ACL_RULE key and fields of a checked acl-entry
+    """
+    rule_idx = entry['sequence-id']
+    rule = {'PRIORITY': str(max_priority - rule_idx)}
+    ipv6 = table_type in IPV6_TABLE_TYPES
+
+    action = _get(entry, 'actions', 'config', 'forwarding-action')
+    if action is None:
+        raise AclJsonError(['acl-entry', str(rule_idx)], 'no forwarding-action')
+    if action == 'ACCEPT':
+        if table_type in CTRLPLANE_TABLE_TYPES:
+            rule['PACKET_ACTION'] = 'ACCEPT'
+        elif table_type in MIRROR_TABLE_TYPES:
+            rule['MIRROR_ACTION'] = mirror_session
+        else:
+            rule['PACKET_ACTION'] = 'FORWARD'
+    else:
+        rule['PACKET_ACTION'] = 'DROP'
+
+    l2 = _get(entry, 'l2', 'config') or {}
+    if 'ethertype' in l2:
+        ethertype = l2['ethertype']
+        rule['ETHER_TYPE'] = str(ETHERTYPES.get(ethertype, ethertype))
+    if l2.get('vlan-id') is not None:
+        rule['VLAN_ID'] = str(l2['vlan-id'])
+
+    ip = _get(entry, 'ip', 'config') or {}
+    if 'protocol' in ip:
+        protocol = ip['protocol']
+        rule['IP_PROTOCOL'] = str(IP_PROTOCOLS.get(protocol, protocol))
+    for leaf, field in (('source-ip-address', 'SRC_IP'), ('destination-ip-address', 'DST_IP')):
+        if leaf in ip:
+            rule[field + 'V6' if ':' in ip[leaf] else field] = ip[leaf]
+    if 'dscp' in ip:
+        rule['DSCP'] = str(ip['dscp'])
+
+    icmp = _get(entry, 'icmp', 'config') or {}
+    prefix = 'ICMPV6' if ipv6 else 'ICMP'
+    if icmp.get('type') is not None:
+        rule[prefix + '_TYPE'] = str(icmp['type'])
+    if icmp.get('code') is not None:
+        rule[prefix + '_CODE'] = str(icmp['code'])
+
+    transport = _get(entry, 'transport', 'config') or {}
+    for leaf, field in (('source-port', 'L4_SRC_PORT'), ('destination-port', 'L4_DST_PORT')):
+        port = transport.get(leaf)
+        if port is None:
+            continue
+        port = str(port)
+        if '..' in port:
+            rule[field + '_RANGE'] = port.replace('..', '-')
+        else:
+            rule[field] = port
+    tcp_flags = 0
+    for flag in transport.get('tcp-flags', []):
+        tcp_flags |= TCP_FLAGS[flag]
+    if tcp_flags:
+        rule['TCP_FLAGS'] = '0x{:02x}/0x{:02x}'.format(tcp_flags, tcp_flags)
+
+    interface = _get(entry, 'input-interface', 'interface-ref', 'config', 'interface')
+    if interface is not None:
+        rule['IN_PORTS'] = interface
+
+    return (table, 'RULE_%d' % rule_idx), rule
+
+
+def deny_rule(table, table_type):
+    """
+    Returns the ACL_RULE key and fields of the default drop rule of a table
+    """
+    rule = {'PRIORITY': str(MIN_PRIORITY), 'PACKET_ACTION': 'DROP'}
+    if table_type in IPV6_TABLE_TYPES:
+        rule['IP_TYPE'] = 'IPV6ANY'
+    else:
+        rule['ETHER_TYPE'] = str(ETHERTYPES['ETHERTYPE_IPV4'])
+    return (table, 'DEFAULT_RULE'), rule
+
+
+def convert(data, table_types=None, mirror_session=None, max_priority=MAX_PRIORITY):
+    """
+    Checks a parsed OpenConfig ACL document and returns its ACL_RULE entries,
+    keyed by (table, rule) like ConfigDBConnector.
+
+    table_types maps the ACL_TABLE names to their type. When it is given,
+    acl-sets without a table are skipped. mirror_session is the MIRROR_ACTION
+    of the ACCEPT rules of mirror tables. Tables other than mirror tables get
+    a DEFAULT_RULE that drops the packets no rule matched.
+    """
+    rules = {}
+    top = _check(data, {'acl': {'acl-sets': {'acl-set': _ignore}, 'interfaces': _ignore, 'state': _ignore}}, [])
+    acl_sets = _get(top, 'acl', 'acl-sets', 'acl-set') or {}
+    path = ['acl', 'acl-sets', 'acl-set']
+    for set_name, acl_set in _list(acl_sets, path).items():
+        set_path = path + [set_name]
+        if not isinstance(acl_set, dict):
+            raise AclJsonError(set_path, 'must be a container')
+        for name in acl_set:
+            if name not in ('name', 'config', 'state', 'acl-entries'):
+                raise AclJsonError(set_path + [name], 'unknown node')
+        _check(acl_set.get('config', {}), ACL_SET_CONFIG_SCHEMA, set_path + ['config'])
+
+        table = table_name(set_name)
+        if table_types is not None and table not in table_types:
+            continue
+        table_type = (table_types or {}).get(table)
+
+        entries_path = set_path + ['acl-entries']
+        entries = acl_set.get('acl-entries', {})
+        if not isinstance(entries, dict) or set(entries) - set(['acl-entry']):
+            raise AclJsonError(entries_path, 'must hold the acl-entry list only')
+        entries_path.append('acl-entry')
+        for entry_key, entry in _list(entries.get('acl-entry', {}), entries_path).items():
+            entry = _check(entry, ACL_ENTRY_SCHEMA, entries_path + [entry_key])
+            if 'sequence-id' not in entry:
+                seq_id = _get(entry, 'config', 'sequence-id')
+                if seq_id is None:
+                    seq_id = _check({'sequence-id': entry_key}, ACL_ENTRY_SCHEMA, entries_path)['sequence-id']
+                entry['sequence-id'] = seq_id
+            key, rule = convert_entry(table, table_type, entry, mirror_session, max_priority)
+            rules[key] = rule
+
+        if table_type not in MIRROR_TABLE_TYPES:
+            key, rule = deny_rule(table, table_type)
+            rules[key] = rule
+    return rules
+
+
+def loads(text, strict=False, **kwargs):
+    """
+    Returns the ACL_RULE entries of an OpenConfig ACL JSON document, see convert().
+    strict=True also loads the document with the pyangbind binding, which
+    raises on anything openconfig-acl does not allow.
+    """
+    if strict:
+        import pyangbind.lib.pybindJSON as pybindJSON
+        import openconfig_acl
+        pybindJSON.loads(text, openconfig_acl, 'openconfig_acl')
+    return convert(json.loads(text), **kwargs)
+
+
+def load(filename, strict=False, **kwargs):
+    with open(filename) as f:
+        return loads(f.read(), strict, **kwargs)
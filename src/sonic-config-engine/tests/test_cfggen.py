@@ -150,6 +150,22 @@ class TestCfgGen(TestCase):
         for key, value in data.items():
             self.assertEqual(output_data[key.replace("key", "jk")], value)
 
+    def test_batch_file(self):
+        with open(self.output2_file, 'w') as bf:
+            bf.write('# comment\n')
+            bf.write('-t ' + os.path.join(self.test_dir, 'test.j2') + ',' + self.output_file + '\n')
+            bf.write('\n')
+            bf.write('-v key1\n')
+            bf.write('-v "yml_item[1]"\n')
+            bf.write('-t ' + os.path.join(self.test_dir, 'test2.j2') + '\n')
+        argument = '-y ' + os.path.join(self.test_dir, 'test.yml')
+        argument += ' -a \'{"key1":"value"}\''
+        argument += ' --batch ' + self.output2_file
+        output = self.run_script(argument)
+        self.assertEqual(output.strip(), 'value\nvalue2\nvalue')
+        with open(self.output_file) as tf:
+            self.assertEqual(tf.read().strip(), 'value1\nvalue2')
+
     # FIXME: This test depends heavily on the ordering of the interfaces and
     # it is not at all intuitive what that ordering should be. Could make it
     # more robust by adding better parsing logic.
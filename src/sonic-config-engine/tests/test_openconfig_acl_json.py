@@ -0,0 +1,93 @@
+import json
+import os
+
+from unittest import TestCase
+
+import openconfig_acl_json
+
+
+def acl_doc(entries, set_name='dataacl'):
+    return {'acl': {'acl-sets': {'acl-set': {set_name: {
+        'config': {'name': set_name},
+        'acl-entries': {'acl-entry': entries},
+    }}}}}
+
+
+class TestOpenconfigAclJson(TestCase):
+
+    def setUp(self):
+        self.test_dir = os.path.dirname(os.path.realpath(__file__))
+        self.sample_acl = os.path.join(self.test_dir, 't0-sample-acl.json')
+
+    def test_sample(self):
+        rules = openconfig_acl_json.load(self.sample_acl, table_types={
+            'DATAACL': 'L3', 'EVERFLOW': 'MIRROR', 'SNMP_ACL': 'CTRLPLANE'}, mirror_session='everflow0')
+        self.assertEqual(rules[('DATAACL', 'RULE_1')], {
+            'PRIORITY': '9999',
+            'PACKET_ACTION': 'FORWARD',
+            'IP_PROTOCOL': '17',
+            'SRC_IP': '10.0.0.0/8',
+        })
+        self.assertEqual(rules[('DATAACL', 'RULE_4')]['TCP_FLAGS'], '0x10/0x10')
+        self.assertEqual(rules[('DATAACL', 'DEFAULT_RULE')], {
+            'PRIORITY': '1', 'PACKET_ACTION': 'DROP', 'ETHER_TYPE': '2048'})
+        self.assertEqual(rules[('EVERFLOW', 'RULE_1')], {
+            'PRIORITY': '9999',
+            'MIRROR_ACTION': 'everflow0',
+            'IP_PROTOCOL': '6',
+            'SRC_IP': '127.0.0.1/32',
+            'DST_IP': '127.0.0.1/32',
+            'L4_SRC_PORT': '0',
+            'L4_DST_PORT': '0',
+        })
+        self.assertNotIn(('EVERFLOW', 'DEFAULT_RULE'), rules)
+        self.assertEqual(rules[('SNMP_ACL', 'RULE_1')]['PACKET_ACTION'], 'ACCEPT')
+
+    def test_skip_unknown_table(self):
+        rules = openconfig_acl_json.load(self.sample_acl, table_types={'DATAACL': 'L3'})
+        self.assertEqual(set(table for table, _ in rules), set(['DATAACL']))
+
+    def test_convert_leaves(self):
+        rules = openconfig_acl_json.convert(acl_doc({'7': {
+            'config': {'sequence-id': 7},
+            'actions': {'config': {'forwarding-action': 'oc-acl:DROP'}},
+            'l2': {'config': {'ethertype': 'ETHERTYPE_IPV6', 'vlan-id': 100}},
+            'ip': {'config': {'protocol': 58, 'source-ip-address': '2001:db8::/32', 'dscp': '8'}},
+            'icmp': {'config': {'type': 128, 'code': 'null'}},
+            'transport': {'config': {'source-port': '1024..2047', 'destination-port': 'ANY',
+                                     'tcp-flags': ['TCP_SYN', 'oc-pkt-match-types:TCP_ACK']}},
+            'input-interface': {'interface-ref': {'config': {'interface': 'Ethernet0'}}},
+        }}), table_types={'DATAACL': 'L3V6'})
+        self.assertEqual(rules[('DATAACL', 'RULE_7')], {
+            'PRIORITY': '9993',
+            'PACKET_ACTION': 'DROP',
+            'ETHER_TYPE': '34525',
+            'VLAN_ID': '100',
+            'IP_PROTOCOL': '58',
+            'SRC_IPV6': '2001:db8::/32',
+            'DSCP': '8',
+            'ICMPV6_TYPE': '128',
+            'L4_SRC_PORT_RANGE': '1024-2047',
+            'TCP_FLAGS': '0x12/0x12',
+            'IN_PORTS': 'Ethernet0',
+        })
+        self.assertEqual(rules[('DATAACL', 'DEFAULT_RULE')]['IP_TYPE'], 'IPV6ANY')
+
+    def test_invalid(self):
+        cases = [
+            ({'1': {'actions': {'config': {'forwarding-action': 'PERMIT'}}}}, 'forwarding-action'),
+            ({'1': {'ip': {'config': {'dscp': 64}}}}, 'dscp'),
+            ({'1': {'ip': {'config': {'source-ip-address': '10.0.0.256/8'}}}}, 'source-ip-address'),
+            ({'1': {'transport': {'config': {'source-port': '70000'}}}}, 'source-port'),
+            ({'1': {'ip': {'config': {'src-ip': '10.0.0.0/8'}}}}, 'src-ip'),
+            ({'x': {'actions': {'config': {'forwarding-action': 'ACCEPT'}}}}, 'sequence-id'),
+        ]
+        for entries, leaf in cases:
+            with self.assertRaises(openconfig_acl_json.AclJsonError) as cm:
+                openconfig_acl_json.convert(acl_doc(entries))
+            self.assertEqual(cm.exception.path[-1], leaf)
+
+    def test_loads(self):
+        text = json.dumps(acl_doc({'1': {'actions': {'config': {'forwarding-action': 'ACCEPT'}}}}, 'my acl'))
+        rules = openconfig_acl_json.loads(text)
+        self.assertEqual(rules[('MY_ACL', 'RULE_1')], {'PRIORITY': '9999', 'PACKET_ACTION': 'FORWARD'})
@@ -0,0 +1,113 @@
+"""
+System EEPROM image cache shared by the processes that decode it.
+
+decode-syseeprom, snmp and the platform daemons each instantiate the eeprom
+plugin and read the TLV EEPROM again, which takes hundreds of milliseconds
+on drivers that read the chip byte by byte. EepromCache keeps the image in
+a tmpfs file, so it is read from the bus once per boot. The cache is used
+only while it is newer than the eeprom attribute, which sysfs creates
+again when the driver binds to the device. Writing the attribute does not
+change its mtime, so the writer drops the cache, see EepromCacheMixin.
+"""
+
+import os
+
+CACHE_DIR = '/var/run/sonic-eeprom'
+
+
+class EepromCache(object):
+    """
+    First size bytes, from offset start, of the eeprom attribute at path.
+    """
+
+    def __init__(self, path, start=0, size=256, cache_dir=CACHE_DIR):
+        self.path = path
+        self.start = start
+        self.size = size
+        self.cache_path = os.path.join(cache_dir, '%s@%x' % (path.strip('/').replace('/', '_'), start))
+        self._image = None
+
+    def _load_cache(self):
+        try:
+            if os.stat(self.cache_path).st_mtime < os.stat(self.path).st_mtime:
+                return None
+            with open(self.cache_path, 'rb') as f:
+                image = f.read()
+        except (IOError, OSError):
+            return None
+        return image if len(image) == self.size else None
+
+    def _save_cache(self, image):
+        tmp_path = '%s.%d' % (self.cache_path, os.getpid())
+        try:
+            cache_dir = os.path.dirname(self.cache_path)
+            if not os.path.isdir(cache_dir):
+                os.makedirs(cache_dir)
+            with open(tmp_path, 'wb') as f:
+                f.write(image)
+            os.rename(tmp_path, self.cache_path)
+        except (IOError, OSError):
+            # Not running as root, or no tmpfs: work without the cache
+            try:
+                os.remove(tmp_path)
+            except OSError:
+                pass
+
+    def _read_device(self, count, offset):
+        with open(self.path, 'rb') as f:
+            f.seek(self.start + offset)
+            return f.read(count)
+
+    def image(self):
+        """
+        Returns the EEPROM image, from the cache when it is valid
+        """
+        if self._image is None:
+            image = self._load_cache()
+            if image is None:
+                image = self._read_device(self.size, 0)
+                if len(image) == self.size:
+                    self._save_cache(image)
+            self._image = image
+        return self._image
+
+    def read(self, count, offset=0):
+        """
+        Returns count bytes at offset, like EepromDecoder.read_eeprom_bytes().
+        Raises RuntimeError on a short read.
+        """
+        image = self.image()
+        if offset + count <= len(image):
+            data = image[offset:offset + count]
+        else:
+            data = self._read_device(count, offset)
+        if len(data) != count:
+            raise RuntimeError("Expected to read %d bytes from %s, but only read %d" % (count, self.path, len(data)))
+        return data
+
+    def invalidate(self):
+        """
+        Drops the cached image, after the EEPROM was written
+        """
+        self._image = None
+        try:
+            os.remove(self.cache_path)
+        except OSError:
+            pass
+
+
+class EepromCacheMixin(object):
+    """
+    Serves read_eeprom_bytes() of an EepromDecoder from self.eeprom_cache,
+    and drops the cache when write_eeprom() programs the EEPROM. Goes before
+    the decoder in the base classes of a plugin.
+    """
+
+    def read_eeprom_bytes(self, byteCount, offset=0):
+        return self.eeprom_cache.read(byteCount, offset)
+
+    def write_eeprom(self, e):
+        try:
+            return super(EepromCacheMixin, self).write_eeprom(e)
+        finally:
+            self.eeprom_cache.invalidate()
@@ -0,0 +1,107 @@
+"""
+PSU presence and power good snapshot shared by the psuutil plugins.
+
+psud, snmp and the CLI all poll get_psu_presence()/get_psu_status(), and
+each call of a plugin used to read a CPLD attribute. PsuStatusSnapshot
+reads the attributes of all PSUs together, at most once per interval, and
+answers the calls in between from memory. When the platform driver calls
+sysfs_notify() on an attribute, a change is picked up before the interval
+expires.
+"""
+
+import select
+import time
+
+
+class PsuStatusSnapshot(object):
+    """
+    Presence and power good of the PSUs of a platform.
+
+    nodes maps the PSU index to a (presence path, power good path) pair.
+    An attribute holds a decimal number, 1 is present or power good.
+    """
+
+    def __init__(self, nodes, interval=1.0, notify=True):
+        self.nodes = dict(nodes)
+        self.interval = interval
+        self.notify = notify
+        self._files = {}
+        self._poller = None
+        self._presence = {}
+        self._status = {}
+        self._time = None
+
+    def _read(self, path):
+        """
+        Returns the value of an attribute, None when it cannot be read.
+        Each read re-arms the notification of the driver.
+        """
+        try:
+            f = self._files.get(path)
+            if f is None:
+                f = open(path, 'rb', 0)
+                self._files[path] = f
+                if self.notify:
+                    if self._poller is None:
+                        self._poller = select.poll()
+                    self._poller.register(f.fileno(), select.POLLPRI | select.POLLERR)
+            f.seek(0)
+            return int(f.read().strip())
+        except (IOError, OSError, ValueError):
+            self._close(path)
+            return None
+
+    def _close(self, path):
+        f = self._files.pop(path, None)
+        if f is not None:
+            if self._poller is not None:
+                try:
+                    self._poller.unregister(f.fileno())
+                except (KeyError, ValueError):
+                    pass
+            f.close()
+
+    def _notified(self):
+        """
+        Returns True when the driver signaled one of the attributes since it was read
+        """
+        if self._poller is None:
+            return False
+        return bool(self._poller.poll(0))
+
+    def refresh(self, force=False):
+        """
+        Reads all the attributes again when forced, when the interval expired
+        or when the driver signaled a change
+        """
+        now = time.time()
+        if not force and self._time is not None and \
+                0 <= now - self._time < self.interval and not self._notified():
+            return
+        for index, (presence_path, status_path) in self.nodes.items():
+            self._presence[index] = self._read(presence_path)
+            self._status[index] = self._read(status_path)
+        self._time = now
+
+    def get_presence(self, index):
+        """
+        Returns True if the PSU is present
+        """
+        if index not in self.nodes:
+            return False
+        self.refresh()
+        return self._presence.get(index) == 1
+
+    def get_status(self, index):
+        """
+        Returns True if the power of the PSU is good
+        """
+        if index not in self.nodes:
+            return False
+        self.refresh()
+        return self._status.get(index) == 1
+
+    def close(self):
+        for path in list(self._files):
+            self._close(path)
+        self._poller = None
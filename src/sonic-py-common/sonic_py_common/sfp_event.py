@@ -0,0 +1,143 @@
+"""
+Transceiver presence change events from platform driver notifications.
+
+A platform driver that keeps the presence bits of its ports in one sysfs
+attribute, and calls sysfs_notify() on that attribute when a module is
+inserted or removed, lets get_transceiver_change_event() sleep in poll()
+instead of re-reading the CPLD on a timer.
+"""
+
+import os
+import select
+import time
+
+SFP_STATUS_INSERTED = '1'
+SFP_STATUS_REMOVED = '0'
+
+
+class PresenceBitmap(object):
+    """
+    One presence attribute of a platform driver.
+
+    ports lists the port numbers in bit order, ports[n] is the port of bit n.
+    A binary attribute is decoded as a little-endian word of size bytes
+    starting at offset. A text attribute holds one hexadecimal number.
+    """
+
+    def __init__(self, path, ports, size=8, offset=0, text=False, active_low=False):
+        self.path = path
+        self.ports = list(ports)
+        self.size = size
+        self.offset = offset
+        self.text = text
+        self.mask = (1 << len(self.ports)) - 1
+        self.active_low = active_low
+        self._file = None
+
+    def exists(self):
+        return os.path.exists(self.path)
+
+    def fileno(self):
+        if self._file is None:
+            self._file = open(self.path, 'rb', 0)
+        return self._file.fileno()
+
+    def read(self):
+        """
+        Returns the presence bits, 1 is present. Each read re-arms the
+        notification of the driver.
+        """
+        self.fileno()
+        if self.text:
+            self._file.seek(0)
+            value = int(self._file.read().strip(), 16)
+        else:
+            self._file.seek(self.offset)
+            data = bytearray(self._file.read(self.size))
+            if len(data) != self.size:
+                raise IOError("short read of %s" % self.path)
+            value = 0
+            for i, byte in enumerate(data):
+                value |= byte << (8 * i)
+
+        if self.active_low:
+            value = ~value
+        return value & self.mask
+
+    def close(self):
+        if self._file is not None:
+            self._file.close()
+            self._file = None
+
+
+class PresenceWatcher(object):
+    """
+    Waits on the presence attributes of a platform and reports the ports
+    that changed, in the format of SfpUtilBase.get_transceiver_change_event().
+    """
+
+    def __init__(self, bitmaps):
+        self.bitmaps = list(bitmaps)
+        self._poller = None
+        self._present = None
+
+    def available(self):
+        """
+        Returns True when the driver exposes all the attributes.
+        """
+        return all(bitmap.exists() for bitmap in self.bitmaps)
+
+    def _open(self):
+        self._poller = select.poll()
+        for bitmap in self.bitmaps:
+            self._poller.register(bitmap.fileno(), select.POLLPRI | select.POLLERR)
+
+    def _read(self):
+        present = {}
+        for bitmap in self.bitmaps:
+            value = bitmap.read()
+            for bit, port in enumerate(bitmap.ports):
+                present[port] = bool(value & (1 << bit))
+        return present
+
+    def wait(self, timeout=0):
+        """
+        Returns a dict of the changed ports, port to SFP_STATUS_INSERTED or
+        SFP_STATUS_REMOVED. The first call reports the present ports.
+        Blocks until a change, or for timeout ms when timeout is not 0;
+        returns an empty dict on timeout. Raises IOError/OSError when an
+        attribute cannot be read.
+        """
+        try:
+            if self._poller is None:
+                self._open()
+
+            end = time.time() + timeout / 1000.0
+            while True:
+                present = self._read()
+                port_dict = {}
+                for port, state in present.items():
+                    if self._present is None:
+                        if state:
+                            port_dict[port] = SFP_STATUS_INSERTED
+                    elif state != self._present[port]:
+                        port_dict[port] = SFP_STATUS_INSERTED if state else SFP_STATUS_REMOVED
+                self._present = present
+
+                if port_dict:
+                    return port_dict
+
+                if timeout == 0:
+                    self._poller.poll()
+                else:
+                    wait = int((end - time.time()) * 1000)
+                    if wait <= 0 or not self._poller.poll(wait):
+                        return {}
+        except (IOError, OSError):
+            self.close()
+            raise
+
+    def close(self):
+        for bitmap in self.bitmaps:
+            bitmap.close()
+        self._poller = None
@@ -0,0 +1,32 @@
+import os
+import shutil
+import tempfile
+
+import pytest
+
+
+class SysfsDir(object):
+    """
+    Temporary directory standing in for the sysfs attributes of a device
+    """
+    def __init__(self):
+        self.path = tempfile.mkdtemp()
+
+    def join(self, name):
+        return os.path.join(self.path, name)
+
+    def write(self, name, data):
+        path = self.join(name)
+        with open(path, 'w' if isinstance(data, str) else 'wb') as f:
+            f.write(data)
+        return path
+
+    def remove(self):
+        shutil.rmtree(self.path)
+
+
+@pytest.fixture
+def sysfs():
+    sysfs_dir = SysfsDir()
+    yield sysfs_dir
+    sysfs_dir.remove()
@@ -0,0 +1,83 @@
+import os
+import time
+
+import pytest
+
+from sonic_py_common.eeprom_cache import EepromCache, EepromCacheMixin
+
+
+@pytest.fixture
+def eeprom(sysfs):
+    sysfs.write('eeprom', bytes(bytearray(range(256))))
+    return sysfs
+
+
+def eeprom_cache(sysfs, start=0, size=16):
+    return EepromCache(sysfs.join('eeprom'), start, size, cache_dir=sysfs.join('cache'))
+
+
+class EepromDecoder(object):
+    """
+    Write path of the sonic_eeprom decoder, which leaves the mtime of a
+    sysfs attribute as it was
+    """
+    def __init__(self, path):
+        self.p = path
+
+    def write_eeprom(self, e):
+        st = os.stat(self.p)
+        with open(self.p, 'r+b') as f:
+            f.write(e)
+        os.utime(self.p, (st.st_atime, st.st_mtime))
+
+
+class Board(EepromCacheMixin, EepromDecoder):
+    def __init__(self, sysfs):
+        super(Board, self).__init__(sysfs.join('eeprom'))
+        self.eeprom_cache = eeprom_cache(sysfs)
+
+
+class TestEepromCache(object):
+    def test_read(self, eeprom):
+        cache = eeprom_cache(eeprom)
+        assert cache.read(4) == b'\x00\x01\x02\x03'
+        assert cache.read(2, 14) == b'\x0e\x0f'
+        # beyond the cached image
+        assert cache.read(2, 16) == b'\x10\x11'
+        with pytest.raises(RuntimeError):
+            cache.read(2, 255)
+
+    def test_shared_cache(self, eeprom):
+        cache = eeprom_cache(eeprom, 0x10)
+        assert cache.read(1) == b'\x10'
+        assert os.path.isfile(cache.cache_path)
+
+        # another process uses the cache file, not the device
+        path = eeprom.write('eeprom', b'\xff' * 256)
+        past = time.time() - 10
+        os.utime(path, (past, past))
+        assert eeprom_cache(eeprom, 0x10).read(1) == b'\x10'
+
+    def test_stale_cache(self, eeprom):
+        eeprom_cache(eeprom).image()
+        # the device was bound again after the cache was written
+        path = eeprom.write('eeprom', b'\xff' * 256)
+        future = time.time() + 10
+        os.utime(path, (future, future))
+        assert eeprom_cache(eeprom).read(1) == b'\xff'
+
+    def test_invalidate(self, eeprom):
+        cache = eeprom_cache(eeprom)
+        cache.image()
+        cache.invalidate()
+        assert not os.path.exists(cache.cache_path)
+        eeprom.write('eeprom', b'\xff' * 256)
+        assert cache.read(1) == b'\xff'
+
+    def test_read_after_write(self, eeprom):
+        board = Board(eeprom)
+        assert board.read_eeprom_bytes(2) == b'\x00\x01'
+        board.write_eeprom(b'\xff\xfe')
+        assert board.read_eeprom_bytes(2) == b'\xff\xfe'
+        # and in other processes
+        assert eeprom_cache(eeprom).read(2) == b'\xff\xfe'
@@ -0,0 +1,42 @@
+import os
+
+from sonic_py_common.psu_status import PsuStatusSnapshot
+
+
+def psu_nodes(sysfs):
+    return {
+        1: (sysfs.write('psu1_present', '1\n'), sysfs.write('psu1_power_good', '1\n')),
+        2: (sysfs.write('psu2_present', '1\n'), sysfs.write('psu2_power_good', '0\n')),
+    }
+
+
+class TestPsuStatusSnapshot(object):
+    def test_status(self, sysfs):
+        snapshot = PsuStatusSnapshot(psu_nodes(sysfs))
+        assert snapshot.get_presence(1)
+        assert snapshot.get_status(1)
+        assert snapshot.get_presence(2)
+        assert not snapshot.get_status(2)
+        assert not snapshot.get_presence(3)
+        assert not snapshot.get_status(3)
+
+    def test_cached_until_interval(self, sysfs):
+        snapshot = PsuStatusSnapshot(psu_nodes(sysfs), interval=3600)
+        assert not snapshot.get_status(2)
+        sysfs.write('psu2_power_good', '1\n')
+        assert not snapshot.get_status(2)
+        snapshot.refresh(force=True)
+        assert snapshot.get_status(2)
+
+    def test_no_cache(self, sysfs):
+        snapshot = PsuStatusSnapshot(psu_nodes(sysfs), interval=0)
+        assert snapshot.get_presence(1)
+        sysfs.write('psu1_present', '0\n')
+        assert not snapshot.get_presence(1)
+
+    def test_missing_attribute(self, sysfs):
+        nodes = psu_nodes(sysfs)
+        os.remove(nodes[1][1])
+        snapshot = PsuStatusSnapshot(nodes)
+        assert snapshot.get_presence(1)
+        assert not snapshot.get_status(1)
@@ -0,0 +1,40 @@
+import struct
+
+from sonic_py_common import sfp_event
+from sonic_py_common.sfp_event import PresenceBitmap, PresenceWatcher
+
+
+class TestPresenceWatcher(object):
+    def test_binary_bitmap(self, sysfs):
+        path = sysfs.write('module_present_bitmap', struct.pack('<Q', 0b101))
+        watcher = PresenceWatcher([PresenceBitmap(path, range(1, 33))])
+        assert watcher.available()
+
+        result = watcher.wait(10)
+        assert result == {1: sfp_event.SFP_STATUS_INSERTED, 3: sfp_event.SFP_STATUS_INSERTED}
+        assert watcher.wait(10) == {}
+
+        sysfs.write('module_present_bitmap', struct.pack('<Q', 0b110))
+        result = watcher.wait(10)
+        assert result == {1: sfp_event.SFP_STATUS_REMOVED, 2: sfp_event.SFP_STATUS_INSERTED}
+
+    def test_several_bitmaps(self, sysfs):
+        low = sysfs.write('low', struct.pack('<HHHH', 0x0001, 0, 0, 0))
+        high = sysfs.write('high', struct.pack('<HHHH', 0x8000, 0, 0, 0))
+        watcher = PresenceWatcher([
+            PresenceBitmap(low, range(0, 16), size=2),
+            PresenceBitmap(high, range(16, 32), size=2),
+        ])
+
+        result = watcher.wait(10)
+        assert result == {0: sfp_event.SFP_STATUS_INSERTED, 31: sfp_event.SFP_STATUS_INSERTED}
+
+    def test_active_low_text(self, sysfs):
+        path = sysfs.write('qsfp_modprs_changed', b'0xfffffffe\n')
+        watcher = PresenceWatcher([PresenceBitmap(path, range(1, 33), text=True, active_low=True)])
+
+        assert watcher.wait(10) == {1: sfp_event.SFP_STATUS_INSERTED}
+
+    def test_missing_attribute(self, sysfs):
+        watcher = PresenceWatcher([PresenceBitmap(sysfs.join('missing'), range(1, 33))])
+        assert not watcher.available()
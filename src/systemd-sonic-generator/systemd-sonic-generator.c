@@ -1,10 +1,12 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <linux/limits.h>
@@ -13,13 +15,128 @@
 #define MAX_NUM_INSTALL_LINES 15
 #define MAX_NUM_UNITS 128
 #define MAX_BUF_SIZE 512
+#define ARENA_BLOCK_SIZE 65536
 
 static const char* UNIT_FILE_PREFIX = "/usr/lib/systemd/system/";
 static const char* CONFIG_FILE = "/etc/sonic/generated_services.conf";
 static const char* MACHINE_CONF_FILE = "/host/machine.conf";
 static int num_asics;
-static char** multi_instance_services;
+static char* multi_instance_services[MAX_NUM_UNITS];
 static int num_multi_inst;
+/* Generator output directory, units and symlinks are created relative to it */
+static int install_dir_fd = -1;
+
+/* Strings live until the generator exits, they are carved out of one arena */
+struct arena_block {
+    struct arena_block* next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+static struct arena_block* arena;
+
+/* Growable buffer, reused for every unit file */
+struct buffer {
+    char* data;
+    size_t len;
+    size_t size;
+};
+
+/* A unit file as parsed from its single read */
+struct unit {
+    char* name;                         /* unit file name as installed */
+    char* targets[MAX_NUM_TARGETS];     /* target directories, e.g. multi-user.target.wants */
+    int num_targets;
+    bool generated;                     /* expanded copy written to the generator output directory */
+};
+
+/* Target directories already created in this run */
+static char* target_dirs[MAX_NUM_UNITS * MAX_NUM_TARGETS];
+static int num_target_dirs;
+
+static char* arena_alloc(size_t len) {
+    /***
+    Allocates len bytes from the string arena
+    ***/
+    struct arena_block* block = arena;
+
+    if (block == NULL || block->size - block->used < len) {
+        size_t size = len > ARENA_BLOCK_SIZE ? len : ARENA_BLOCK_SIZE;
+
+        block = malloc(sizeof(*block) + size);
+        if (block == NULL) {
+            fputs("Out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        block->used = 0;
+        block->size = size;
+        block->next = arena;
+        arena = block;
+    }
+
+    block->used += len;
+    return block->data + block->used - len;
+}
+
+static char* arena_strndup(const char* str, size_t len) {
+    char* copy = arena_alloc(len + 1);
+
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    return copy;
+}
+
+static char* arena_strdup(const char* str) {
+    return arena_strndup(str, strlen(str));
+}
+
+static void arena_free(void) {
+    while (arena != NULL) {
+        struct arena_block* next = arena->next;
+
+        free(arena);
+        arena = next;
+    }
+}
+
+static void buffer_reserve(struct buffer* buf, size_t len) {
+    if (buf->len + len + 1 > buf->size) {
+        size_t size = buf->size ? buf->size : MAX_BUF_SIZE;
+
+        while (buf->len + len + 1 > size)
+            size *= 2;
+
+        buf->data = realloc(buf->data, size);
+        if (buf->data == NULL) {
+            fputs("Out of memory\n", stderr);
+            exit(EXIT_FAILURE);
+        }
+        buf->size = size;
+    }
+}
+
+static void buffer_append(struct buffer* buf, const char* str, size_t len) {
+    buffer_reserve(buf, len);
+    memcpy(buf->data + buf->len, str, len);
+    buf->len += len;
+    buf->data[buf->len] = '\0';
+}
+
+static void buffer_printf(struct buffer* buf, const char* fmt, ...) {
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+
+    buffer_reserve(buf, len);
+    va_start(args, fmt);
+    vsnprintf(buf->data + buf->len, len + 1, fmt, args);
+    va_end(args);
+    buf->len += len;
+}
 
 void strip_trailing_newline(char* str) {
     /***
@@ -32,19 +149,12 @@ void strip_trailing_newline(char* str) {
 }
 
 
-static int get_target_lines(char* unit_file, char* target_lines[]) {
+static int read_unit_file(const char* unit_file, struct buffer* content) {
     /***
-    Gets installation information for a given unit file
-
-    Returns lines in the [Install] section of a unit file
+    Reads a whole unit file into content
     ***/
     FILE *fp;
-    char *line = NULL;
-    size_t len = 0;
-    ssize_t nread;
-    bool found_install;
-    int num_target_lines;
-
+    size_t nread;
 
     fp = fopen(unit_file, "r");
 
@@ -53,33 +163,20 @@ static int get_target_lines(char* unit_file, char* target_lines[]) {
         return -1;
     }
 
-    found_install = false;
-    num_target_lines = 0;
-
-    while ((nread = getline(&line, &len, fp)) != -1 ) {
-        // Assumes that [Install] is the last section of the unit file
-        if (strstr(line, "[Install]") != NULL) {
-             found_install = true;
-        }
-        else if (found_install) {
-            if (num_target_lines >= MAX_NUM_INSTALL_LINES) {
-                fprintf(stderr, "Number of lines in [Install] section of %s exceeds MAX_NUM_INSTALL_LINES\n", unit_file);
-                fputs("Extra [Install] lines will be ignored\n", stderr);
-                break;
-            }
-            target_lines[num_target_lines] = strdup(line);
-            num_target_lines++;
-        }
-    }
-
-    free(line);
+    content->len = 0;
+    do {
+        buffer_reserve(content, MAX_BUF_SIZE);
+        nread = fread(content->data + content->len, 1, content->size - content->len - 1, fp);
+        content->len += nread;
+    } while (nread > 0);
+    content->data[content->len] = '\0';
 
     fclose(fp);
 
-    return num_target_lines;
+    return 0;
 }
 
-static bool is_multi_instance_service(char *service_name){
+static bool is_multi_instance_service(const char *service_name){
     int i;
     for(i=0; i < num_multi_inst; i++){
         if (strstr(service_name, multi_instance_services[i]) != NULL) {
@@ -90,197 +187,227 @@ static bool is_multi_instance_service(char *service_name){
 
 }
 
-static int get_install_targets_from_line(char* target_string, char* install_type, char* targets[], int existing_targets) {
+static void get_install_targets_from_line(char* target_string, const char* install_type, struct unit* unit) {
     /***
-    Helper fuction for get_install_targets
+    Helper fuction for parse_install_section
 
     Given a space delimited string of target directories and a suffix,
-    puts each target directory plus the suffix into the targets array
+    puts each target directory plus the suffix into the unit targets
     ***/
     char* token;
-    char* target;
-    char final_target[PATH_MAX];
-    int num_targets = 0;
+    char* dot;
+    char* percent;
 
-    while ((token = strtok_r(target_string, " ", &target_string))) {
-        if (num_targets + existing_targets >= MAX_NUM_TARGETS) {
+    while ((token = strtok_r(target_string, " \n", &target_string))) {
+        if (unit->num_targets >= MAX_NUM_TARGETS) {
             fputs("Number of targets found exceeds MAX_NUM_TARGETS\n", stderr);
             fputs("Additional targets will be ignored \n", stderr);
-            return num_targets;
+            return;
         }
 
-        target = strdup(token);
-        strip_trailing_newline(target);
+        // foo@%i.service -> foo@.service.wants
+        percent = strchr(token, '%');
+        dot = strchr(token, '.');
+        if (percent != NULL && dot != NULL && dot - token >= 2) {
+            int prefix_len = dot - token - 2;
+            char* suffix_end = strchr(dot + 1, '.');
+            int suffix_len = suffix_end ? suffix_end - dot - 1 : (int) strlen(dot + 1);
+            size_t len = prefix_len + 1 + suffix_len + strlen(install_type);
+
+            unit->targets[unit->num_targets] = arena_alloc(len + 1);
+            snprintf(unit->targets[unit->num_targets], len + 1, "%.*s.%.*s%s",
+                     prefix_len, token, suffix_len, dot + 1, install_type);
+        }
+        else {
+            size_t len = strlen(token) + strlen(install_type);
+
+            unit->targets[unit->num_targets] = arena_alloc(len + 1);
+            snprintf(unit->targets[unit->num_targets], len + 1, "%s%s", token, install_type);
+        }
+        unit->num_targets++;
+    }
+}
+
+static void parse_install_section(char* content, struct unit* unit) {
+    /***
+    Gets installation information for a unit file
 
-        if (strstr(target, "%") != NULL) {
-            char* prefix = strtok(target, ".");
-            char* suffix = strtok(NULL, ".");
-            int prefix_len = strlen(prefix);
+    Parses the lines in the [Install] section of the unit file
+    content to determine which directories to install the unit in
+    ***/
+    char* line;
+    char* save_ptr = NULL;
+    char* value;
+    bool found_install = false;
+    int num_target_lines = 0;
 
-            strncpy(final_target, prefix, prefix_len - 2);
-            final_target[prefix_len - 2] = '\0';
-            strcat(final_target, ".");
-            strcat(final_target, suffix);
+    for (line = strtok_r(content, "\n", &save_ptr); line; line = strtok_r(NULL, "\n", &save_ptr)) {
+        // Assumes that [Install] is the last section of the unit file
+        if (strstr(line, "[Install]") != NULL) {
+            found_install = true;
+            continue;
         }
-        else {
-            strcpy(final_target, target);
+        if (!found_install) {
+            continue;
+        }
+        if (num_target_lines >= MAX_NUM_INSTALL_LINES) {
+            fprintf(stderr, "Number of lines in [Install] section of %s exceeds MAX_NUM_INSTALL_LINES\n", unit->name);
+            fputs("Extra [Install] lines will be ignored\n", stderr);
+            break;
+        }
+        num_target_lines++;
+
+        value = strchr(line, '=');
+        if (value == NULL) {
+            continue;
         }
-        strcat(final_target, install_type);
+        *value++ = '\0';
 
-        free(target);
-        
-        targets[num_targets + existing_targets] = strdup(final_target);
-        num_targets++;
+        if (strstr(line, "RequiredBy") != NULL) {
+            get_install_targets_from_line(value, ".requires", unit);
+        }
+        else if (strstr(line, "WantedBy") != NULL) {
+            get_install_targets_from_line(value, ".wants", unit);
+        }
     }
-    return num_targets;
 }
 
-static void replace_multi_inst_dep(char *src) {
-    FILE *fp_src;
-    FILE *fp_tmp;
-    char buf[MAX_BUF_SIZE];
-    char* line = NULL;
-    int i;
-    ssize_t len;
-    char *token;
-    char *word;
-    char *line_copy;
-    char *service_name;
-    char *type;
-    char *save_ptr1 = NULL;
-    char *save_ptr2 = NULL;
-    ssize_t nread;
+static void replace_multi_inst_dep(const char* content, struct buffer* out) {
+    /***
+    Expands the dependencies on multi instance services of a unit file
+
+    Each dependency is put on a line of its own, and the ones on a
+    multi instance service are replaced with one per instance
+    ***/
+    const char* line;
+    const char* end;
+    const char* eq;
+    const char* word;
+    const char* word_end;
     bool section_done = false;
-    char tmp_file_path[PATH_MAX];
-    
+
     /* Assumes that the service files has 3 sections,
      * in the order: Unit, Service and Install.
-     * Assumes that the timer file has 3 sectiosn, 
+     * Assumes that the timer file has 3 sectiosn,
      * in the order: Unit, Timer and Install.
-     * Read service dependency from Unit and Install 
+     * Read service dependency from Unit and Install
      * sections, replace if dependent on multi instance
      * service.
      */
-    fp_src = fopen(src, "r");
-    snprintf(tmp_file_path, PATH_MAX, "%s.tmp", src);
-    fp_tmp = fopen(tmp_file_path, "w");
+    out->len = 0;
+    for (line = content; *line; line = end) {
+        end = strchr(line, '\n');
+        end = end ? end + 1 : line + strlen(line);
 
-    while ((nread = getline(&line, &len, fp_src)) != -1 ) {
-        if ((strstr(line, "[Service]") != NULL) || 
-            (strstr(line, "[Timer]") != NULL)) {
+        if (strncmp(line, "[Service]", 9) == 0 || strncmp(line, "[Timer]", 7) == 0) {
             section_done = true;
-            fputs(line,fp_tmp);
-        } else if (strstr(line, "[Install]") != NULL) {
+        } else if (strncmp(line, "[Install]", 9) == 0) {
             section_done = false;
-            fputs(line,fp_tmp);
-        } else if ((strstr(line, "[Unit]") != NULL) ||
-           (strstr(line, "Description") != NULL) ||
-           (section_done == true)) {
-            fputs(line,fp_tmp);
-        } else {
-            line_copy = strdup(line);
-            token = strtok_r(line_copy, "=", &save_ptr1);
-            while ((word = strtok_r(NULL, " ", &save_ptr1))) {
-                if((strchr(word, '.') == NULL) ||
-                   (strchr(word, '@') != NULL)) {
-                    snprintf(buf, MAX_BUF_SIZE,"%s=%s\n",token, word);
-                    fputs(buf,fp_tmp);
-                } else {
-                    service_name = strdup(word);
-                    service_name = strtok_r(service_name, ".", &save_ptr2);
-                    type = strtok_r(NULL, " ", &save_ptr2);
-                    if (is_multi_instance_service(word)) {
-                        for(i = 0; i < num_asics; i++) {
-                            snprintf(buf, MAX_BUF_SIZE, "%s=%s@%d.%s\n",
-                                    token, service_name, i, type);
-                            fputs(buf,fp_tmp);
-                        }
-                    } else {
-                        snprintf(buf, MAX_BUF_SIZE,"%s=%s.%s\n",token, service_name, type);
-                        fputs(buf, fp_tmp);
-                    }
-                    free(service_name);
+        }
+
+        eq = memchr(line, '=', end - line);
+        if (section_done || eq == NULL || line[0] == '[' ||
+            strncmp(line, "Description", 11) == 0) {
+            buffer_append(out, line, end - line);
+            if (end[-1] != '\n')
+                buffer_append(out, "\n", 1);
+            continue;
+        }
+
+        for (word = eq + 1; word < end; word = word_end) {
+            word += strspn(word, " \t");
+            word_end = word + strcspn(word, " \t\n");
+            if (word_end > end)
+                word_end = end;
+            if (word == word_end)
+                break;
+
+            const char* dot = memchr(word, '.', word_end - word);
+            bool is_template = memchr(word, '@', word_end - word) != NULL;
+            char service_name[MAX_BUF_SIZE];
+
+            snprintf(service_name, sizeof(service_name), "%.*s", (int) (word_end - word), word);
+            if (dot != NULL && !is_template && is_multi_instance_service(service_name)) {
+                for (int i = 0; i < num_asics; i++) {
+                    buffer_printf(out, "%.*s=%.*s@%d%.*s\n", (int) (eq - line), line,
+                                  (int) (dot - word), word, i, (int) (word_end - dot), dot);
                 }
+            } else {
+                buffer_printf(out, "%.*s=%.*s\n", (int) (eq - line), line, (int) (word_end - word), word);
             }
-            free(line_copy);
         }
     }
-    fclose(fp_src);
-    fclose(fp_tmp);
-    free(line);
-    /* remove the .service file, rename the .service.tmp file
-     * as .service.
-     */
-    remove(src);
-    rename(tmp_file_path, src);
 }
 
-static int get_install_targets(char* unit_file, char* targets[]) {
+static int write_unit_file(const char* unit_file, const struct buffer* content) {
     /***
-    Returns install targets for a unit file
-
-    Parses the information in the [Install] section of a given
-    unit file to determine which directories to install the unit in
+    Writes a unit file of the output directory in one go
     ***/
-    char file_path[PATH_MAX];
-    char *target_lines[MAX_NUM_INSTALL_LINES];
-    int num_target_lines;
-    int num_targets;
-    int found_targets;
-    char* token;
-    char* line = NULL;
-    bool first;
-    char* target_suffix;
-    char *instance_name;
-    char *dot_ptr;
-
-    strcpy(file_path, UNIT_FILE_PREFIX);
-    strcat(file_path, unit_file);
-
-    instance_name = strdup(unit_file);
-    dot_ptr = strchr(instance_name, '.');
-    *dot_ptr = '\0';
+    FILE *fp;
+    int fd;
 
-    if((num_asics > 1) && (!is_multi_instance_service(instance_name))) {
-        replace_multi_inst_dep(file_path);
+    fd = openat(install_dir_fd, unit_file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    fp = fd < 0 ? NULL : fdopen(fd, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Failed to open file %s\n", unit_file);
+        if (fd >= 0)
+            close(fd);
+        return -1;
     }
-    free(instance_name);
 
-    num_target_lines = get_target_lines(file_path, target_lines);
-    if (num_target_lines < 0) {
-        fprintf(stderr, "Error parsing targets for %s\n", unit_file);
+    if (fwrite(content->data, 1, content->len, fp) != content->len) {
+        fprintf(stderr, "Failed to write file %s\n", unit_file);
+        fclose(fp);
+        unlinkat(install_dir_fd, unit_file, 0);
         return -1;
     }
 
-    num_targets = 0;
+    return fclose(fp);
+}
+
+static int parse_unit_file(struct unit* unit, struct buffer* content, struct buffer* expanded) {
+    /***
+    Parses a unit file in a single read
+
+    On multi ASIC platforms, the dependencies of the unit on multi
+    instance services are expanded first, the install targets are
+    taken from the expanded unit. The expanded unit is written to the
+    generator output directory, where it takes precedence over the
+    base unit, which is left untouched. A drop-in cannot be used, it
+    can add dependencies but not remove the ones on the single
+    instance services.
+    ***/
+    char file_path[PATH_MAX];
+    size_t base_len;
 
-    for (int i = 0; i < num_target_lines; i++) {
-        line = target_lines[i];
-        first = true;
+    snprintf(file_path, PATH_MAX, "%s%s", UNIT_FILE_PREFIX, unit->name);
+    if (read_unit_file(file_path, content) < 0) {
+        return -1;
+    }
 
-        while ((token = strtok_r(line, "=", &line))) {
-            if (first) {
-                first = false;
+    base_len = strcspn(unit->name, ".");
+    char instance_name[base_len + 1];
+    snprintf(instance_name, base_len + 1, "%s", unit->name);
 
-                if (strstr(token, "RequiredBy") != NULL) {
-                    target_suffix = ".requires";
-                }
-                else if (strstr(token, "WantedBy") != NULL) {
-                    target_suffix = ".wants";
-                }
-            }
-            else {
-                found_targets = get_install_targets_from_line(token, target_suffix, targets, num_targets);
-                num_targets += found_targets;
-            }
+    if ((num_asics > 1) && (!is_multi_instance_service(instance_name))) {
+        replace_multi_inst_dep(content->data, expanded);
+        if (write_unit_file(unit->name, expanded) < 0) {
+            fprintf(stderr, "Failed to generate multi ASIC dependencies of %s\n", file_path);
+        }
+        else {
+            unit->generated = true;
         }
-        free(target_lines[i]);
+        parse_install_section(expanded->data, unit);
+    }
+    else {
+        parse_install_section(content->data, unit);
     }
-    return num_targets;
+
+    return 0;
 }
 
 
-static int get_unit_files(char* unit_files[]) {
+static int get_unit_files(struct unit units[]) {
     /***
     Reads a list of unit files to be installed from /etc/sonic/generated_services.conf
     ***/
@@ -300,8 +427,6 @@ static int get_unit_files(char* unit_files[]) {
     int num_unit_files = 0;
     num_multi_inst = 0;
 
-    multi_instance_services = malloc(MAX_NUM_UNITS * sizeof(char *));
-
     while ((read = getline(&line, &len, fp)) != -1) {
         if (num_unit_files >= MAX_NUM_UNITS) {
             fprintf(stderr, "Maximum number of units exceeded, ignoring extras\n");
@@ -312,8 +437,7 @@ static int get_unit_files(char* unit_files[]) {
         /* Get the multi-instance services */
         pos = strchr(line, '@');
         if (pos != NULL) {
-            multi_instance_services[num_multi_inst] = malloc(strlen(line)*sizeof(char));
-            strncpy(multi_instance_services[num_multi_inst], line, pos-line);
+            multi_instance_services[num_multi_inst] = arena_strndup(line, pos - line);
             num_multi_inst++;
         }
 
@@ -322,7 +446,17 @@ static int get_unit_files(char* unit_files[]) {
                         (num_asics == 1)) {
             continue;
         }
-        unit_files[num_unit_files] = strdup(line);
+
+        /* Single ASIC platforms install templates as plain units, example@.service -> example.service */
+        if ((num_asics == 1) && pos != NULL) {
+            units[num_unit_files].name = arena_alloc(strlen(line));
+            snprintf(units[num_unit_files].name, strlen(line), "%.*s%s", (int) (pos - line), line, pos + 1);
+        }
+        else {
+            units[num_unit_files].name = arena_strdup(line);
+        }
+        units[num_unit_files].num_targets = 0;
+        units[num_unit_files].generated = false;
         num_unit_files++;
     }
 
@@ -334,108 +468,115 @@ static int get_unit_files(char* unit_files[]) {
 }
 
 
-static char* insert_instance_number(char* unit_file, int instance) {
+static int insert_instance_number(const char* unit_file, int instance, char* instance_name, size_t size) {
     /***
     Adds an instance number to a systemd template name
 
     E.g. given unit_file='example@.service', instance=3,
-    returns a pointer to 'example@1.service'
+    writes 'example@3.service' to instance_name
     ***/
-    char* prefix;
-    char* suffix;
-    char* instance_string;
-    char* instance_name;
-    char* temp_unit_file;
-
-    instance_string = malloc(2 * sizeof(char));
-    snprintf(instance_string, 2, "%d", instance);
+    const char* pos = strchr(unit_file, '@');
+    int r;
 
-    instance_name = malloc(strlen(unit_file) + 2);
+    if (pos == NULL) {
+        r = snprintf(instance_name, size, "%s", unit_file);
+    }
+    else {
+        r = snprintf(instance_name, size, "%.*s@%d%s", (int) (pos - unit_file), unit_file, instance, pos + 1);
+    }
 
-    if (instance_name == NULL) {
+    if (r < 0 || (size_t) r >= size) {
         fprintf(stderr, "Error creating instance %d of %s\n", instance, unit_file);
-        return NULL;
+        return -1;
     }
 
-    temp_unit_file = strdup(unit_file);
-    prefix = strtok(temp_unit_file, "@");
-    suffix = strtok(NULL, "@");
-
-    strcpy(instance_name, prefix);
-    strcat(instance_name, "@");
-    strcat(instance_name, instance_string);
-    strcat(instance_name, suffix);
-
-    free(instance_string);
-    free(temp_unit_file);
-
-    return instance_name;
+    return 0;
 }
 
 
-static int create_symlink(char* unit, char* target, char* install_dir, int instance) {
+static int prepare_target_dir(const char* target) {
+    /***
+    Makes sure that a target directory of the output directory exists
+    with the right permissions, once per directory
+    ***/
     struct stat st;
-    char src_path[PATH_MAX];
-    char dest_path[PATH_MAX];
-    char final_install_dir[PATH_MAX];
-    char* unit_instance;
     int r;
 
-    strcpy(src_path, UNIT_FILE_PREFIX);
-    strcat(src_path, unit);
-
-    if (instance < 0) {
-        unit_instance = strdup(unit);
-    }
-    else {
-        unit_instance = insert_instance_number(unit, instance);
+    for (int i = 0; i < num_target_dirs; i++) {
+        if (strcmp(target_dirs[i], target) == 0) {
+            return 0;
+        }
     }
 
-    strcpy(final_install_dir, install_dir);
-    strcat(final_install_dir, target);
-    strcpy(dest_path, final_install_dir);
-    strcat(dest_path, "/");
-    strcat(dest_path, unit_instance);
-
-    free(unit_instance);
-
-    if (stat(final_install_dir, &st) == -1) {
+    if (fstatat(install_dir_fd, target, &st, AT_SYMLINK_NOFOLLOW) == -1) {
         // If doesn't exist, create
-        r = mkdir(final_install_dir, 0755);
+        r = mkdirat(install_dir_fd, target, 0755);
         if (r == -1) {
-            fprintf(stderr, "Unable to create target directory %s\n", final_install_dir);
+            fprintf(stderr, "Unable to create target directory %s\n", target);
             return -1;
         }
     }
     else if (S_ISREG(st.st_mode)) {
         // If is regular file, remove and create
-        r = remove(final_install_dir);
+        r = unlinkat(install_dir_fd, target, 0);
         if (r == -1) {
-            fprintf(stderr, "Unable to remove file with same name as target directory %s\n", final_install_dir);
+            fprintf(stderr, "Unable to remove file with same name as target directory %s\n", target);
             return -1;
         }
 
-        r = mkdir(final_install_dir, 0755);
+        r = mkdirat(install_dir_fd, target, 0755);
         if (r == -1) {
-            fprintf(stderr, "Unable to create target directory %s\n", final_install_dir);
+            fprintf(stderr, "Unable to create target directory %s\n", target);
             return -1;
         }
     }
-    else if (S_ISDIR(st.st_mode)) {
+    else if (S_ISDIR(st.st_mode) && (st.st_mode & 07777) != 0755) {
         // If directory, verify correct permissions
-        r = chmod(final_install_dir, 0755);
+        r = fchmodat(install_dir_fd, target, 0755, 0);
         if (r == -1) {
-            fprintf(stderr, "Unable to change permissions of existing target directory %s\n", final_install_dir);
+            fprintf(stderr, "Unable to change permissions of existing target directory %s\n", target);
             return -1;
         }
     }
 
-    r = symlink(src_path, dest_path);
+    if (num_target_dirs < (int) (sizeof(target_dirs) / sizeof(*target_dirs))) {
+        target_dirs[num_target_dirs++] = arena_strdup(target);
+    }
+
+    return 0;
+}
+
+
+static int create_symlink(const struct unit* unit, const char* target, const char* install_dir, int instance) {
+    /***
+    Links a unit in a target directory of the output directory
+    ***/
+    char src_path[PATH_MAX];
+    char dest_path[PATH_MAX];
+    char unit_instance[NAME_MAX + 1];
+    int r;
+
+    snprintf(src_path, PATH_MAX, "%s%s", unit->generated ? install_dir : UNIT_FILE_PREFIX, unit->name);
+
+    if (instance < 0) {
+        snprintf(unit_instance, sizeof(unit_instance), "%s", unit->name);
+    }
+    else if (insert_instance_number(unit->name, instance, unit_instance, sizeof(unit_instance)) < 0) {
+        return -1;
+    }
+
+    snprintf(dest_path, PATH_MAX, "%s/%s", target, unit_instance);
+
+    if (prepare_target_dir(target) < 0) {
+        return -1;
+    }
+
+    r = symlinkat(src_path, install_dir_fd, dest_path);
 
     if (r < 0) {
         if (errno == EEXIST)
             return 0;
-        fprintf(stderr, "Error creating symlink %s from source %s\n", dest_path, src_path);
+        fprintf(stderr, "Error creating symlink %s%s from source %s\n", install_dir, dest_path, src_path);
         return -1;
     }
 
@@ -444,7 +585,7 @@ static int create_symlink(char* unit, char* target, char* install_dir, int insta
 }
 
 
-static int install_unit_file(char* unit_file, char* target, char* install_dir) {
+static int install_unit_file(const struct unit* unit, const char* target, const char* install_dir) {
     /***
     Creates a symlink for a unit file installation
 
@@ -455,38 +596,31 @@ static int install_unit_file(char* unit_file, char* target, char* install_dir) {
     If a multi ASIC platform is detected, enables multi-instance
     services as well
     ***/
-    char* target_instance;
-    char* prefix;
-    char* suffix;
+    char target_instance[NAME_MAX + 1];
     int r;
 
-    assert(unit_file);
+    assert(unit);
     assert(target);
-            
 
-    if ((num_asics > 1) && strstr(unit_file, "@") != NULL) {
+
+    if ((num_asics > 1) && strstr(unit->name, "@") != NULL) {
 
         for (int i = 0; i < num_asics; i++) {
 
-            if (strstr(target, "@") != NULL) {
-                target_instance = insert_instance_number(target, i);
-            }
-            else {
-                target_instance = strdup(target);
+            if (insert_instance_number(target, i, target_instance, sizeof(target_instance)) < 0) {
+                continue;
             }
 
-            r = create_symlink(unit_file, target_instance, install_dir, i);
-            if (r < 0) 
-                fprintf(stderr, "Error installing %s for target %s\n", unit_file, target_instance);
-            
-            free(target_instance);
+            r = create_symlink(unit, target_instance, install_dir, i);
+            if (r < 0)
+                fprintf(stderr, "Error installing %s for target %s\n", unit->name, target_instance);
 
-        } 
+        }
     }
     else {
-        r = create_symlink(unit_file, target, install_dir, -1);
-        if (r < 0) 
-            fprintf(stderr, "Error installing %s for target %s\n", unit_file, target);
+        r = create_symlink(unit, target, install_dir, -1);
+        if (r < 0)
+            fprintf(stderr, "Error installing %s for target %s\n", unit->name, target);
     }
 
     return 0;
@@ -500,10 +634,9 @@ static int get_num_of_asic() {
     FILE *fp;
     char *line = NULL;
     char* token;
-    char* platform;
+    char* platform = NULL;
     size_t len = 0;
     ssize_t nread;
-    bool ans;
     char asic_file[512];
     char* str_num_asic;
     int num_asic = 1;
@@ -542,24 +675,20 @@ static int get_num_of_asic() {
                 }
             }
             fclose(fp);
-            free(line);
         }
     }
+    free(line);
     return num_asic;
 
 }
 
 
 int main(int argc, char **argv) {
-    char* unit_files[MAX_NUM_UNITS];
+    static struct unit units[MAX_NUM_UNITS];
+    struct buffer content = {0};
+    struct buffer expanded = {0};
     char install_dir[PATH_MAX];
-    char* targets[MAX_NUM_TARGETS];
-    char* unit_instance;
-    char* prefix;
-    char* suffix;
     int num_unit_files;
-    int num_targets;
-    int r;
 
     if (argc <= 1) {
         fputs("Installation directory required as argument\n", stderr);
@@ -568,45 +697,33 @@ int main(int argc, char **argv) {
 
     num_asics = get_num_of_asic();
 
-    strcpy(install_dir, argv[1]);
-    strcat(install_dir, "/");
+    snprintf(install_dir, PATH_MAX, "%s/", argv[1]);
+
+    install_dir_fd = open(install_dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (install_dir_fd < 0) {
+        fprintf(stderr, "Failed to open installation directory %s\n", install_dir);
+        return 1;
+    }
 
-    num_unit_files = get_unit_files(unit_files);
+    num_unit_files = get_unit_files(units);
 
     // For each unit file, get the installation targets and install the unit
     for (int i = 0; i < num_unit_files; i++) {
-        unit_instance = strdup(unit_files[i]);
-        if ((num_asics == 1) && strstr(unit_instance, "@") != NULL) {
-            prefix = strtok(unit_instance, "@");
-            suffix = strtok(NULL, "@");
-
-            strcpy(unit_instance, prefix);
-            strcat(unit_instance, suffix);
-        }
-
-        num_targets = get_install_targets(unit_instance, targets);
-        if (num_targets < 0) {
-            fprintf(stderr, "Error parsing %s\n", unit_instance);
-            free(unit_instance);
-            free(unit_files[i]);
+        if (parse_unit_file(&units[i], &content, &expanded) < 0) {
+            fprintf(stderr, "Error parsing %s\n", units[i].name);
             continue;
         }
 
-        for (int j = 0; j < num_targets; j++) {
-            if (install_unit_file(unit_instance, targets[j], install_dir) != 0)
-                fprintf(stderr, "Error installing %s to target directory %s\n", unit_instance, targets[j]);
-
-            free(targets[j]);
+        for (int j = 0; j < units[i].num_targets; j++) {
+            if (install_unit_file(&units[i], units[i].targets[j], install_dir) != 0)
+                fprintf(stderr, "Error installing %s to target directory %s\n", units[i].name, units[i].targets[j]);
         }
-
-        free(unit_instance);
-        free(unit_files[i]);
     }
 
-    for (int i = 0; i < num_multi_inst; i++) {
-        free(multi_instance_services[i]);
-    }
-    free(multi_instance_services);
+    free(content.data);
+    free(expanded.data);
+    arena_free();
+    close(install_dir_fd);
 
     return 0;
 }